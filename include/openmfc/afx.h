@@ -169,6 +169,8 @@ class CFile;
 class CException;
 class CFileException;
 
+namespace openmfc_archmap { struct ObjectMap; }   // phase4/src/archive_object_map.h
+
 // CFileStatus - file status structure
 struct CFileStatus {
     ULONGLONG m_ctime;      // Creation time (simplified)
@@ -180,6 +182,12 @@ struct CFileStatus {
     wchar_t m_szFullName[_MAX_PATH];  // Absolute path name
 };
 
+#if defined(OPENMFC_EXPORTS)
+struct CRuntimeClass;
+// Inside the DLL, IsDerivedFrom is answered from cached ancestry (cobject_impl.cpp).
+bool OpenMFCIsDerivedFrom(const CRuntimeClass* pClass, const CRuntimeClass* pBaseClass);
+#endif
+
 // CRuntimeClass - runtime type information structure
 // This structure is used for MFC's own RTTI system (separate from C++ RTTI)
 // IMPORTANT: Layout must match real MFC exactly for ABI compatibility!
@@ -202,6 +210,9 @@ struct CRuntimeClass {
     }
 
     bool IsDerivedFrom(const CRuntimeClass* pBaseClass) const {
+#if defined(OPENMFC_EXPORTS)
+        return OpenMFCIsDerivedFrom(this, pBaseClass);
+#else
         const CRuntimeClass* pClassThis = this;
         while (pClassThis != nullptr) {
             if (pClassThis == pBaseClass) {
@@ -215,6 +226,7 @@ struct CRuntimeClass {
             }
         }
         return false;
+#endif
     }
 };
 
@@ -386,6 +398,20 @@ public:
     // Raw read/write
     UINT Read(void* lpBuf, UINT nMax);
     void Write(const void* lpBuf, UINT nMax);
+
+    // Element counts in MFC's escalating WORD / DWORD / QWORD format
+    void WriteCount(DWORD_PTR dwCount);
+    DWORD_PTR ReadCount();
+    
+    // Object graph: shared objects and classes are written once, later
+    // references as an index (MFC tag format)
+    void WriteObject(const CObject* pOb);
+    CObject* ReadObject(const CRuntimeClass* pClassRefRequested);
+    void WriteClass(const CRuntimeClass* pClassRef);
+    CRuntimeClass* ReadClass(const CRuntimeClass* pClassRefRequested = nullptr,
+                             UINT* pSchema = nullptr, DWORD* pObTag = nullptr);
+    void SerializeClass(const CRuntimeClass* pClassRef);
+    void MapObject(const CObject* pOb);
     
     // Flush buffer
     void Flush();
@@ -406,6 +432,8 @@ protected:
     UINT m_nObjectSchema;
     bool m_bForceFlat;
     bool m_bUserBuf;
+    bool m_bDirectBuffer;       // m_lpBuf* point into the file's own buffer
+    openmfc_archmap::ObjectMap* m_pObjectMap;   // created on first object/class
     
     friend class CArchiveAccess;
     void FillBuffer(UINT nBytesNeeded);
@@ -435,6 +463,10 @@ public:
     
     enum { hFileNull = -1 };
     
+    // GetBufferPtr commands and bufferCheck result bits
+    enum BufferCommand { bufferRead, bufferWrite, bufferCommit, bufferCheck };
+    enum BufferFlags { bufferDirect = 0x01, bufferBlocking = 0x02 };
+    
     CFile();
     CFile(HANDLE hFile);
     CFile(const wchar_t* lpszFileName, UINT nOpenFlags);
@@ -500,13 +532,35 @@ public:
     BYTE* Detach();
     void Attach(BYTE* lpBuffer, UINT nBufferSize, UINT nGrowBytes = 0);
     
+    // Direct buffer access (bufferDirect): bufferRead/bufferWrite return a
+    // window into the file buffer at the current position, bufferCommit
+    // advances past bytes written into it. CArchive uses this instead of
+    // copying through its own buffer.
+    UINT GetBufferPtr(UINT nCommand, UINT nCount = (UINT)-1,
+                      void** ppBufStart = nullptr, void** ppBufMax = nullptr);
+    
+    // OpenMFC extensions.
+    // Grow by doubling the buffer, adding at most nMaxGrowBytes per step,
+    // instead of the MFC default of m_nGrowBytes at a time. Attached buffers
+    // keep growing by m_nGrowBytes.
+    void SetGeometricGrowth(SIZE_T nMaxGrowBytes = 64 * 1024 * 1024);
+    // Back the file with nMaxSize bytes of reserved address space, committed
+    // as the file grows, so the buffer never moves. Not for attached buffers.
+    BOOL ReserveAddressSpace(ULONGLONG nMaxSize);
+    
 protected:
     BYTE* m_lpBuffer;
-    UINT m_nBufferSize;
-    UINT m_nFileSize;
-    UINT m_nGrowBytes;
-    UINT m_nPosition;
+    SIZE_T m_nBufferSize;
+    SIZE_T m_nFileSize;
+    SIZE_T m_nGrowBytes;
+    SIZE_T m_nPosition;
     bool m_bAutoDelete;
+    bool m_bReserved;           // m_lpBuffer is a VirtualAlloc reservation
+    SIZE_T m_nMaxGrowBytes;     // 0: linear growth
+    SIZE_T m_nReservedSize;
+    
+    bool GrowBuffer(SIZE_T nNewLen);
+    void FreeBuffer();
 };
 
 // CStdioFile - stdio file
@@ -729,6 +783,9 @@ public:
     // Hash table operations
     UINT GetHashTableSize() const { return m_nHashTableSize; }
     void InitHashTable(UINT hashSize, bool bAllocNow = true);
+    // OpenMFC extension: grow the bucket array as the map fills. Off by
+    // default, so the table keeps its InitHashTable size as in MFC.
+    void EnableAutoRehash(bool bEnable = true);
     
 protected:
     CAssoc* NewAssoc();
@@ -1137,6 +1194,212 @@ void CList<TYPE, ARG_TYPE>::RemoveAll() {
     m_nCount = 0;
 }
 
+// ============================================================================
+// Map bucket arrays (shared by CMap<> and the CMap* wrappers in filecore.cpp)
+// ============================================================================
+
+// Bucket arrays keep the size they were given, as in MFC. A map can opt in
+// to growth with EnableAutoRehash: its array then grows once it holds more
+// assocs than buckets, to the next prime in kGrowthSizes (roughly
+// doubling). The old array stays attached to the new one and is drained a
+// few buckets per insert, so no insert pays for moving the whole map. Until
+// a key's old bucket has been drained, the key still lives in the old array.
+//
+// Every array carries a TableHeader just ahead of bucket 0, so the wrappers'
+// fixed 56-byte layouts need no extra fields; m_pHashTable still points at
+// bucket 0. The opt-in lives there too, which is why enabling it allocates
+// the array, and why RemoveAll and InitHashTable carry it over.
+namespace openmfc_maphash {
+
+const UINT kGrowthSizes[] = {
+    17, 37, 79, 163, 331, 673, 1361, 2729, 5471, 10949, 21911, 43853, 87719,
+    175447, 350899, 701819, 1403641, 2807303, 5614657, 11229331, 22458671,
+    44917381, 89834777, 179669557, 359339171, 718678369, 1437356741
+};
+const UINT kDrainPerInsert = 4;
+
+struct TableHeader {
+    void* pOldTable;        // array being drained, or null
+    UINT nOldSize;
+    UINT nDrained;          // old buckets [0, nDrained) are empty
+    bool bAutoGrow;         // EnableAutoRehash
+};
+
+inline TableHeader* HeaderOf(const void* pTable) {
+    return reinterpret_cast<TableHeader*>(const_cast<void*>(pTable)) - 1;
+}
+
+inline bool AutoGrows(const void* pTable) {
+    return pTable != nullptr && HeaderOf(pTable)->bAutoGrow;
+}
+
+// The first size in kGrowthSizes above nSize; 0 past the last one.
+inline UINT NextGrowthSize(UINT nSize) {
+    for (UINT nNext : kGrowthSizes) {
+        if (nNext > nSize)
+            return nNext;
+    }
+    return 0;
+}
+
+template<class ASSOC>
+ASSOC** AllocTable(UINT nSize, bool bAutoGrow = false) {
+    void* pBlock = calloc(1, sizeof(TableHeader) + static_cast<size_t>(nSize) * sizeof(ASSOC*));
+    if (pBlock == nullptr)
+        return nullptr;
+    static_cast<TableHeader*>(pBlock)->bAutoGrow = bAutoGrow;
+    return reinterpret_cast<ASSOC**>(static_cast<TableHeader*>(pBlock) + 1);
+}
+
+// Frees the array and any array still being drained into it; the assocs
+// themselves belong to the map's blocks.
+template<class ASSOC>
+void FreeTable(ASSOC** pTable) {
+    if (pTable == nullptr)
+        return;
+    TableHeader* pHeader = HeaderOf(pTable);
+    if (pHeader->pOldTable != nullptr)
+        free(HeaderOf(pHeader->pOldTable));
+    free(pHeader);
+}
+
+// The chain head that owns nHash.
+template<class ASSOC>
+ASSOC** HomeChain(ASSOC* const* pTable, UINT nSize, UINT nHash) {
+    const TableHeader* pHeader = HeaderOf(pTable);
+    if (pHeader->pOldTable != nullptr) {
+        UINT nOldBucket = nHash % pHeader->nOldSize;
+        if (nOldBucket >= pHeader->nDrained)
+            return static_cast<ASSOC**>(pHeader->pOldTable) + nOldBucket;
+    }
+    return const_cast<ASSOC**>(pTable) + nHash % nSize;
+}
+
+// Moves up to nBuckets old buckets into pTable, releasing the old array
+// once it is empty. The old array is always smaller, so nBuckets == nSize
+// finishes the drain.
+template<class ASSOC>
+void DrainOld(ASSOC** pTable, UINT nSize, UINT nBuckets) {
+    TableHeader* pHeader = HeaderOf(pTable);
+    if (pHeader->pOldTable == nullptr)
+        return;
+    ASSOC** pOld = static_cast<ASSOC**>(pHeader->pOldTable);
+    for (; nBuckets != 0 && pHeader->nDrained < pHeader->nOldSize; --nBuckets, ++pHeader->nDrained) {
+        for (ASSOC* pAssoc = pOld[pHeader->nDrained]; pAssoc != nullptr;) {
+            ASSOC* pNext = pAssoc->pNext;
+            ASSOC** ppChain = pTable + pAssoc->nHashValue % nSize;
+            pAssoc->pNext = *ppChain;
+            *ppChain = pAssoc;
+            pAssoc = pNext;
+        }
+        pOld[pHeader->nDrained] = nullptr;
+    }
+    if (pHeader->nDrained == pHeader->nOldSize) {
+        FreeTable(pOld);
+        pHeader->pOldTable = nullptr;
+        pHeader->nOldSize = 0;
+        pHeader->nDrained = 0;
+    }
+}
+
+// Call after linking a new assoc: advances any drain in progress and, for
+// an auto-rehashing map, starts a new one when nCount passes the bucket
+// count. An allocation failure just leaves the map at its current size.
+template<class ASSOC>
+void AfterInsert(ASSOC**& pTable, UINT& nSize, INT_PTR nCount) {
+    DrainOld(pTable, nSize, kDrainPerInsert);
+    if (!HeaderOf(pTable)->bAutoGrow || static_cast<UINT_PTR>(nCount) <= nSize)
+        return;
+    UINT nNewSize = NextGrowthSize(nSize);
+    if (nNewSize == 0)
+        return;
+    ASSOC** pNew = AllocTable<ASSOC>(nNewSize, true);
+    if (pNew == nullptr)
+        return;
+    DrainOld(pTable, nSize, nSize);     // finish the previous drain: one old array at a time
+    TableHeader* pHeader = HeaderOf(pNew);
+    pHeader->pOldTable = pTable;
+    pHeader->nOldSize = nSize;
+    pTable = pNew;
+    nSize = nNewSize;
+}
+
+// Empties the array in place, dropping any array still being drained, and
+// keeps its settings. The assocs themselves belong to the map's blocks.
+template<class ASSOC>
+void ClearTable(ASSOC** pTable, UINT nSize) {
+    TableHeader* pHeader = HeaderOf(pTable);
+    if (pHeader->pOldTable != nullptr)
+        free(HeaderOf(pHeader->pOldTable));
+    pHeader->pOldTable = nullptr;
+    pHeader->nOldSize = 0;
+    pHeader->nDrained = 0;
+    for (UINT i = 0; i < nSize; ++i)
+        pTable[i] = nullptr;
+}
+
+// EnableAutoRehash. Allocates the array so the setting has a home; turning
+// growth off finishes any drain in progress. False when allocation fails.
+template<class ASSOC>
+bool SetAutoGrow(ASSOC**& pTable, UINT nSize, bool bEnable) {
+    if (pTable == nullptr) {
+        if (!bEnable)
+            return true;
+        pTable = AllocTable<ASSOC>(nSize, true);
+        return pTable != nullptr;
+    }
+    if (!bEnable)
+        DrainOld(pTable, nSize, nSize);
+    HeaderOf(pTable)->bAutoGrow = bEnable;
+    return true;
+}
+
+// Iteration walks the current array's buckets and then the old array's
+// undrained ones; a cursor >= nSize indexes the old array. As with MFC's
+// GetNextAssoc the cursor is recomputed from the assoc's hash rather than
+// trusted from the POSITION.
+template<class ASSOC>
+ASSOC* ScanFrom(ASSOC* const* pTable, UINT nSize, UINT& nCursor) {
+    const TableHeader* pHeader = HeaderOf(pTable);
+    for (; nCursor < nSize; ++nCursor) {
+        if (pTable[nCursor] != nullptr)
+            return pTable[nCursor];
+    }
+    if (pHeader->pOldTable != nullptr) {
+        ASSOC* const* pOld = static_cast<ASSOC* const*>(pHeader->pOldTable);
+        if (nCursor < nSize + pHeader->nDrained)
+            nCursor = nSize + pHeader->nDrained;
+        for (; nCursor - nSize < pHeader->nOldSize; ++nCursor) {
+            if (pOld[nCursor - nSize] != nullptr)
+                return pOld[nCursor - nSize];
+        }
+    }
+    return nullptr;
+}
+
+template<class ASSOC>
+ASSOC* FirstAssoc(ASSOC* const* pTable, UINT nSize, UINT& nCursor) {
+    nCursor = 0;
+    return pTable != nullptr ? ScanFrom(pTable, nSize, nCursor) : nullptr;
+}
+
+template<class ASSOC>
+ASSOC* NextAssoc(ASSOC* const* pTable, UINT nSize, const ASSOC* pAssoc, UINT& nCursor) {
+    const TableHeader* pHeader = HeaderOf(pTable);
+    nCursor = pAssoc->nHashValue % nSize;
+    if (pHeader->pOldTable != nullptr) {
+        UINT nOldBucket = pAssoc->nHashValue % pHeader->nOldSize;
+        if (nOldBucket >= pHeader->nDrained)
+            nCursor = nSize + nOldBucket;
+    }
+    if (pAssoc->pNext != nullptr)
+        return pAssoc->pNext;
+    ++nCursor;
+    return ScanFrom(pTable, nSize, nCursor);
+}
+
+} // namespace openmfc_maphash
+
 // ============================================================================
 // CMap template implementation
 // ============================================================================
@@ -1149,8 +1412,7 @@ CMap<KEY, ARG_KEY, VALUE, ARG_VALUE>::CMap(int nBlockSize)
 template<class KEY, class ARG_KEY, class VALUE, class ARG_VALUE>
 CMap<KEY, ARG_KEY, VALUE, ARG_VALUE>::~CMap() {
     RemoveAll();
-    if (m_pHashTable != nullptr)
-        free(m_pHashTable);
+    openmfc_maphash::FreeTable(m_pHashTable);
     while (m_pBlocks != nullptr) {
         CBlock* pNext = m_pBlocks->pNext;
         free(m_pBlocks);
@@ -1160,17 +1422,21 @@ CMap<KEY, ARG_KEY, VALUE, ARG_VALUE>::~CMap() {
 
 template<class KEY, class ARG_KEY, class VALUE, class ARG_VALUE>
 void CMap<KEY, ARG_KEY, VALUE, ARG_VALUE>::InitHashTable(UINT hashSize, bool bAllocNow) {
+    const bool bAutoGrow = openmfc_maphash::AutoGrows(m_pHashTable);
     RemoveAll();
-    if (m_pHashTable != nullptr) {
-        free(m_pHashTable);
-        m_pHashTable = nullptr;
-    }
+    openmfc_maphash::FreeTable(m_pHashTable);
+    m_pHashTable = nullptr;
     m_nHashTableSize = hashSize;
-    if (bAllocNow) {
-        m_pHashTable = (CAssoc**)calloc(hashSize, sizeof(CAssoc*));
+    if (bAllocNow || bAutoGrow) {
+        m_pHashTable = openmfc_maphash::AllocTable<CAssoc>(hashSize, bAutoGrow);
     }
 }
 
+template<class KEY, class ARG_KEY, class VALUE, class ARG_VALUE>
+void CMap<KEY, ARG_KEY, VALUE, ARG_VALUE>::EnableAutoRehash(bool bEnable) {
+    openmfc_maphash::SetAutoGrow(m_pHashTable, m_nHashTableSize, bEnable);
+}
+
 template<class KEY, class ARG_KEY, class VALUE, class ARG_VALUE>
 UINT CMap<KEY, ARG_KEY, VALUE, ARG_VALUE>::HashKey(ARG_KEY key) const {
     // Default hash for integral types
@@ -1254,7 +1520,8 @@ CMap<KEY, ARG_KEY, VALUE, ARG_VALUE>::GetAssocAt(ARG_KEY key, UINT& nHash, UINT&
     if (m_pHashTable == nullptr)
         return nullptr;
 
-    for (CAssoc* pAssoc = m_pHashTable[nHashBucket]; pAssoc != nullptr; pAssoc = pAssoc->pNext) {
+    CAssoc* pAssoc = *openmfc_maphash::HomeChain(m_pHashTable, m_nHashTableSize, nHash);
+    for (; pAssoc != nullptr; pAssoc = pAssoc->pNext) {
         if (pAssoc->key == key)
             return pAssoc;
     }
@@ -1293,8 +1560,10 @@ VALUE& CMap<KEY, ARG_KEY, VALUE, ARG_VALUE>::operator[](ARG_KEY key) {
         pAssoc = NewAssoc();
         pAssoc->nHashValue = nHash;
         pAssoc->key = key;
-        pAssoc->pNext = m_pHashTable[nHashBucket];
-        m_pHashTable[nHashBucket] = pAssoc;
+        CAssoc** ppChain = openmfc_maphash::HomeChain(m_pHashTable, m_nHashTableSize, nHash);
+        pAssoc->pNext = *ppChain;
+        *ppChain = pAssoc;
+        openmfc_maphash::AfterInsert(m_pHashTable, m_nHashTableSize, m_nCount);
     }
     return pAssoc->value;
 }
@@ -1317,8 +1586,7 @@ bool CMap<KEY, ARG_KEY, VALUE, ARG_VALUE>::RemoveKey(ARG_KEY key) {
     if (m_pHashTable == nullptr)
         return false;
 
-    UINT nHashBucket = HashKey(key) % m_nHashTableSize;
-    CAssoc** ppAssocPrev = &m_pHashTable[nHashBucket];
+    CAssoc** ppAssocPrev = openmfc_maphash::HomeChain(m_pHashTable, m_nHashTableSize, HashKey(key));
 
     for (CAssoc* pAssoc = *ppAssocPrev; pAssoc != nullptr; pAssoc = pAssoc->pNext) {
         if (pAssoc->key == key) {
@@ -1334,6 +1602,7 @@ bool CMap<KEY, ARG_KEY, VALUE, ARG_VALUE>::RemoveKey(ARG_KEY key) {
 template<class KEY, class ARG_KEY, class VALUE, class ARG_VALUE>
 void CMap<KEY, ARG_KEY, VALUE, ARG_VALUE>::RemoveAll() {
     if (m_pHashTable != nullptr) {
+        openmfc_maphash::DrainOld(m_pHashTable, m_nHashTableSize, m_nHashTableSize);
         for (UINT i = 0; i < m_nHashTableSize; i++) {
             for (CAssoc* pAssoc = m_pHashTable[i]; pAssoc != nullptr;) {
                 CAssoc* pNext = pAssoc->pNext;
@@ -1349,14 +1618,12 @@ void CMap<KEY, ARG_KEY, VALUE, ARG_VALUE>::RemoveAll() {
 template<class KEY, class ARG_KEY, class VALUE, class ARG_VALUE>
 typename CMap<KEY, ARG_KEY, VALUE, ARG_VALUE>::POSITION
 CMap<KEY, ARG_KEY, VALUE, ARG_VALUE>::GetStartPosition() const {
-    if (m_nCount == 0 || m_pHashTable == nullptr)
+    if (m_nCount == 0)
         return POSITION(nullptr, 0);
 
-    for (UINT i = 0; i < m_nHashTableSize; i++) {
-        if (m_pHashTable[i] != nullptr)
-            return POSITION(m_pHashTable[i], i);
-    }
-    return POSITION(nullptr, 0);
+    UINT nCursor = 0;
+    CAssoc* pAssoc = openmfc_maphash::FirstAssoc(m_pHashTable, m_nHashTableSize, nCursor);
+    return POSITION(pAssoc, nCursor);
 }
 
 template<class KEY, class ARG_KEY, class VALUE, class ARG_VALUE>
@@ -1366,19 +1633,8 @@ void CMap<KEY, ARG_KEY, VALUE, ARG_VALUE>::GetNextAssoc(POSITION& rNextPosition,
     rValue = pAssoc->value;
 
     // Advance position
-    if (pAssoc->pNext != nullptr) {
-        rNextPosition.pAssoc = pAssoc->pNext;
-    } else {
-        // Find next bucket
-        for (UINT i = rNextPosition.nHashBucket + 1; i < m_nHashTableSize; i++) {
-            if (m_pHashTable[i] != nullptr) {
-                rNextPosition.pAssoc = m_pHashTable[i];
-                rNextPosition.nHashBucket = i;
-                return;
-            }
-        }
-        rNextPosition.pAssoc = nullptr;
-    }
+    rNextPosition.pAssoc = openmfc_maphash::NextAssoc(m_pHashTable, m_nHashTableSize, pAssoc,
+                                                      rNextPosition.nHashBucket);
 }
 
 // Type definitions for common collections
@@ -1397,6 +1653,8 @@ class class_name : public CObject { \
 public: \
     class_name(); \
     virtual ~class_name(); \
+    class_name(const class_name&) = delete;            /* owns m_pData */ \
+    class_name& operator=(const class_name&) = delete; \
     INT_PTR GetSize() const; \
     INT_PTR GetCount() const; \
     BOOL IsEmpty() const; \
@@ -1420,6 +1678,14 @@ public: \
     void RemoveAt(INT_PTR nIndex, INT_PTR nCount = 1); \
     void InsertAt(INT_PTR nStartIndex, class_name* pNewArray); \
     virtual void Serialize(CArchive& ar) override; \
+protected: \
+    /* Retail member block: sizeof 40, CObject at 0..7. These fields are the   */ \
+    /* live storage -- the inline accessors real MFC clients compile against  */ \
+    /* read m_pData/m_nSize directly, so there is no side table.              */ \
+    element_type* m_pData;  /* 0x08 */ \
+    INT_PTR  m_nSize;       /* 0x10 */ \
+    INT_PTR  m_nMaxSize;    /* 0x18 */ \
+    INT_PTR  m_nGrowBy;     /* 0x20 */ \
 };
 
 #define OPENMFC_DECLARE_LIST_WRAPPER(class_name, element_type, arg_type, class_decl) \
@@ -1429,6 +1695,8 @@ public: \
     typedef CList<element_type, arg_type>::POSITION POSITION; \
     explicit class_name(INT_PTR nBlockSize = 10); \
     virtual ~class_name(); \
+    class_name(const class_name&) = delete;            /* owns the nodes */ \
+    class_name& operator=(const class_name&) = delete; \
     INT_PTR GetCount() const; \
     BOOL IsEmpty() const; \
     element_type& GetHead(); \
@@ -1456,17 +1724,21 @@ public: \
     POSITION InsertAfter(POSITION position, arg_type newElement); \
     void RemoveAll(); \
     virtual void Serialize(CArchive& ar) override; \
+    /* Implementation. Protected in MFC; public here so the exported          */ \
+    /* NewNode/FreeNode thunks can forward to them.                           */ \
+    struct CNode { CNode* pNext; CNode* pPrev; element_type data; }; \
+    CNode* NewNode(CNode* pPrev, CNode* pNext); \
+    void FreeNode(CNode* pNode); \
 protected: \
     /* Retail member block, harvested with /d1reportSingleClassLayoutCObList.  */ \
     /* MFC's list classes all share this shape: sizeof 56, CObject at 0..7.    */ \
-    /* OpenMFC keeps the live list contents in a side table keyed by `this`,   */ \
-    /* so these are storage for binary compatibility rather than the working   */ \
-    /* representation -- but they must exist, or anything embedding a list by  */ \
-    /* value (CMFCToolBar has three) lays out 48 bytes short per list.         */ \
-    void*    m_pNodeHead;   /* 0x08 */ \
-    void*    m_pNodeTail;   /* 0x10 */ \
+    /* The nodes hang directly off these fields (CPlex blocks + free list, as  */ \
+    /* in MFC), and anything embedding a list by value (CMFCToolBar has three) */ \
+    /* relies on the 48-byte block being here.                                */ \
+    CNode*   m_pNodeHead;   /* 0x08 */ \
+    CNode*   m_pNodeTail;   /* 0x10 */ \
     INT_PTR  m_nCount;      /* 0x18 */ \
-    void*    m_pNodeFree;   /* 0x20 */ \
+    CNode*   m_pNodeFree;   /* 0x20 */ \
     struct CPlex* m_pBlocks;/* 0x28 */ \
     INT_PTR  m_nBlockSize;  /* 0x30 */ \
 };
@@ -1479,6 +1751,8 @@ public: \
     typedef CMap<key_type, arg_key_type, value_type, arg_value_type>::POSITION POSITION; \
     explicit class_name(INT_PTR nBlockSize = 10); \
     virtual ~class_name(); \
+    class_name(const class_name&) = delete;            /* owns the assocs */ \
+    class_name& operator=(const class_name&) = delete; \
     INT_PTR GetCount() const; \
     BOOL IsEmpty() const; \
     BOOL Lookup(arg_key_type key, value_type& rValue) const; \
@@ -1491,7 +1765,26 @@ public: \
     void GetNextAssoc(POSITION& rNextPosition, key_type& rKey, value_type& rValue) const; \
     UINT GetHashTableSize() const; \
     void InitHashTable(UINT hashSize, BOOL bAllocNow = TRUE); \
+    /* OpenMFC extension, off by default: grow the buckets as the map fills */ \
+    void EnableAutoRehash(BOOL bEnable = TRUE) { \
+        openmfc_maphash::SetAutoGrow(m_pHashTable, m_nHashTableSize, bEnable != FALSE); \
+    } \
     virtual void Serialize(CArchive& ar) override; \
+    /* Implementation. Protected in MFC; public here so the exported          */ \
+    /* NewAssoc/FreeAssoc/GetAssocAt thunks can forward to them.              */ \
+    struct CAssoc { CAssoc* pNext; UINT nHashValue; key_type key; value_type value; }; \
+    CAssoc* NewAssoc(); \
+    void FreeAssoc(CAssoc* pAssoc); \
+    CAssoc* GetAssocAt(arg_key_type key, UINT& nHashBucket, UINT& nHashValue) const; \
+protected: \
+    /* Retail member block: sizeof 56, CObject at 0..7. Assocs are carved out  */ \
+    /* of CPlex blocks and chained from m_pHashTable, as in MFC.              */ \
+    CAssoc** m_pHashTable;  /* 0x08 */ \
+    UINT     m_nHashTableSize; /* 0x10 */ \
+    INT_PTR  m_nCount;      /* 0x18 */ \
+    CAssoc*  m_pFreeList;   /* 0x20 */ \
+    struct CPlex* m_pBlocks;/* 0x28 */ \
+    INT_PTR  m_nBlockSize;  /* 0x30 */ \
 };
 
 OPENMFC_DECLARE_ARRAY_WRAPPER(CUIntArray, unsigned int, unsigned int, DECLARE_DYNAMIC)
@@ -1505,6 +1798,8 @@ class CStringArray : public CObject {
 public:
     CStringArray();
     virtual ~CStringArray();
+    CStringArray(const CStringArray&) = delete;
+    CStringArray& operator=(const CStringArray&) = delete;
     INT_PTR GetSize() const;
     INT_PTR GetCount() const;
     BOOL IsEmpty() const;
@@ -1531,6 +1826,12 @@ public:
     void InsertAt(INT_PTR nStartIndex, CStringArray* pNewArray);
     void InsertEmpty(INT_PTR nIndex, INT_PTR nCount);
     virtual void Serialize(CArchive& ar) override;
+protected:
+    // Same 40-byte retail block as the OPENMFC_DECLARE_ARRAY_WRAPPER arrays.
+    CString* m_pData;       // 0x08
+    INT_PTR  m_nSize;       // 0x10
+    INT_PTR  m_nMaxSize;    // 0x18
+    INT_PTR  m_nGrowBy;     // 0x20
 };
 
 OPENMFC_DECLARE_LIST_WRAPPER(CObList, CObject*, CObject*, DECLARE_SERIAL)
@@ -1541,6 +1842,8 @@ public:
     typedef CList<CString, const CString&>::POSITION POSITION;
     explicit CStringList(INT_PTR nBlockSize = 10);
     virtual ~CStringList();
+    CStringList(const CStringList&) = delete;
+    CStringList& operator=(const CStringList&) = delete;
     INT_PTR GetCount() const;
     BOOL IsEmpty() const;
     CString& GetHead();
@@ -1573,6 +1876,18 @@ public:
     POSITION InsertAfter(POSITION position, const wchar_t* newElement);
     void RemoveAll();
     virtual void Serialize(CArchive& ar) override;
+    // Implementation (see OPENMFC_DECLARE_LIST_WRAPPER).
+    struct CNode { CNode* pNext; CNode* pPrev; CString data; };
+    CNode* NewNode(CNode* pPrev, CNode* pNext);
+    void FreeNode(CNode* pNode);
+protected:
+    // Same 56-byte retail block as the OPENMFC_DECLARE_LIST_WRAPPER lists.
+    CNode*   m_pNodeHead;   // 0x08
+    CNode*   m_pNodeTail;   // 0x10
+    INT_PTR  m_nCount;      // 0x18
+    CNode*   m_pNodeFree;   // 0x20
+    struct CPlex* m_pBlocks;// 0x28
+    INT_PTR  m_nBlockSize;  // 0x30
 };
 
 OPENMFC_DECLARE_MAP_WRAPPER(CMapPtrToPtr, void*, void*, void*, void*, void*, DECLARE_DYNAMIC)
@@ -1588,6 +1903,8 @@ public:
     typedef CMap<CString, const CString&, CObject*, CObject*>::POSITION POSITION;
     explicit CMapStringToOb(INT_PTR nBlockSize = 10);
     virtual ~CMapStringToOb();
+    CMapStringToOb(const CMapStringToOb&) = delete;
+    CMapStringToOb& operator=(const CMapStringToOb&) = delete;
 
     INT_PTR GetCount() const;
     BOOL IsEmpty() const;
@@ -1607,7 +1924,23 @@ public:
     void GetNextAssoc(POSITION& rNextPosition, CString& rKey, CObject*& rValue) const;
     UINT GetHashTableSize() const;
     void InitHashTable(UINT hashSize, BOOL bAllocNow = TRUE);
+    void EnableAutoRehash(BOOL bEnable = TRUE) {   // see OPENMFC_DECLARE_MAP_WRAPPER
+        openmfc_maphash::SetAutoGrow(m_pHashTable, m_nHashTableSize, bEnable != FALSE);
+    }
     virtual void Serialize(CArchive& ar) override;
+    // Implementation (see OPENMFC_DECLARE_MAP_WRAPPER).
+    struct CAssoc { CAssoc* pNext; UINT nHashValue; CString key; CObject* value; };
+    CAssoc* NewAssoc();
+    void FreeAssoc(CAssoc* pAssoc);
+    CAssoc* GetAssocAt(const wchar_t* key, UINT& nHashBucket, UINT& nHashValue) const;
+protected:
+    // Same 56-byte retail block as the OPENMFC_DECLARE_MAP_WRAPPER maps.
+    CAssoc** m_pHashTable;  // 0x08
+    UINT     m_nHashTableSize; // 0x10
+    INT_PTR  m_nCount;      // 0x18
+    CAssoc*  m_pFreeList;   // 0x20
+    struct CPlex* m_pBlocks;// 0x28
+    INT_PTR  m_nBlockSize;  // 0x30
 };
 
 class CMapStringToPtr : public CObject {
@@ -1617,6 +1950,8 @@ public:
     typedef CMap<CString, const CString&, void*, void*>::POSITION POSITION;
     explicit CMapStringToPtr(INT_PTR nBlockSize = 10);
     virtual ~CMapStringToPtr();
+    CMapStringToPtr(const CMapStringToPtr&) = delete;
+    CMapStringToPtr& operator=(const CMapStringToPtr&) = delete;
 
     INT_PTR GetCount() const;
     BOOL IsEmpty() const;
@@ -1636,7 +1971,23 @@ public:
     void GetNextAssoc(POSITION& rNextPosition, CString& rKey, void*& rValue) const;
     UINT GetHashTableSize() const;
     void InitHashTable(UINT hashSize, BOOL bAllocNow = TRUE);
+    void EnableAutoRehash(BOOL bEnable = TRUE) {   // see OPENMFC_DECLARE_MAP_WRAPPER
+        openmfc_maphash::SetAutoGrow(m_pHashTable, m_nHashTableSize, bEnable != FALSE);
+    }
     virtual void Serialize(CArchive& ar) override;
+    // Implementation (see OPENMFC_DECLARE_MAP_WRAPPER).
+    struct CAssoc { CAssoc* pNext; UINT nHashValue; CString key; void* value; };
+    CAssoc* NewAssoc();
+    void FreeAssoc(CAssoc* pAssoc);
+    CAssoc* GetAssocAt(const wchar_t* key, UINT& nHashBucket, UINT& nHashValue) const;
+protected:
+    // Same 56-byte retail block as the OPENMFC_DECLARE_MAP_WRAPPER maps.
+    CAssoc** m_pHashTable;  // 0x08
+    UINT     m_nHashTableSize; // 0x10
+    INT_PTR  m_nCount;      // 0x18
+    CAssoc*  m_pFreeList;   // 0x20
+    struct CPlex* m_pBlocks;// 0x28
+    INT_PTR  m_nBlockSize;  // 0x30
 };
 
 class CMapStringToString : public CObject {
@@ -1644,15 +1995,17 @@ class CMapStringToString : public CObject {
 public:
     typedef const wchar_t* BASE_KEY;
     typedef CMap<CString, const CString&, CString, const CString&>::POSITION POSITION;
+    // MFC's layout: the pair is the leading part of the assoc, so PLookup and
+    // the PGet*Assoc walk hand out the map's own nodes.
     struct CPair {
-        const CPair* pNextAssoc;
-        UINT nHashValue;
         CString key;
         CString value;
     };
 
     explicit CMapStringToString(INT_PTR nBlockSize = 10);
     virtual ~CMapStringToString();
+    CMapStringToString(const CMapStringToString&) = delete;
+    CMapStringToString& operator=(const CMapStringToString&) = delete;
 
     INT_PTR GetCount() const;
     BOOL IsEmpty() const;
@@ -1673,6 +2026,9 @@ public:
     void GetNextAssoc(POSITION& rNextPosition, CString& rKey, CString& rValue) const;
     UINT GetHashTableSize() const;
     void InitHashTable(UINT hashSize, BOOL bAllocNow = TRUE);
+    void EnableAutoRehash(BOOL bEnable = TRUE) {   // see OPENMFC_DECLARE_MAP_WRAPPER
+        openmfc_maphash::SetAutoGrow(m_pHashTable, m_nHashTableSize, bEnable != FALSE);
+    }
     CPair* PLookup(const wchar_t* key);
     const CPair* PLookup(const wchar_t* key) const;
     CPair* PGetFirstAssoc();
@@ -1680,6 +2036,20 @@ public:
     CPair* PGetNextAssoc(const CPair* pAssocRet);
     const CPair* PGetNextAssoc(const CPair* pAssocRet) const;
     virtual void Serialize(CArchive& ar) override;
+    // Implementation (see OPENMFC_DECLARE_MAP_WRAPPER).
+    struct CAssoc : CPair { CAssoc* pNext; UINT nHashValue; };
+    CAssoc* NewAssoc();
+    CAssoc* NewAssoc(const wchar_t* key);
+    void FreeAssoc(CAssoc* pAssoc);
+    CAssoc* GetAssocAt(const wchar_t* key, UINT& nHashBucket, UINT& nHashValue) const;
+protected:
+    // Same 56-byte retail block as the OPENMFC_DECLARE_MAP_WRAPPER maps.
+    CAssoc** m_pHashTable;  // 0x08
+    UINT     m_nHashTableSize; // 0x10
+    INT_PTR  m_nCount;      // 0x18
+    CAssoc*  m_pFreeList;   // 0x20
+    struct CPlex* m_pBlocks;// 0x28
+    INT_PTR  m_nBlockSize;  // 0x30
 };
 
 #undef OPENMFC_DECLARE_ARRAY_WRAPPER
@@ -1889,3 +2259,20 @@ inline void CObject::Serialize(CArchive& ar) {
     (void)ar;  // Base CObject::Serialize does nothing
 }
 #endif
+
+// AfxDump / CDumpContext(NULL) output (OpenMFC extensions). Dump text is
+// gathered into whole lines before it reaches the debugger. An application
+// can send it somewhere else and choose when it is written:
+//   afxDumpFlushImmediate - each fragment as it is written
+//   afxDumpFlushLine      - each completed line (the default)
+//   afxDumpFlushBlock     - whole lines, 4096 characters at a time, on
+//                           AfxFlushDump, and at exit
+// pfnOutput gets nul-terminated text; NULL sends output to the debugger
+// again. Either switch writes out what the old destination was owed.
+typedef void (AFXAPI* AFX_DUMP_OUTPUT_PROC)(const wchar_t* lpszText, size_t nLength, void* pContext);
+enum { afxDumpFlushImmediate = 0, afxDumpFlushLine = 1, afxDumpFlushBlock = 2 };
+extern "C" {
+void AFX_IMPORT_FUNC AfxSetDumpOutput(AFX_DUMP_OUTPUT_PROC pfnOutput, void* pContext);
+int AFX_IMPORT_FUNC AfxSetDumpFlushPolicy(int nPolicy);    // returns the previous policy
+void AFX_IMPORT_FUNC AfxFlushDump();
+}
@@ -73,6 +73,31 @@ public:
     BOOL ExecuteSQL(const wchar_t* lpszSQL);
     void Cancel();
 
+    // Prepared statements and parameter batches.
+    // ExecuteSQLBatch prepares a statement with '?' markers and runs it once
+    // per row of column-wise parameter arrays, as one SQL_ATTR_PARAMSET_SIZE
+    // execution when the driver allows. SetStatementCacheSize (off by
+    // default; 16 is a reasonable size) keeps that many prepared statements
+    // per connection, least recently used out first, so repeating an
+    // ExecuteSQL or ExecuteSQLBatch text skips the driver's parse. Recordsets
+    // always prepare their own statement after OnSetOptions.
+    struct ParamArray {
+        SQLSMALLINT nCType;         // SQL_C_* type of pValues
+        SQLSMALLINT nSQLType;       // SQL_* type of the marker
+        SQLULEN nColumnSize;
+        SQLSMALLINT nDecimalDigits;
+        void* pValues;              // nRows values, nValueSize bytes apart
+        SQLLEN nValueSize;
+        SQLLEN* pLengths;           // nRows lengths / SQL_NULL_DATA; may be null
+    };
+    BOOL ExecuteSQLBatch(const wchar_t* lpszSQL, const ParamArray* pParams,
+                         int nParams, DWORD nRows, DWORD* pRowsProcessed = nullptr);
+    void SetStatementCacheSize(int nStatements);   // 0 turns the cache off
+    int GetStatementCacheSize() const;
+    DWORD GetStatementCacheHits() const;
+    DWORD GetStatementCacheMisses() const;
+    void FlushStatementCache();
+
     // Direct execution
     BOOL CanTransact() const;
     BOOL CanUpdate() const;
@@ -94,9 +119,10 @@ public:
     BOOL m_bOpen;
     BOOL m_bReadOnly;
     CString m_strConnect;
+    struct CDatabaseStatementCache* m_pStatementCache;
 
 protected:
-    char _cdatabase_padding[48];
+    char _cdatabase_padding[40];
 };
 
 //=============================================================================
@@ -114,7 +140,8 @@ public:
         MarkForUpdate,
         AllocCache,
         StoreField,
-        DeleteField
+        DeleteField,
+        AllocMultiRowBuffer
     };
 
     CFieldExchange(RFX_Operation op, CRecordset* pRecordset);
@@ -184,6 +211,20 @@ public:
     void SetRowsetSize(DWORD dwNewRowsetSize);
     DWORD GetRowsetSize() const { return m_dwRowsetSize; }
 
+    // Bulk row fetching (useMultiRowFetch). Each fetch fills the RFX_*_Bulk
+    // arrays with up to GetRowsetSize() rows; MoveNext and MovePrev fetch the
+    // next or prior rowset. MoveNextRow / MovePrevRow (OpenMFC extensions)
+    // step one row at a time instead, going back to the driver only at
+    // either end of the rowset. The current row is element
+    // GetRowsetCursorPosition() - 1 of every array.
+    void MoveNextRow();
+    void MovePrevRow();
+    DWORD GetRowsFetched() const { return m_dwRowsFetched; }
+    WORD GetRowStatus(WORD wRow) const {
+        return m_rgRowStatus && wRow >= 1 && wRow <= m_dwRowsFetched ? m_rgRowStatus[wRow - 1] : (WORD)SQL_ROW_NOROW;
+    }
+    WORD GetRowsetCursorPosition() const { return (WORD)(m_dwRowsetRow + 1); }
+
     // Filtering and sorting
     CString m_strFilter;
     CString m_strSort;
@@ -192,6 +233,7 @@ public:
     virtual CString GetDefaultConnect();
     virtual CString GetDefaultSQL();
     virtual void DoFieldExchange(CFieldExchange* pFX);
+    virtual void DoBulkFieldExchange(CFieldExchange* pFX);
     virtual BOOL OnSetOptions(HSTMT hstmt);
     virtual void OnFieldChange(void* pvField, LONG* plLength);
 
@@ -226,11 +268,36 @@ public:
     int m_nOpenType;
     DWORD m_dwOptions;
     int m_nEditMode;
+    DWORD m_dwRowsFetched;
+    DWORD m_dwRowsetRow;                          // current row of the fetched rowset
+    WORD* m_rgRowStatus;
+    struct CRecordsetBulkRowset* m_pBulkRowset;   // useMultiRowFetch only
 
 protected:
-    char _crecordset_padding[128];
+    char _crecordset_padding[104];
 };
 
+//=============================================================================
+// Bulk record field exchange (call from DoBulkFieldExchange)
+//=============================================================================
+// Each call allocates a column-wise array of GetRowsetSize() values and one
+// of lengths (SQL_NULL_DATA for NULL), and binds the column to them.
+// nMaxLength counts characters (text) or bytes (binary) per value.
+void AFXAPI RFX_Text_Bulk(CFieldExchange* pFX, const wchar_t* szName, wchar_t** prgStrVals,
+                          __int64** prgLengths, int nMaxLength);
+void AFXAPI RFX_Text_Bulk(CFieldExchange* pFX, const wchar_t* szName, char** prgStrVals,
+                          __int64** prgLengths, int nMaxLength);
+void AFXAPI RFX_Bool_Bulk(CFieldExchange* pFX, const wchar_t* szName, BOOL** prgBoolVals, __int64** prgLengths);
+void AFXAPI RFX_Int_Bulk(CFieldExchange* pFX, const wchar_t* szName, int** prgIntVals, __int64** prgLengths);
+void AFXAPI RFX_Long_Bulk(CFieldExchange* pFX, const wchar_t* szName, long** prgLongVals, __int64** prgLengths);
+void AFXAPI RFX_Single_Bulk(CFieldExchange* pFX, const wchar_t* szName, float** prgFltVals, __int64** prgLengths);
+void AFXAPI RFX_Double_Bulk(CFieldExchange* pFX, const wchar_t* szName, double** prgDblVals, __int64** prgLengths);
+void AFXAPI RFX_Date_Bulk(CFieldExchange* pFX, const wchar_t* szName, TIMESTAMP_STRUCT** prgTSVals,
+                          __int64** prgLengths);
+void AFXAPI RFX_Byte_Bulk(CFieldExchange* pFX, const wchar_t* szName, BYTE** prgByteVals, __int64** prgLengths);
+void AFXAPI RFX_Binary_Bulk(CFieldExchange* pFX, const wchar_t* szName, BYTE** prgByteVals,
+                            __int64** prgLengths, int nMaxLength);
+
 //=============================================================================
 // CRecordView - Record View (form view bound to a recordset)
 //=============================================================================
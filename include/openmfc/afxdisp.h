@@ -1,7 +1,12 @@
 #pragma once
 #include "afxwin.h"
+#include <atomic>
 #include <cstdarg>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 // OLE/COM Dispatch support (minimal)
@@ -66,6 +71,81 @@ public:
     void Clear() { VariantClear(this); VariantInit(this); }
 };
 
+// Per-driver name -> DISPID caches behind COleDispatchDriver::GetDispID.
+//
+// A driver keeps MFC's layout (an IDispatch pointer and a BOOL), so its cache
+// lives in a table keyed by the driver's address. The driver is entirely
+// inline, so GetDispID and the ReleaseDispatch / DetachDispatch that drop
+// the cache always run in the same module and see the same table. Names are
+// matched exactly; GetIDsOfNames is case-insensitive, so "Visible" and
+// "visible" are each resolved once. Drivers may be used from any thread, so
+// the table takes a lock, but it is skipped without one while no driver has
+// cached anything. The table is never destroyed, so drivers with static
+// storage duration may still drop their caches during exit.
+namespace openmfc_dispcache {
+
+struct DriverCache {
+    std::deque<std::wstring> names;                     // stable storage for the keys
+    std::unordered_map<std::wstring_view, DISPID> ids;  // hits need no allocation
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::unordered_map<const void*, DriverCache> caches;
+    std::atomic<size_t> nCaches{0};
+};
+
+inline Registry& GetRegistry() {
+    static Registry* registry = new Registry;
+    return *registry;
+}
+
+inline bool Find(const void* pDriver, const wchar_t* lpszName, DISPID& dispid) {
+    Registry& registry = GetRegistry();
+    if (registry.nCaches.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto cache = registry.caches.find(pDriver);
+    if (cache == registry.caches.end()) {
+        return false;
+    }
+    auto id = cache->second.ids.find(std::wstring_view(lpszName));
+    if (id == cache->second.ids.end()) {
+        return false;
+    }
+    dispid = id->second;
+    return true;
+}
+
+inline void Store(const void* pDriver, const wchar_t* lpszName, DISPID dispid) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto inserted = registry.caches.try_emplace(pDriver);
+    if (inserted.second) {
+        registry.nCaches.fetch_add(1, std::memory_order_relaxed);
+    }
+    DriverCache& cache = inserted.first->second;
+    if (cache.ids.count(std::wstring_view(lpszName)) == 0) {
+        cache.names.emplace_back(lpszName);
+        cache.ids.emplace(cache.names.back(), dispid);
+    }
+}
+
+// Cheap when no driver has cached anything.
+inline void Drop(const void* pDriver) {
+    Registry& registry = GetRegistry();
+    if (registry.nCaches.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (registry.caches.erase(pDriver) != 0) {
+        registry.nCaches.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace openmfc_dispcache
+
 class COleDispatchDriver {
 public:
     COleDispatchDriver() : m_lpDispatch(nullptr), m_bAutoRelease(TRUE) {}
@@ -80,18 +160,42 @@ public:
     }
 
     LPDISPATCH DetachDispatch() {
+        FlushDispIDCache();
         LPDISPATCH lpDispatch = m_lpDispatch;
         m_lpDispatch = nullptr;
         return lpDispatch;
     }
 
     void ReleaseDispatch() {
+        FlushDispIDCache();
         if (m_lpDispatch && m_bAutoRelease) {
             m_lpDispatch->Release();
         }
         m_lpDispatch = nullptr;
     }
 
+    // OpenMFC extension: resolves lpszName with GetIDsOfNames the first time
+    // and from the driver's cache afterwards, until the dispatch is released
+    // or replaced.
+    DISPID GetDispID(const wchar_t* lpszName) {
+        if (!m_lpDispatch || !lpszName) {
+            AfxThrowOleException(E_POINTER);
+        }
+        DISPID dispid = DISPID_UNKNOWN;
+        if (openmfc_dispcache::Find(this, lpszName, dispid)) {
+            return dispid;
+        }
+        LPOLESTR name = const_cast<LPOLESTR>(lpszName);
+        HRESULT hr = m_lpDispatch->GetIDsOfNames(IID_NULL, &name, 1, LOCALE_USER_DEFAULT, &dispid);
+        if (FAILED(hr)) {
+            AfxThrowOleException(hr);
+        }
+        openmfc_dispcache::Store(this, lpszName, dispid);
+        return dispid;
+    }
+
+    void FlushDispIDCache() { openmfc_dispcache::Drop(this); }
+
     LPDISPATCH GetIDispatch(BOOL bAddRef = FALSE) const {
         if (m_lpDispatch && bAddRef) {
             m_lpDispatch->AddRef();
@@ -135,29 +239,24 @@ public:
             AfxThrowOleException(E_POINTER);
         }
 
+        // IDispatch::Invoke takes the arguments last to first. Typical calls
+        // fit the array on the stack; longer lists spill to the heap.
         int cParams = CountParams(pbParamInfo);
-        std::vector<VARIANTARG> params;
-        params.reserve(cParams);
-
-        // Build parameters in reverse order for IDispatch::Invoke.
+        VARIANTARG inlineArgs[kInlineArgs];
+        std::vector<VARIANTARG> spilledArgs;
+        VARIANTARG* pArgs = inlineArgs;
+        if (cParams > kInlineArgs) {
+            spilledArgs.resize(static_cast<size_t>(cParams));
+            pArgs = spilledArgs.data();
+        }
         for (int i = 0; i < cParams; ++i) {
             VARTYPE vt = static_cast<VARTYPE>(pbParamInfo[i]);
-            VARIANTARG var = MakeVariant(vt, &args);
-            params.push_back(var);
-        }
-
-        std::vector<VARIANTARG> reversed;
-        reversed.reserve(cParams);
-        for (int i = cParams - 1; i >= 0; --i) {
-            reversed.push_back(params[static_cast<size_t>(i)]);
-            if (i == 0) {
-                break;
-            }
+            pArgs[cParams - 1 - i] = MakeVariant(vt, &args);
         }
 
         DISPPARAMS dispParams = {};
         dispParams.cArgs = cParams;
-        dispParams.rgvarg = cParams ? reversed.data() : nullptr;
+        dispParams.rgvarg = cParams ? pArgs : nullptr;
 
         DISPID dispidNamed = DISPID_PROPERTYPUT;
         if (wFlags & (DISPATCH_PROPERTYPUT | DISPATCH_PROPERTYPUTREF)) {
@@ -175,7 +274,7 @@ public:
 
         // Clean up argument variants.
         for (int i = 0; i < cParams; ++i) {
-            VariantClear(&params[static_cast<size_t>(i)]);
+            VariantClear(&pArgs[i]);
         }
 
         if (FAILED(hr)) {
@@ -212,6 +311,8 @@ public:
     }
 
 private:
+    static const int kInlineArgs = 16;
+
     static int CountParams(const unsigned char* pbParamInfo) {
         if (!pbParamInfo) {
             return 0;
@@ -238,7 +238,8 @@ public:
     DWORD m_dwContext;
 
 protected:
-    char _inetfile_padding[40];
+    struct CInternetFileReadBuffer* m_pReadBuffer;   // null until first needed
+    char _inetfile_padding[32];
 };
 
 //=============================================================================
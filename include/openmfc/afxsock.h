@@ -130,6 +130,7 @@ public:
     static void AuxQueueAdd(UINT message, SOCKET hSocket, long lParam);
     static int ProcessAuxQueue();
     int SendChunk(const void* lpBuf, int nBufLen, int nFlags);
+    int SendChunks(WSABUF* lpBuffers, DWORD dwBufferCount, int nFlags = 0);
     int _OpenMfcReceiveFromHelper(void* lpBuf, int nBufLen, struct sockaddr* lpSockAddr, int* lpSockAddrLen, int nFlags) {
         return ReceiveFromHelper(lpBuf, nBufLen, lpSockAddr, lpSockAddrLen, nFlags);
     }
@@ -147,10 +148,12 @@ protected:
     virtual int OnMessagePending();
     int PumpMessages(UINT uStopFlag);
 
-    int m_bBlocking;
+    int m_bBlocking;        // TRUE while a blocking call is in progress
+    int m_nConnectError;    // error reported with FD_CONNECT
+    int m_nTimeOut;         // ms between OnMessagePending calls while blocked
 
 protected:
-    char _socket_padding[32];
+    char _socket_padding[24];
 };
 
 //=============================================================================
@@ -181,12 +184,19 @@ public:
     virtual void UnlockRange(ULONGLONG dwPos, ULONGLONG dwCount);
     virtual int Open(const wchar_t* lpszFileName, UINT nOpenFlags, CFileException* pError = nullptr);
 
+    // OpenMFC: read-ahead / write-coalescing buffer sizes, both 0 (off) by
+    // default; 64 KB each is a good size. Coalesced writes go out when the
+    // buffer fills, on Flush, and before every Read. With both on, CArchive
+    // works in the buffers directly. Fails while data is buffered.
+    int SetBufferSizes(UINT nReadAhead, UINT nWriteCoalesce);
+
 public:
     CSocket* m_pSocket;
     int m_bArchiveCompatible;
 
 protected:
-    char _socketfile_padding[32];
+    struct CSocketFileBuffers* m_pBuffers;
+    char _socketfile_padding[24];
 };
 
 //=============================================================================
@@ -5,6 +5,9 @@
 #include <cstdio>
 #include <cstdint>
 #include <cstdarg>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
 
 // Windows type definitions
 #ifndef UINT
@@ -66,37 +69,193 @@ struct CStringData {
     wchar_t* data() { return reinterpret_cast<wchar_t*>(this + 1); }
     const wchar_t* data() const { return reinterpret_cast<const wchar_t*>(this + 1); }
 
-    void AddRef() { if (nRefs >= 0) ++nRefs; }
-    bool Release() { return (nRefs >= 0 && --nRefs <= 0); }
-    bool IsLocked() const { return nRefs < 0; }
-    bool IsShared() const { return nRefs > 1; }
+    // Interlocked, as ATL's are: a CString copy may be released on another
+    // thread. A locked buffer (nRefs == -1) is owned by one CString and never
+    // shared, so testing for the lock needs no read-modify-write.
+    void AddRef() {
+        if (LoadRefs() >= 0) {
+#if defined(_MSC_VER) && !defined(__clang__)
+            _InterlockedIncrement(&nRefs);
+#else
+            __atomic_add_fetch(&nRefs, 1, __ATOMIC_RELAXED);
+#endif
+        }
+    }
+    bool Release() {
+        if (LoadRefs() < 0) return false;
+#if defined(_MSC_VER) && !defined(__clang__)
+        return _InterlockedDecrement(&nRefs) <= 0;
+#else
+        return __atomic_sub_fetch(&nRefs, 1, __ATOMIC_ACQ_REL) <= 0;
+#endif
+    }
+    bool IsLocked() const { return LoadRefs() < 0; }
+    bool IsShared() const { return LoadRefs() > 1; }
+
+private:
+    long LoadRefs() const {
+#if defined(_MSC_VER) && !defined(__clang__)
+        return *static_cast<const volatile long*>(&nRefs);
+#else
+        return __atomic_load_n(&nRefs, __ATOMIC_RELAXED);
+#endif
+    }
 };
 
 static_assert(sizeof(CStringData) == 24, "CStringData must match ATL (24 bytes)");
 
 inline CStringData* GetNilStringData();  // fwd (manager references it)
 
+// Per-thread free lists behind OpenMFCStringMgr. Every block carries a
+// 16-byte prefix ahead of its CStringData recording its size class, so Free
+// and Reallocate (which an MSVC client may call on our buffers) need no
+// nCharSize. Small blocks come in five payload classes -- 16..256 wchar_t, or
+// twice as many chars -- and are recycled through the freeing thread's cache;
+// larger ones go to malloc/realloc. A block may be freed on any thread: all
+// blocks of a class are interchangeable.
+namespace openmfc_strpool {
+
+const int kClassCount = 5;
+const int kLargeClass = kClassCount;
+const unsigned kMaxCachedPerClass = 32;
+const size_t kPrefixBytes = 16;        // keeps CStringData 16-byte aligned
+
+inline size_t ClassPayloadBytes(int nClass) { return size_t(32) << nClass; }   // 32..512
+
+inline int ClassForPayload(size_t nPayloadBytes) {
+    if (nPayloadBytes <= ClassPayloadBytes(0)) return 0;
+    if (nPayloadBytes > ClassPayloadBytes(kClassCount - 1)) return kLargeClass;
+    // ceil(log2(nPayloadBytes)) - 5, for 33..512
+    unsigned nBits = 0;
+    for (size_t n = (nPayloadBytes - 1) >> 5; n != 0; n >>= 1) ++nBits;
+    return static_cast<int>(nBits);
+}
+
+struct BlockPrefix {
+    int nClass;
+    int nReserved[3];
+};
+static_assert(sizeof(BlockPrefix) == kPrefixBytes, "string block prefix must stay 16 bytes");
+
+inline BlockPrefix* PrefixOf(CStringData* pData) {
+    return reinterpret_cast<BlockPrefix*>(reinterpret_cast<char*>(pData) - kPrefixBytes);
+}
+inline CStringData* DataOf(BlockPrefix* pBlock) {
+    return reinterpret_cast<CStringData*>(reinterpret_cast<char*>(pBlock) + kPrefixBytes);
+}
+
+// Trivially destructible so it stays usable while (and after) the thread
+// exits; the reaper below drains it and marks it closed.
+struct ThreadCache {
+    void* pHead[kClassCount];          // singly linked through the block's first word
+    unsigned nCount[kClassCount];
+    bool bReaperArmed;
+    bool bClosed;
+};
+
+inline ThreadCache& GetThreadCache() {
+    thread_local ThreadCache cache;    // zero-initialised
+    return cache;
+}
+
+struct ThreadCacheReaper {
+    ~ThreadCacheReaper() {
+        ThreadCache& cache = GetThreadCache();
+        for (int nClass = 0; nClass < kClassCount; ++nClass) {
+            while (void* pBlock = cache.pHead[nClass]) {
+                cache.pHead[nClass] = *static_cast<void**>(pBlock);
+                free(pBlock);
+            }
+            cache.nCount[nClass] = 0;
+        }
+        cache.bClosed = true;          // strings freed later on this thread go straight to free()
+    }
+};
+
+inline void ArmReaper(ThreadCache& cache) {
+    thread_local ThreadCacheReaper reaper;
+    (void)reaper;
+    cache.bReaperArmed = true;
+}
+
+inline BlockPrefix* AllocBlock(int nClass, size_t nPayloadBytes) {
+    if (nClass != kLargeClass) {
+        ThreadCache& cache = GetThreadCache();
+        if (void* pBlock = cache.pHead[nClass]) {
+            cache.pHead[nClass] = *static_cast<void**>(pBlock);
+            --cache.nCount[nClass];
+            static_cast<BlockPrefix*>(pBlock)->nClass = nClass;   // the link overwrote it
+            return static_cast<BlockPrefix*>(pBlock);
+        }
+        nPayloadBytes = ClassPayloadBytes(nClass);
+    }
+    BlockPrefix* pBlock = static_cast<BlockPrefix*>(malloc(kPrefixBytes + sizeof(CStringData) + nPayloadBytes));
+    if (pBlock) pBlock->nClass = nClass;
+    return pBlock;
+}
+
+inline void FreeBlock(BlockPrefix* pBlock) {
+    int nClass = pBlock->nClass;
+    if (nClass != kLargeClass) {
+        ThreadCache& cache = GetThreadCache();
+        if (!cache.bClosed && cache.nCount[nClass] < kMaxCachedPerClass) {
+            if (!cache.bReaperArmed) ArmReaper(cache);
+            *reinterpret_cast<void**>(pBlock) = cache.pHead[nClass];
+            cache.pHead[nClass] = pBlock;
+            ++cache.nCount[nClass];
+            return;
+        }
+    }
+    free(pBlock);
+}
+
+} // namespace openmfc_strpool
+
 // The OpenMFC string manager. Its vtable layout matches IAtlStringMgr, so a MSVC
 // client can call Free/Reallocate/etc. on buffers our DLL allocated (and vice versa).
+// nAllocLength always reports the requested capacity; a small block's class
+// slack only lets Reallocate grow in place.
 class OpenMFCStringMgr : public IAtlStringMgr {
 public:
     CStringData* Allocate(int nAllocLength, int nCharSize) override {
-        size_t nBytes = sizeof(CStringData) + static_cast<size_t>(nAllocLength + 1) * nCharSize;
-        CStringData* pData = static_cast<CStringData*>(malloc(nBytes));
-        if (!pData) return nullptr;
+        size_t nPayload = static_cast<size_t>(nAllocLength + 1) * nCharSize;
+        openmfc_strpool::BlockPrefix* pBlock =
+            openmfc_strpool::AllocBlock(openmfc_strpool::ClassForPayload(nPayload), nPayload);
+        if (!pBlock) return nullptr;
+        CStringData* pData = openmfc_strpool::DataOf(pBlock);
         pData->pStringMgr = this;
         pData->nDataLength = 0;
         pData->nAllocLength = nAllocLength;
         pData->nRefs = 1;
         return pData;
     }
-    void Free(CStringData* pData) override { free(pData); }
+    void Free(CStringData* pData) override {
+        if (pData) openmfc_strpool::FreeBlock(openmfc_strpool::PrefixOf(pData));
+    }
     CStringData* Reallocate(CStringData* pData, int nAllocLength, int nCharSize) override {
-        size_t nBytes = sizeof(CStringData) + static_cast<size_t>(nAllocLength + 1) * nCharSize;
-        CStringData* pNew = static_cast<CStringData*>(realloc(pData, nBytes));
+        using namespace openmfc_strpool;
+        size_t nPayload = static_cast<size_t>(nAllocLength + 1) * nCharSize;
+        BlockPrefix* pBlock = PrefixOf(pData);
+        int nOldClass = pBlock->nClass;
+        int nNewClass = ClassForPayload(nPayload);
+        if (nOldClass != kLargeClass && nNewClass <= nOldClass) {
+            pData->nAllocLength = nAllocLength;    // fits the block it already has
+            return pData;
+        }
+        if (nOldClass == kLargeClass && nNewClass == kLargeClass) {
+            BlockPrefix* pNew = static_cast<BlockPrefix*>(realloc(pBlock, kPrefixBytes + sizeof(CStringData) + nPayload));
+            if (!pNew) return nullptr;
+            DataOf(pNew)->nAllocLength = nAllocLength;
+            return DataOf(pNew);
+        }
+        // Moving between classes: copy header plus the smaller of the payloads.
+        BlockPrefix* pNew = AllocBlock(nNewClass, nPayload);
         if (!pNew) return nullptr;
-        pNew->nAllocLength = nAllocLength;
-        return pNew;
+        size_t nOldPayload = static_cast<size_t>(pData->nAllocLength + 1) * nCharSize;
+        memcpy(DataOf(pNew), pData, sizeof(CStringData) + (nOldPayload < nPayload ? nOldPayload : nPayload));
+        FreeBlock(pBlock);
+        DataOf(pNew)->nAllocLength = nAllocLength;
+        return DataOf(pNew);
     }
     CStringData* GetNilString() override { return GetNilStringData(); }
     IAtlStringMgr* Clone() override { return this; }
@@ -390,6 +390,14 @@ enum AfxSig
     AfxSig_vv_i = 20,     // void (void) - returns int
 };
 
+// Command notification codes passed to OnCmdMsg as nCode
+#ifndef CN_COMMAND
+#define CN_COMMAND              0               // void ()
+#endif
+#ifndef CN_UPDATE_COMMAND_UI
+#define CN_UPDATE_COMMAND_UI    ((UINT)(-1))    // void (CCmdUI*)
+#endif
+
 //=============================================================================
 // CCmdTarget - base for command message handling
 //=============================================================================
@@ -3978,6 +3986,10 @@ public:
     virtual BOOL Lock(DWORD dwTimeout);
     virtual BOOL Unlock();
 
+    // How long EnterCriticalSection and timed Lock spin before blocking;
+    // returns the previous count.
+    DWORD SetSpinCount(DWORD dwSpinCount);
+
     // Data
     CRITICAL_SECTION m_sect;
 };
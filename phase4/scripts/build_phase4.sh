@@ -272,6 +272,27 @@ cat >> "$BUILD/openmfc.def" << 'EOF_OPENMFC_EXPORTS'
     ?AssertValid@CFileException@@UEBAXXZ=impl__AssertValid_CFileException__UEBAXXZ
     ?Dump@CArchiveException@@UEBAXXZ=impl__Dump_CArchiveException__UEBAXXZ
     ?AssertValid@CArchiveException@@UEBAXXZ=impl__AssertValid_CArchiveException__UEBAXXZ
+    ; OpenMFC extensions (afx.h): AfxDump / CDumpContext(NULL) output channel
+    AfxSetDumpOutput=impl__AfxSetDumpOutput
+    AfxSetDumpFlushPolicy=impl__AfxSetDumpFlushPolicy
+    AfxFlushDump=impl__AfxFlushDump
+    ; OpenMFC extensions (afx.h): CMemFile growth policy
+    ?SetGeometricGrowth@CMemFile@@QEAAX_K@Z=impl__SetGeometricGrowth_CMemFile__QEAAX_K_Z
+    ?ReserveAddressSpace@CMemFile@@QEAAH_K@Z=impl__ReserveAddressSpace_CMemFile__QEAAH_K_Z
+    ; OpenMFC extensions (afxsock.h): CSocketFile buffering
+    ?SetBufferSizes@CSocketFile@@QEAAHII@Z=impl__SetBufferSizes_CSocketFile__QEAAHII_Z
+    ; OpenMFC extensions (afxdb.h): CDatabase statement cache and parameter batches
+    ?ExecuteSQLBatch@CDatabase@@QEAAHPEB_WPEBUParamArray@1@HKPEAK@Z=impl__ExecuteSQLBatch_CDatabase__QEAAHPEB_WPEBUParamArray_1_HKPEAK_Z
+    ?SetStatementCacheSize@CDatabase@@QEAAXH@Z=impl__SetStatementCacheSize_CDatabase__QEAAXH_Z
+    ?GetStatementCacheSize@CDatabase@@QEBAHXZ=impl__GetStatementCacheSize_CDatabase__QEBAHXZ
+    ?GetStatementCacheHits@CDatabase@@QEBAKXZ=impl__GetStatementCacheHits_CDatabase__QEBAKXZ
+    ?GetStatementCacheMisses@CDatabase@@QEBAKXZ=impl__GetStatementCacheMisses_CDatabase__QEBAKXZ
+    ?FlushStatementCache@CDatabase@@QEAAXXZ=impl__FlushStatementCache_CDatabase__QEAAXXZ
+    ; OpenMFC extensions (afxdb.h): CRecordset row stepping within a rowset
+    ?MoveNextRow@CRecordset@@QEAAXXZ=impl__MoveNextRow_CRecordset__QEAAXXZ
+    ?MovePrevRow@CRecordset@@QEAAXXZ=impl__MovePrevRow_CRecordset__QEAAXXZ
+    ; OpenMFC extensions (afxwin.h): CCriticalSection spin count
+    ?SetSpinCount@CCriticalSection@@QEAAKK@Z=impl__SetSpinCount_CCriticalSection__QEAAKK_Z
     ; GDI class runtime classes
     ?classCGdiObject@CGdiObject@@2UCRuntimeClass@@A=_ZN10CGdiObject15classCGdiObjectE DATA
     ?classCPen@CPen@@2UCRuntimeClass@@A=_ZN4CPen9classCPenE DATA
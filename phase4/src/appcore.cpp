@@ -6,11 +6,14 @@
 // Define OPENMFC_APPCORE_IMPL to use extern declarations instead of inline stubs
 #define OPENMFC_APPCORE_IMPL
 #include "openmfc/afxwin.h"
+#include "profile_store.h"
 #include <windows.h>
 #include <algorithm>
 #include <cstdlib>
 #include <cstring>
+#include <cwchar>
 #include <cwctype>
+#include <memory>
 #include <new>
 #include <string>
 #include <unordered_map>
@@ -24,120 +27,8 @@
   #define MS_ABI
 #endif
 
-namespace {
-
-CRuntimeClass* const g_coreRuntimeClasses[] = {
-    &CObject::classCObject,
-    &CException::classCException,
-    &CMemoryException::classCMemoryException,
-    &CFileException::classCFileException,
-    &CArchiveException::classCArchiveException,
-    &CCmdTarget::classCCmdTarget,
-    &CWinThread::classCWinThread,
-    &CWinApp::classCWinApp,
-};
-
-bool RuntimeClassNameEquals(const char* lhs, const char* rhs) {
-    return lhs && rhs && std::strcmp(lhs, rhs) == 0;
-}
-
-bool RuntimeClassNameEquals(const char* lhs, const wchar_t* rhs) {
-    if (!lhs || !rhs) return false;
-    while (*lhs && *rhs) {
-        if (static_cast<unsigned char>(*lhs) != static_cast<unsigned int>(*rhs)) return false;
-        ++lhs;
-        ++rhs;
-    }
-    return *lhs == '\0' && *rhs == L'\0';
-}
-
-CRuntimeClass* FindRuntimeClassByName(const char* name) {
-    if (!name || !*name) return nullptr;
-    for (CRuntimeClass* seed : g_coreRuntimeClasses) {
-        for (CRuntimeClass* pClass = seed; pClass; pClass = pClass->m_pNextClass) {
-            if (RuntimeClassNameEquals(pClass->m_lpszClassName, name)) return pClass;
-        }
-    }
-    return nullptr;
-}
-
-CRuntimeClass* FindRuntimeClassByName(const wchar_t* name) {
-    if (!name || !*name) return nullptr;
-    for (CRuntimeClass* seed : g_coreRuntimeClasses) {
-        for (CRuntimeClass* pClass = seed; pClass; pClass = pClass->m_pNextClass) {
-            if (RuntimeClassNameEquals(pClass->m_lpszClassName, name)) return pClass;
-        }
-    }
-    return nullptr;
-}
-
-}  // namespace
-
-// Symbol: ?CreateObject@CRuntimeClass@@QEAAPEAVCObject@@XZ
-extern "C" CObject* MS_ABI impl__CreateObject_CRuntimeClass__QEAAPEAVCObject__XZ(CRuntimeClass* pThis) {
-    return pThis ? pThis->CreateObject() : nullptr;
-}
-
-// Symbol: ?CreateObject@CRuntimeClass@@SAPEAVCObject@@PEBD@Z
-extern "C" CObject* MS_ABI impl__CreateObject_CRuntimeClass__SAPEAVCObject__PEBD_Z(const char* className) {
-    CRuntimeClass* pClass = FindRuntimeClassByName(className);
-    return pClass ? pClass->CreateObject() : nullptr;
-}
-
-// Symbol: ?CreateObject@CRuntimeClass@@SAPEAVCObject@@PEB_W@Z
-extern "C" CObject* MS_ABI impl__CreateObject_CRuntimeClass__SAPEAVCObject__PEB_W_Z(const wchar_t* className) {
-    CRuntimeClass* pClass = FindRuntimeClassByName(className);
-    return pClass ? pClass->CreateObject() : nullptr;
-}
-
-// Symbol: ?FromName@CRuntimeClass@@SAPEAU1@PEBD@Z
-extern "C" CRuntimeClass* MS_ABI impl__FromName_CRuntimeClass__SAPEAU1_PEBD_Z(const char* className) {
-    return FindRuntimeClassByName(className);
-}
-
-// Symbol: ?FromName@CRuntimeClass@@SAPEAU1@PEB_W@Z
-extern "C" CRuntimeClass* MS_ABI impl__FromName_CRuntimeClass__SAPEAU1_PEB_W_Z(const wchar_t* className) {
-    return FindRuntimeClassByName(className);
-}
-
-// Symbol: ?IsDerivedFrom@CRuntimeClass@@QEBAHPEBU1@@Z
-extern "C" int MS_ABI impl__IsDerivedFrom_CRuntimeClass__QEBAHPEBU1__Z(
-    const CRuntimeClass* pThis, const CRuntimeClass* pBaseClass) {
-    return (pThis && pBaseClass && pThis->IsDerivedFrom(pBaseClass)) ? TRUE : FALSE;
-}
-
-// Symbol: ?Load@CRuntimeClass@@SAPEAU1@AEAVCArchive@@PEAI@Z
-extern "C" CRuntimeClass* MS_ABI impl__Load_CRuntimeClass__SAPEAU1_AEAVCArchive__PEAI_Z(
-    CArchive* ar, unsigned int* pwSchemaNum) {
-    if (!ar) return nullptr;
-
-    unsigned int schema = 0xFFFF;
-    unsigned int nameLength = 0;
-    if (ar->Read(&schema, sizeof(schema)) != sizeof(schema) ||
-        ar->Read(&nameLength, sizeof(nameLength)) != sizeof(nameLength)) {
-        if (pwSchemaNum) *pwSchemaNum = 0xFFFF;
-        return nullptr;
-    }
-
-    if (pwSchemaNum) *pwSchemaNum = schema;
-    if (nameLength == 0 || nameLength > 4096) return nullptr;
-
-    std::vector<char> name(nameLength + 1, '\0');
-    if (ar->Read(name.data(), nameLength) != nameLength) return nullptr;
-    return FindRuntimeClassByName(name.data());
-}
-
-// Symbol: ?Store@CRuntimeClass@@QEBAXAEAVCArchive@@@Z
-extern "C" void MS_ABI impl__Store_CRuntimeClass__QEBAXAEAVCArchive___Z(
-    const CRuntimeClass* pThis, CArchive* ar) {
-    if (!pThis || !ar) return;
-    const char* className = pThis->m_lpszClassName ? pThis->m_lpszClassName : "";
-    unsigned int schema = pThis->m_wSchema;
-    unsigned int nameLength = static_cast<unsigned int>(std::strlen(className));
-    ar->Write(&schema, sizeof(schema));
-    ar->Write(&nameLength, sizeof(nameLength));
-    if (nameLength != 0) ar->Write(className, nameLength);
-}
+// The CRuntimeClass exports (CreateObject, FromName, IsDerivedFrom, Load,
+// Store) live in cobject_impl.cpp.
 
 // =============================================================================
 // Forward declarations from wincore.cpp
@@ -237,26 +128,29 @@ const AFX_MSGMAP_ENTRY CCmdTarget::_messageEntries[] =
     {0, 0, 0, 0, AfxSig_end, (AFX_PMSG)0 }
 };
 
+// Per-thread message-map cache (global_afx_msgcache.cpp)
+extern const AFX_MSGMAP_ENTRY* OpenMfcLookupMessageEntry(const AFX_MSGMAP* pMap, UINT nMsg, UINT nCode, UINT nID);
+
 int CCmdTarget::OnCmdMsg(unsigned int nID, int nCode, void* pExtra, void* pHandlerInfo)
 {
-    // Simple command routing
-    const AFX_MSGMAP* pMap = GetMessageMap();
-    
-    for (; pMap != nullptr; pMap = (*pMap->pfnGetBaseMap)())
+    // As in MFC, a notification routed as a command carries its window message
+    // in the high word of nCode; CN_UPDATE_COMMAND_UI (-1) is never split.
+    UINT nMsg = 0;
+    UINT nCodeKey = static_cast<UINT>(nCode);
+    if (nCodeKey != CN_UPDATE_COMMAND_UI)
     {
-        const AFX_MSGMAP_ENTRY* lpEntry = pMap->lpEntries;
-        while (lpEntry->nSig != AfxSig_end)
-        {
-            if (lpEntry->nID == nID && lpEntry->nCode == (UINT)nCode)
-            {
-                // Found a match
-                return DispatchCmdMsg(this, nID, nCode, lpEntry->pfn, pExtra, lpEntry->nSig, pHandlerInfo);
-            }
-            lpEntry++;
-        }
+        nMsg = HIWORD(nCodeKey);
+        nCodeKey = LOWORD(nCodeKey);
     }
-    
-    return FALSE; // Not handled
+    if (nMsg == 0)
+        nMsg = WM_COMMAND;
+
+    const AFX_MSGMAP_ENTRY* lpEntry = OpenMfcLookupMessageEntry(GetMessageMap(), nMsg, nCodeKey, nID);
+    if (lpEntry == nullptr)
+        return FALSE; // Not handled
+
+    return DispatchCmdMsg(this, nID, static_cast<int>(nCodeKey), lpEntry->pfn, pExtra,
+                          static_cast<unsigned int>(lpEntry->nSig), pHandlerInfo);
 }
 
 int PASCAL CCmdTarget::DispatchCmdMsg(CCmdTarget* pTarget, unsigned int nID, int nCode,
@@ -846,6 +740,11 @@ asm(".globl \"?classCWinApp@CWinApp@@2UCRuntimeClass@@A\"\n"
 // Source-backed defaults are provided here for _AFXDLL consumers.
 extern CWinApp* g_pApp;
 
+// Close saves queued WriteProfile* changes and stops the app's profile
+// writer; Release drops the store. Defined after the app runtime state below.
+void OpenMfcCloseAppProfile(CWinApp* app);
+void OpenMfcReleaseAppProfile(CWinApp* app);
+
 CWinApp::CWinApp(const wchar_t* lpszAppName) {
     m_pMainWnd = nullptr;
     m_nThreadID = ::GetCurrentThreadId();
@@ -872,6 +771,7 @@ BOOL CWinApp::InitInstance() {
 }
 
 int CWinApp::ExitInstance() {
+    OpenMfcCloseAppProfile(this);
     return CWinThread::ExitInstance();
 }
 
@@ -938,6 +838,7 @@ extern "C" CWinApp* MS_ABI impl___0CWinApp__QEAA_PEB_W_Z(CWinApp* pThis, const w
 // Symbol: ??1CWinApp@@UEAA@XZ
 // Ordinal: 1450
 extern "C" void MS_ABI impl___1CWinApp__UEAA_XZ(CWinApp* pThis) {
+    OpenMfcReleaseAppProfile(pThis);
     if (g_pApp == pThis) {
         g_pApp = nullptr;
     }
@@ -1094,9 +995,7 @@ struct AppRuntimeState {
     std::vector<CDocTemplate*> templates;
     std::vector<std::wstring> recentEntries;
     unsigned int maxRecent = 4;
-    std::unordered_map<std::wstring, unsigned int> profileInts;
-    std::unordered_map<std::wstring, std::wstring> profileStrings;
-    std::unordered_map<std::wstring, std::vector<unsigned char>> profileBinary;
+    std::unique_ptr<openmfc_profile::ProfileStore> profile;
     std::wstring registryRoot;
     std::wstring appId;
     bool modelessEnabled = true;
@@ -1126,13 +1025,6 @@ constexpr int kShellCommandAppRegister = 5;
 constexpr int kShellCommandAppUnregister = 6;
 constexpr int kShellCommandFileDDE = 7;
 
-std::wstring MakeProfileKey(const wchar_t* section, const wchar_t* entry) {
-    std::wstring key = section ? section : L"";
-    key.push_back(L'\x1f');
-    key.append(entry ? entry : L"");
-    return key;
-}
-
 std::wstring WideValue(const wchar_t* value) {
     return value ? value : L"";
 }
@@ -1143,18 +1035,249 @@ std::wstring LowerWide(std::wstring value) {
     return value;
 }
 
+std::wstring GetAppName(CWinApp* app) {
+    if (app && app->m_pszAppName && *app->m_pszAppName) return app->m_pszAppName;
+    if (app && app->m_pszExeName && *app->m_pszExeName) return app->m_pszExeName;
+    return L"OpenMFC";
+}
+
+std::wstring GetAppProfileName(CWinApp* app) {
+    if (app && app->m_pszProfileName && *app->m_pszProfileName) return app->m_pszProfileName;
+    return GetAppName(app);
+}
+
+// HKCU\Software\<registry key>\<profile name>, as MFC lays it out.
 std::wstring GetAppRegistryRoot(CWinApp* app) {
     AppRuntimeState& state = g_appRuntimeStates[app];
-    if (!state.registryRoot.empty()) return state.registryRoot;
-    if (app && app->m_pszRegistryKey && *app->m_pszRegistryKey) return app->m_pszRegistryKey;
+    if (!state.registryRoot.empty()) return state.registryRoot + L"\\" + GetAppProfileName(app);
+    if (app && app->m_pszRegistryKey && *app->m_pszRegistryKey) {
+        return std::wstring(L"Software\\") + app->m_pszRegistryKey + L"\\" + GetAppProfileName(app);
+    }
     if (app && app->m_pszAppName && *app->m_pszAppName) return std::wstring(L"Software\\") + app->m_pszAppName;
     return L"Software\\OpenMFC";
 }
 
-std::wstring GetAppName(CWinApp* app) {
-    if (app && app->m_pszAppName && *app->m_pszAppName) return app->m_pszAppName;
-    if (app && app->m_pszExeName && *app->m_pszExeName) return app->m_pszExeName;
-    return L"OpenMFC";
+bool UsesRegistryProfile(CWinApp* app) {
+    if (!g_appRuntimeStates[app].registryRoot.empty()) return true;
+    return app && app->m_pszRegistryKey && *app->m_pszRegistryKey;
+}
+
+// Without SetRegistryKey the profile is an INI file. Bare names resolve
+// against the Windows directory, as GetPrivateProfileString does.
+std::wstring GetAppIniPath(CWinApp* app) {
+    std::wstring name;
+    if (app && app->m_pszProfileName && *app->m_pszProfileName) name = app->m_pszProfileName;
+    else if (app && app->m_pszExeName && *app->m_pszExeName) name = std::wstring(app->m_pszExeName) + L".INI";
+    else name = GetAppName(app) + L".INI";
+    if (name.find_first_of(L"\\/:") != std::wstring::npos) return name;
+
+    wchar_t directory[MAX_PATH] = {};
+    const UINT length = ::GetWindowsDirectoryW(directory, MAX_PATH);
+    if (length == 0 || length >= MAX_PATH) return name;
+    std::wstring path(directory, length);
+    if (path.back() != L'\\') path.push_back(L'\\');
+    return path + name;
+}
+
+class RegistryProfileBackend : public openmfc_profile::Backend {
+public:
+    explicit RegistryProfileBackend(std::wstring root) : m_root(std::move(root)) {}
+
+    bool Load(std::vector<openmfc_profile::Change>& values) override {
+        HKEY root = nullptr;
+        if (::RegOpenKeyExW(HKEY_CURRENT_USER, m_root.c_str(), 0, KEY_READ, &root) != ERROR_SUCCESS) return true;
+        wchar_t sectionName[256];
+        for (DWORD i = 0;; ++i) {
+            DWORD length = 256;
+            if (::RegEnumKeyExW(root, i, sectionName, &length, nullptr, nullptr, nullptr, nullptr) != ERROR_SUCCESS) break;
+            HKEY section = nullptr;
+            if (::RegOpenKeyExW(root, sectionName, 0, KEY_READ, &section) != ERROR_SUCCESS) continue;
+            LoadSection(section, sectionName, values);
+            ::RegCloseKey(section);
+        }
+        ::RegCloseKey(root);
+        return true;
+    }
+
+    bool Save(const std::vector<openmfc_profile::Change>& batch) override {
+        HKEY root = nullptr;
+        if (::RegCreateKeyExW(HKEY_CURRENT_USER, m_root.c_str(), 0, nullptr, 0, KEY_ALL_ACCESS,
+                              nullptr, &root, nullptr) != ERROR_SUCCESS) {
+            return false;
+        }
+        bool ok = true;
+        std::unordered_map<std::wstring, HKEY> sections;    // open for the rest of the batch
+        for (const openmfc_profile::Change& change : batch) {
+            const std::wstring folded = openmfc_profile::FoldName(change.section);
+            if (change.kind == openmfc_profile::ChangeKind::DeleteSection) {
+                auto open = sections.find(folded);
+                if (open != sections.end()) {
+                    ::RegCloseKey(open->second);
+                    sections.erase(open);
+                }
+                const LONG status = ::RegDeleteTreeW(root, change.section.c_str());
+                ok = ok && (status == ERROR_SUCCESS || status == ERROR_FILE_NOT_FOUND);
+                continue;
+            }
+
+            HKEY& section = sections[folded];
+            if (!section && ::RegCreateKeyExW(root, change.section.c_str(), 0, nullptr, 0, KEY_ALL_ACCESS,
+                                              nullptr, &section, nullptr) != ERROR_SUCCESS) {
+                sections.erase(folded);
+                ok = false;
+                continue;
+            }
+            if (change.kind == openmfc_profile::ChangeKind::DeleteEntry) {
+                const LONG status = ::RegDeleteValueW(section, change.entry.c_str());
+                ok = ok && (status == ERROR_SUCCESS || status == ERROR_FILE_NOT_FOUND);
+            } else {
+                ok = SetValue(section, change.entry, change.value) && ok;
+            }
+        }
+        for (auto& open : sections) ::RegCloseKey(open.second);
+        ::RegCloseKey(root);
+        return ok;
+    }
+
+private:
+    static void LoadSection(HKEY section, const wchar_t* sectionName, std::vector<openmfc_profile::Change>& values) {
+        DWORD maxName = 0;
+        DWORD maxData = 0;
+        if (::RegQueryInfoKeyW(section, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                               &maxName, &maxData, nullptr, nullptr) != ERROR_SUCCESS) {
+            return;
+        }
+        std::vector<wchar_t> name(maxName + 1);
+        std::vector<unsigned char> data(maxData + sizeof(wchar_t));
+        for (DWORD i = 0;; ++i) {
+            DWORD nameLength = maxName + 1;
+            DWORD dataLength = maxData;
+            DWORD type = 0;
+            if (::RegEnumValueW(section, i, name.data(), &nameLength, nullptr, &type, data.data(),
+                                &dataLength) != ERROR_SUCCESS) {
+                break;
+            }
+            openmfc_profile::Change change;
+            change.section = sectionName;
+            change.entry.assign(name.data(), nameLength);
+            if (type == REG_DWORD && dataLength == sizeof(DWORD)) {
+                change.value.kind = openmfc_profile::ValueKind::Int;
+                std::memcpy(&change.value.number, data.data(), sizeof(DWORD));
+            } else if (type == REG_SZ || type == REG_EXPAND_SZ) {
+                const wchar_t* text = reinterpret_cast<const wchar_t*>(data.data());
+                size_t length = dataLength / sizeof(wchar_t);
+                while (length > 0 && text[length - 1] == L'\0') --length;
+                change.value.text.assign(text, length);
+            } else if (type == REG_BINARY) {
+                change.value.kind = openmfc_profile::ValueKind::Binary;
+                change.value.bytes.assign(data.data(), data.data() + dataLength);
+            } else {
+                continue;
+            }
+            values.push_back(std::move(change));
+        }
+    }
+
+    static bool SetValue(HKEY section, const std::wstring& entry, const openmfc_profile::Value& value) {
+        switch (value.kind) {
+        case openmfc_profile::ValueKind::Int: {
+            const DWORD number = value.number;
+            return ::RegSetValueExW(section, entry.c_str(), 0, REG_DWORD,
+                                    reinterpret_cast<const BYTE*>(&number), sizeof(number)) == ERROR_SUCCESS;
+        }
+        case openmfc_profile::ValueKind::Binary:
+            return ::RegSetValueExW(section, entry.c_str(), 0, REG_BINARY, value.bytes.data(),
+                                    static_cast<DWORD>(value.bytes.size())) == ERROR_SUCCESS;
+        default:
+            return ::RegSetValueExW(section, entry.c_str(), 0, REG_SZ,
+                                    reinterpret_cast<const BYTE*>(value.text.c_str()),
+                                    static_cast<DWORD>((value.text.size() + 1) * sizeof(wchar_t))) == ERROR_SUCCESS;
+        }
+    }
+
+    std::wstring m_root;
+};
+
+// Goes through the private-profile API one key at a time, as MFC does, so
+// the file keeps its comments, layout and encoding (ANSI or UTF-16).
+class IniProfileBackend : public openmfc_profile::Backend {
+public:
+    explicit IniProfileBackend(std::wstring path) : m_path(std::move(path)) {}
+
+    bool Load(std::vector<openmfc_profile::Change>& values) override {
+        const std::vector<wchar_t> sections = ReadList(nullptr);
+        for (const wchar_t* section = sections.data(); *section; section += std::wcslen(section) + 1) {
+            const std::vector<wchar_t> entries = ReadList(section);
+            for (const wchar_t* entry = entries.data(); *entry; entry += std::wcslen(entry) + 1) {
+                openmfc_profile::Change change;
+                change.section = section;
+                change.entry = entry;
+                change.value.text = ReadValue(section, entry);
+                values.push_back(std::move(change));
+            }
+        }
+        return true;
+    }
+
+    bool Save(const std::vector<openmfc_profile::Change>& batch) override {
+        bool ok = true;
+        for (const openmfc_profile::Change& change : batch) {
+            const wchar_t* entry = nullptr;
+            std::wstring text;
+            if (change.kind != openmfc_profile::ChangeKind::DeleteSection) entry = change.entry.c_str();
+            if (change.kind == openmfc_profile::ChangeKind::Set) text = openmfc_profile::ValueToText(change.value);
+            const wchar_t* value = change.kind == openmfc_profile::ChangeKind::Set ? text.c_str() : nullptr;
+            ok = ::WritePrivateProfileStringW(change.section.c_str(), entry, value, m_path.c_str()) && ok;
+        }
+        // All-null arguments flush the system's cached copy of the file.
+        ::WritePrivateProfileStringW(nullptr, nullptr, nullptr, m_path.c_str());
+        return ok;
+    }
+
+private:
+    // Section names (section == nullptr) or a section's entry names, as a
+    // double-nul-terminated list. The API returns size - 2 when it truncates.
+    std::vector<wchar_t> ReadList(const wchar_t* section) const {
+        std::vector<wchar_t> buffer(1024);
+        for (;;) {
+            const DWORD size = static_cast<DWORD>(buffer.size());
+            const DWORD length = section
+                ? ::GetPrivateProfileStringW(section, nullptr, L"", buffer.data(), size, m_path.c_str())
+                : ::GetPrivateProfileSectionNamesW(buffer.data(), size, m_path.c_str());
+            if (length + 2 < size) {
+                buffer.resize(length + 2);
+                buffer[length] = L'\0';
+                buffer[length + 1] = L'\0';
+                return buffer;
+            }
+            buffer.resize(buffer.size() * 2);
+        }
+    }
+
+    std::wstring ReadValue(const wchar_t* section, const wchar_t* entry) const {
+        std::vector<wchar_t> buffer(256);
+        for (;;) {
+            const DWORD size = static_cast<DWORD>(buffer.size());
+            const DWORD length = ::GetPrivateProfileStringW(section, entry, L"", buffer.data(), size, m_path.c_str());
+            if (length + 1 < size) return std::wstring(buffer.data(), length);
+            buffer.resize(buffer.size() * 2);
+        }
+    }
+
+    std::wstring m_path;
+};
+
+// Bound on first use: registry mode once SetRegistryKey (or
+// m_pszRegistryKey) is set, INI mode otherwise.
+openmfc_profile::ProfileStore& GetAppProfile(CWinApp* app) {
+    AppRuntimeState& state = g_appRuntimeStates[app];
+    if (!state.profile) {
+        std::unique_ptr<openmfc_profile::Backend> backend;
+        if (UsesRegistryProfile(app)) backend.reset(new RegistryProfileBackend(GetAppRegistryRoot(app)));
+        else backend.reset(new IniProfileBackend(GetAppIniPath(app)));
+        state.profile.reset(new openmfc_profile::ProfileStore(std::move(backend)));
+    }
+    return *state.profile;
 }
 
 HWND GetAppMainHwnd(CWinApp* app) {
@@ -1284,6 +1407,18 @@ CDocument* OpenWithTemplates(const std::vector<CDocTemplate*>& templates, const
 }
 }  // namespace
 
+void OpenMfcCloseAppProfile(CWinApp* app) {
+    auto it = g_appRuntimeStates.find(app);
+    if (it != g_appRuntimeStates.end() && it->second.profile) it->second.profile->Close();
+}
+
+// The app object is usually a global, so this can run under the loader
+// lock; the store does not join its writer here (ExitInstance did).
+void OpenMfcReleaseAppProfile(CWinApp* app) {
+    auto it = g_appRuntimeStates.find(app);
+    if (it != g_appRuntimeStates.end()) it->second.profile.reset();
+}
+
 // Symbol: ??0CCommandLineInfo@@QEAA@XZ
 extern "C" void* MS_ABI impl___0CCommandLineInfo__QEAA_XZ(void* pThis) {
     if (pThis) g_commandLineInfoStates[reinterpret_cast<CCommandLineInfo*>(pThis)] = CommandLineInfoState{};
@@ -1411,23 +1546,21 @@ extern "C" void MS_ABI impl__AddToRecentFileList_CWinApp__UEAAXPEB_W_Z(CWinApp*
 // Symbol: ?GetProfileIntW@CWinApp@@UEAAIPEB_W0H@Z
 extern "C" unsigned int MS_ABI impl__GetProfileIntW_CWinApp__UEAAIPEB_W0H_Z(
     CWinApp* pThis, const wchar_t* section, const wchar_t* entry, int defaultValue) {
-    if (!pThis) return static_cast<unsigned int>(defaultValue);
-    const auto& map = g_appRuntimeStates[pThis].profileInts;
-    const auto it = map.find(MakeProfileKey(section, entry));
-    return it == map.end() ? static_cast<unsigned int>(defaultValue) : it->second;
+    unsigned int value = static_cast<unsigned int>(defaultValue);
+    if (!pThis || !section || !entry) return value;
+    return GetAppProfile(pThis).GetInt(section, entry, value) ? value : static_cast<unsigned int>(defaultValue);
 }
 
 // Symbol: ?GetProfileStringW@CWinApp@@UEAA?AV?$CStringT@_WV?$StrTraitMFC_DLL@_WV?$ChTraitsCRT@_W@ATL@@@@@ATL@@PEB_W00@Z
 extern "C" void MS_ABI impl__GetProfileStringW_CWinApp__UEAA_AV__CStringT__WV__StrTraitMFC_DLL__WV__ChTraitsCRT__W_ATL_____ATL__PEB_W00_Z(
     CString* ret, CWinApp* pThis, const wchar_t* section, const wchar_t* entry, const wchar_t* defaultValue) {
     if (!ret) return;
-    if (!pThis) {
+    std::wstring value;
+    if (!pThis || !section || !entry || !GetAppProfile(pThis).GetString(section, entry, value)) {
         new (ret) CString(defaultValue ? defaultValue : L"");
         return;
     }
-    const auto& map = g_appRuntimeStates[pThis].profileStrings;
-    const auto it = map.find(MakeProfileKey(section, entry));
-    new (ret) CString(it == map.end() ? (defaultValue ? defaultValue : L"") : it->second.c_str());
+    new (ret) CString(value.c_str());
 }
 
 // Symbol: ?GetProfileBinary@CWinApp@@UEAAHPEB_W0PEAPEAEPEAI@Z
@@ -1435,14 +1568,10 @@ extern "C" int MS_ABI impl__GetProfileBinary_CWinApp__UEAAHPEB_W0PEAPEAEPEAI_Z(
     CWinApp* pThis, const wchar_t* section, const wchar_t* entry, unsigned char** ppData, unsigned int* pBytes) {
     if (ppData) *ppData = nullptr;
     if (pBytes) *pBytes = 0;
-    if (!pThis || !ppData || !pBytes) return FALSE;
+    if (!pThis || !section || !entry || !ppData || !pBytes) return FALSE;
 
-    const auto& map = g_appRuntimeStates[pThis].profileBinary;
-    const auto it = map.find(MakeProfileKey(section, entry));
-    if (it == map.end()) return FALSE;
-
-    const std::vector<unsigned char>& data = it->second;
-    if (data.empty()) return FALSE;
+    std::vector<unsigned char> data;
+    if (!GetAppProfile(pThis).GetBinary(section, entry, data) || data.empty()) return FALSE;
 
     unsigned char* copy = new (std::nothrow) unsigned char[data.size()];
     if (!copy) return FALSE;
@@ -1456,15 +1585,19 @@ extern "C" int MS_ABI impl__GetProfileBinary_CWinApp__UEAAHPEB_W0PEAPEAEPEAI_Z(
 extern "C" int MS_ABI impl__WriteProfileInt_CWinApp__UEAAHPEB_W0H_Z(
     CWinApp* pThis, const wchar_t* section, const wchar_t* entry, int value) {
     if (!pThis || !section || !entry) return FALSE;
-    g_appRuntimeStates[pThis].profileInts[MakeProfileKey(section, entry)] = static_cast<unsigned int>(value);
+    GetAppProfile(pThis).WriteInt(section, entry, value);
     return TRUE;
 }
 
+// A null entry deletes the section and a null value deletes the entry, as in MFC.
 // Symbol: ?WriteProfileStringW@CWinApp@@UEAAHPEB_W00@Z
 extern "C" int MS_ABI impl__WriteProfileStringW_CWinApp__UEAAHPEB_W00_Z(
     CWinApp* pThis, const wchar_t* section, const wchar_t* entry, const wchar_t* value) {
-    if (!pThis || !section || !entry) return FALSE;
-    g_appRuntimeStates[pThis].profileStrings[MakeProfileKey(section, entry)] = value ? value : L"";
+    if (!pThis || !section) return FALSE;
+    openmfc_profile::ProfileStore& profile = GetAppProfile(pThis);
+    if (!entry) profile.DeleteSection(section);
+    else if (!value) profile.DeleteEntry(section, entry);
+    else profile.WriteString(section, entry, value);
     return TRUE;
 }
 
@@ -1472,9 +1605,7 @@ extern "C" int MS_ABI impl__WriteProfileStringW_CWinApp__UEAAHPEB_W00_Z(
 extern "C" int MS_ABI impl__WriteProfileBinary_CWinApp__UEAAHPEB_W0PEAEI_Z(
     CWinApp* pThis, const wchar_t* section, const wchar_t* entry, unsigned char* data, unsigned int bytes) {
     if (!pThis || !section || !entry) return FALSE;
-    std::vector<unsigned char> blob;
-    if (data && bytes != 0) blob.assign(data, data + bytes);
-    g_appRuntimeStates[pThis].profileBinary[MakeProfileKey(section, entry)] = std::move(blob);
+    GetAppProfile(pThis).WriteBinary(section, entry, data, bytes);
     return TRUE;
 }
 
@@ -2272,7 +2403,10 @@ extern "C" void MS_ABI impl__SetCurrentHandles_CWinApp__QEAAXXZ(CWinApp* pThis)
 
 // Symbol: ?SetRegistryKey@CWinApp@@IEAAXPEB_W@Z
 extern "C" void MS_ABI impl__SetRegistryKey_CWinApp__IEAAXPEB_W_Z(CWinApp* pThis, const wchar_t* key) {
-    if (pThis) g_appRuntimeStates[pThis].registryRoot = key && *key ? std::wstring(L"Software\\") + key : L"Software\\OpenMFC";
+    if (!pThis) return;
+    AppRuntimeState& state = g_appRuntimeStates[pThis];
+    state.profile.reset();    // saves to the old location; rebinds on next use
+    state.registryRoot = key && *key ? std::wstring(L"Software\\") + key : L"Software\\OpenMFC";
 }
 
 // Symbol: ?SetRegistryKey@CWinApp@@IEAAXI@Z
@@ -2280,7 +2414,9 @@ extern "C" void MS_ABI impl__SetRegistryKey_CWinApp__IEAAXI_Z(CWinApp* pThis, un
     if (!pThis) return;
     wchar_t buffer[64] = {};
     std::swprintf(buffer, 64, L"OpenMFC\\%u", id);
-    g_appRuntimeStates[pThis].registryRoot = std::wstring(L"Software\\") + buffer;
+    AppRuntimeState& state = g_appRuntimeStates[pThis];
+    state.profile.reset();
+    state.registryRoot = std::wstring(L"Software\\") + buffer;
 }
 
 // Symbol: ?Unregister@CWinApp@@UEAAHXZ
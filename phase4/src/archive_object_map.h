@@ -0,0 +1,143 @@
+#pragma once
+
+// Object and class numbering behind CArchive::WriteObject / ReadObject.
+//
+// As in MFC, every object and every class that goes through an archive gets
+// the next index the first time it is seen (index 0 is the null tag). A
+// later reference writes only that index, so a shared object is stored once
+// and a cycle comes back as the same pointer. Classes and objects share one
+// counter, exactly as MFC numbers them, which keeps the tags byte-compatible:
+//   wNullTag        0x0000         null pointer
+//   wNewClassTag    0xFFFF         class record follows, then the object
+//   wClassTag|n     0x8000 | n     known class n, then the object
+//   n               0x0001..0x7FFE back-reference to object n
+//   wBigObjectTag   0x7FFF         a DWORD follows: n, or dwBigClassTag | n
+//
+// The store side is a pointer -> index map with open addressing (linear
+// probing on a multiplicatively hashed pointer, load factor <= 1/2) that
+// archives never remove from. The load side is an index -> pointer array
+// that also remembers each class's stored schema.
+//
+// CArchive::WriteObject / ReadObject (filecore.cpp) are the only users;
+// tests/test_archive_graph_logic.cpp drives them end to end.
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace openmfc_archmap {
+
+const uint16_t kNullTag = 0;
+const uint16_t kNewClassTag = 0xFFFF;
+const uint16_t kClassTag = 0x8000;
+const uint32_t kBigClassTag = 0x80000000u;
+const uint16_t kBigObjectTag = 0x7FFF;
+
+class StoreMap {
+public:
+    StoreMap() = default;
+    StoreMap(const StoreMap&) = delete;
+    StoreMap& operator=(const StoreMap&) = delete;
+    ~StoreMap() { delete[] m_pSlots; }
+
+    size_t GetCount() const { return m_nCount; }
+
+    // The index p was mapped to, or 0.
+    uint32_t Lookup(const void* p) const {
+        if (!m_pSlots || !p) {
+            return 0;
+        }
+        const size_t mask = m_nCapacity - 1;
+        for (size_t i = Home(p);; i = (i + 1) & mask) {
+            if (m_pSlots[i].pKey == p) {
+                return m_pSlots[i].nIndex;
+            }
+            if (!m_pSlots[i].pKey) {
+                return 0;
+            }
+        }
+    }
+
+    // Maps non-null p to nIndex, replacing any earlier index (MFC's
+    // MapObject renumbers an object mapped twice). Fails only when out of
+    // memory.
+    bool Set(const void* p, uint32_t nIndex) {
+        if ((m_nCount + 1) * 2 > m_nCapacity && !Grow()) {
+            return false;
+        }
+        const size_t mask = m_nCapacity - 1;
+        size_t i = Home(p);
+        while (m_pSlots[i].pKey && m_pSlots[i].pKey != p) {
+            i = (i + 1) & mask;
+        }
+        if (!m_pSlots[i].pKey) {
+            m_pSlots[i].pKey = p;
+            ++m_nCount;
+        }
+        m_pSlots[i].nIndex = nIndex;
+        return true;
+    }
+
+private:
+    struct Slot {
+        const void* pKey;
+        uint32_t nIndex;
+    };
+
+    static const size_t kMinCapacity = 256;
+
+    size_t Home(const void* p) const {
+        uint64_t h = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(p)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h >> (64 - m_nBits));
+    }
+
+    bool Grow() {
+        size_t nNewCapacity = m_nCapacity ? m_nCapacity * 2 : kMinCapacity;
+        Slot* pNew = new (std::nothrow) Slot[nNewCapacity]();
+        if (!pNew) {
+            return false;
+        }
+        Slot* pOld = m_pSlots;
+        size_t nOldCapacity = m_nCapacity;
+        m_pSlots = pNew;
+        m_nCapacity = nNewCapacity;
+        m_nBits = 0;
+        while ((size_t(1) << m_nBits) < m_nCapacity) {
+            ++m_nBits;
+        }
+        const size_t mask = m_nCapacity - 1;
+        for (size_t j = 0; j < nOldCapacity; ++j) {
+            if (!pOld[j].pKey) {
+                continue;
+            }
+            size_t i = Home(pOld[j].pKey);
+            while (m_pSlots[i].pKey) {
+                i = (i + 1) & mask;
+            }
+            m_pSlots[i] = pOld[j];
+        }
+        delete[] pOld;
+        return true;
+    }
+
+    Slot* m_pSlots = nullptr;
+    size_t m_nCapacity = 0;
+    unsigned m_nBits = 0;
+    size_t m_nCount = 0;
+};
+
+struct LoadEntry {
+    void* p;            // CObject* or CRuntimeClass*
+    uint32_t nSchema;   // schema the class was stored with (classes only)
+    bool bClass;
+};
+
+// Per-archive state; only the side matching the archive's direction is used.
+struct ObjectMap {
+    uint32_t nMapCount = 1;
+    StoreMap store;
+    std::vector<LoadEntry> load{ LoadEntry{ nullptr, 0, false } };   // [kNullTag]
+};
+
+} // namespace openmfc_archmap
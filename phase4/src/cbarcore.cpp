@@ -80,14 +80,6 @@ struct RibbonStatusPaneState {
 };
 std::unordered_map<UINT, RibbonStatusPaneState> g_statusPaneStates;
 
-struct ThreadSlotDataState {
-    int nextSlot = 0;
-    std::unordered_set<int> freeSlots;
-    std::unordered_map<DWORD, std::unordered_map<int, void*>> threadValues;
-};
-std::mutex g_threadSlotMutex;
-std::unordered_map<void*, ThreadSlotDataState> g_threadSlotStates;
-
 struct TypeLibCacheState {
     bool locked = false;
     std::unordered_map<unsigned long, ITypeLib*> typeLibs;
@@ -987,68 +979,9 @@ BOOL CToolBar::IsFloating() const {
 }
 
 //=============================================================================
-// CThreadSlotData and toolbar ABI residuals
+// Toolbar ABI residuals
 //=============================================================================
 
-// Symbol: ?AllocSlot@CThreadSlotData@@QEAAHXZ
-extern "C" int MS_ABI impl__AllocSlot_CThreadSlotData__QEAAHXZ(void* pThis) {
-    std::lock_guard<std::mutex> lock(g_threadSlotMutex);
-    auto& state = g_threadSlotStates[pThis];
-    if (!state.freeSlots.empty()) {
-        int slot = *state.freeSlots.begin();
-        state.freeSlots.erase(slot);
-        return slot;
-    }
-    return state.nextSlot++;
-}
-
-// Symbol: ?AssignInstance@CThreadSlotData@@QEAAXPEAUHINSTANCE__@@@Z
-extern "C" void MS_ABI impl__AssignInstance_CThreadSlotData__QEAAXPEAUHINSTANCE_____Z(void* pThis, HINSTANCE hInst) {
-    (void)pThis;
-    (void)hInst;
-}
-
-// Symbol: ?DeleteValues@CThreadSlotData@@QEAAXPEAUCThreadData@@PEAUHINSTANCE__@@@Z
-extern "C" void MS_ABI impl__DeleteValues_CThreadSlotData__QEAAXPEAUCThreadData__PEAUHINSTANCE_____Z(
-    void* pThis, void* pThreadData, HINSTANCE hInst) {
-    (void)pThreadData;
-    (void)hInst;
-    std::lock_guard<std::mutex> lock(g_threadSlotMutex);
-    auto it = g_threadSlotStates.find(pThis);
-    if (it != g_threadSlotStates.end()) {
-        it->second.threadValues.erase(::GetCurrentThreadId());
-    }
-}
-
-// Symbol: ?DeleteValues@CThreadSlotData@@QEAAXPEAUHINSTANCE__@@H@Z
-extern "C" void MS_ABI impl__DeleteValues_CThreadSlotData__QEAAXPEAUHINSTANCE____H_Z(void* pThis, HINSTANCE hInst, int bAll) {
-    (void)hInst;
-    std::lock_guard<std::mutex> lock(g_threadSlotMutex);
-    auto it = g_threadSlotStates.find(pThis);
-    if (it == g_threadSlotStates.end()) return;
-    if (bAll) {
-        it->second.threadValues.clear();
-    } else {
-        it->second.threadValues.erase(::GetCurrentThreadId());
-    }
-}
-
-// Symbol: ?FreeSlot@CThreadSlotData@@QEAAXH@Z
-extern "C" void MS_ABI impl__FreeSlot_CThreadSlotData__QEAAXH_Z(void* pThis, int nSlot) {
-    std::lock_guard<std::mutex> lock(g_threadSlotMutex);
-    auto& state = g_threadSlotStates[pThis];
-    state.freeSlots.insert(nSlot);
-    for (auto& entry : state.threadValues) {
-        entry.second.erase(nSlot);
-    }
-}
-
-// Symbol: ?SetValue@CThreadSlotData@@QEAAXHPEAX@Z
-extern "C" void MS_ABI impl__SetValue_CThreadSlotData__QEAAXHPEAX_Z(void* pThis, int nSlot, void* pValue) {
-    std::lock_guard<std::mutex> lock(g_threadSlotMutex);
-    g_threadSlotStates[pThis].threadValues[::GetCurrentThreadId()][nSlot] = pValue;
-}
-
 // Symbol: ?CalcDynamicLayout@CToolBar@@UEAA?AVCSize@@HK@Z
 extern "C" void MS_ABI impl__CalcDynamicLayout_CToolBar__UEAA_AVCSize__HK_Z(
     CSize* pRet, CToolBar* pThis, int nLength, unsigned long dwMode) {
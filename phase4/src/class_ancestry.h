@@ -0,0 +1,332 @@
+#pragma once
+
+// Cached class ancestry behind CRuntimeClass::IsDerivedFrom / CObject::IsKindOf.
+//
+// For each class asked about, a record holds its depth and its ancestors
+// from the root (ancestors[0]) down to the class itself (ancestors[depth]).
+// "D derives from B" is then rec(D).depth >= rec(B).depth and
+// rec(D).ancestors[rec(B).depth] == B: two table probes and a compare, with
+// no calls through m_pfnGetBaseClass.
+//
+// A check that the first kWalkDepth bases settle (one of them is the class
+// asked about, or the hierarchy ends within them) is answered by walking,
+// without touching the table: that costs a few loads, where the table path
+// costs a read-modify-write on a shared reader count.
+//
+// Records live outside the ABI struct, in an open-addressed table keyed by
+// class pointer (multiplicative hash, linear probing, load factor <= 1/2).
+// Lookups take no lock; records are immutable once published and are
+// filled in under a mutex the first time a class is seen.
+//
+// Invalidate() unpublishes the whole table, so a class registered at the
+// address of one whose module was unloaded cannot inherit the old record;
+// records are rebuilt on their next use. The unpublished table and its
+// records, like a table replaced by growth, are retired rather than freed,
+// since a Check() in flight may still be reading them. Each Check() holds
+// a reader count (striped by thread, so readers rarely share a cache line)
+// while it probes without the lock; retired memory is freed by the next
+// writer that sees every count at zero.
+//
+// Chains deeper than kMaxDepth (or cyclic ones) are not cached; Check()
+// reports them as uncacheable and the caller falls back to walking.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace openmfc_ancestry {
+
+enum CheckResult { kNotDerived = 0, kDerived = 1, kUncacheable = 2 };
+
+template <class TClass>
+class AncestryCache {
+public:
+    typedef const TClass* (*PFNGETBASE)(const TClass*);
+
+    static const uint32_t kMaxDepth = 256;
+    static const uint32_t kWalkDepth = 4;
+
+    explicit AncestryCache(PFNGETBASE pfnGetBase) : m_pfnGetBase(pfnGetBase) {}
+    AncestryCache(const AncestryCache&) = delete;
+    AncestryCache& operator=(const AncestryCache&) = delete;
+    ~AncestryCache() {
+        Table* pTable = m_pTable.load(std::memory_order_relaxed);
+        if (pTable) {
+            DestroyRecords(pTable);
+            DestroyTable(pTable);
+        }
+        FreeRetired();
+    }
+
+    // Whether pClass is pBase or derives from it. Both must be non-null.
+    CheckResult Check(const TClass* pClass, const TClass* pBase) {
+        if (pClass == pBase) {
+            return kDerived;
+        }
+        const TClass* pWalk = pClass;
+        for (uint32_t i = 0; i <= kWalkDepth; ++i) {
+            pWalk = m_pfnGetBase(pWalk);
+            if (pWalk == pBase) {
+                return kDerived;
+            }
+            if (!pWalk) {
+                return kNotDerived;
+            }
+        }
+        {
+            ReadGuard guard(m_readers[ReaderStripe()].nActive);
+            const Table* pTable = m_pTable.load(std::memory_order_seq_cst);
+            const Record* pDerived = pTable ? Find(pTable, pClass) : nullptr;
+            const Record* pAncestor = pDerived ? Find(pTable, pBase) : nullptr;
+            if (pAncestor) {
+                return Compare(pDerived, pAncestor, pBase);
+            }
+        }
+        // First sight of either class: build under the mutex, where nothing
+        // can be retired, and free what earlier writers retired.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ReclaimLocked();
+        const Record* pDerived = BuildLocked(pClass);
+        const Record* pAncestor = pDerived ? BuildLocked(pBase) : nullptr;
+        if (!pAncestor) {
+            return kUncacheable;
+        }
+        return Compare(pDerived, pAncestor, pBase);
+    }
+
+    // Called when classes are registered or a module's classes are
+    // unregistered; every record is rebuilt on next use.
+    void Invalidate() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Table* pTable = m_pTable.load(std::memory_order_relaxed);
+        if (pTable) {
+            m_pTable.store(nullptr, std::memory_order_seq_cst);
+            m_nCount = 0;
+            Retire(pTable, true);
+        }
+        ReclaimLocked();
+    }
+
+    // Tables and records unpublished but not yet freed (for tests).
+    size_t GetRetiredCount() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_retiredRecords.size() + m_retiredTables.size();
+    }
+
+private:
+    struct Record {
+        const TClass* pClass;
+        uint32_t nDepth;
+        const TClass* ancestors[1];   // nDepth + 1 entries
+    };
+
+    struct Table {
+        size_t mask;
+        unsigned nBits;
+        std::atomic<Record*>* slots;
+    };
+
+    static const size_t kMinCapacity = 256;
+    static const size_t kReaderStripes = 16;
+
+    struct alignas(64) ReaderCount {
+        std::atomic<uint32_t> nActive{ 0 };
+    };
+
+    // Counts one Check() in flight. The increment is ordered before the
+    // table load (both seq_cst), so a writer that unpublishes a table and
+    // then reads every count as zero knows no reader can still reach it.
+    class ReadGuard {
+    public:
+        explicit ReadGuard(std::atomic<uint32_t>& nActive) : m_nActive(nActive) {
+            m_nActive.fetch_add(1, std::memory_order_seq_cst);
+        }
+        ~ReadGuard() { m_nActive.fetch_sub(1, std::memory_order_release); }
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+    private:
+        std::atomic<uint32_t>& m_nActive;
+    };
+
+    static size_t ReaderStripe() {
+        static thread_local const char s_anchor = 0;
+        const uint64_t h = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&s_anchor)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h >> 60) & (kReaderStripes - 1);
+    }
+
+    static size_t Home(const Table* pTable, const TClass* p) {
+        uint64_t h = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(p)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h >> (64 - pTable->nBits));
+    }
+
+    // The slot holding p's record, or the empty slot where it would go.
+    static std::atomic<Record*>* Probe(const Table* pTable, const TClass* p, Record** ppRecord) {
+        for (size_t i = Home(pTable, p);; i = (i + 1) & pTable->mask) {
+            Record* pRecord = pTable->slots[i].load(std::memory_order_acquire);
+            if (!pRecord || pRecord->pClass == p) {
+                *ppRecord = pRecord;
+                return &pTable->slots[i];
+            }
+        }
+    }
+
+    static const Record* Find(const Table* pTable, const TClass* p) {
+        Record* pRecord;
+        Probe(pTable, p, &pRecord);
+        return pRecord;
+    }
+
+    static CheckResult Compare(const Record* pDerived, const Record* pAncestor, const TClass* pBase) {
+        return (pAncestor->nDepth <= pDerived->nDepth &&
+                pDerived->ancestors[pAncestor->nDepth] == pBase) ? kDerived : kNotDerived;
+    }
+
+    // p's record, built and published if it is new. Records are only
+    // retired under m_mutex, so the result stays valid while it is held.
+    const Record* BuildLocked(const TClass* p) {
+        Table* pTable = m_pTable.load(std::memory_order_relaxed);
+        Record* pExisting = nullptr;
+        if (pTable) {
+            Probe(pTable, p, &pExisting);
+            if (pExisting) {
+                return pExisting;
+            }
+        }
+
+        uint32_t nDepth = 0;
+        for (const TClass* pBase = m_pfnGetBase(p); pBase; pBase = m_pfnGetBase(pBase)) {
+            if (++nDepth > kMaxDepth) {
+                return nullptr;
+            }
+        }
+        void* pMem = ::operator new(sizeof(Record) + nDepth * sizeof(const TClass*), std::nothrow);
+        if (!pMem) {
+            return nullptr;
+        }
+        Record* pRecord = static_cast<Record*>(pMem);
+        pRecord->pClass = p;
+        pRecord->nDepth = nDepth;
+        const TClass* pWalk = p;
+        for (uint32_t i = nDepth + 1; i-- > 0; pWalk = m_pfnGetBase(pWalk)) {
+            pRecord->ancestors[i] = pWalk;
+        }
+
+        if (!pTable || (m_nCount + 1) * 2 > pTable->mask + 1) {
+            pTable = Grow(pTable);
+            if (!pTable) {
+                DestroyRecord(pRecord);
+                return nullptr;
+            }
+        }
+        Record* pEmpty;
+        Probe(pTable, p, &pEmpty)->store(pRecord, std::memory_order_release);
+        ++m_nCount;
+        return pRecord;
+    }
+
+    // Builds a table of twice the capacity holding every record in pOld and
+    // publishes it. Called with m_mutex held.
+    Table* Grow(Table* pOld) {
+        const size_t nCapacity = pOld ? (pOld->mask + 1) * 2 : kMinCapacity;
+        Table* pNew = new (std::nothrow) Table;
+        if (!pNew) {
+            return nullptr;
+        }
+        pNew->mask = nCapacity - 1;
+        pNew->nBits = 0;
+        while ((size_t(1) << pNew->nBits) < nCapacity) {
+            ++pNew->nBits;
+        }
+        pNew->slots = new (std::nothrow) std::atomic<Record*>[nCapacity];
+        if (!pNew->slots) {
+            delete pNew;
+            return nullptr;
+        }
+        for (size_t i = 0; i < nCapacity; ++i) {
+            pNew->slots[i].store(nullptr, std::memory_order_relaxed);
+        }
+        if (pOld) {
+            for (size_t i = 0; i <= pOld->mask; ++i) {
+                Record* pRecord = pOld->slots[i].load(std::memory_order_relaxed);
+                if (pRecord) {
+                    Record* pEmpty;
+                    Probe(pNew, pRecord->pClass, &pEmpty)->store(pRecord, std::memory_order_relaxed);
+                }
+            }
+        }
+        m_pTable.store(pNew, std::memory_order_seq_cst);
+        if (pOld) {
+            Retire(pOld, false);
+        }
+        return pNew;
+    }
+
+    // Queues an unpublished table (and, if bRecords, the records in it) for
+    // ReclaimLocked. Called with m_mutex held. If the queue cannot grow the
+    // memory is leaked rather than freed under a possible reader.
+    void Retire(Table* pTable, bool bRecords) {
+        try {
+            if (bRecords) {
+                for (size_t i = 0; i <= pTable->mask; ++i) {
+                    if (Record* pRecord = pTable->slots[i].load(std::memory_order_relaxed)) {
+                        m_retiredRecords.push_back(pRecord);
+                    }
+                }
+            }
+            m_retiredTables.push_back(pTable);
+        } catch (...) {
+        }
+    }
+
+    // Frees everything retired if no Check() is on its lock-free path.
+    // Called with m_mutex held, after the retired memory was unpublished.
+    void ReclaimLocked() {
+        if (m_retiredRecords.empty() && m_retiredTables.empty()) {
+            return;
+        }
+        for (const ReaderCount& readers : m_readers) {
+            if (readers.nActive.load(std::memory_order_seq_cst) != 0) {
+                return;
+            }
+        }
+        FreeRetired();
+    }
+
+    void FreeRetired() {
+        for (Record* pRecord : m_retiredRecords) {
+            DestroyRecord(pRecord);
+        }
+        for (Table* pOld : m_retiredTables) {
+            DestroyTable(pOld);
+        }
+        m_retiredRecords.clear();
+        m_retiredTables.clear();
+    }
+
+    static void DestroyRecord(Record* pRecord) { ::operator delete(pRecord); }
+
+    static void DestroyRecords(Table* pTable) {
+        for (size_t i = 0; i <= pTable->mask; ++i) {
+            DestroyRecord(pTable->slots[i].load(std::memory_order_relaxed));
+        }
+    }
+
+    static void DestroyTable(Table* pTable) {
+        delete[] pTable->slots;
+        delete pTable;
+    }
+
+    PFNGETBASE m_pfnGetBase;
+    std::atomic<Table*> m_pTable{ nullptr };
+    ReaderCount m_readers[kReaderStripes];
+    size_t m_nCount = 0;
+    std::vector<Record*> m_retiredRecords;
+    std::vector<Table*> m_retiredTables;
+    std::mutex m_mutex;
+};
+
+} // namespace openmfc_ancestry
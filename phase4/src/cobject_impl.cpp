@@ -60,13 +60,19 @@ typedef CObject* (__cdecl *PFNCREATEOBJECT)();
 // =============================================================================
 // Global CRuntimeClass Registry (for FromName lookups)
 // =============================================================================
-// Note: Real MFC doesn't have m_pNextClass in CRuntimeClass struct.
-// We use a separate array to track registered classes.
+// Registered classes are indexed by name (runtime_class_registry.h), so
+// registration, FromName, CreateObject(name) and Load are O(1) and lookups
+// take no lock. Every registered class is also pushed onto the m_pNextClass
+// list, as MFC's AfxClassInit does, including unnamed classes and classes
+// whose name another class already holds in the index.
 
-#include <vector>
-static std::vector<CRuntimeClass*>& GetClassRegistry() {
-    static std::vector<CRuntimeClass*> registry;
-    return registry;
+#include "runtime_class_registry.h"
+
+typedef openmfc_rtreg::ClassNameTable<CRuntimeClass> CRuntimeClassTable;
+
+static CRuntimeClassTable& RegistryTable() {
+    static CRuntimeClassTable table;
+    return table;
 }
 
 static CRuntimeClass*& GetClassRegistryHead() {
@@ -74,50 +80,136 @@ static CRuntimeClass*& GetClassRegistryHead() {
     return head;
 }
 
-// Register a class in the global list
+// Guards the m_pNextClass list.
+static std::mutex& ClassListLock() {
+    static std::mutex s_listLock;
+    return s_listLock;
+}
+
+// Register a class in the global list. Only the name index is
+// de-duplicated; a class object already indexed under its own name has
+// been linked before and is left alone.
 static void RegisterRuntimeClass(CRuntimeClass* pClass) {
-    if (pClass) {
-        auto& registry = GetClassRegistry();
-        // Avoid duplicates
-        for (auto* c : registry) {
-            if (c == pClass) return;
+    if (!pClass) return;
+    std::lock_guard<std::mutex> lock(ClassListLock());
+    if (pClass->m_lpszClassName && RegistryTable().Find(pClass->m_lpszClassName) == pClass) {
+        return;
+    }
+    RegistryTable().Add(pClass);
+    pClass->m_pNextClass = GetClassRegistryHead();
+    GetClassRegistryHead() = pClass;
+}
+
+// Drops every class whose CRuntimeClass lives in [pBegin, pEnd) from the
+// name index and the m_pNextClass list. Used when an extension DLL unloads.
+static size_t UnregisterClassesIn(const BYTE* pBegin, const BYTE* pEnd) {
+    auto inModule = [pBegin, pEnd](const CRuntimeClass* pClass) {
+        const BYTE* p = reinterpret_cast<const BYTE*>(pClass);
+        return p >= pBegin && p < pEnd;
+    };
+    const size_t nRemoved = RegistryTable().RemoveIf(inModule);
+    std::lock_guard<std::mutex> lock(ClassListLock());
+    for (CRuntimeClass** ppClass = &GetClassRegistryHead(); *ppClass;) {
+        if (inModule(*ppClass)) {
+            *ppClass = (*ppClass)->m_pNextClass;
+        } else {
+            ppClass = &(*ppClass)->m_pNextClass;
         }
-        pClass->m_pNextClass = GetClassRegistryHead();
-        GetClassRegistryHead() = pClass;
-        registry.push_back(pClass);
     }
+    return nRemoved;
 }
 
+// The core classes are registered the first time the registry is used;
+// later callers only pay for the initialised-static check.
+static CRuntimeClassTable& GetClassRegistry() {
+    static const bool s_bCoreRegistered = [] {
+        RegisterRuntimeClass(&CObject::classCObject);
+        RegisterRuntimeClass(&CException::classCException);
+        RegisterRuntimeClass(&CMemoryException::classCMemoryException);
+        RegisterRuntimeClass(&CFileException::classCFileException);
+        RegisterRuntimeClass(&CArchiveException::classCArchiveException);
+        RegisterRuntimeClass(&CCmdTarget::classCCmdTarget);
+        RegisterRuntimeClass(&CWinThread::classCWinThread);
+        RegisterRuntimeClass(&CWinApp::classCWinApp);
+        RegisterRuntimeClass(&CWnd::classCWnd);
+        RegisterRuntimeClass(&CFrameWnd::classCFrameWnd);
+        return true;
+    }();
+    (void)s_bCoreRegistered;
+    return RegistryTable();
+}
+
+static void InitializeClasses() {
+    GetClassRegistry();
+}
+
+// Build the index while the module loads rather than on the first lookup.
+static const bool g_classRegistryReady = (InitializeClasses(), true);
+
 // Find a runtime class by name
 static CRuntimeClass* FindRuntimeClass(const char* lpszClassName) {
-    if (!lpszClassName) return nullptr;
-
-    auto& registry = GetClassRegistry();
-    for (auto* pClass : registry) {
-        if (pClass && pClass->m_lpszClassName) {
-            if (strcmp(pClass->m_lpszClassName, lpszClassName) == 0) {
-                return pClass;
-            }
+    return GetClassRegistry().Find(lpszClassName);
+}
+
+// Narrows a wide class name the way the A exports expect it (class names
+// are ASCII). Returns false if the name does not fit.
+static bool NarrowClassName(const wchar_t* lpszClassName, char* pszOut, size_t nOut) {
+    size_t i = 0;
+    for (; lpszClassName[i]; ++i) {
+        if (i + 1 >= nOut) {
+            return false;
         }
+        wchar_t ch = lpszClassName[i];
+        pszOut[i] = (ch >= 0 && ch <= 0x7f) ? static_cast<char>(ch) : '?';
     }
-    return nullptr;
+    pszOut[i] = '\0';
+    return true;
 }
 
-// Initialize on first use
-static bool g_classesInitialized = false;
-static void InitializeClasses() {
-    if (g_classesInitialized) return;
-    RegisterRuntimeClass(&CObject::classCObject);
-    RegisterRuntimeClass(&CException::classCException);
-    RegisterRuntimeClass(&CMemoryException::classCMemoryException);
-    RegisterRuntimeClass(&CFileException::classCFileException);
-    RegisterRuntimeClass(&CArchiveException::classCArchiveException);
-    RegisterRuntimeClass(&CCmdTarget::classCCmdTarget);
-    RegisterRuntimeClass(&CWinThread::classCWinThread);
-    RegisterRuntimeClass(&CWinApp::classCWinApp);
-    RegisterRuntimeClass(&CWnd::classCWnd);
-    RegisterRuntimeClass(&CFrameWnd::classCFrameWnd);
-    g_classesInitialized = true;
+// =============================================================================
+// Class ancestry cache (IsDerivedFrom / IsKindOf)
+// =============================================================================
+// Checks settled within a few levels are walked; for the rest, each class's
+// depth and ancestor list are computed once and kept in a side table
+// (class_ancestry.h), so they make no calls through m_pfnGetBaseClass. AfxClassInit and AfxTermExtensionModule invalidate the
+// table; the records are freed once no lookup can still be reading them.
+
+#include "class_ancestry.h"
+
+static const CRuntimeClass* GetRuntimeBaseClass(const CRuntimeClass* pClass) {
+    return pClass->m_pfnGetBaseClass ? pClass->m_pfnGetBaseClass() : pClass->m_pBaseClass;
+}
+
+static openmfc_ancestry::AncestryCache<CRuntimeClass>& GetAncestryCache() {
+    static openmfc_ancestry::AncestryCache<CRuntimeClass> cache(GetRuntimeBaseClass);
+    return cache;
+}
+
+// Also used by CRuntimeClass::IsDerivedFrom in DLL builds (see afx.h).
+bool OpenMFCIsDerivedFrom(const CRuntimeClass* pClass, const CRuntimeClass* pBaseClass) {
+    if (!pClass || !pBaseClass) {
+        return false;
+    }
+    openmfc_ancestry::CheckResult result = GetAncestryCache().Check(pClass, pBaseClass);
+    if (result != openmfc_ancestry::kUncacheable) {
+        return result == openmfc_ancestry::kDerived;
+    }
+    for (; pClass; pClass = GetRuntimeBaseClass(pClass)) {
+        if (pClass == pBaseClass) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// An object's CRuntimeClass through vtable[0]; see the note on IsKindOf below.
+static const CRuntimeClass* GetObjectRuntimeClass(const CObject* pObject) {
+    typedef CRuntimeClass* (MS_ABI *GetRuntimeClassFn)(const CObject*);
+    void** vptr = *(void***)pObject;
+    if (!vptr) {
+        return nullptr;
+    }
+    return ((GetRuntimeClassFn)vptr[0])(pObject);
 }
 
 // =============================================================================
@@ -175,34 +267,8 @@ extern "C" int MS_ABI impl__IsKindOf_CObject__QEBAHPEBUCRuntimeClass___Z(
         return FALSE;
     }
 
-    // Get this object's runtime class by calling GetRuntimeClass() through the vtable
-    // MSVC vtable layout: GetRuntimeClass is at vtable[0]
-    // Our headers declare GetRuntimeClass() before destructor to match this layout
-    typedef CRuntimeClass* (MS_ABI *GetRuntimeClassFn)(const CObject*);
-
-    // Get vptr (first pointer in the object)
-    void** vptr = *(void***)pThis;
-    if (!vptr) {
-        return FALSE;
-    }
-
     // vtable[0] is GetRuntimeClass (verified by header declaration order)
-    GetRuntimeClassFn getRuntimeClass = (GetRuntimeClassFn)vptr[0];
-    const CRuntimeClass* pThisClass = getRuntimeClass(pThis);
-
-    if (!pThisClass) {
-        return FALSE;
-    }
-
-    // Walk the inheritance chain
-    while (pThisClass != nullptr) {
-        if (pThisClass == pClass) {
-            return TRUE;
-        }
-        pThisClass = pThisClass->m_pBaseClass;
-    }
-
-    return FALSE;
+    return OpenMFCIsDerivedFrom(GetObjectRuntimeClass(pThis), pClass) ? TRUE : FALSE;
 }
 
 // CObject::IsSerializable() - const member function
@@ -254,27 +320,15 @@ extern "C" CObject* MS_ABI impl__CreateObject_CRuntimeClass__SAPEAVCObject__PEB_
         return nullptr;
     }
 
-    InitializeClasses();
-
     char narrowName[256];
-    size_t i = 0;
-    while (lpszClassName[i] && i < sizeof(narrowName) - 1) {
-        wchar_t ch = lpszClassName[i];
-        narrowName[i] = (ch >= 0 && ch <= 0x7f) ? static_cast<char>(ch) : '?';
-        ++i;
-    }
-    narrowName[i] = '\0';
-
-    // Search the registered classes
-    for (CRuntimeClass* pClass : GetClassRegistry()) {
-        if (pClass->m_lpszClassName && strcmp(pClass->m_lpszClassName, narrowName) == 0) {
-            if (pClass->m_pfnCreateObject) {
-                return pClass->m_pfnCreateObject();
-            }
-            return nullptr;
-        }
+    if (!NarrowClassName(lpszClassName, narrowName, sizeof(narrowName))) {
+        return nullptr;
     }
 
+    CRuntimeClass* pClass = FindRuntimeClass(narrowName);
+    if (pClass && pClass->m_pfnCreateObject) {
+        return pClass->m_pfnCreateObject();
+    }
     return nullptr;
 }
 
@@ -286,18 +340,10 @@ extern "C" CObject* MS_ABI impl__CreateObject_CRuntimeClass__SAPEAVCObject__PEBD
         return nullptr;
     }
 
-    InitializeClasses();
-
-    // Search the registered classes
-    for (CRuntimeClass* pClass : GetClassRegistry()) {
-        if (pClass->m_lpszClassName && strcmp(pClass->m_lpszClassName, lpszClassName) == 0) {
-            if (pClass->m_pfnCreateObject) {
-                return pClass->m_pfnCreateObject();
-            }
-            return nullptr;
-        }
+    CRuntimeClass* pClass = FindRuntimeClass(lpszClassName);
+    if (pClass && pClass->m_pfnCreateObject) {
+        return pClass->m_pfnCreateObject();
     }
-
     return nullptr;
 }
 
@@ -309,25 +355,11 @@ extern "C" CRuntimeClass* MS_ABI impl__FromName_CRuntimeClass__SAPEAU1_PEB_W_Z(
         return nullptr;
     }
 
-    InitializeClasses();
-
     char narrowName[256];
-    size_t i = 0;
-    while (lpszClassName[i] && i < sizeof(narrowName) - 1) {
-        wchar_t ch = lpszClassName[i];
-        narrowName[i] = (ch >= 0 && ch <= 0x7f) ? static_cast<char>(ch) : '?';
-        ++i;
-    }
-    narrowName[i] = '\0';
-
-    // Search the registered classes
-    for (CRuntimeClass* pClass : GetClassRegistry()) {
-        if (pClass->m_lpszClassName && strcmp(pClass->m_lpszClassName, narrowName) == 0) {
-            return pClass;
-        }
+    if (!NarrowClassName(lpszClassName, narrowName, sizeof(narrowName))) {
+        return nullptr;
     }
-
-    return nullptr;
+    return FindRuntimeClass(narrowName);
 }
 
 // Symbol: ?FromName@CRuntimeClass@@SAPEAU1@PEBD@Z
@@ -338,16 +370,7 @@ extern "C" CRuntimeClass* MS_ABI impl__FromName_CRuntimeClass__SAPEAU1_PEBD_Z(
         return nullptr;
     }
 
-    InitializeClasses();
-
-    // Search the registered classes
-    for (CRuntimeClass* pClass : GetClassRegistry()) {
-        if (pClass->m_lpszClassName && strcmp(pClass->m_lpszClassName, lpszClassName) == 0) {
-            return pClass;
-        }
-    }
-
-    return nullptr;
+    return FindRuntimeClass(lpszClassName);
 }
 
 // Symbol: ?IsDerivedFrom@CRuntimeClass@@QEBAHPEBU1@@Z
@@ -355,20 +378,7 @@ extern "C" int MS_ABI impl__IsDerivedFrom_CRuntimeClass__QEBAHPEBU1__Z(
     const CRuntimeClass* pThis,     // RCX = this (CRuntimeClass*)
     const CRuntimeClass* pBaseClass // RDX = base class to check
 ) {
-    if (!pThis || !pBaseClass) {
-        return FALSE;
-    }
-
-    // Walk the inheritance chain
-    const CRuntimeClass* pClass = pThis;
-    while (pClass != nullptr) {
-        if (pClass == pBaseClass) {
-            return TRUE;
-        }
-        pClass = pClass->m_pfnGetBaseClass ? pClass->m_pfnGetBaseClass() : pClass->m_pBaseClass;
-    }
-
-    return FALSE;
+    return OpenMFCIsDerivedFrom(pThis, pBaseClass) ? TRUE : FALSE;
 }
 
 // Symbol: ?Load@CRuntimeClass@@SAPEAU1@AEAVCArchive@@PEAI@Z
@@ -395,15 +405,13 @@ extern "C" CRuntimeClass* MS_ABI impl__Load_CRuntimeClass__SAPEAU1_AEAVCArchive_
     }
 
     // Read class name
-    char szClassName[65];
-    ar->Read(szClassName, wNameLen);
-    szClassName[wNameLen] = '\0';
+    char szClassName[64];
+    if (ar->Read(szClassName, wNameLen) != wNameLen) {
+        return nullptr;
+    }
 
     // Look up the class
-    InitializeClasses();
-    CRuntimeClass* pClass = FindRuntimeClass(szClassName);
-
-    return pClass;
+    return GetClassRegistry().Find(szClassName, wNameLen);
 }
 
 // Symbol: ?Store@CRuntimeClass@@QEBAXAEAVCArchive@@@Z
@@ -440,7 +448,58 @@ extern "C" void MS_ABI impl__Store_CRuntimeClass__QEBAXAEAVCArchive___Z(
 extern "C" void MS_ABI impl__AfxClassInit__YAXPEAUCRuntimeClass___Z(
     CRuntimeClass* pNewClass  // RCX = class to register
 ) {
+    InitializeClasses();    // core classes keep their names
     RegisterRuntimeClass(pNewClass);
+    GetAncestryCache().Invalidate();
+}
+
+// Layout of MFC's AFX_EXTENSION_MODULE (afxdll_.h).
+struct AFX_EXTENSION_MODULE {
+    BOOL bInitialized;
+    HMODULE hModule;
+    HMODULE hResource;
+    CRuntimeClass* pFirstSharedClass;
+    void* pFirstSharedFactory;
+};
+
+// AfxInitExtensionModule - called from an extension DLL's DllMain on attach
+// Symbol: ?AfxInitExtensionModule@@YAHAEAUAFX_EXTENSION_MODULE@@PEAUHINSTANCE__@@@Z
+extern "C" BOOL MS_ABI impl__AfxInitExtensionModule__YAHAEAUAFX_EXTENSION_MODULE__PEAUHINSTANCE_____Z(
+    AFX_EXTENSION_MODULE* pModule,  // RCX = module state
+    HINSTANCE hInst                 // RDX = the DLL
+) {
+    if (pModule->bInitialized) {
+        return TRUE;
+    }
+    pModule->bInitialized = TRUE;
+    pModule->hModule = hInst;
+    pModule->hResource = hInst;
+    return TRUE;
+}
+
+// Every thread's message-map cache (global_afx_msgcache.cpp)
+extern void OpenMfcFlushMessageCache();
+
+// AfxTermExtensionModule - called from an extension DLL's DllMain on detach.
+// The DLL's CRuntimeClass objects and message maps are about to be unmapped,
+// so the classes leave the registry, and cached ancestry and message-map
+// entries that might point at them are dropped.
+// Symbol: ?AfxTermExtensionModule@@YAXAEAUAFX_EXTENSION_MODULE@@H@Z
+extern "C" void MS_ABI impl__AfxTermExtensionModule__YAXAEAUAFX_EXTENSION_MODULE__H_Z(
+    AFX_EXTENSION_MODULE* pModule,  // RCX = module state
+    BOOL bAll                       // EDX = process detach (unused)
+) {
+    (void)bAll;
+    if (!pModule->bInitialized || !pModule->hModule) {
+        return;
+    }
+    const BYTE* pBase = reinterpret_cast<const BYTE*>(pModule->hModule);
+    const IMAGE_DOS_HEADER* pDos = reinterpret_cast<const IMAGE_DOS_HEADER*>(pBase);
+    const IMAGE_NT_HEADERS* pNt = reinterpret_cast<const IMAGE_NT_HEADERS*>(pBase + pDos->e_lfanew);
+    UnregisterClassesIn(pBase, pBase + pNt->OptionalHeader.SizeOfImage);
+    GetAncestryCache().Invalidate();
+    OpenMfcFlushMessageCache();
+    pModule->bInitialized = FALSE;
 }
 
 // AfxDynamicDownCast - dynamic_cast equivalent for MFC
@@ -452,12 +511,5 @@ extern "C" CObject* MS_ABI impl__AfxDynamicDownCast__YAPEAVCObject__PEAUCRuntime
     if (!pObject || !pClass) {
         return nullptr;
     }
-
-    // Get the object's runtime class through vtable
-    // For now, we assume caller handles this properly
-    // In real MFC, this would call pObject->GetRuntimeClass() virtually
-
-    // Simplified: just return the object (caller responsibility)
-    // Real implementation needs vtable access
-    return pObject;
+    return OpenMFCIsDerivedFrom(GetObjectRuntimeClass(pObject), pClass) ? pObject : nullptr;
 }
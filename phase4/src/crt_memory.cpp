@@ -1,46 +1,337 @@
 // Minimal CRT memory/string routines to avoid importing api-ms-win-crt-private.
 // llvm-mingw may otherwise resolve these primitives through the private UCRT
 // facade, which is not loadable on the Windows CI runners.
+//
+// Every CArchive/CMemFile transfer, collection grow and CString copy in the
+// DLL lands here, so these are real kernels rather than byte loops:
+//   - up to 64 bytes: overlapping scalar/SSE2 loads, all loads before stores,
+//     so the same path serves memcpy and memmove;
+//   - larger: head and tail vectors are loaded up front, the body runs as
+//     aligned 64-byte (SSE2) or 128-byte (AVX2) blocks, and copies of
+//     kNonTemporalThreshold bytes or more that do not overlap bypass the cache;
+//   - memmove copies backwards only when the destination starts inside the
+//     source;
+//   - memcmp/memchr/strchr/wcschr/wcsrchr test 16 bytes per step with SSE2,
+//     scanning from aligned blocks so they never cross into an unmapped page.
+// SSE2 is the x64 baseline. The AVX2 copy kernels are selected once at DLL
+// load from CPUID (and XGETBV, so the OS must also save YMM state).
+//
+// Defining OPENMFC_CRT_MEMORY_KERNELS_ONLY drops the exported CRT names so a
+// host test can link these kernels next to the system libc.
 
 #include <stddef.h>
+#include <stdint.h>
 #include <wchar.h>
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <immintrin.h>
 
-extern "C" {
+// The compiler must not turn a kernel's own loops back into calls to the
+// routines being defined here.
+#if defined(__clang__)
+  #define OPENMFC_CRT_KERNEL __attribute__((no_builtin))
+#else
+  #define OPENMFC_CRT_KERNEL __attribute__((optimize("no-tree-loop-distribute-patterns")))
+#endif
+#define OPENMFC_CRT_KERNEL_AVX2 OPENMFC_CRT_KERNEL __attribute__((target("avx2")))
 
-void* memcpy(void* dest, const void* src, size_t n) {
+namespace {
+
+typedef uint16_t __attribute__((may_alias, aligned(1))) UnalignedU16;
+typedef uint32_t __attribute__((may_alias, aligned(1))) UnalignedU32;
+typedef uint64_t __attribute__((may_alias, aligned(1))) UnalignedU64;
+
+// Copies at or above this size that do not overlap use streaming stores; they
+// would only evict the working set on the way through.
+const size_t kNonTemporalThreshold = 4u << 20;
+
+inline unsigned LowestSetBit(unsigned mask) {
+    return static_cast<unsigned>(__builtin_ctz(mask));
+}
+
+inline unsigned HighestSetBit(unsigned mask) {
+    return 31u - static_cast<unsigned>(__builtin_clz(mask));
+}
+
+// n <= 64. Loads everything before storing anything, so overlap is harmless.
+OPENMFC_CRT_KERNEL inline void CopySmall(unsigned char* d, const unsigned char* s, size_t n) {
+    if (n >= 32) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + n - 32));
+        __m128i e = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + n - 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d), a);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 16), b);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + n - 32), c);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + n - 16), e);
+    } else if (n >= 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + n - 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d), a);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + n - 16), b);
+    } else if (n >= 8) {
+        uint64_t a = *reinterpret_cast<const UnalignedU64*>(s);
+        uint64_t b = *reinterpret_cast<const UnalignedU64*>(s + n - 8);
+        *reinterpret_cast<UnalignedU64*>(d) = a;
+        *reinterpret_cast<UnalignedU64*>(d + n - 8) = b;
+    } else if (n >= 4) {
+        uint32_t a = *reinterpret_cast<const UnalignedU32*>(s);
+        uint32_t b = *reinterpret_cast<const UnalignedU32*>(s + n - 4);
+        *reinterpret_cast<UnalignedU32*>(d) = a;
+        *reinterpret_cast<UnalignedU32*>(d + n - 4) = b;
+    } else if (n >= 2) {
+        uint16_t a = *reinterpret_cast<const UnalignedU16*>(s);
+        uint16_t b = *reinterpret_cast<const UnalignedU16*>(s + n - 2);
+        *reinterpret_cast<UnalignedU16*>(d) = a;
+        *reinterpret_cast<UnalignedU16*>(d + n - 2) = b;
+    } else if (n == 1) {
+        *d = *s;
+    }
+}
+
+inline bool RangesOverlap(const unsigned char* d, const unsigned char* s, size_t n) {
+    return static_cast<size_t>(d - s) < n || static_cast<size_t>(s - d) < n;
+}
+
+// n > 64, and the destination does not start inside the source.
+OPENMFC_CRT_KERNEL void CopyForwardSse2(unsigned char* d, const unsigned char* s, size_t n) {
+    __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+    __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + n - 16));
+    unsigned char* dEnd = d + n;
+    size_t skew = 16 - (reinterpret_cast<uintptr_t>(d) & 15);
+    unsigned char* dp = d + skew;
+    const unsigned char* sp = s + skew;
+    size_t remaining = n - skew;
+
+    if (n >= kNonTemporalThreshold && !RangesOverlap(d, s, n)) {
+        for (; remaining > 64; remaining -= 64, dp += 64, sp += 64) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sp));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sp + 16));
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sp + 32));
+            __m128i e = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sp + 48));
+            _mm_stream_si128(reinterpret_cast<__m128i*>(dp), a);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(dp + 16), b);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(dp + 32), c);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(dp + 48), e);
+        }
+        _mm_sfence();
+    }
+    for (; remaining > 64; remaining -= 64, dp += 64, sp += 64) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sp));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sp + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sp + 32));
+        __m128i e = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sp + 48));
+        _mm_store_si128(reinterpret_cast<__m128i*>(dp), a);
+        _mm_store_si128(reinterpret_cast<__m128i*>(dp + 16), b);
+        _mm_store_si128(reinterpret_cast<__m128i*>(dp + 32), c);
+        _mm_store_si128(reinterpret_cast<__m128i*>(dp + 48), e);
+    }
+    for (; remaining > 16; remaining -= 16, dp += 16, sp += 16) {
+        _mm_store_si128(reinterpret_cast<__m128i*>(dp), _mm_loadu_si128(reinterpret_cast<const __m128i*>(sp)));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dEnd - 16), tail);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(d), head);
+}
+
+// n > 64, and the destination starts inside the source.
+OPENMFC_CRT_KERNEL void CopyBackwardSse2(unsigned char* d, const unsigned char* s, size_t n) {
+    __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+    __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + n - 16));
+    unsigned char* dEnd = d + n;
+    size_t skew = reinterpret_cast<uintptr_t>(dEnd) & 15;
+    unsigned char* dp = dEnd - skew;
+    const unsigned char* sp = s + n - skew;
+    size_t remaining = n - skew;
+
+    for (; remaining > 64; remaining -= 64) {
+        dp -= 64;
+        sp -= 64;
+        __m128i e = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sp + 48));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sp + 32));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sp + 16));
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sp));
+        _mm_store_si128(reinterpret_cast<__m128i*>(dp + 48), e);
+        _mm_store_si128(reinterpret_cast<__m128i*>(dp + 32), c);
+        _mm_store_si128(reinterpret_cast<__m128i*>(dp + 16), b);
+        _mm_store_si128(reinterpret_cast<__m128i*>(dp), a);
+    }
+    for (; remaining > 16; remaining -= 16) {
+        dp -= 16;
+        sp -= 16;
+        _mm_store_si128(reinterpret_cast<__m128i*>(dp), _mm_loadu_si128(reinterpret_cast<const __m128i*>(sp)));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(d), head);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dEnd - 16), tail);
+}
+
+OPENMFC_CRT_KERNEL_AVX2 void CopyForwardAvx2(unsigned char* d, const unsigned char* s, size_t n) {
+    if (n <= 128) {
+        CopyForwardSse2(d, s, n);
+        return;
+    }
+    __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+    __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + n - 32));
+    unsigned char* dEnd = d + n;
+    size_t skew = 32 - (reinterpret_cast<uintptr_t>(d) & 31);
+    unsigned char* dp = d + skew;
+    const unsigned char* sp = s + skew;
+    size_t remaining = n - skew;
+
+    if (n >= kNonTemporalThreshold && !RangesOverlap(d, s, n)) {
+        for (; remaining > 128; remaining -= 128, dp += 128, sp += 128) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sp));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sp + 32));
+            __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sp + 64));
+            __m256i e = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sp + 96));
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(dp), a);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(dp + 32), b);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(dp + 64), c);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(dp + 96), e);
+        }
+        _mm_sfence();
+    }
+    for (; remaining > 128; remaining -= 128, dp += 128, sp += 128) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sp));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sp + 32));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sp + 64));
+        __m256i e = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sp + 96));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(dp), a);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(dp + 32), b);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(dp + 64), c);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(dp + 96), e);
+    }
+    for (; remaining > 32; remaining -= 32, dp += 32, sp += 32) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(dp), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sp)));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dEnd - 32), tail);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(d), head);
+}
+
+OPENMFC_CRT_KERNEL_AVX2 void CopyBackwardAvx2(unsigned char* d, const unsigned char* s, size_t n) {
+    if (n <= 128) {
+        CopyBackwardSse2(d, s, n);
+        return;
+    }
+    __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+    __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + n - 32));
+    unsigned char* dEnd = d + n;
+    size_t skew = reinterpret_cast<uintptr_t>(dEnd) & 31;
+    unsigned char* dp = dEnd - skew;
+    const unsigned char* sp = s + n - skew;
+    size_t remaining = n - skew;
+
+    for (; remaining > 128; remaining -= 128) {
+        dp -= 128;
+        sp -= 128;
+        __m256i e = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sp + 96));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sp + 64));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sp + 32));
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sp));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(dp + 96), e);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(dp + 64), c);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(dp + 32), b);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(dp), a);
+    }
+    for (; remaining > 32; remaining -= 32) {
+        dp -= 32;
+        sp -= 32;
+        _mm256_store_si256(reinterpret_cast<__m256i*>(dp), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sp)));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(d), head);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dEnd - 32), tail);
+}
+
+typedef void (*CopyKernel)(unsigned char*, const unsigned char*, size_t);
+
+// SSE2 until the load-time constructor below has looked at the CPU; anything
+// the CRT copies before then still works.
+CopyKernel g_copyForward = CopyForwardSse2;
+CopyKernel g_copyBackward = CopyBackwardSse2;
+
+bool CpuHasAvx2() {
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    const unsigned kOsxsave = 1u << 27;
+    const unsigned kAvx = 1u << 28;
+    if ((ecx & (kOsxsave | kAvx)) != (kOsxsave | kAvx)) {
+        return false;
+    }
+    unsigned xcr0Low = 0, xcr0High = 0;
+    __asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+    if ((xcr0Low & 6) != 6) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ebx & (1u << 5)) != 0;
+}
+
+__attribute__((constructor)) void SelectCrtKernels() {
+    if (CpuHasAvx2()) {
+        g_copyForward = CopyForwardAvx2;
+        g_copyBackward = CopyBackwardAvx2;
+    }
+}
+
+OPENMFC_CRT_KERNEL void* CrtMemcpy(void* dest, const void* src, size_t n) {
     unsigned char* d = static_cast<unsigned char*>(dest);
     const unsigned char* s = static_cast<const unsigned char*>(src);
-    for (size_t i = 0; i < n; ++i) {
-        d[i] = s[i];
+    if (n <= 64) {
+        CopySmall(d, s, n);
+    } else {
+        g_copyForward(d, s, n);
     }
     return dest;
 }
 
-void* memmove(void* dest, const void* src, size_t n) {
+OPENMFC_CRT_KERNEL void* CrtMemmove(void* dest, const void* src, size_t n) {
     unsigned char* d = static_cast<unsigned char*>(dest);
     const unsigned char* s = static_cast<const unsigned char*>(src);
-
-    if (d == s || n == 0) {
+    if (d == s) {
         return dest;
     }
-
-    if (d < s || d >= s + n) {
-        for (size_t i = 0; i < n; ++i) {
-            d[i] = s[i];
-        }
+    if (n <= 64) {
+        CopySmall(d, s, n);
+    } else if (static_cast<size_t>(d - s) >= n) {
+        g_copyForward(d, s, n);
     } else {
-        for (size_t i = n; i > 0; --i) {
-            d[i - 1] = s[i - 1];
-        }
+        g_copyBackward(d, s, n);
     }
-
     return dest;
 }
 
-int memcmp(const void* lhs, const void* rhs, size_t n) {
+OPENMFC_CRT_KERNEL int CrtMemcmp(const void* lhs, const void* rhs, size_t n) {
     const unsigned char* a = static_cast<const unsigned char*>(lhs);
     const unsigned char* b = static_cast<const unsigned char*>(rhs);
-    for (size_t i = 0; i < n; ++i) {
+    if (n >= 16) {
+        size_t offset = 0;
+        for (;;) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + offset));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + offset));
+            unsigned diff = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb))) ^ 0xFFFFu;
+            if (diff) {
+                size_t i = offset + LowestSetBit(diff);
+                return static_cast<int>(a[i]) - static_cast<int>(b[i]);
+            }
+            if (offset + 16 == n) {
+                return 0;
+            }
+            // The last block overlaps the previous one instead of going short.
+            offset = (n - offset >= 32) ? offset + 16 : n - 16;
+        }
+    }
+    size_t i = 0;
+    if (n >= 8) {
+        uint64_t wa = *reinterpret_cast<const UnalignedU64*>(a);
+        uint64_t wb = *reinterpret_cast<const UnalignedU64*>(b);
+        if (wa == wb) {
+            i = 8;
+        }
+    }
+    for (; i < n; ++i) {
         if (a[i] != b[i]) {
             return static_cast<int>(a[i]) - static_cast<int>(b[i]);
         }
@@ -48,41 +339,89 @@ int memcmp(const void* lhs, const void* rhs, size_t n) {
     return 0;
 }
 
-void* memchr(const void* ptr, int ch, size_t n) {
+OPENMFC_CRT_KERNEL void* CrtMemchr(const void* ptr, int ch, size_t n) {
+    if (n == 0) {
+        return nullptr;
+    }
     const unsigned char* p = static_cast<const unsigned char*>(ptr);
-    const unsigned char c = static_cast<unsigned char>(ch);
-    for (size_t i = 0; i < n; ++i) {
-        if (p[i] == c) {
-            return const_cast<unsigned char*>(p + i);
+    const __m128i needle = _mm_set1_epi8(static_cast<char>(ch));
+    size_t misalign = reinterpret_cast<uintptr_t>(p) & 15;
+    const unsigned char* block = p - misalign;
+
+    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(block)), needle))) >> misalign;
+    if (mask) {
+        size_t i = LowestSetBit(mask);
+        return i < n ? const_cast<unsigned char*>(p + i) : nullptr;
+    }
+    size_t consumed = 16 - misalign;
+    if (consumed >= n) {
+        return nullptr;
+    }
+    size_t remaining = n - consumed;
+    for (block += 16; remaining >= 64; block += 64, remaining -= 64) {
+        __m128i a = _mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(block)), needle);
+        __m128i b = _mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(block + 16)), needle);
+        __m128i c = _mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(block + 32)), needle);
+        __m128i e = _mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(block + 48)), needle);
+        if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, e)))) {
+            break;
         }
     }
-    return nullptr;
-}
-
-char* strchr(const char* str, int ch) {
-    const char c = static_cast<char>(ch);
-    for (;; ++str) {
-        if (*str == c) {
-            return const_cast<char*>(str);
+    for (; remaining >= 16; block += 16, remaining -= 16) {
+        mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(block)), needle)));
+        if (mask) {
+            return const_cast<unsigned char*>(block + LowestSetBit(mask));
         }
-        if (*str == '\0') {
-            return nullptr;
+    }
+    if (remaining) {
+        mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(block)), needle)));
+        mask &= (1u << remaining) - 1;
+        if (mask) {
+            return const_cast<unsigned char*>(block + LowestSetBit(mask));
         }
     }
+    return nullptr;
 }
 
-int __intrinsic_setjmpex(void*) {
-    return 0;
-}
-
-[[noreturn]] void longjmp(void*, int) {
-    __builtin_trap();
+OPENMFC_CRT_KERNEL char* CrtStrchr(const char* str, int ch) {
+    const __m128i needle = _mm_set1_epi8(static_cast<char>(ch));
+    const __m128i zero = _mm_setzero_si128();
+    size_t misalign = reinterpret_cast<uintptr_t>(str) & 15;
+    const char* block = str - misalign;
+    unsigned shift = static_cast<unsigned>(misalign);
+    for (;; block += 16, shift = 0) {
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+        unsigned hit = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle))) >> shift << shift;
+        unsigned end = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero))) >> shift << shift;
+        if (hit | end) {
+            const char* p = block + LowestSetBit(hit | end);
+            return *p == static_cast<char>(ch) ? const_cast<char*>(p) : nullptr;
+        }
+    }
 }
 
-void (*__imp_longjmp)(void*, int) = longjmp;
-int (*__imp___intrinsic_setjmpex)(void*) = __intrinsic_setjmpex;
-
-wchar_t* wcschr(const wchar_t* str, wchar_t ch) {
+// The vector paths assume UTF-16 wchar_t on a 2-byte boundary, which is what
+// the DLL always passes; anything else takes the scalar loop.
+OPENMFC_CRT_KERNEL wchar_t* CrtWcschr(const wchar_t* str, wchar_t ch) {
+    if (sizeof(wchar_t) == 2 && (reinterpret_cast<uintptr_t>(str) & 1) == 0) {
+        const __m128i needle = _mm_set1_epi16(static_cast<short>(ch));
+        const __m128i zero = _mm_setzero_si128();
+        size_t misalign = reinterpret_cast<uintptr_t>(str) & 15;
+        const unsigned char* block = reinterpret_cast<const unsigned char*>(str) - misalign;
+        unsigned shift = static_cast<unsigned>(misalign);
+        for (;; block += 16, shift = 0) {
+            __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+            unsigned hit = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi16(v, needle))) >> shift << shift;
+            unsigned end = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi16(v, zero))) >> shift << shift;
+            if (hit | end) {
+                const wchar_t* p = reinterpret_cast<const wchar_t*>(block + LowestSetBit(hit | end));
+                return *p == ch ? const_cast<wchar_t*>(p) : nullptr;
+            }
+        }
+    }
     for (;; ++str) {
         if (*str == ch) {
             return const_cast<wchar_t*>(str);
@@ -93,8 +432,30 @@ wchar_t* wcschr(const wchar_t* str, wchar_t ch) {
     }
 }
 
-wchar_t* wcsrchr(const wchar_t* str, wchar_t ch) {
+OPENMFC_CRT_KERNEL wchar_t* CrtWcsrchr(const wchar_t* str, wchar_t ch) {
     const wchar_t* found = nullptr;
+    if (sizeof(wchar_t) == 2 && (reinterpret_cast<uintptr_t>(str) & 1) == 0) {
+        const __m128i needle = _mm_set1_epi16(static_cast<short>(ch));
+        const __m128i zero = _mm_setzero_si128();
+        size_t misalign = reinterpret_cast<uintptr_t>(str) & 15;
+        const unsigned char* block = reinterpret_cast<const unsigned char*>(str) - misalign;
+        unsigned shift = static_cast<unsigned>(misalign);
+        for (;; block += 16, shift = 0) {
+            __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+            unsigned hit = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi16(v, needle))) >> shift << shift;
+            unsigned end = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi16(v, zero))) >> shift << shift;
+            if (end) {
+                // Keep matches up to and including the terminator's two bytes.
+                hit &= (2u << (LowestSetBit(end) + 1)) - 1;
+            }
+            if (hit) {
+                found = reinterpret_cast<const wchar_t*>(block + (HighestSetBit(hit) & ~1u));
+            }
+            if (end) {
+                return const_cast<wchar_t*>(found);
+            }
+        }
+    }
     for (;; ++str) {
         if (*str == ch) {
             found = str;
@@ -106,4 +467,51 @@ wchar_t* wcsrchr(const wchar_t* str, wchar_t ch) {
     return const_cast<wchar_t*>(found);
 }
 
+} // namespace
+
+#ifndef OPENMFC_CRT_MEMORY_KERNELS_ONLY
+
+extern "C" {
+
+void* memcpy(void* dest, const void* src, size_t n) {
+    return CrtMemcpy(dest, src, n);
 }
+
+void* memmove(void* dest, const void* src, size_t n) {
+    return CrtMemmove(dest, src, n);
+}
+
+int memcmp(const void* lhs, const void* rhs, size_t n) {
+    return CrtMemcmp(lhs, rhs, n);
+}
+
+void* memchr(const void* ptr, int ch, size_t n) {
+    return CrtMemchr(ptr, ch, n);
+}
+
+char* strchr(const char* str, int ch) {
+    return CrtStrchr(str, ch);
+}
+
+int __intrinsic_setjmpex(void*) {
+    return 0;
+}
+
+[[noreturn]] void longjmp(void*, int) {
+    __builtin_trap();
+}
+
+void (*__imp_longjmp)(void*, int) = longjmp;
+int (*__imp___intrinsic_setjmpex)(void*) = __intrinsic_setjmpex;
+
+wchar_t* wcschr(const wchar_t* str, wchar_t ch) {
+    return CrtWcschr(str, ch);
+}
+
+wchar_t* wcsrchr(const wchar_t* str, wchar_t ch) {
+    return CrtWcsrchr(str, ch);
+}
+
+}
+
+#endif // OPENMFC_CRT_MEMORY_KERNELS_ONLY
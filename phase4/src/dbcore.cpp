@@ -6,6 +6,7 @@
 #define OPENMFC_APPCORE_IMPL
 #include "openmfc/afxwin.h"
 #include "openmfc/afxdb.h"
+#include "statement_cache.h"
 #include <algorithm>
 #include <cwctype>
 #include <cstring>
@@ -159,6 +160,108 @@ void StoreSql(CRecordset* recordset, const CString& sql) {
 //=============================================================================
 // No IMPLEMENT_DYNAMIC needed - CDBException doesn't derive from CObject
 
+//=============================================================================
+// Prepared statement cache (CDatabase::ExecuteSQL, ExecuteSQLBatch)
+//=============================================================================
+// One per CDatabase (statement_cache.h), keyed on the SQL text, and off
+// until SetStatementCacheSize turns it on. Recordset statements never go
+// through it: OnSetOptions sets cursor attributes that a driver refuses
+// (HY011) once a statement is prepared, so each Open sets them on a new
+// statement before preparing it.
+struct CDatabaseStatementCache : openmfc_stmtcache::StatementCache<HSTMT> {};
+
+namespace {
+
+void FreeStatement(HSTMT hstmt) {
+    SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+}
+
+bool StatementCacheOn(const CDatabase* pDatabase) {
+    return pDatabase->m_pStatementCache && pDatabase->m_pStatementCache->GetMaxIdle() != 0;
+}
+
+// A prepared statement for lpszSQL: an idle one from the cache, or a new
+// one. SQL_NULL_HSTMT on failure.
+HSTMT CheckOutStatement(CDatabase* pDatabase, const wchar_t* lpszSQL) {
+    CDatabaseStatementCache* pCache = StatementCacheOn(pDatabase) ? pDatabase->m_pStatementCache : nullptr;
+    HSTMT hstmt = pCache ? pCache->Take(lpszSQL) : SQL_NULL_HSTMT;
+    if (hstmt != SQL_NULL_HSTMT) {
+        return hstmt;
+    }
+    if (SQLAllocHandle(SQL_HANDLE_STMT, pDatabase->GetHDBC(), &hstmt) != SQL_SUCCESS) {
+        return SQL_NULL_HSTMT;
+    }
+    if (!SqlSucceeded(SQLPrepareW(hstmt, (SQLWCHAR*)lpszSQL, SQL_NTS))) {
+        SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+        return SQL_NULL_HSTMT;
+    }
+    if (pCache) pCache->Adopt(hstmt);
+    return hstmt;
+}
+
+// Gives a statement back to the cache with its cursor closed and its
+// parameters reset; frees it if the cache does not keep it.
+void CheckInStatement(CDatabase* pDatabase, const wchar_t* lpszSQL, HSTMT hstmt) {
+    CDatabaseStatementCache* pCache = pDatabase->m_pStatementCache;
+    if (!pCache || !pCache->CheckIn(lpszSQL, hstmt, FreeStatement)) {
+        SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+        return;
+    }
+    SQLFreeStmt(hstmt, SQL_CLOSE);
+    SQLFreeStmt(hstmt, SQL_RESET_PARAMS);
+    SQLSetStmtAttr(hstmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)1, 0);
+}
+
+bool BindParamRow(HSTMT hstmt, const CDatabase::ParamArray* pParams, int nParams, DWORD nRow) {
+    for (int i = 0; i < nParams; ++i) {
+        const CDatabase::ParamArray& param = pParams[i];
+        char* pValue = static_cast<char*>(param.pValues) + static_cast<size_t>(nRow) * param.nValueSize;
+        SQLLEN* pLength = param.pLengths ? param.pLengths + nRow : nullptr;
+        if (!SqlSucceeded(SQLBindParameter(hstmt, static_cast<SQLUSMALLINT>(i + 1), SQL_PARAM_INPUT,
+                                           param.nCType, param.nSQLType, param.nColumnSize,
+                                           param.nDecimalDigits, pValue, param.nValueSize, pLength))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Runs a prepared statement once per row of the parameter arrays: as one
+// SQLExecute with SQL_ATTR_PARAMSET_SIZE = nRows if the driver takes that
+// size as asked, else row by row on the same prepared statement.
+bool ExecuteParamArrays(HSTMT hstmt, const CDatabase::ParamArray* pParams, int nParams, DWORD nRows,
+                        DWORD* pnProcessed) {
+    *pnProcessed = 0;
+    if (nRows > 1 &&
+        SqlSucceeded(SQLSetStmtAttr(hstmt, SQL_ATTR_PARAM_BIND_TYPE, (SQLPOINTER)SQL_PARAM_BIND_BY_COLUMN, 0)) &&
+        SQLSetStmtAttr(hstmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)(SQLULEN)nRows, 0) == SQL_SUCCESS) {
+        std::vector<SQLUSMALLINT> status(nRows, SQL_PARAM_ERROR);
+        SQLULEN nProcessed = 0;
+        SQLSetStmtAttr(hstmt, SQL_ATTR_PARAM_STATUS_PTR, status.data(), 0);
+        SQLSetStmtAttr(hstmt, SQL_ATTR_PARAMS_PROCESSED_PTR, &nProcessed, 0);
+        bool bOk = BindParamRow(hstmt, pParams, nParams, 0) && SqlSucceeded(SQLExecute(hstmt));
+        SQLSetStmtAttr(hstmt, SQL_ATTR_PARAM_STATUS_PTR, nullptr, 0);
+        SQLSetStmtAttr(hstmt, SQL_ATTR_PARAMS_PROCESSED_PTR, nullptr, 0);
+        *pnProcessed = static_cast<DWORD>(std::min<SQLULEN>(nProcessed, nRows));
+        for (DWORD i = 0; bOk && i < *pnProcessed; ++i) {
+            bOk = status[i] != SQL_PARAM_ERROR;
+        }
+        return bOk && *pnProcessed == nRows;
+    }
+
+    SQLSetStmtAttr(hstmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)1, 0);
+    for (DWORD nRow = 0; nRow < nRows; ++nRow) {
+        if (!BindParamRow(hstmt, pParams, nParams, nRow) || !SqlSucceeded(SQLExecute(hstmt))) {
+            return false;
+        }
+        SQLFreeStmt(hstmt, SQL_CLOSE);
+        *pnProcessed = nRow + 1;
+    }
+    return true;
+}
+
+}
+
 //=============================================================================
 // CDatabase
 //=============================================================================
@@ -166,13 +269,15 @@ IMPLEMENT_DYNAMIC(CDatabase, CObject)
 
 CDatabase::CDatabase()
     : m_hdbc(SQL_NULL_HDBC), m_henv(SQL_NULL_HENV),
-      m_bOpen(FALSE), m_bReadOnly(FALSE) {
+      m_bOpen(FALSE), m_bReadOnly(FALSE),
+      m_pStatementCache(new (std::nothrow) CDatabaseStatementCache) {
     memset(_cdatabase_padding, 0, sizeof(_cdatabase_padding));
     g_databaseStates[this] = DbState{};
 }
 
 CDatabase::~CDatabase() {
     Close();
+    delete m_pStatementCache;
     g_databaseStates.erase(this);
 }
 
@@ -235,6 +340,12 @@ BOOL CDatabase::Open(const wchar_t* lpszDSN, BOOL bExclusive, BOOL bReadOnly,
 }
 
 void CDatabase::Close() {
+    // Idle statements are freed here; one still checked out goes with the
+    // disconnect below.
+    if (m_pStatementCache) {
+        m_pStatementCache->Trim(0, FreeStatement);
+        m_pStatementCache->ForgetCheckedOut();
+    }
     if (m_hdbc != SQL_NULL_HDBC) {
         SQLDisconnect(m_hdbc);
         SQLFreeHandle(SQL_HANDLE_DBC, m_hdbc);
@@ -272,15 +383,63 @@ BOOL CDatabase::Rollback() {
 
 BOOL CDatabase::ExecuteSQL(const wchar_t* lpszSQL) {
     if (!m_bOpen || !lpszSQL) return FALSE;
-    HSTMT hstmt = SQL_NULL_HSTMT;
-    if (SQLAllocHandle(SQL_HANDLE_STMT, m_hdbc, &hstmt) != SQL_SUCCESS) {
-        return FALSE;
+    RETCODE rc = SQL_ERROR;
+    if (StatementCacheOn(this)) {
+        HSTMT hstmt = CheckOutStatement(this, lpszSQL);
+        if (hstmt == SQL_NULL_HSTMT) {
+            return FALSE;
+        }
+        rc = SQLExecute(hstmt);
+        CheckInStatement(this, lpszSQL, hstmt);
+    } else {
+        HSTMT hstmt = SQL_NULL_HSTMT;
+        if (SQLAllocHandle(SQL_HANDLE_STMT, m_hdbc, &hstmt) != SQL_SUCCESS) {
+            return FALSE;
+        }
+        rc = SQLExecDirectW(hstmt, (SQLWCHAR*)lpszSQL, SQL_NTS);
+        SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
     }
-    RETCODE rc = SQLExecDirectW(hstmt, (SQLWCHAR*)lpszSQL, SQL_NTS);
-    SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
     return (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO);
 }
 
+BOOL CDatabase::ExecuteSQLBatch(const wchar_t* lpszSQL, const ParamArray* pParams, int nParams,
+                                DWORD nRows, DWORD* pRowsProcessed) {
+    if (pRowsProcessed) *pRowsProcessed = 0;
+    if (!m_bOpen || !lpszSQL || nParams < 0 || (nParams > 0 && !pParams)) return FALSE;
+    if (nRows == 0) return TRUE;
+    HSTMT hstmt = CheckOutStatement(this, lpszSQL);
+    if (hstmt == SQL_NULL_HSTMT) {
+        return FALSE;
+    }
+    DWORD nProcessed = 0;
+    const bool bOk = ExecuteParamArrays(hstmt, pParams, nParams, nRows, &nProcessed);
+    CheckInStatement(this, lpszSQL, hstmt);
+    if (pRowsProcessed) *pRowsProcessed = nProcessed;
+    return bOk ? TRUE : FALSE;
+}
+
+void CDatabase::SetStatementCacheSize(int nStatements) {
+    if (m_pStatementCache) {
+        m_pStatementCache->SetMaxIdle(nStatements > 0 ? static_cast<size_t>(nStatements) : 0, FreeStatement);
+    }
+}
+
+int CDatabase::GetStatementCacheSize() const {
+    return m_pStatementCache ? static_cast<int>(m_pStatementCache->GetMaxIdle()) : 0;
+}
+
+DWORD CDatabase::GetStatementCacheHits() const {
+    return m_pStatementCache ? m_pStatementCache->GetHits() : 0;
+}
+
+DWORD CDatabase::GetStatementCacheMisses() const {
+    return m_pStatementCache ? m_pStatementCache->GetMisses() : 0;
+}
+
+void CDatabase::FlushStatementCache() {
+    if (m_pStatementCache) m_pStatementCache->Trim(0, FreeStatement);
+}
+
 void CDatabase::Cancel() {
 }
 
@@ -345,6 +504,257 @@ void CFieldExchange::SetNull(const wchar_t* lpszName) {
     (void)lpszName;
 }
 
+//=============================================================================
+// Bulk rowsets (CRecordset::useMultiRowFetch)
+//=============================================================================
+// The arrays each RFX_*_Bulk call allocated and bound, and the ODBC rowset
+// status the driver writes on every fetch. The length arrays are bound
+// directly as the ODBC length/indicator arrays.
+static_assert(sizeof(SQLLEN) == sizeof(__int64), "RFX_*_Bulk length arrays are SQLLEN indicators");
+
+struct CRecordsetBulkRowset {
+    struct Column {
+        unsigned char* pValues;
+        __int64* pLengths;
+        void** ppValues;       // the recordset members that point at them
+        __int64** ppLengths;
+    };
+    std::vector<Column> columns;
+    std::vector<SQLUSMALLINT> rowStatus;
+    SQLULEN nRowsFetched = 0;
+    DWORD nRowsetSize = 0;
+};
+
+namespace {
+
+void FreeBulkColumns(CRecordset* recordset) {
+    CRecordsetBulkRowset* bulk = recordset->m_pBulkRowset;
+    if (!bulk) return;
+    if (recordset->m_hstmt != SQL_NULL_HSTMT) {
+        SQLFreeStmt(recordset->m_hstmt, SQL_UNBIND);
+    }
+    for (const CRecordsetBulkRowset::Column& column : bulk->columns) {
+        if (*column.ppValues == column.pValues) *column.ppValues = nullptr;
+        if (*column.ppLengths == column.pLengths) *column.ppLengths = nullptr;
+        delete[] column.pValues;
+        delete[] column.pLengths;
+    }
+    bulk->columns.clear();
+    recordset->m_dwRowsFetched = 0;
+    recordset->m_dwRowsetRow = 0;
+}
+
+// Sets up column-wise binding of m_dwRowsetSize rows and lets
+// DoBulkFieldExchange allocate and bind the arrays. The driver may lower
+// the rowset size; m_dwRowsetSize then reports what it accepted.
+bool AllocBulkColumns(CRecordset* recordset) {
+    if (recordset->m_hstmt == SQL_NULL_HSTMT) return false;
+    CRecordsetBulkRowset* bulk = recordset->m_pBulkRowset;
+    if (!bulk) {
+        bulk = new (std::nothrow) CRecordsetBulkRowset;
+        if (!bulk) return false;
+        recordset->m_pBulkRowset = bulk;
+    }
+    FreeBulkColumns(recordset);
+
+    HSTMT hstmt = recordset->m_hstmt;
+    SQLULEN nRows = recordset->m_dwRowsetSize != 0 ? recordset->m_dwRowsetSize : 1;
+    if (!SqlSucceeded(SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_BIND_TYPE, (SQLPOINTER)SQL_BIND_BY_COLUMN, 0)) ||
+        !SqlSucceeded(SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)nRows, 0))) {
+        return false;
+    }
+    SQLULEN nAccepted = 0;
+    if (SqlSucceeded(SQLGetStmtAttr(hstmt, SQL_ATTR_ROW_ARRAY_SIZE, &nAccepted, 0, nullptr)) && nAccepted != 0) {
+        nRows = nAccepted;
+    }
+    bulk->nRowsetSize = static_cast<DWORD>(nRows);
+    recordset->m_dwRowsetSize = bulk->nRowsetSize;
+    bulk->rowStatus.assign(nRows, static_cast<SQLUSMALLINT>(SQL_ROW_NOROW));
+    bulk->nRowsFetched = 0;
+    SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_STATUS_PTR, bulk->rowStatus.data(), 0);
+    SQLSetStmtAttr(hstmt, SQL_ATTR_ROWS_FETCHED_PTR, &bulk->nRowsFetched, 0);
+    recordset->m_rgRowStatus = bulk->rowStatus.data();
+
+    CFieldExchange fx(CFieldExchange::AllocMultiRowBuffer, recordset);
+    recordset->DoBulkFieldExchange(&fx);
+    return true;
+}
+
+void FreeBulkRowset(CRecordset* recordset) {
+    if (!recordset->m_pBulkRowset) return;
+    FreeBulkColumns(recordset);
+    if (recordset->m_hstmt != SQL_NULL_HSTMT) {
+        SQLSetStmtAttr(recordset->m_hstmt, SQL_ATTR_ROW_STATUS_PTR, nullptr, 0);
+        SQLSetStmtAttr(recordset->m_hstmt, SQL_ATTR_ROWS_FETCHED_PTR, nullptr, 0);
+    }
+    delete recordset->m_pBulkRowset;
+    recordset->m_pBulkRowset = nullptr;
+    recordset->m_rgRowStatus = nullptr;
+}
+
+// Fetches a whole rowset; returns the rows it holds (0 at either end).
+DWORD FetchBulkRowset(CRecordset* recordset, SQLSMALLINT nOrientation, SQLLEN nOffset) {
+    RETCODE rc = SQLFetchScroll(recordset->m_hstmt, nOrientation, nOffset);
+    recordset->m_dwRowsFetched =
+        SqlSucceeded(rc) ? static_cast<DWORD>(recordset->m_pBulkRowset->nRowsFetched) : 0;
+    recordset->m_dwRowsetRow = 0;
+    return recordset->m_dwRowsFetched;
+}
+
+// Absolute position of the fetched rowset's first row.
+long BulkRowsetStart(const CRecordset* recordset) {
+    return recordset->m_nAbsolutePosition - static_cast<long>(recordset->m_dwRowsetRow);
+}
+
+void BindBulkColumn(CFieldExchange* pFX, void** ppValues, __int64** ppLengths, SQLSMALLINT nCType,
+                    SQLLEN nElementSize) {
+    if (!pFX || pFX->m_nOperation != CFieldExchange::AllocMultiRowBuffer || !ppValues || !ppLengths ||
+        nElementSize <= 0) {
+        return;
+    }
+    CRecordset* recordset = pFX->m_pRecordset;
+    if (!recordset || !recordset->m_pBulkRowset) return;
+    CRecordsetBulkRowset& bulk = *recordset->m_pBulkRowset;
+    const SQLUSMALLINT nColumn = static_cast<SQLUSMALLINT>(++pFX->m_nFields);
+    *ppValues = nullptr;
+    *ppLengths = nullptr;
+    CRecordsetBulkRowset::Column column = {
+        new (std::nothrow) unsigned char[static_cast<size_t>(nElementSize) * bulk.nRowsetSize](),
+        new (std::nothrow) __int64[bulk.nRowsetSize](),
+        ppValues, ppLengths };
+    if (!column.pValues || !column.pLengths) {
+        delete[] column.pValues;
+        delete[] column.pLengths;
+        return;
+    }
+    if (!SqlSucceeded(SQLBindCol(recordset->m_hstmt, nColumn, nCType, column.pValues, nElementSize,
+                                 reinterpret_cast<SQLLEN*>(column.pLengths)))) {
+        delete[] column.pValues;
+        delete[] column.pLengths;
+        return;
+    }
+    *ppValues = column.pValues;
+    *ppLengths = column.pLengths;
+    bulk.columns.push_back(column);
+}
+}
+
+void AFXAPI RFX_Text_Bulk(CFieldExchange* pFX, const wchar_t* szName, wchar_t** prgStrVals,
+                          __int64** prgLengths, int nMaxLength) {
+    (void)szName;
+    BindBulkColumn(pFX, reinterpret_cast<void**>(prgStrVals), prgLengths, SQL_C_WCHAR,
+                   static_cast<SQLLEN>(nMaxLength) * sizeof(wchar_t));
+}
+
+void AFXAPI RFX_Text_Bulk(CFieldExchange* pFX, const wchar_t* szName, char** prgStrVals,
+                          __int64** prgLengths, int nMaxLength) {
+    (void)szName;
+    BindBulkColumn(pFX, reinterpret_cast<void**>(prgStrVals), prgLengths, SQL_C_CHAR, nMaxLength);
+}
+
+void AFXAPI RFX_Bool_Bulk(CFieldExchange* pFX, const wchar_t* szName, BOOL** prgBoolVals, __int64** prgLengths) {
+    (void)szName;
+    BindBulkColumn(pFX, reinterpret_cast<void**>(prgBoolVals), prgLengths, SQL_C_LONG, sizeof(BOOL));
+}
+
+void AFXAPI RFX_Int_Bulk(CFieldExchange* pFX, const wchar_t* szName, int** prgIntVals, __int64** prgLengths) {
+    (void)szName;
+    BindBulkColumn(pFX, reinterpret_cast<void**>(prgIntVals), prgLengths, SQL_C_LONG, sizeof(int));
+}
+
+void AFXAPI RFX_Long_Bulk(CFieldExchange* pFX, const wchar_t* szName, long** prgLongVals, __int64** prgLengths) {
+    (void)szName;
+    BindBulkColumn(pFX, reinterpret_cast<void**>(prgLongVals), prgLengths, SQL_C_LONG, sizeof(long));
+}
+
+void AFXAPI RFX_Single_Bulk(CFieldExchange* pFX, const wchar_t* szName, float** prgFltVals, __int64** prgLengths) {
+    (void)szName;
+    BindBulkColumn(pFX, reinterpret_cast<void**>(prgFltVals), prgLengths, SQL_C_FLOAT, sizeof(float));
+}
+
+void AFXAPI RFX_Double_Bulk(CFieldExchange* pFX, const wchar_t* szName, double** prgDblVals, __int64** prgLengths) {
+    (void)szName;
+    BindBulkColumn(pFX, reinterpret_cast<void**>(prgDblVals), prgLengths, SQL_C_DOUBLE, sizeof(double));
+}
+
+void AFXAPI RFX_Date_Bulk(CFieldExchange* pFX, const wchar_t* szName, TIMESTAMP_STRUCT** prgTSVals,
+                          __int64** prgLengths) {
+    (void)szName;
+    BindBulkColumn(pFX, reinterpret_cast<void**>(prgTSVals), prgLengths, SQL_C_TIMESTAMP,
+                   sizeof(TIMESTAMP_STRUCT));
+}
+
+void AFXAPI RFX_Byte_Bulk(CFieldExchange* pFX, const wchar_t* szName, BYTE** prgByteVals, __int64** prgLengths) {
+    (void)szName;
+    BindBulkColumn(pFX, reinterpret_cast<void**>(prgByteVals), prgLengths, SQL_C_UTINYINT, sizeof(BYTE));
+}
+
+void AFXAPI RFX_Binary_Bulk(CFieldExchange* pFX, const wchar_t* szName, BYTE** prgByteVals,
+                            __int64** prgLengths, int nMaxLength) {
+    (void)szName;
+    BindBulkColumn(pFX, reinterpret_cast<void**>(prgByteVals), prgLengths, SQL_C_BINARY, nMaxLength);
+}
+
+// Symbol: ?RFX_Text_Bulk@@YAXPEAVCFieldExchange@@PEB_WPEAPEA_WPEAPEA_JH@Z
+extern "C" void MS_ABI impl__RFX_Text_Bulk__YAXPEAVCFieldExchange__PEB_WPEAPEA_WPEAPEA_JH_Z(
+    CFieldExchange* pFX, const wchar_t* szName, wchar_t** prgStrVals, __int64** prgLengths, int nMaxLength) {
+    RFX_Text_Bulk(pFX, szName, prgStrVals, prgLengths, nMaxLength);
+}
+
+// Symbol: ?RFX_Text_Bulk@@YAXPEAVCFieldExchange@@PEB_WPEAPEADPEAPEA_JH@Z
+extern "C" void MS_ABI impl__RFX_Text_Bulk__YAXPEAVCFieldExchange__PEB_WPEAPEADPEAPEA_JH_Z(
+    CFieldExchange* pFX, const wchar_t* szName, char** prgStrVals, __int64** prgLengths, int nMaxLength) {
+    RFX_Text_Bulk(pFX, szName, prgStrVals, prgLengths, nMaxLength);
+}
+
+// Symbol: ?RFX_Bool_Bulk@@YAXPEAVCFieldExchange@@PEB_WPEAPEAHPEAPEA_J@Z
+extern "C" void MS_ABI impl__RFX_Bool_Bulk__YAXPEAVCFieldExchange__PEB_WPEAPEAHPEAPEA_J_Z(
+    CFieldExchange* pFX, const wchar_t* szName, BOOL** prgBoolVals, __int64** prgLengths) {
+    RFX_Bool_Bulk(pFX, szName, prgBoolVals, prgLengths);
+}
+
+// Symbol: ?RFX_Int_Bulk@@YAXPEAVCFieldExchange@@PEB_WPEAPEAHPEAPEA_J@Z
+extern "C" void MS_ABI impl__RFX_Int_Bulk__YAXPEAVCFieldExchange__PEB_WPEAPEAHPEAPEA_J_Z(
+    CFieldExchange* pFX, const wchar_t* szName, int** prgIntVals, __int64** prgLengths) {
+    RFX_Int_Bulk(pFX, szName, prgIntVals, prgLengths);
+}
+
+// Symbol: ?RFX_Long_Bulk@@YAXPEAVCFieldExchange@@PEB_WPEAPEAJPEAPEA_J@Z
+extern "C" void MS_ABI impl__RFX_Long_Bulk__YAXPEAVCFieldExchange__PEB_WPEAPEAJPEAPEA_J_Z(
+    CFieldExchange* pFX, const wchar_t* szName, long** prgLongVals, __int64** prgLengths) {
+    RFX_Long_Bulk(pFX, szName, prgLongVals, prgLengths);
+}
+
+// Symbol: ?RFX_Single_Bulk@@YAXPEAVCFieldExchange@@PEB_WPEAPEAMPEAPEA_J@Z
+extern "C" void MS_ABI impl__RFX_Single_Bulk__YAXPEAVCFieldExchange__PEB_WPEAPEAMPEAPEA_J_Z(
+    CFieldExchange* pFX, const wchar_t* szName, float** prgFltVals, __int64** prgLengths) {
+    RFX_Single_Bulk(pFX, szName, prgFltVals, prgLengths);
+}
+
+// Symbol: ?RFX_Double_Bulk@@YAXPEAVCFieldExchange@@PEB_WPEAPEANPEAPEA_J@Z
+extern "C" void MS_ABI impl__RFX_Double_Bulk__YAXPEAVCFieldExchange__PEB_WPEAPEANPEAPEA_J_Z(
+    CFieldExchange* pFX, const wchar_t* szName, double** prgDblVals, __int64** prgLengths) {
+    RFX_Double_Bulk(pFX, szName, prgDblVals, prgLengths);
+}
+
+// Symbol: ?RFX_Date_Bulk@@YAXPEAVCFieldExchange@@PEB_WPEAPEAUtagTIMESTAMP_STRUCT@@PEAPEA_J@Z
+extern "C" void MS_ABI impl__RFX_Date_Bulk__YAXPEAVCFieldExchange__PEB_WPEAPEAUtagTIMESTAMP_STRUCT__PEAPEA_J_Z(
+    CFieldExchange* pFX, const wchar_t* szName, TIMESTAMP_STRUCT** prgTSVals, __int64** prgLengths) {
+    RFX_Date_Bulk(pFX, szName, prgTSVals, prgLengths);
+}
+
+// Symbol: ?RFX_Byte_Bulk@@YAXPEAVCFieldExchange@@PEB_WPEAPEAEPEAPEA_J@Z
+extern "C" void MS_ABI impl__RFX_Byte_Bulk__YAXPEAVCFieldExchange__PEB_WPEAPEAEPEAPEA_J_Z(
+    CFieldExchange* pFX, const wchar_t* szName, BYTE** prgByteVals, __int64** prgLengths) {
+    RFX_Byte_Bulk(pFX, szName, prgByteVals, prgLengths);
+}
+
+// Symbol: ?RFX_Binary_Bulk@@YAXPEAVCFieldExchange@@PEB_WPEAPEAEPEAPEA_JH@Z
+extern "C" void MS_ABI impl__RFX_Binary_Bulk__YAXPEAVCFieldExchange__PEB_WPEAPEAEPEAPEA_JH_Z(
+    CFieldExchange* pFX, const wchar_t* szName, BYTE** prgByteVals, __int64** prgLengths, int nMaxLength) {
+    RFX_Binary_Bulk(pFX, szName, prgByteVals, prgLengths, nMaxLength);
+}
+
 //=============================================================================
 // CRecordset
 //=============================================================================
@@ -356,7 +766,8 @@ CRecordset::CRecordset(CDatabase* pDatabase)
       m_nFields(0), m_nParams(0), m_nRecordCount(0),
       m_nAbsolutePosition(0), m_dwRowsetSize(1),
       m_nOpenType(CRecordset::dynaset),
-      m_dwOptions(CRecordset::none), m_nEditMode(0) {
+      m_dwOptions(CRecordset::none), m_nEditMode(0),
+      m_dwRowsFetched(0), m_dwRowsetRow(0), m_rgRowStatus(nullptr), m_pBulkRowset(nullptr) {
     memset(_crecordset_padding, 0, sizeof(_crecordset_padding));
 }
 
@@ -376,24 +787,30 @@ BOOL CRecordset::Open(UINT nOpenType, const wchar_t* lpszSQL, DWORD dwOptions) {
         return FALSE;
     }
 
+    // Get SQL string
+    CString strSQL = lpszSQL ? CString(lpszSQL) : GetDefaultSQL();
+    if (strSQL.IsEmpty()) {
+        return FALSE;
+    }
+
     // Allocate statement handle
     if (SQLAllocHandle(SQL_HANDLE_STMT, m_pDatabase->GetHDBC(), &m_hstmt) != SQL_SUCCESS) {
         return FALSE;
     }
 
-    // Set options
+    // Set options before the statement is prepared; cursor attributes
+    // cannot be changed afterwards.
     OnSetOptions(m_hstmt);
 
-    // Get SQL string
-    CString strSQL = lpszSQL ? CString(lpszSQL) : GetDefaultSQL();
-    if (strSQL.IsEmpty()) {
-        SQLFreeHandle(SQL_HANDLE_STMT, m_hstmt);
-        m_hstmt = SQL_NULL_HSTMT;
-        return FALSE;
+    // Execute: prepared, so Requery can run it again, or directly for
+    // executeDirect.
+    RETCODE rc = SQL_ERROR;
+    if (dwOptions & CRecordset::executeDirect) {
+        rc = SQLExecDirectW(m_hstmt, (SQLWCHAR*)(const wchar_t*)strSQL, SQL_NTS);
+    } else {
+        rc = SQLPrepareW(m_hstmt, (SQLWCHAR*)(const wchar_t*)strSQL, SQL_NTS);
+        if (SqlSucceeded(rc)) rc = SQLExecute(m_hstmt);
     }
-
-    // Execute
-    RETCODE rc = SQLExecDirectW(m_hstmt, (SQLWCHAR*)(const wchar_t*)strSQL, SQL_NTS);
     if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) {
         SQLFreeHandle(SQL_HANDLE_STMT, m_hstmt);
         m_hstmt = SQL_NULL_HSTMT;
@@ -405,6 +822,15 @@ BOOL CRecordset::Open(UINT nOpenType, const wchar_t* lpszSQL, DWORD dwOptions) {
     SQLNumResultCols(m_hstmt, &nCols);
     m_nFields = nCols;
 
+    m_dwRowsFetched = 0;
+    m_dwRowsetRow = 0;
+    if ((dwOptions & CRecordset::useMultiRowFetch) && !AllocBulkColumns(this)) {
+        FreeBulkRowset(this);
+        SQLFreeHandle(SQL_HANDLE_STMT, m_hstmt);
+        m_hstmt = SQL_NULL_HSTMT;
+        return FALSE;
+    }
+
     m_bOpen = TRUE;
     m_bBOF = TRUE;
     m_bEOF = FALSE;
@@ -419,6 +845,7 @@ BOOL CRecordset::Open(UINT nOpenType, const wchar_t* lpszSQL, DWORD dwOptions) {
 }
 
 void CRecordset::Close() {
+    FreeBulkRowset(this);
     if (m_hstmt != SQL_NULL_HSTMT) {
         SQLFreeHandle(SQL_HANDLE_STMT, m_hstmt);
         m_hstmt = SQL_NULL_HSTMT;
@@ -453,6 +880,14 @@ BOOL CRecordset::IsFieldNullable(unsigned long dwField) {
 
 void CRecordset::MoveFirst() {
     if (!m_bOpen) return;
+    if (m_pBulkRowset) {
+        if (FetchBulkRowset(this, SQL_FETCH_FIRST, 0) != 0) {
+            m_bBOF = FALSE;
+            m_bEOF = FALSE;
+            m_nAbsolutePosition = 1;
+        }
+        return;
+    }
     if (SQLFetchScroll(m_hstmt, SQL_FETCH_FIRST, 0) == SQL_SUCCESS) {
         m_bBOF = FALSE;
         m_bEOF = FALSE;
@@ -462,14 +897,34 @@ void CRecordset::MoveFirst() {
 
 void CRecordset::MoveLast() {
     if (!m_bOpen) return;
+    if (m_pBulkRowset) {
+        if (FetchBulkRowset(this, SQL_FETCH_LAST, 0) != 0) {
+            m_bBOF = FALSE;
+            m_bEOF = FALSE;
+        }
+        return;
+    }
     if (SQLFetchScroll(m_hstmt, SQL_FETCH_LAST, 0) == SQL_SUCCESS) {
         m_bBOF = FALSE;
         m_bEOF = FALSE;
     }
 }
 
+// With useMultiRowFetch, as in MFC, MoveNext and MovePrev fetch the whole
+// next or prior rowset and leave the cursor on its first row;
+// m_nAbsolutePosition tracks that row. MoveNextRow / MovePrevRow step
+// through the fetched rowset instead.
 void CRecordset::MoveNext() {
     if (!m_bOpen || m_bEOF) return;
+    if (m_pBulkRowset) {
+        const long nNextStart = m_dwRowsFetched != 0 ? BulkRowsetStart(this) + static_cast<long>(m_dwRowsFetched) : 1;
+        m_bBOF = FALSE;
+        m_nAbsolutePosition = nNextStart;
+        if (FetchBulkRowset(this, SQL_FETCH_NEXT, 0) == 0) {
+            m_bEOF = TRUE;   // m_nAbsolutePosition is now one past the last row
+        }
+        return;
+    }
     RETCODE rc = SQLFetchScroll(m_hstmt, SQL_FETCH_NEXT, 0);
     if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
         m_bBOF = FALSE;
@@ -481,6 +936,20 @@ void CRecordset::MoveNext() {
 
 void CRecordset::MovePrev() {
     if (!m_bOpen || m_bBOF) return;
+    if (m_pBulkRowset) {
+        // SQL_FETCH_PRIOR returns the rowset ending just before the current
+        // one (or, past the end, the last rowset), clipped to start at row 1.
+        const long nFrom = m_bEOF ? m_nAbsolutePosition : BulkRowsetStart(this);
+        const long nPriorStart = std::max(1L, nFrom - static_cast<long>(m_pBulkRowset->nRowsetSize));
+        m_bEOF = FALSE;
+        if (FetchBulkRowset(this, SQL_FETCH_PRIOR, 0) == 0) {
+            m_bBOF = TRUE;
+            m_nAbsolutePosition = 0;
+            return;
+        }
+        m_nAbsolutePosition = nPriorStart;
+        return;
+    }
     RETCODE rc = SQLFetchScroll(m_hstmt, SQL_FETCH_PRIOR, 0);
     if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
         m_bEOF = FALSE;
@@ -490,8 +959,58 @@ void CRecordset::MovePrev() {
     }
 }
 
+// Opt-in row-at-a-time walk over a bulk rowset: the cursor moves to the next
+// element of the RFX_*_Bulk arrays and the next rowset is fetched only once
+// the current one is used up. Without useMultiRowFetch this is MoveNext.
+void CRecordset::MoveNextRow() {
+    if (!m_bOpen || m_bEOF) return;
+    if (!m_pBulkRowset || m_dwRowsetRow + 1 >= m_dwRowsFetched) {
+        MoveNext();
+        return;
+    }
+    ++m_dwRowsetRow;
+    ++m_nAbsolutePosition;
+}
+
+// Steps back one row; at the start of the rowset it fetches the prior rowset
+// and lands on the row just before the old rowset's first.
+void CRecordset::MovePrevRow() {
+    if (!m_bOpen || m_bBOF) return;
+    if (!m_pBulkRowset) {
+        MovePrev();
+        return;
+    }
+    if (!m_bEOF && m_dwRowsetRow > 0) {
+        --m_dwRowsetRow;
+        --m_nAbsolutePosition;
+        return;
+    }
+    const long nTarget = (m_bEOF ? m_nAbsolutePosition : BulkRowsetStart(this)) - 1;
+    MovePrev();
+    if (m_bBOF) return;
+    const long nRow = nTarget - m_nAbsolutePosition;
+    m_dwRowsetRow = nRow >= 0 && nRow < static_cast<long>(m_dwRowsFetched) ? static_cast<DWORD>(nRow)
+                                                                           : m_dwRowsFetched - 1;
+    m_nAbsolutePosition += static_cast<long>(m_dwRowsetRow);
+}
+
 void CRecordset::Move(long nRows, WORD wFetchType) {
     if (!m_bOpen) return;
+    if (m_pBulkRowset) {
+        switch (wFetchType) {
+        case SQL_FETCH_NEXT: MoveNext(); return;
+        case SQL_FETCH_PRIOR: MovePrev(); return;
+        case SQL_FETCH_FIRST: MoveFirst(); return;
+        case SQL_FETCH_LAST: MoveLast(); return;
+        }
+        const long nStart = wFetchType == SQL_FETCH_RELATIVE ? BulkRowsetStart(this) + nRows : nRows;
+        if (FetchBulkRowset(this, static_cast<SQLSMALLINT>(wFetchType), nRows) != 0) {
+            m_bBOF = FALSE;
+            m_bEOF = FALSE;
+            if (nStart > 0) m_nAbsolutePosition = nStart;
+        }
+        return;
+    }
     SQLFetchScroll(m_hstmt, wFetchType, nRows);
 }
 
@@ -556,8 +1075,18 @@ BOOL CRecordset::CanUpdate() const {
     return TRUE;
 }
 
+// Takes effect at Open. On a recordset already open with useMultiRowFetch
+// the arrays are reallocated and refetched so the current row stays current.
 void CRecordset::SetRowsetSize(DWORD dwNewRowsetSize) {
+    if (dwNewRowsetSize == m_dwRowsetSize) return;
     m_dwRowsetSize = dwNewRowsetSize;
+    if (!m_bOpen || !m_pBulkRowset) return;
+    const DWORD dwRow = m_dwRowsetRow;
+    const bool bHadRows = m_dwRowsFetched != 0;
+    if (!AllocBulkColumns(this)) return;
+    if (bHadRows) {
+        FetchBulkRowset(this, SQL_FETCH_RELATIVE, static_cast<SQLLEN>(dwRow));
+    }
 }
 
 CString CRecordset::GetDefaultConnect() {
@@ -572,6 +1101,10 @@ void CRecordset::DoFieldExchange(CFieldExchange* pFX) {
     (void)pFX;
 }
 
+void CRecordset::DoBulkFieldExchange(CFieldExchange* pFX) {
+    (void)pFX;
+}
+
 BOOL CRecordset::OnSetOptions(HSTMT hstmt) {
     (void)hstmt;
     return TRUE;
@@ -722,6 +1255,8 @@ extern "C" int MS_ABI impl__Requery_CRecordset__UEAAHXZ(CRecordset* pThis) {
         return FALSE;
     }
 
+    pThis->m_dwRowsFetched = 0;
+    pThis->m_dwRowsetRow = 0;
     rc = SQLExecute(pThis->GetHSTMT());
     if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
         return TRUE;
@@ -928,6 +1463,40 @@ extern "C" void MS_ABI impl__VerifyConnect_CDatabase__IEAAXXZ(CDatabase* pThis)
     if (pThis && pThis->m_hdbc == SQL_NULL_HDBC) pThis->m_bOpen = FALSE;
 }
 
+// OpenMFC extensions (statement cache and parameter batches), not in the MFC
+// ordinal map: build_phase4.sh adds these to the .def file.
+// Symbol: ?ExecuteSQLBatch@CDatabase@@QEAAHPEB_WPEBUParamArray@1@HKPEAK@Z
+extern "C" int MS_ABI impl__ExecuteSQLBatch_CDatabase__QEAAHPEB_WPEBUParamArray_1_HKPEAK_Z(
+    CDatabase* pThis, const wchar_t* lpszSQL, const CDatabase::ParamArray* pParams, int nParams, DWORD nRows,
+    DWORD* pRowsProcessed) {
+    return pThis ? pThis->ExecuteSQLBatch(lpszSQL, pParams, nParams, nRows, pRowsProcessed) : FALSE;
+}
+
+// Symbol: ?SetStatementCacheSize@CDatabase@@QEAAXH@Z
+extern "C" void MS_ABI impl__SetStatementCacheSize_CDatabase__QEAAXH_Z(CDatabase* pThis, int nStatements) {
+    if (pThis) pThis->SetStatementCacheSize(nStatements);
+}
+
+// Symbol: ?GetStatementCacheSize@CDatabase@@QEBAHXZ
+extern "C" int MS_ABI impl__GetStatementCacheSize_CDatabase__QEBAHXZ(const CDatabase* pThis) {
+    return pThis ? pThis->GetStatementCacheSize() : 0;
+}
+
+// Symbol: ?GetStatementCacheHits@CDatabase@@QEBAKXZ
+extern "C" DWORD MS_ABI impl__GetStatementCacheHits_CDatabase__QEBAKXZ(const CDatabase* pThis) {
+    return pThis ? pThis->GetStatementCacheHits() : 0;
+}
+
+// Symbol: ?GetStatementCacheMisses@CDatabase@@QEBAKXZ
+extern "C" DWORD MS_ABI impl__GetStatementCacheMisses_CDatabase__QEBAKXZ(const CDatabase* pThis) {
+    return pThis ? pThis->GetStatementCacheMisses() : 0;
+}
+
+// Symbol: ?FlushStatementCache@CDatabase@@QEAAXXZ
+extern "C" void MS_ABI impl__FlushStatementCache_CDatabase__QEAAXXZ(CDatabase* pThis) {
+    if (pThis) pThis->FlushStatementCache();
+}
+
 // Symbol: ?GetLongBinarySize@CFieldExchange@@QEAA_JH@Z
 extern "C" long long MS_ABI impl__GetLongBinarySize_CFieldExchange__QEAA_JH_Z(CFieldExchange*, int) {
     return 0;
@@ -984,9 +1553,17 @@ extern "C" void MS_ABI impl__AllocDataCache_CRecordset__QEAAXXZ(CRecordset* pThi
 // Symbol: ?FreeDataCache@CRecordset@@QEAAXXZ
 extern "C" void MS_ABI impl__FreeDataCache_CRecordset__QEAAXXZ(CRecordset* pThis) { if (pThis) EnsureRecordsetState(pThis).dataCache.clear(); }
 // Symbol: ?AllocRowset@CRecordset@@IEAAXXZ
-extern "C" void MS_ABI impl__AllocRowset_CRecordset__IEAAXXZ(CRecordset* pThis) { if (pThis) EnsureRecordsetState(pThis).rowsetAllocated = true; }
+extern "C" void MS_ABI impl__AllocRowset_CRecordset__IEAAXXZ(CRecordset* pThis) {
+    if (!pThis) return;
+    EnsureRecordsetState(pThis).rowsetAllocated =
+        !(pThis->m_dwOptions & CRecordset::useMultiRowFetch) || AllocBulkColumns(pThis);
+}
 // Symbol: ?FreeRowset@CRecordset@@IEAAXXZ
-extern "C" void MS_ABI impl__FreeRowset_CRecordset__IEAAXXZ(CRecordset* pThis) { if (pThis) EnsureRecordsetState(pThis).rowsetAllocated = false; }
+extern "C" void MS_ABI impl__FreeRowset_CRecordset__IEAAXXZ(CRecordset* pThis) {
+    if (!pThis) return;
+    FreeBulkColumns(pThis);
+    EnsureRecordsetState(pThis).rowsetAllocated = false;
+}
 // Symbol: ?AllocStatusArrays@CRecordset@@QEAAXXZ
 extern "C" void MS_ABI impl__AllocStatusArrays_CRecordset__QEAAXXZ(CRecordset* pThis) { if (pThis) EnsureRecordsetState(pThis).fieldLengths.resize(static_cast<size_t>(std::max(0, pThis->m_nFields))); }
 
@@ -1082,7 +1659,7 @@ extern "C" int MS_ABI impl__IsFieldStatusNull_CRecordset__QEBAHK_Z(const CRecord
 // Symbol: ?IsParamStatusNull@CRecordset@@QEBAHK@Z
 extern "C" int MS_ABI impl__IsParamStatusNull_CRecordset__QEBAHK_Z(const CRecordset* pThis, unsigned long param) { return pThis && g_recordsetStates[pThis].nullParams.count(param) ? TRUE : FALSE; }
 // Symbol: ?DoBulkFieldExchange@CRecordset@@UEAAXPEAVCFieldExchange@@@Z
-extern "C" void MS_ABI impl__DoBulkFieldExchange_CRecordset__UEAAXPEAVCFieldExchange___Z(CRecordset* pThis, CFieldExchange* fx) { if (pThis) pThis->DoFieldExchange(fx); }
+extern "C" void MS_ABI impl__DoBulkFieldExchange_CRecordset__UEAAXPEAVCFieldExchange___Z(CRecordset* pThis, CFieldExchange* fx) { if (pThis) pThis->CRecordset::DoBulkFieldExchange(fx); }
 // Symbol: ?ExecuteSetPosUpdate@CRecordset@@IEAAXXZ
 extern "C" void MS_ABI impl__ExecuteSetPosUpdate_CRecordset__IEAAXXZ(CRecordset* pThis) { if (pThis) pThis->Update(); }
 // Symbol: ?ExecuteUpdateSQL@CRecordset@@IEAAXXZ
@@ -1092,7 +1669,13 @@ extern "C" short MS_ABI impl__FetchData_CRecordset__QEAAFGJPEA_K_Z(CRecordset* p
     if (rowsFetched) *rowsFetched = 0;
     if (!pThis || pThis->m_hstmt == SQL_NULL_HSTMT) return SQL_ERROR;
     RETCODE rc = SQLFetchScroll(pThis->m_hstmt, fetchType, row);
-    if (SqlSucceeded(rc) && rowsFetched) *rowsFetched = 1;
+    if (pThis->m_pBulkRowset) {
+        pThis->m_dwRowsFetched = SqlSucceeded(rc) ? static_cast<DWORD>(pThis->m_pBulkRowset->nRowsFetched) : 0;
+        pThis->m_dwRowsetRow = 0;
+        if (rowsFetched) *rowsFetched = pThis->m_dwRowsFetched;
+    } else if (SqlSucceeded(rc) && rowsFetched) {
+        *rowsFetched = 1;
+    }
     return rc;
 }
 // Symbol: ?FindSQLToken@CRecordset@@SAPEB_WPEB_W0@Z
@@ -1198,9 +1781,22 @@ extern "C" void MS_ABI impl__SetLockingMode_CRecordset__QEAAXI_Z(CRecordset* pTh
 // Symbol: ?SetRowsetCurrencyStatus@CRecordset@@UEAAXFGJ_K@Z
 extern "C" void MS_ABI impl__SetRowsetCurrencyStatus_CRecordset__UEAAXFGJ_K_Z(CRecordset*, short, unsigned short, long, unsigned long long) {}
 // Symbol: ?SetRowsetCursorPosition@CRecordset@@QEAAXGG@Z
-extern "C" void MS_ABI impl__SetRowsetCursorPosition_CRecordset__QEAAXGG_Z(CRecordset* pThis, unsigned short fetchType, unsigned short row) { if (pThis && pThis->m_hstmt!=SQL_NULL_HSTMT) SQLFetchScroll(pThis->m_hstmt, fetchType, row); }
+extern "C" void MS_ABI impl__SetRowsetCursorPosition_CRecordset__QEAAXGG_Z(CRecordset* pThis, unsigned short row, unsigned short lockType) {
+    if (!pThis || pThis->m_hstmt == SQL_NULL_HSTMT || row == 0) return;
+    if (pThis->m_pBulkRowset && row > pThis->m_dwRowsFetched) return;
+    if (SqlSucceeded(SQLSetPos(pThis->m_hstmt, row, SQL_POSITION, lockType)) && pThis->m_pBulkRowset) {
+        pThis->m_nAbsolutePosition += static_cast<long>(row - 1) - static_cast<long>(pThis->m_dwRowsetRow);
+        pThis->m_dwRowsetRow = row - 1u;
+    }
+}
 // Symbol: ?SetState@CRecordset@@IEAAXHPEB_WK@Z
 extern "C" void MS_ABI impl__SetState_CRecordset__IEAAXHPEB_WK_Z(CRecordset* pThis, int open, const wchar_t* sql, unsigned long options) { if (pThis) { pThis->m_bOpen=open; pThis->m_dwOptions=options; if (sql) StoreSql(pThis,CString(sql)); } }
+// OpenMFC extensions, not in the MFC ordinal map: build_phase4.sh adds these
+// two to the .def file.
+// Symbol: ?MoveNextRow@CRecordset@@QEAAXXZ
+extern "C" void MS_ABI impl__MoveNextRow_CRecordset__QEAAXXZ(CRecordset* pThis) { if (pThis) pThis->MoveNextRow(); }
+// Symbol: ?MovePrevRow@CRecordset@@QEAAXXZ
+extern "C" void MS_ABI impl__MovePrevRow_CRecordset__QEAAXXZ(CRecordset* pThis) { if (pThis) pThis->MovePrevRow(); }
 // Symbol: ?SetUpdateMethod@CRecordset@@IEAAXXZ
 extern "C" void MS_ABI impl__SetUpdateMethod_CRecordset__IEAAXXZ(CRecordset* pThis) { if (pThis) EnsureRecordsetState(pThis).updatePrepared=true; }
 // Symbol: ?SkipDeletedRecords@CRecordset@@QEAAXGJPEA_KPEAF@Z
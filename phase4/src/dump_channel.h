@@ -0,0 +1,200 @@
+#pragma once
+
+// Buffered output channel behind AfxDump and CDumpContext(nullptr)
+// (memcore.cpp, global_cdumpcontext.cpp).
+//
+// Dump code writes many small fragments: a label, a number, a separator.
+// Sending each one to OutputDebugStringW costs a debugger round trip, so a
+// 1e5-element array dump made hundreds of thousands of them. The channel
+// collects fragments and hands the sink whole lines:
+//
+//   Immediate - every fragment goes straight through (the old behaviour).
+//   Line      - one sink write per completed line, or per fragment that
+//               completes several. This is the default: output still appears
+//               as each line ends.
+//   Block     - whole lines, written only when the buffer fills, on Flush,
+//               or at process exit.
+//
+// Applications redirect the channel and pick the policy through the
+// AfxSetDumpOutput / AfxSetDumpFlushPolicy / AfxFlushDump exports (afx.h,
+// memcore.cpp). Redirecting flushes what the old sink was owed first.
+
+#include <cstddef>
+#include <cstdlib>
+#include <cwchar>
+#include <mutex>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace openmfc_dump {
+
+class DumpSink {
+public:
+    virtual ~DumpSink() {}
+    // text[length] is always L'\0'.
+    virtual void Write(const wchar_t* text, size_t length) = 0;
+    virtual void Flush() {}
+};
+
+enum class FlushPolicy { Immediate, Line, Block };
+
+class DumpChannel {
+public:
+    static const size_t kBufferChars = 4096;
+
+    explicit DumpChannel(DumpSink* pSink, FlushPolicy policy = FlushPolicy::Line)
+        : m_pSink(pSink), m_policy(policy) {
+        m_buffer.reserve(kBufferChars);
+    }
+
+    ~DumpChannel() { Flush(); }
+
+    DumpChannel(const DumpChannel&) = delete;
+    DumpChannel& operator=(const DumpChannel&) = delete;
+
+    void Write(const wchar_t* text) {
+        if (text) Write(text, std::wcslen(text), true);
+    }
+
+    void Write(const wchar_t* text, size_t length) { Write(text, length, false); }
+
+    // Writes everything buffered, including a partial line, and flushes the sink.
+    void Flush() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_pSink) return;
+        EmitBufferLocked(m_buffer.size());
+        m_pSink->Flush();
+    }
+
+    // Returns the previous sink, which has been flushed.
+    DumpSink* SetSink(DumpSink* pSink) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        DumpSink* pOld = m_pSink;
+        if (pOld) {
+            EmitBufferLocked(m_buffer.size());
+            pOld->Flush();
+        }
+        m_buffer.clear();
+        m_pSink = pSink;
+        return pOld;
+    }
+
+    FlushPolicy GetPolicy() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_policy;
+    }
+
+    FlushPolicy SetPolicy(FlushPolicy policy) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const FlushPolicy old = m_policy;
+        if (m_pSink && policy == FlushPolicy::Immediate) EmitBufferLocked(m_buffer.size());
+        else if (m_pSink && policy == FlushPolicy::Line) EmitLinesLocked();
+        m_policy = policy;
+        return old;
+    }
+
+private:
+    void Write(const wchar_t* text, size_t length, bool bTerminated) {
+        if (!text || length == 0) return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_pSink) return;
+        if (m_policy == FlushPolicy::Immediate) {
+            EmitLocked(text, length, bTerminated);
+            return;
+        }
+        if (m_buffer.size() + length > kBufferChars) {
+            EmitLinesLocked();
+            if (m_buffer.size() + length > kBufferChars) {
+                // One line longer than the buffer: let it out in pieces.
+                EmitBufferLocked(m_buffer.size());
+                if (length > kBufferChars) {
+                    EmitLocked(text, length, bTerminated);
+                    return;
+                }
+            }
+        }
+        m_buffer.append(text, length);
+        if (m_policy == FlushPolicy::Line && std::wmemchr(text, L'\n', length)) {
+            EmitLinesLocked();
+        }
+    }
+
+    void EmitLocked(const wchar_t* text, size_t length, bool bTerminated) {
+        if (bTerminated) {
+            m_pSink->Write(text, length);
+        } else {
+            const std::wstring copy(text, length);
+            m_pSink->Write(copy.c_str(), length);
+        }
+    }
+
+    // Writes m_buffer[0, count) as one sink call and drops it.
+    void EmitBufferLocked(size_t count) {
+        if (count == 0) return;
+        const wchar_t saved = m_buffer[count];    // L'\0' when count == size()
+        m_buffer[count] = L'\0';
+        m_pSink->Write(m_buffer.c_str(), count);
+        m_buffer[count] = saved;
+        m_buffer.erase(0, count);
+    }
+
+    // Writes every completed line; a trailing partial line stays buffered.
+    void EmitLinesLocked() {
+        const size_t lastNewline = m_buffer.rfind(L'\n');
+        if (lastNewline != std::wstring::npos) {
+            EmitBufferLocked(lastNewline + 1);
+        }
+    }
+
+    std::mutex m_mutex;
+    DumpSink* m_pSink;
+    FlushPolicy m_policy;
+    std::wstring m_buffer;
+};
+
+// Hands each write to an application callback (AfxSetDumpOutput).
+class CallbackSink : public DumpSink {
+public:
+    typedef void (*OutputProc)(const wchar_t* text, size_t length, void* pContext);
+
+    CallbackSink(OutputProc pfnOutput, void* pContext) : m_pfnOutput(pfnOutput), m_pContext(pContext) {}
+    void Write(const wchar_t* text, size_t length) override { m_pfnOutput(text, length, m_pContext); }
+
+private:
+    OutputProc m_pfnOutput;
+    void* m_pContext;
+};
+
+#ifdef _WIN32
+// The default destination: the debugger.
+class DebuggerSink : public DumpSink {
+public:
+    void Write(const wchar_t* text, size_t) override { ::OutputDebugStringW(text); }
+};
+
+inline void FlushDebugChannelAtExit();
+
+// Process-wide channel for AfxDump and CDumpContext(nullptr). Never
+// destroyed, so dumps from other static destructors stay safe; an atexit
+// hook writes out what Block mode is still holding.
+inline DebuggerSink& DefaultDebugSink() {
+    static DebuggerSink sink;
+    return sink;
+}
+
+inline DumpChannel& DebugChannel() {
+    static DumpChannel* pChannel = [] {
+        DumpChannel* pNew = new DumpChannel(&DefaultDebugSink());
+        std::atexit(FlushDebugChannelAtExit);
+        return pNew;
+    }();
+    return *pChannel;
+}
+
+inline void FlushDebugChannelAtExit() { DebugChannel().Flush(); }
+#endif
+
+} // namespace openmfc_dump
@@ -22,13 +22,20 @@
 //
 // Repo layout target (NOT retail mfc140u.dll):
 //   CFile     sizeof = 24  : [vptr@0][void* m_hFile@8][CString m_strFileName@16]
-//   CMemFile  sizeof = 56  : + BYTE* m_lpBuffer@24, UINT m_nBufferSize@32,
-//                              UINT m_nFileSize@36, UINT m_nGrowBytes@40,
-//                              UINT m_nPosition@44, bool m_bAutoDelete@48 (pad)
-//   CSharedFile sizeof = 72: + HGLOBAL m_hGlobalMemory@56, UINT m_nAllocFlags@64
+//   CMemFile  sizeof = 88  : + BYTE* m_lpBuffer@24, SIZE_T m_nBufferSize@32,
+//                              SIZE_T m_nFileSize@40, SIZE_T m_nGrowBytes@48,
+//                              SIZE_T m_nPosition@56, bool m_bAutoDelete@64,
+//                              bool m_bReserved@65 (pad), SIZE_T m_nMaxGrowBytes@72,
+//                              SIZE_T m_nReservedSize@80
+//   CSharedFile sizeof = 104: + HGLOBAL m_hGlobalMemory@88, UINT m_nAllocFlags@96,
+//                              UINT m_nOwnGrowBytes@100 (was padding)
 //
-// All allocation goes through the GlobalAlloc family so that Detach() / SetHandle()
-// can hand back a usable HGLOBAL, matching real CSharedFile semantics.
+// Blocks from Alloc / Realloc / SetHandle belong to m_hGlobalMemory, not to
+// CMemFile. CMemFile::GrowBuffer grows with realloc, so SetHandle sets
+// m_nGrowBytes to 0 to keep the block fixed size; m_nOwnGrowBytes holds the
+// file's own step for when the block is detached. A file that started empty
+// and was grown by Write holds a malloc buffer instead; Detach copies it into
+// a global block so the caller always gets a usable HGLOBAL.
 // =============================================================================
 class CSharedFile : public CMemFile {
 public:
@@ -51,10 +58,11 @@ protected:
 public:
     HGLOBAL m_hGlobalMemory;
     UINT m_nAllocFlags;
+    UINT m_nOwnGrowBytes;   // m_nGrowBytes while no SetHandle block is installed
 };
 
 // Confirm the repo-targeted layout at compile time.
-static_assert(sizeof(CSharedFile) == 72, "CSharedFile must be 72 bytes (repo CMemFile family layout)");
+static_assert(sizeof(CSharedFile) == 104, "CSharedFile must be 104 bytes (repo CMemFile family layout)");
 
 // Accessor to reach CSharedFile's protected virtual-override entry points from
 // the extern "C" thunks (mirrors CMemFileAccessor in filecore.cpp).
@@ -78,19 +86,20 @@ struct CSharedFileAccessor : CSharedFile {
 // -----------------------------------------------------------------------------
 
 CSharedFile::CSharedFile(UINT nAllocFlags, UINT nGrowBytes)
-    : CMemFile(nGrowBytes), m_hGlobalMemory(nullptr), m_nAllocFlags(nAllocFlags)
+    : CMemFile(nGrowBytes), m_hGlobalMemory(nullptr), m_nAllocFlags(nAllocFlags),
+      m_nOwnGrowBytes(nGrowBytes)
 {
 }
 
 CSharedFile::~CSharedFile()
 {
-    // If the file still owns a global block, release it through Free() so the
-    // GlobalAlloc/GlobalFree pairing stays consistent. CMemFile's destructor
-    // would otherwise call free() on a GlobalLock pointer, which is wrong, so
-    // detach the CMemFile buffer bookkeeping first.
-    if (m_bAutoDelete && m_lpBuffer) {
-        Free(m_lpBuffer);
+    // A global block goes back through Free() so the GlobalAlloc/GlobalFree
+    // pairing stays consistent; a malloc buffer grown by Write is left for
+    // CMemFile's destructor.
+    if (!m_hGlobalMemory) {
+        return;
     }
+    Free(m_lpBuffer);
     m_lpBuffer = nullptr;
     m_nBufferSize = 0;
     m_nFileSize = 0;
@@ -167,12 +176,23 @@ HGLOBAL CSharedFile::Detach()
     HGLOBAL hMem = m_hGlobalMemory;
     if (hMem && m_lpBuffer) {
         ::GlobalUnlock(hMem);
+    } else if (!hMem && m_lpBuffer) {
+        hMem = ::GlobalAlloc(m_nAllocFlags, m_nFileSize ? m_nFileSize : 1);
+        void* pDest = hMem ? ::GlobalLock(hMem) : nullptr;
+        if (!pDest) {
+            if (hMem) ::GlobalFree(hMem);
+            return nullptr;
+        }
+        std::memcpy(pDest, m_lpBuffer, m_nFileSize);
+        ::GlobalUnlock(hMem);
+        FreeBuffer();
     }
     m_hGlobalMemory = nullptr;
     m_lpBuffer = nullptr;
     m_nBufferSize = 0;
     m_nFileSize = 0;
     m_nPosition = 0;
+    m_nGrowBytes = m_nOwnGrowBytes;
     m_bAutoDelete = false;
     return hMem;
 }
@@ -181,17 +201,23 @@ HGLOBAL CSharedFile::Detach()
 void CSharedFile::SetHandle(HGLOBAL hGlobalMemory, BOOL bAllowGrow)
 {
     // Release any block we currently own.
-    if (m_bAutoDelete && m_lpBuffer) {
+    if (m_hGlobalMemory) {
         Free(m_lpBuffer);
+    } else {
+        FreeBuffer();
     }
 
     m_hGlobalMemory = hGlobalMemory;
     SIZE_T nSize = hGlobalMemory ? ::GlobalSize(hGlobalMemory) : 0;
     m_lpBuffer = hGlobalMemory ? reinterpret_cast<BYTE*>(::GlobalLock(hGlobalMemory)) : nullptr;
-    m_nBufferSize = static_cast<UINT>(nSize);
-    m_nFileSize = static_cast<UINT>(nSize);
+    m_nBufferSize = nSize;
+    m_nFileSize = nSize;
     m_nPosition = 0;
-    m_bAutoDelete = bAllowGrow ? true : false;
+    // The handle is the caller's GlobalAlloc block: it is freed with the file
+    // but never realloc'd, so writes past its size throw whatever bAllowGrow.
+    (void)bAllowGrow;
+    m_nGrowBytes = hGlobalMemory ? 0 : m_nOwnGrowBytes;
+    m_bAutoDelete = false;
 }
 
 // =============================================================================
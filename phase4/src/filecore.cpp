@@ -4,9 +4,11 @@
 
 #define OPENMFC_APPCORE_IMPL
 #include "openmfc/afx.h"
+#include "archive_object_map.h"
 #include <windows.h>
 #include <algorithm>
 #include <cstring>
+#include <cwchar>
 #include <cstdlib>
 #include <cstdio>
 #include <cerrno>
@@ -14,9 +16,7 @@
 #include <io.h>
 #include <limits>
 #include <memory>
-#include <mutex>
 #include <type_traits>
-#include <unordered_map>
 #include <vector>
 
 // MS ABI calling convention
@@ -35,6 +35,7 @@ void                MS_ABI OpenMFC_File_Write(CFile*, const void*, unsigned int)
 unsigned long long  MS_ABI OpenMFC_File_Seek(CFile*, long long, unsigned int);
 unsigned long long  MS_ABI OpenMFC_File_GetLength(CFile*);
 void                MS_ABI OpenMFC_File_Flush(CFile*);
+unsigned int        MS_ABI OpenMFC_File_GetBufferPtr(CFile*, unsigned int, unsigned int, void**, void**);
 }
 
 extern "C" CRuntimeClass* MS_ABI impl__Load_CRuntimeClass__SAPEAU1_AEAVCArchive__PEAI_Z(
@@ -46,234 +47,701 @@ extern "C" void MS_ABI impl__Store_CRuntimeClass__QEBAXAEAVCArchive___Z(
     CArchive* ar
 );
 
+// CPlex block allocator (collections_cplex.cpp). The element area of a block
+// starts immediately after its 8-byte chain header.
+extern "C" CPlex* MS_ABI impl__Create_CPlex__SAPEAU1_AEAPEAU1__K1_Z(
+    CPlex** ppHead,
+    unsigned long long nMax,
+    unsigned long long cbElement
+);
+extern "C" void MS_ABI impl__FreeDataChain_CPlex__QEAAXXZ(CPlex* pThis);
+
 namespace {
 
-std::mutex g_collectionStateMutex;
+static INT_PTR ClampCollectionBlockSize(INT_PTR value) {
+    if (value <= 0) return 10;
+    if (value > std::numeric_limits<int>::max()) return std::numeric_limits<int>::max();
+    return value;
+}
 
-template<typename Wrapper, typename State>
-using CollectionStateMap = std::unordered_map<const Wrapper*, State>;
+static CString NormalizeStringKey(const wchar_t* key) {
+    return CString(key ? key : L"");
+}
 
-template<typename Wrapper, typename State>
-CollectionStateMap<Wrapper, State>& GetCollectionStates() {
-    static CollectionStateMap<Wrapper, State> states;
-    return states;
+static UINT HashStringKey(const wchar_t* key) {
+    UINT hash = 0;
+    while (*key) {
+        hash = (hash << 5) + hash + static_cast<UINT>(*key++);
+    }
+    return hash;
 }
 
-template<typename Wrapper, typename State, typename... Args>
-State& EnsureCollectionState(const Wrapper* self, Args&&... args) {
-    auto& states = GetCollectionStates<Wrapper, State>();
-    auto it = states.find(self);
-    if (it == states.end()) {
-        it = states.emplace(self, State(std::forward<Args>(args)...)).first;
+// ---------------------------------------------------------------------------
+// Inline collection storage
+//
+// Every other non-template collection keeps its contents in its own retail
+// member block (afx.h), where MFC keeps them: arrays own one malloc'd element
+// vector, lists and maps carve nodes out of CPlex blocks and recycle them
+// through a free list. As in MFC, a collection is not internally
+// synchronized; threads sharing one must lock around it themselves.
+// ---------------------------------------------------------------------------
+
+static void* PlexData(CPlex* pBlock) {
+    return reinterpret_cast<BYTE*>(pBlock) + sizeof(void*);
+}
+
+// Elements are the MFC collection element types: scalars, pointers and
+// CString. Scalars are zero-filled like MFC's ConstructElements; CString is a
+// single pointer to its own heap block, so every element type may be moved
+// with memmove/realloc and only construction and destruction need to run.
+template<typename TYPE>
+void ConstructCollectionElements(TYPE* pElements, INT_PTR nCount) {
+    if constexpr (std::is_trivially_copyable<TYPE>::value) {
+        std::memset(static_cast<void*>(pElements), 0, static_cast<size_t>(nCount) * sizeof(TYPE));
+    } else {
+        for (; nCount > 0; --nCount, ++pElements) {
+            new (static_cast<void*>(pElements)) TYPE();
+        }
     }
-    return it->second;
 }
 
-template<typename Wrapper, typename State>
-State* FindCollectionState(const Wrapper* self) {
-    auto& states = GetCollectionStates<Wrapper, State>();
-    auto it = states.find(self);
-    return it == states.end() ? nullptr : &it->second;
+template<typename TYPE>
+void DestructCollectionElements(TYPE* pElements, INT_PTR nCount) {
+    if constexpr (!std::is_trivially_destructible<TYPE>::value) {
+        for (; nCount > 0; --nCount, ++pElements) {
+            pElements->~TYPE();
+        }
+    }
 }
 
-template<typename Wrapper, typename State>
-void RemoveCollectionState(const Wrapper* self) {
-    GetCollectionStates<Wrapper, State>().erase(self);
+template<typename TYPE>
+void CopyCollectionElements(TYPE* pDest, const TYPE* pSrc, INT_PTR nCount) {
+    if constexpr (std::is_trivially_copyable<TYPE>::value) {
+        std::memmove(pDest, pSrc, static_cast<size_t>(nCount) * sizeof(TYPE));
+    } else {
+        for (; nCount > 0; --nCount) {
+            *pDest++ = *pSrc++;
+        }
+    }
 }
 
-template<typename TYPE, typename ARG_TYPE>
-struct ArrayWrapperState {
-    CArray<TYPE, ARG_TYPE> data;
-};
+template<typename TYPE>
+void MoveCollectionElements(TYPE* pDest, TYPE* pSrc, INT_PTR nCount) {
+    std::memmove(static_cast<void*>(pDest), static_cast<const void*>(pSrc), static_cast<size_t>(nCount) * sizeof(TYPE));
+}
 
-template<typename TYPE, typename ARG_TYPE>
-struct ListWrapperState {
-    explicit ListWrapperState(int nBlockSize = 10) : data(nBlockSize) {}
-    CList<TYPE, ARG_TYPE> data;
-};
+// View over an array wrapper's m_pData/m_nSize/m_nMaxSize/m_nGrowBy. The
+// mutators return false (leaving the array untouched) when memory runs out.
+template<typename TYPE>
+struct InlineArray {
+    TYPE*& m_pData;
+    INT_PTR& m_nSize;
+    INT_PTR& m_nMaxSize;
+    INT_PTR& m_nGrowBy;
 
-template<typename KEY, typename ARG_KEY, typename VALUE, typename ARG_VALUE>
-struct MapWrapperState {
-    explicit MapWrapperState(int nBlockSize = 10) : data(nBlockSize) {}
-    CMap<KEY, ARG_KEY, VALUE, ARG_VALUE> data;
-};
+    bool SetSize(INT_PTR nNewSize, INT_PTR nGrowBy = -1) {
+        if (nGrowBy >= 0) {
+            m_nGrowBy = nGrowBy;
+        }
+        if (nNewSize <= 0) {
+            DestructCollectionElements(m_pData, m_nSize);
+            std::free(m_pData);
+            m_pData = nullptr;
+            m_nSize = m_nMaxSize = 0;
+            return true;
+        }
+        if (nNewSize <= m_nMaxSize) {
+            if (nNewSize > m_nSize) {
+                ConstructCollectionElements(m_pData + m_nSize, nNewSize - m_nSize);
+            } else {
+                DestructCollectionElements(m_pData + nNewSize, m_nSize - nNewSize);
+            }
+            m_nSize = nNewSize;
+            return true;
+        }
 
-template<typename VALUE, typename ARG_VALUE>
-struct CStringKeyMapState {
-    explicit CStringKeyMapState(int nBlockSize = 10) : data(nBlockSize) {}
-    CMap<CString, const CString&, VALUE, ARG_VALUE> data;
-    CString lookupKeyScratch;
-};
+        // MFC growth: the first allocation is max(nNewSize, m_nGrowBy); later
+        // ones grow by m_nGrowBy, or by size/8 clamped to [4, 1024] when unset.
+        INT_PTR nNewMax;
+        if (m_pData == nullptr) {
+            nNewMax = std::max(nNewSize, m_nGrowBy);
+        } else {
+            INT_PTR nGrow = m_nGrowBy;
+            if (nGrow == 0) {
+                nGrow = std::min<INT_PTR>(1024, std::max<INT_PTR>(4, m_nSize / 8));
+            }
+            nNewMax = std::max(nNewSize, m_nMaxSize + nGrow);
+        }
+        if (static_cast<size_t>(nNewMax) > std::numeric_limits<size_t>::max() / sizeof(TYPE)) {
+            return false;
+        }
+        void* pNewData = std::realloc(static_cast<void*>(m_pData), static_cast<size_t>(nNewMax) * sizeof(TYPE));
+        if (!pNewData) {
+            return false;
+        }
+        m_pData = static_cast<TYPE*>(pNewData);
+        ConstructCollectionElements(m_pData + m_nSize, nNewSize - m_nSize);
+        m_nSize = nNewSize;
+        m_nMaxSize = nNewMax;
+        return true;
+    }
 
-static int ClampCollectionSize(INT_PTR value) {
-    if (value <= 0) return 0;
-    if (value > std::numeric_limits<int>::max()) return std::numeric_limits<int>::max();
-    return static_cast<int>(value);
-}
+    void FreeExtra() {
+        if (m_nSize == m_nMaxSize) {
+            return;
+        }
+        if (m_nSize == 0) {
+            std::free(m_pData);
+            m_pData = nullptr;
+            m_nMaxSize = 0;
+            return;
+        }
+        void* pNewData = std::realloc(static_cast<void*>(m_pData), static_cast<size_t>(m_nSize) * sizeof(TYPE));
+        if (pNewData) {
+            m_pData = static_cast<TYPE*>(pNewData);
+            m_nMaxSize = m_nSize;
+        }
+    }
 
-static int ClampCollectionGrow(INT_PTR value) {
-    if (value < -1) return -1;
-    if (value > std::numeric_limits<int>::max()) return std::numeric_limits<int>::max();
-    return static_cast<int>(value);
-}
+    void SetAtGrow(INT_PTR nIndex, const TYPE& newElement) {
+        if (nIndex < 0) {
+            return;
+        }
+        if (nIndex < m_nSize) {
+            m_pData[nIndex] = newElement;
+            return;
+        }
+        // newElement may live in this array; take it before the block moves.
+        TYPE value(newElement);
+        if (SetSize(nIndex + 1)) {
+            m_pData[nIndex] = value;
+        }
+    }
 
-static int ClampCollectionBlockSize(INT_PTR value) {
-    if (value <= 0) return 10;
-    if (value > std::numeric_limits<int>::max()) return std::numeric_limits<int>::max();
-    return static_cast<int>(value);
-}
+    INT_PTR Add(const TYPE& newElement) {
+        if (m_nSize < m_nMaxSize) {
+            new (static_cast<void*>(m_pData + m_nSize)) TYPE(newElement);
+            return m_nSize++;
+        }
+        INT_PTR nIndex = m_nSize;
+        SetAtGrow(nIndex, newElement);
+        return nIndex;
+    }
 
-static CString NormalizeStringKey(const wchar_t* key) {
-    return CString(key ? key : L"");
-}
+    INT_PTR Append(const TYPE* pSrc, INT_PTR nSrc) {
+        INT_PTR nOldSize = m_nSize;
+        bool bSelf = pSrc == m_pData;
+        if (nSrc <= 0 || !SetSize(nOldSize + nSrc)) {
+            return nOldSize;
+        }
+        CopyCollectionElements(m_pData + nOldSize, bSelf ? m_pData : pSrc, nSrc);
+        return nOldSize;
+    }
 
-template<typename T>
-const T& CollectionConstRef(T& value) {
-    return value;
-}
+    void Copy(const TYPE* pSrc, INT_PTR nSrc) {
+        if (pSrc == m_pData || !SetSize(nSrc)) {
+            return;
+        }
+        CopyCollectionElements(m_pData, pSrc, nSrc);
+    }
 
-template<typename T>
-const T*& CollectionConstRef(T*& value) {
-    static thread_local const T* snapshot = nullptr;
-    snapshot = value;
-    return snapshot;
-}
+    // Opens nCount default-constructed slots at nIndex, as MFC's InsertAt does
+    // before filling them.
+    bool InsertEmpty(INT_PTR nIndex, INT_PTR nCount) {
+        if (nIndex < 0 || nCount <= 0) {
+            return false;
+        }
+        if (nIndex >= m_nSize) {
+            return SetSize(nIndex + nCount);
+        }
+        INT_PTR nOldSize = m_nSize;
+        if (!SetSize(m_nSize + nCount)) {
+            return false;
+        }
+        DestructCollectionElements(m_pData + nOldSize, nCount);
+        MoveCollectionElements(m_pData + nIndex + nCount, m_pData + nIndex, nOldSize - nIndex);
+        ConstructCollectionElements(m_pData + nIndex, nCount);
+        return true;
+    }
 
-template<typename T>
-const T* CollectionConstData(T* data) {
-    return data;
-}
+    void InsertAt(INT_PTR nIndex, const TYPE& newElement, INT_PTR nCount) {
+        TYPE value(newElement);
+        if (!InsertEmpty(nIndex, nCount)) {
+            return;
+        }
+        for (INT_PTR i = 0; i < nCount; ++i) {
+            m_pData[nIndex + i] = value;
+        }
+    }
 
-template<typename T>
-const T** CollectionConstData(T** data) {
-    return (const T**)data;
-}
+    void InsertAt(INT_PTR nStartIndex, const TYPE* pSrc, INT_PTR nSrc) {
+        if (pSrc == m_pData || nSrc <= 0 || !InsertEmpty(nStartIndex, nSrc)) {
+            return;
+        }
+        CopyCollectionElements(m_pData + nStartIndex, pSrc, nSrc);
+    }
 
-static UINT HashCStringKey(const CString& key) {
-    UINT hash = 0;
-    const wchar_t* p = static_cast<const wchar_t*>(key);
-    while (*p) {
-        hash = (hash << 5) + hash + static_cast<UINT>(*p++);
+    void RemoveAt(INT_PTR nIndex, INT_PTR nCount) {
+        if (nIndex < 0 || nCount <= 0 || nIndex > m_nSize - nCount) {
+            return;
+        }
+        DestructCollectionElements(m_pData + nIndex, nCount);
+        MoveCollectionElements(m_pData + nIndex, m_pData + nIndex + nCount, m_nSize - (nIndex + nCount));
+        m_nSize -= nCount;
     }
-    return hash;
-}
 
-struct CStringMapStringState {
-    explicit CStringMapStringState(int nBlockSize = 10) : data(nBlockSize) {}
+    void Serialize(CArchive& ar) {
+        if (ar.IsStoring()) {
+            ar.WriteCount(static_cast<DWORD_PTR>(m_nSize));
+            SerializeElements(ar, m_pData, static_cast<int>(m_nSize));
+        } else {
+            const DWORD_PTR nSize = ar.ReadCount();
+            if (SetSize(static_cast<INT_PTR>(nSize))) {
+                SerializeElements(ar, m_pData, static_cast<int>(nSize));
+            }
+        }
+    }
+};
+
+// View over a list wrapper's node block. NODE is the wrapper's CNode.
+template<typename NODE>
+struct InlineList {
+    NODE*& m_pNodeHead;
+    NODE*& m_pNodeTail;
+    INT_PTR& m_nCount;
+    NODE*& m_pNodeFree;
+    CPlex*& m_pBlocks;
+    INT_PTR& m_nBlockSize;
+
+    NODE* NewNode(NODE* pPrev, NODE* pNext) {
+        if (m_pNodeFree == nullptr) {
+            CPlex* pBlock = impl__Create_CPlex__SAPEAU1_AEAPEAU1__K1_Z(
+                &m_pBlocks, static_cast<unsigned long long>(m_nBlockSize), sizeof(NODE));
+            if (!pBlock) {
+                return nullptr;
+            }
+            // Chain in reverse so nodes are handed out in address order.
+            NODE* pNode = static_cast<NODE*>(PlexData(pBlock)) + m_nBlockSize - 1;
+            for (INT_PTR i = m_nBlockSize - 1; i >= 0; --i, --pNode) {
+                pNode->pNext = m_pNodeFree;
+                m_pNodeFree = pNode;
+            }
+        }
+        NODE* pNode = m_pNodeFree;
+        m_pNodeFree = m_pNodeFree->pNext;
+        pNode->pPrev = pPrev;
+        pNode->pNext = pNext;
+        ConstructCollectionElements(&pNode->data, 1);
+        m_nCount++;
+        return pNode;
+    }
+
+    // The node must already be unlinked. Like MFC, the blocks go back to the
+    // heap as soon as the list drains.
+    void FreeNode(NODE* pNode) {
+        DestructCollectionElements(&pNode->data, 1);
+        pNode->pNext = m_pNodeFree;
+        m_pNodeFree = pNode;
+        m_nCount--;
+        if (m_nCount == 0) {
+            RemoveAll();
+        }
+    }
+
+    void RemoveAll() {
+        for (NODE* pNode = m_pNodeHead; pNode; pNode = pNode->pNext) {
+            DestructCollectionElements(&pNode->data, 1);
+        }
+        m_nCount = 0;
+        m_pNodeHead = m_pNodeTail = m_pNodeFree = nullptr;
+        if (m_pBlocks) {
+            impl__FreeDataChain_CPlex__QEAAXXZ(m_pBlocks);
+            m_pBlocks = nullptr;
+        }
+    }
 
-    void MarkDirty() { pairsDirty = true; }
+    template<typename ARG>
+    NODE* AddHead(const ARG& newElement) {
+        NODE* pNewNode = NewNode(nullptr, m_pNodeHead);
+        if (!pNewNode) {
+            return nullptr;
+        }
+        pNewNode->data = newElement;
+        if (m_pNodeHead) {
+            m_pNodeHead->pPrev = pNewNode;
+        } else {
+            m_pNodeTail = pNewNode;
+        }
+        m_pNodeHead = pNewNode;
+        return pNewNode;
+    }
+
+    template<typename ARG>
+    NODE* AddTail(const ARG& newElement) {
+        NODE* pNewNode = NewNode(m_pNodeTail, nullptr);
+        if (!pNewNode) {
+            return nullptr;
+        }
+        pNewNode->data = newElement;
+        if (m_pNodeTail) {
+            m_pNodeTail->pNext = pNewNode;
+        } else {
+            m_pNodeHead = pNewNode;
+        }
+        m_pNodeTail = pNewNode;
+        return pNewNode;
+    }
 
-    void EnsurePairs() {
-        if (!pairsDirty) {
+    template<typename ARG>
+    NODE* InsertBefore(NODE* pOldNode, const ARG& newElement) {
+        if (!pOldNode) {
+            return AddHead(newElement);
+        }
+        NODE* pNewNode = NewNode(pOldNode->pPrev, pOldNode);
+        if (!pNewNode) {
+            return nullptr;
+        }
+        pNewNode->data = newElement;
+        if (pOldNode->pPrev) {
+            pOldNode->pPrev->pNext = pNewNode;
+        } else {
+            m_pNodeHead = pNewNode;
+        }
+        pOldNode->pPrev = pNewNode;
+        return pNewNode;
+    }
+
+    template<typename ARG>
+    NODE* InsertAfter(NODE* pOldNode, const ARG& newElement) {
+        if (!pOldNode) {
+            return AddTail(newElement);
+        }
+        NODE* pNewNode = NewNode(pOldNode, pOldNode->pNext);
+        if (!pNewNode) {
+            return nullptr;
+        }
+        pNewNode->data = newElement;
+        if (pOldNode->pNext) {
+            pOldNode->pNext->pPrev = pNewNode;
+        } else {
+            m_pNodeTail = pNewNode;
+        }
+        pOldNode->pNext = pNewNode;
+        return pNewNode;
+    }
+
+    void RemoveAt(NODE* pOldNode) {
+        if (!pOldNode) {
             return;
         }
-        pairs.clear();
-        CMapStringToString::CPair* previous = nullptr;
-        auto pos = data.GetStartPosition();
-        while (pos != CMapStringToString::POSITION(nullptr, 0)) {
-            CString key;
-            CString value;
-            data.GetNextAssoc(pos, key, value);
-            auto pair = std::make_unique<CMapStringToString::CPair>();
-            pair->pNextAssoc = nullptr;
-            pair->nHashValue = HashCStringKey(key);
-            pair->key = key;
-            pair->value = value;
-            CMapStringToString::CPair* raw = pair.get();
-            if (previous) {
-                previous->pNextAssoc = raw;
-            }
-            pairs.push_back(std::move(pair));
-            previous = raw;
+        if (pOldNode == m_pNodeHead) {
+            m_pNodeHead = pOldNode->pNext;
+        } else {
+            pOldNode->pPrev->pNext = pOldNode->pNext;
         }
-        pairsDirty = false;
+        if (pOldNode == m_pNodeTail) {
+            m_pNodeTail = pOldNode->pPrev;
+        } else {
+            pOldNode->pNext->pPrev = pOldNode->pPrev;
+        }
+        FreeNode(pOldNode);
     }
 
-    CMapStringToString::CPair* PLookup(const wchar_t* key) {
-        EnsurePairs();
-        CString lookup = NormalizeStringKey(key);
-        for (const auto& pair : pairs) {
-            if (pair->key == lookup) {
-                return pair.get();
-            }
+    decltype(NODE::data) RemoveHead() {
+        if (!m_pNodeHead) {
+            return decltype(NODE::data)();
         }
-        return nullptr;
+        decltype(NODE::data) value = m_pNodeHead->data;
+        RemoveAt(m_pNodeHead);
+        return value;
     }
 
-    const CMapStringToString::CPair* PLookup(const wchar_t* key) const {
-        return const_cast<CStringMapStringState*>(this)->PLookup(key);
+    decltype(NODE::data) RemoveTail() {
+        if (!m_pNodeTail) {
+            return decltype(NODE::data)();
+        }
+        decltype(NODE::data) value = m_pNodeTail->data;
+        RemoveAt(m_pNodeTail);
+        return value;
     }
 
-    CMap<CString, const CString&, CString, const CString&> data;
-    CString lookupKeyScratch;
-    std::vector<std::unique_ptr<CMapStringToString::CPair>> pairs;
-    bool pairsDirty = true;
+    void Serialize(CArchive& ar) {
+        if (ar.IsStoring()) {
+            ar.WriteCount(static_cast<DWORD_PTR>(m_nCount));
+            for (NODE* pNode = m_pNodeHead; pNode; pNode = pNode->pNext) {
+                ar << pNode->data;
+            }
+        } else {
+            const DWORD_PTR nCount = ar.ReadCount();
+            RemoveAll();
+            for (DWORD_PTR i = 0; i < nCount; ++i) {
+                decltype(NODE::data) value{};
+                ar >> value;
+                AddTail(value);
+            }
+        }
+    }
 };
 
-template<typename Wrapper, typename TYPE, typename ARG_TYPE>
-static CArray<TYPE, ARG_TYPE>& EnsureArrayStorage(const Wrapper* self) {
-    return EnsureCollectionState<Wrapper, ArrayWrapperState<TYPE, ARG_TYPE>>(self).data;
+template<typename NODE>
+NODE* FindListIndex(NODE* pNodeHead, INT_PTR nCount, INT_PTR nIndex) {
+    if (nIndex < 0 || nIndex >= nCount) {
+        return nullptr;
+    }
+    NODE* pNode = pNodeHead;
+    while (nIndex--) {
+        pNode = pNode->pNext;
+    }
+    return pNode;
+}
+
+template<typename NODE, typename ARG>
+NODE* FindListValue(NODE* pNodeHead, const ARG& searchValue, NODE* pStartAfter) {
+    for (NODE* pNode = pStartAfter ? pStartAfter->pNext : pNodeHead; pNode; pNode = pNode->pNext) {
+        if (pNode->data == searchValue) {
+            return pNode;
+        }
+    }
+    return nullptr;
+}
+
+// The wrapper POSITIONs are the CList/CMap template ones; their node pointer
+// is only an opaque cursor, so the wrappers' own nodes travel in it.
+template<typename POS, typename NODE>
+POS MakeListPosition(NODE* pNode) {
+    return POS(reinterpret_cast<decltype(POS().pNode)>(pNode));
 }
 
-template<typename Wrapper, typename TYPE, typename ARG_TYPE>
-static const CArray<TYPE, ARG_TYPE>* FindArrayStorage(const Wrapper* self) {
-    const auto* state = FindCollectionState<Wrapper, ArrayWrapperState<TYPE, ARG_TYPE>>(self);
-    return state ? &state->data : nullptr;
+template<typename NODE, typename POS>
+NODE* ListPositionNode(const POS& pos) {
+    return reinterpret_cast<NODE*>(pos.pNode);
 }
 
-template<typename Wrapper, typename TYPE, typename ARG_TYPE>
-static CList<TYPE, ARG_TYPE>& EnsureListStorage(const Wrapper* self, int nBlockSize = 10) {
-    return EnsureCollectionState<Wrapper, ListWrapperState<TYPE, ARG_TYPE>>(self, ClampCollectionBlockSize(nBlockSize)).data;
+static UINT CollectionHashKey(void* key) {
+    return static_cast<UINT>(reinterpret_cast<uintptr_t>(key) >> 4);
 }
 
-template<typename Wrapper, typename TYPE, typename ARG_TYPE>
-static const CList<TYPE, ARG_TYPE>* FindListStorage(const Wrapper* self) {
-    const auto* state = FindCollectionState<Wrapper, ListWrapperState<TYPE, ARG_TYPE>>(self);
-    return state ? &state->data : nullptr;
+static UINT CollectionHashKey(WORD key) {
+    return static_cast<UINT>(key) >> 4;
 }
 
-template<typename Wrapper, typename KEY, typename ARG_KEY, typename VALUE, typename ARG_VALUE>
-static CMap<KEY, ARG_KEY, VALUE, ARG_VALUE>& EnsureMapStorage(const Wrapper* self, int nBlockSize = 10) {
-    return EnsureCollectionState<Wrapper, MapWrapperState<KEY, ARG_KEY, VALUE, ARG_VALUE>>(self, ClampCollectionBlockSize(nBlockSize)).data;
+static UINT CollectionHashKey(const wchar_t* key) {
+    return HashStringKey(key);
 }
 
-template<typename Wrapper, typename KEY, typename ARG_KEY, typename VALUE, typename ARG_VALUE>
-static const CMap<KEY, ARG_KEY, VALUE, ARG_VALUE>* FindMapStorage(const Wrapper* self) {
-    const auto* state = FindCollectionState<Wrapper, MapWrapperState<KEY, ARG_KEY, VALUE, ARG_VALUE>>(self);
-    return state ? &state->data : nullptr;
+template<typename KEY, typename ARG_KEY>
+bool CollectionKeysEqual(const KEY& storedKey, const ARG_KEY& key) {
+    return storedKey == key;
 }
 
-template<typename Wrapper, typename VALUE, typename ARG_VALUE>
-static CStringKeyMapState<VALUE, ARG_VALUE>& EnsureCStringKeyMapStorage(const Wrapper* self, int nBlockSize = 10) {
-    return EnsureCollectionState<Wrapper, CStringKeyMapState<VALUE, ARG_VALUE>>(self, ClampCollectionBlockSize(nBlockSize));
+static bool CollectionKeysEqual(const CString& storedKey, const wchar_t* key) {
+    return std::wcscmp(storedKey, key) == 0;
 }
 
-template<typename Wrapper, typename VALUE, typename ARG_VALUE>
-static const CStringKeyMapState<VALUE, ARG_VALUE>* FindCStringKeyMapStorage(const Wrapper* self) {
-    return FindCollectionState<Wrapper, CStringKeyMapState<VALUE, ARG_VALUE>>(self);
+template<typename ASSOC, typename ARG_KEY>
+ASSOC* FindCollectionAssoc(ASSOC* const* pHashTable, UINT nHashTableSize, ARG_KEY key,
+                           UINT& nHashBucket, UINT& nHashValue) {
+    nHashValue = CollectionHashKey(key);
+    nHashBucket = nHashValue % nHashTableSize;
+    if (!pHashTable) {
+        return nullptr;
+    }
+    ASSOC* const* ppChain = openmfc_maphash::HomeChain(pHashTable, nHashTableSize, nHashValue);
+    for (ASSOC* pAssoc = *ppChain; pAssoc; pAssoc = pAssoc->pNext) {
+        if (pAssoc->nHashValue == nHashValue && CollectionKeysEqual(pAssoc->key, key)) {
+            return pAssoc;
+        }
+    }
+    return nullptr;
 }
 
-static CStringMapStringState& EnsureCStringMapStringStorage(const CMapStringToString* self, int nBlockSize = 10) {
-    return EnsureCollectionState<CMapStringToString, CStringMapStringState>(self, ClampCollectionBlockSize(nBlockSize));
+template<typename POS, typename ASSOC>
+POS MakeMapPosition(ASSOC* pAssoc, UINT nHashBucket) {
+    return POS(reinterpret_cast<decltype(POS().pAssoc)>(pAssoc), nHashBucket);
 }
 
-static const CStringMapStringState* FindCStringMapStringStorage(const CMapStringToString* self) {
-    return FindCollectionState<CMapStringToString, CStringMapStringState>(self);
+template<typename POS, typename ASSOC>
+POS MapStartPosition(ASSOC* const* pHashTable, UINT nHashTableSize, INT_PTR nCount) {
+    if (nCount == 0 || !pHashTable) {
+        return POS();
+    }
+    UINT nCursor = 0;
+    ASSOC* pAssoc = openmfc_maphash::FirstAssoc(pHashTable, nHashTableSize, nCursor);
+    return pAssoc ? MakeMapPosition<POS>(pAssoc, nCursor) : POS();
 }
 
-template<typename KEY, typename VALUE>
-struct AssocSnapshot {
-    AssocSnapshot* pNext = nullptr;
-    UINT nHashValue = 0;
-    KEY key{};
-    VALUE value{};
-};
+// Returns the assoc at rNextPosition and advances it, MFC-style: the bucket
+// is recomputed from the assoc's hash rather than trusted from the cursor.
+template<typename ASSOC, typename POS>
+ASSOC* MapNextAssoc(ASSOC* const* pHashTable, UINT nHashTableSize, POS& rNextPosition) {
+    ASSOC* pAssoc = reinterpret_cast<ASSOC*>(rNextPosition.pAssoc);
+    if (!pAssoc || !pHashTable) {
+        rNextPosition = POS();
+        return nullptr;
+    }
+    UINT nCursor = 0;
+    ASSOC* pNext = openmfc_maphash::NextAssoc(pHashTable, nHashTableSize, pAssoc, nCursor);
+    rNextPosition = pNext ? MakeMapPosition<POS>(pNext, nCursor) : POS();
+    return pAssoc;
+}
+
+// View over a map wrapper's hash table and assoc block. ASSOC is the
+// wrapper's CAssoc. Bucket arrays come from openmfc_maphash, so a map that
+// opted in with EnableAutoRehash grows (incrementally) with its count.
+template<typename ASSOC>
+struct InlineMap {
+    ASSOC**& m_pHashTable;
+    UINT& m_nHashTableSize;
+    INT_PTR& m_nCount;
+    ASSOC*& m_pFreeList;
+    CPlex*& m_pBlocks;
+    INT_PTR& m_nBlockSize;
+
+    void InitHashTable(UINT nHashSize, bool bAllocNow) {
+        if (nHashSize == 0) {
+            return;
+        }
+        const bool bAutoGrow = openmfc_maphash::AutoGrows(m_pHashTable);
+        if (m_nCount != 0) {
+            RemoveAll();
+        }
+        openmfc_maphash::FreeTable(m_pHashTable);
+        m_pHashTable = nullptr;
+        if (bAllocNow || bAutoGrow) {
+            m_pHashTable = openmfc_maphash::AllocTable<ASSOC>(nHashSize, bAutoGrow);
+        }
+        m_nHashTableSize = nHashSize;
+    }
+
+    ASSOC* NewAssoc() {
+        if (m_pFreeList == nullptr) {
+            CPlex* pBlock = impl__Create_CPlex__SAPEAU1_AEAPEAU1__K1_Z(
+                &m_pBlocks, static_cast<unsigned long long>(m_nBlockSize), sizeof(ASSOC));
+            if (!pBlock) {
+                return nullptr;
+            }
+            ASSOC* pAssoc = static_cast<ASSOC*>(PlexData(pBlock)) + m_nBlockSize - 1;
+            for (INT_PTR i = m_nBlockSize - 1; i >= 0; --i, --pAssoc) {
+                pAssoc->pNext = m_pFreeList;
+                m_pFreeList = pAssoc;
+            }
+        }
+        ASSOC* pAssoc = m_pFreeList;
+        m_pFreeList = m_pFreeList->pNext;
+        ConstructCollectionElements(&pAssoc->key, 1);
+        ConstructCollectionElements(&pAssoc->value, 1);
+        m_nCount++;
+        return pAssoc;
+    }
+
+    // The assoc must already be unlinked from its bucket.
+    void FreeAssoc(ASSOC* pAssoc) {
+        DestructCollectionElements(&pAssoc->key, 1);
+        DestructCollectionElements(&pAssoc->value, 1);
+        pAssoc->pNext = m_pFreeList;
+        m_pFreeList = pAssoc;
+        m_nCount--;
+        if (m_nCount == 0) {
+            RemoveAll();
+        }
+    }
+
+    void RemoveAll() {
+        if (m_pHashTable) {
+            UINT nCursor = 0;
+            for (ASSOC* pAssoc = openmfc_maphash::FirstAssoc(m_pHashTable, m_nHashTableSize, nCursor); pAssoc;
+                 pAssoc = openmfc_maphash::NextAssoc(m_pHashTable, m_nHashTableSize, pAssoc, nCursor)) {
+                DestructCollectionElements(&pAssoc->key, 1);
+                DestructCollectionElements(&pAssoc->value, 1);
+            }
+            if (openmfc_maphash::AutoGrows(m_pHashTable)) {
+                // The emptied array carries the EnableAutoRehash setting.
+                openmfc_maphash::ClearTable(m_pHashTable, m_nHashTableSize);
+            } else {
+                openmfc_maphash::FreeTable(m_pHashTable);
+                m_pHashTable = nullptr;
+            }
+        }
+        m_nCount = 0;
+        m_pFreeList = nullptr;
+        if (m_pBlocks) {
+            impl__FreeDataChain_CPlex__QEAAXXZ(m_pBlocks);
+            m_pBlocks = nullptr;
+        }
+    }
+
+    // Finds key, inserting a default-valued assoc for it when absent.
+    template<typename ARG_KEY>
+    ASSOC* Assoc(ARG_KEY key) {
+        UINT nHashBucket = 0;
+        UINT nHashValue = 0;
+        ASSOC* pAssoc = FindCollectionAssoc(m_pHashTable, m_nHashTableSize, key, nHashBucket, nHashValue);
+        if (pAssoc) {
+            return pAssoc;
+        }
+        if (!m_pHashTable) {
+            InitHashTable(m_nHashTableSize, true);
+            if (!m_pHashTable) {
+                return nullptr;
+            }
+        }
+        pAssoc = NewAssoc();
+        if (!pAssoc) {
+            return nullptr;
+        }
+        pAssoc->nHashValue = nHashValue;
+        pAssoc->key = key;
+        ASSOC** ppChain = openmfc_maphash::HomeChain(m_pHashTable, m_nHashTableSize, nHashValue);
+        pAssoc->pNext = *ppChain;
+        *ppChain = pAssoc;
+        openmfc_maphash::AfterInsert(m_pHashTable, m_nHashTableSize, m_nCount);
+        return pAssoc;
+    }
+
+    template<typename ARG_KEY>
+    bool RemoveKey(ARG_KEY key) {
+        if (!m_pHashTable) {
+            return false;
+        }
+        UINT nHashValue = CollectionHashKey(key);
+        ASSOC** ppAssocPrev = openmfc_maphash::HomeChain(m_pHashTable, m_nHashTableSize, nHashValue);
+        for (ASSOC* pAssoc = *ppAssocPrev; pAssoc; pAssoc = pAssoc->pNext) {
+            if (pAssoc->nHashValue == nHashValue && CollectionKeysEqual(pAssoc->key, key)) {
+                *ppAssocPrev = pAssoc->pNext;
+                FreeAssoc(pAssoc);
+                return true;
+            }
+            ppAssocPrev = &pAssoc->pNext;
+        }
+        return false;
+    }
 
-template<typename VALUE>
-struct ListNodeSnapshot {
-    ListNodeSnapshot* pNext = nullptr;
-    ListNodeSnapshot* pPrev = nullptr;
-    VALUE data{};
+    void Serialize(CArchive& ar) {
+        if (ar.IsStoring()) {
+            ar.WriteCount(static_cast<DWORD_PTR>(m_nCount));
+            if (!m_pHashTable) {
+                return;
+            }
+            UINT nCursor = 0;
+            for (ASSOC* pAssoc = openmfc_maphash::FirstAssoc(m_pHashTable, m_nHashTableSize, nCursor); pAssoc;
+                 pAssoc = openmfc_maphash::NextAssoc(m_pHashTable, m_nHashTableSize, pAssoc, nCursor)) {
+                ar << pAssoc->key;
+                ar << pAssoc->value;
+            }
+        } else {
+            const DWORD_PTR nCount = ar.ReadCount();
+            RemoveAll();
+            for (DWORD_PTR i = 0; i < nCount; ++i) {
+                decltype(ASSOC::key) key{};
+                decltype(ASSOC::value) value{};
+                ar >> key;
+                ar >> value;
+                if (ASSOC* pAssoc = Assoc(key)) {
+                    pAssoc->value = value;
+                }
+            }
+        }
+    }
 };
 
 } // namespace
@@ -298,396 +766,294 @@ __attribute__((used)) static CRuntimeClass g_classCWordArray = {
     "CWordArray", sizeof(CWordArray), 0xFFFF, nullptr, nullptr, &CObject::classCObject, nullptr
 };
 
+#define OPENMFC_INLINE_ARRAY(element_type) \
+    InlineArray<element_type>{m_pData, m_nSize, m_nMaxSize, m_nGrowBy}
+
 #define OPENMFC_DEFINE_ARRAY_METHODS(class_name, element_type, arg_type) \
-class_name::class_name() { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    EnsureCollectionState<class_name, ArrayWrapperState<element_type, arg_type>>(this); \
-} \
- \
-class_name::~class_name() { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    RemoveCollectionState<class_name, ArrayWrapperState<element_type, arg_type>>(this); \
-} \
- \
-INT_PTR class_name::GetSize() const { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    const auto* data = FindArrayStorage<class_name, element_type, arg_type>(this); \
-    return data ? data->GetSize() : 0; \
-} \
- \
-INT_PTR class_name::GetCount() const { \
-    return GetSize(); \
-} \
- \
-BOOL class_name::IsEmpty() const { \
-    return GetSize() == 0; \
-} \
- \
-INT_PTR class_name::GetUpperBound() const { \
-    return GetSize() - 1; \
-} \
- \
-void class_name::SetSize(INT_PTR nNewSize, INT_PTR nGrowBy) { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    EnsureArrayStorage<class_name, element_type, arg_type>(this).SetSize(ClampCollectionSize(nNewSize), ClampCollectionGrow(nGrowBy)); \
-} \
- \
-void class_name::FreeExtra() { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    EnsureArrayStorage<class_name, element_type, arg_type>(this).FreeExtra(); \
-} \
- \
-void class_name::RemoveAll() { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    EnsureArrayStorage<class_name, element_type, arg_type>(this).RemoveAll(); \
-} \
- \
-element_type class_name::GetAt(INT_PTR nIndex) const { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    const auto& data = EnsureArrayStorage<class_name, element_type, arg_type>(this); \
-    return data.GetAt(ClampCollectionSize(nIndex)); \
-} \
- \
-void class_name::SetAt(INT_PTR nIndex, arg_type newElement) { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    EnsureArrayStorage<class_name, element_type, arg_type>(this).SetAt(ClampCollectionSize(nIndex), newElement); \
-} \
- \
-element_type& class_name::ElementAt(INT_PTR nIndex) { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    return EnsureArrayStorage<class_name, element_type, arg_type>(this).ElementAt(ClampCollectionSize(nIndex)); \
-} \
- \
-const element_type& class_name::ElementAt(INT_PTR nIndex) const { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    return CollectionConstRef(EnsureArrayStorage<class_name, element_type, arg_type>(this).ElementAt(ClampCollectionSize(nIndex))); \
-} \
- \
-element_type class_name::operator[](INT_PTR nIndex) const { \
-    return GetAt(nIndex); \
-} \
- \
-element_type& class_name::operator[](INT_PTR nIndex) { \
-    return ElementAt(nIndex); \
-} \
- \
-element_type* class_name::GetData() { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    return EnsureArrayStorage<class_name, element_type, arg_type>(this).GetData(); \
-} \
- \
-const element_type* class_name::GetData() const { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    return CollectionConstData(EnsureArrayStorage<class_name, element_type, arg_type>(this).GetData()); \
-} \
- \
-void class_name::SetAtGrow(INT_PTR nIndex, arg_type newElement) { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    EnsureArrayStorage<class_name, element_type, arg_type>(this).SetAtGrow(ClampCollectionSize(nIndex), newElement); \
-} \
- \
-INT_PTR class_name::Add(arg_type newElement) { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    return EnsureArrayStorage<class_name, element_type, arg_type>(this).Add(newElement); \
-} \
- \
-INT_PTR class_name::Append(const class_name& src) { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    auto& data = EnsureArrayStorage<class_name, element_type, arg_type>(this); \
-    const auto& srcData = EnsureArrayStorage<class_name, element_type, arg_type>(&src); \
-    return data.Append(srcData); \
-} \
- \
-void class_name::Copy(const class_name& src) { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    auto& data = EnsureArrayStorage<class_name, element_type, arg_type>(this); \
-    const auto& srcData = EnsureArrayStorage<class_name, element_type, arg_type>(&src); \
-    data.Copy(srcData); \
-} \
- \
-void class_name::InsertAt(INT_PTR nIndex, arg_type newElement, INT_PTR nCount) { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    EnsureArrayStorage<class_name, element_type, arg_type>(this).InsertAt(ClampCollectionSize(nIndex), newElement, ClampCollectionSize(nCount)); \
-} \
- \
-void class_name::RemoveAt(INT_PTR nIndex, INT_PTR nCount) { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    EnsureArrayStorage<class_name, element_type, arg_type>(this).RemoveAt(ClampCollectionSize(nIndex), ClampCollectionSize(nCount)); \
-} \
- \
+class_name::class_name() : m_pData(nullptr), m_nSize(0), m_nMaxSize(0), m_nGrowBy(0) {} \
+class_name::~class_name() { OPENMFC_INLINE_ARRAY(element_type).SetSize(0); } \
+INT_PTR class_name::GetSize() const { return m_nSize; } \
+INT_PTR class_name::GetCount() const { return m_nSize; } \
+BOOL class_name::IsEmpty() const { return m_nSize == 0; } \
+INT_PTR class_name::GetUpperBound() const { return m_nSize - 1; } \
+void class_name::SetSize(INT_PTR nNewSize, INT_PTR nGrowBy) { OPENMFC_INLINE_ARRAY(element_type).SetSize(nNewSize, nGrowBy); } \
+void class_name::FreeExtra() { OPENMFC_INLINE_ARRAY(element_type).FreeExtra(); } \
+void class_name::RemoveAll() { OPENMFC_INLINE_ARRAY(element_type).SetSize(0); } \
+element_type class_name::GetAt(INT_PTR nIndex) const { return m_pData[nIndex]; } \
+void class_name::SetAt(INT_PTR nIndex, arg_type newElement) { m_pData[nIndex] = newElement; } \
+element_type& class_name::ElementAt(INT_PTR nIndex) { return m_pData[nIndex]; } \
+const element_type& class_name::ElementAt(INT_PTR nIndex) const { return (const element_type&)m_pData[nIndex]; } \
+element_type class_name::operator[](INT_PTR nIndex) const { return m_pData[nIndex]; } \
+element_type& class_name::operator[](INT_PTR nIndex) { return m_pData[nIndex]; } \
+element_type* class_name::GetData() { return m_pData; } \
+const element_type* class_name::GetData() const { return (const element_type*)m_pData; } \
+void class_name::SetAtGrow(INT_PTR nIndex, arg_type newElement) { OPENMFC_INLINE_ARRAY(element_type).SetAtGrow(nIndex, newElement); } \
+INT_PTR class_name::Add(arg_type newElement) { return OPENMFC_INLINE_ARRAY(element_type).Add(newElement); } \
+INT_PTR class_name::Append(const class_name& src) { return OPENMFC_INLINE_ARRAY(element_type).Append(src.m_pData, src.m_nSize); } \
+void class_name::Copy(const class_name& src) { OPENMFC_INLINE_ARRAY(element_type).Copy(src.m_pData, src.m_nSize); } \
+void class_name::InsertAt(INT_PTR nIndex, arg_type newElement, INT_PTR nCount) { OPENMFC_INLINE_ARRAY(element_type).InsertAt(nIndex, newElement, nCount); } \
+void class_name::RemoveAt(INT_PTR nIndex, INT_PTR nCount) { OPENMFC_INLINE_ARRAY(element_type).RemoveAt(nIndex, nCount); } \
 void class_name::InsertAt(INT_PTR nStartIndex, class_name* pNewArray) { \
     if (!pNewArray) return; \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    auto& data = EnsureArrayStorage<class_name, element_type, arg_type>(this); \
-    auto& srcData = EnsureArrayStorage<class_name, element_type, arg_type>(pNewArray); \
-    data.InsertAt(ClampCollectionSize(nStartIndex), &srcData); \
+    OPENMFC_INLINE_ARRAY(element_type).InsertAt(nStartIndex, pNewArray->m_pData, pNewArray->m_nSize); \
 } \
- \
-void class_name::Serialize(CArchive& ar) { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    auto& data = EnsureArrayStorage<class_name, element_type, arg_type>(this); \
-    if (ar.IsStoring()) ar << data; else ar >> data; \
-}
+void class_name::Serialize(CArchive& ar) { OPENMFC_INLINE_ARRAY(element_type).Serialize(ar); }
 
 OPENMFC_DEFINE_ARRAY_METHODS(CUIntArray, unsigned int, unsigned int)
 OPENMFC_DEFINE_ARRAY_METHODS(CDWordArray, DWORD, DWORD)
 OPENMFC_DEFINE_ARRAY_METHODS(CObArray, CObject*, CObject*)
 OPENMFC_DEFINE_ARRAY_METHODS(CPtrArray, void*, void*)
 OPENMFC_DEFINE_ARRAY_METHODS(CByteArray, BYTE, BYTE)
+OPENMFC_DEFINE_ARRAY_METHODS(CStringArray, CString, const CString&)
 
-CStringArray::CStringArray() {
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex);
-    EnsureCollectionState<CStringArray, ArrayWrapperState<CString, const CString&>>(this);
-}
-
-CStringArray::~CStringArray() {
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex);
-    RemoveCollectionState<CStringArray, ArrayWrapperState<CString, const CString&>>(this);
-}
-
-INT_PTR CStringArray::GetSize() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* data = FindArrayStorage<CStringArray, CString, const CString&>(this); return data ? data->GetSize() : 0; }
-INT_PTR CStringArray::GetCount() const { return GetSize(); }
-BOOL CStringArray::IsEmpty() const { return GetSize() == 0; }
-INT_PTR CStringArray::GetUpperBound() const { return GetSize() - 1; }
-void CStringArray::SetSize(INT_PTR nNewSize, INT_PTR nGrowBy) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureArrayStorage<CStringArray, CString, const CString&>(this).SetSize(ClampCollectionSize(nNewSize), ClampCollectionGrow(nGrowBy)); }
-void CStringArray::FreeExtra() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureArrayStorage<CStringArray, CString, const CString&>(this).FreeExtra(); }
-void CStringArray::RemoveAll() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureArrayStorage<CStringArray, CString, const CString&>(this).RemoveAll(); }
-CString CStringArray::GetAt(INT_PTR nIndex) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureArrayStorage<CStringArray, CString, const CString&>(this).GetAt(ClampCollectionSize(nIndex)); }
-void CStringArray::SetAt(INT_PTR nIndex, const CString& newElement) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureArrayStorage<CStringArray, CString, const CString&>(this).SetAt(ClampCollectionSize(nIndex), newElement); }
-CString& CStringArray::ElementAt(INT_PTR nIndex) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureArrayStorage<CStringArray, CString, const CString&>(this).ElementAt(ClampCollectionSize(nIndex)); }
-const CString& CStringArray::ElementAt(INT_PTR nIndex) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureArrayStorage<CStringArray, CString, const CString&>(this).ElementAt(ClampCollectionSize(nIndex)); }
-CString CStringArray::operator[](INT_PTR nIndex) const { return GetAt(nIndex); }
-CString& CStringArray::operator[](INT_PTR nIndex) { return ElementAt(nIndex); }
-CString* CStringArray::GetData() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureArrayStorage<CStringArray, CString, const CString&>(this).GetData(); }
-const CString* CStringArray::GetData() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureArrayStorage<CStringArray, CString, const CString&>(this).GetData(); }
-void CStringArray::SetAtGrow(INT_PTR nIndex, const CString& newElement) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureArrayStorage<CStringArray, CString, const CString&>(this).SetAtGrow(ClampCollectionSize(nIndex), newElement); }
 void CStringArray::SetAtGrow(INT_PTR nIndex, const wchar_t* newElement) { SetAtGrow(nIndex, NormalizeStringKey(newElement)); }
-INT_PTR CStringArray::Add(const CString& newElement) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureArrayStorage<CStringArray, CString, const CString&>(this).Add(newElement); }
-INT_PTR CStringArray::Append(const CStringArray& src) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureArrayStorage<CStringArray, CString, const CString&>(this); const auto& srcData = EnsureArrayStorage<CStringArray, CString, const CString&>(&src); return data.Append(srcData); }
-void CStringArray::Copy(const CStringArray& src) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureArrayStorage<CStringArray, CString, const CString&>(this); const auto& srcData = EnsureArrayStorage<CStringArray, CString, const CString&>(&src); data.Copy(srcData); }
-void CStringArray::InsertAt(INT_PTR nIndex, const CString& newElement, INT_PTR nCount) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureArrayStorage<CStringArray, CString, const CString&>(this).InsertAt(ClampCollectionSize(nIndex), newElement, ClampCollectionSize(nCount)); }
 void CStringArray::InsertAt(INT_PTR nIndex, const wchar_t* newElement, INT_PTR nCount) { InsertAt(nIndex, NormalizeStringKey(newElement), nCount); }
-void CStringArray::RemoveAt(INT_PTR nIndex, INT_PTR nCount) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureArrayStorage<CStringArray, CString, const CString&>(this).RemoveAt(ClampCollectionSize(nIndex), ClampCollectionSize(nCount)); }
-void CStringArray::InsertAt(INT_PTR nStartIndex, CStringArray* pNewArray) { if (!pNewArray) return; std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureArrayStorage<CStringArray, CString, const CString&>(this); auto& srcData = EnsureArrayStorage<CStringArray, CString, const CString&>(pNewArray); data.InsertAt(ClampCollectionSize(nStartIndex), &srcData); }
-void CStringArray::Serialize(CArchive& ar) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureArrayStorage<CStringArray, CString, const CString&>(this); if (ar.IsStoring()) ar << data; else ar >> data; }
-void CStringArray::InsertEmpty(INT_PTR nIndex, INT_PTR nCount) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureArrayStorage<CStringArray, CString, const CString&>(this).InsertAt(ClampCollectionSize(nIndex), CString(), ClampCollectionSize(nCount)); }
+void CStringArray::InsertEmpty(INT_PTR nIndex, INT_PTR nCount) { OPENMFC_INLINE_ARRAY(CString).InsertEmpty(nIndex, nCount); }
+
+#define OPENMFC_INLINE_LIST() \
+    InlineList<CNode>{m_pNodeHead, m_pNodeTail, m_nCount, m_pNodeFree, m_pBlocks, m_nBlockSize}
 
 #define OPENMFC_DEFINE_LIST_METHODS(class_name, element_type, arg_type) \
-class_name::class_name(INT_PTR nBlockSize) { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    EnsureCollectionState<class_name, ListWrapperState<element_type, arg_type>>(this, ClampCollectionBlockSize(nBlockSize)); \
+class_name::class_name(INT_PTR nBlockSize) \
+    : m_pNodeHead(nullptr), m_pNodeTail(nullptr), m_nCount(0), m_pNodeFree(nullptr), \
+      m_pBlocks(nullptr), m_nBlockSize(ClampCollectionBlockSize(nBlockSize)) {} \
+class_name::~class_name() { OPENMFC_INLINE_LIST().RemoveAll(); } \
+class_name::CNode* class_name::NewNode(CNode* pPrev, CNode* pNext) { return OPENMFC_INLINE_LIST().NewNode(pPrev, pNext); } \
+void class_name::FreeNode(CNode* pNode) { OPENMFC_INLINE_LIST().FreeNode(pNode); } \
+INT_PTR class_name::GetCount() const { return m_nCount; } \
+BOOL class_name::IsEmpty() const { return m_nCount == 0; } \
+element_type& class_name::GetHead() { return m_pNodeHead->data; } \
+element_type class_name::GetHead() const { return m_pNodeHead->data; } \
+element_type& class_name::GetTail() { return m_pNodeTail->data; } \
+element_type class_name::GetTail() const { return m_pNodeTail->data; } \
+class_name::POSITION class_name::GetHeadPosition() const { return MakeListPosition<POSITION>(m_pNodeHead); } \
+class_name::POSITION class_name::GetTailPosition() const { return MakeListPosition<POSITION>(m_pNodeTail); } \
+element_type& class_name::GetNext(POSITION& rPosition) { \
+    CNode* pNode = ListPositionNode<CNode>(rPosition); \
+    rPosition = MakeListPosition<POSITION>(pNode->pNext); \
+    return pNode->data; \
 } \
- \
-class_name::~class_name() { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    RemoveCollectionState<class_name, ListWrapperState<element_type, arg_type>>(this); \
+element_type class_name::GetNext(POSITION& rPosition) const { \
+    CNode* pNode = ListPositionNode<CNode>(rPosition); \
+    rPosition = MakeListPosition<POSITION>(pNode->pNext); \
+    return pNode->data; \
 } \
- \
-INT_PTR class_name::GetCount() const { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    const auto* data = FindListStorage<class_name, element_type, arg_type>(this); \
-    return data ? data->GetCount() : 0; \
+element_type& class_name::GetPrev(POSITION& rPosition) { \
+    CNode* pNode = ListPositionNode<CNode>(rPosition); \
+    rPosition = MakeListPosition<POSITION>(pNode->pPrev); \
+    return pNode->data; \
 } \
- \
-BOOL class_name::IsEmpty() const { return GetCount() == 0; } \
-element_type& class_name::GetHead() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<class_name, element_type, arg_type>(this).GetHead(); } \
-element_type class_name::GetHead() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<class_name, element_type, arg_type>(this).GetHead(); } \
-element_type& class_name::GetTail() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<class_name, element_type, arg_type>(this).GetTail(); } \
-element_type class_name::GetTail() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<class_name, element_type, arg_type>(this).GetTail(); } \
-typename class_name::POSITION class_name::GetHeadPosition() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* data = FindListStorage<class_name, element_type, arg_type>(this); return data ? data->GetHeadPosition() : POSITION(nullptr); } \
-typename class_name::POSITION class_name::GetTailPosition() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* data = FindListStorage<class_name, element_type, arg_type>(this); return data ? data->GetTailPosition() : POSITION(nullptr); } \
-element_type& class_name::GetNext(POSITION& rPosition) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<class_name, element_type, arg_type>(this).GetNext(rPosition); } \
-element_type class_name::GetNext(POSITION& rPosition) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<class_name, element_type, arg_type>(this).GetNext(rPosition); } \
-element_type& class_name::GetPrev(POSITION& rPosition) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<class_name, element_type, arg_type>(this).GetPrev(rPosition); } \
-element_type class_name::GetPrev(POSITION& rPosition) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<class_name, element_type, arg_type>(this).GetPrev(rPosition); } \
-element_type class_name::GetAt(POSITION position) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<class_name, element_type, arg_type>(this).GetAt(position); } \
-void class_name::SetAt(POSITION pos, arg_type newElement) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureListStorage<class_name, element_type, arg_type>(this).SetAt(pos, newElement); } \
-void class_name::RemoveAt(POSITION position) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureListStorage<class_name, element_type, arg_type>(this).RemoveAt(position); } \
-typename class_name::POSITION class_name::FindIndex(INT_PTR nIndex) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* data = FindListStorage<class_name, element_type, arg_type>(this); return data ? data->FindIndex(ClampCollectionSize(nIndex)) : POSITION(nullptr); } \
-typename class_name::POSITION class_name::Find(arg_type searchValue, POSITION startAfter) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* data = FindListStorage<class_name, element_type, arg_type>(this); return data ? data->Find(searchValue, startAfter) : POSITION(nullptr); } \
-typename class_name::POSITION class_name::AddHead(arg_type newElement) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureListStorage<class_name, element_type, arg_type>(this); data.AddHead(newElement); return data.GetHeadPosition(); } \
-typename class_name::POSITION class_name::AddTail(arg_type newElement) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureListStorage<class_name, element_type, arg_type>(this); data.AddTail(newElement); return data.GetTailPosition(); } \
-void class_name::AddHead(class_name* pNewList) { if (!pNewList || pNewList == this) return; std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureListStorage<class_name, element_type, arg_type>(this); auto& srcData = EnsureListStorage<class_name, element_type, arg_type>(pNewList); data.AddHead(&srcData); } \
-void class_name::AddTail(class_name* pNewList) { if (!pNewList || pNewList == this) return; std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureListStorage<class_name, element_type, arg_type>(this); auto& srcData = EnsureListStorage<class_name, element_type, arg_type>(pNewList); data.AddTail(&srcData); } \
-element_type class_name::RemoveHead() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<class_name, element_type, arg_type>(this).RemoveHead(); } \
-element_type class_name::RemoveTail() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<class_name, element_type, arg_type>(this).RemoveTail(); } \
-typename class_name::POSITION class_name::InsertBefore(POSITION position, arg_type newElement) { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    auto& data = EnsureListStorage<class_name, element_type, arg_type>(this); \
-    POSITION oldPos = position; \
-    data.InsertBefore(position, newElement); \
-    if (oldPos == POSITION(nullptr)) return data.GetTailPosition(); \
-    POSITION pos = data.GetHeadPosition(); \
-    POSITION prev(nullptr); \
-    while (pos != POSITION(nullptr) && pos != oldPos) { prev = pos; data.GetNext(pos); } \
-    return prev; \
+element_type class_name::GetPrev(POSITION& rPosition) const { \
+    CNode* pNode = ListPositionNode<CNode>(rPosition); \
+    rPosition = MakeListPosition<POSITION>(pNode->pPrev); \
+    return pNode->data; \
 } \
-typename class_name::POSITION class_name::InsertAfter(POSITION position, arg_type newElement) { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    auto& data = EnsureListStorage<class_name, element_type, arg_type>(this); \
-    POSITION oldPos = position; \
-    data.InsertAfter(position, newElement); \
-    if (oldPos == POSITION(nullptr)) return data.GetHeadPosition(); \
-    POSITION result = oldPos; \
-    data.GetNext(result); \
-    return result; \
+element_type class_name::GetAt(POSITION position) const { return ListPositionNode<CNode>(position)->data; } \
+void class_name::SetAt(POSITION pos, arg_type newElement) { ListPositionNode<CNode>(pos)->data = newElement; } \
+void class_name::RemoveAt(POSITION position) { OPENMFC_INLINE_LIST().RemoveAt(ListPositionNode<CNode>(position)); } \
+class_name::POSITION class_name::FindIndex(INT_PTR nIndex) const { return MakeListPosition<POSITION>(FindListIndex(m_pNodeHead, m_nCount, nIndex)); } \
+class_name::POSITION class_name::Find(arg_type searchValue, POSITION startAfter) const { \
+    return MakeListPosition<POSITION>(FindListValue(m_pNodeHead, searchValue, ListPositionNode<CNode>(startAfter))); \
 } \
-void class_name::RemoveAll() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureListStorage<class_name, element_type, arg_type>(this).RemoveAll(); } \
-void class_name::Serialize(CArchive& ar) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureListStorage<class_name, element_type, arg_type>(this); if (ar.IsStoring()) ar << data; else ar >> data; }
+class_name::POSITION class_name::AddHead(arg_type newElement) { return MakeListPosition<POSITION>(OPENMFC_INLINE_LIST().AddHead(newElement)); } \
+class_name::POSITION class_name::AddTail(arg_type newElement) { return MakeListPosition<POSITION>(OPENMFC_INLINE_LIST().AddTail(newElement)); } \
+void class_name::AddHead(class_name* pNewList) { \
+    if (!pNewList || pNewList == this) return; \
+    auto list = OPENMFC_INLINE_LIST(); \
+    for (CNode* pNode = pNewList->m_pNodeTail; pNode; pNode = pNode->pPrev) list.AddHead(pNode->data); \
+} \
+void class_name::AddTail(class_name* pNewList) { \
+    if (!pNewList || pNewList == this) return; \
+    auto list = OPENMFC_INLINE_LIST(); \
+    for (CNode* pNode = pNewList->m_pNodeHead; pNode; pNode = pNode->pNext) list.AddTail(pNode->data); \
+} \
+element_type class_name::RemoveHead() { return OPENMFC_INLINE_LIST().RemoveHead(); } \
+element_type class_name::RemoveTail() { return OPENMFC_INLINE_LIST().RemoveTail(); } \
+class_name::POSITION class_name::InsertBefore(POSITION position, arg_type newElement) { \
+    return MakeListPosition<POSITION>(OPENMFC_INLINE_LIST().InsertBefore(ListPositionNode<CNode>(position), newElement)); \
+} \
+class_name::POSITION class_name::InsertAfter(POSITION position, arg_type newElement) { \
+    return MakeListPosition<POSITION>(OPENMFC_INLINE_LIST().InsertAfter(ListPositionNode<CNode>(position), newElement)); \
+} \
+void class_name::RemoveAll() { OPENMFC_INLINE_LIST().RemoveAll(); } \
+void class_name::Serialize(CArchive& ar) { OPENMFC_INLINE_LIST().Serialize(ar); }
 
 OPENMFC_DEFINE_LIST_METHODS(CObList, CObject*, CObject*)
+OPENMFC_DEFINE_LIST_METHODS(CStringList, CString, const CString&)
+
+CStringList::POSITION CStringList::Find(const wchar_t* searchValue, POSITION startAfter) const {
+    return MakeListPosition<POSITION>(FindListValue(m_pNodeHead, searchValue ? searchValue : L"", ListPositionNode<CNode>(startAfter)));
+}
+CStringList::POSITION CStringList::AddHead(const wchar_t* newElement) { return MakeListPosition<POSITION>(OPENMFC_INLINE_LIST().AddHead(newElement ? newElement : L"")); }
+CStringList::POSITION CStringList::AddTail(const wchar_t* newElement) { return MakeListPosition<POSITION>(OPENMFC_INLINE_LIST().AddTail(newElement ? newElement : L"")); }
+CStringList::POSITION CStringList::InsertBefore(POSITION position, const wchar_t* newElement) {
+    return MakeListPosition<POSITION>(OPENMFC_INLINE_LIST().InsertBefore(ListPositionNode<CNode>(position), newElement ? newElement : L""));
+}
+CStringList::POSITION CStringList::InsertAfter(POSITION position, const wchar_t* newElement) {
+    return MakeListPosition<POSITION>(OPENMFC_INLINE_LIST().InsertAfter(ListPositionNode<CNode>(position), newElement ? newElement : L""));
+}
 
-CStringList::CStringList(INT_PTR nBlockSize) {
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex);
-    EnsureCollectionState<CStringList, ListWrapperState<CString, const CString&>>(this, ClampCollectionBlockSize(nBlockSize));
-}
-
-CStringList::~CStringList() {
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex);
-    RemoveCollectionState<CStringList, ListWrapperState<CString, const CString&>>(this);
-}
-
-INT_PTR CStringList::GetCount() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* data = FindListStorage<CStringList, CString, const CString&>(this); return data ? data->GetCount() : 0; }
-BOOL CStringList::IsEmpty() const { return GetCount() == 0; }
-CString& CStringList::GetHead() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<CStringList, CString, const CString&>(this).GetHead(); }
-CString CStringList::GetHead() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<CStringList, CString, const CString&>(this).GetHead(); }
-CString& CStringList::GetTail() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<CStringList, CString, const CString&>(this).GetTail(); }
-CString CStringList::GetTail() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<CStringList, CString, const CString&>(this).GetTail(); }
-CStringList::POSITION CStringList::GetHeadPosition() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* data = FindListStorage<CStringList, CString, const CString&>(this); return data ? data->GetHeadPosition() : POSITION(nullptr); }
-CStringList::POSITION CStringList::GetTailPosition() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* data = FindListStorage<CStringList, CString, const CString&>(this); return data ? data->GetTailPosition() : POSITION(nullptr); }
-CString& CStringList::GetNext(POSITION& rPosition) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<CStringList, CString, const CString&>(this).GetNext(rPosition); }
-CString CStringList::GetNext(POSITION& rPosition) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<CStringList, CString, const CString&>(this).GetNext(rPosition); }
-CString& CStringList::GetPrev(POSITION& rPosition) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<CStringList, CString, const CString&>(this).GetPrev(rPosition); }
-CString CStringList::GetPrev(POSITION& rPosition) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<CStringList, CString, const CString&>(this).GetPrev(rPosition); }
-CString CStringList::GetAt(POSITION position) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<CStringList, CString, const CString&>(this).GetAt(position); }
-void CStringList::SetAt(POSITION pos, const CString& newElement) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureListStorage<CStringList, CString, const CString&>(this).SetAt(pos, newElement); }
-void CStringList::RemoveAt(POSITION position) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureListStorage<CStringList, CString, const CString&>(this).RemoveAt(position); }
-CStringList::POSITION CStringList::FindIndex(INT_PTR nIndex) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* data = FindListStorage<CStringList, CString, const CString&>(this); return data ? data->FindIndex(ClampCollectionSize(nIndex)) : POSITION(nullptr); }
-CStringList::POSITION CStringList::Find(const CString& searchValue, POSITION startAfter) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* data = FindListStorage<CStringList, CString, const CString&>(this); return data ? data->Find(searchValue, startAfter) : POSITION(nullptr); }
-CStringList::POSITION CStringList::Find(const wchar_t* searchValue, POSITION startAfter) const { return Find(NormalizeStringKey(searchValue), startAfter); }
-CStringList::POSITION CStringList::AddHead(const CString& newElement) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureListStorage<CStringList, CString, const CString&>(this); data.AddHead(newElement); return data.GetHeadPosition(); }
-CStringList::POSITION CStringList::AddHead(const wchar_t* newElement) { return AddHead(NormalizeStringKey(newElement)); }
-void CStringList::AddHead(CStringList* pNewList) { if (!pNewList || pNewList == this) return; std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureListStorage<CStringList, CString, const CString&>(this); auto& srcData = EnsureListStorage<CStringList, CString, const CString&>(pNewList); data.AddHead(&srcData); }
-CStringList::POSITION CStringList::AddTail(const CString& newElement) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureListStorage<CStringList, CString, const CString&>(this); data.AddTail(newElement); return data.GetTailPosition(); }
-CStringList::POSITION CStringList::AddTail(const wchar_t* newElement) { return AddTail(NormalizeStringKey(newElement)); }
-void CStringList::AddTail(CStringList* pNewList) { if (!pNewList || pNewList == this) return; std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureListStorage<CStringList, CString, const CString&>(this); auto& srcData = EnsureListStorage<CStringList, CString, const CString&>(pNewList); data.AddTail(&srcData); }
-CString CStringList::RemoveHead() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<CStringList, CString, const CString&>(this).RemoveHead(); }
-CString CStringList::RemoveTail() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureListStorage<CStringList, CString, const CString&>(this).RemoveTail(); }
-CStringList::POSITION CStringList::InsertBefore(POSITION position, const CString& newElement) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureListStorage<CStringList, CString, const CString&>(this); POSITION oldPos = position; data.InsertBefore(position, newElement); if (oldPos == POSITION(nullptr)) return data.GetTailPosition(); POSITION pos = data.GetHeadPosition(); POSITION prev(nullptr); while (pos != POSITION(nullptr) && pos != oldPos) { prev = pos; data.GetNext(pos); } return prev; }
-CStringList::POSITION CStringList::InsertBefore(POSITION position, const wchar_t* newElement) { return InsertBefore(position, NormalizeStringKey(newElement)); }
-CStringList::POSITION CStringList::InsertAfter(POSITION position, const CString& newElement) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureListStorage<CStringList, CString, const CString&>(this); POSITION oldPos = position; data.InsertAfter(position, newElement); if (oldPos == POSITION(nullptr)) return data.GetHeadPosition(); POSITION result = oldPos; data.GetNext(result); return result; }
-CStringList::POSITION CStringList::InsertAfter(POSITION position, const wchar_t* newElement) { return InsertAfter(position, NormalizeStringKey(newElement)); }
-void CStringList::RemoveAll() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureListStorage<CStringList, CString, const CString&>(this).RemoveAll(); }
-void CStringList::Serialize(CArchive& ar) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureListStorage<CStringList, CString, const CString&>(this); if (ar.IsStoring()) ar << data; else ar >> data; }
+#define OPENMFC_INLINE_MAP() \
+    InlineMap<CAssoc>{m_pHashTable, m_nHashTableSize, m_nCount, m_pFreeList, m_pBlocks, m_nBlockSize}
+
+#define OPENMFC_DEFINE_MAP_COMMON(class_name, key_type, value_type) \
+class_name::class_name(INT_PTR nBlockSize) \
+    : m_pHashTable(nullptr), m_nHashTableSize(17), m_nCount(0), m_pFreeList(nullptr), \
+      m_pBlocks(nullptr), m_nBlockSize(ClampCollectionBlockSize(nBlockSize)) {} \
+class_name::~class_name() { \
+    OPENMFC_INLINE_MAP().RemoveAll(); \
+    openmfc_maphash::FreeTable(m_pHashTable); /* RemoveAll keeps an auto-rehash array */ \
+} \
+class_name::CAssoc* class_name::NewAssoc() { return OPENMFC_INLINE_MAP().NewAssoc(); } \
+void class_name::FreeAssoc(CAssoc* pAssoc) { OPENMFC_INLINE_MAP().FreeAssoc(pAssoc); } \
+INT_PTR class_name::GetCount() const { return m_nCount; } \
+BOOL class_name::IsEmpty() const { return m_nCount == 0; } \
+void class_name::RemoveAll() { OPENMFC_INLINE_MAP().RemoveAll(); } \
+class_name::POSITION class_name::GetStartPosition() const { return MapStartPosition<POSITION>(m_pHashTable, m_nHashTableSize, m_nCount); } \
+void class_name::GetNextAssoc(POSITION& rNextPosition, key_type& rKey, value_type& rValue) const { \
+    if (CAssoc* pAssoc = MapNextAssoc(m_pHashTable, m_nHashTableSize, rNextPosition)) { \
+        rKey = pAssoc->key; \
+        rValue = pAssoc->value; \
+    } \
+} \
+UINT class_name::GetHashTableSize() const { return m_nHashTableSize; } \
+void class_name::InitHashTable(UINT hashSize, BOOL bAllocNow) { OPENMFC_INLINE_MAP().InitHashTable(hashSize, bAllocNow != FALSE); } \
+void class_name::Serialize(CArchive& ar) { OPENMFC_INLINE_MAP().Serialize(ar); }
 
 #define OPENMFC_DEFINE_MAP_METHODS(class_name, key_type, arg_key_type, value_type, arg_value_type) \
-class_name::class_name(INT_PTR nBlockSize) { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    EnsureCollectionState<class_name, MapWrapperState<key_type, arg_key_type, value_type, arg_value_type>>(this, ClampCollectionBlockSize(nBlockSize)); \
+OPENMFC_DEFINE_MAP_COMMON(class_name, key_type, value_type) \
+class_name::CAssoc* class_name::GetAssocAt(arg_key_type key, UINT& nHashBucket, UINT& nHashValue) const { \
+    return FindCollectionAssoc(m_pHashTable, m_nHashTableSize, key, nHashBucket, nHashValue); \
 } \
- \
-class_name::~class_name() { \
-    std::lock_guard<std::mutex> lock(g_collectionStateMutex); \
-    RemoveCollectionState<class_name, MapWrapperState<key_type, arg_key_type, value_type, arg_value_type>>(this); \
+BOOL class_name::Lookup(arg_key_type key, value_type& rValue) const { \
+    UINT nHashBucket = 0; \
+    UINT nHashValue = 0; \
+    CAssoc* pAssoc = GetAssocAt(key, nHashBucket, nHashValue); \
+    if (!pAssoc) return FALSE; \
+    rValue = pAssoc->value; \
+    return TRUE; \
 } \
- \
-INT_PTR class_name::GetCount() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* data = FindMapStorage<class_name, key_type, arg_key_type, value_type, arg_value_type>(this); return data ? data->GetCount() : 0; } \
-BOOL class_name::IsEmpty() const { return GetCount() == 0; } \
-BOOL class_name::Lookup(arg_key_type key, value_type& rValue) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* data = FindMapStorage<class_name, key_type, arg_key_type, value_type, arg_value_type>(this); return (data && data->Lookup(key, rValue)) ? TRUE : FALSE; } \
-value_type& class_name::operator[](arg_key_type key) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureMapStorage<class_name, key_type, arg_key_type, value_type, arg_value_type>(this)[key]; } \
-const value_type& class_name::operator[](arg_key_type key) const { \
-    return CollectionConstRef(const_cast<class_name*>(this)->operator[](key)); \
+value_type& class_name::operator[](arg_key_type key) { return OPENMFC_INLINE_MAP().Assoc(key)->value; } \
+const value_type& class_name::operator[](arg_key_type key) const { return (const value_type&)const_cast<class_name*>(this)->operator[](key); } \
+void class_name::SetAt(arg_key_type key, arg_value_type newValue) { \
+    if (CAssoc* pAssoc = OPENMFC_INLINE_MAP().Assoc(key)) pAssoc->value = newValue; \
 } \
-void class_name::SetAt(arg_key_type key, arg_value_type newValue) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureMapStorage<class_name, key_type, arg_key_type, value_type, arg_value_type>(this).SetAt(key, newValue); } \
-BOOL class_name::RemoveKey(arg_key_type key) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureMapStorage<class_name, key_type, arg_key_type, value_type, arg_value_type>(this); return data.RemoveKey(key) ? TRUE : FALSE; } \
-void class_name::RemoveAll() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureMapStorage<class_name, key_type, arg_key_type, value_type, arg_value_type>(this).RemoveAll(); } \
-typename class_name::POSITION class_name::GetStartPosition() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* data = FindMapStorage<class_name, key_type, arg_key_type, value_type, arg_value_type>(this); return data ? data->GetStartPosition() : POSITION(nullptr, 0); } \
-void class_name::GetNextAssoc(POSITION& rNextPosition, key_type& rKey, value_type& rValue) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureMapStorage<class_name, key_type, arg_key_type, value_type, arg_value_type>(this).GetNextAssoc(rNextPosition, rKey, rValue); } \
-UINT class_name::GetHashTableSize() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* data = FindMapStorage<class_name, key_type, arg_key_type, value_type, arg_value_type>(this); return data ? data->GetHashTableSize() : 17; } \
-void class_name::InitHashTable(UINT hashSize, BOOL bAllocNow) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureMapStorage<class_name, key_type, arg_key_type, value_type, arg_value_type>(this).InitHashTable(hashSize, bAllocNow != FALSE); } \
-void class_name::Serialize(CArchive& ar) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& data = EnsureMapStorage<class_name, key_type, arg_key_type, value_type, arg_value_type>(this); if (ar.IsStoring()) ar << data; else ar >> data; }
+BOOL class_name::RemoveKey(arg_key_type key) { return OPENMFC_INLINE_MAP().RemoveKey(key) ? TRUE : FALSE; }
 
 OPENMFC_DEFINE_MAP_METHODS(CMapPtrToPtr, void*, void*, void*, void*)
 OPENMFC_DEFINE_MAP_METHODS(CMapPtrToWord, void*, void*, WORD, WORD)
 OPENMFC_DEFINE_MAP_METHODS(CMapWordToOb, WORD, WORD, CObject*, CObject*)
 OPENMFC_DEFINE_MAP_METHODS(CMapWordToPtr, WORD, WORD, void*, void*)
 
-CMapStringToOb::CMapStringToOb(INT_PTR nBlockSize) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureCStringKeyMapStorage<CMapStringToOb, CObject*, CObject*>(this, ClampCollectionBlockSize(nBlockSize)); }
-CMapStringToOb::~CMapStringToOb() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); RemoveCollectionState<CMapStringToOb, CStringKeyMapState<CObject*, CObject*>>(this); }
-INT_PTR CMapStringToOb::GetCount() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* state = FindCStringKeyMapStorage<CMapStringToOb, CObject*, CObject*>(this); return state ? state->data.GetCount() : 0; }
-BOOL CMapStringToOb::IsEmpty() const { return GetCount() == 0; }
-BOOL CMapStringToOb::Lookup(const CString& key, CObject*& rValue) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* state = FindCStringKeyMapStorage<CMapStringToOb, CObject*, CObject*>(this); return (state && state->data.Lookup(key, rValue)) ? TRUE : FALSE; }
-BOOL CMapStringToOb::Lookup(const wchar_t* key, CObject*& rValue) const { return Lookup(NormalizeStringKey(key), rValue); }
-BOOL CMapStringToOb::LookupKey(const CString& key, const wchar_t*& rKey) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& state = EnsureCStringKeyMapStorage<CMapStringToOb, CObject*, CObject*>(this); CString actualKey; if (!state.data.LookupKey(key, actualKey)) return FALSE; state.lookupKeyScratch = actualKey; rKey = static_cast<const wchar_t*>(state.lookupKeyScratch); return TRUE; }
-BOOL CMapStringToOb::LookupKey(const wchar_t* key, const wchar_t*& rKey) const { return LookupKey(NormalizeStringKey(key), rKey); }
-CObject*& CMapStringToOb::operator[](const CString& key) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureCStringKeyMapStorage<CMapStringToOb, CObject*, CObject*>(this).data[key]; }
-CObject*& CMapStringToOb::operator[](const wchar_t* key) { return (*this)[NormalizeStringKey(key)]; }
-const CObject* CMapStringToOb::operator[](const wchar_t* key) const { CObject* value = nullptr; Lookup(key, value); return value; }
-void CMapStringToOb::SetAt(const CString& key, CObject* newValue) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureCStringKeyMapStorage<CMapStringToOb, CObject*, CObject*>(this).data.SetAt(key, newValue); }
-void CMapStringToOb::SetAt(const wchar_t* key, CObject* newValue) { SetAt(NormalizeStringKey(key), newValue); }
-BOOL CMapStringToOb::RemoveKey(const CString& key) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& state = EnsureCStringKeyMapStorage<CMapStringToOb, CObject*, CObject*>(this); return state.data.RemoveKey(key) ? TRUE : FALSE; }
-BOOL CMapStringToOb::RemoveKey(const wchar_t* key) { return RemoveKey(NormalizeStringKey(key)); }
-void CMapStringToOb::RemoveAll() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureCStringKeyMapStorage<CMapStringToOb, CObject*, CObject*>(this).data.RemoveAll(); }
-CMapStringToOb::POSITION CMapStringToOb::GetStartPosition() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* state = FindCStringKeyMapStorage<CMapStringToOb, CObject*, CObject*>(this); return state ? state->data.GetStartPosition() : POSITION(nullptr, 0); }
-void CMapStringToOb::GetNextAssoc(POSITION& rNextPosition, CString& rKey, CObject*& rValue) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureCStringKeyMapStorage<CMapStringToOb, CObject*, CObject*>(this).data.GetNextAssoc(rNextPosition, rKey, rValue); }
-UINT CMapStringToOb::GetHashTableSize() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* state = FindCStringKeyMapStorage<CMapStringToOb, CObject*, CObject*>(this); return state ? state->data.GetHashTableSize() : 17; }
-void CMapStringToOb::InitHashTable(UINT hashSize, BOOL bAllocNow) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureCStringKeyMapStorage<CMapStringToOb, CObject*, CObject*>(this).data.InitHashTable(hashSize, bAllocNow != FALSE); }
-void CMapStringToOb::Serialize(CArchive& ar) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& state = EnsureCStringKeyMapStorage<CMapStringToOb, CObject*, CObject*>(this); if (ar.IsStoring()) ar << state.data; else ar >> state.data; }
-
-CMapStringToPtr::CMapStringToPtr(INT_PTR nBlockSize) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureCStringKeyMapStorage<CMapStringToPtr, void*, void*>(this, ClampCollectionBlockSize(nBlockSize)); }
-CMapStringToPtr::~CMapStringToPtr() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); RemoveCollectionState<CMapStringToPtr, CStringKeyMapState<void*, void*>>(this); }
-INT_PTR CMapStringToPtr::GetCount() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* state = FindCStringKeyMapStorage<CMapStringToPtr, void*, void*>(this); return state ? state->data.GetCount() : 0; }
-BOOL CMapStringToPtr::IsEmpty() const { return GetCount() == 0; }
-BOOL CMapStringToPtr::Lookup(const CString& key, void*& rValue) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* state = FindCStringKeyMapStorage<CMapStringToPtr, void*, void*>(this); return (state && state->data.Lookup(key, rValue)) ? TRUE : FALSE; }
-BOOL CMapStringToPtr::Lookup(const wchar_t* key, void*& rValue) const { return Lookup(NormalizeStringKey(key), rValue); }
-BOOL CMapStringToPtr::LookupKey(const CString& key, const wchar_t*& rKey) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& state = EnsureCStringKeyMapStorage<CMapStringToPtr, void*, void*>(this); CString actualKey; if (!state.data.LookupKey(key, actualKey)) return FALSE; state.lookupKeyScratch = actualKey; rKey = static_cast<const wchar_t*>(state.lookupKeyScratch); return TRUE; }
-BOOL CMapStringToPtr::LookupKey(const wchar_t* key, const wchar_t*& rKey) const { return LookupKey(NormalizeStringKey(key), rKey); }
-void*& CMapStringToPtr::operator[](const CString& key) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureCStringKeyMapStorage<CMapStringToPtr, void*, void*>(this).data[key]; }
-void*& CMapStringToPtr::operator[](const wchar_t* key) { return (*this)[NormalizeStringKey(key)]; }
-const void* CMapStringToPtr::operator[](const wchar_t* key) const { void* value = nullptr; Lookup(key, value); return value; }
-void CMapStringToPtr::SetAt(const CString& key, void* newValue) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureCStringKeyMapStorage<CMapStringToPtr, void*, void*>(this).data.SetAt(key, newValue); }
-void CMapStringToPtr::SetAt(const wchar_t* key, void* newValue) { SetAt(NormalizeStringKey(key), newValue); }
-BOOL CMapStringToPtr::RemoveKey(const CString& key) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& state = EnsureCStringKeyMapStorage<CMapStringToPtr, void*, void*>(this); return state.data.RemoveKey(key) ? TRUE : FALSE; }
-BOOL CMapStringToPtr::RemoveKey(const wchar_t* key) { return RemoveKey(NormalizeStringKey(key)); }
-void CMapStringToPtr::RemoveAll() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureCStringKeyMapStorage<CMapStringToPtr, void*, void*>(this).data.RemoveAll(); }
-CMapStringToPtr::POSITION CMapStringToPtr::GetStartPosition() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* state = FindCStringKeyMapStorage<CMapStringToPtr, void*, void*>(this); return state ? state->data.GetStartPosition() : POSITION(nullptr, 0); }
-void CMapStringToPtr::GetNextAssoc(POSITION& rNextPosition, CString& rKey, void*& rValue) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureCStringKeyMapStorage<CMapStringToPtr, void*, void*>(this).data.GetNextAssoc(rNextPosition, rKey, rValue); }
-UINT CMapStringToPtr::GetHashTableSize() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* state = FindCStringKeyMapStorage<CMapStringToPtr, void*, void*>(this); return state ? state->data.GetHashTableSize() : 17; }
-void CMapStringToPtr::InitHashTable(UINT hashSize, BOOL bAllocNow) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureCStringKeyMapStorage<CMapStringToPtr, void*, void*>(this).data.InitHashTable(hashSize, bAllocNow != FALSE); }
-void CMapStringToPtr::Serialize(CArchive& ar) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& state = EnsureCStringKeyMapStorage<CMapStringToPtr, void*, void*>(this); if (ar.IsStoring()) ar << state.data; else ar >> state.data; }
-
-CMapStringToString::CMapStringToString(INT_PTR nBlockSize) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureCStringMapStringStorage(this, ClampCollectionBlockSize(nBlockSize)); }
-CMapStringToString::~CMapStringToString() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); RemoveCollectionState<CMapStringToString, CStringMapStringState>(this); }
-INT_PTR CMapStringToString::GetCount() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* state = FindCStringMapStringStorage(this); return state ? state->data.GetCount() : 0; }
-BOOL CMapStringToString::IsEmpty() const { return GetCount() == 0; }
-BOOL CMapStringToString::Lookup(const CString& key, CString& rValue) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* state = FindCStringMapStringStorage(this); return (state && state->data.Lookup(key, rValue)) ? TRUE : FALSE; }
-BOOL CMapStringToString::Lookup(const wchar_t* key, CString& rValue) const { return Lookup(NormalizeStringKey(key), rValue); }
-BOOL CMapStringToString::LookupKey(const CString& key, const wchar_t*& rKey) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& state = EnsureCStringMapStringStorage(this); CString actualKey; if (!state.data.LookupKey(key, actualKey)) return FALSE; state.lookupKeyScratch = actualKey; rKey = static_cast<const wchar_t*>(state.lookupKeyScratch); return TRUE; }
-BOOL CMapStringToString::LookupKey(const wchar_t* key, const wchar_t*& rKey) const { return LookupKey(NormalizeStringKey(key), rKey); }
-CString& CMapStringToString::operator[](const CString& key) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& state = EnsureCStringMapStringStorage(this); state.MarkDirty(); return state.data[key]; }
-CString& CMapStringToString::operator[](const wchar_t* key) { return (*this)[NormalizeStringKey(key)]; }
+// String-keyed maps hash and compare the caller's characters directly, so the
+// LPCTSTR overloads never build a temporary CString.
+#define OPENMFC_DEFINE_STRING_MAP_METHODS(class_name, value_type, const_value_type) \
+OPENMFC_DEFINE_MAP_COMMON(class_name, CString, value_type) \
+class_name::CAssoc* class_name::GetAssocAt(const wchar_t* key, UINT& nHashBucket, UINT& nHashValue) const { \
+    return FindCollectionAssoc(m_pHashTable, m_nHashTableSize, key ? key : L"", nHashBucket, nHashValue); \
+} \
+BOOL class_name::Lookup(const CString& key, value_type& rValue) const { return Lookup(static_cast<const wchar_t*>(key), rValue); } \
+BOOL class_name::Lookup(const wchar_t* key, value_type& rValue) const { \
+    UINT nHashBucket = 0; \
+    UINT nHashValue = 0; \
+    CAssoc* pAssoc = GetAssocAt(key, nHashBucket, nHashValue); \
+    if (!pAssoc) return FALSE; \
+    rValue = pAssoc->value; \
+    return TRUE; \
+} \
+BOOL class_name::LookupKey(const CString& key, const wchar_t*& rKey) const { return LookupKey(static_cast<const wchar_t*>(key), rKey); } \
+BOOL class_name::LookupKey(const wchar_t* key, const wchar_t*& rKey) const { \
+    UINT nHashBucket = 0; \
+    UINT nHashValue = 0; \
+    CAssoc* pAssoc = GetAssocAt(key, nHashBucket, nHashValue); \
+    if (!pAssoc) return FALSE; \
+    rKey = pAssoc->key; \
+    return TRUE; \
+} \
+value_type& class_name::operator[](const CString& key) { return (*this)[static_cast<const wchar_t*>(key)]; } \
+value_type& class_name::operator[](const wchar_t* key) { return OPENMFC_INLINE_MAP().Assoc(key ? key : L"")->value; } \
+const_value_type class_name::operator[](const wchar_t* key) const { value_type value = nullptr; Lookup(key, value); return value; } \
+void class_name::SetAt(const CString& key, value_type newValue) { SetAt(static_cast<const wchar_t*>(key), newValue); } \
+void class_name::SetAt(const wchar_t* key, value_type newValue) { \
+    if (CAssoc* pAssoc = OPENMFC_INLINE_MAP().Assoc(key ? key : L"")) pAssoc->value = newValue; \
+} \
+BOOL class_name::RemoveKey(const CString& key) { return RemoveKey(static_cast<const wchar_t*>(key)); } \
+BOOL class_name::RemoveKey(const wchar_t* key) { return OPENMFC_INLINE_MAP().RemoveKey(key ? key : L"") ? TRUE : FALSE; }
+
+OPENMFC_DEFINE_STRING_MAP_METHODS(CMapStringToOb, CObject*, const CObject*)
+OPENMFC_DEFINE_STRING_MAP_METHODS(CMapStringToPtr, void*, const void*)
+
+OPENMFC_DEFINE_MAP_COMMON(CMapStringToString, CString, CString)
+CMapStringToString::CAssoc* CMapStringToString::NewAssoc(const wchar_t* key) {
+    CAssoc* pAssoc = NewAssoc();
+    if (pAssoc) {
+        pAssoc->key = key ? key : L"";
+        pAssoc->nHashValue = CollectionHashKey(static_cast<const wchar_t*>(pAssoc->key));
+    }
+    return pAssoc;
+}
+CMapStringToString::CAssoc* CMapStringToString::GetAssocAt(const wchar_t* key, UINT& nHashBucket, UINT& nHashValue) const {
+    return FindCollectionAssoc(m_pHashTable, m_nHashTableSize, key ? key : L"", nHashBucket, nHashValue);
+}
+BOOL CMapStringToString::Lookup(const CString& key, CString& rValue) const { return Lookup(static_cast<const wchar_t*>(key), rValue); }
+BOOL CMapStringToString::Lookup(const wchar_t* key, CString& rValue) const {
+    const CPair* pPair = PLookup(key);
+    if (!pPair) return FALSE;
+    rValue = pPair->value;
+    return TRUE;
+}
+BOOL CMapStringToString::LookupKey(const CString& key, const wchar_t*& rKey) const { return LookupKey(static_cast<const wchar_t*>(key), rKey); }
+BOOL CMapStringToString::LookupKey(const wchar_t* key, const wchar_t*& rKey) const {
+    const CPair* pPair = PLookup(key);
+    if (!pPair) return FALSE;
+    rKey = pPair->key;
+    return TRUE;
+}
+CString& CMapStringToString::operator[](const CString& key) { return (*this)[static_cast<const wchar_t*>(key)]; }
+CString& CMapStringToString::operator[](const wchar_t* key) { return OPENMFC_INLINE_MAP().Assoc(key ? key : L"")->value; }
 const CString& CMapStringToString::operator[](const wchar_t* key) const { return const_cast<CMapStringToString*>(this)->operator[](key); }
-void CMapStringToString::SetAt(const CString& key, const CString& newValue) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& state = EnsureCStringMapStringStorage(this); state.data.SetAt(key, newValue); state.MarkDirty(); }
-void CMapStringToString::SetAt(const wchar_t* key, const CString& newValue) { SetAt(NormalizeStringKey(key), newValue); }
-void CMapStringToString::SetAt(const wchar_t* key, const wchar_t* newValue) { SetAt(NormalizeStringKey(key), NormalizeStringKey(newValue)); }
-BOOL CMapStringToString::RemoveKey(const CString& key) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& state = EnsureCStringMapStringStorage(this); BOOL removed = state.data.RemoveKey(key) ? TRUE : FALSE; if (removed) state.MarkDirty(); return removed; }
-BOOL CMapStringToString::RemoveKey(const wchar_t* key) { return RemoveKey(NormalizeStringKey(key)); }
-void CMapStringToString::RemoveAll() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& state = EnsureCStringMapStringStorage(this); state.data.RemoveAll(); state.MarkDirty(); }
-CMapStringToString::POSITION CMapStringToString::GetStartPosition() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* state = FindCStringMapStringStorage(this); return state ? state->data.GetStartPosition() : POSITION(nullptr, 0); }
-void CMapStringToString::GetNextAssoc(POSITION& rNextPosition, CString& rKey, CString& rValue) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); EnsureCStringMapStringStorage(this).data.GetNextAssoc(rNextPosition, rKey, rValue); }
-UINT CMapStringToString::GetHashTableSize() const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); const auto* state = FindCStringMapStringStorage(this); return state ? state->data.GetHashTableSize() : 17; }
-void CMapStringToString::InitHashTable(UINT hashSize, BOOL bAllocNow) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& state = EnsureCStringMapStringStorage(this); state.data.InitHashTable(hashSize, bAllocNow != FALSE); state.MarkDirty(); }
-CMapStringToString::CPair* CMapStringToString::PLookup(const wchar_t* key) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureCStringMapStringStorage(this).PLookup(key); }
-const CMapStringToString::CPair* CMapStringToString::PLookup(const wchar_t* key) const { std::lock_guard<std::mutex> lock(g_collectionStateMutex); return EnsureCStringMapStringStorage(this).PLookup(key); }
-CMapStringToString::CPair* CMapStringToString::PGetFirstAssoc() { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& state = EnsureCStringMapStringStorage(this); state.EnsurePairs(); return state.pairs.empty() ? nullptr : state.pairs.front().get(); }
+void CMapStringToString::SetAt(const CString& key, const CString& newValue) { SetAt(static_cast<const wchar_t*>(key), newValue); }
+void CMapStringToString::SetAt(const wchar_t* key, const CString& newValue) {
+    if (CAssoc* pAssoc = OPENMFC_INLINE_MAP().Assoc(key ? key : L"")) pAssoc->value = newValue;
+}
+void CMapStringToString::SetAt(const wchar_t* key, const wchar_t* newValue) {
+    if (CAssoc* pAssoc = OPENMFC_INLINE_MAP().Assoc(key ? key : L"")) pAssoc->value = newValue ? newValue : L"";
+}
+BOOL CMapStringToString::RemoveKey(const CString& key) { return RemoveKey(static_cast<const wchar_t*>(key)); }
+BOOL CMapStringToString::RemoveKey(const wchar_t* key) { return OPENMFC_INLINE_MAP().RemoveKey(key ? key : L"") ? TRUE : FALSE; }
+
+// The pairs are the assocs themselves: PLookup is a bucket probe and the
+// PGet*Assoc walk follows the hash chains the way GetNextAssoc does.
+CMapStringToString::CPair* CMapStringToString::PLookup(const wchar_t* key) {
+    UINT nHashBucket = 0;
+    UINT nHashValue = 0;
+    return GetAssocAt(key, nHashBucket, nHashValue);
+}
+const CMapStringToString::CPair* CMapStringToString::PLookup(const wchar_t* key) const {
+    UINT nHashBucket = 0;
+    UINT nHashValue = 0;
+    return GetAssocAt(key, nHashBucket, nHashValue);
+}
+CMapStringToString::CPair* CMapStringToString::PGetFirstAssoc() {
+    UINT nCursor = 0;
+    return m_nCount != 0 ? openmfc_maphash::FirstAssoc(m_pHashTable, m_nHashTableSize, nCursor) : nullptr;
+}
 const CMapStringToString::CPair* CMapStringToString::PGetFirstAssoc() const { return const_cast<CMapStringToString*>(this)->PGetFirstAssoc(); }
-CMapStringToString::CPair* CMapStringToString::PGetNextAssoc(const CPair* pAssocRet) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& state = EnsureCStringMapStringStorage(this); state.EnsurePairs(); if (!pAssocRet) return nullptr; for (size_t i = 0; i < state.pairs.size(); ++i) { if (state.pairs[i].get() == pAssocRet) return (i + 1 < state.pairs.size()) ? state.pairs[i + 1].get() : nullptr; } return nullptr; }
+CMapStringToString::CPair* CMapStringToString::PGetNextAssoc(const CPair* pAssocRet) {
+    if (!pAssocRet || !m_pHashTable) return nullptr;
+    UINT nCursor = 0;
+    return openmfc_maphash::NextAssoc(m_pHashTable, m_nHashTableSize, static_cast<const CAssoc*>(pAssocRet), nCursor);
+}
 const CMapStringToString::CPair* CMapStringToString::PGetNextAssoc(const CPair* pAssocRet) const { return const_cast<CMapStringToString*>(this)->PGetNextAssoc(pAssocRet); }
-void CMapStringToString::Serialize(CArchive& ar) { std::lock_guard<std::mutex> lock(g_collectionStateMutex); auto& state = EnsureCStringMapStringStorage(this); if (ar.IsStoring()) ar << state.data; else { ar >> state.data; state.MarkDirty(); } }
 
+#undef OPENMFC_DEFINE_ARRAY_METHODS
+#undef OPENMFC_INLINE_ARRAY
 #undef OPENMFC_DEFINE_LIST_METHODS
+#undef OPENMFC_INLINE_LIST
 #undef OPENMFC_DEFINE_MAP_METHODS
-#undef OPENMFC_DEFINE_ARRAY_METHODS
+#undef OPENMFC_DEFINE_STRING_MAP_METHODS
+#undef OPENMFC_DEFINE_MAP_COMMON
+#undef OPENMFC_INLINE_MAP
 
 #define OPENMFC_WRAP_CTOR0(fn_name, class_name) \
 extern "C" void* MS_ABI fn_name(class_name* pThis) { \
@@ -1046,7 +1412,7 @@ extern "C" CStringList::POSITION MS_ABI impl__Find_CStringList__QEBAPEAU__POSITI
 extern "C" CStringList::POSITION MS_ABI impl__FindIndex_CStringList__QEBAPEAU__POSITION____J_Z(const CStringList* pThis, long long nIndex) { return pThis ? pThis->FindIndex(nIndex) : CStringList::POSITION(nullptr); }
 extern "C" CStringList::POSITION MS_ABI impl__FindIndex_CStringList__QEBAPEAU__POSITION___J_Z(const CStringList* pThis, long long nIndex) { return impl__FindIndex_CStringList__QEBAPEAU__POSITION____J_Z(pThis, nIndex); }
 // Symbol: ?FreeNode@CStringList@@IEAAXPEAUCNode@1@@Z
-extern "C" void MS_ABI impl__FreeNode_CStringList__IEAAXPEAUCNode_1___Z(CStringList* /*pThis*/, void* pNode) { delete static_cast<ListNodeSnapshot<CString>*>(pNode); }
+extern "C" void MS_ABI impl__FreeNode_CStringList__IEAAXPEAUCNode_1___Z(CStringList* pThis, void* pNode) { if (pThis && pNode) pThis->FreeNode(static_cast<CStringList::CNode*>(pNode)); }
 extern "C" void MS_ABI impl__FreeNode_CStringList__IEAAXPEAUCNode_1__Z(CStringList* pThis, void* pNode) { impl__FreeNode_CStringList__IEAAXPEAUCNode_1___Z(pThis, pNode); }
 // Symbol: ?GetRuntimeClass@CStringList@@UEBAPEAUCRuntimeClass@@XZ
 OPENMFC_WRAP_GETRUNTIMECLASS(impl__GetRuntimeClass_CStringList__UEBAPEAUCRuntimeClass__XZ, CStringList)
@@ -1061,7 +1427,7 @@ extern "C" CStringList::POSITION MS_ABI impl__InsertBefore_CStringList__QEAAPEAU
 // Symbol: ?InsertBefore@CStringList@@QEAAPEAU__POSITION@@PEAU2@PEB_W@Z
 extern "C" CStringList::POSITION MS_ABI impl__InsertBefore_CStringList__QEAAPEAU__POSITION__PEAU2_PEB_W_Z(CStringList* pThis, CStringList::POSITION* pPos, const wchar_t* value) { return pThis ? pThis->InsertBefore(pPos ? *pPos : CStringList::POSITION(nullptr), value) : CStringList::POSITION(nullptr); }
 // Symbol: ?NewNode@CStringList@@IEAAPEAUCNode@1@PEAU21@0@Z
-extern "C" void* MS_ABI impl__NewNode_CStringList__IEAAPEAUCNode_1__PEAU21_0_Z(CStringList* /*pThis*/, void* pPrev, void* pNext) { auto* node = new ListNodeSnapshot<CString>(); node->pPrev = static_cast<ListNodeSnapshot<CString>*>(pPrev); node->pNext = static_cast<ListNodeSnapshot<CString>*>(pNext); return node; }
+extern "C" void* MS_ABI impl__NewNode_CStringList__IEAAPEAUCNode_1__PEAU21_0_Z(CStringList* pThis, void* pPrev, void* pNext) { return pThis ? pThis->NewNode(static_cast<CStringList::CNode*>(pPrev), static_cast<CStringList::CNode*>(pNext)) : nullptr; }
 extern "C" void* MS_ABI impl__NewNode_CStringList__IEAAPEAUCNode_1_PEAU21_0_Z(CStringList* pThis, void* pPrev, void* pNext) { return impl__NewNode_CStringList__IEAAPEAUCNode_1__PEAU21_0_Z(pThis, pPrev, pNext); }
 // Symbol: ?RemoveAll@CStringList@@QEAAXXZ
 extern "C" void MS_ABI impl__RemoveAll_CStringList__QEAAXXZ(CStringList* pThis) { if (pThis) pThis->RemoveAll(); }
@@ -1096,7 +1462,7 @@ extern "C" CObList::POSITION MS_ABI impl__Find_CObList__QEBAPEAU__POSITION__PEAV
 extern "C" CObList::POSITION MS_ABI impl__FindIndex_CObList__QEBAPEAU__POSITION____J_Z(const CObList* pThis, long long nIndex) { return pThis ? pThis->FindIndex(nIndex) : CObList::POSITION(nullptr); }
 extern "C" CObList::POSITION MS_ABI impl__FindIndex_CObList__QEBAPEAU__POSITION___J_Z(const CObList* pThis, long long nIndex) { return impl__FindIndex_CObList__QEBAPEAU__POSITION____J_Z(pThis, nIndex); }
 // Symbol: ?FreeNode@CObList@@IEAAXPEAUCNode@1@@Z
-extern "C" void MS_ABI impl__FreeNode_CObList__IEAAXPEAUCNode_1___Z(CObList* /*pThis*/, void* pNode) { delete static_cast<ListNodeSnapshot<CObject*>*>(pNode); }
+extern "C" void MS_ABI impl__FreeNode_CObList__IEAAXPEAUCNode_1___Z(CObList* pThis, void* pNode) { if (pThis && pNode) pThis->FreeNode(static_cast<CObList::CNode*>(pNode)); }
 extern "C" void MS_ABI impl__FreeNode_CObList__IEAAXPEAUCNode_1__Z(CObList* pThis, void* pNode) { impl__FreeNode_CObList__IEAAXPEAUCNode_1___Z(pThis, pNode); }
 // Symbol: ?GetRuntimeClass@CObList@@UEBAPEAUCRuntimeClass@@XZ
 OPENMFC_WRAP_GETRUNTIMECLASS(impl__GetRuntimeClass_CObList__UEBAPEAUCRuntimeClass__XZ, CObList)
@@ -1107,7 +1473,7 @@ extern "C" CObList::POSITION MS_ABI impl__InsertAfter_CObList__QEAAPEAU__POSITIO
 // Symbol: ?InsertBefore@CObList@@QEAAPEAU__POSITION@@PEAU2@PEAVCObject@@@Z
 extern "C" CObList::POSITION MS_ABI impl__InsertBefore_CObList__QEAAPEAU__POSITION__PEAU2_PEAVCObject___Z(CObList* pThis, CObList::POSITION* pPos, CObject* value) { return pThis ? pThis->InsertBefore(pPos ? *pPos : CObList::POSITION(nullptr), value) : CObList::POSITION(nullptr); }
 // Symbol: ?NewNode@CObList@@IEAAPEAUCNode@1@PEAU21@0@Z
-extern "C" void* MS_ABI impl__NewNode_CObList__IEAAPEAUCNode_1__PEAU21_0_Z(CObList* /*pThis*/, void* pPrev, void* pNext) { auto* node = new ListNodeSnapshot<CObject*>(); node->pPrev = static_cast<ListNodeSnapshot<CObject*>*>(pPrev); node->pNext = static_cast<ListNodeSnapshot<CObject*>*>(pNext); return node; }
+extern "C" void* MS_ABI impl__NewNode_CObList__IEAAPEAUCNode_1__PEAU21_0_Z(CObList* pThis, void* pPrev, void* pNext) { return pThis ? pThis->NewNode(static_cast<CObList::CNode*>(pPrev), static_cast<CObList::CNode*>(pNext)) : nullptr; }
 extern "C" void* MS_ABI impl__NewNode_CObList__IEAAPEAUCNode_1_PEAU21_0_Z(CObList* pThis, void* pPrev, void* pNext) { return impl__NewNode_CObList__IEAAPEAUCNode_1__PEAU21_0_Z(pThis, pPrev, pNext); }
 // Symbol: ?RemoveAll@CObList@@QEAAXXZ
 extern "C" void MS_ABI impl__RemoveAll_CObList__QEAAXXZ(CObList* pThis) { if (pThis) pThis->RemoveAll(); }
@@ -1142,10 +1508,10 @@ OPENMFC_WRAP_DTOR(impl___1CMapPtrToPtr__UEAA_XZ, CMapPtrToPtr)
 // Symbol: ??ACMapPtrToPtr@@QEAAAEAPEAXPEAX@Z
 extern "C" void** MS_ABI impl___ACMapPtrToPtr__QEAAAEAPEAXPEAX_Z(CMapPtrToPtr* pThis, void* key) { return pThis ? &((*pThis)[key]) : nullptr; }
 // Symbol: ?FreeAssoc@CMapPtrToPtr@@IEAAXPEAUCAssoc@1@@Z
-extern "C" void MS_ABI impl__FreeAssoc_CMapPtrToPtr__IEAAXPEAUCAssoc_1___Z(CMapPtrToPtr* /*pThis*/, void* pAssoc) { delete static_cast<AssocSnapshot<void*, void*>*>(pAssoc); }
+extern "C" void MS_ABI impl__FreeAssoc_CMapPtrToPtr__IEAAXPEAUCAssoc_1___Z(CMapPtrToPtr* pThis, void* pAssoc) { if (pThis && pAssoc) pThis->FreeAssoc(static_cast<CMapPtrToPtr::CAssoc*>(pAssoc)); }
 extern "C" void MS_ABI impl__FreeAssoc_CMapPtrToPtr__IEAAXPEAUCAssoc_1__Z(CMapPtrToPtr* pThis, void* pAssoc) { impl__FreeAssoc_CMapPtrToPtr__IEAAXPEAUCAssoc_1___Z(pThis, pAssoc); }
 // Symbol: ?GetAssocAt@CMapPtrToPtr@@IEBAPEAUCAssoc@1@PEAXAEAI1@Z
-extern "C" void* MS_ABI impl__GetAssocAt_CMapPtrToPtr__IEBAPEAUCAssoc_1_PEAXAEAI1_Z(const CMapPtrToPtr* pThis, void* key, unsigned int& nHash, unsigned int& nHashBucket) { nHash = static_cast<unsigned int>(reinterpret_cast<uintptr_t>(key) >> 4); nHashBucket = pThis ? (nHash % pThis->GetHashTableSize()) : 0; void* value = nullptr; if (!pThis || !pThis->Lookup(key, value)) return nullptr; auto* assoc = new AssocSnapshot<void*, void*>(); assoc->nHashValue = nHash; assoc->key = key; assoc->value = value; return assoc; }
+extern "C" void* MS_ABI impl__GetAssocAt_CMapPtrToPtr__IEBAPEAUCAssoc_1_PEAXAEAI1_Z(const CMapPtrToPtr* pThis, void* key, unsigned int& nHashBucket, unsigned int& nHashValue) { if (!pThis) { nHashBucket = nHashValue = 0; return nullptr; } return pThis->GetAssocAt(key, nHashBucket, nHashValue); }
 // Symbol: ?GetNextAssoc@CMapPtrToPtr@@QEBAXAEAPEAU__POSITION@@AEAPEAX1@Z
 extern "C" void MS_ABI impl__GetNextAssoc_CMapPtrToPtr__QEBAXAEAPEAU__POSITION__AEAPEAX1_Z(const CMapPtrToPtr* pThis, CMapPtrToPtr::POSITION& pos, void*& key, void*& value) { if (pThis) pThis->GetNextAssoc(pos, key, value); else { key = nullptr; value = nullptr; } }
 // Symbol: ?GetRuntimeClass@CMapPtrToPtr@@UEBAPEAUCRuntimeClass@@XZ
@@ -1159,7 +1525,7 @@ extern "C" void MS_ABI impl__InitHashTable_CMapPtrToPtr__QEAAXIH_Z(CMapPtrToPtr*
 // Symbol: ?Lookup@CMapPtrToPtr@@QEBAHPEAXAEAPEAX@Z
 extern "C" int MS_ABI impl__Lookup_CMapPtrToPtr__QEBAHPEAXAEAPEAX_Z(const CMapPtrToPtr* pThis, void* key, void*& value) { return (pThis && pThis->Lookup(key, value)) ? 1 : 0; }
 // Symbol: ?NewAssoc@CMapPtrToPtr@@IEAAPEAUCAssoc@1@XZ
-extern "C" void* MS_ABI impl__NewAssoc_CMapPtrToPtr__IEAAPEAUCAssoc_1_XZ(CMapPtrToPtr* /*pThis*/) { return new AssocSnapshot<void*, void*>(); }
+extern "C" void* MS_ABI impl__NewAssoc_CMapPtrToPtr__IEAAPEAUCAssoc_1_XZ(CMapPtrToPtr* pThis) { return pThis ? pThis->NewAssoc() : nullptr; }
 // Symbol: ?RemoveAll@CMapPtrToPtr@@QEAAXXZ
 extern "C" void MS_ABI impl__RemoveAll_CMapPtrToPtr__QEAAXXZ(CMapPtrToPtr* pThis) { if (pThis) pThis->RemoveAll(); }
 // Symbol: ?RemoveKey@CMapPtrToPtr@@QEAAHPEAX@Z
@@ -1172,10 +1538,10 @@ OPENMFC_WRAP_DTOR(impl___1CMapPtrToWord__UEAA_XZ, CMapPtrToWord)
 // Symbol: ??ACMapPtrToWord@@QEAAAEAGPEAX@Z
 extern "C" unsigned short* MS_ABI impl___ACMapPtrToWord__QEAAAEAGPEAX_Z(CMapPtrToWord* pThis, void* key) { return pThis ? &((*pThis)[key]) : nullptr; }
 // Symbol: ?FreeAssoc@CMapPtrToWord@@IEAAXPEAUCAssoc@1@@Z
-extern "C" void MS_ABI impl__FreeAssoc_CMapPtrToWord__IEAAXPEAUCAssoc_1___Z(CMapPtrToWord* /*pThis*/, void* pAssoc) { delete static_cast<AssocSnapshot<void*, WORD>*>(pAssoc); }
+extern "C" void MS_ABI impl__FreeAssoc_CMapPtrToWord__IEAAXPEAUCAssoc_1___Z(CMapPtrToWord* pThis, void* pAssoc) { if (pThis && pAssoc) pThis->FreeAssoc(static_cast<CMapPtrToWord::CAssoc*>(pAssoc)); }
 extern "C" void MS_ABI impl__FreeAssoc_CMapPtrToWord__IEAAXPEAUCAssoc_1__Z(CMapPtrToWord* pThis, void* pAssoc) { impl__FreeAssoc_CMapPtrToWord__IEAAXPEAUCAssoc_1___Z(pThis, pAssoc); }
 // Symbol: ?GetAssocAt@CMapPtrToWord@@IEBAPEAUCAssoc@1@PEAXAEAI1@Z
-extern "C" void* MS_ABI impl__GetAssocAt_CMapPtrToWord__IEBAPEAUCAssoc_1_PEAXAEAI1_Z(const CMapPtrToWord* pThis, void* key, unsigned int& nHash, unsigned int& nHashBucket) { nHash = static_cast<unsigned int>(reinterpret_cast<uintptr_t>(key) >> 4); nHashBucket = pThis ? (nHash % pThis->GetHashTableSize()) : 0; WORD value = 0; if (!pThis || !pThis->Lookup(key, value)) return nullptr; auto* assoc = new AssocSnapshot<void*, WORD>(); assoc->nHashValue = nHash; assoc->key = key; assoc->value = value; return assoc; }
+extern "C" void* MS_ABI impl__GetAssocAt_CMapPtrToWord__IEBAPEAUCAssoc_1_PEAXAEAI1_Z(const CMapPtrToWord* pThis, void* key, unsigned int& nHashBucket, unsigned int& nHashValue) { if (!pThis) { nHashBucket = nHashValue = 0; return nullptr; } return pThis->GetAssocAt(key, nHashBucket, nHashValue); }
 // Symbol: ?GetNextAssoc@CMapPtrToWord@@QEBAXAEAPEAU__POSITION@@AEAPEAXAEAG@Z
 extern "C" void MS_ABI impl__GetNextAssoc_CMapPtrToWord__QEBAXAEAPEAU__POSITION__AEAPEAXAEAG_Z(const CMapPtrToWord* pThis, CMapPtrToWord::POSITION& pos, void*& key, unsigned short& value) { if (pThis) pThis->GetNextAssoc(pos, key, value); else { key = nullptr; value = 0; } }
 // Symbol: ?GetRuntimeClass@CMapPtrToWord@@UEBAPEAUCRuntimeClass@@XZ
@@ -1187,7 +1553,7 @@ extern "C" void MS_ABI impl__InitHashTable_CMapPtrToWord__QEAAXIH_Z(CMapPtrToWor
 // Symbol: ?Lookup@CMapPtrToWord@@QEBAHPEAXAEAG@Z
 extern "C" int MS_ABI impl__Lookup_CMapPtrToWord__QEBAHPEAXAEAG_Z(const CMapPtrToWord* pThis, void* key, unsigned short& value) { return (pThis && pThis->Lookup(key, value)) ? 1 : 0; }
 // Symbol: ?NewAssoc@CMapPtrToWord@@IEAAPEAUCAssoc@1@XZ
-extern "C" void* MS_ABI impl__NewAssoc_CMapPtrToWord__IEAAPEAUCAssoc_1_XZ(CMapPtrToWord* /*pThis*/) { return new AssocSnapshot<void*, WORD>(); }
+extern "C" void* MS_ABI impl__NewAssoc_CMapPtrToWord__IEAAPEAUCAssoc_1_XZ(CMapPtrToWord* pThis) { return pThis ? pThis->NewAssoc() : nullptr; }
 // Symbol: ?RemoveAll@CMapPtrToWord@@QEAAXXZ
 extern "C" void MS_ABI impl__RemoveAll_CMapPtrToWord__QEAAXXZ(CMapPtrToWord* pThis) { if (pThis) pThis->RemoveAll(); }
 // Symbol: ?RemoveKey@CMapPtrToWord@@QEAAHPEAX@Z
@@ -1204,10 +1570,10 @@ extern "C" CObject** MS_ABI impl___ACMapStringToOb__QEAAAEAPEAVCObject__PEB_W_Z(
 // Symbol: ?CreateObject@CMapStringToOb@@SAPEAVCObject@@XZ
 OPENMFC_WRAP_CREATEOBJECT(impl__CreateObject_CMapStringToOb__SAPEAVCObject__XZ, CMapStringToOb)
 // Symbol: ?FreeAssoc@CMapStringToOb@@IEAAXPEAUCAssoc@1@@Z
-extern "C" void MS_ABI impl__FreeAssoc_CMapStringToOb__IEAAXPEAUCAssoc_1___Z(CMapStringToOb* /*pThis*/, void* pAssoc) { delete static_cast<AssocSnapshot<CString, CObject*>*>(pAssoc); }
+extern "C" void MS_ABI impl__FreeAssoc_CMapStringToOb__IEAAXPEAUCAssoc_1___Z(CMapStringToOb* pThis, void* pAssoc) { if (pThis && pAssoc) pThis->FreeAssoc(static_cast<CMapStringToOb::CAssoc*>(pAssoc)); }
 extern "C" void MS_ABI impl__FreeAssoc_CMapStringToOb__IEAAXPEAUCAssoc_1__Z(CMapStringToOb* pThis, void* pAssoc) { impl__FreeAssoc_CMapStringToOb__IEAAXPEAUCAssoc_1___Z(pThis, pAssoc); }
 // Symbol: ?GetAssocAt@CMapStringToOb@@IEBAPEAUCAssoc@1@PEB_WAEAI1@Z
-extern "C" void* MS_ABI impl__GetAssocAt_CMapStringToOb__IEBAPEAUCAssoc_1_PEB_WAEAI1_Z(const CMapStringToOb* pThis, const wchar_t* key, unsigned int& nHash, unsigned int& nHashBucket) { CString k = NormalizeStringKey(key); nHash = HashCStringKey(k); nHashBucket = pThis ? (nHash % pThis->GetHashTableSize()) : 0; CObject* value = nullptr; if (!pThis || !pThis->Lookup(k, value)) return nullptr; auto* assoc = new AssocSnapshot<CString, CObject*>(); assoc->nHashValue = nHash; assoc->key = k; assoc->value = value; return assoc; }
+extern "C" void* MS_ABI impl__GetAssocAt_CMapStringToOb__IEBAPEAUCAssoc_1_PEB_WAEAI1_Z(const CMapStringToOb* pThis, const wchar_t* key, unsigned int& nHashBucket, unsigned int& nHashValue) { if (!pThis) { nHashBucket = nHashValue = 0; return nullptr; } return pThis->GetAssocAt(key, nHashBucket, nHashValue); }
 // Symbol: ?GetNextAssoc@CMapStringToOb@@QEBAXAEAPEAU__POSITION@@AEAV?$CStringT@_WV?$StrTraitMFC_DLL@_WV?$ChTraitsCRT@_W@ATL@@@@@ATL@@AEAPEAVCObject@@@Z
 extern "C" void MS_ABI impl__GetNextAssoc_CMapStringToOb__QEBAXAEAPEAU__POSITION__AEAV__CStringT__WV__StrTraitMFC_DLL__WV__ChTraitsCRT__W_ATL_____ATL__AEAPEAVCObject___Z(const CMapStringToOb* pThis, CMapStringToOb::POSITION& pos, CString& key, CObject*& value) { if (pThis) pThis->GetNextAssoc(pos, key, value); else { key = L""; value = nullptr; } }
 // Symbol: ?GetRuntimeClass@CMapStringToOb@@UEBAPEAUCRuntimeClass@@XZ
@@ -1221,7 +1587,7 @@ extern "C" int MS_ABI impl__Lookup_CMapStringToOb__QEBAHPEB_WAEAPEAVCObject___Z(
 // Symbol: ?LookupKey@CMapStringToOb@@QEBAHPEB_WAEAPEB_W@Z
 extern "C" int MS_ABI impl__LookupKey_CMapStringToOb__QEBAHPEB_WAEAPEB_W_Z(const CMapStringToOb* pThis, const wchar_t* key, const wchar_t*& actualKey) { return (pThis && pThis->LookupKey(key, actualKey)) ? 1 : 0; }
 // Symbol: ?NewAssoc@CMapStringToOb@@IEAAPEAUCAssoc@1@XZ
-extern "C" void* MS_ABI impl__NewAssoc_CMapStringToOb__IEAAPEAUCAssoc_1_XZ(CMapStringToOb* /*pThis*/) { return new AssocSnapshot<CString, CObject*>(); }
+extern "C" void* MS_ABI impl__NewAssoc_CMapStringToOb__IEAAPEAUCAssoc_1_XZ(CMapStringToOb* pThis) { return pThis ? pThis->NewAssoc() : nullptr; }
 // Symbol: ?RemoveAll@CMapStringToOb@@QEAAXXZ
 extern "C" void MS_ABI impl__RemoveAll_CMapStringToOb__QEAAXXZ(CMapStringToOb* pThis) { if (pThis) pThis->RemoveAll(); }
 // Symbol: ?RemoveKey@CMapStringToOb@@QEAAHPEB_W@Z
@@ -1236,10 +1602,10 @@ OPENMFC_WRAP_DTOR(impl___1CMapStringToPtr__UEAA_XZ, CMapStringToPtr)
 // Symbol: ??ACMapStringToPtr@@QEAAAEAPEAXPEB_W@Z
 extern "C" void** MS_ABI impl___ACMapStringToPtr__QEAAAEAPEAXPEB_W_Z(CMapStringToPtr* pThis, const wchar_t* key) { return pThis ? &((*pThis)[key]) : nullptr; }
 // Symbol: ?FreeAssoc@CMapStringToPtr@@IEAAXPEAUCAssoc@1@@Z
-extern "C" void MS_ABI impl__FreeAssoc_CMapStringToPtr__IEAAXPEAUCAssoc_1___Z(CMapStringToPtr* /*pThis*/, void* pAssoc) { delete static_cast<AssocSnapshot<CString, void*>*>(pAssoc); }
+extern "C" void MS_ABI impl__FreeAssoc_CMapStringToPtr__IEAAXPEAUCAssoc_1___Z(CMapStringToPtr* pThis, void* pAssoc) { if (pThis && pAssoc) pThis->FreeAssoc(static_cast<CMapStringToPtr::CAssoc*>(pAssoc)); }
 extern "C" void MS_ABI impl__FreeAssoc_CMapStringToPtr__IEAAXPEAUCAssoc_1__Z(CMapStringToPtr* pThis, void* pAssoc) { impl__FreeAssoc_CMapStringToPtr__IEAAXPEAUCAssoc_1___Z(pThis, pAssoc); }
 // Symbol: ?GetAssocAt@CMapStringToPtr@@IEBAPEAUCAssoc@1@PEB_WAEAI1@Z
-extern "C" void* MS_ABI impl__GetAssocAt_CMapStringToPtr__IEBAPEAUCAssoc_1_PEB_WAEAI1_Z(const CMapStringToPtr* pThis, const wchar_t* key, unsigned int& nHash, unsigned int& nHashBucket) { CString k = NormalizeStringKey(key); nHash = HashCStringKey(k); nHashBucket = pThis ? (nHash % pThis->GetHashTableSize()) : 0; void* value = nullptr; if (!pThis || !pThis->Lookup(k, value)) return nullptr; auto* assoc = new AssocSnapshot<CString, void*>(); assoc->nHashValue = nHash; assoc->key = k; assoc->value = value; return assoc; }
+extern "C" void* MS_ABI impl__GetAssocAt_CMapStringToPtr__IEBAPEAUCAssoc_1_PEB_WAEAI1_Z(const CMapStringToPtr* pThis, const wchar_t* key, unsigned int& nHashBucket, unsigned int& nHashValue) { if (!pThis) { nHashBucket = nHashValue = 0; return nullptr; } return pThis->GetAssocAt(key, nHashBucket, nHashValue); }
 // Symbol: ?GetNextAssoc@CMapStringToPtr@@QEBAXAEAPEAU__POSITION@@AEAV?$CStringT@_WV?$StrTraitMFC_DLL@_WV?$ChTraitsCRT@_W@ATL@@@@@ATL@@AEAPEAX@Z
 extern "C" void MS_ABI impl__GetNextAssoc_CMapStringToPtr__QEBAXAEAPEAU__POSITION__AEAV__CStringT__WV__StrTraitMFC_DLL__WV__ChTraitsCRT__W_ATL_____ATL__AEAPEAX_Z(const CMapStringToPtr* pThis, CMapStringToPtr::POSITION& pos, CString& key, void*& value) { if (pThis) pThis->GetNextAssoc(pos, key, value); else { key = L""; value = nullptr; } }
 // Symbol: ?GetRuntimeClass@CMapStringToPtr@@UEBAPEAUCRuntimeClass@@XZ
@@ -1253,7 +1619,7 @@ extern "C" int MS_ABI impl__Lookup_CMapStringToPtr__QEBAHPEB_WAEAPEAX_Z(const CM
 // Symbol: ?LookupKey@CMapStringToPtr@@QEBAHPEB_WAEAPEB_W@Z
 extern "C" int MS_ABI impl__LookupKey_CMapStringToPtr__QEBAHPEB_WAEAPEB_W_Z(const CMapStringToPtr* pThis, const wchar_t* key, const wchar_t*& actualKey) { return (pThis && pThis->LookupKey(key, actualKey)) ? 1 : 0; }
 // Symbol: ?NewAssoc@CMapStringToPtr@@IEAAPEAUCAssoc@1@XZ
-extern "C" void* MS_ABI impl__NewAssoc_CMapStringToPtr__IEAAPEAUCAssoc_1_XZ(CMapStringToPtr* /*pThis*/) { return new AssocSnapshot<CString, void*>(); }
+extern "C" void* MS_ABI impl__NewAssoc_CMapStringToPtr__IEAAPEAUCAssoc_1_XZ(CMapStringToPtr* pThis) { return pThis ? pThis->NewAssoc() : nullptr; }
 // Symbol: ?RemoveAll@CMapStringToPtr@@QEAAXXZ
 extern "C" void MS_ABI impl__RemoveAll_CMapStringToPtr__QEAAXXZ(CMapStringToPtr* pThis) { if (pThis) pThis->RemoveAll(); }
 // Symbol: ?RemoveKey@CMapStringToPtr@@QEAAHPEB_W@Z
@@ -1270,10 +1636,10 @@ extern "C" CString* MS_ABI impl___ACMapStringToString__QEAAAEAV__CStringT__WV__S
 // Symbol: ?CreateObject@CMapStringToString@@SAPEAVCObject@@XZ
 OPENMFC_WRAP_CREATEOBJECT(impl__CreateObject_CMapStringToString__SAPEAVCObject__XZ, CMapStringToString)
 // Symbol: ?FreeAssoc@CMapStringToString@@IEAAXPEAVCAssoc@1@@Z
-extern "C" void MS_ABI impl__FreeAssoc_CMapStringToString__IEAAXPEAVCAssoc_1___Z(CMapStringToString* /*pThis*/, void* pAssoc) { delete static_cast<AssocSnapshot<CString, CString>*>(pAssoc); }
+extern "C" void MS_ABI impl__FreeAssoc_CMapStringToString__IEAAXPEAVCAssoc_1___Z(CMapStringToString* pThis, void* pAssoc) { if (pThis && pAssoc) pThis->FreeAssoc(static_cast<CMapStringToString::CAssoc*>(pAssoc)); }
 extern "C" void MS_ABI impl__FreeAssoc_CMapStringToString__IEAAXPEAVCAssoc_1__Z(CMapStringToString* pThis, void* pAssoc) { impl__FreeAssoc_CMapStringToString__IEAAXPEAVCAssoc_1___Z(pThis, pAssoc); }
 // Symbol: ?GetAssocAt@CMapStringToString@@IEBAPEAVCAssoc@1@PEB_WAEAI1@Z
-extern "C" void* MS_ABI impl__GetAssocAt_CMapStringToString__IEBAPEAVCAssoc_1_PEB_WAEAI1_Z(const CMapStringToString* pThis, const wchar_t* key, unsigned int& nHash, unsigned int& nHashBucket) { CString k = NormalizeStringKey(key); nHash = HashCStringKey(k); nHashBucket = pThis ? (nHash % pThis->GetHashTableSize()) : 0; CString value; if (!pThis || !pThis->Lookup(k, value)) return nullptr; auto* assoc = new AssocSnapshot<CString, CString>(); assoc->nHashValue = nHash; assoc->key = k; assoc->value = value; return assoc; }
+extern "C" void* MS_ABI impl__GetAssocAt_CMapStringToString__IEBAPEAVCAssoc_1_PEB_WAEAI1_Z(const CMapStringToString* pThis, const wchar_t* key, unsigned int& nHashBucket, unsigned int& nHashValue) { if (!pThis) { nHashBucket = nHashValue = 0; return nullptr; } return pThis->GetAssocAt(key, nHashBucket, nHashValue); }
 // Symbol: ?GetNextAssoc@CMapStringToString@@QEBAXAEAPEAU__POSITION@@AEAV?$CStringT@_WV?$StrTraitMFC_DLL@_WV?$ChTraitsCRT@_W@ATL@@@@@ATL@@1@Z
 extern "C" void MS_ABI impl__GetNextAssoc_CMapStringToString__QEBAXAEAPEAU__POSITION__AEAV__CStringT__WV__StrTraitMFC_DLL__WV__ChTraitsCRT__W_ATL_____ATL__1_Z(const CMapStringToString* pThis, CMapStringToString::POSITION& pos, CString& key, CString& value) { if (pThis) pThis->GetNextAssoc(pos, key, value); else { key = L""; value = L""; } }
 // Symbol: ?GetRuntimeClass@CMapStringToString@@UEBAPEAUCRuntimeClass@@XZ
@@ -1287,7 +1653,7 @@ extern "C" int MS_ABI impl__Lookup_CMapStringToString__QEBAHPEB_WAEAV__CStringT_
 // Symbol: ?LookupKey@CMapStringToString@@QEBAHPEB_WAEAPEB_W@Z
 extern "C" int MS_ABI impl__LookupKey_CMapStringToString__QEBAHPEB_WAEAPEB_W_Z(const CMapStringToString* pThis, const wchar_t* key, const wchar_t*& actualKey) { return (pThis && pThis->LookupKey(key, actualKey)) ? 1 : 0; }
 // Symbol: ?NewAssoc@CMapStringToString@@IEAAPEAVCAssoc@1@PEB_W@Z
-extern "C" void* MS_ABI impl__NewAssoc_CMapStringToString__IEAAPEAVCAssoc_1_PEB_W_Z(CMapStringToString* /*pThis*/, const wchar_t* key) { auto* assoc = new AssocSnapshot<CString, CString>(); assoc->key = NormalizeStringKey(key); assoc->nHashValue = HashCStringKey(assoc->key); return assoc; }
+extern "C" void* MS_ABI impl__NewAssoc_CMapStringToString__IEAAPEAVCAssoc_1_PEB_W_Z(CMapStringToString* pThis, const wchar_t* key) { return pThis ? pThis->NewAssoc(key) : nullptr; }
 // Symbol: ?PGetFirstAssoc@CMapStringToString@@QEAAPEAUCPair@1@XZ
 extern "C" CMapStringToString::CPair* MS_ABI impl__PGetFirstAssoc_CMapStringToString__QEAAPEAUCPair_1_XZ(CMapStringToString* pThis) { return pThis ? pThis->PGetFirstAssoc() : nullptr; }
 // Symbol: ?PGetFirstAssoc@CMapStringToString@@QEBAPEBUCPair@1@XZ
@@ -1320,10 +1686,10 @@ extern "C" CObject** MS_ABI impl___ACMapWordToOb__QEAAAEAPEAVCObject__G_Z(CMapWo
 // Symbol: ?CreateObject@CMapWordToOb@@SAPEAVCObject@@XZ
 OPENMFC_WRAP_CREATEOBJECT(impl__CreateObject_CMapWordToOb__SAPEAVCObject__XZ, CMapWordToOb)
 // Symbol: ?FreeAssoc@CMapWordToOb@@IEAAXPEAUCAssoc@1@@Z
-extern "C" void MS_ABI impl__FreeAssoc_CMapWordToOb__IEAAXPEAUCAssoc_1___Z(CMapWordToOb* /*pThis*/, void* pAssoc) { delete static_cast<AssocSnapshot<WORD, CObject*>*>(pAssoc); }
+extern "C" void MS_ABI impl__FreeAssoc_CMapWordToOb__IEAAXPEAUCAssoc_1___Z(CMapWordToOb* pThis, void* pAssoc) { if (pThis && pAssoc) pThis->FreeAssoc(static_cast<CMapWordToOb::CAssoc*>(pAssoc)); }
 extern "C" void MS_ABI impl__FreeAssoc_CMapWordToOb__IEAAXPEAUCAssoc_1__Z(CMapWordToOb* pThis, void* pAssoc) { impl__FreeAssoc_CMapWordToOb__IEAAXPEAUCAssoc_1___Z(pThis, pAssoc); }
 // Symbol: ?GetAssocAt@CMapWordToOb@@IEBAPEAUCAssoc@1@GAEAI0@Z
-extern "C" void* MS_ABI impl__GetAssocAt_CMapWordToOb__IEBAPEAUCAssoc_1_GAEAI0_Z(const CMapWordToOb* pThis, unsigned short key, unsigned int& nHash, unsigned int& nHashBucket) { nHash = static_cast<unsigned int>(key >> 4); nHashBucket = pThis ? (nHash % pThis->GetHashTableSize()) : 0; CObject* value = nullptr; if (!pThis || !pThis->Lookup(key, value)) return nullptr; auto* assoc = new AssocSnapshot<WORD, CObject*>(); assoc->nHashValue = nHash; assoc->key = key; assoc->value = value; return assoc; }
+extern "C" void* MS_ABI impl__GetAssocAt_CMapWordToOb__IEBAPEAUCAssoc_1_GAEAI0_Z(const CMapWordToOb* pThis, unsigned short key, unsigned int& nHashBucket, unsigned int& nHashValue) { if (!pThis) { nHashBucket = nHashValue = 0; return nullptr; } return pThis->GetAssocAt(key, nHashBucket, nHashValue); }
 // Symbol: ?GetNextAssoc@CMapWordToOb@@QEBAXAEAPEAU__POSITION@@AEAGAEAPEAVCObject@@@Z
 extern "C" void MS_ABI impl__GetNextAssoc_CMapWordToOb__QEBAXAEAPEAU__POSITION__AEAGAEAPEAVCObject___Z(const CMapWordToOb* pThis, CMapWordToOb::POSITION& pos, unsigned short& key, CObject*& value) { if (pThis) pThis->GetNextAssoc(pos, key, value); else { key = 0; value = nullptr; } }
 // Symbol: ?GetRuntimeClass@CMapWordToOb@@UEBAPEAUCRuntimeClass@@XZ
@@ -1335,7 +1701,7 @@ extern "C" void MS_ABI impl__InitHashTable_CMapWordToOb__QEAAXIH_Z(CMapWordToOb*
 // Symbol: ?Lookup@CMapWordToOb@@QEBAHGAEAPEAVCObject@@@Z
 extern "C" int MS_ABI impl__Lookup_CMapWordToOb__QEBAHGAEAPEAVCObject___Z(const CMapWordToOb* pThis, unsigned short key, CObject*& value) { return (pThis && pThis->Lookup(key, value)) ? 1 : 0; }
 // Symbol: ?NewAssoc@CMapWordToOb@@IEAAPEAUCAssoc@1@XZ
-extern "C" void* MS_ABI impl__NewAssoc_CMapWordToOb__IEAAPEAUCAssoc_1_XZ(CMapWordToOb* /*pThis*/) { return new AssocSnapshot<WORD, CObject*>(); }
+extern "C" void* MS_ABI impl__NewAssoc_CMapWordToOb__IEAAPEAUCAssoc_1_XZ(CMapWordToOb* pThis) { return pThis ? pThis->NewAssoc() : nullptr; }
 // Symbol: ?RemoveAll@CMapWordToOb@@QEAAXXZ
 extern "C" void MS_ABI impl__RemoveAll_CMapWordToOb__QEAAXXZ(CMapWordToOb* pThis) { if (pThis) pThis->RemoveAll(); }
 // Symbol: ?RemoveKey@CMapWordToOb@@QEAAHG@Z
@@ -1350,10 +1716,10 @@ OPENMFC_WRAP_DTOR(impl___1CMapWordToPtr__UEAA_XZ, CMapWordToPtr)
 // Symbol: ??ACMapWordToPtr@@QEAAAEAPEAXG@Z
 extern "C" void** MS_ABI impl___ACMapWordToPtr__QEAAAEAPEAXG_Z(CMapWordToPtr* pThis, unsigned short key) { return pThis ? &((*pThis)[key]) : nullptr; }
 // Symbol: ?FreeAssoc@CMapWordToPtr@@IEAAXPEAUCAssoc@1@@Z
-extern "C" void MS_ABI impl__FreeAssoc_CMapWordToPtr__IEAAXPEAUCAssoc_1___Z(CMapWordToPtr* /*pThis*/, void* pAssoc) { delete static_cast<AssocSnapshot<WORD, void*>*>(pAssoc); }
+extern "C" void MS_ABI impl__FreeAssoc_CMapWordToPtr__IEAAXPEAUCAssoc_1___Z(CMapWordToPtr* pThis, void* pAssoc) { if (pThis && pAssoc) pThis->FreeAssoc(static_cast<CMapWordToPtr::CAssoc*>(pAssoc)); }
 extern "C" void MS_ABI impl__FreeAssoc_CMapWordToPtr__IEAAXPEAUCAssoc_1__Z(CMapWordToPtr* pThis, void* pAssoc) { impl__FreeAssoc_CMapWordToPtr__IEAAXPEAUCAssoc_1___Z(pThis, pAssoc); }
 // Symbol: ?GetAssocAt@CMapWordToPtr@@IEBAPEAUCAssoc@1@GAEAI0@Z
-extern "C" void* MS_ABI impl__GetAssocAt_CMapWordToPtr__IEBAPEAUCAssoc_1_GAEAI0_Z(const CMapWordToPtr* pThis, unsigned short key, unsigned int& nHash, unsigned int& nHashBucket) { nHash = static_cast<unsigned int>(key >> 4); nHashBucket = pThis ? (nHash % pThis->GetHashTableSize()) : 0; void* value = nullptr; if (!pThis || !pThis->Lookup(key, value)) return nullptr; auto* assoc = new AssocSnapshot<WORD, void*>(); assoc->nHashValue = nHash; assoc->key = key; assoc->value = value; return assoc; }
+extern "C" void* MS_ABI impl__GetAssocAt_CMapWordToPtr__IEBAPEAUCAssoc_1_GAEAI0_Z(const CMapWordToPtr* pThis, unsigned short key, unsigned int& nHashBucket, unsigned int& nHashValue) { if (!pThis) { nHashBucket = nHashValue = 0; return nullptr; } return pThis->GetAssocAt(key, nHashBucket, nHashValue); }
 // Symbol: ?GetNextAssoc@CMapWordToPtr@@QEBAXAEAPEAU__POSITION@@AEAGAEAPEAX@Z
 extern "C" void MS_ABI impl__GetNextAssoc_CMapWordToPtr__QEBAXAEAPEAU__POSITION__AEAGAEAPEAX_Z(const CMapWordToPtr* pThis, CMapWordToPtr::POSITION& pos, unsigned short& key, void*& value) { if (pThis) pThis->GetNextAssoc(pos, key, value); else { key = 0; value = nullptr; } }
 // Symbol: ?GetRuntimeClass@CMapWordToPtr@@UEBAPEAUCRuntimeClass@@XZ
@@ -1365,7 +1731,7 @@ extern "C" void MS_ABI impl__InitHashTable_CMapWordToPtr__QEAAXIH_Z(CMapWordToPt
 // Symbol: ?Lookup@CMapWordToPtr@@QEBAHGAEAPEAX@Z
 extern "C" int MS_ABI impl__Lookup_CMapWordToPtr__QEBAHGAEAPEAX_Z(const CMapWordToPtr* pThis, unsigned short key, void*& value) { return (pThis && pThis->Lookup(key, value)) ? 1 : 0; }
 // Symbol: ?NewAssoc@CMapWordToPtr@@IEAAPEAUCAssoc@1@XZ
-extern "C" void* MS_ABI impl__NewAssoc_CMapWordToPtr__IEAAPEAUCAssoc_1_XZ(CMapWordToPtr* /*pThis*/) { return new AssocSnapshot<WORD, void*>(); }
+extern "C" void* MS_ABI impl__NewAssoc_CMapWordToPtr__IEAAPEAUCAssoc_1_XZ(CMapWordToPtr* pThis) { return pThis ? pThis->NewAssoc() : nullptr; }
 // Symbol: ?RemoveAll@CMapWordToPtr@@QEAAXXZ
 extern "C" void MS_ABI impl__RemoveAll_CMapWordToPtr__QEAAXXZ(CMapWordToPtr* pThis) { if (pThis) pThis->RemoveAll(); }
 // Symbol: ?RemoveKey@CMapWordToPtr@@QEAAHG@Z
@@ -1678,33 +2044,136 @@ void CFile::SetStatus(const wchar_t* lpszFileName, const CFileStatus& status) {
 
 // =============================================================================
 // CMemFile Implementation
+//
+// The buffer grows linearly by m_nGrowBytes as in MFC, or geometrically after
+// SetGeometricGrowth. After ReserveAddressSpace it is a VirtualAlloc
+// reservation whose pages are committed as the file grows, so growing never
+// moves or copies it.
+//
+// A buffer with nGrowBytes 0 is fixed size; writing past it throws
+// CFileException::diskFull. A buffer handed to the constructor or to Attach
+// with nGrowBytes != 0 is grown with realloc, as MFC documents, so it must
+// come from malloc; it stays the caller's to free after Detach. Geometric
+// growth applies only to a buffer the file allocated itself. CSharedFile
+// keeps its SetHandle block fixed by setting nGrowBytes to 0.
 // =============================================================================
 
+extern "C" void MS_ABI impl__AfxThrowFileException__YAXHJPEB_W_Z(int cause, long lOsError, const wchar_t* lpszFileName);
+
+namespace {
+
+const SIZE_T kMemFileCommitGranularity = 64 * 1024;
+const int kMemFileDiskFull = 13;    // CFileException::diskFull
+
+void ThrowMemFileFull() {
+    impl__AfxThrowFileException__YAXHJPEB_W_Z(kMemFileDiskFull, -1, nullptr);
+}
+
+SIZE_T RoundUpTo(SIZE_T n, SIZE_T nMultiple) {
+    SIZE_T nRem = n % nMultiple;
+    return (nRem == 0 || n > static_cast<SIZE_T>(-1) - (nMultiple - nRem)) ? n : n + (nMultiple - nRem);
+}
+
+} // namespace
+
 CMemFile::CMemFile(UINT nGrowBytes)
     : m_lpBuffer(nullptr), m_nBufferSize(0), m_nFileSize(0),
-      m_nGrowBytes(nGrowBytes), m_nPosition(0), m_bAutoDelete(true)
+      m_nGrowBytes(nGrowBytes), m_nPosition(0), m_bAutoDelete(true),
+      m_bReserved(false), m_nMaxGrowBytes(0), m_nReservedSize(0)
 {
     m_hFile = INVALID_HANDLE_VALUE;
 }
 
 CMemFile::CMemFile(BYTE* lpBuffer, UINT nBufferSize, UINT nGrowBytes)
     : m_lpBuffer(lpBuffer), m_nBufferSize(nBufferSize), m_nFileSize(nBufferSize),
-      m_nGrowBytes(nGrowBytes), m_nPosition(0), m_bAutoDelete(false)
+      m_nGrowBytes(nGrowBytes), m_nPosition(0), m_bAutoDelete(false),
+      m_bReserved(false), m_nMaxGrowBytes(0), m_nReservedSize(0)
 {
     m_hFile = INVALID_HANDLE_VALUE;
 }
 
 CMemFile::~CMemFile() {
-    if (m_bAutoDelete && m_lpBuffer) {
+    FreeBuffer();
+}
+
+void CMemFile::FreeBuffer() {
+    if (m_bReserved) {
+        VirtualFree(m_lpBuffer, 0, MEM_RELEASE);
+    } else if (m_bAutoDelete && m_lpBuffer) {
         free(m_lpBuffer);
     }
+    m_lpBuffer = nullptr;
+    m_bReserved = false;
+    m_nReservedSize = 0;
+}
+
+// Makes room for nNewLen bytes. On failure the buffer is left as it was.
+bool CMemFile::GrowBuffer(SIZE_T nNewLen) {
+    if (nNewLen <= m_nBufferSize) return true;
+    if (!m_bReserved && m_nGrowBytes == 0) return false;
+
+    SIZE_T nGrow = (m_nGrowBytes > 0) ? m_nGrowBytes : 1024;
+    SIZE_T nNewBufSize = m_nBufferSize;
+    if (m_nMaxGrowBytes > 0 && m_bAutoDelete) {
+        SIZE_T nStep = (nNewBufSize > nGrow) ? nNewBufSize : nGrow;
+        nNewBufSize += (nStep < m_nMaxGrowBytes) ? nStep : m_nMaxGrowBytes;
+    }
+    if (nNewBufSize < nNewLen) {
+        nNewBufSize = nNewLen;
+    }
+    nNewBufSize = RoundUpTo(nNewBufSize, nGrow);
+
+    if (m_bReserved) {
+        nNewBufSize = RoundUpTo(nNewBufSize, kMemFileCommitGranularity);
+        if (nNewBufSize > m_nReservedSize) {
+            if (nNewLen > m_nReservedSize) return false;
+            nNewBufSize = m_nReservedSize;
+        }
+        if (!VirtualAlloc(m_lpBuffer + m_nBufferSize, nNewBufSize - m_nBufferSize, MEM_COMMIT, PAGE_READWRITE)) {
+            return false;
+        }
+    } else {
+        BYTE* pNewBuf = (BYTE*)realloc(m_lpBuffer, nNewBufSize);
+        if (!pNewBuf) return false;
+        m_lpBuffer = pNewBuf;
+    }
+    m_nBufferSize = nNewBufSize;
+    return true;
+}
+
+void CMemFile::SetGeometricGrowth(SIZE_T nMaxGrowBytes) {
+    m_nMaxGrowBytes = nMaxGrowBytes;
+}
+
+BOOL CMemFile::ReserveAddressSpace(ULONGLONG nMaxSize) {
+    if (m_bReserved || (m_lpBuffer && !m_bAutoDelete)) return FALSE;
+    if (nMaxSize < m_nFileSize || nMaxSize > static_cast<SIZE_T>(-1) - kMemFileCommitGranularity) return FALSE;
+
+    SIZE_T nReserve = RoundUpTo(nMaxSize ? static_cast<SIZE_T>(nMaxSize) : 1, kMemFileCommitGranularity);
+    BYTE* pBase = static_cast<BYTE*>(VirtualAlloc(nullptr, nReserve, MEM_RESERVE, PAGE_NOACCESS));
+    if (!pBase) return FALSE;
+    SIZE_T nCommit = RoundUpTo(m_nFileSize, kMemFileCommitGranularity);
+    if (nCommit > 0 && !VirtualAlloc(pBase, nCommit, MEM_COMMIT, PAGE_READWRITE)) {
+        VirtualFree(pBase, 0, MEM_RELEASE);
+        return FALSE;
+    }
+    if (m_nFileSize > 0) {
+        memcpy(pBase, m_lpBuffer, m_nFileSize);
+    }
+    FreeBuffer();
+    m_lpBuffer = pBase;
+    m_nBufferSize = nCommit;
+    m_nReservedSize = nReserve;
+    m_bReserved = true;
+    m_bAutoDelete = true;
+    return TRUE;
 }
 
 UINT CMemFile::Read(void* lpBuf, UINT nCount) {
     if (!lpBuf || nCount == 0) return 0;
 
-    UINT nAvail = (m_nPosition < m_nFileSize) ? (m_nFileSize - m_nPosition) : 0;
-    UINT nRead = (nCount < nAvail) ? nCount : nAvail;
+    SIZE_T nAvail = (m_nPosition < m_nFileSize) ? (m_nFileSize - m_nPosition) : 0;
+    UINT nRead = (nCount < nAvail) ? nCount : static_cast<UINT>(nAvail);
 
     if (nRead > 0 && m_lpBuffer) {
         memcpy(lpBuf, m_lpBuffer + m_nPosition, nRead);
@@ -1717,18 +2186,9 @@ UINT CMemFile::Read(void* lpBuf, UINT nCount) {
 void CMemFile::Write(const void* lpBuf, UINT nCount) {
     if (!lpBuf || nCount == 0) return;
 
-    // Grow buffer if needed
-    UINT nNewSize = m_nPosition + nCount;
-    if (nNewSize > m_nBufferSize) {
-        UINT nGrow = (m_nGrowBytes > 0) ? m_nGrowBytes : 1024;
-        UINT nNewBufSize = ((nNewSize + nGrow - 1) / nGrow) * nGrow;
-
-        BYTE* pNewBuf = (BYTE*)realloc(m_lpBuffer, nNewBufSize);
-        if (!pNewBuf) return;
-
-        m_lpBuffer = pNewBuf;
-        m_nBufferSize = nNewBufSize;
-        m_bAutoDelete = true;
+    if (!GrowBuffer(m_nPosition + nCount)) {
+        ThrowMemFileFull();
+        return;
     }
 
     memcpy(m_lpBuffer + m_nPosition, lpBuf, nCount);
@@ -1743,29 +2203,22 @@ ULONGLONG CMemFile::Seek(LONGLONG lOff, UINT nFrom) {
     LONGLONG lNewPos;
     switch (nFrom) {
         case begin:   lNewPos = lOff; break;
-        case current: lNewPos = m_nPosition + lOff; break;
-        case end:     lNewPos = m_nFileSize + lOff; break;
+        case current: lNewPos = (LONGLONG)m_nPosition + lOff; break;
+        case end:     lNewPos = (LONGLONG)m_nFileSize + lOff; break;
         default:      lNewPos = lOff; break;
     }
 
     if (lNewPos < 0) lNewPos = 0;
-    m_nPosition = (UINT)lNewPos;
+    m_nPosition = (SIZE_T)lNewPos;
     return m_nPosition;
 }
 
 void CMemFile::SetLength(ULONGLONG dwNewLen) {
-    UINT nNewLen = (UINT)dwNewLen;
-
-    if (nNewLen > m_nBufferSize) {
-        UINT nGrow = (m_nGrowBytes > 0) ? m_nGrowBytes : 1024;
-        UINT nNewBufSize = ((nNewLen + nGrow - 1) / nGrow) * nGrow;
+    SIZE_T nNewLen = (SIZE_T)dwNewLen;
 
-        BYTE* pNewBuf = (BYTE*)realloc(m_lpBuffer, nNewBufSize);
-        if (!pNewBuf) return;
-
-        m_lpBuffer = pNewBuf;
-        m_nBufferSize = nNewBufSize;
-        m_bAutoDelete = true;
+    if (!GrowBuffer(nNewLen)) {
+        ThrowMemFileFull();
+        return;
     }
 
     m_nFileSize = nNewLen;
@@ -1782,8 +2235,49 @@ void CMemFile::Flush() {
     // Nothing to flush for memory file
 }
 
+UINT CMemFile::GetBufferPtr(UINT nCommand, UINT nCount, void** ppBufStart, void** ppBufMax) {
+    // Direct windows only into memory the file owns; anything else goes
+    // through CArchive's own buffer and Write.
+    if (nCommand == bufferCheck) {
+        return (m_bAutoDelete || m_bReserved) ? bufferDirect : 0;
+    }
+    if (nCommand == bufferCommit) {
+        m_nPosition += nCount;
+        if (m_nPosition > m_nFileSize) {
+            m_nFileSize = m_nPosition;
+        }
+        return 0;
+    }
+    if (!ppBufStart || !ppBufMax) return 0;
+
+    // A write window past the buffer grows it first; if that fails the
+    // window is just shorter, and an empty one throws as Write does.
+    if (nCommand == bufferWrite && m_nPosition + nCount > m_nBufferSize &&
+        !GrowBuffer(m_nPosition + nCount) && m_nPosition >= m_nBufferSize) {
+        ThrowMemFileFull();
+    }
+    SIZE_T nEnd = (nCommand == bufferWrite) ? m_nBufferSize : m_nFileSize;
+    SIZE_T nAvail = (m_nPosition < nEnd) ? nEnd - m_nPosition : 0;
+    if (nAvail > nCount) {
+        nAvail = nCount;
+    }
+    *ppBufStart = m_lpBuffer ? m_lpBuffer + m_nPosition : nullptr;
+    *ppBufMax = m_lpBuffer ? m_lpBuffer + m_nPosition + nAvail : nullptr;
+    if (nCommand == bufferRead) {
+        m_nPosition += nAvail;
+    }
+    return static_cast<UINT>(nAvail);
+}
+
 BYTE* CMemFile::Detach() {
     BYTE* lpBuffer = m_lpBuffer;
+    if (m_bReserved) {
+        // Callers free() a detached buffer, so hand back a heap copy.
+        lpBuffer = static_cast<BYTE*>(malloc(m_nFileSize ? m_nFileSize : 1));
+        if (!lpBuffer) return nullptr;
+        memcpy(lpBuffer, m_lpBuffer, m_nFileSize);
+        FreeBuffer();
+    }
     m_lpBuffer = nullptr;
     m_nBufferSize = 0;
     m_nFileSize = 0;
@@ -1793,9 +2287,7 @@ BYTE* CMemFile::Detach() {
 }
 
 void CMemFile::Attach(BYTE* lpBuffer, UINT nBufferSize, UINT nGrowBytes) {
-    if (m_bAutoDelete && m_lpBuffer) {
-        free(m_lpBuffer);
-    }
+    FreeBuffer();
     m_lpBuffer = lpBuffer;
     m_nBufferSize = nBufferSize;
     m_nFileSize = nBufferSize;
@@ -1899,16 +2391,23 @@ int CStdioFile::ReadString(CString& rString) {
     rString.Empty();
     if (!m_pStream) return 0;
 
-    wchar_t buf[256];
-    while (fgetws(buf, 256, m_pStream)) {
-        rString += buf;
-        // Check if we got a complete line
-        int len = rString.GetLength();
-        if (len > 0 && ((const wchar_t*)rString)[len - 1] == L'\n') {
-            break;
+    // fgetws writes straight into the string's buffer, which doubles until
+    // the line fits; the stream's own buffer is the CRT's, so the scan for
+    // the newline stays inside fgetws.
+    int nCapacity = 128;
+    int nLen = 0;
+    wchar_t* pBuf = rString.GetBuffer(nCapacity);
+    while (fgetws(pBuf + nLen, nCapacity + 1 - nLen, m_pStream)) {
+        nLen += static_cast<int>(wcslen(pBuf + nLen));
+        if (nLen < nCapacity || pBuf[nLen - 1] == L'\n') {
+            break;  // complete line, or the last one in the file
         }
+        rString.ReleaseBuffer(nLen);
+        nCapacity *= 2;
+        pBuf = rString.GetBuffer(nCapacity);
     }
-    return rString.GetLength() > 0 ? 1 : 0;
+    rString.ReleaseBuffer(nLen);
+    return nLen > 0 ? 1 : 0;
 }
 
 void CStdioFile::WriteString(const wchar_t* lpsz) {
@@ -1922,8 +2421,19 @@ void CStdioFile::WriteString(const wchar_t* lpsz) {
 
 CArchive::CArchive(CFile* pFile, UINT nMode, int nBufSize, void* lpBuf)
     : m_pFile(pFile), m_nMode(nMode), m_nBufSize(nBufSize),
-      m_nObjectSchema(0), m_bForceFlat(false)
+      m_nObjectSchema(0), m_bForceFlat(false), m_bDirectBuffer(false), m_pObjectMap(nullptr)
 {
+    // Files that expose their own buffer (CMemFile) are read and written in
+    // place; the archive buffer is then a window into the file's. The first
+    // window is taken by the first Read or Write, so an archive that stores
+    // nothing leaves the file as it was.
+    if (pFile && (OpenMFC_File_GetBufferPtr(pFile, CFile::bufferCheck, 0, nullptr, nullptr) & CFile::bufferDirect)) {
+        m_bDirectBuffer = true;
+        m_bUserBuf = true;
+        m_lpBufStart = m_lpBufCur = m_lpBufMax = nullptr;
+        return;
+    }
+
     if (lpBuf) {
         m_lpBufStart = static_cast<unsigned char*>(lpBuf);
         m_bUserBuf = true;
@@ -1948,9 +2458,32 @@ CArchive::~CArchive() {
     if (!m_bUserBuf) {
         delete[] m_lpBufStart;
     }
+    delete m_pObjectMap;
 }
 
 void CArchive::FillBuffer(UINT nBytesNeeded) {
+    if (m_bDirectBuffer) {
+        UINT nRemaining = (UINT)(m_lpBufMax - m_lpBufCur);
+        if (nRemaining >= nBytesNeeded) return;
+        // Step the file back over the unread tail and take a new window that
+        // starts there.
+        if (nRemaining > 0) {
+            OpenMFC_File_Seek(m_pFile, -(long long)nRemaining, CFile::current);
+        }
+        // A blocking file (CSocketFile) waits for the count it is given, so
+        // ask only for what is needed; its window covers everything already
+        // received anyway.
+        UINT nWant = (nBytesNeeded > (UINT)m_nBufSize) ? nBytesNeeded : (UINT)m_nBufSize;
+        if (OpenMFC_File_GetBufferPtr(m_pFile, CFile::bufferCheck, 0, nullptr, nullptr) & CFile::bufferBlocking) {
+            nWant = nBytesNeeded;
+        }
+        void* pStart = nullptr;
+        void* pMax = nullptr;
+        OpenMFC_File_GetBufferPtr(m_pFile, CFile::bufferRead, nWant, &pStart, &pMax);
+        m_lpBufStart = m_lpBufCur = static_cast<unsigned char*>(pStart);
+        m_lpBufMax = static_cast<unsigned char*>(pMax);
+        return;
+    }
     if (!m_pFile || !m_lpBufStart || m_nBufSize <= 0) return;
 
     // Move remaining data to start of buffer
@@ -1965,11 +2498,16 @@ void CArchive::FillBuffer(UINT nBytesNeeded) {
         return;
     }
 
+    // A socket returns whatever has arrived, so keep reading until the
+    // caller's need is met or the file ends.
     UINT capacity = static_cast<UINT>(m_nBufSize);
-    UINT bytesToRead = capacity - nRemaining;
-
-    UINT nRead = OpenMFC_File_Read(m_pFile, m_lpBufStart + nRemaining, bytesToRead);
-    m_lpBufMax = m_lpBufStart + nRemaining + nRead;
+    UINT nHave = nRemaining;
+    do {
+        UINT nRead = OpenMFC_File_Read(m_pFile, m_lpBufStart + nHave, capacity - nHave);
+        if (nRead == 0) break;
+        nHave += nRead;
+    } while (nHave < nBytesNeeded && nHave < capacity);
+    m_lpBufMax = m_lpBufStart + nHave;
 }
 
 class CArchiveAccess {
@@ -1989,6 +2527,19 @@ extern "C" void MS_ABI impl__FillBuffer_CArchive__QEAAXI_Z(CArchive* pThis, unsi
 void CArchive::WriteBuffer() {
     if (!m_pFile) return;
 
+    if (m_bDirectBuffer) {
+        // Commit what was written into the window and take the next one.
+        if (m_lpBufCur != m_lpBufStart) {
+            OpenMFC_File_GetBufferPtr(m_pFile, CFile::bufferCommit, (UINT)(m_lpBufCur - m_lpBufStart), nullptr, nullptr);
+        }
+        void* pStart = nullptr;
+        void* pMax = nullptr;
+        OpenMFC_File_GetBufferPtr(m_pFile, CFile::bufferWrite, (UINT)m_nBufSize, &pStart, &pMax);
+        m_lpBufStart = m_lpBufCur = static_cast<unsigned char*>(pStart);
+        m_lpBufMax = static_cast<unsigned char*>(pMax);
+        return;
+    }
+
     UINT nBytes = (UINT)(m_lpBufCur - m_lpBufStart);
     if (nBytes > 0) {
         OpenMFC_File_Write(m_pFile, m_lpBufStart, nBytes);
@@ -2030,6 +2581,7 @@ void CArchive::Write(const void* lpBuf, UINT nMax) {
         if (nAvail == 0) {
             WriteBuffer();
             nAvail = (UINT)(m_lpBufMax - m_lpBufCur);
+            if (nAvail == 0) break;  // direct buffer could not grow
         }
 
         UINT nCopy = (nMax - nWritten < nAvail) ? (nMax - nWritten) : nAvail;
@@ -2040,7 +2592,14 @@ void CArchive::Write(const void* lpBuf, UINT nMax) {
 }
 
 void CArchive::Flush() {
-    if (IsStoring()) {
+    if (IsStoring() && m_bDirectBuffer) {
+        // Commit the window without taking another, so the file's buffer is
+        // not grown past what was written.
+        if (m_lpBufCur != m_lpBufStart) {
+            OpenMFC_File_GetBufferPtr(m_pFile, CFile::bufferCommit, (UINT)(m_lpBufCur - m_lpBufStart), nullptr, nullptr);
+        }
+        m_lpBufStart = m_lpBufCur = m_lpBufMax = nullptr;
+    } else if (IsStoring()) {
         WriteBuffer();
     }
     if (m_pFile) {
@@ -2053,11 +2612,218 @@ void CArchive::Close() {
 }
 
 void CArchive::Abort() {
-    // Reset without flushing
+    // Reset without flushing; object indices from before are meaningless now
     m_lpBufCur = m_lpBufStart;
     if (IsLoading()) {
         m_lpBufMax = m_lpBufStart;
     }
+    delete m_pObjectMap;
+    m_pObjectMap = nullptr;
+}
+
+// =============================================================================
+// CArchive object graph (tag format: archive_object_map.h)
+//
+// Every object and class gets the next index the first time it goes through
+// the archive; later references write only that index. The store side looks
+// pointers up in a hash map and the load side indexes an array, so each
+// object costs O(1) however large the graph is, and a shared or cyclic
+// object comes back as one object instead of a copy per reference.
+// =============================================================================
+
+void CArchive::MapObject(const CObject* pOb) {
+    if (!m_pObjectMap) {
+        m_pObjectMap = new (std::nothrow) openmfc_archmap::ObjectMap;
+        if (!m_pObjectMap) return;
+    }
+    if (!pOb) return;   // MFC: MapObject(NULL) only creates the map
+
+    // The index is consumed even if the map cannot record it, so the counter
+    // stays in step with the other side of the archive.
+    openmfc_archmap::ObjectMap& map = *m_pObjectMap;
+    if (IsStoring()) {
+        map.store.Set(pOb, map.nMapCount);
+    } else {
+        map.load.push_back({ const_cast<CObject*>(pOb), 0, false });
+    }
+    ++map.nMapCount;
+}
+
+extern "C" void MS_ABI impl__AfxThrowArchiveException__YAXHPEB_W_Z(int cause, const wchar_t* lpszArchiveName);
+extern "C" void MS_ABI impl__AfxThrowMemoryException__YAXXZ();
+
+// CArchiveException causes (afxwin.h) and CRuntimeClass schema flag.
+enum ArchiveCause { kArchiveBadIndex = 5, kArchiveBadClass = 6, kArchiveBadSchema = 7 };
+const UINT kVersionableSchema = 0x80000000u;
+
+// As MFC, a malformed or foreign graph aborts the load rather than skipping
+// a payload it cannot interpret and misreading everything after it.
+static void ThrowArchiveException(int cause) {
+    impl__AfxThrowArchiveException__YAXHPEB_W_Z(cause, nullptr);
+}
+
+// Index reference to something already in the map: 15 bits inline, else the
+// wBigObjectTag escape and a DWORD.
+static void WriteArchiveIndex(CArchive& ar, uint32_t nIndex, bool bClass) {
+    using namespace openmfc_archmap;
+    if (nIndex < kBigObjectTag) {
+        ar << static_cast<unsigned short>(bClass ? (kClassTag | nIndex) : nIndex);
+    } else {
+        ar << static_cast<unsigned short>(kBigObjectTag);
+        ar << static_cast<unsigned long>(bClass ? (kBigClassTag | nIndex) : nIndex);
+    }
+}
+
+void CArchive::WriteClass(const CRuntimeClass* pClassRef) {
+    if (!pClassRef || !IsStoring()) return;
+    MapObject(nullptr);
+    if (!m_pObjectMap) return;
+
+    openmfc_archmap::ObjectMap& map = *m_pObjectMap;
+    if (uint32_t nIndex = map.store.Lookup(pClassRef)) {
+        WriteArchiveIndex(*this, nIndex, true);
+        return;
+    }
+    *this << openmfc_archmap::kNewClassTag;
+    impl__Store_CRuntimeClass__QEBAXAEAVCArchive___Z(pClassRef, this);
+    map.store.Set(pClassRef, map.nMapCount);
+    ++map.nMapCount;
+}
+
+CRuntimeClass* CArchive::ReadClass(const CRuntimeClass* pClassRefRequested, UINT* pSchema, DWORD* pObTag) {
+    using namespace openmfc_archmap;
+    if (!IsLoading()) return nullptr;
+    MapObject(nullptr);
+
+    unsigned short wTag = kNullTag;
+    *this >> wTag;
+    unsigned long obTag;
+    if (wTag == kBigObjectTag) {
+        obTag = 0;
+        *this >> obTag;
+    } else {
+        obTag = (static_cast<unsigned long>(wTag & kClassTag) << 16) | (wTag & ~kClassTag);
+    }
+    if (!(obTag & kBigClassTag)) {
+        // Null or an object reference: only ReadObject may be handed one
+        if (!pObTag) {
+            ThrowArchiveException(kArchiveBadIndex);
+            return nullptr;
+        }
+        *pObTag = obTag;
+        return nullptr;
+    }
+    if (pObTag) *pObTag = obTag;
+    if (!m_pObjectMap) return nullptr;
+
+    CRuntimeClass* pClassRef = nullptr;
+    UINT nSchema = 0xFFFF;
+    std::vector<LoadEntry>& load = m_pObjectMap->load;
+    if (wTag == kNewClassTag) {
+        pClassRef = impl__Load_CRuntimeClass__SAPEAU1_AEAVCArchive__PEAI_Z(this, &nSchema);
+        if (!pClassRef) {
+            ThrowArchiveException(kArchiveBadClass);
+            return nullptr;
+        }
+        // A versionable class takes any stored schema; Serialize reads it
+        // back through GetObjectSchema.
+        if ((pClassRef->m_wSchema & ~kVersionableSchema) != nSchema &&
+            !(pClassRef->m_wSchema & kVersionableSchema)) {
+            ThrowArchiveException(kArchiveBadSchema);
+            return nullptr;
+        }
+        load.push_back({ pClassRef, nSchema, true });
+        ++m_pObjectMap->nMapCount;
+    } else {
+        unsigned long nIndex = obTag & ~kBigClassTag;
+        if (nIndex == 0 || nIndex >= load.size() || !load[nIndex].bClass) {
+            ThrowArchiveException(kArchiveBadIndex);
+            return nullptr;
+        }
+        pClassRef = static_cast<CRuntimeClass*>(load[nIndex].p);
+        nSchema = load[nIndex].nSchema;
+    }
+    if (pClassRefRequested && !pClassRef->IsDerivedFrom(pClassRefRequested)) {
+        ThrowArchiveException(kArchiveBadClass);
+        return nullptr;
+    }
+    if (pSchema) *pSchema = nSchema;
+    return pClassRef;
+}
+
+void CArchive::SerializeClass(const CRuntimeClass* pClassRef) {
+    if (IsStoring()) {
+        WriteClass(pClassRef);
+    } else {
+        ReadClass(pClassRef, &m_nObjectSchema, nullptr);
+    }
+}
+
+void CArchive::WriteObject(const CObject* pOb) {
+    MapObject(nullptr);
+    if (!pOb || !m_pObjectMap) {
+        *this << openmfc_archmap::kNullTag;
+        return;
+    }
+    if (uint32_t nIndex = m_pObjectMap->store.Lookup(pOb)) {
+        WriteArchiveIndex(*this, nIndex, false);
+        return;
+    }
+
+    const CRuntimeClass* pClass = pOb->GetRuntimeClass();
+    if (pClass == nullptr) {
+        pClass = &CObject::classCObject;
+    }
+    WriteClass(pClass);
+    // Mapped before Serialize so references back to pOb from inside it
+    // (cycles) are written as an index.
+    MapObject(pOb);
+
+    // Conservative format: only write payload if load side can create the object.
+    if (pClass->m_pfnCreateObject) {
+        const_cast<CObject*>(pOb)->Serialize(*this);
+    }
+}
+
+CObject* CArchive::ReadObject(const CRuntimeClass* pClassRefRequested) {
+    UINT nSchema = 0xFFFF;
+    DWORD obTag = 0;
+    CRuntimeClass* pClassRef = ReadClass(pClassRefRequested, &nSchema, &obTag);
+
+    if (!pClassRef) {
+        // Null or a back-reference
+        if (!m_pObjectMap || obTag >= m_pObjectMap->load.size() || m_pObjectMap->load[obTag].bClass) {
+            ThrowArchiveException(kArchiveBadIndex);
+            return nullptr;
+        }
+        CObject* pOb = static_cast<CObject*>(m_pObjectMap->load[obTag].p);
+        if (pOb && pClassRefRequested && !pOb->IsKindOf(pClassRefRequested)) {
+            ThrowArchiveException(kArchiveBadClass);
+            return nullptr;
+        }
+        return pOb;
+    }
+
+    // WriteObject stores no payload for a class that cannot be created, so
+    // such an object comes back null; its index is still mapped to stay in
+    // step with the store side.
+    CObject* pOb = nullptr;
+    if (pClassRef->m_pfnCreateObject) {
+        pOb = pClassRef->CreateObject();
+        if (!pOb) {
+            impl__AfxThrowMemoryException__YAXXZ();
+            return nullptr;
+        }
+    }
+    m_pObjectMap->load.push_back({ pOb, 0, false });
+    ++m_pObjectMap->nMapCount;
+    if (pOb) {
+        UINT nSchemaSave = m_nObjectSchema;
+        m_nObjectSchema = nSchema;
+        pOb->Serialize(*this);
+        m_nObjectSchema = nSchemaSave;
+    }
+    return pOb;
 }
 
 // Reading operators
@@ -2119,25 +2885,7 @@ CArchive& CArchive::operator>>(double& d) {
 }
 
 CArchive& CArchive::operator>>(CObject*& pOb) {
-    unsigned char hasObject = 0;
-    if (Read(&hasObject, sizeof(hasObject)) != sizeof(hasObject) || hasObject == 0) {
-        pOb = nullptr;
-        return *this;
-    }
-
-    unsigned int nSchema = 0xFFFF;
-    CRuntimeClass* pClass = impl__Load_CRuntimeClass__SAPEAU1_AEAVCArchive__PEAI_Z(this, &nSchema);
-    SetObjectSchema(nSchema);
-
-    if (!pClass || !pClass->m_pfnCreateObject) {
-        pOb = nullptr;
-        return *this;
-    }
-
-    pOb = pClass->CreateObject();
-    if (pOb) {
-        pOb->Serialize(*this);
-    }
+    pOb = ReadObject(nullptr);
     return *this;
 }
 
@@ -2222,23 +2970,7 @@ CArchive& CArchive::operator<<(double d) {
 }
 
 CArchive& CArchive::operator<<(const CObject* pOb) {
-    unsigned char hasObject = (pOb != nullptr) ? 1 : 0;
-    Write(&hasObject, sizeof(hasObject));
-
-    if (!hasObject) {
-        return *this;
-    }
-
-    const CRuntimeClass* pClass = pOb->GetRuntimeClass();
-    if (pClass == nullptr) {
-        pClass = &CObject::classCObject;
-    }
-    impl__Store_CRuntimeClass__QEBAXAEAVCArchive___Z(pClass, this);
-
-    // Conservative format: only write payload if load side can create the object.
-    if (pClass->m_pfnCreateObject) {
-        const_cast<CObject*>(pOb)->Serialize(*this);
-    }
+    WriteObject(pOb);
     return *this;
 }
 
@@ -2260,19 +2992,84 @@ CArchive& CArchive::operator<<(const CString& str) {
 }
 
 // String operations
+//
+// Text lines are found in place in m_lpBufCur..m_lpBufMax: memchr (the SSE2
+// kernel in crt_memory.cpp) looks for the terminator's low byte, and whole
+// runs between CRs are copied out at once. FillBuffer only runs when the
+// buffer is exhausted or ends inside a wchar_t.
+namespace {
+
+// First wchar_t ch in [p, pEnd), which spans whole characters. The low byte
+// comes first (little-endian), so memchr finds every candidate.
+const unsigned char* FindArchiveChar(const unsigned char* p, const unsigned char* pEnd, wchar_t ch) {
+    const unsigned char chLow = static_cast<unsigned char>(ch & 0xFF);
+    for (const unsigned char* pScan = p; pScan < pEnd;) {
+        const unsigned char* pHit = static_cast<const unsigned char*>(std::memchr(pScan, chLow, pEnd - pScan));
+        if (!pHit) {
+            return nullptr;
+        }
+        if ((pHit - p) % sizeof(wchar_t) == 0) {
+            wchar_t chHit;
+            std::memcpy(&chHit, pHit, sizeof(chHit));
+            if (chHit == ch) {
+                return pHit;
+            }
+        }
+        pScan = pHit + 1;
+    }
+    return nullptr;
+}
+
+// Bytes available at m_lpBufCur, rounded down to whole characters.
+size_t WholeArchiveChars(const unsigned char* pCur, const unsigned char* pMax) {
+    size_t nBytes = static_cast<size_t>(pMax - pCur);
+    return nBytes - nBytes % sizeof(wchar_t);
+}
+
+// Copies the wchar_t run [p, pEnd) to pDest without its CRs, storing at most
+// nRoom characters; advances p past what was consumed (stripped CRs take no
+// room) and returns the number of characters stored.
+int CopyArchiveRun(wchar_t* pDest, size_t nRoom, const unsigned char*& p, const unsigned char* pEnd) {
+    wchar_t* pOut = pDest;
+    while (p < pEnd && nRoom > 0) {
+        const unsigned char* pCR = FindArchiveChar(p, pEnd, L'\r');
+        const unsigned char* pRunEnd = pCR ? pCR : pEnd;
+        size_t nRun = static_cast<size_t>(pRunEnd - p) / sizeof(wchar_t);
+        if (nRun > nRoom) {
+            nRun = nRoom;
+            pRunEnd = p + nRun * sizeof(wchar_t);
+        }
+        std::memcpy(pOut, p, pRunEnd - p);
+        pOut += nRun;
+        nRoom -= nRun;
+        p = (pRunEnd == pCR) ? pCR + sizeof(wchar_t) : pRunEnd;
+    }
+    return static_cast<int>(pOut - pDest);
+}
+
+} // namespace
+
 int CArchive::ReadString(wchar_t* lpsz, UINT nMax) {
     if (!lpsz || nMax == 0) return 0;
 
     UINT nRead = 0;
-    while (nRead < nMax - 1) {
-        wchar_t ch;
-        if (Read(&ch, sizeof(ch)) != sizeof(ch)) break;
-        if (ch == L'\n') {
-            lpsz[nRead++] = ch;
-            break;
+    bool bEndOfLine = false;
+    while (IsLoading() && !bEndOfLine && nRead < nMax - 1) {
+        size_t nAvail = WholeArchiveChars(m_lpBufCur, m_lpBufMax);
+        if (nAvail == 0) {
+            FillBuffer(sizeof(wchar_t));
+            nAvail = WholeArchiveChars(m_lpBufCur, m_lpBufMax);
+            if (nAvail == 0) break;  // EOF
+        }
+        const unsigned char* pEnd = m_lpBufCur + nAvail;
+        const unsigned char* pNewline = FindArchiveChar(m_lpBufCur, pEnd, L'\n');
+        if (pNewline) {
+            pEnd = pNewline + sizeof(wchar_t);
         }
-        if (ch == L'\r') continue;  // Skip CR
-        lpsz[nRead++] = ch;
+        const unsigned char* pNext = m_lpBufCur;
+        nRead += CopyArchiveRun(lpsz + nRead, nMax - 1 - nRead, pNext, pEnd);
+        bEndOfLine = pNewline && pNext == pEnd;
+        m_lpBufCur += pNext - m_lpBufCur;
     }
     lpsz[nRead] = L'\0';
     return nRead;
@@ -2280,17 +3077,39 @@ int CArchive::ReadString(wchar_t* lpsz, UINT nMax) {
 
 int CArchive::ReadString(CString& rString) {
     rString.Empty();
-    wchar_t buf[256];
-    int nTotal = 0;
-
-    while (true) {
-        int nRead = ReadString(buf, 256);
-        if (nRead == 0) break;
-        rString += buf;
-        nTotal += nRead;
-        if (buf[nRead - 1] == L'\n') break;
+    if (!IsLoading()) return 0;
+
+    // The string's own buffer stays locked across refills and grows by
+    // doubling, so a line longer than the archive buffer is not re-copied
+    // per chunk.
+    int nLen = 0;
+    int nCapacity = 0;
+    wchar_t* pBuf = nullptr;
+    for (;;) {
+        size_t nAvail = WholeArchiveChars(m_lpBufCur, m_lpBufMax);
+        if (nAvail == 0) {
+            FillBuffer(sizeof(wchar_t));
+            nAvail = WholeArchiveChars(m_lpBufCur, m_lpBufMax);
+            if (nAvail == 0) break;  // EOF
+        }
+        const unsigned char* pEnd = m_lpBufCur + nAvail;
+        const unsigned char* pNewline = FindArchiveChar(m_lpBufCur, pEnd, L'\n');
+        if (pNewline) {
+            pEnd = pNewline + sizeof(wchar_t);
+        }
+        int nRun = static_cast<int>((pEnd - m_lpBufCur) / sizeof(wchar_t));
+        if (nLen + nRun > nCapacity) {
+            nCapacity = (nCapacity == 0) ? nRun : std::max(nLen + nRun, nCapacity * 2);
+            if (pBuf) rString.ReleaseBuffer(nLen);
+            pBuf = rString.GetBuffer(nCapacity);
+        }
+        const unsigned char* pNext = m_lpBufCur;
+        nLen += CopyArchiveRun(pBuf + nLen, static_cast<size_t>(nRun), pNext, pEnd);
+        m_lpBufCur += pNext - m_lpBufCur;
+        if (pNewline) break;
     }
-    return nTotal;
+    if (pBuf) rString.ReleaseBuffer(nLen);
+    return nLen;
 }
 
 void CArchive::WriteString(const wchar_t* lpsz) {
@@ -2299,6 +3118,41 @@ void CArchive::WriteString(const wchar_t* lpsz) {
     Write(lpsz, nLen * sizeof(wchar_t));
 }
 
+// MFC's count format: a WORD, escaping through 0xFFFF to a DWORD and
+// through 0xFFFFFFFF to a QWORD, so small counts stay two bytes.
+void CArchive::WriteCount(DWORD_PTR dwCount) {
+    if (dwCount < 0xFFFF) {
+        *this << static_cast<unsigned short>(dwCount);
+        return;
+    }
+    *this << static_cast<unsigned short>(0xFFFF);
+    if (dwCount < 0xFFFFFFFF) {
+        const DWORD dwCount32 = static_cast<DWORD>(dwCount);
+        Write(&dwCount32, sizeof(dwCount32));
+        return;
+    }
+    const DWORD dwEscape = 0xFFFFFFFF;
+    Write(&dwEscape, sizeof(dwEscape));
+    const unsigned long long qwCount = dwCount;
+    Write(&qwCount, sizeof(qwCount));
+}
+
+DWORD_PTR CArchive::ReadCount() {
+    unsigned short wCount = 0;
+    *this >> wCount;
+    if (wCount != 0xFFFF) {
+        return wCount;
+    }
+    DWORD dwCount = 0;
+    Read(&dwCount, sizeof(dwCount));
+    if (dwCount != 0xFFFFFFFF) {
+        return dwCount;
+    }
+    unsigned long long qwCount = 0;
+    Read(&qwCount, sizeof(qwCount));
+    return static_cast<DWORD_PTR>(qwCount);
+}
+
 // Symbol: ?GetObjectSchema@CArchive@@QEAAIXZ
 extern "C" unsigned int MS_ABI impl__GetObjectSchema_CArchive__QEAAIXZ(CArchive* pThis) {
     return pThis ? pThis->GetObjectSchema() : 0;
@@ -2307,14 +3161,12 @@ extern "C" unsigned int MS_ABI impl__GetObjectSchema_CArchive__QEAAIXZ(CArchive*
 // Symbol: ?WriteCount@CArchive@@QEAAX_K@Z
 extern "C" void MS_ABI impl__WriteCount_CArchive__QEAAX_K_Z(CArchive* pThis, unsigned long long count) {
     if (!pThis) return;
-    pThis->Write(&count, sizeof(count));
+    pThis->WriteCount(static_cast<DWORD_PTR>(count));
 }
 
 // Symbol: ?ReadCount@CArchive@@QEAA_KXZ
 extern "C" unsigned long long MS_ABI impl__ReadCount_CArchive__QEAA_KXZ(CArchive* pThis) {
-    unsigned long long count = 0;
-    if (pThis) pThis->Read(&count, sizeof(count));
-    return count;
+    return pThis ? pThis->ReadCount() : 0;
 }
 
 // Symbol: ?CheckCount@CArchive@@QEAAXXZ
@@ -2324,35 +3176,28 @@ extern "C" void MS_ABI impl__CheckCount_CArchive__QEAAXXZ(CArchive* pThis) {
 
 // Symbol: ?WriteClass@CArchive@@QEAAXPEBUCRuntimeClass@@@Z
 extern "C" void MS_ABI impl__WriteClass_CArchive__QEAAXPEBUCRuntimeClass___Z(CArchive* pThis, const CRuntimeClass* pClass) {
-    if (pThis && pClass) impl__Store_CRuntimeClass__QEBAXAEAVCArchive___Z(pClass, pThis);
+    if (pThis) pThis->WriteClass(pClass);
 }
 
 // Symbol: ?SerializeClass@CArchive@@QEAAXPEBUCRuntimeClass@@@Z
 extern "C" void MS_ABI impl__SerializeClass_CArchive__QEAAXPEBUCRuntimeClass___Z(CArchive* pThis, const CRuntimeClass* pClass) {
-    if (pThis && pThis->IsStoring()) impl__WriteClass_CArchive__QEAAXPEBUCRuntimeClass___Z(pThis, pClass);
-    else if (pThis) {
-        unsigned int schema = 0;
-        (void)impl__Load_CRuntimeClass__SAPEAU1_AEAVCArchive__PEAI_Z(pThis, &schema);
-        pThis->SetObjectSchema(schema);
-    }
+    if (pThis) pThis->SerializeClass(pClass);
 }
 
 // Symbol: ?ReadClass@CArchive@@QEAAPEAUCRuntimeClass@@PEBU2@PEAIPEAK@Z
 extern "C" CRuntimeClass* MS_ABI impl__ReadClass_CArchive__QEAAPEAUCRuntimeClass__PEBU2_PEAIPEAK_Z(
-    CArchive* pThis, const CRuntimeClass*, unsigned int* schema, unsigned long*) {
-    return pThis ? impl__Load_CRuntimeClass__SAPEAU1_AEAVCArchive__PEAI_Z(pThis, schema) : nullptr;
+    CArchive* pThis, const CRuntimeClass* pClassRefRequested, unsigned int* schema, unsigned long* obTag) {
+    return pThis ? pThis->ReadClass(pClassRefRequested, schema, obTag) : nullptr;
 }
 
 // Symbol: ?WriteObject@CArchive@@QEAAXPEBVCObject@@@Z
 extern "C" void MS_ABI impl__WriteObject_CArchive__QEAAXPEBVCObject___Z(CArchive* pThis, const CObject* object) {
-    if (pThis) (*pThis) << object;
+    if (pThis) pThis->WriteObject(object);
 }
 
 // Symbol: ?ReadObject@CArchive@@QEAAPEAVCObject@@PEBUCRuntimeClass@@@Z
-extern "C" CObject* MS_ABI impl__ReadObject_CArchive__QEAAPEAVCObject__PEBUCRuntimeClass___Z(CArchive* pThis, const CRuntimeClass*) {
-    CObject* object = nullptr;
-    if (pThis) (*pThis) >> object;
-    return object;
+extern "C" CObject* MS_ABI impl__ReadObject_CArchive__QEAAPEAVCObject__PEBUCRuntimeClass___Z(CArchive* pThis, const CRuntimeClass* pClassRefRequested) {
+    return pThis ? pThis->ReadObject(pClassRefRequested) : nullptr;
 }
 
 // Symbol: ?ReadString@CArchive@@QEAAHAEAV?$CStringT@_WV?$StrTraitMFC_DLL@_WV?$ChTraitsCRT@_W@ATL@@@@@ATL@@@Z
@@ -2361,11 +3206,15 @@ extern "C" int MS_ABI impl__ReadString_CArchive__QEAAHAEAV__CStringT__WV__StrTra
 }
 
 // Symbol: ?MapObject@CArchive@@QEAAXPEBVCObject@@@Z
-extern "C" void MS_ABI impl__MapObject_CArchive__QEAAXPEBVCObject___Z(CArchive*, const CObject*) {
+extern "C" void MS_ABI impl__MapObject_CArchive__QEAAXPEBVCObject___Z(CArchive* pThis, const CObject* object) {
+    if (pThis) pThis->MapObject(object);
 }
 
 // Symbol: ?EnsureSchemaMapExists@CArchive@@QEAAXPEAPEAV?$CArray@W4LoadArrayObjType@CArchive@@AEBW412@@@@Z
-extern "C" void MS_ABI impl__EnsureSchemaMapExists_CArchive__QEAAXPEAPEAV__CArray_W4LoadArrayObjType_CArchive__AEBW412____Z(CArchive*, void**) {
+extern "C" void MS_ABI impl__EnsureSchemaMapExists_CArchive__QEAAXPEAPEAV__CArray_W4LoadArrayObjType_CArchive__AEBW412____Z(CArchive* pThis, void**) {
+    // Stored schemas live in the load array itself; there is no separate
+    // CArray to hand back.
+    if (pThis) pThis->MapObject(nullptr);
 }
 
 // =============================================================================
@@ -2493,12 +3342,12 @@ struct CFileAccessor : CFile {
 };
 
 struct CMemFileAccessor : CMemFile {
-    static UINT& Position(CMemFile* pFile) { return static_cast<CMemFileAccessor*>(pFile)->m_nPosition; }
-    static UINT Position(const CMemFile* pFile) { return static_cast<const CMemFileAccessor*>(pFile)->m_nPosition; }
-    static UINT GrowBytes(const CMemFile* pFile) { return static_cast<const CMemFileAccessor*>(pFile)->m_nGrowBytes; }
+    static SIZE_T& Position(CMemFile* pFile) { return static_cast<CMemFileAccessor*>(pFile)->m_nPosition; }
+    static SIZE_T Position(const CMemFile* pFile) { return static_cast<const CMemFileAccessor*>(pFile)->m_nPosition; }
+    static SIZE_T GrowBytes(const CMemFile* pFile) { return static_cast<const CMemFileAccessor*>(pFile)->m_nGrowBytes; }
     static BYTE* Buffer(CMemFile* pFile) { return static_cast<CMemFileAccessor*>(pFile)->m_lpBuffer; }
     static const BYTE* Buffer(const CMemFile* pFile) { return static_cast<const CMemFileAccessor*>(pFile)->m_lpBuffer; }
-    static UINT BufferSize(const CMemFile* pFile) { return static_cast<const CMemFileAccessor*>(pFile)->m_nBufferSize; }
+    static bool Grow(CMemFile* pFile, SIZE_T nNewLen) { return static_cast<CMemFileAccessor*>(pFile)->GrowBuffer(nNewLen); }
 };
 
 struct CStdioFileAccessor : CStdioFile {
@@ -2655,7 +3504,9 @@ extern "C" void MS_ABI impl__Close_CMemFile__UEAAXXZ(CMemFile* pThis) {
 // Symbol: ?Duplicate@CMemFile@@UEBAPEAVCFile@@XZ
 extern "C" CFile* MS_ABI impl__Duplicate_CMemFile__UEBAPEAVCFile__XZ(const CMemFile* pThis) {
     if (!pThis) return nullptr;
-    CMemFile* pDup = new CMemFile(CMemFileAccessor::GrowBytes(pThis));
+    // The copy owns its buffer, so it may grow even if the original cannot.
+    const SIZE_T nGrowBytes = CMemFileAccessor::GrowBytes(pThis);
+    CMemFile* pDup = new CMemFile(nGrowBytes ? static_cast<UINT>(nGrowBytes) : 1024);
     ULONGLONG len = pThis->GetLength();
     if (len > 0) {
         pDup->SetLength(len);
@@ -2667,22 +3518,8 @@ extern "C" CFile* MS_ABI impl__Duplicate_CMemFile__UEBAPEAVCFile__XZ(const CMemF
 
 // Symbol: ?GetBufferPtr@CMemFile@@UEAAIIIPEAPEAX0@Z
 extern "C" unsigned int MS_ABI impl__GetBufferPtr_CMemFile__UEAAIIIPEAPEAX0_Z(
-    CMemFile* pThis, unsigned int /*nCommand*/, unsigned int nCount, void** ppBufStart, void** ppBufMax) {
-    if (!pThis) return 0;
-    if (ppBufStart) {
-        BYTE* buf = CMemFileAccessor::Buffer(pThis);
-        UINT pos = CMemFileAccessor::Position(pThis);
-        UINT size = CMemFileAccessor::BufferSize(pThis);
-        *ppBufStart = (buf && pos < size) ? (void*)(buf + pos) : nullptr;
-    }
-    if (ppBufMax) {
-        BYTE* buf = CMemFileAccessor::Buffer(pThis);
-        *ppBufMax = buf ? (void*)(buf + CMemFileAccessor::BufferSize(pThis)) : nullptr;
-    }
-    UINT pos = CMemFileAccessor::Position(pThis);
-    UINT size = CMemFileAccessor::BufferSize(pThis);
-    UINT nAvail = (pos < size) ? (size - pos) : 0;
-    return (nCount < nAvail) ? nCount : nAvail;
+    CMemFile* pThis, unsigned int nCommand, unsigned int nCount, void** ppBufStart, void** ppBufMax) {
+    return pThis ? pThis->GetBufferPtr(nCommand, nCount, ppBufStart, ppBufMax) : 0;
 }
 
 // Symbol: ?GetStatus@CMemFile@@QEBAHAEAUCFileStatus@@@Z
@@ -2721,7 +3558,21 @@ extern "C" unsigned char* MS_ABI impl__Memcpy_CMemFile__MEAAPEAEPEAEPEBE_K_Z(
 // Symbol: ?GrowFile@CMemFile@@MEAAX_K@Z
 extern "C" void MS_ABI impl__GrowFile_CMemFile__MEAAX_K_Z(CMemFile* pThis, unsigned long long dwNewLen) {
     if (!pThis) return;
-    pThis->SetLength(dwNewLen);
+    if (!CMemFileAccessor::Grow(pThis, static_cast<SIZE_T>(dwNewLen))) {
+        ThrowMemFileFull();
+    }
+}
+
+// OpenMFC extensions, not in the MFC ordinal map: build_phase4.sh adds these
+// two to the .def file.
+// Symbol: ?SetGeometricGrowth@CMemFile@@QEAAX_K@Z
+extern "C" void MS_ABI impl__SetGeometricGrowth_CMemFile__QEAAX_K_Z(CMemFile* pThis, unsigned long long nMaxGrowBytes) {
+    if (pThis) pThis->SetGeometricGrowth(static_cast<SIZE_T>(nMaxGrowBytes));
+}
+
+// Symbol: ?ReserveAddressSpace@CMemFile@@QEAAH_K@Z
+extern "C" int MS_ABI impl__ReserveAddressSpace_CMemFile__QEAAH_K_Z(CMemFile* pThis, unsigned long long nMaxSize) {
+    return pThis ? pThis->ReserveAddressSpace(nMaxSize) : FALSE;
 }
 
 // Symbol: ?LockRange@CMemFile@@UEAAX_K0@Z
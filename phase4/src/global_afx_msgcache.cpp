@@ -0,0 +1,152 @@
+// Global residuals: message-map entry lookup and the per-thread dispatch cache.
+//
+// AfxFindMessageEntry scans one AFX_MSGMAP_ENTRY table. OpenMfcLookupMessageEntry
+// resolves (map, message, code, id) across the whole pfnGetBaseMap chain and
+// remembers the answer -- including "no handler", which is the common case for
+// ON_UPDATE_COMMAND_UI idle passes -- in a bounded per-thread table, as MFC's
+// _afxMsgCache does (ours is two-way set associative, so two hot keys that
+// hash alike do not keep evicting each other). Message maps are static const
+// data, so a cached answer only goes stale if the module that owns the map is
+// unloaded. AfxTermExtensionModule (cobject_impl.cpp) then calls
+// OpenMfcFlushMessageCache, which bumps a global generation; each thread
+// compares it on every lookup and empties its own table when it has moved.
+// CCmdTarget::OnCmdMsg (appcore.cpp) and the CWnd::OnWndMsg export
+// (wincore.cpp) both route through here.
+//
+// Named global_*; build_phase4.sh's shard glob compiles global_*.
+
+#include "openmfc/afxwin.h"   // AFX_MSGMAP, AFX_MSGMAP_ENTRY, AfxSig_end
+
+#ifdef __GNUC__
+  #define MS_ABI __attribute__((ms_abi))
+#else
+  #define MS_ABI
+#endif
+
+namespace {
+
+// 256 sets x 2 ways x 32 bytes keeps each thread's table at 16 KB.
+const UINT kMsgCacheSetBits = 8;
+const UINT kMsgCacheWays = 2;
+
+struct MsgCacheEntry {
+    const AFX_MSGMAP* pMap;             // null: slot unused
+    UINT nMessage;
+    UINT nCode;
+    UINT nID;
+    const AFX_MSGMAP_ENTRY* lpEntry;    // null: no handler anywhere in the chain
+};
+
+struct MsgCache {
+    MsgCacheEntry sets[1u << kMsgCacheSetBits][kMsgCacheWays];   // way 0 is most recent
+    ULONGLONG nHits;
+    ULONGLONG nMisses;
+    LONG nGeneration;                   // g_nMsgCacheGeneration when last emptied
+};
+
+// Plain zero-initialised data, so the thread_local needs no constructor call.
+thread_local MsgCache g_msgCache;
+
+volatile LONG g_nMsgCacheGeneration = 0;
+
+// The calling thread's cache, emptied first if a flush happened since.
+MsgCache& CurrentMsgCache() {
+    MsgCache& cache = g_msgCache;
+    const LONG nGeneration = g_nMsgCacheGeneration;
+    if (cache.nGeneration != nGeneration) {
+        for (UINT i = 0; i < (1u << kMsgCacheSetBits); ++i) {
+            for (UINT way = 0; way < kMsgCacheWays; ++way) {
+                cache.sets[i][way].pMap = nullptr;
+            }
+        }
+        cache.nHits = 0;
+        cache.nMisses = 0;
+        cache.nGeneration = nGeneration;
+    }
+    return cache;
+}
+
+UINT HashMsgKey(const AFX_MSGMAP* pMap, UINT nMessage, UINT nCode, UINT nID) {
+    ULONGLONG h = reinterpret_cast<UINT_PTR>(pMap);
+    h ^= (static_cast<ULONGLONG>(nMessage) << 32) | nID;
+    h ^= static_cast<ULONGLONG>(nCode) * 0xC2B2AE3D27D4EB4FULL;
+    h *= 0x9E3779B97F4A7C15ULL;
+    return static_cast<UINT>(h >> (64 - kMsgCacheSetBits));
+}
+
+bool MatchesKey(const MsgCacheEntry& e, const AFX_MSGMAP* pMap, UINT nMessage, UINT nCode, UINT nID) {
+    return e.pMap == pMap && e.nMessage == nMessage && e.nCode == nCode && e.nID == nID;
+}
+
+} // namespace
+
+// Symbol: ?AfxFindMessageEntry@@YAPEBUAFX_MSGMAP_ENTRY@@PEBU1@III@Z
+extern "C" const AFX_MSGMAP_ENTRY* MS_ABI impl__AfxFindMessageEntry__YAPEBUAFX_MSGMAP_ENTRY__PEBU1_III_Z(
+    const AFX_MSGMAP_ENTRY* lpEntry, UINT nMsg, UINT nCode, UINT nID)
+{
+    if (lpEntry == nullptr) {
+        return nullptr;
+    }
+    for (; lpEntry->nSig != AfxSig_end; ++lpEntry) {
+        if (lpEntry->nMessage == nMsg && lpEntry->nCode == nCode &&
+            nID >= lpEntry->nID && nID <= lpEntry->nLastID) {
+            return lpEntry;
+        }
+    }
+    return nullptr;
+}
+
+// Walks pMap and its bases for the first entry handling (nMsg, nCode, nID).
+const AFX_MSGMAP_ENTRY* OpenMfcLookupMessageEntry(const AFX_MSGMAP* pMap, UINT nMsg, UINT nCode, UINT nID)
+{
+    if (pMap == nullptr) {
+        return nullptr;
+    }
+
+    MsgCache& cache = CurrentMsgCache();
+    MsgCacheEntry* set = cache.sets[HashMsgKey(pMap, nMsg, nCode, nID)];
+    if (MatchesKey(set[0], pMap, nMsg, nCode, nID)) {
+        ++cache.nHits;
+        return set[0].lpEntry;
+    }
+    if (MatchesKey(set[1], pMap, nMsg, nCode, nID)) {
+        ++cache.nHits;
+        MsgCacheEntry hit = set[1];
+        set[1] = set[0];
+        set[0] = hit;
+        return hit.lpEntry;
+    }
+    ++cache.nMisses;
+
+    const AFX_MSGMAP_ENTRY* lpFound = nullptr;
+    for (const AFX_MSGMAP* pCur = pMap; pCur != nullptr && lpFound == nullptr;
+         pCur = pCur->pfnGetBaseMap ? (*pCur->pfnGetBaseMap)() : nullptr) {
+        lpFound = impl__AfxFindMessageEntry__YAPEBUAFX_MSGMAP_ENTRY__PEBU1_III_Z(pCur->lpEntries, nMsg, nCode, nID);
+    }
+
+    set[1] = set[0];
+    set[0].pMap = pMap;
+    set[0].nMessage = nMsg;
+    set[0].nCode = nCode;
+    set[0].nID = nID;
+    set[0].lpEntry = lpFound;
+    return lpFound;
+}
+
+// Hit/miss counters for the calling thread since the last flush.
+void OpenMfcGetMessageCacheStats(ULONGLONG* pnHits, ULONGLONG* pnMisses)
+{
+    const MsgCache& cache = CurrentMsgCache();
+    if (pnHits) {
+        *pnHits = cache.nHits;
+    }
+    if (pnMisses) {
+        *pnMisses = cache.nMisses;
+    }
+}
+
+// Drops every thread's entries; each thread notices on its next lookup.
+void OpenMfcFlushMessageCache()
+{
+    ::InterlockedIncrement(&g_nMsgCacheGeneration);
+}
@@ -7,15 +7,18 @@
 //   offset 8: CFile*  m_pFile    (8 bytes)
 //
 // OutputString() writes the wide-char text via m_pFile->Write() (CFile::Write
-// is virtual, afx.h:445) or OutputDebugStringW when m_pFile == nullptr.
-// operator<< / DumpAsHex format their argument into a wide buffer and call
-// OutputString, returning *this. Flush() forwards to m_pFile->Flush().
+// is virtual, afx.h:445) or, when m_pFile == nullptr, to the shared buffered
+// debug channel (dump_channel.h) that AfxDump also uses, so fragments reach
+// the debugger as whole lines. operator<< / DumpAsHex format their argument
+// into a wide buffer and call OutputString, returning *this. Flush() forwards
+// to m_pFile->Flush() or flushes the debug channel.
 
 #define OPENMFC_APPCORE_IMPL
 // CDumpContext only needs CObject and CFile, both declared in afx.h. Including
 // the lighter afx.h (instead of the full afxmfc.h) avoids dragging in CWnd /
 // CCmdTarget vtables that have no out-of-line defs in a standalone build.
 #include "openmfc/afx.h"
+#include "dump_channel.h"
 
 #include <cstdint>
 #include <cstdio>
@@ -95,7 +98,7 @@ void CDumpContext::OutputString(LPCWSTR lpsz) {
         UINT nBytes = static_cast<UINT>(wcslen(lpsz) * sizeof(wchar_t));
         OpenMFC_File_Write(m_pFile, lpsz, nBytes);
     } else {
-        OutputDebugStringW(lpsz);
+        openmfc_dump::DebugChannel().Write(lpsz);
     }
 }
 
@@ -269,6 +272,8 @@ CDumpContext& CDumpContext::DumpAsHex(unsigned short w) {
 void CDumpContext::Flush() {
     if (m_pFile != nullptr) {
         OpenMFC_File_Flush(m_pFile);
+    } else {
+        openmfc_dump::DebugChannel().Flush();
     }
 }
 
@@ -5,6 +5,11 @@
 // looked up (GetDataNA) or lazily created (GetData) through that slot. The
 // destructor releases the slot and destroys every thread's value bound to it.
 //
+// As in MFC, slots come from one process-wide CThreadSlotData (_afxThreadData,
+// global_cthreadslotdata.cpp), so a lookup is TlsGetValue plus an array index
+// with no lock; only slot allocation/free and a thread's first use of a slot
+// take the slot table's critical section.
+//
 // Layout (cl.exe /d1reportSingleClassLayout):
 //   class CThreadLocalObject size(4):
 //     +---
@@ -15,7 +20,6 @@
 #include <windows.h>
 #include <cstdint>
 #include <cstddef>
-#include <unordered_map>
 
 #ifdef __GNUC__
   #define MS_ABI __attribute__((ms_abi))
@@ -23,6 +27,16 @@
   #define MS_ABI
 #endif
 
+// global_cthreadslotdata.cpp
+struct CThreadSlotData;
+CThreadSlotData* OpenMfcGetThreadSlotData();
+void* OpenMfcGetThreadSlotValue(CThreadSlotData* pThis, int slot);
+void OpenMfcFreeThreadSlot(CThreadSlotData* pThis, int slot, void (*pfnDestroy)(void*));
+extern "C" int MS_ABI impl__AllocSlot_CThreadSlotData__QEAAHXZ(CThreadSlotData* pThis);
+extern "C" void MS_ABI impl__FreeSlot_CThreadSlotData__QEAAXH_Z(CThreadSlotData* pThis, int slot);
+extern "C" void MS_ABI impl__SetValue_CThreadSlotData__QEAAXHPEAX_Z(
+    CThreadSlotData* pThis, int slot, void* pValue);
+
 // Layout-faithful mirror of CThreadLocalObject.
 struct S {
     DWORD m_nSlot;   // 0 == unallocated
@@ -35,42 +49,20 @@ static_assert(offsetof(S, m_nSlot) == 0, "m_nSlot at offset 0");
 // opaquely, invoking that slot to destroy them faithfully.
 namespace {
 
-// Global thread-local slot store. Values are keyed by (threadId, slot) so a
-// single slot index yields an independent value per thread — exactly the
-// semantics of MFC's CThreadSlotData.
-struct Store {
-    CRITICAL_SECTION cs;
-    std::unordered_map<uint64_t, void*> values;
-    DWORD nextSlot;
-    Store() : nextSlot(1) { InitializeCriticalSection(&cs); }
-    ~Store() {
-        // Release the lock object. We intentionally do NOT walk `values` calling
-        // each object's virtual destructor here: this runs at static-destruction
-        // (DLL unload / process teardown), where those objects' vtables may live
-        // in a module already unloaded — dispatching through them would crash.
-        // Any surviving thread-local values are process-lifetime and reclaimed by
-        // the OS at teardown. Per-slot values are freed in the exported destructor.
-        DeleteCriticalSection(&cs);
+// Allocate the object's slot on first use. Two threads may race here for the
+// same object; the loser hands its slot back.
+DWORD ensureSlot(S* p, CThreadSlotData* pSlots) {
+    int slot = impl__AllocSlot_CThreadSlotData__QEAAHXZ(pSlots);
+    if (slot <= 0) {
+        return 0;
     }
-};
-
-// C++11 guarantees thread-safe initialization of function-local statics.
-Store& store() {
-    static Store s;
-    return s;
-}
-
-inline uint64_t makeKey(DWORD slot) {
-    return (static_cast<uint64_t>(GetCurrentThreadId()) << 32)
-         | static_cast<uint64_t>(slot);
-}
-
-DWORD allocSlot() {
-    Store& s = store();
-    EnterCriticalSection(&s.cs);
-    DWORD slot = s.nextSlot++;
-    LeaveCriticalSection(&s.cs);
-    return slot;
+    LONG prev = InterlockedCompareExchange(reinterpret_cast<volatile LONG*>(&p->m_nSlot),
+                                           static_cast<LONG>(slot), 0);
+    if (prev != 0) {
+        impl__FreeSlot_CThreadSlotData__QEAAXH_Z(pSlots, slot);
+        return static_cast<DWORD>(prev);
+    }
+    return static_cast<DWORD>(slot);
 }
 
 // Destroy a CNoTrackObject value via its virtual (vector-)deleting destructor.
@@ -88,18 +80,8 @@ void destroyValue(void* val) {
 extern "C" void MS_ABI impl___1CThreadLocalObject__QEAA_XZ(void* pThis) {
     S* p = reinterpret_cast<S*>(pThis);
     if (p->m_nSlot != 0) {
-        Store& s = store();
-        EnterCriticalSection(&s.cs);
-        const DWORD slot = p->m_nSlot;
-        for (auto it = s.values.begin(); it != s.values.end(); ) {
-            if (static_cast<DWORD>(it->first & 0xFFFFFFFFu) == slot) {
-                destroyValue(it->second);
-                it = s.values.erase(it);
-            } else {
-                ++it;
-            }
-        }
-        LeaveCriticalSection(&s.cs);
+        // Visits one array cell per thread rather than every value in the process.
+        OpenMfcFreeThreadSlot(OpenMfcGetThreadSlotData(), static_cast<int>(p->m_nSlot), destroyValue);
         p->m_nSlot = 0;
     }
 }
@@ -109,27 +91,24 @@ extern "C" void MS_ABI impl___1CThreadLocalObject__QEAA_XZ(void* pThis) {
 extern "C" void* MS_ABI impl__GetData_CThreadLocalObject__QEAAPEAVCNoTrackObject__P6APEAV2_XZ_Z(
         void* pThis, void* pfnCreateObject) {
     S* p = reinterpret_cast<S*>(pThis);
+    CThreadSlotData* pSlots = OpenMfcGetThreadSlotData();
 
     // Allocate a slot lazily on first use.
-    if (p->m_nSlot == 0) {
-        p->m_nSlot = allocSlot();
+    DWORD slot = p->m_nSlot;
+    if (slot == 0) {
+        slot = ensureSlot(p, pSlots);
+        if (slot == 0) {
+            return nullptr;
+        }
     }
 
-    Store& s = store();
-    const uint64_t k = makeKey(p->m_nSlot);
-
-    EnterCriticalSection(&s.cs);
-    auto it = s.values.find(k);
-    void* val = (it != s.values.end()) ? it->second : nullptr;
-    LeaveCriticalSection(&s.cs);
+    void* val = OpenMfcGetThreadSlotValue(pSlots, static_cast<int>(slot));
 
     // Create the per-thread value on first access.
     if (val == nullptr && pfnCreateObject != nullptr) {
         typedef void* (MS_ABI *CreateFn)();
         val = reinterpret_cast<CreateFn>(pfnCreateObject)();
-        EnterCriticalSection(&s.cs);
-        s.values[k] = val;
-        LeaveCriticalSection(&s.cs);
+        impl__SetValue_CThreadSlotData__QEAAXHPEAX_Z(pSlots, static_cast<int>(slot), val);
     }
     return val;
 }
@@ -142,10 +121,5 @@ extern "C" void* MS_ABI impl__GetDataNA_CThreadLocalObject__QEAAPEAVCNoTrackObje
     if (p->m_nSlot == 0) {
         return nullptr;
     }
-    Store& s = store();
-    EnterCriticalSection(&s.cs);
-    auto it = s.values.find(makeKey(p->m_nSlot));
-    void* val = (it != s.values.end()) ? it->second : nullptr;
-    LeaveCriticalSection(&s.cs);
-    return val;
+    return OpenMfcGetThreadSlotValue(OpenMfcGetThreadSlotData(), static_cast<int>(p->m_nSlot));
 }
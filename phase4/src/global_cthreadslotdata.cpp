@@ -15,6 +15,11 @@
 //   off 32  CSlotData*       m_pSlotData
 //   off 40  CRITICAL_SECTION m_sect      (40 bytes on x64)
 //
+// Locking: m_sect guards the slot table and m_list. A thread's node and its
+// value array are only allocated, grown or freed by that thread (under m_sect,
+// since FreeSlot / DeleteValues walk them from other threads), so GetThreadValue
+// and SetValue on an already-sized slot are a TlsGetValue plus one load/store.
+//
 // All 8 exported symbols are QEAA (public, non-virtual, x64 member): `this` is
 // passed in RCX and MUST be the first parameter of each impl, mirroring
 // collections_csimplelist.cpp.
@@ -77,9 +82,27 @@ static_assert(offsetof(CThreadSlotData, m_list) == 16, "m_list@16");
 static_assert(offsetof(CThreadSlotData, m_pSlotData) == 32, "m_pSlotData@32");
 static_assert(offsetof(CThreadSlotData, m_sect) == 40, "m_sect@40");
 
+extern "C" void MS_ABI impl__DeleteValues_CThreadSlotData__QEAAXPEAUHINSTANCE____H_Z(
+    CThreadSlotData* pThis, HINSTANCE hInst, int bAll);
+
 namespace {
 
+// Process-wide instance (OpenMfcGetThreadSlotData); null until first use.
+CThreadSlotData* g_pProcessSlotData = nullptr;
+
+// Thread-detach hook for the process-wide instance: MFC's AfxTermThread
+// calls DeleteValues(NULL, FALSE) so an exiting thread deletes what it left
+// bound. Armed by the thread's first node. Other instances may be destroyed
+// before their threads exit, so only the process-wide one, which never is,
+// gets the hook.
+struct ThreadDetach {
+    ~ThreadDetach() {
+        impl__DeleteValues_CThreadSlotData__QEAAXPEAUHINSTANCE____H_Z(g_pProcessSlotData, nullptr, FALSE);
+    }
+};
+
 // Get-or-create this thread's CThreadData node, linking it into m_list.
+// Caller holds m_sect (m_list is shared with FreeSlot / DeleteValues).
 CThreadData* GetOrCreateThreadData(CThreadSlotData* pThis) {
     CThreadData* pData = (CThreadData*)TlsGetValue(pThis->m_tlsIndex);
     if (pData == nullptr) {
@@ -93,15 +116,26 @@ CThreadData* GetOrCreateThreadData(CThreadSlotData* pThis) {
         // AddHead into m_list (m_nNextOffset == 0 == offsetof(pNext)).
         *(void**)((BYTE*)pData + pThis->m_list.m_nNextOffset) = pThis->m_list.m_pHead;
         pThis->m_list.m_pHead = pData;
+        if (pThis == g_pProcessSlotData) {
+            thread_local ThreadDetach detach;
+            (void)detach;
+        }
     }
     return pData;
 }
 
-// Ensure pData->pData can index [slot], zero-filling new entries.
-bool GrowThreadData(CThreadData* pData, int slot) {
+// Ensure pData->pData can index [slot], zero-filling new entries. Sized to
+// cover every allocated slot (and at least double) so a thread touching its
+// slots in ascending order reallocates once, not once per slot. Caller holds
+// m_sect: other threads walk this array in FreeSlot / DeleteValues(bAll).
+bool GrowThreadData(CThreadSlotData* pThis, CThreadData* pData, int slot) {
     if (slot < pData->nCount)
         return true;
     int newCount = slot + 1;
+    if (newCount < pThis->m_nMax)
+        newCount = pThis->m_nMax;
+    if (newCount < pData->nCount * 2)
+        newCount = pData->nCount * 2;
     void** p = (void**)realloc(pData->pData, (size_t)newCount * sizeof(void*));
     if (p == nullptr)
         return false;
@@ -112,6 +146,56 @@ bool GrowThreadData(CThreadData* pData, int slot) {
     return true;
 }
 
+// Delete a CNoTrackObject value via its virtual (vector-)deleting destructor,
+// slot 0 of its vtable.
+void DeleteNoTrackObject(void* pValue) {
+    void** vtbl = *reinterpret_cast<void***>(pValue);
+    if (vtbl == nullptr)
+        return;
+    typedef void* (MS_ABI *DelDtor)(void*, unsigned);
+    reinterpret_cast<DelDtor>(vtbl[0])(pValue, 1u); // flag bit0 => operator delete
+}
+
+// Delete one thread's values for slots owned by hInst (all slots when null),
+// as MFC's DeleteValues does. Returns true when the node holds no values
+// afterwards. Caller holds m_sect.
+bool ClearThreadData(CThreadSlotData* pThis, CThreadData* pData, HINSTANCE hInst) {
+    if (pData->pData == nullptr)
+        return true;
+    bool bEmpty = true;
+    for (int i = 1; i < pData->nCount; ++i) {
+        void* pValue = pData->pData[i];
+        if (pValue == nullptr)
+            continue;
+        if (i < pThis->m_nMax && (hInst == nullptr || pThis->m_pSlotData[i].hInst == hInst)) {
+            // Cleared first: the destructor may look its own slot up again.
+            pData->pData[i] = nullptr;
+            DeleteNoTrackObject(pValue);
+        } else {
+            bEmpty = false;
+        }
+    }
+    return bEmpty;
+}
+
+// Per-thread teardown: once the calling thread's node holds nothing, unlink
+// and free it so an exited thread leaves no node behind. Only the owning
+// thread may do this; its TLS value is the node's other reference. Caller
+// holds m_sect.
+void ReleaseThreadData(CThreadSlotData* pThis, CThreadData* pData) {
+    const size_t off = pThis->m_list.m_nNextOffset;
+    for (void** ppLink = &pThis->m_list.m_pHead; *ppLink != nullptr;
+         ppLink = (void**)((BYTE*)*ppLink + off)) {
+        if (*ppLink == pData) {
+            *ppLink = *(void**)((BYTE*)pData + off);
+            break;
+        }
+    }
+    TlsSetValue(pThis->m_tlsIndex, nullptr);
+    free(pData->pData);
+    free(pData);
+}
+
 } // namespace
 
 void* CThreadSlotData::GetThreadValue(int slot) {
@@ -121,6 +205,20 @@ void* CThreadSlotData::GetThreadValue(int slot) {
     return pData->pData[slot];
 }
 
+// Process-wide instance behind CThreadLocalObject (MFC's _afxThreadData).
+// Never destroyed: values still bound at process exit may have vtables in
+// modules that are already gone.
+CThreadSlotData* OpenMfcGetThreadSlotData();
+
+// Calling thread's value in slot, without locking.
+void* OpenMfcGetThreadSlotValue(CThreadSlotData* pThis, int slot) {
+    return pThis ? pThis->GetThreadValue(slot) : nullptr;
+}
+
+// FreeSlot that first hands every thread's non-null value in slot to
+// pfnDestroy (CThreadLocalObject's destructor deletes its CNoTrackObjects).
+void OpenMfcFreeThreadSlot(CThreadSlotData* pThis, int slot, void (*pfnDestroy)(void*));
+
 // Symbol: ??0CThreadSlotData@@QEAA@XZ
 extern "C" void MS_ABI impl___0CThreadSlotData__QEAA_XZ(CThreadSlotData* pThis) {
     if (pThis == nullptr)
@@ -140,12 +238,13 @@ extern "C" void MS_ABI impl___1CThreadSlotData__QEAA_XZ(CThreadSlotData* pThis)
     if (pThis == nullptr)
         return;
     EnterCriticalSection(&pThis->m_sect);
-    // Walk m_list, freeing each thread's CThreadData and its value array.
+    // Walk m_list, deleting each thread's values and freeing its CThreadData.
     void* p = pThis->m_list.m_pHead;
     const size_t off = pThis->m_list.m_nNextOffset;
     while (p != nullptr) {
         void* pNext = *(void**)((BYTE*)p + off);
         CThreadData* pData = (CThreadData*)p;
+        ClearThreadData(pThis, pData, nullptr);
         free(pData->pData);
         free(pData);
         p = pNext;
@@ -234,25 +333,7 @@ extern "C" void MS_ABI impl__AssignInstance_CThreadSlotData__QEAAXPEAUHINSTANCE_
 // Symbol: ?FreeSlot@CThreadSlotData@@QEAAXH@Z
 extern "C" void MS_ABI impl__FreeSlot_CThreadSlotData__QEAAXH_Z(
     CThreadSlotData* pThis, int slot) {
-    if (pThis == nullptr || slot <= 0)
-        return;
-    EnterCriticalSection(&pThis->m_sect);
-    if (pThis->m_pSlotData != nullptr && slot < pThis->m_nMax) {
-        pThis->m_pSlotData[slot].dwFlags = 0;
-        pThis->m_pSlotData[slot].hInst   = nullptr;
-    }
-    // Clear that slot's value in every thread's CThreadData.
-    void* p = pThis->m_list.m_pHead;
-    const size_t off = pThis->m_list.m_nNextOffset;
-    while (p != nullptr) {
-        CThreadData* pData = (CThreadData*)p;
-        if (pData->pData != nullptr && slot < pData->nCount)
-            pData->pData[slot] = nullptr;
-        p = *(void**)((BYTE*)p + off);
-    }
-    if (slot < pThis->m_nRover)
-        pThis->m_nRover = slot;  // prefer reusing the freed slot next
-    LeaveCriticalSection(&pThis->m_sect);
+    OpenMfcFreeThreadSlot(pThis, slot, DeleteNoTrackObject);
 }
 
 // Symbol: ?SetValue@CThreadSlotData@@QEAAXHPEAX@Z
@@ -260,59 +341,93 @@ extern "C" void MS_ABI impl__SetValue_CThreadSlotData__QEAAXHPEAX_Z(
     CThreadSlotData* pThis, int slot, void* pValue) {
     if (pThis == nullptr || slot <= 0)
         return;
-    EnterCriticalSection(&pThis->m_sect);
-    CThreadData* pData = GetOrCreateThreadData(pThis);
-    if (pData != nullptr && GrowThreadData(pData, slot))
-        pData->pData[slot] = pValue;
-    LeaveCriticalSection(&pThis->m_sect);
+    // Fast path: the node and its array only move on the owning thread, so a
+    // store into an existing cell needs no lock. First use and growth lock,
+    // since other threads walk m_list and the arrays under m_sect.
+    CThreadData* pData = (CThreadData*)TlsGetValue(pThis->m_tlsIndex);
+    if (pData == nullptr || slot >= pData->nCount) {
+        EnterCriticalSection(&pThis->m_sect);
+        pData = GetOrCreateThreadData(pThis);
+        bool bOk = pData != nullptr && GrowThreadData(pThis, pData, slot);
+        LeaveCriticalSection(&pThis->m_sect);
+        if (!bOk)
+            return;
+    }
+    pData->pData[slot] = pValue;
 }
 
 // Symbol: ?DeleteValues@CThreadSlotData@@QEAAXPEAUHINSTANCE__@@H@Z
-// Clears, for the calling thread, all slot values belonging to a module.
+// Deletes slot values belonging to a module (all modules when hInst is null),
+// in every thread's node when bAll, else in the calling thread's only; the
+// calling thread's node is freed once nothing is left in it.
 extern "C" void MS_ABI impl__DeleteValues_CThreadSlotData__QEAAXPEAUHINSTANCE____H_Z(
     CThreadSlotData* pThis, HINSTANCE hInst, int bAll) {
     if (pThis == nullptr)
         return;
     EnterCriticalSection(&pThis->m_sect);
-    if (pThis->m_pSlotData != nullptr) {
-        // Clear matching (module-owned) slot values in one thread's node.
-        auto clearNode = [&](CThreadData* pData) {
-            if (pData == nullptr || pData->pData == nullptr)
-                return;
-            int limit = pData->nCount < pThis->m_nMax ? pData->nCount : pThis->m_nMax;
-            for (int i = 1; i < limit; ++i) {
-                if (hInst == nullptr || pThis->m_pSlotData[i].hInst == hInst)
-                    pData->pData[i] = nullptr;
-            }
-        };
-        if (bAll) {
-            // Walk every tracked per-thread node via m_list, not just this thread.
-            for (CThreadData* p = (CThreadData*)pThis->m_list.m_pHead; p != nullptr;
-                 p = *(CThreadData**)((BYTE*)p + pThis->m_list.m_nNextOffset))
-                clearNode(p);
-        } else {
-            clearNode((CThreadData*)TlsGetValue(pThis->m_tlsIndex));
-        }
+    if (bAll) {
+        // Walk every tracked per-thread node via m_list, not just this thread.
+        for (CThreadData* p = (CThreadData*)pThis->m_list.m_pHead; p != nullptr;
+             p = *(CThreadData**)((BYTE*)p + pThis->m_list.m_nNextOffset))
+            ClearThreadData(pThis, p, hInst);
+    } else {
+        CThreadData* pData = (CThreadData*)TlsGetValue(pThis->m_tlsIndex);
+        if (pData != nullptr && ClearThreadData(pThis, pData, hInst))
+            ReleaseThreadData(pThis, pData);
     }
     LeaveCriticalSection(&pThis->m_sect);
 }
 
 // Symbol: ?DeleteValues@CThreadSlotData@@QEAAXPEAUCThreadData@@PEAUHINSTANCE__@@@Z
-// Clears slot values for a specific thread's CThreadData, optionally scoped to
-// a module. When pData is null, falls back to the calling thread's node.
+// Deletes slot values for a specific thread's CThreadData, optionally scoped to
+// a module. When pData is null, falls back to the calling thread's node, which
+// is then freed if empty (thread-exit teardown).
 extern "C" void MS_ABI impl__DeleteValues_CThreadSlotData__QEAAXPEAUCThreadData__PEAUHINSTANCE_____Z(
     CThreadSlotData* pThis, CThreadData* pData, HINSTANCE hInst) {
     if (pThis == nullptr)
         return;
     EnterCriticalSection(&pThis->m_sect);
+    CThreadData* pOwn = (CThreadData*)TlsGetValue(pThis->m_tlsIndex);
     if (pData == nullptr)
-        pData = (CThreadData*)TlsGetValue(pThis->m_tlsIndex);
-    if (pData != nullptr && pData->pData != nullptr && pThis->m_pSlotData != nullptr) {
-        int limit = pData->nCount < pThis->m_nMax ? pData->nCount : pThis->m_nMax;
-        for (int i = 1; i < limit; ++i) {
-            if (hInst == nullptr || pThis->m_pSlotData[i].hInst == hInst)
-                pData->pData[i] = nullptr;
+        pData = pOwn;
+    if (pData != nullptr && ClearThreadData(pThis, pData, hInst) && pData == pOwn)
+        ReleaseThreadData(pThis, pData);
+    LeaveCriticalSection(&pThis->m_sect);
+}
+
+void OpenMfcFreeThreadSlot(CThreadSlotData* pThis, int slot, void (*pfnDestroy)(void*)) {
+    if (pThis == nullptr || slot <= 0)
+        return;
+    EnterCriticalSection(&pThis->m_sect);
+    if (pThis->m_pSlotData != nullptr && slot < pThis->m_nMax) {
+        pThis->m_pSlotData[slot].dwFlags = 0;
+        pThis->m_pSlotData[slot].hInst   = nullptr;
+    }
+    // Clear that slot's value in every thread's CThreadData.
+    void* p = pThis->m_list.m_pHead;
+    const size_t off = pThis->m_list.m_nNextOffset;
+    while (p != nullptr) {
+        CThreadData* pData = (CThreadData*)p;
+        if (pData->pData != nullptr && slot < pData->nCount) {
+            void* pValue = pData->pData[slot];
+            pData->pData[slot] = nullptr;
+            if (pValue != nullptr && pfnDestroy != nullptr)
+                pfnDestroy(pValue);
         }
+        p = *(void**)((BYTE*)p + off);
     }
+    if (slot < pThis->m_nRover)
+        pThis->m_nRover = slot;  // prefer reusing the freed slot next
     LeaveCriticalSection(&pThis->m_sect);
 }
+
+CThreadSlotData* OpenMfcGetThreadSlotData() {
+    // C++11 guarantees thread-safe initialization of function-local statics.
+    static CThreadSlotData* s_pThreadData = [] {
+        CThreadSlotData* pData = (CThreadSlotData*)calloc(1, sizeof(CThreadSlotData));
+        impl___0CThreadSlotData__QEAA_XZ(pData);
+        g_pProcessSlotData = pData;
+        return pData;
+    }();
+    return s_pThreadData;
+}
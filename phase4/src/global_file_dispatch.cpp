@@ -8,7 +8,7 @@
 // helpers instead, which dispatch through the fixed MSVC slot index. The slot
 // numbers are uniform across the whole CFile family (verified via
 // cl.exe /d1reportSingleClassLayout): 5 GetPosition, 13 Seek, 14 SetLength,
-// 15 GetLength, 16 Read, 17 Write, 21 Flush, 22 Close. This is also correct for
+// 15 GetLength, 16 Read, 17 Write, 21 Flush, 22 Close, 23 GetBufferPtr. This is also correct for
 // CFile objects supplied by a real-MSVC client (their vtable is MSVC-layout too).
 
 #include "openmfc/afx.h"
@@ -57,5 +57,10 @@ void MS_ABI OpenMFC_File_Close(CFile* p) {
     typedef void (MS_ABI *Fn)(CFile*);
     ((Fn)vtbl(p)[22])(p);
 }
+unsigned int MS_ABI OpenMFC_File_GetBufferPtr(CFile* p, unsigned int nCommand, unsigned int nCount,
+                                              void** ppBufStart, void** ppBufMax) {
+    typedef unsigned int (MS_ABI *Fn)(CFile*, unsigned int, unsigned int, void**, void**);
+    return ((Fn)vtbl(p)[23])(p, nCommand, nCount, ppBufStart, ppBufMax);
+}
 
 } // extern "C"
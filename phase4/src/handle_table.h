@@ -0,0 +1,291 @@
+#pragma once
+
+// Handle -> wrapper table behind CWnd::FromHandle and AfxWndProc routing.
+//
+// MFC keeps one CHandleMap per AFX_MODULE_THREAD_STATE: a window's messages
+// are only ever dispatched on the thread that created it, so the table needs
+// no lock when each UI thread owns its own. Lookups are open addressing with
+// linear probing on a multiplicatively hashed handle; deletion shifts the
+// following run back instead of leaving tombstones, so probe lengths do not
+// decay as windows come and go.
+//
+// Permanent entries belong to the caller. Temporary wrappers (FromHandle on
+// a handle nobody attached) are owned here: they are kept on their own list
+// so idle cleanup costs O(temporaries) rather than O(windows), stamped with
+// the idle generation in which they were last handed out so cleanup only
+// probes the OS for ones that went cold, and their storage is recycled
+// through a small pool instead of going back to the heap. A temporary that is
+// unmapped while possibly still in use (its window was destroyed through it,
+// or a permanent wrapper took over its handle) is retired and freed at the
+// next idle pass, which is the lifetime MFC documents for temporaries.
+//
+// TRAITS supplies `static void Attach(OBJECT*, HANDLE)` and
+// `static void Detach(OBJECT*)` to set and clear the wrapper's handle field.
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace openmfc::handle_table {
+
+template <typename HANDLE, typename OBJECT, typename TRAITS>
+class HandleTable {
+public:
+    HandleTable() = default;
+    HandleTable(const HandleTable&) = delete;
+    HandleTable& operator=(const HandleTable&) = delete;
+
+    ~HandleTable() {
+        for (const TempRecord& rec : m_temps) {
+            DestroyTemporary(rec.pObject);
+        }
+        for (OBJECT* pObject : m_retired) {
+            DestroyTemporary(pObject);
+        }
+        for (void* pStorage : m_pool) {
+            ::operator delete(pStorage);
+        }
+        delete[] m_pSlots;
+    }
+
+    size_t GetCount() const { return m_nCount; }
+    size_t GetTemporaryCount() const { return m_temps.size(); }
+    unsigned GetGeneration() const { return m_nGeneration; }
+
+    OBJECT* Lookup(HANDLE h) const {
+        const Slot* pSlot = FindSlot(h);
+        return pSlot ? pSlot->pObject : nullptr;
+    }
+
+    bool IsTemporary(HANDLE h) const {
+        const Slot* pSlot = FindSlot(h);
+        return pSlot && pSlot->nTemp != 0;
+    }
+
+    // Maps h to a caller-owned wrapper, replacing whatever was there.
+    void SetPermanent(HANDLE h, OBJECT* pObject) {
+        if (!h) {
+            return;
+        }
+        if (Slot* pSlot = FindSlot(h)) {
+            if (pSlot->nTemp != 0) {
+                OBJECT* pTemp = pSlot->pObject;
+                RemoveTempRecord(pSlot->nTemp - 1);
+                RetireTemporary(pTemp);
+            }
+            pSlot->pObject = pObject;
+            pSlot->nTemp = 0;
+            return;
+        }
+        InsertNew(h, pObject, 0);
+    }
+
+    // Permanent wrapper for h, or a temporary one created on demand.
+    OBJECT* FromHandle(HANDLE h) {
+        if (!h) {
+            return nullptr;
+        }
+        if (Slot* pSlot = FindSlot(h)) {
+            if (pSlot->nTemp != 0) {
+                m_temps[pSlot->nTemp - 1].nLastUsed = m_nGeneration;
+            }
+            return pSlot->pObject;
+        }
+        OBJECT* pTemp = CreateTemporary(h);
+        m_temps.push_back(TempRecord{ h, pTemp, m_nGeneration });
+        InsertNew(h, pTemp, static_cast<unsigned>(m_temps.size()));
+        return pTemp;
+    }
+
+    // Unmaps h and returns its wrapper. A temporary stays owned by the table;
+    // pass it to ReleaseTemporary once the caller is done with it, or to
+    // RetireTemporary if it may still be on the stack.
+    OBJECT* Remove(HANDLE h, bool* pbTemporary = nullptr) {
+        Slot* pSlot = FindSlot(h);
+        if (pbTemporary) {
+            *pbTemporary = pSlot && pSlot->nTemp != 0;
+        }
+        if (!pSlot) {
+            return nullptr;
+        }
+        OBJECT* pObject = pSlot->pObject;
+        if (pSlot->nTemp != 0) {
+            RemoveTempRecord(pSlot->nTemp - 1);
+        }
+        EraseSlot(static_cast<size_t>(pSlot - m_pSlots));
+        return pObject;
+    }
+
+    void ReleaseTemporary(OBJECT* pObject) {
+        DestroyTemporary(pObject);
+    }
+
+    void RetireTemporary(OBJECT* pObject) {
+        m_retired.push_back(pObject);
+    }
+
+    // Idle-time cleanup: frees retired temporaries, and unmaps and recycles
+    // temporaries that were not handed out since the previous pass and whose
+    // handle isAlive rejects. Returns the number of wrappers freed.
+    template <typename IS_ALIVE>
+    size_t CollectTemporaries(IS_ALIVE isAlive) {
+        size_t nFreed = m_retired.size();
+        for (OBJECT* pObject : m_retired) {
+            DestroyTemporary(pObject);
+        }
+        m_retired.clear();
+
+        unsigned nCurrent = m_nGeneration++;
+        for (size_t i = 0; i < m_temps.size();) {
+            TempRecord rec = m_temps[i];
+            if (rec.nLastUsed == nCurrent || isAlive(rec.hHandle)) {
+                ++i;
+                continue;
+            }
+            // Remove swaps the last record into slot i, so do not advance.
+            Remove(rec.hHandle);
+            DestroyTemporary(rec.pObject);
+            ++nFreed;
+        }
+        return nFreed;
+    }
+
+private:
+    struct Slot {
+        HANDLE hHandle;      // null: empty
+        OBJECT* pObject;
+        unsigned nTemp;      // 0: permanent, else index + 1 into m_temps
+    };
+
+    struct TempRecord {
+        HANDLE hHandle;
+        OBJECT* pObject;
+        unsigned nLastUsed;  // idle generation of the last FromHandle
+    };
+
+    static const size_t kMinCapacity = 64;
+    static const size_t kMaxPooled = 64;
+
+    size_t Home(HANDLE h) const {
+        uint64_t x = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(h));
+        x *= 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(x >> (64 - m_nBits));
+    }
+
+    const Slot* FindSlot(HANDLE h) const {
+        if (!m_pSlots || !h) {
+            return nullptr;
+        }
+        size_t mask = m_nCapacity - 1;
+        for (size_t i = Home(h);; i = (i + 1) & mask) {
+            const Slot& slot = m_pSlots[i];
+            if (slot.hHandle == h) {
+                return &slot;
+            }
+            if (!slot.hHandle) {
+                return nullptr;
+            }
+        }
+    }
+
+    Slot* FindSlot(HANDLE h) {
+        return const_cast<Slot*>(static_cast<const HandleTable*>(this)->FindSlot(h));
+    }
+
+    void InsertNew(HANDLE h, OBJECT* pObject, unsigned nTemp) {
+        // Keep the load factor at or below one half.
+        if ((m_nCount + 1) * 2 > m_nCapacity) {
+            Grow();
+        }
+        size_t mask = m_nCapacity - 1;
+        size_t i = Home(h);
+        while (m_pSlots[i].hHandle) {
+            i = (i + 1) & mask;
+        }
+        m_pSlots[i] = Slot{ h, pObject, nTemp };
+        ++m_nCount;
+    }
+
+    void Grow() {
+        size_t nOldCapacity = m_nCapacity;
+        Slot* pOld = m_pSlots;
+        m_nCapacity = nOldCapacity ? nOldCapacity * 2 : kMinCapacity;
+        m_nBits = 0;
+        while ((size_t(1) << m_nBits) < m_nCapacity) {
+            ++m_nBits;
+        }
+        m_pSlots = new Slot[m_nCapacity]();
+        size_t mask = m_nCapacity - 1;
+        for (size_t j = 0; j < nOldCapacity; ++j) {
+            if (!pOld[j].hHandle) {
+                continue;
+            }
+            size_t i = Home(pOld[j].hHandle);
+            while (m_pSlots[i].hHandle) {
+                i = (i + 1) & mask;
+            }
+            m_pSlots[i] = pOld[j];
+        }
+        delete[] pOld;
+    }
+
+    // Backward-shift deletion: pull later members of the probe run into the
+    // hole when their home position allows it.
+    void EraseSlot(size_t hole) {
+        size_t mask = m_nCapacity - 1;
+        for (size_t j = (hole + 1) & mask; m_pSlots[j].hHandle; j = (j + 1) & mask) {
+            size_t home = Home(m_pSlots[j].hHandle);
+            bool reachable = (hole <= j) ? (home <= hole || home > j) : (home <= hole && home > j);
+            if (reachable) {
+                m_pSlots[hole] = m_pSlots[j];
+                hole = j;
+            }
+        }
+        m_pSlots[hole] = Slot{};
+        --m_nCount;
+    }
+
+    void RemoveTempRecord(size_t index) {
+        size_t last = m_temps.size() - 1;
+        if (index != last) {
+            m_temps[index] = m_temps[last];
+            FindSlot(m_temps[index].hHandle)->nTemp = static_cast<unsigned>(index + 1);
+        }
+        m_temps.pop_back();
+    }
+
+    OBJECT* CreateTemporary(HANDLE h) {
+        void* pStorage;
+        if (!m_pool.empty()) {
+            pStorage = m_pool.back();
+            m_pool.pop_back();
+        } else {
+            pStorage = ::operator new(sizeof(OBJECT));
+        }
+        OBJECT* pObject = new (pStorage) OBJECT();
+        TRAITS::Attach(pObject, h);
+        return pObject;
+    }
+
+    void DestroyTemporary(OBJECT* pObject) {
+        TRAITS::Detach(pObject);
+        pObject->~OBJECT();
+        if (m_pool.size() < kMaxPooled) {
+            m_pool.push_back(pObject);
+        } else {
+            ::operator delete(pObject);
+        }
+    }
+
+    Slot* m_pSlots = nullptr;
+    size_t m_nCapacity = 0;
+    unsigned m_nBits = 0;
+    size_t m_nCount = 0;
+    unsigned m_nGeneration = 1;
+    std::vector<TempRecord> m_temps;
+    std::vector<OBJECT*> m_retired;
+    std::vector<void*> m_pool;
+};
+
+} // namespace openmfc::handle_table
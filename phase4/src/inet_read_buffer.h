@@ -0,0 +1,209 @@
+#pragma once
+
+// Read-ahead buffer behind CInternetFile::Read / ReadString.
+//
+// As in MFC, the buffer is off (size 0) until SetReadBufferSize turns it
+// on or ReadString first needs it. Read serves buffered bytes first and
+// refills with one large read; a request at least as large as the buffer
+// goes straight into the caller's memory. ReadLine finds the newline with
+// memchr inside the buffer and hands the line to a callback piece by piece,
+// one piece per buffer fill, so a line can be any length and the caller
+// converts it as it arrives.
+//
+// The source is a functor: unsigned fill(void* p, unsigned n) returning the
+// bytes read, 0 at end of data or on error.
+//
+// SplitCharCarry sits between ReadLine and the ANSI -> UTF-16 conversion:
+// it holds back a multibyte character whose bytes straddle two pieces, so
+// every piece handed to MultiByteToWideChar ends on a character boundary.
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+namespace openmfc_inetbuf {
+
+class ReadAheadBuffer {
+public:
+    ReadAheadBuffer() = default;
+    ReadAheadBuffer(const ReadAheadBuffer&) = delete;
+    ReadAheadBuffer& operator=(const ReadAheadBuffer&) = delete;
+    ~ReadAheadBuffer() { delete[] m_pData; }
+
+    unsigned GetSize() const { return m_nSize; }
+    unsigned GetBuffered() const { return m_nEnd - m_nPos; }
+
+    // Keeps what is buffered; fails if that does not fit in nSize (or if
+    // the new buffer cannot be allocated).
+    bool SetSize(unsigned nSize) {
+        const unsigned nBuffered = m_nEnd - m_nPos;
+        if (nBuffered > nSize) {
+            return false;
+        }
+        unsigned char* pData = nullptr;
+        if (nSize != 0) {
+            pData = new (std::nothrow) unsigned char[nSize];
+            if (!pData) {
+                return false;
+            }
+            if (nBuffered != 0) {
+                std::memcpy(pData, m_pData + m_nPos, nBuffered);
+            }
+        }
+        delete[] m_pData;
+        m_pData = pData;
+        m_nSize = nSize;
+        m_nPos = 0;
+        m_nEnd = nBuffered;
+        return true;
+    }
+
+    void Discard() { m_nPos = m_nEnd = 0; }
+
+    template <class TFill>
+    unsigned Read(TFill& fill, void* lpBuf, unsigned nCount) {
+        unsigned char* pDest = static_cast<unsigned char*>(lpBuf);
+        unsigned nDone = 0;
+        while (nDone < nCount) {
+            if (m_nPos == m_nEnd) {
+                if (nCount - nDone >= m_nSize) {
+                    unsigned nRead = fill(pDest + nDone, nCount - nDone);
+                    nDone += nRead;
+                    break;
+                }
+                if (!Refill(fill)) {
+                    break;
+                }
+            }
+            unsigned nCopy = m_nEnd - m_nPos;
+            if (nCopy > nCount - nDone) {
+                nCopy = nCount - nDone;
+            }
+            std::memcpy(pDest + nDone, m_pData + m_nPos, nCopy);
+            m_nPos += nCopy;
+            nDone += nCopy;
+        }
+        return nDone;
+    }
+
+    // Passes the bytes of the next line, newline included, to
+    // onPiece(const char*, size_t), stopping after nMaxBytes bytes.
+    // Returns false only if the data had already ended.
+    template <class TFill, class TPiece>
+    bool ReadLine(TFill& fill, size_t nMaxBytes, TPiece&& onPiece) {
+        size_t nTaken = 0;
+        while (nTaken < nMaxBytes) {
+            if (m_nPos == m_nEnd && !Refill(fill)) {
+                break;
+            }
+            size_t nAvail = m_nEnd - m_nPos;
+            if (nAvail > nMaxBytes - nTaken) {
+                nAvail = nMaxBytes - nTaken;
+            }
+            const unsigned char* p = m_pData + m_nPos;
+            const void* pNewline = std::memchr(p, '\n', nAvail);
+            size_t nPiece = pNewline ? static_cast<const unsigned char*>(pNewline) - p + 1 : nAvail;
+            m_nPos += static_cast<unsigned>(nPiece);
+            nTaken += nPiece;
+            onPiece(reinterpret_cast<const char*>(p), nPiece);
+            if (pNewline) {
+                break;
+            }
+        }
+        return nTaken != 0;
+    }
+
+private:
+    template <class TFill>
+    bool Refill(TFill& fill) {
+        m_nPos = m_nEnd = 0;
+        if (!m_pData) {
+            return false;
+        }
+        m_nEnd = fill(m_pData, m_nSize);
+        return m_nEnd != 0;
+    }
+
+    unsigned char* m_pData = nullptr;
+    unsigned m_nSize = 0;
+    unsigned m_nPos = 0;   // next unread byte
+    unsigned m_nEnd = 0;   // end of buffered data
+};
+
+// Code page shapes: single-byte (nothing to carry), DBCS (a lead byte,
+// told by isLead, takes the next byte with it) and UTF-8.
+enum CodePageKind { kSingleByte, kDoubleByte, kUtf8 };
+
+template <class TIsLead>
+class SplitCharCarry {
+public:
+    SplitCharCarry(CodePageKind kind, TIsLead isLead) : m_kind(kind), m_isLead(isLead) {}
+
+    // Passes p[0..n) on to emit(const char*, size_t) in whole characters.
+    template <class TEmit>
+    void Feed(const char* p, size_t n, TEmit&& emit) {
+        if (m_kind == kSingleByte) {
+            if (n != 0) {
+                emit(p, n);
+            }
+            return;
+        }
+        while (m_nCarry != 0 && n != 0) {
+            m_carry[m_nCarry++] = *p++;
+            --n;
+            if (IncompleteTail(m_carry, m_nCarry) == 0 || m_nCarry == sizeof(m_carry)) {
+                emit(m_carry, m_nCarry);
+                m_nCarry = 0;
+            }
+        }
+        if (n == 0) {
+            return;
+        }
+        size_t nTail = IncompleteTail(p, n);
+        if (n > nTail) {
+            emit(p, n - nTail);
+        }
+        std::memcpy(m_carry, p + n - nTail, nTail);
+        m_nCarry = nTail;
+    }
+
+    // End of the line: whatever is held back goes out as it is.
+    template <class TEmit>
+    void Finish(TEmit&& emit) {
+        if (m_nCarry != 0) {
+            emit(m_carry, m_nCarry);
+            m_nCarry = 0;
+        }
+    }
+
+private:
+    // How many bytes at the end of p[0..n), which starts on a character
+    // boundary, begin a character that continues past n.
+    size_t IncompleteTail(const char* p, size_t n) const {
+        const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+        if (m_kind == kUtf8) {
+            size_t nBack = 0;
+            while (nBack < 3 && nBack < n && (u[n - 1 - nBack] & 0xC0) == 0x80) {
+                ++nBack;
+            }
+            if (nBack == n) {
+                return 0;   // only continuation bytes: invalid, let them through
+            }
+            unsigned char lead = u[n - 1 - nBack];
+            size_t nLen = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+            return nLen > nBack + 1 ? nBack + 1 : 0;
+        }
+        size_t i = 0;
+        while (i < n) {
+            i += m_isLead(u[i]) ? 2 : 1;
+        }
+        return i > n ? 1 : 0;
+    }
+
+    CodePageKind m_kind;
+    TIsLead m_isLead;
+    char m_carry[4];
+    size_t m_nCarry = 0;
+};
+
+} // namespace openmfc_inetbuf
@@ -7,6 +7,7 @@
 #include "openmfc/afxwin.h"
 #include "openmfc/afxinet.h"
 #include "openmfc/afxstr.h"
+#include "inet_read_buffer.h"
 #include <windows.h>
 #include <wininet.h>
 #include <cstring>
@@ -491,16 +492,58 @@ __attribute__((used)) static CRuntimeClass g_classCGopherFile = {
 // CInternetFile
 //=============================================================================
 
+struct CInternetFileReadBuffer : openmfc_inetbuf::ReadAheadBuffer {};
+
+namespace {
+
+// MFC's ReadString turns on a 4 KB read buffer if none was set.
+constexpr UINT kDefaultLineBufferSize = 4096;
+
+// InternetReadFile as the read-ahead buffer's source.
+struct InternetFileSource {
+    HINTERNET hFile;
+    unsigned operator()(void* p, unsigned n) const {
+        DWORD dwRead = 0;
+        return InternetReadFile(hFile, p, n, &dwRead) ? dwRead : 0;
+    }
+};
+
+struct AcpLeadByte {
+    bool operator()(unsigned char b) const { return IsDBCSLeadByteEx(CP_ACP, b) != FALSE; }
+};
+
+typedef openmfc_inetbuf::SplitCharCarry<AcpLeadByte> AcpCarry;
+
+AcpCarry MakeAcpCarry() {
+    CPINFO info;
+    openmfc_inetbuf::CodePageKind kind = openmfc_inetbuf::kSingleByte;
+    if (GetACP() == CP_UTF8) {
+        kind = openmfc_inetbuf::kUtf8;
+    } else if (GetCPInfo(CP_ACP, &info) && info.MaxCharSize > 1) {
+        kind = openmfc_inetbuf::kDoubleByte;
+    }
+    return AcpCarry(kind, AcpLeadByte());
+}
+
+// Every code page yields at most one UTF-16 unit per byte, so nBytes units
+// of room always suffice.
+int AcpToWide(const char* p, size_t nBytes, wchar_t* pOut) {
+    int n = MultiByteToWideChar(CP_ACP, 0, p, (int)nBytes, pOut, (int)nBytes);
+    return n > 0 ? n : 0;
+}
+
+} // namespace
+
 // Not using IMPLEMENT_DYNAMIC since base class CStdioFile lacks DECLARE_DYNAMIC
 CInternetFile::CInternetFile()
-    : CStdioFile(), m_hFile(nullptr), m_dwContext(0)
+    : CStdioFile(), m_hFile(nullptr), m_dwContext(0), m_pReadBuffer(nullptr)
 {
     memset(_inetfile_padding, 0, sizeof(_inetfile_padding));
 }
 
 CInternetFile::CInternetFile(HINTERNET hFile, const wchar_t* pstrFileName,
                              CInternetConnection* pConnection, int nErrorCode)
-    : CStdioFile(), m_hFile(hFile), m_dwContext(0)
+    : CStdioFile(), m_hFile(hFile), m_dwContext(0), m_pReadBuffer(nullptr)
 {
     (void)nErrorCode;
     if (pstrFileName) {
@@ -517,6 +560,7 @@ CInternetFile::~CInternetFile() {
         InternetCloseHandle(m_hFile);
         m_hFile = nullptr;
     }
+    delete m_pReadBuffer;
 }
 
 ULONGLONG CInternetFile::GetLength() const {
@@ -536,7 +580,11 @@ ULONGLONG CInternetFile::Seek(LONGLONG lOff, UINT nFrom) {
 }
 
 UINT CInternetFile::Read(void* lpBuf, UINT nCount) {
-    if (!m_hFile) return 0;
+    if (!m_hFile || !lpBuf) return 0;
+    if (m_pReadBuffer && m_pReadBuffer->GetSize() != 0) {
+        InternetFileSource source = { m_hFile };
+        return m_pReadBuffer->Read(source, lpBuf, nCount);
+    }
     DWORD dwRead = 0;
     if (InternetReadFile(m_hFile, lpBuf, nCount, &dwRead)) {
         return dwRead;
@@ -562,6 +610,9 @@ void CInternetFile::Close() {
         InternetCloseHandle(m_hFile);
         m_hFile = nullptr;
     }
+    if (m_pReadBuffer) {
+        m_pReadBuffer->Discard();
+    }
 }
 
 CFile* CInternetFile::Duplicate() const {
@@ -598,35 +649,55 @@ int CInternetFile::SetOption(DWORD dwOption, void* lpBuffer, DWORD dwBufLen, DWO
     return InternetSetOptionW(m_hFile, dwOption, lpBuffer, dwBufLen);
 }
 
+// Reads up to nMax - 1 bytes of the next line (newline kept) and converts
+// them, as before; the bytes now come out of the read-ahead buffer instead
+// of one InternetReadFile call each.
 wchar_t* CInternetFile::ReadString(wchar_t* pstr, UINT nMax) {
     if (!pstr || nMax == 0) return nullptr;
-    std::vector<char> bytes;
-    bytes.reserve(nMax);
-    for (UINT i = 0; i + 1 < nMax; ++i) {
-        char ch = 0;
-        if (Read(&ch, 1) != 1) break;
-        bytes.push_back(ch);
-        if (ch == '\n') break;
-    }
-    if (bytes.empty()) return nullptr;
-    bytes.push_back('\0');
-    int converted = MultiByteToWideChar(CP_ACP, 0, bytes.data(), -1, pstr, (int)nMax);
-    if (converted <= 0) {
-        pstr[0] = L'\0';
+    pstr[0] = L'\0';
+    if (!m_hFile || nMax == 1) return nullptr;
+    if ((!m_pReadBuffer || m_pReadBuffer->GetSize() == 0) && !SetReadBufferSize(kDefaultLineBufferSize)) {
         return nullptr;
     }
+    InternetFileSource source = { m_hFile };
+    AcpCarry carry = MakeAcpCarry();
+    int nLen = 0;
+    auto emit = [&](const char* p, size_t n) { nLen += AcpToWide(p, n, pstr + nLen); };
+    if (!m_pReadBuffer->ReadLine(source, nMax - 1, [&](const char* p, size_t n) { carry.Feed(p, n, emit); })) {
+        return nullptr;
+    }
+    carry.Finish(emit);
+    pstr[nLen] = L'\0';
     return pstr;
 }
 
+// Any line length: each piece of the line is converted straight into the
+// string's buffer, which doubles as needed.
 int CInternetFile::ReadString(CString& rString) {
-    wchar_t buf[1024];
-    wchar_t* p = ReadString(buf, 1024);
-    if (!p) {
-        rString.Empty();
+    rString.Empty();
+    if (!m_hFile) return FALSE;
+    if ((!m_pReadBuffer || m_pReadBuffer->GetSize() == 0) && !SetReadBufferSize(kDefaultLineBufferSize)) {
         return FALSE;
     }
-    rString = p;
-    return TRUE;
+    InternetFileSource source = { m_hFile };
+    AcpCarry carry = MakeAcpCarry();
+    int nCapacity = 128;
+    int nLen = 0;
+    wchar_t* pBuf = rString.GetBuffer(nCapacity);
+    auto emit = [&](const char* p, size_t n) {
+        if (nLen + (int)n > nCapacity) {
+            rString.ReleaseBuffer(nLen);
+            while (nLen + (int)n > nCapacity) {
+                nCapacity *= 2;
+            }
+            pBuf = rString.GetBuffer(nCapacity);
+        }
+        nLen += AcpToWide(p, n, pBuf + nLen);
+    };
+    bool bRead = m_pReadBuffer->ReadLine(source, (size_t)-1, [&](const char* p, size_t n) { carry.Feed(p, n, emit); });
+    carry.Finish(emit);
+    rString.ReleaseBuffer(nLen);
+    return bRead ? TRUE : FALSE;
 }
 
 void CInternetFile::WriteString(const wchar_t* pstr) {
@@ -640,10 +711,15 @@ void CInternetFile::WriteString(const wchar_t* pstr) {
     Write(bytes.data(), (UINT)(bytesNeeded - 1));
 }
 
+// Sizes the read-ahead buffer Read and ReadString share (0 turns it off).
+// As in MFC, this fails if more bytes are buffered than the new size holds.
 int CInternetFile::SetReadBufferSize(UINT nReadSize) {
-    if (!m_hFile) return FALSE;
-    return InternetSetOptionW(m_hFile, INTERNET_OPTION_READ_BUFFER_SIZE,
-                               &nReadSize, sizeof(nReadSize));
+    if (!m_pReadBuffer) {
+        if (nReadSize == 0) return TRUE;
+        m_pReadBuffer = new (std::nothrow) CInternetFileReadBuffer;
+        if (!m_pReadBuffer) return FALSE;
+    }
+    return m_pReadBuffer->SetSize(nReadSize) ? TRUE : FALSE;
 }
 
 int CInternetFile::SetWriteBufferSize(UINT nWriteSize) {
@@ -9,6 +9,7 @@
 
 #define OPENMFC_APPCORE_IMPL
 #include "openmfc/afxwin.h"
+#include "dump_channel.h"
 #include <windows.h>
 #include <cstddef>
 #include <cstdlib>
@@ -239,21 +240,41 @@ extern "C" int impl__AfxCheckMemory() {
 }
 
 // AfxDump - Global CDumpContext for debug output
-// In real MFC this is a global CDumpContext object; here we provide
-// a stub that outputs to stderr via OutputDebugString.
-static void DumpToDebugger(const wchar_t* psz) {
-    if (psz) {
-        OutputDebugStringW(psz);
-        fwprintf(stderr, L"%s", psz);
+// In real MFC this is a global CDumpContext object; here it writes to the
+// same buffered debug channel as CDumpContext(nullptr), which hands the
+// debugger whole lines.
+extern "C" void impl__AfxDump__PB_W(const wchar_t* psz) {
+    openmfc_dump::DebugChannel().Write(psz);
+}
+
+// AfxSetDumpOutput / AfxSetDumpFlushPolicy / AfxFlushDump - OpenMFC
+// extensions (afx.h) steering the channel AfxDump and CDumpContext(nullptr)
+// share. They are not in the MFC ordinal map; build_phase4.sh adds them to
+// the .def file.
+extern "C" void MS_ABI impl__AfxSetDumpOutput(openmfc_dump::CallbackSink::OutputProc pfnOutput, void* pContext) {
+    openmfc_dump::DumpSink* pDefault = &openmfc_dump::DefaultDebugSink();
+    openmfc_dump::DumpSink* pSink = pfnOutput ? new openmfc_dump::CallbackSink(pfnOutput, pContext) : pDefault;
+    openmfc_dump::DumpSink* pOld = openmfc_dump::DebugChannel().SetSink(pSink);
+    if (pOld != pDefault) {
+        delete pOld;
     }
 }
 
-extern "C" void impl__AfxDump__PB_W(const wchar_t* psz) {
-    DumpToDebugger(psz);
+extern "C" int MS_ABI impl__AfxSetDumpFlushPolicy(int nPolicy) {
+    openmfc_dump::DumpChannel& channel = openmfc_dump::DebugChannel();
+    if (nPolicy < static_cast<int>(openmfc_dump::FlushPolicy::Immediate) ||
+        nPolicy > static_cast<int>(openmfc_dump::FlushPolicy::Block)) {
+        return static_cast<int>(channel.GetPolicy());
+    }
+    return static_cast<int>(channel.SetPolicy(static_cast<openmfc_dump::FlushPolicy>(nPolicy)));
+}
+
+extern "C" void MS_ABI impl__AfxFlushDump() {
+    openmfc_dump::DebugChannel().Flush();
 }
 
 // AfxDumpStack - Prints stack trace to debug output
 extern "C" void impl__AfxDumpStack(unsigned long dwFlags) {
     (void)dwFlags;
-    OutputDebugStringW(L"AfxDumpStack: (stack trace not available on this platform)\n");
+    openmfc_dump::DebugChannel().Write(L"AfxDumpStack: (stack trace not available on this platform)\n");
 }
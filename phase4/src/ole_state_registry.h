@@ -0,0 +1,39 @@
+#pragma once
+
+// Per-object side state for the OLE classes whose retail layout has no room
+// for OpenMFC's bookkeeping (olecore.cpp: drop targets, documents, client
+// and server items, controls).
+//
+// States are keyed on the object's address. Lookup is a hash probe, and
+// because unordered_map nodes never move, a state pointer stays valid while
+// other objects come and go -- until its own object's state is removed.
+// Like the objects themselves, a registry is only used from the UI thread
+// and takes no lock.
+
+#include <cstddef>
+#include <unordered_map>
+
+namespace openmfc_olestate {
+
+template <typename OBJECT, typename STATE>
+class StateRegistry {
+public:
+    STATE* Find(const OBJECT* pObject) {
+        auto it = m_states.find(pObject);
+        return it == m_states.end() ? nullptr : &it->second;
+    }
+
+    // The state for pObject, default-constructed on first use.
+    STATE* Ensure(const OBJECT* pObject) {
+        return &m_states.try_emplace(pObject).first->second;
+    }
+
+    bool Remove(const OBJECT* pObject) { return m_states.erase(pObject) != 0; }
+
+    size_t GetCount() const { return m_states.size(); }
+
+private:
+    std::unordered_map<const OBJECT*, STATE> m_states;
+};
+
+} // namespace openmfc_olestate
@@ -5,6 +5,7 @@
 
 #define OPENMFC_APPCORE_IMPL
 #include "openmfc/afxole.h"
+#include "ole_state_registry.h"
 #include <algorithm>
 #include <cstring>
 #include <cwchar>
@@ -1217,47 +1218,36 @@ struct OleControlState {
     BOOL hasObjectRects = FALSE;
 };
 
-static std::vector<DropTargetState> g_dropTargetStates;
-static std::vector<DocumentState> g_documentStates;
-static std::vector<ClientItemState> g_clientItemStates;
-static std::vector<ServerDocState> g_serverDocStates;
-static std::vector<ServerItemState> g_serverItemStates;
-static std::vector<OleControlState> g_oleControlStates;
+static openmfc_olestate::StateRegistry<COleDropTarget, DropTargetState> g_dropTargetStates;
+static openmfc_olestate::StateRegistry<COleDocument, DocumentState> g_documentStates;
+static openmfc_olestate::StateRegistry<COleClientItem, ClientItemState> g_clientItemStates;
+static openmfc_olestate::StateRegistry<COleServerDoc, ServerDocState> g_serverDocStates;
+static openmfc_olestate::StateRegistry<COleServerItem, ServerItemState> g_serverItemStates;
+static openmfc_olestate::StateRegistry<COleControl, OleControlState> g_oleControlStates;
 static std::vector<COleObjectFactory*> g_oleObjectFactories;
 
 static DropTargetState* GetDropTargetState(COleDropTarget* target, bool create) {
     if (!target) return nullptr;
-    for (DropTargetState& state : g_dropTargetStates) {
-        if (state.target == target) return &state;
-    }
-    if (!create) return nullptr;
-    g_dropTargetStates.push_back(DropTargetState{target, nullptr});
-    return &g_dropTargetStates.back();
+    if (!create) return g_dropTargetStates.Find(target);
+    DropTargetState* state = g_dropTargetStates.Ensure(target);
+    state->target = target;
+    return state;
 }
 
 static void RemoveDropTargetState(COleDropTarget* target) {
-    g_dropTargetStates.erase(
-        std::remove_if(g_dropTargetStates.begin(), g_dropTargetStates.end(),
-                       [target](const DropTargetState& state) { return state.target == target; }),
-        g_dropTargetStates.end());
+    g_dropTargetStates.Remove(target);
 }
 
 static DocumentState* GetDocumentState(COleDocument* document, bool create) {
     if (!document) return nullptr;
-    for (DocumentState& state : g_documentStates) {
-        if (state.document == document) return &state;
-    }
-    if (!create) return nullptr;
-    g_documentStates.push_back(DocumentState());
-    g_documentStates.back().document = document;
-    return &g_documentStates.back();
+    if (!create) return g_documentStates.Find(document);
+    DocumentState* state = g_documentStates.Ensure(document);
+    state->document = document;
+    return state;
 }
 
 static void RemoveDocumentState(COleDocument* document) {
-    g_documentStates.erase(
-        std::remove_if(g_documentStates.begin(), g_documentStates.end(),
-                       [document](const DocumentState& state) { return state.document == document; }),
-        g_documentStates.end());
+    g_documentStates.Remove(document);
 }
 
 class OleItemContainerAdapter : public IOleItemContainer {
@@ -1314,27 +1304,18 @@ private:
 
 static ClientItemState* GetClientItemState(COleClientItem* item, bool create) {
     if (!item) return nullptr;
-    for (ClientItemState& state : g_clientItemStates) {
-        if (state.item == item) return &state;
-    }
-    if (!create) return nullptr;
-    g_clientItemStates.push_back(ClientItemState());
-    g_clientItemStates.back().item = item;
-    return &g_clientItemStates.back();
+    if (!create) return g_clientItemStates.Find(item);
+    ClientItemState* state = g_clientItemStates.Ensure(item);
+    state->item = item;
+    return state;
 }
 
 static ClientItemState* FindClientItemState(const COleClientItem* item) {
-    for (ClientItemState& state : g_clientItemStates) {
-        if (state.item == item) return &state;
-    }
-    return nullptr;
+    return g_clientItemStates.Find(item);
 }
 
 static void RemoveClientItemState(COleClientItem* item) {
-    g_clientItemStates.erase(
-        std::remove_if(g_clientItemStates.begin(), g_clientItemStates.end(),
-                       [item](const ClientItemState& state) { return state.item == item; }),
-        g_clientItemStates.end());
+    g_clientItemStates.Remove(item);
 }
 
 static void AddOleObjectFactory(COleObjectFactory* factory) {
@@ -1351,38 +1332,26 @@ static void RemoveOleObjectFactory(COleObjectFactory* factory) {
 
 static ServerDocState* GetServerDocState(COleServerDoc* document, bool create) {
     if (!document) return nullptr;
-    for (ServerDocState& state : g_serverDocStates) {
-        if (state.document == document) return &state;
-    }
-    if (!create) return nullptr;
-    g_serverDocStates.push_back(ServerDocState());
-    g_serverDocStates.back().document = document;
-    return &g_serverDocStates.back();
+    if (!create) return g_serverDocStates.Find(document);
+    ServerDocState* state = g_serverDocStates.Ensure(document);
+    state->document = document;
+    return state;
 }
 
 static void RemoveServerDocState(COleServerDoc* document) {
-    g_serverDocStates.erase(
-        std::remove_if(g_serverDocStates.begin(), g_serverDocStates.end(),
-                       [document](const ServerDocState& state) { return state.document == document; }),
-        g_serverDocStates.end());
+    g_serverDocStates.Remove(document);
 }
 
 static ServerItemState* GetServerItemState(COleServerItem* item, bool create) {
     if (!item) return nullptr;
-    for (ServerItemState& state : g_serverItemStates) {
-        if (state.item == item) return &state;
-    }
-    if (!create) return nullptr;
-    g_serverItemStates.push_back(ServerItemState());
-    g_serverItemStates.back().item = item;
-    return &g_serverItemStates.back();
+    if (!create) return g_serverItemStates.Find(item);
+    ServerItemState* state = g_serverItemStates.Ensure(item);
+    state->item = item;
+    return state;
 }
 
 static void RemoveServerItemState(COleServerItem* item) {
-    g_serverItemStates.erase(
-        std::remove_if(g_serverItemStates.begin(), g_serverItemStates.end(),
-                       [item](const ServerItemState& state) { return state.item == item; }),
-        g_serverItemStates.end());
+    g_serverItemStates.Remove(item);
 }
 
 static BOOL EnsureLinkingDocMoniker(COleLinkingDoc* document, const wchar_t* fileName, BOOL setModified) {
@@ -1414,13 +1383,10 @@ static BOOL EnsureLinkingDocMoniker(COleLinkingDoc* document, const wchar_t* fil
 
 static OleControlState* GetOleControlState(COleControl* control, bool create) {
     if (!control) return nullptr;
-    for (OleControlState& state : g_oleControlStates) {
-        if (state.control == control) return &state;
-    }
-    if (!create) return nullptr;
-    g_oleControlStates.push_back(OleControlState());
-    g_oleControlStates.back().control = control;
-    return &g_oleControlStates.back();
+    if (!create) return g_oleControlStates.Find(control);
+    OleControlState* state = g_oleControlStates.Ensure(control);
+    state->control = control;
+    return state;
 }
 
 // OpenMFC's COleControlSite for a control, or null. Retail keeps no such
@@ -1447,17 +1413,15 @@ static Interface* QueryOleControlInterface(COleControl* control, REFIID iid) {
 }
 
 static void RemoveOleControlState(COleControl* control) {
-    auto it = std::remove_if(g_oleControlStates.begin(), g_oleControlStates.end(),
-                             [control](const OleControlState& state) { return state.control == control; });
-    for (auto releaseIt = it; releaseIt != g_oleControlStates.end(); ++releaseIt) {
-        for (auto& sink : releaseIt->eventSinks) {
-            if (sink.sink) sink.sink->Release();
-        }
-        for (auto* sink : releaseIt->propSinks) {
-            if (sink) sink->Release();
-        }
+    OleControlState* state = g_oleControlStates.Find(control);
+    if (!state) return;
+    for (auto& sink : state->eventSinks) {
+        if (sink.sink) sink.sink->Release();
+    }
+    for (auto* sink : state->propSinks) {
+        if (sink) sink->Release();
     }
-    g_oleControlStates.erase(it, g_oleControlStates.end());
+    g_oleControlStates.Remove(control);
 }
 
 static void AddDocumentItem(COleDocument* document, COleClientItem* item) {
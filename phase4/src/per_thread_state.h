@@ -0,0 +1,66 @@
+#pragma once
+
+// Lazily created per-thread state objects, as MFC's CThreadLocal hands out
+// for AFX_MODULE_THREAD_STATE (regcore.cpp).
+//
+// A thread's object is allocated on its first Get and deleted when the
+// thread exits, so threads that never ask pay one pointer of TLS. The slot
+// itself is trivially destructible: a Get made during that thread's teardown,
+// after its object is gone, returns the process-wide fallback instead of
+// resurrecting (and leaking) a new one. The fallback is also what an
+// allocation failure gets.
+//
+// TAG keeps unrelated states of the same type in separate slots.
+
+#include <new>
+
+namespace openmfc_threadstate {
+
+template <typename STATE, typename TAG = STATE>
+class PerThread {
+public:
+    static STATE* Get() {
+        Slot& slot = GetSlot();
+        if (slot.pState) {
+            return slot.pState;
+        }
+        if (slot.bClosed) {
+            return &GetFallback();
+        }
+        thread_local Reaper reaper;
+        (void)reaper;
+        slot.pState = new (std::nothrow) STATE();
+        return slot.pState ? slot.pState : &GetFallback();
+    }
+
+    // The calling thread's object if it has one, without creating it.
+    static STATE* Peek() { return GetSlot().pState; }
+
+private:
+    struct Slot {
+        STATE* pState;
+        bool bClosed;
+    };
+
+    struct Reaper {
+        ~Reaper() {
+            Slot& slot = GetSlot();
+            delete slot.pState;
+            slot.pState = nullptr;
+            slot.bClosed = true;
+        }
+    };
+
+    static Slot& GetSlot() {
+        thread_local Slot slot;    // zero-initialised
+        return slot;
+    }
+
+    // Never destroyed, so late callers during process exit stay safe.
+    static STATE& GetFallback() {
+        static STATE* pFallback = new STATE();
+        return *pFallback;
+    }
+};
+
+} // namespace openmfc_threadstate
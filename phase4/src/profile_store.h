@@ -0,0 +1,426 @@
+#pragma once
+
+// Write-behind store for the CWinApp profile functions (appcore.cpp).
+//
+// Every value lives in a warm cache that is loaded from the backend once,
+// on first use, so GetProfile* never touches the registry or the disk.
+// WriteProfile* updates the cache and queues the change. A writer thread
+// waits a short while so a burst of writes lands as one batch, then hands
+// the batch to the backend. Flush blocks until everything queued so far
+// has been saved; Close (called from CWinApp::ExitInstance) also stops the
+// writer.
+//
+// Repeated writes to one entry before a save collapse into one change.
+// Section and entry names are case-insensitive, as in both the registry
+// and INI files.
+//
+// Both backends live in appcore.cpp: the registry one (SetRegistryKey
+// mode) and the INI one (m_pszProfileName mode). The INI backend stores
+// ints as decimal and binary blobs in MFC's two-letters-per-byte encoding,
+// so on reload every INI value comes back as a string and the typed
+// getters convert it.
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cwchar>
+#include <cwctype>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace openmfc_profile {
+
+enum class ValueKind { Int, String, Binary };
+
+struct Value {
+    ValueKind kind = ValueKind::String;
+    unsigned int number = 0;
+    std::wstring text;
+    std::vector<unsigned char> bytes;
+};
+
+enum class ChangeKind { Set, DeleteEntry, DeleteSection };
+
+struct Change {
+    ChangeKind kind = ChangeKind::Set;
+    std::wstring section;
+    std::wstring entry;     // empty for DeleteSection
+    Value value;            // Set only
+};
+
+class Backend {
+public:
+    virtual ~Backend() {}
+    // Appends every persisted value as a Set change. Missing storage is an
+    // empty profile, not an error.
+    virtual bool Load(std::vector<Change>& values) = 0;
+    // Applies one batch, in order. Only ever called from one thread at a time.
+    virtual bool Save(const std::vector<Change>& batch) = 0;
+};
+
+inline std::wstring FoldName(const std::wstring& name) {
+    std::wstring folded(name);
+    for (wchar_t& ch : folded) ch = static_cast<wchar_t>(std::towlower(ch));
+    return folded;
+}
+
+inline std::wstring FormatInt(unsigned int value) {
+    // Signed, as WriteProfileInt takes an int.
+    wchar_t buffer[16];
+    std::swprintf(buffer, 16, L"%d", static_cast<int>(value));
+    return buffer;
+}
+
+// GetPrivateProfileInt rules: leading digits, optional sign, else missing.
+inline bool ParseInt(const std::wstring& text, unsigned int& value) {
+    const wchar_t* begin = text.c_str();
+    wchar_t* end = nullptr;
+    long parsed = std::wcstol(begin, &end, 10);
+    if (end == begin) return false;
+    value = static_cast<unsigned int>(parsed);
+    return true;
+}
+
+// MFC's INI encoding for WriteProfileBinary: low nibble then high nibble,
+// each as 'A' + nibble.
+inline std::wstring EncodeBinary(const std::vector<unsigned char>& bytes) {
+    std::wstring text;
+    text.reserve(bytes.size() * 2);
+    for (unsigned char byte : bytes) {
+        text.push_back(static_cast<wchar_t>(L'A' + (byte & 0x0F)));
+        text.push_back(static_cast<wchar_t>(L'A' + ((byte >> 4) & 0x0F)));
+    }
+    return text;
+}
+
+inline bool DecodeBinary(const std::wstring& text, std::vector<unsigned char>& bytes) {
+    if (text.size() % 2 != 0) return false;
+    std::vector<unsigned char> decoded(text.size() / 2);
+    for (size_t i = 0; i < decoded.size(); ++i) {
+        const wchar_t low = text[i * 2];
+        const wchar_t high = text[i * 2 + 1];
+        if (low < L'A' || low > L'P' || high < L'A' || high > L'P') return false;
+        decoded[i] = static_cast<unsigned char>((low - L'A') | ((high - L'A') << 4));
+    }
+    bytes.swap(decoded);
+    return true;
+}
+
+inline std::wstring ValueToText(const Value& value) {
+    switch (value.kind) {
+    case ValueKind::Int: return FormatInt(value.number);
+    case ValueKind::Binary: return EncodeBinary(value.bytes);
+    default: return value.text;
+    }
+}
+
+class ProfileStore {
+public:
+    static constexpr std::chrono::milliseconds kDefaultBatchDelay{100};
+
+    explicit ProfileStore(std::unique_ptr<Backend> backend,
+                          std::chrono::milliseconds batchDelay = kDefaultBatchDelay)
+        : m_state(std::make_shared<State>(std::move(backend), batchDelay)) {}
+
+    // Does not flush or join: the last CWinApp is usually a global, so this
+    // can run during DLL_PROCESS_DETACH under the loader lock, and at process
+    // exit the writer has already been terminated. A writer that Close never
+    // stopped is told to stop and detached; it shares the state, so it can
+    // still save what is queued if it is alive.
+    ~ProfileStore() {
+        State& state = *m_state;
+        if (!state.writer.joinable()) return;
+        state.bStop = true;
+        // Either the writer is between waits and will see bStop, or it is
+        // waiting and gets the notify. try_lock, not lock: a terminated
+        // writer may have died holding the mutex.
+        if (state.mutex.try_lock()) state.mutex.unlock();
+        state.wake.notify_all();
+        state.writer.detach();
+    }
+
+    ProfileStore(const ProfileStore&) = delete;
+    ProfileStore& operator=(const ProfileStore&) = delete;
+
+    bool GetInt(const wchar_t* section, const wchar_t* entry, unsigned int& value) {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        const Value* found = FindLocked(section, entry);
+        if (!found) return false;
+        if (found->kind == ValueKind::Int) {
+            value = found->number;
+            return true;
+        }
+        return found->kind == ValueKind::String && ParseInt(found->text, value);
+    }
+
+    bool GetString(const wchar_t* section, const wchar_t* entry, std::wstring& value) {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        const Value* found = FindLocked(section, entry);
+        if (!found) return false;
+        value = ValueToText(*found);
+        return true;
+    }
+
+    bool GetBinary(const wchar_t* section, const wchar_t* entry, std::vector<unsigned char>& value) {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        const Value* found = FindLocked(section, entry);
+        if (!found) return false;
+        if (found->kind == ValueKind::Binary) {
+            value = found->bytes;
+            return true;
+        }
+        return found->kind == ValueKind::String && DecodeBinary(found->text, value);
+    }
+
+    void WriteInt(const wchar_t* section, const wchar_t* entry, int number) {
+        Value value;
+        value.kind = ValueKind::Int;
+        value.number = static_cast<unsigned int>(number);
+        Write(section, entry, std::move(value));
+    }
+
+    void WriteString(const wchar_t* section, const wchar_t* entry, const wchar_t* text) {
+        Value value;
+        value.text = text ? text : L"";
+        Write(section, entry, std::move(value));
+    }
+
+    void WriteBinary(const wchar_t* section, const wchar_t* entry, const unsigned char* data, size_t bytes) {
+        Value value;
+        value.kind = ValueKind::Binary;
+        if (data && bytes != 0) value.bytes.assign(data, data + bytes);
+        Write(section, entry, std::move(value));
+    }
+
+    void DeleteEntry(const wchar_t* section, const wchar_t* entry) {
+        State& state = *m_state;
+        std::lock_guard<std::mutex> lock(state.mutex);
+        EnsureLoadedLocked();
+        auto it = state.cache.find(MakeKey(section, entry));
+        if (it == state.cache.end()) return;
+        Change change;
+        change.kind = ChangeKind::DeleteEntry;
+        change.section = it->second.section;
+        change.entry = it->second.entry;
+        state.cache.erase(it);
+        QueueLocked(std::move(change));
+    }
+
+    void DeleteSection(const wchar_t* section) {
+        State& state = *m_state;
+        std::lock_guard<std::mutex> lock(state.mutex);
+        EnsureLoadedLocked();
+        const std::wstring prefix = FoldName(section ? section : L"") + L'\x1f';
+        for (auto it = state.cache.begin(); it != state.cache.end();) {
+            if (it->first.compare(0, prefix.size(), prefix) == 0) it = state.cache.erase(it);
+            else ++it;
+        }
+        Change change;
+        change.kind = ChangeKind::DeleteSection;
+        change.section = section ? section : L"";
+        // Queued per-entry changes for this section are superseded, but must
+        // not be collapsed into by writes that come after the delete.
+        for (auto it = state.pendingIndex.begin(); it != state.pendingIndex.end();) {
+            if (it->first.compare(0, prefix.size(), prefix) == 0) it = state.pendingIndex.erase(it);
+            else ++it;
+        }
+        QueueLocked(std::move(change));
+    }
+
+    // Blocks until every change queued before the call has been handed to
+    // the backend. FALSE if any save since the last Flush failed.
+    bool Flush() {
+        State& state = *m_state;
+        std::unique_lock<std::mutex> lock(state.mutex);
+        const unsigned long long target = state.queued;
+        if (state.saved < target) {
+            state.bFlushRequested = true;
+            state.wake.notify_all();
+            state.saveDone.wait(lock, [&] { return state.saved >= target; });
+        }
+        const bool ok = !state.bSaveFailed;
+        state.bSaveFailed = false;
+        return ok;
+    }
+
+    // Flushes and joins the writer. The cache stays warm; writes made after
+    // Close are saved as they are made.
+    bool Close() {
+        const bool ok = Flush();
+        State& state = *m_state;
+        std::thread writer;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.bWriterStarted = true;
+            state.bSynchronous = true;
+            state.bStop = true;
+            writer.swap(state.writer);
+        }
+        state.wake.notify_all();
+        if (writer.joinable()) writer.join();
+        return ok;
+    }
+
+private:
+    struct CacheEntry {
+        std::wstring section;
+        std::wstring entry;
+        Value value;
+    };
+
+    // Shared with the writer thread, which holds its own reference.
+    struct State {
+        State(std::unique_ptr<Backend> backend_, std::chrono::milliseconds batchDelay_)
+            : backend(std::move(backend_)), batchDelay(batchDelay_) {}
+
+        std::unique_ptr<Backend> backend;
+        const std::chrono::milliseconds batchDelay;
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable saveDone;
+        std::thread writer;
+
+        bool bLoaded = false;
+        std::unordered_map<std::wstring, CacheEntry> cache;
+
+        std::vector<Change> pending;
+        std::unordered_map<std::wstring, size_t> pendingIndex;    // Set/DeleteEntry changes by key
+        unsigned long long queued = 0;     // changes queued so far
+        unsigned long long saved = 0;      // of those, handed to the backend
+        bool bWriterStarted = false;
+        bool bSynchronous = false;
+        bool bFlushRequested = false;
+        std::atomic<bool> bStop{false};
+        bool bSaveFailed = false;
+    };
+
+    static std::wstring MakeKey(const wchar_t* section, const wchar_t* entry) {
+        std::wstring key = FoldName(section ? section : L"");
+        key.push_back(L'\x1f');
+        key.append(FoldName(entry ? entry : L""));
+        return key;
+    }
+
+    void EnsureLoadedLocked() {
+        State& state = *m_state;
+        if (state.bLoaded) return;
+        state.bLoaded = true;
+        std::vector<Change> values;
+        if (!state.backend || !state.backend->Load(values)) return;
+        for (Change& change : values) {
+            const std::wstring key = MakeKey(change.section.c_str(), change.entry.c_str());
+            state.cache[key] = CacheEntry{std::move(change.section), std::move(change.entry), std::move(change.value)};
+        }
+    }
+
+    const Value* FindLocked(const wchar_t* section, const wchar_t* entry) {
+        EnsureLoadedLocked();
+        auto it = m_state->cache.find(MakeKey(section, entry));
+        return it == m_state->cache.end() ? nullptr : &it->second.value;
+    }
+
+    void Write(const wchar_t* section, const wchar_t* entry, Value value) {
+        State& state = *m_state;
+        std::lock_guard<std::mutex> lock(state.mutex);
+        EnsureLoadedLocked();
+        const std::wstring key = MakeKey(section, entry);
+        CacheEntry& cached = state.cache[key];
+        if (cached.section.empty() && cached.entry.empty()) {
+            cached.section = section ? section : L"";
+            cached.entry = entry ? entry : L"";
+        }
+        cached.value = value;
+
+        auto pending = state.pendingIndex.find(key);
+        if (pending != state.pendingIndex.end()) {
+            // Not yet saved: overwrite the queued change in place.
+            Change& change = state.pending[pending->second];
+            change.kind = ChangeKind::Set;
+            change.value = std::move(value);
+            ++state.queued;
+            return;
+        }
+        Change change;
+        change.section = cached.section;
+        change.entry = cached.entry;
+        change.value = std::move(value);
+        state.pendingIndex.emplace(key, state.pending.size());
+        QueueLocked(std::move(change));
+    }
+
+    void QueueLocked(Change change) {
+        State& state = *m_state;
+        if (change.kind == ChangeKind::DeleteEntry) {
+            const std::wstring key = MakeKey(change.section.c_str(), change.entry.c_str());
+            auto pending = state.pendingIndex.find(key);
+            if (pending != state.pendingIndex.end()) {
+                state.pending[pending->second] = std::move(change);
+                ++state.queued;
+                return;
+            }
+            state.pendingIndex.emplace(key, state.pending.size());
+        }
+        state.pending.push_back(std::move(change));
+        ++state.queued;
+        if (!state.bWriterStarted) StartWriterLocked();
+        if (state.bSynchronous) SaveSynchronouslyLocked();
+        else state.wake.notify_one();
+    }
+
+    void StartWriterLocked() {
+        State& state = *m_state;
+        state.bWriterStarted = true;
+        try {
+            state.writer = std::thread(&ProfileStore::WriterLoop, m_state);
+        } catch (const std::system_error&) {
+            state.bSynchronous = true;    // no thread: save on every write
+        }
+    }
+
+    void SaveSynchronouslyLocked() {
+        State& state = *m_state;
+        std::vector<Change> batch;
+        batch.swap(state.pending);
+        state.pendingIndex.clear();
+        if (state.backend && !state.backend->Save(batch)) state.bSaveFailed = true;
+        state.saved = state.queued;
+    }
+
+    static void WriterLoop(std::shared_ptr<State> shared) {
+        State& state = *shared;
+        std::unique_lock<std::mutex> lock(state.mutex);
+        for (;;) {
+            state.wake.wait(lock, [&] { return state.bStop || state.bFlushRequested || !state.pending.empty(); });
+            if (!state.bStop && !state.bFlushRequested) {
+                // Let the rest of a burst arrive before saving.
+                state.wake.wait_for(lock, state.batchDelay, [&] { return state.bStop || state.bFlushRequested; });
+            }
+            std::vector<Change> batch;
+            batch.swap(state.pending);
+            state.pendingIndex.clear();
+            const unsigned long long generation = state.queued;
+            state.bFlushRequested = false;
+
+            lock.unlock();
+            const bool ok = batch.empty() || !state.backend || state.backend->Save(batch);
+            lock.lock();
+
+            if (!ok) state.bSaveFailed = true;
+            state.saved = generation;
+            state.saveDone.notify_all();
+            if (state.bStop && state.pending.empty()) return;
+        }
+    }
+
+    std::shared_ptr<State> m_state;
+};
+
+} // namespace openmfc_profile
@@ -4,6 +4,7 @@
 
 #define OPENMFC_APPCORE_IMPL
 #include "openmfc/afxwin.h"
+#include "per_thread_state.h"
 #include <windows.h>
 #include <cstring>
 
@@ -258,9 +259,8 @@ struct AFX_MODULE_THREAD_STATE {
     int m_nTempMapLock;
 };
 
-static AFX_MODULE_THREAD_STATE g_moduleThreadState;
-
-// AfxGetModuleThreadState
+// AfxGetModuleThreadState - one state per thread, as in MFC: created on the
+// thread's first call and freed when the thread exits.
 extern "C" AFX_MODULE_THREAD_STATE* MS_ABI impl__AfxGetModuleThreadState__YAPEAUAFX_MODULE_THREAD_STATE__XZ() {
-    return &g_moduleThreadState;
+    return openmfc_threadstate::PerThread<AFX_MODULE_THREAD_STATE>::Get();
 }
@@ -0,0 +1,238 @@
+#pragma once
+
+// Name index behind CRuntimeClass::FromName, CreateObject(name) and Load.
+//
+// Classes are keyed by the 64-bit FNV-1a hash of m_lpszClassName in an
+// open-addressed table (linear probing, load factor <= 1/2). Lookups take no
+// lock: a slot's hash is written before its class pointer is published with
+// a release store, and a grown table is filled completely before it replaces
+// the old one. Registration serialises on a mutex. Replaced tables are kept
+// until the registry itself goes away, because a reader may still be probing
+// one; with doubling they add up to less than the live table.
+//
+// The first class registered under a name keeps it, which is what the old
+// registration-order scan returned. Classes without a name are not indexed.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace openmfc_rtreg {
+
+inline uint64_t HashName(const char* psz, size_t nLen) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < nLen; ++i) {
+        h ^= static_cast<unsigned char>(psz[i]);
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+template <class TClass>
+class ClassNameTable {
+public:
+    ClassNameTable() = default;
+    ClassNameTable(const ClassNameTable&) = delete;
+    ClassNameTable& operator=(const ClassNameTable&) = delete;
+    ~ClassNameTable() {
+        Destroy(m_pTable.load(std::memory_order_relaxed));
+        for (Table* pOld : m_retired) {
+            Destroy(pOld);
+        }
+    }
+
+    size_t GetCount() const { return m_nCount.load(std::memory_order_relaxed); }
+
+    // The class registered under the nLen bytes at psz, or nullptr.
+    TClass* Find(const char* psz, size_t nLen) const {
+        const Table* pTable = m_pTable.load(std::memory_order_acquire);
+        if (!pTable || !psz) {
+            return nullptr;
+        }
+        const uint64_t h = HashName(psz, nLen);
+        for (size_t i = static_cast<size_t>(h) & pTable->mask;; i = (i + 1) & pTable->mask) {
+            TClass* p = pTable->slots[i].pClass.load(std::memory_order_acquire);
+            if (!p) {
+                return nullptr;
+            }
+            if (pTable->slots[i].nHash == h && NameEquals(p->m_lpszClassName, psz, nLen)) {
+                return p;
+            }
+        }
+    }
+
+    TClass* Find(const char* pszName) const {
+        return pszName ? Find(pszName, std::strlen(pszName)) : nullptr;
+    }
+
+    // Indexes pClass under its name. Returns false if pClass has no name,
+    // the name is already taken (by pClass or another class), or memory ran
+    // out.
+    bool Add(TClass* pClass) {
+        if (!pClass || !pClass->m_lpszClassName) {
+            return false;
+        }
+        const size_t nLen = std::strlen(pClass->m_lpszClassName);
+        const uint64_t h = HashName(pClass->m_lpszClassName, nLen);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Table* pTable = m_pTable.load(std::memory_order_relaxed);
+        if (pTable && FindSlot(pTable, h, pClass->m_lpszClassName, nLen)) {
+            return false;
+        }
+        const size_t nCount = m_nCount.load(std::memory_order_relaxed);
+        if (!pTable || (nCount + 1) * 2 > pTable->mask + 1) {
+            Table* pNew = Grow(pTable);
+            if (!pNew) {
+                return false;
+            }
+            pTable = pNew;
+        }
+        Insert(pTable, h, pClass);
+        m_nCount.store(nCount + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Drops every class pred(pClass) accepts, for a module that is going
+    // away. Linear probing cannot simply clear slots, so the survivors are
+    // copied into a fresh table that replaces the current one; the current
+    // one is retired like a grown one. Returns the number removed, or 0 if
+    // nothing matched or memory ran out.
+    template <class Pred>
+    size_t RemoveIf(Pred pred) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Table* pOld = m_pTable.load(std::memory_order_relaxed);
+        if (!pOld) {
+            return 0;
+        }
+        size_t nRemoved = 0;
+        for (size_t i = 0; i <= pOld->mask; ++i) {
+            TClass* p = pOld->slots[i].pClass.load(std::memory_order_relaxed);
+            if (p && pred(p)) {
+                ++nRemoved;
+            }
+        }
+        if (nRemoved == 0) {
+            return 0;
+        }
+        Table* pNew = NewTable(pOld->mask + 1);
+        if (!pNew) {
+            return 0;
+        }
+        try {
+            m_retired.push_back(pOld);
+        } catch (...) {
+            Destroy(pNew);
+            return 0;
+        }
+        for (size_t i = 0; i <= pOld->mask; ++i) {
+            TClass* p = pOld->slots[i].pClass.load(std::memory_order_relaxed);
+            if (p && !pred(p)) {
+                Insert(pNew, pOld->slots[i].nHash, p);
+            }
+        }
+        m_pTable.store(pNew, std::memory_order_release);
+        m_nCount.store(m_nCount.load(std::memory_order_relaxed) - nRemoved, std::memory_order_relaxed);
+        return nRemoved;
+    }
+
+private:
+    struct Slot {
+        std::atomic<TClass*> pClass;
+        uint64_t nHash;
+    };
+
+    struct Table {
+        size_t mask;
+        Slot* slots;
+    };
+
+    static const size_t kMinCapacity = 256;
+
+    static bool NameEquals(const char* pszClass, const char* psz, size_t nLen) {
+        return std::strncmp(pszClass, psz, nLen) == 0 && pszClass[nLen] == '\0';
+    }
+
+    static TClass* FindSlot(const Table* pTable, uint64_t h, const char* psz, size_t nLen) {
+        for (size_t i = static_cast<size_t>(h) & pTable->mask;; i = (i + 1) & pTable->mask) {
+            TClass* p = pTable->slots[i].pClass.load(std::memory_order_relaxed);
+            if (!p) {
+                return nullptr;
+            }
+            if (pTable->slots[i].nHash == h && NameEquals(p->m_lpszClassName, psz, nLen)) {
+                return p;
+            }
+        }
+    }
+
+    static void Insert(Table* pTable, uint64_t h, TClass* pClass) {
+        size_t i = static_cast<size_t>(h) & pTable->mask;
+        while (pTable->slots[i].pClass.load(std::memory_order_relaxed)) {
+            i = (i + 1) & pTable->mask;
+        }
+        pTable->slots[i].nHash = h;
+        pTable->slots[i].pClass.store(pClass, std::memory_order_release);
+    }
+
+    // Builds a table of twice the capacity holding everything in pOld and
+    // publishes it. Called with m_mutex held.
+    Table* Grow(Table* pOld) {
+        Table* pNew = NewTable(pOld ? (pOld->mask + 1) * 2 : kMinCapacity);
+        if (!pNew) {
+            return nullptr;
+        }
+        if (pOld) {
+            try {
+                m_retired.push_back(pOld);
+            } catch (...) {
+                Destroy(pNew);
+                return nullptr;
+            }
+            for (size_t i = 0; i <= pOld->mask; ++i) {
+                TClass* p = pOld->slots[i].pClass.load(std::memory_order_relaxed);
+                if (p) {
+                    Insert(pNew, pOld->slots[i].nHash, p);
+                }
+            }
+        }
+        m_pTable.store(pNew, std::memory_order_release);
+        return pNew;
+    }
+
+    // An empty, unpublished table of nCapacity (a power of two) slots.
+    static Table* NewTable(size_t nCapacity) {
+        Table* pNew = new (std::nothrow) Table;
+        if (!pNew) {
+            return nullptr;
+        }
+        pNew->mask = nCapacity - 1;
+        pNew->slots = new (std::nothrow) Slot[nCapacity];
+        if (!pNew->slots) {
+            delete pNew;
+            return nullptr;
+        }
+        for (size_t i = 0; i < nCapacity; ++i) {
+            pNew->slots[i].pClass.store(nullptr, std::memory_order_relaxed);
+            pNew->slots[i].nHash = 0;
+        }
+        return pNew;
+    }
+
+    static void Destroy(Table* pTable) {
+        if (pTable) {
+            delete[] pTable->slots;
+            delete pTable;
+        }
+    }
+
+    std::atomic<Table*> m_pTable{ nullptr };
+    std::atomic<size_t> m_nCount{ 0 };
+    std::vector<Table*> m_retired;
+    std::mutex m_mutex;
+};
+
+} // namespace openmfc_rtreg
@@ -7,12 +7,13 @@
 #define OPENMFC_APPCORE_IMPL
 #include "openmfc/afxwin.h"
 #include "openmfc/afxsock.h"
+#include "socket_file_buffer.h"
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #include <cstring>
 #include <deque>
-#include <map>
 #include <mutex>
+#include <unordered_map>
 
 #ifdef __GNUC__
   #define MS_ABI __attribute__((ms_abi))
@@ -26,8 +27,8 @@
 static int g_bSocketsInitialized = FALSE;
 static WSADATA g_wsaData;
 
-// Simple socket handle map for LookupHandle/KillSocket/AttachHandle
-static std::map<SOCKET, CAsyncSocket*> g_socketMap;
+// Socket handle map for LookupHandle/KillSocket/AttachHandle
+static std::unordered_map<SOCKET, CAsyncSocket*> g_socketMap;
 static std::mutex g_socketMapMutex;
 static constexpr UINT kSocketNotifyMessage = WM_USER + 0;
 static constexpr UINT kSocketDeadMessage = WM_USER + 1;
@@ -38,8 +39,68 @@ struct AuxSocketMessage {
     long lParam;
 };
 
-static std::deque<AuxSocketMessage> g_auxQueue;
-static std::mutex g_auxQueueMutex;
+//=============================================================================
+// Per-thread notification window
+//=============================================================================
+// As in MFC, AsyncSelect hands the socket to WSAAsyncSelect with a hidden
+// message-only window owned by the calling thread, so WinSock posts each
+// FD_* event to the thread that owns the socket and nothing here scans the
+// socket map. The window procedure queues the event on the thread's aux
+// queue and drains it; CSocket's blocking calls queue events for other
+// sockets there while they wait.
+
+namespace {
+
+struct SocketThreadState {
+    HWND hSocketWnd = nullptr;
+    std::deque<AuxSocketMessage> auxQueue;
+
+    ~SocketThreadState() {
+        if (hSocketWnd) {
+            ::DestroyWindow(hSocketWnd);
+        }
+    }
+};
+
+thread_local SocketThreadState t_socketState;
+
+const wchar_t kSocketWndClassName[] = L"OpenMFCSocketNotifyWnd";
+
+LRESULT CALLBACK SocketNotifyWndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
+    if (message == kSocketNotifyMessage || message == kSocketDeadMessage) {
+        // wParam 0 is posted after a blocking call just to drain the queue.
+        if (wParam != 0) {
+            CSocket::AuxQueueAdd(message, (SOCKET)wParam, (long)lParam);
+        }
+        CSocket::ProcessAuxQueue();
+        return 0;
+    }
+    return ::DefWindowProcW(hWnd, message, wParam, lParam);
+}
+
+// The calling thread's notification window, created on first use.
+HWND GetSocketWindow() {
+    SocketThreadState& state = t_socketState;
+    if (state.hSocketWnd) {
+        return state.hSocketWnd;
+    }
+    HINSTANCE hInstance = ::GetModuleHandleW(nullptr);
+    WNDCLASSEXW existing = {};
+    existing.cbSize = sizeof(existing);
+    if (!::GetClassInfoExW(hInstance, kSocketWndClassName, &existing)) {
+        WNDCLASSEXW wc = {};
+        wc.cbSize = sizeof(wc);
+        wc.lpfnWndProc = SocketNotifyWndProc;
+        wc.hInstance = hInstance;
+        wc.lpszClassName = kSocketWndClassName;
+        ::RegisterClassExW(&wc);
+    }
+    state.hSocketWnd = ::CreateWindowExW(0, kSocketWndClassName, L"", 0, 0, 0, 0, 0,
+                                         HWND_MESSAGE, nullptr, hInstance, nullptr);
+    return state.hSocketWnd;
+}
+
+} // namespace
 
 //=============================================================================
 // AfxSocketInit (existing public export - symbol already in thunks.cpp)
@@ -103,6 +164,7 @@ int CAsyncSocket::Create(UINT nSocketPort, int nSocketType,
     m_hSocket = socket(AF_INET, nSocketType, 0);
     if (m_hSocket == INVALID_SOCKET) return FALSE;
 
+    AttachHandle(m_hSocket, this, FALSE);
     m_nSocketType = nSocketType;
     m_lEvent = lEvent;
 
@@ -283,11 +345,13 @@ int CAsyncSocket::ReceiveFromHelper(void* lpBuf, int nBufLen, sockaddr* lpSockAd
 
 int CAsyncSocket::AsyncSelect(long lEvent) {
     if (m_hSocket == INVALID_SOCKET) return FALSE;
-    m_lEvent = lEvent;
-    if (lEvent != 0) {
-        u_long mode = 1;
-        ioctlsocket(m_hSocket, FIONBIO, &mode);
+    // WSAAsyncSelect also makes the socket non-blocking; lEvent == 0 cancels
+    // notifications but leaves it non-blocking, as in MFC.
+    HWND hWnd = GetSocketWindow();
+    if (!hWnd || ::WSAAsyncSelect(m_hSocket, hWnd, kSocketNotifyMessage, lEvent) == SOCKET_ERROR) {
+        return FALSE;
     }
+    m_lEvent = lEvent;
     return TRUE;
 }
 
@@ -359,11 +423,20 @@ void CAsyncSocket::DoCallBack(SOCKET hSocket, long lParam) {
     CAsyncSocket* pSocket = LookupHandle(hSocket, FALSE);
     if (!pSocket) return;
 
-    const int nErrorCode = WSAGETSELECTERROR(lParam);
+    int nErrorCode = WSAGETSELECTERROR(lParam);
     switch (WSAGETSELECTEVENT(lParam)) {
-    case FD_READ:
-        pSocket->OnReceive(nErrorCode);
+    case FD_READ: {
+        // WinSock can post FD_READ for data an earlier Receive already took;
+        // only report it if something is actually waiting (as MFC does).
+        DWORD nBytes = 0;
+        if (!nErrorCode && pSocket->IOCtl(FIONREAD, &nBytes) == SOCKET_ERROR) {
+            nErrorCode = WSAGetLastError();
+        }
+        if (nBytes != 0 || nErrorCode != 0) {
+            pSocket->OnReceive(nErrorCode);
+        }
         break;
+    }
     case FD_WRITE:
         pSocket->OnSend(nErrorCode);
         break;
@@ -425,6 +498,7 @@ int CAsyncSocket::Socket(int nSocketType, long lEvent, int nProtocolType, int nA
     m_hSocket = socket(nAddressFormat, nSocketType, nProtocolType);
     if (m_hSocket == INVALID_SOCKET) return FALSE;
 
+    AttachHandle(m_hSocket, this, FALSE);
     m_nSocketType = nSocketType;
     m_lEvent = lEvent;
 
@@ -448,7 +522,7 @@ void CAsyncSocket::OnSend(int nErrorCode) { (void)nErrorCode; }
 IMPLEMENT_DYNAMIC(CSocket, CAsyncSocket)
 
 CSocket::CSocket()
-    : CAsyncSocket(), m_bBlocking(FALSE)
+    : CAsyncSocket(), m_bBlocking(FALSE), m_nConnectError(-1), m_nTimeOut(2000)
 {
     memset(_socket_padding, 0, sizeof(_socket_padding));
 }
@@ -459,14 +533,16 @@ CSocket::~CSocket() {
 int CSocket::Accept(CAsyncSocket& rConnectedSocket,
                      sockaddr* lpSockAddr, int* lpSockAddrLen) {
     if (m_hSocket == INVALID_SOCKET) return FALSE;
+    if (m_bBlocking) {
+        WSASetLastError(WSAEINPROGRESS);
+        return FALSE;
+    }
 
-    SOCKET hNew = ::accept(m_hSocket, lpSockAddr, lpSockAddrLen);
-    if (hNew == INVALID_SOCKET) {
-        if (m_bBlocking && WSAGetLastError() == WSAEWOULDBLOCK) {
-            PumpMessages(FD_ACCEPT);
-            hNew = ::accept(m_hSocket, lpSockAddr, lpSockAddrLen);
+    SOCKET hNew;
+    while ((hNew = ::accept(m_hSocket, lpSockAddr, lpSockAddrLen)) == INVALID_SOCKET) {
+        if (WSAGetLastError() != WSAEWOULDBLOCK || !PumpMessages(FD_ACCEPT)) {
+            return FALSE;
         }
-        if (hNew == INVALID_SOCKET) return FALSE;
     }
 
     rConnectedSocket.Attach(hNew);
@@ -479,15 +555,24 @@ void CSocket::Close() {
 }
 
 int CSocket::Send(const void* lpBuf, int nBufLen, int nFlags) {
+    if (m_bBlocking) {
+        WSASetLastError(WSAEINPROGRESS);
+        return SOCKET_ERROR;
+    }
     return SendChunk(lpBuf, nBufLen, nFlags);
 }
 
 int CSocket::Receive(void* lpBuf, int nBufLen, int nFlags) {
     if (m_hSocket == INVALID_SOCKET) return SOCKET_ERROR;
-    int result = ::recv(m_hSocket, (char*)lpBuf, nBufLen, nFlags);
-    if (result == SOCKET_ERROR && m_bBlocking && WSAGetLastError() == WSAEWOULDBLOCK) {
-        PumpMessages(FD_READ);
-        result = ::recv(m_hSocket, (char*)lpBuf, nBufLen, nFlags);
+    if (m_bBlocking) {
+        WSASetLastError(WSAEINPROGRESS);
+        return SOCKET_ERROR;
+    }
+    int result;
+    while ((result = ::recv(m_hSocket, (char*)lpBuf, nBufLen, nFlags)) == SOCKET_ERROR) {
+        if (WSAGetLastError() != WSAEWOULDBLOCK || !PumpMessages(FD_READ)) {
+            return SOCKET_ERROR;
+        }
     }
     return result;
 }
@@ -518,13 +603,46 @@ int CSocket::ReceiveFrom(void* lpBuf, int nBufLen, CString& rSocketAddress,
 
 int CSocket::IsBlocking() const { return m_bBlocking; }
 
+// Makes the blocking call in progress fail with WSAEINTR. Meant to be
+// called from OnMessagePending (or a message handler it dispatches).
 int CSocket::CancelBlockingCall() {
     m_bBlocking = FALSE;
     return TRUE;
 }
 
 int CSocket::ConnectHelper(const sockaddr* lpSockAddr, int nSockAddrLen) {
-    return CAsyncSocket::ConnectHelper(lpSockAddr, nSockAddrLen);
+    if (m_hSocket == INVALID_SOCKET) return FALSE;
+    if (m_bBlocking) {
+        WSASetLastError(WSAEINPROGRESS);
+        return FALSE;
+    }
+
+    m_nConnectError = -1;
+    if (::connect(m_hSocket, lpSockAddr, nSockAddrLen) != SOCKET_ERROR) {
+        m_bConnected = TRUE;
+        return TRUE;
+    }
+    if (WSAGetLastError() != WSAEWOULDBLOCK) {
+        return FALSE;
+    }
+    while (m_nConnectError == -1) {
+        if (!PumpMessages(FD_CONNECT)) {
+            return FALSE;
+        }
+        if (m_nConnectError == -1) {
+            // Woken by the poll fallback rather than FD_CONNECT.
+            int nError = 0;
+            int nLen = sizeof(nError);
+            ::getsockopt(m_hSocket, SOL_SOCKET, SO_ERROR, (char*)&nError, &nLen);
+            m_nConnectError = nError;
+        }
+    }
+    if (m_nConnectError != 0) {
+        WSASetLastError(m_nConnectError);
+        return FALSE;
+    }
+    m_bConnected = TRUE;
+    return TRUE;
 }
 
 int CSocket::SendChunk(const void* lpBuf, int nBufLen, int nFlags) {
@@ -534,11 +652,12 @@ int CSocket::SendChunk(const void* lpBuf, int nBufLen, int nFlags) {
     while (nLeft > 0) {
         int nSent = ::send(m_hSocket, pBuf, nLeft, nFlags);
         if (nSent == SOCKET_ERROR) {
-            if (m_bBlocking && WSAGetLastError() == WSAEWOULDBLOCK) {
-                PumpMessages(FD_WRITE);
-                continue;
+            // FD_WRITE is posted once send() has failed with WSAEWOULDBLOCK
+            // and buffer space frees up.
+            if (WSAGetLastError() != WSAEWOULDBLOCK || !PumpMessages(FD_WRITE)) {
+                return SOCKET_ERROR;
             }
-            return SOCKET_ERROR;
+            continue;
         }
         pBuf += nSent;
         nLeft -= nSent;
@@ -546,13 +665,52 @@ int CSocket::SendChunk(const void* lpBuf, int nBufLen, int nFlags) {
     return nBufLen;
 }
 
+// Sends every buffer in order, as one WSASend where the stack takes it all,
+// so buffered bytes and a caller's block go out without being copied
+// together first. The array is advanced in place past what was sent.
+int CSocket::SendChunks(WSABUF* lpBuffers, DWORD dwBufferCount, int nFlags) {
+    if (m_hSocket == INVALID_SOCKET) return SOCKET_ERROR;
+    if (m_bBlocking) {
+        WSASetLastError(WSAEINPROGRESS);
+        return SOCKET_ERROR;
+    }
+    ULONGLONG nTotal = 0;
+    for (DWORD i = 0; i < dwBufferCount; ++i) {
+        nTotal += lpBuffers[i].len;
+    }
+    while (dwBufferCount > 0) {
+        DWORD dwSent = 0;
+        if (::WSASend(m_hSocket, lpBuffers, dwBufferCount, &dwSent, (DWORD)nFlags, nullptr, nullptr) == SOCKET_ERROR) {
+            if (WSAGetLastError() != WSAEWOULDBLOCK || !PumpMessages(FD_WRITE)) {
+                return SOCKET_ERROR;
+            }
+            continue;
+        }
+        while (dwBufferCount > 0 && dwSent >= lpBuffers->len) {
+            dwSent -= lpBuffers->len;
+            ++lpBuffers;
+            --dwBufferCount;
+        }
+        if (dwBufferCount > 0) {
+            lpBuffers->buf += dwSent;
+            lpBuffers->len -= dwSent;
+        }
+    }
+    return nTotal > 0x7FFFFFFF ? 0x7FFFFFFF : (int)nTotal;
+}
+
 int CSocket::ReceiveFromHelper(void* lpBuf, int nBufLen, sockaddr* lpSockAddr,
                                 int* lpSockAddrLen, int nFlags) {
     if (m_hSocket == INVALID_SOCKET) return SOCKET_ERROR;
-    int result = ::recvfrom(m_hSocket, (char*)lpBuf, nBufLen, nFlags, lpSockAddr, lpSockAddrLen);
-    if (result == SOCKET_ERROR && m_bBlocking && WSAGetLastError() == WSAEWOULDBLOCK) {
-        PumpMessages(FD_READ);
-        result = ::recvfrom(m_hSocket, (char*)lpBuf, nBufLen, nFlags, lpSockAddr, lpSockAddrLen);
+    if (m_bBlocking) {
+        WSASetLastError(WSAEINPROGRESS);
+        return SOCKET_ERROR;
+    }
+    int result;
+    while ((result = ::recvfrom(m_hSocket, (char*)lpBuf, nBufLen, nFlags, lpSockAddr, lpSockAddrLen)) == SOCKET_ERROR) {
+        if (WSAGetLastError() != WSAEWOULDBLOCK || !PumpMessages(FD_READ)) {
+            return SOCKET_ERROR;
+        }
     }
     return result;
 }
@@ -560,22 +718,38 @@ int CSocket::ReceiveFromHelper(void* lpBuf, int nBufLen, sockaddr* lpSockAddr,
 int CSocket::SendToHelper(const void* lpBuf, int nBufLen, const sockaddr* lpSockAddr,
                            int nSockAddrLen, int nFlags) {
     if (m_hSocket == INVALID_SOCKET) return SOCKET_ERROR;
-    return ::sendto(m_hSocket, (const char*)lpBuf, nBufLen, nFlags, lpSockAddr, nSockAddrLen);
+    if (m_bBlocking) {
+        WSASetLastError(WSAEINPROGRESS);
+        return SOCKET_ERROR;
+    }
+    int result;
+    while ((result = ::sendto(m_hSocket, (const char*)lpBuf, nBufLen, nFlags, lpSockAddr, nSockAddrLen)) == SOCKET_ERROR) {
+        if (WSAGetLastError() != WSAEWOULDBLOCK || !PumpMessages(FD_WRITE)) {
+            return SOCKET_ERROR;
+        }
+    }
+    return result;
 }
 
+// Called while blocked: when messages arrive and every m_nTimeOut ms. Like
+// MFC, only WM_PAINT is dispatched so windows keep repainting without
+// re-entering input handlers; override to do more (or to call
+// CancelBlockingCall for an overall timeout).
 int CSocket::OnMessagePending() {
-    ProcessAuxQueue();
-    return PumpMessages(0);
+    MSG msg;
+    if (::PeekMessageW(&msg, nullptr, WM_PAINT, WM_PAINT, PM_REMOVE)) {
+        ::DispatchMessageW(&msg);
+    }
+    return FALSE;
 }
 
 int CSocket::ProcessAuxQueue() {
+    std::deque<AuxSocketMessage>& queue = t_socketState.auxQueue;
+    if (queue.empty()) return TRUE;
     std::deque<AuxSocketMessage> pending;
-    {
-        std::lock_guard<std::mutex> lock(g_auxQueueMutex);
-        if (g_auxQueue.empty()) return TRUE;
-        pending.swap(g_auxQueue);
-    }
+    pending.swap(queue);
 
+    // A callback may queue more events; they are handled on the next drain.
     for (const auto& item : pending) {
         if (item.message == kSocketNotifyMessage) {
             CAsyncSocket::DoCallBack(item.socket, item.lParam);
@@ -589,19 +763,76 @@ int CSocket::ProcessAuxQueue() {
 }
 
 void CSocket::AuxQueueAdd(UINT message, SOCKET hSocket, long lParam) {
-    std::lock_guard<std::mutex> lock(g_auxQueueMutex);
-    g_auxQueue.push_back({message, hSocket, lParam});
+    t_socketState.auxQueue.push_back({message, hSocket, lParam});
 }
 
+// Waits until this socket reports one of uStopFlag (or FD_CLOSE). The wait
+// is MsgWaitForMultipleObjectsEx on the thread's message queue, where the
+// notification window's FD_* messages arrive, so it sleeps until something
+// happens. Notifications for other sockets are moved to the aux queue and
+// delivered once the blocking call ends. Every m_nTimeOut ms without a
+// notification the socket is also checked directly, in case it was
+// selected from another thread. Returns FALSE with WSAEINTR if
+// CancelBlockingCall was called.
 int CSocket::PumpMessages(UINT uStopFlag) {
-    (void)uStopFlag;
-    MSG msg;
-    for (int i = 0; i < 100; i++) {
-        if (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
-            TranslateMessage(&msg);
-            DispatchMessageW(&msg);
+    HWND hSocketWnd = GetSocketWindow();
+    m_bBlocking = TRUE;
+    bool bReady = false;
+    while (m_bBlocking && !bReady) {
+        MSG msg;
+        while (!bReady && ::PeekMessageW(&msg, hSocketWnd, kSocketNotifyMessage, kSocketDeadMessage, PM_REMOVE)) {
+            SOCKET hSocket = (SOCKET)msg.wParam;
+            long lEvent = (long)msg.lParam;
+            if (msg.message == kSocketNotifyMessage && hSocket == m_hSocket &&
+                (WSAGETSELECTEVENT(lEvent) & (uStopFlag | FD_CLOSE))) {
+                if (WSAGETSELECTEVENT(lEvent) & FD_CONNECT) {
+                    m_nConnectError = WSAGETSELECTERROR(lEvent);
+                }
+                bReady = true;
+                // Let OnClose still see FD_CLOSE once the call returns.
+                if (WSAGETSELECTEVENT(lEvent) & FD_CLOSE) {
+                    AuxQueueAdd(msg.message, hSocket, lEvent);
+                }
+            } else if (hSocket != 0) {
+                AuxQueueAdd(msg.message, hSocket, lEvent);
+            }
+        }
+        if (bReady) {
+            break;
+        }
+        OnMessagePending();
+        if (!m_bBlocking) {
+            break;
+        }
+
+        DWORD dwWait = ::MsgWaitForMultipleObjectsEx(0, nullptr, (DWORD)m_nTimeOut, QS_ALLINPUT, 0);
+        if (dwWait == WAIT_TIMEOUT) {
+            fd_set readSet, writeSet, exceptSet;
+            FD_ZERO(&readSet);
+            FD_ZERO(&writeSet);
+            FD_ZERO(&exceptSet);
+            FD_SET(m_hSocket, &readSet);
+            FD_SET(m_hSocket, &writeSet);
+            FD_SET(m_hSocket, &exceptSet);
+            timeval tvZero = { 0, 0 };
+            fd_set* pRead = (uStopFlag & (FD_READ | FD_ACCEPT)) ? &readSet : nullptr;
+            fd_set* pWrite = (uStopFlag & (FD_WRITE | FD_CONNECT)) ? &writeSet : nullptr;
+            fd_set* pExcept = (uStopFlag & FD_CONNECT) ? &exceptSet : nullptr;
+            if (::select(0, pRead, pWrite, pExcept, &tvZero) > 0) {
+                bReady = true;
+            }
         }
     }
+
+    const bool bCancelled = !m_bBlocking;
+    m_bBlocking = FALSE;
+    if (!t_socketState.auxQueue.empty()) {
+        ::PostMessageW(hSocketWnd, kSocketNotifyMessage, 0, 0);
+    }
+    if (bCancelled && !bReady) {
+        WSASetLastError(WSAEINTR);
+        return FALSE;
+    }
     return TRUE;
 }
 
@@ -620,39 +851,75 @@ CRuntimeClass CSocketFile::classCSocketFile = {
     nullptr
 };
 
+struct CSocketFileBuffers : openmfc_sockfile::SocketFileBuffer<CSocket, WSABUF> {};
+
 CSocketFile::CSocketFile(CSocket* pSocket, int bArchiveCompatible)
-    : CFile(), m_pSocket(pSocket), m_bArchiveCompatible(bArchiveCompatible)
+    : CFile(), m_pSocket(pSocket), m_bArchiveCompatible(bArchiveCompatible),
+      m_pBuffers(new (std::nothrow) CSocketFileBuffers)
 {
     memset(_socketfile_padding, 0, sizeof(_socketfile_padding));
 }
 
 CSocketFile::~CSocketFile() {
+    // Unsent bytes go out before the file goes away, as MFC's archive Close
+    // would have sent them.
+    if (m_pSocket && m_pBuffers) {
+        m_pBuffers->Flush(*m_pSocket);
+    }
+    delete m_pBuffers;
+}
+
+int CSocketFile::SetBufferSizes(UINT nReadAhead, UINT nWriteCoalesce) {
+    return (m_pBuffers && m_pBuffers->SetSizes(nReadAhead, nWriteCoalesce)) ? TRUE : FALSE;
 }
 
 UINT CSocketFile::Read(void* lpBuf, UINT nCount) {
     if (!m_pSocket) return 0;
+    if (m_pBuffers) {
+        // Never block with coalesced writes still held back: a
+        // request/response peer is waiting for what was written so far.
+        m_pBuffers->Flush(*m_pSocket);
+        return m_pBuffers->Read(*m_pSocket, lpBuf, nCount);
+    }
     int result = m_pSocket->Receive(lpBuf, (int)nCount);
     return (result == SOCKET_ERROR) ? 0 : (UINT)result;
 }
 
 void CSocketFile::Write(const void* lpBuf, UINT nCount) {
-    if (m_pSocket) {
-        m_pSocket->Send(lpBuf, (int)nCount);
+    if (!m_pSocket) return;
+    if (m_pBuffers) {
+        m_pBuffers->Write(*m_pSocket, lpBuf, nCount);
+        return;
     }
+    m_pSocket->Send(lpBuf, (int)nCount);
 }
 
 void CSocketFile::Close() {
     // Detach only - don't close the underlying socket
+    Flush();
 }
 
+// The only seek a socket supports: stepping back over the unread tail of
+// the last GetBufferPtr(bufferRead) window, which CArchive does before it
+// asks for the next one.
 ULONGLONG CSocketFile::Seek(LONGLONG lOff, UINT nFrom) {
-    (void)lOff; (void)nFrom;
+    if (m_pBuffers && nFrom == current && lOff <= 0 &&
+        m_pBuffers->StepBack((unsigned)-lOff)) {
+        return 0;
+    }
     return (ULONGLONG)-1;
 }
 
-void CSocketFile::Flush() { /* no-op: no buffering */ }
+void CSocketFile::Flush() {
+    if (m_pSocket && m_pBuffers) {
+        m_pBuffers->Flush(*m_pSocket);
+    }
+}
 
 void CSocketFile::Abort() {
+    if (m_pBuffers) {
+        m_pBuffers->Discard();
+    }
     if (m_pSocket) {
         m_pSocket->Close();
     }
@@ -666,10 +933,32 @@ CFile* CSocketFile::Duplicate() const {
     return new CSocketFile(m_pSocket, m_bArchiveCompatible);
 }
 
+// With both buffers on, CArchive works in the socket file's buffers
+// directly (bufferDirect). bufferBlocking tells it that bufferRead's count
+// is the minimum it needs: the call waits for that many bytes and the
+// window covers everything received so far.
 UINT CSocketFile::GetBufferPtr(UINT nCommand, UINT nCount, void** ppBufStart, void** ppBufMax) {
-    (void)nCommand; (void)nCount;
-    if (ppBufStart) *ppBufStart = nullptr;
-    if (ppBufMax) *ppBufMax = nullptr;
+    if (nCommand == bufferCheck) {
+        return (m_pSocket && m_pBuffers && m_pBuffers->IsDirect()) ? (bufferDirect | bufferBlocking) : bufferBlocking;
+    }
+    if (!m_pSocket || !m_pBuffers) {
+        if (ppBufStart) *ppBufStart = nullptr;
+        if (ppBufMax) *ppBufMax = nullptr;
+        return 0;
+    }
+    if (nCommand == bufferCommit) {
+        m_pBuffers->Commit(nCount);
+        return 0;
+    }
+    if (!ppBufStart || !ppBufMax) return 0;
+    if (nCommand == bufferRead) {
+        m_pBuffers->Flush(*m_pSocket);
+        return m_pBuffers->ReadWindow(*m_pSocket, nCount, ppBufStart, ppBufMax);
+    }
+    if (nCommand == bufferWrite) {
+        return m_pBuffers->WriteWindow(*m_pSocket, nCount, ppBufStart, ppBufMax);
+    }
+    *ppBufStart = *ppBufMax = nullptr;
     return 0;
 }
 
@@ -697,22 +986,14 @@ CSocketWnd::CSocketWnd() : CWnd() {
 }
 
 LRESULT CSocketWnd::OnSocketNotify(WPARAM wParam, LPARAM lParam) {
-    SOCKET hSocket = (SOCKET)wParam;
-    long lEvent = (long)lParam;
-    CAsyncSocket* pSocket = CAsyncSocket::LookupHandle(hSocket, FALSE);
-    if (pSocket) {
-        CAsyncSocket::DoCallBack(hSocket, lEvent);
-    }
+    CSocket::AuxQueueAdd(kSocketNotifyMessage, (SOCKET)wParam, (long)lParam);
+    CSocket::ProcessAuxQueue();
     return 0;
 }
 
 LRESULT CSocketWnd::OnSocketDead(WPARAM wParam, LPARAM lParam) {
-    SOCKET hSocket = (SOCKET)wParam;
-    (void)lParam;
-    CAsyncSocket* pSocket = CAsyncSocket::LookupHandle(hSocket, TRUE);
-    if (pSocket) {
-        pSocket->Close();
-    }
+    CSocket::AuxQueueAdd(kSocketDeadMessage, (SOCKET)wParam, (long)lParam);
+    CSocket::ProcessAuxQueue();
     return 0;
 }
 
@@ -914,6 +1195,14 @@ extern "C" unsigned int MS_ABI impl__GetBufferPtr_CSocketFile__UEAAIIIPEAPEAX0_Z
     return pThis->GetBufferPtr(nCommand, nCount, ppBufStart, ppBufMax);
 }
 
+// OpenMFC extension, not in the MFC ordinal map: build_phase4.sh adds it to
+// the .def file.
+// Symbol: ?SetBufferSizes@CSocketFile@@QEAAHII@Z
+extern "C" int MS_ABI impl__SetBufferSizes_CSocketFile__QEAAHII_Z(
+        CSocketFile* pThis, unsigned int nReadAhead, unsigned int nWriteCoalesce) {
+    return pThis->SetBufferSizes(nReadAhead, nWriteCoalesce);
+}
+
 // Symbol: ?LockRange@CSocketFile@@UEAAX_K0@Z
 extern "C" void MS_ABI impl__LockRange_CSocketFile__UEAAX_K0_Z(
         CSocketFile* pThis, unsigned long long dwPos, unsigned long long dwCount) {
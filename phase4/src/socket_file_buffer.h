@@ -0,0 +1,254 @@
+#pragma once
+
+// Read-ahead and write-coalescing buffers behind CSocketFile.
+//
+// Both sides start off, so a CSocketFile sends each Write and receives each
+// Read as MFC's does; CSocketFile::SetBufferSizes turns them on (kDefaultSize
+// is the size it was tuned with). With write coalescing on, written bytes
+// stay buffered until the buffer fills or the file is flushed; CSocketFile
+// also flushes before every read, so a request/response peer always sees
+// the request before this side blocks waiting for the answer.
+//
+// Reads are served from a read-ahead buffer that each receive fills as far
+// as the socket allows, so an archive asking for a few bytes at a time does
+// not make a recv call per field. Writes are copied into a coalescing
+// buffer. When a write does not fit, the buffered bytes and the caller's
+// block go out together in one gathered send, and the caller's block is
+// never copied.
+//
+// The same buffers back CFile::GetBufferPtr, so a CArchive can serialize
+// straight into the send buffer and parse straight out of the receive
+// buffer:
+//   ReadWindow(n)   blocks until at least n bytes are buffered (or the
+//                   peer closes), then hands out everything buffered and
+//                   counts it as consumed.
+//   StepBack(n)     un-consumes the last n bytes of that window; the
+//                   archive does this with its unread tail before asking
+//                   for the next window.
+//   WriteWindow(n)  returns up to n bytes of free space after the committed
+//                   data, sending first if less than n is free.
+//   Commit(n)       appends n bytes written into the last write window.
+// Flush sends the committed bytes but keeps their offsets, so a write
+// window handed out before the flush stays valid. The buffer only rewinds
+// once it is empty and a new window is asked for.
+//
+// TSocket provides int Receive(void*, int) (0 = closed, < 0 = error) and
+// int SendChunks(TBuf*, unsigned long), which sends every buffer in order
+// (advancing them in place) and returns < 0 on error. TBuf has the shape of
+// WSABUF: { len, buf }. Buffers are allocated on first use; if that fails
+// the calls go straight to the socket.
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+namespace openmfc_sockfile {
+
+template <class TSocket, class TBuf>
+class SocketFileBuffer {
+public:
+    static const unsigned kDefaultSize = 64 * 1024;
+
+    SocketFileBuffer() = default;
+    SocketFileBuffer(const SocketFileBuffer&) = delete;
+    SocketFileBuffer& operator=(const SocketFileBuffer&) = delete;
+    ~SocketFileBuffer() {
+        delete[] m_pRead;
+        delete[] m_pWrite;
+    }
+
+    // 0 turns that side's buffering off. Refused while data is buffered.
+    bool SetSizes(unsigned nReadAhead, unsigned nWriteCoalesce) {
+        if (m_nReadPos != m_nReadEnd || m_nWriteStart != m_nWriteEnd) {
+            return false;
+        }
+        delete[] m_pRead;
+        delete[] m_pWrite;
+        m_pRead = m_pWrite = nullptr;
+        m_nReadSize = nReadAhead;
+        m_nWriteSize = nWriteCoalesce;
+        m_nReadPos = m_nReadEnd = m_nWriteStart = m_nWriteEnd = 0;
+        return true;
+    }
+
+    unsigned GetReadSize() const { return m_nReadSize; }
+    unsigned GetWriteSize() const { return m_nWriteSize; }
+
+    // GetBufferPtr windows are offered only with both buffers configured.
+    bool IsDirect() const { return m_nReadSize != 0 && m_nWriteSize != 0; }
+
+    unsigned Read(TSocket& socket, void* lpBuf, unsigned nCount) {
+        if (nCount == 0) {
+            return 0;
+        }
+        if (m_nReadPos == m_nReadEnd) {
+            // A request at least as large as the buffer gains nothing from
+            // staging; receive into the caller's memory.
+            if (nCount >= m_nReadSize || !EnsureRead()) {
+                int nGot = socket.Receive(lpBuf, ClampInt(nCount));
+                return nGot > 0 ? static_cast<unsigned>(nGot) : 0;
+            }
+            m_nReadPos = m_nReadEnd = 0;
+            if (!ReceiveMore(socket)) {
+                return 0;
+            }
+        }
+        unsigned nCopy = m_nReadEnd - m_nReadPos;
+        if (nCopy > nCount) {
+            nCopy = nCount;
+        }
+        std::memcpy(lpBuf, m_pRead + m_nReadPos, nCopy);
+        m_nReadPos += nCopy;
+        return nCopy;
+    }
+
+    bool Write(TSocket& socket, const void* lpBuf, unsigned nCount) {
+        if (nCount == 0) {
+            return true;
+        }
+        if (EnsureWrite()) {
+            if (m_nWriteStart == m_nWriteEnd) {
+                m_nWriteStart = m_nWriteEnd = 0;
+            }
+            if (nCount <= m_nWriteSize - m_nWriteEnd) {
+                std::memcpy(m_pWrite + m_nWriteEnd, lpBuf, nCount);
+                m_nWriteEnd += nCount;
+                return true;
+            }
+        }
+        TBuf chunks[2];
+        unsigned long nChunks = 0;
+        if (m_nWriteStart != m_nWriteEnd) {
+            chunks[nChunks].len = m_nWriteEnd - m_nWriteStart;
+            chunks[nChunks].buf = reinterpret_cast<char*>(m_pWrite + m_nWriteStart);
+            ++nChunks;
+        }
+        chunks[nChunks].len = nCount;
+        chunks[nChunks].buf = const_cast<char*>(static_cast<const char*>(lpBuf));
+        ++nChunks;
+        // The connection is unusable after a failed send; nothing buffered
+        // can still be delivered.
+        m_nWriteStart = m_nWriteEnd = 0;
+        return socket.SendChunks(chunks, nChunks) >= 0;
+    }
+
+    bool Flush(TSocket& socket) {
+        if (m_nWriteStart == m_nWriteEnd) {
+            return true;
+        }
+        TBuf chunk;
+        chunk.len = m_nWriteEnd - m_nWriteStart;
+        chunk.buf = reinterpret_cast<char*>(m_pWrite + m_nWriteStart);
+        m_nWriteStart = m_nWriteEnd;
+        return socket.SendChunks(&chunk, 1) >= 0;
+    }
+
+    // Drops everything buffered in both directions (CFile::Abort).
+    void Discard() { m_nReadPos = m_nReadEnd = m_nWriteStart = m_nWriteEnd = 0; }
+
+    unsigned ReadWindow(TSocket& socket, unsigned nNeeded, void** ppBufStart, void** ppBufMax) {
+        *ppBufStart = *ppBufMax = nullptr;
+        if (!EnsureRead()) {
+            return 0;
+        }
+        if (nNeeded > m_nReadSize) {
+            nNeeded = m_nReadSize;
+        }
+        if (m_nReadEnd - m_nReadPos < nNeeded) {
+            if (m_nReadPos != 0) {
+                std::memmove(m_pRead, m_pRead + m_nReadPos, m_nReadEnd - m_nReadPos);
+                m_nReadEnd -= m_nReadPos;
+                m_nReadPos = 0;
+            }
+            while (m_nReadEnd < nNeeded && ReceiveMore(socket)) {
+            }
+        }
+        unsigned nAvail = m_nReadEnd - m_nReadPos;
+        *ppBufStart = m_pRead + m_nReadPos;
+        *ppBufMax = m_pRead + m_nReadEnd;
+        m_nReadPos = m_nReadEnd;
+        return nAvail;
+    }
+
+    bool StepBack(unsigned nCount) {
+        if (nCount > m_nReadPos) {
+            return false;
+        }
+        m_nReadPos -= nCount;
+        return true;
+    }
+
+    unsigned WriteWindow(TSocket& socket, unsigned nCount, void** ppBufStart, void** ppBufMax) {
+        *ppBufStart = *ppBufMax = nullptr;
+        if (!EnsureWrite()) {
+            return 0;
+        }
+        if (nCount > m_nWriteSize) {
+            nCount = m_nWriteSize;
+        }
+        if (m_nWriteSize - m_nWriteEnd < nCount && !Flush(socket)) {
+            return 0;
+        }
+        if (m_nWriteStart == m_nWriteEnd) {
+            m_nWriteStart = m_nWriteEnd = 0;
+        }
+        unsigned nAvail = m_nWriteSize - m_nWriteEnd;
+        if (nAvail > nCount) {
+            nAvail = nCount;
+        }
+        *ppBufStart = m_pWrite + m_nWriteEnd;
+        *ppBufMax = m_pWrite + m_nWriteEnd + nAvail;
+        return nAvail;
+    }
+
+    void Commit(unsigned nCount) {
+        if (!m_pWrite) {
+            return;
+        }
+        if (nCount > m_nWriteSize - m_nWriteEnd) {
+            nCount = m_nWriteSize - m_nWriteEnd;
+        }
+        m_nWriteEnd += nCount;
+    }
+
+private:
+    static int ClampInt(unsigned n) { return n > 0x7FFFFFFFu ? 0x7FFFFFFF : static_cast<int>(n); }
+
+    bool EnsureRead() {
+        if (!m_pRead && m_nReadSize != 0) {
+            m_pRead = new (std::nothrow) unsigned char[m_nReadSize];
+        }
+        return m_pRead != nullptr;
+    }
+
+    bool EnsureWrite() {
+        if (!m_pWrite && m_nWriteSize != 0) {
+            m_pWrite = new (std::nothrow) unsigned char[m_nWriteSize];
+        }
+        return m_pWrite != nullptr;
+    }
+
+    // One receive into the free tail of the read buffer.
+    bool ReceiveMore(TSocket& socket) {
+        if (m_nReadEnd == m_nReadSize) {
+            return false;
+        }
+        int nGot = socket.Receive(m_pRead + m_nReadEnd, ClampInt(m_nReadSize - m_nReadEnd));
+        if (nGot <= 0) {
+            return false;
+        }
+        m_nReadEnd += static_cast<unsigned>(nGot);
+        return true;
+    }
+
+    unsigned char* m_pRead = nullptr;
+    unsigned m_nReadSize = 0;
+    unsigned m_nReadPos = 0;      // next unread byte
+    unsigned m_nReadEnd = 0;      // end of received data
+    unsigned char* m_pWrite = nullptr;
+    unsigned m_nWriteSize = 0;
+    unsigned m_nWriteStart = 0;   // first unsent byte
+    unsigned m_nWriteEnd = 0;     // end of committed data
+};
+
+} // namespace openmfc_sockfile
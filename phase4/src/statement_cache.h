@@ -0,0 +1,99 @@
+#pragma once
+
+// Least-recently-used cache of prepared statements behind
+// CDatabase::ExecuteSQL and ExecuteSQLBatch.
+//
+// Statements are keyed on their SQL text. Whoever runs a statement checks
+// it out and checks it back in afterwards, so a statement is never handed
+// to two users at once. Idle statements are kept most recently used first,
+// and the oldest are freed once there are more than the idle limit. The
+// limit starts at 0, which keeps nothing: the cache is opt-in
+// (CDatabase::SetStatementCacheSize, kSuggestedMaxIdle).
+//
+// The cache makes no driver calls itself: CheckIn returns false for a
+// statement it will not keep and the caller frees it, and Trim frees the
+// statements it drops through a functor void free(THandle).
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace openmfc_stmtcache {
+
+template <class THandle, class TKey = std::wstring>
+class StatementCache {
+public:
+    static const size_t kSuggestedMaxIdle = 16;
+
+    // An idle statement for key, now checked out, or THandle() on a miss.
+    THandle Take(const TKey& key) {
+        auto it = m_index.find(key);
+        if (it == m_index.end()) {
+            ++m_nMisses;
+            return THandle();
+        }
+        THandle handle = it->second->second;
+        m_idle.erase(it->second);
+        m_index.erase(it);
+        m_checkedOut.insert(handle);
+        ++m_nHits;
+        return handle;
+    }
+
+    // Records a statement prepared after a miss as checked out.
+    void Adopt(THandle handle) { m_checkedOut.insert(handle); }
+
+    // Takes a checked-out statement back as the most recently used. False
+    // if the cache did not hand it out, is turned off, or already holds an
+    // idle statement for key; the caller frees it then.
+    template <class TFree>
+    bool CheckIn(const TKey& key, THandle handle, TFree&& free) {
+        if (m_checkedOut.erase(handle) == 0 || m_nMaxIdle == 0 || m_index.count(key) != 0) {
+            return false;
+        }
+        m_idle.emplace_front(key, handle);
+        m_index[key] = m_idle.begin();
+        Trim(m_nMaxIdle, free);
+        return true;
+    }
+
+    // Frees the least recently used idle statements down to nKeep.
+    template <class TFree>
+    void Trim(size_t nKeep, TFree&& free) {
+        while (m_idle.size() > nKeep) {
+            free(m_idle.back().second);
+            m_index.erase(m_idle.back().first);
+            m_idle.pop_back();
+        }
+    }
+
+    // The connection is going away and takes the checked-out statements
+    // with it; they are no longer ours to take back.
+    void ForgetCheckedOut() { m_checkedOut.clear(); }
+
+    template <class TFree>
+    void SetMaxIdle(size_t nMaxIdle, TFree&& free) {
+        m_nMaxIdle = nMaxIdle;
+        Trim(m_nMaxIdle, free);
+    }
+
+    size_t GetMaxIdle() const { return m_nMaxIdle; }
+    size_t GetIdleCount() const { return m_idle.size(); }
+    unsigned long GetHits() const { return m_nHits; }
+    unsigned long GetMisses() const { return m_nMisses; }
+
+private:
+    typedef std::list<std::pair<TKey, THandle>> IdleList;
+
+    IdleList m_idle;   // most recently used first
+    std::unordered_map<TKey, typename IdleList::iterator> m_index;
+    std::unordered_set<THandle> m_checkedOut;
+    size_t m_nMaxIdle = 0;
+    unsigned long m_nHits = 0;
+    unsigned long m_nMisses = 0;
+};
+
+} // namespace openmfc_stmtcache
@@ -159,27 +159,157 @@ BOOL CCriticalSection::Lock() {
     return TRUE;
 }
 
+// Timed waits park on WaitOnAddress instead of polling. CRITICAL_SECTION
+// keeps its layout, so the wait words live in a small striped table keyed by
+// the object's address: Unlock() leaves the section and, if anyone is parked
+// on its stripe, bumps the stripe's generation and wakes the stripe.
+// WaitOnAddress is Windows 8+; without it the wait falls back to Sleep(1).
+//
+// Only this Unlock() wakes the stripe. Retail-built callers inline Unlock as
+// LeaveCriticalSection, and code can leave m_sect directly, so a park never
+// lasts longer than kTimedLockSliceMs: a release nobody announced is still
+// noticed within one slice.
+//
+// Most processes never time out a CCriticalSection, so Unlock() first reads
+// g_nTimedWaiterSeen with a plain load and skips the barrier and the stripe
+// entirely while it is zero. A timed Lock() sets it (with an interlocked
+// exchange) before it first registers on a stripe and it is never cleared.
+// That is enough: the waiter's exchange precedes its failed TryEnter, which
+// precedes the holder's LeaveCriticalSection on the same lock word, and the
+// holder reads the flag after the leave.
+namespace {
+
+volatile LONG g_nTimedWaiterSeen = 0;
+
+struct TimedLockStripe {
+    volatile LONG nWaiters;
+    volatile LONG nGeneration;
+    char pad[64 - 2 * sizeof(LONG)];
+};
+
+const size_t kTimedLockStripes = 64;
+const DWORD kTimedLockSliceMs = 2;
+TimedLockStripe g_timedLockStripes[kTimedLockStripes];
+
+TimedLockStripe& TimedLockStripeFor(const void* p) {
+    ULONG_PTR h = reinterpret_cast<ULONG_PTR>(p);
+    h ^= h >> 6;
+    h ^= h >> 12;
+    return g_timedLockStripes[h % kTimedLockStripes];
+}
+
+using WaitOnAddressFn = BOOL (WINAPI *)(volatile VOID*, PVOID, SIZE_T, DWORD);
+using WakeByAddressAllFn = VOID (WINAPI *)(PVOID);
+
+struct AddressWaitApi {
+    WaitOnAddressFn pfnWait;
+    WakeByAddressAllFn pfnWakeAll;
+
+    // kernelbase.dll exports both on Windows 8+ and is always mapped, so
+    // this never loads a library (and never takes the loader lock for it).
+    AddressWaitApi() : pfnWait(nullptr), pfnWakeAll(nullptr) {
+        HMODULE hSynch = ::GetModuleHandleW(L"kernelbase.dll");
+        if (hSynch) {
+            pfnWait = reinterpret_cast<WaitOnAddressFn>(::GetProcAddress(hSynch, "WaitOnAddress"));
+            pfnWakeAll = reinterpret_cast<WakeByAddressAllFn>(::GetProcAddress(hSynch, "WakeByAddressAll"));
+        }
+        if (!pfnWait || !pfnWakeAll) {
+            pfnWait = nullptr;
+            pfnWakeAll = nullptr;
+        }
+    }
+};
+
+const AddressWaitApi& GetAddressWaitApi() {
+    static const AddressWaitApi api;
+    return api;
+}
+
+} // namespace
+
 BOOL CCriticalSection::Lock(DWORD dwTimeout) {
     if (dwTimeout == INFINITE) {
         ::EnterCriticalSection(&m_sect);
         return TRUE;
     }
-    // TryEnterCriticalSection with timeout simulation
-    DWORD dwStart = ::GetTickCount();
-    while (!::TryEnterCriticalSection(&m_sect)) {
-        if (::GetTickCount() - dwStart >= dwTimeout) {
+
+    // Spin first, for as long as the section's spin count allows (the low 24
+    // bits; the rest are RTL flags). SetSpinCount tunes this.
+    const DWORD dwSpin = static_cast<DWORD>(m_sect.SpinCount & 0x00FFFFFF);
+    for (DWORD i = 0;; ++i) {
+        if (::TryEnterCriticalSection(&m_sect)) {
+            return TRUE;
+        }
+        if (i >= dwSpin) {
+            break;
+        }
+        YieldProcessor();
+    }
+    if (dwTimeout == 0) {
+        return FALSE;
+    }
+
+    if (g_nTimedWaiterSeen == 0) {
+        ::InterlockedExchange(&g_nTimedWaiterSeen, 1);
+    }
+    const AddressWaitApi& api = GetAddressWaitApi();
+    TimedLockStripe& stripe = TimedLockStripeFor(this);
+    const ULONGLONG ullDeadline = ::GetTickCount64() + dwTimeout;
+    for (;;) {
+        // Register before sampling the generation and retrying, so an
+        // Unlock() that slips in after the retry sees us and bumps it.
+        ::InterlockedIncrement(&stripe.nWaiters);
+        LONG nObserved = ::InterlockedCompareExchange(&stripe.nGeneration, 0, 0);
+        BOOL bEntered = ::TryEnterCriticalSection(&m_sect);
+        ULONGLONG ullNow = ::GetTickCount64();
+        if (!bEntered && ullNow < ullDeadline) {
+            const ULONGLONG ullLeft = ullDeadline - ullNow;
+            const DWORD dwWait = ullLeft < kTimedLockSliceMs ? static_cast<DWORD>(ullLeft) : kTimedLockSliceMs;
+            if (api.pfnWait) {
+                api.pfnWait(&stripe.nGeneration, &nObserved, sizeof(LONG), dwWait);
+            } else {
+                ::Sleep(1);
+            }
+        }
+        ::InterlockedDecrement(&stripe.nWaiters);
+        if (bEntered || ::TryEnterCriticalSection(&m_sect)) {
+            return TRUE;
+        }
+        if (::GetTickCount64() >= ullDeadline) {
             return FALSE;
         }
-        ::Sleep(1);
     }
-    return TRUE;
 }
 
 BOOL CCriticalSection::Unlock() {
     ::LeaveCriticalSection(&m_sect);
+    if (g_nTimedWaiterSeen == 0) {
+        return TRUE;
+    }
+    TimedLockStripe& stripe = TimedLockStripeFor(this);
+    MemoryBarrier();    // the leave must be visible before nWaiters is read
+    if (stripe.nWaiters != 0) {
+        ::InterlockedIncrement(&stripe.nGeneration);
+        const AddressWaitApi& api = GetAddressWaitApi();
+        if (api.pfnWakeAll) {
+            api.pfnWakeAll(const_cast<LONG*>(&stripe.nGeneration));
+        }
+    }
     return TRUE;
 }
 
+DWORD CCriticalSection::SetSpinCount(DWORD dwSpinCount) {
+    return ::SetCriticalSectionSpinCount(&m_sect, dwSpinCount);
+}
+
+// OpenMFC extension, not in the MFC ordinal map: build_phase4.sh adds it to
+// the .def file.
+// Symbol: ?SetSpinCount@CCriticalSection@@QEAAKK@Z
+extern "C" DWORD MS_ABI
+impl__SetSpinCount_CCriticalSection__QEAAKK_Z(CCriticalSection* pThis, DWORD dwSpinCount) {
+    return pThis->SetSpinCount(dwSpinCount);
+}
+
 //=============================================================================
 // CMutex implementation
 //=============================================================================
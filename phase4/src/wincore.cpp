@@ -33,84 +33,70 @@ extern "C" int MS_ABI impl__PreCreateWindow_CFrameWnd__MEAAHAEAUtagCREATESTRUCTW
 
 // Map HWND to CWnd* for message routing
 #include <map>
-#include <set>
 #include <vector>
-static std::map<HWND, CWnd*> g_hwndMap;
-static std::map<const CWnd*, COleControlContainer*> g_controlContainerMap;
+#include "handle_table.h"
+
+namespace {
+struct CWndHandleTraits {
+    static void Attach(CWnd* pWnd, HWND hWnd) { pWnd->m_hWnd = hWnd; }
+    // Clear before destruction so the wrapper never tries to detach itself.
+    static void Detach(CWnd* pWnd) { pWnd->m_hWnd = nullptr; }
+};
+typedef openmfc::handle_table::HandleTable<HWND, CWnd, CWndHandleTraits> CWndHandleTable;
+} // namespace
 
-// Track temporary CWnd wrappers allocated by OpenMfcAttachCWnd
-// These need to be deleted when the underlying window is destroyed
-static std::set<CWnd*> g_tempWrappers;
+// One table per thread, as MFC keeps its CHandleMap in AFX_MODULE_THREAD_STATE:
+// a window is only routed on the thread that created it, so no lock is taken.
+static thread_local CWndHandleTable g_hwndMap;
+static std::map<const CWnd*, COleControlContainer*> g_controlContainerMap;
 
 // Helper to reuse/attach CWnd wrappers for existing HWNDs.
 CWnd* OpenMfcLookupCWnd(HWND hWnd) {
-    if (!hWnd) {
-        return nullptr;
-    }
-    auto it = g_hwndMap.find(hWnd);
-    if (it != g_hwndMap.end()) {
-        return it->second;
-    }
-    return nullptr;
+    return g_hwndMap.Lookup(hWnd);
 }
 
 // Detach and optionally delete a CWnd wrapper when window is destroyed
 // Called from AfxWndProc on WM_NCDESTROY (the final cleanup message)
 void OpenMfcDetachCWnd(HWND hWnd) {
-    auto it = g_hwndMap.find(hWnd);
-    if (it != g_hwndMap.end()) {
-        CWnd* pWnd = it->second;
-        g_hwndMap.erase(it);
-
-        auto ccIt = g_controlContainerMap.find(pWnd);
-        if (ccIt != g_controlContainerMap.end()) {
-            delete ccIt->second;
-            g_controlContainerMap.erase(ccIt);
-        }
+    bool bTemporary = false;
+    CWnd* pWnd = g_hwndMap.Remove(hWnd, &bTemporary);
+    if (!pWnd) {
+        return;
+    }
 
-        // Delete if this was a temporary wrapper allocated by OpenMfcAttachCWnd
-        auto tempIt = g_tempWrappers.find(pWnd);
-        if (tempIt != g_tempWrappers.end()) {
-            g_tempWrappers.erase(tempIt);
-            pWnd->m_hWnd = nullptr;  // Clear before delete to prevent double-detach
-            delete pWnd;
-        }
+    auto ccIt = g_controlContainerMap.find(pWnd);
+    if (ccIt != g_controlContainerMap.end()) {
+        delete ccIt->second;
+        g_controlContainerMap.erase(ccIt);
     }
-}
 
-CWnd* OpenMfcAttachCWnd(HWND hWnd) {
-    if (!hWnd) {
-        return nullptr;
+    // Temporary wrappers created by OpenMfcAttachCWnd go back to the pool
+    if (bTemporary) {
+        g_hwndMap.ReleaseTemporary(pWnd);
     }
-    if (CWnd* existing = OpenMfcLookupCWnd(hWnd)) {
-        return existing;
+}
+
+// Unmaps hWnd from inside a member call on its wrapper; a temporary wrapper
+// is only freed at the next idle pass, since `this` is still in use.
+static void OpenMfcForgetCWnd(HWND hWnd) {
+    bool bTemporary = false;
+    CWnd* pWnd = g_hwndMap.Remove(hWnd, &bTemporary);
+    if (pWnd && bTemporary) {
+        g_hwndMap.RetireTemporary(pWnd);
     }
+}
 
-    // Create a temporary wrapper - tracked for cleanup on window destruction
-    CWnd* wrapper = new CWnd();
-    wrapper->m_hWnd = hWnd;
-    g_hwndMap[hWnd] = wrapper;
-    g_tempWrappers.insert(wrapper);  // Track for deletion
-    return wrapper;
+CWnd* OpenMfcAttachCWnd(HWND hWnd) {
+    // Creates a temporary wrapper on first use; the table owns and recycles it
+    return g_hwndMap.FromHandle(hWnd);
 }
 
 // Cleanup stale temporary wrappers for destroyed windows
 // Called during idle processing to handle windows not using our window procedure
-// (e.g., dialog controls obtained via GetDlgItem)
+// (e.g., dialog controls obtained via GetDlgItem). Only temporaries that were
+// not handed out since the previous idle pass are checked against the OS.
 void OpenMfcCleanupTempWrappers() {
-    // Build list of stale entries (can't modify map while iterating)
-    std::vector<HWND> staleHandles;
-    for (auto& pair : g_hwndMap) {
-        // Check if the window still exists
-        if (!::IsWindow(pair.first)) {
-            staleHandles.push_back(pair.first);
-        }
-    }
-
-    // Clean up stale entries
-    for (HWND hWnd : staleHandles) {
-        OpenMfcDetachCWnd(hWnd);
-    }
+    g_hwndMap.CollectTemporaries([](HWND hWnd) { return ::IsWindow(hWnd) != FALSE; });
 }
 
 // Global app pointer (defined in appcore.cpp)
@@ -119,6 +105,8 @@ extern CWinThread* AfxGetThread();
 // Returns nonzero when the message was handled and writes the result to pResult.
 extern "C" int MS_ABI impl__OnWndMsg_CWnd__MEAAHI_K_JPEA_J_Z(
     CWnd* pThis, UINT message, WPARAM wParam, LPARAM lParam, LRESULT* pResult);
+// Per-thread message-map cache (global_afx_msgcache.cpp)
+extern const AFX_MSGMAP_ENTRY* OpenMfcLookupMessageEntry(const AFX_MSGMAP* pMap, UINT nMsg, UINT nCode, UINT nID);
 
 // OpenMFC window class name
 static const wchar_t* g_szOpenMFCClass = L"OpenMFC_Window";
@@ -279,7 +267,7 @@ extern "C" int MS_ABI impl__Create_CWnd__UEAAHPEB_W0KAEBUtagRECT__PEAV1_IPEAUCCr
     }
 
     pThis->m_hWnd = hWnd;
-    g_hwndMap[hWnd] = pThis;
+    g_hwndMap.SetPermanent(hWnd, pThis);
 
     return TRUE;
 }
@@ -343,7 +331,7 @@ extern "C" int MS_ABI impl__CreateEx_CWnd__UEAAHKPEB_W0KHHHHPEAUHWND____PEAUHMEN
     }
 
     pThis->m_hWnd = hWnd;
-    g_hwndMap[hWnd] = pThis;
+    g_hwndMap.SetPermanent(hWnd, pThis);
     return TRUE;
 }
 
@@ -414,7 +402,7 @@ extern "C" int MS_ABI impl__DestroyWindow_CWnd__UEAAHXZ(CWnd* pThis) {
     }
 
     HWND hWnd = pThis->m_hWnd;
-    g_hwndMap.erase(hWnd);
+    OpenMfcForgetCWnd(hWnd);
     pThis->m_hWnd = nullptr;
 
     return ::DestroyWindow(hWnd);
@@ -557,7 +545,7 @@ extern "C" CFrameWnd* MS_ABI impl___0CFrameWnd__QEAA_XZ(CFrameWnd* pThis) {
 // Ordinal: 1129
 extern "C" void MS_ABI impl___1CFrameWnd__UEAA_XZ(CFrameWnd* pThis) {
     if (pThis && pThis->m_hWnd) {
-        g_hwndMap.erase(pThis->m_hWnd);
+        OpenMfcForgetCWnd(pThis->m_hWnd);
         ::DestroyWindow(pThis->m_hWnd);
         pThis->m_hWnd = nullptr;
     }
@@ -651,7 +639,7 @@ extern "C" int MS_ABI impl__Create_CFrameWnd__UEAAHPEB_W0KAEBUtagRECT__PEAVCWnd_
     }
 
     pThis->m_hWnd = hWnd;
-    g_hwndMap[hWnd] = pThis;
+    g_hwndMap.SetPermanent(hWnd, pThis);
 
     return TRUE;
 }
@@ -793,14 +781,11 @@ static LRESULT CALLBACK AfxWndProc(HWND hWnd, UINT message, WPARAM wParam, LPARA
         pWnd = reinterpret_cast<CWnd*>(pCreate->lpCreateParams);
         if (pWnd) {
             pWnd->m_hWnd = hWnd;
-            g_hwndMap[hWnd] = pWnd;
+            g_hwndMap.SetPermanent(hWnd, pWnd);
         }
     } else {
         // Look up CWnd from HWND
-        auto it = g_hwndMap.find(hWnd);
-        if (it != g_hwndMap.end()) {
-            pWnd = it->second;
-        }
+        pWnd = g_hwndMap.Lookup(hWnd);
     }
 
     // Route to CWnd::WindowProc if we have a CWnd
@@ -1035,7 +1020,7 @@ int CMDIChildWnd::Create(const wchar_t* lpszClassName, const wchar_t* lpszWindow
     m_hWnd = (HWND)::SendMessageW(pParentWnd->m_hWndMDIClient, WM_MDICREATE, 0, (LPARAM)&mcs);
 
     if (m_hWnd) {
-        g_hwndMap[m_hWnd] = this;
+        g_hwndMap.SetPermanent(m_hWnd, this);
         return TRUE;
     }
 
@@ -1093,8 +1078,7 @@ void* CWnd::FromHandlePermanent(HWND p0)
 
 // Symbol: ?FromHandlePermanent@CWnd@@SAPEAV1@PEAUHWND__@@@Z
 extern "C" CWnd* MS_ABI impl__FromHandlePermanent_CWnd__SAPEAV1_PEAUHWND_____Z(HWND hWnd) {
-    auto it = g_hwndMap.find(hWnd);
-    return it != g_hwndMap.end() ? it->second : nullptr;
+    return g_hwndMap.Lookup(hWnd);
 }
 
 const MSG* CWnd::GetCurrentMessage()
@@ -2493,6 +2477,107 @@ extern "C" int MS_ABI impl__OnNotify_CWnd__MEAAH_K_JPEA_J_Z(
     return FALSE;
 }
 
+namespace {
+// GetMessageMap is protected (DECLARE_MESSAGE_MAP); naming it through a
+// derived class yields a CCmdTarget member pointer that still dispatches
+// virtually to the most-derived map.
+struct CmdTargetMessageMapAccess : CCmdTarget {
+    static const AFX_MSGMAP* Of(const CCmdTarget* pTarget) {
+        return (pTarget->*&CmdTargetMessageMapAccess::GetMessageMap)();
+    }
+};
+
+// Only objects whose vtable lies inside this DLL have the slot order our
+// virtual calls assume; a client's MSVC-compiled CWnd is only safe at
+// vtable[0] (see cobject_impl.cpp), so its map cannot be fetched from here.
+bool HasNativeVtable(const void* pObject) {
+    static const std::pair<uintptr_t, uintptr_t> s_image = [] {
+        HMODULE hModule = nullptr;
+        if (!::GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                                  reinterpret_cast<LPCWSTR>(&HasNativeVtable), &hModule) || !hModule) {
+            return std::pair<uintptr_t, uintptr_t>(0, 0);
+        }
+        uintptr_t base = reinterpret_cast<uintptr_t>(hModule);
+        const IMAGE_DOS_HEADER* pDos = reinterpret_cast<const IMAGE_DOS_HEADER*>(base);
+        const IMAGE_NT_HEADERS* pNt = reinterpret_cast<const IMAGE_NT_HEADERS*>(base + pDos->e_lfanew);
+        return std::pair<uintptr_t, uintptr_t>(base, base + pNt->OptionalHeader.SizeOfImage);
+    }();
+    uintptr_t vptr = *static_cast<const uintptr_t*>(pObject);
+    return vptr >= s_image.first && vptr < s_image.second;
+}
+
+// Calls a window-message handler found in a message map. Returns FALSE for
+// signatures that do not describe a window message, so the caller falls back
+// to DefWindowProc.
+int DispatchWndMsg(CWnd* pWnd, const AFX_MSGMAP_ENTRY* lpEntry, WPARAM wParam, LPARAM lParam, LRESULT* pResult) {
+    typedef void (CCmdTarget::*AFX_PMSG_v)();
+    typedef int (CCmdTarget::*AFX_PMSG_b)();
+    typedef void (CCmdTarget::*AFX_PMSG_vw)(UINT);
+    typedef void (CCmdTarget::*AFX_PMSG_vww)(UINT, UINT);
+    typedef void (CCmdTarget::*AFX_PMSG_vwl)(UINT, LONG);
+    typedef LRESULT (CCmdTarget::*AFX_PMSG_lwl)(WPARAM, LPARAM);
+    typedef void (CCmdTarget::*AFX_PMSG_vb)(BOOL);
+    typedef int (CCmdTarget::*AFX_PMSG_iw)(UINT);
+    typedef int (CCmdTarget::*AFX_PMSG_iww)(UINT, UINT);
+
+    union MessageMapFunctions {
+        AFX_PMSG pfn;
+        AFX_PMSG_v pfn_v;
+        AFX_PMSG_b pfn_b;
+        AFX_PMSG_vw pfn_vw;
+        AFX_PMSG_vww pfn_vww;
+        AFX_PMSG_vwl pfn_vwl;
+        AFX_PMSG_lwl pfn_lwl;
+        AFX_PMSG_vb pfn_vb;
+        AFX_PMSG_iw pfn_iw;
+        AFX_PMSG_iww pfn_iww;
+    };
+
+    MessageMapFunctions mmf;
+    mmf.pfn = lpEntry->pfn;
+    CCmdTarget* pTarget = pWnd;
+    LRESULT lResult = 0;
+
+    switch (lpEntry->nSig) {
+    case AfxSig_vv:
+    case AfxSig_vv_i:
+        (pTarget->*mmf.pfn_v)();
+        break;
+    case AfxSig_bv:
+        lResult = (pTarget->*mmf.pfn_b)();
+        break;
+    case AfxSig_vw:
+        (pTarget->*mmf.pfn_vw)(static_cast<UINT>(wParam));
+        break;
+    case AfxSig_vww:
+        (pTarget->*mmf.pfn_vww)(static_cast<UINT>(wParam), static_cast<UINT>(lParam));
+        break;
+    case AfxSig_vwl:
+        (pTarget->*mmf.pfn_vwl)(static_cast<UINT>(wParam), static_cast<LONG>(lParam));
+        break;
+    case AfxSig_lwl:
+        lResult = (pTarget->*mmf.pfn_lwl)(wParam, lParam);
+        break;
+    case AfxSig_v_b:
+    case AfxSig_vb:
+        (pTarget->*mmf.pfn_vb)(static_cast<BOOL>(wParam));
+        break;
+    case AfxSig_iw:
+        lResult = (pTarget->*mmf.pfn_iw)(static_cast<UINT>(wParam));
+        break;
+    case AfxSig_iww:
+        lResult = (pTarget->*mmf.pfn_iww)(static_cast<UINT>(wParam), static_cast<UINT>(lParam));
+        break;
+    default:
+        return FALSE;
+    }
+    if (pResult) {
+        *pResult = lResult;
+    }
+    return TRUE;
+}
+} // namespace
+
 // Symbol: ?OnWndMsg@CWnd@@MEAAHI_K_JPEA_J@Z
 extern "C" int MS_ABI impl__OnWndMsg_CWnd__MEAAHI_K_JPEA_J_Z(
     CWnd* pThis, UINT message, WPARAM wParam, LPARAM lParam, LRESULT* pResult) {
@@ -2505,8 +2590,19 @@ extern "C" int MS_ABI impl__OnWndMsg_CWnd__MEAAHI_K_JPEA_J_Z(
     case WM_NOTIFY:
         return impl__OnNotify_CWnd__MEAAH_K_JPEA_J_Z(pThis, wParam, lParam, pResult);
     default:
+        break;
+    }
+    if (!pThis || !HasNativeVtable(pThis)) {
+        return FALSE;
+    }
+
+    // Window-message entries are keyed with code and id 0, as in MFC.
+    const AFX_MSGMAP_ENTRY* lpEntry =
+        OpenMfcLookupMessageEntry(CmdTargetMessageMapAccess::Of(pThis), message, 0, 0);
+    if (lpEntry == nullptr) {
         return FALSE;
     }
+    return DispatchWndMsg(pThis, lpEntry, wParam, lParam, pResult);
 }
 
 LONGLONG CWnd::SendDlgItemMessageW(int p0, UINT p1, ULONGLONG p2, LONGLONG p3)
@@ -0,0 +1,208 @@
+// Benchmark + correctness check for cached class ancestry
+// (phase4/src/class_ancestry.h, behind CRuntimeClass::IsDerivedFrom and
+// CObject::IsKindOf in cobject_impl.cpp).
+//
+// IsDerivedFrom used to follow m_pfnGetBaseClass / m_pBaseClass one level
+// at a time on every check. The cache keeps each class's depth and
+// ancestor list in a side table, so a check is two table probes and a
+// compare whatever the depth; checks settled within kWalkDepth levels are
+// still walked, which skips the table's shared reader count.
+//
+// The classes below mirror CRuntimeClass: a base-class accessor called
+// through a function pointer (as for classes linked from a DLL) and a
+// plain m_pBaseClass. The bench times IsKindOf-style checks of a leaf
+// against its root (the worst case for the walk) and against an unrelated
+// class for hierarchies 2 to 12 deep, then checks invalidation (including
+// against concurrent checks, and that retired records are freed) and the
+// fallback for chains the cache will not hold.
+//
+// Build:
+//   g++ -O2 -std=c++17 -pthread tests/bench_class_ancestry.cpp -o /tmp/bench_class_ancestry
+//   /tmp/bench_class_ancestry
+// or, for the Windows toolchain:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static tests/bench_class_ancestry.cpp -o /tmp/bench_class_ancestry.exe
+//   WINEDEBUG=-all wine /tmp/bench_class_ancestry.exe
+
+#include "../phase4/src/class_ancestry.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+static int g_fail = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond)
+        g_fail = 1;
+}
+
+struct RuntimeClass {
+    RuntimeClass* (*m_pfnGetBaseClass)();
+    RuntimeClass* m_pBaseClass;
+};
+
+static const RuntimeClass* GetBase(const RuntimeClass* p) {
+    return p->m_pfnGetBaseClass ? p->m_pfnGetBaseClass() : p->m_pBaseClass;
+}
+
+typedef openmfc_ancestry::AncestryCache<RuntimeClass> Cache;
+
+// A chain of 13 classes whose accessors are real functions, so the walk
+// pays an indirect call per level as DLL-linked classes do.
+static RuntimeClass g_chain[13];
+template <int N>
+static RuntimeClass* GetChainBase() { return &g_chain[N - 1]; }
+typedef RuntimeClass* (*PFNBASE)();
+static const PFNBASE g_pfnChainBase[13] = {
+    nullptr, GetChainBase<1>, GetChainBase<2>, GetChainBase<3>, GetChainBase<4>,
+    GetChainBase<5>, GetChainBase<6>, GetChainBase<7>, GetChainBase<8>, GetChainBase<9>,
+    GetChainBase<10>, GetChainBase<11>, GetChainBase<12>,
+};
+static RuntimeClass g_unrelated{ nullptr, nullptr };
+
+__attribute__((noinline)) static bool WalkIsDerivedFrom(const RuntimeClass* p, const RuntimeClass* pBase) {
+    for (; p; p = GetBase(p)) {
+        if (p == pBase)
+            return true;
+    }
+    return false;
+}
+
+__attribute__((noinline)) static bool CachedIsDerivedFrom(Cache& cache, const RuntimeClass* p, const RuntimeClass* pBase) {
+    openmfc_ancestry::CheckResult r = cache.Check(p, pBase);
+    return r == openmfc_ancestry::kUncacheable ? WalkIsDerivedFrom(p, pBase) : r == openmfc_ancestry::kDerived;
+}
+
+static double NsPerCheck(std::chrono::steady_clock::time_point start, size_t n) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / n;
+}
+
+static void CheckSemantics() {
+    Cache cache(GetBase);
+    check("a class derives from itself", cache.Check(&g_chain[5], &g_chain[5]) == openmfc_ancestry::kDerived);
+    check("leaf derives from every ancestor", [&] {
+        for (int i = 0; i <= 12; ++i)
+            if (cache.Check(&g_chain[12], &g_chain[i]) != openmfc_ancestry::kDerived)
+                return false;
+        return true;
+    }());
+    check("base does not derive from its subclass", cache.Check(&g_chain[3], &g_chain[4]) == openmfc_ancestry::kNotDerived);
+    check("unrelated root is not an ancestor", cache.Check(&g_chain[12], &g_unrelated) == openmfc_ancestry::kNotDerived);
+
+    // A class whose base changes, as when a module is unloaded and a new
+    // class is registered at the same address. Both hierarchies are deeper
+    // than the walk, so the answers come from the table.
+    RuntimeClass other[8];
+    other[0] = RuntimeClass{ nullptr, nullptr };
+    for (int i = 1; i < 8; ++i)
+        other[i] = RuntimeClass{ nullptr, &other[i - 1] };
+    RuntimeClass reused{ nullptr, &g_chain[12] };
+    check("cached answer before the address is reused", cache.Check(&reused, &g_chain[2]) == openmfc_ancestry::kDerived);
+    reused.m_pBaseClass = &other[7];
+    cache.Invalidate();
+    check("invalidation rebuilds the record",
+          cache.Check(&reused, &g_chain[2]) == openmfc_ancestry::kNotDerived &&
+          cache.Check(&reused, &other[0]) == openmfc_ancestry::kDerived);
+    cache.Invalidate();
+    check("invalidation with no check in flight frees the records", cache.GetRetiredCount() == 0);
+
+    RuntimeClass a{ nullptr, nullptr }, b{ nullptr, &a };
+    a.m_pBaseClass = &b;
+    check("cyclic chains are reported uncacheable", cache.Check(&a, &g_unrelated) == openmfc_ancestry::kUncacheable);
+
+    std::vector<RuntimeClass> deep(Cache::kMaxDepth + 2);
+    for (size_t i = 1; i < deep.size(); ++i)
+        deep[i] = RuntimeClass{ nullptr, &deep[i - 1] };
+    deep[0] = RuntimeClass{ nullptr, nullptr };
+    check("chains past kMaxDepth fall back to the walk",
+          cache.Check(&deep.back(), &deep[0]) == openmfc_ancestry::kUncacheable &&
+          CachedIsDerivedFrom(cache, &deep.back(), &deep[0]));
+
+    // Many classes from several threads at once, forcing table growth.
+    std::vector<RuntimeClass> wide(20000);
+    for (RuntimeClass& c : wide)
+        c = RuntimeClass{ nullptr, &g_chain[12] };
+    bool bOk[4] = {};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            bool ok = true;
+            for (size_t i = t; i < wide.size(); i += 2)
+                ok = ok && cache.Check(&wide[i], &g_chain[1]) == openmfc_ancestry::kDerived &&
+                     cache.Check(&wide[i], &g_unrelated) == openmfc_ancestry::kNotDerived;
+            bOk[t] = ok;
+        });
+    }
+    for (std::thread& th : threads)
+        th.join();
+    check("concurrent first use from 4 threads", bOk[0] && bOk[1] && bOk[2] && bOk[3]);
+    check("grown tables are freed once the threads are done",
+          (cache.Check(&g_chain[11], &g_chain[1]), cache.GetRetiredCount() == 0));
+
+    // Checks racing with invalidation, as when AfxTermExtensionModule runs
+    // while other threads call IsKindOf. Retired memory must not pile up.
+    std::atomic<bool> bStop{ false };
+    bool bRaceOk[4] = {};
+    threads.clear();
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            bool ok = true;
+            for (size_t i = t; !bStop.load(std::memory_order_relaxed); i = (i + 4) % wide.size())
+                ok = ok && CachedIsDerivedFrom(cache, &wide[i], &g_chain[1]) &&
+                     !CachedIsDerivedFrom(cache, &wide[i], &g_unrelated);
+            bRaceOk[t] = ok;
+        });
+    }
+    size_t nMaxRetired = 0;
+    for (int i = 0; i < 2000; ++i) {
+        cache.Invalidate();
+        const size_t nRetired = cache.GetRetiredCount();
+        nMaxRetired = nRetired > nMaxRetired ? nRetired : nMaxRetired;
+        std::this_thread::yield();
+    }
+    bStop.store(true);
+    for (std::thread& th : threads)
+        th.join();
+    check("checks racing with invalidation stay correct", bRaceOk[0] && bRaceOk[1] && bRaceOk[2] && bRaceOk[3]);
+    cache.Invalidate();
+    check("retired memory is freed after the race", cache.GetRetiredCount() == 0);
+    std::printf("most retired blocks held during the race: %zu\n", nMaxRetired);
+}
+
+int main() {
+    g_chain[0] = RuntimeClass{ nullptr, nullptr };
+    for (int i = 1; i <= 12; ++i)
+        g_chain[i] = RuntimeClass{ g_pfnChainBase[i], nullptr };
+
+    CheckSemantics();
+
+    const size_t kChecks = 20000000;
+    Cache cache(GetBase);
+    std::printf("\nIsKindOf, ns per check   leaf vs root          leaf vs unrelated\n");
+    std::printf("depth                    walk     cached       walk     cached\n");
+    for (int depth = 2; depth <= 12; depth += 2) {
+        const RuntimeClass* pLeaf = &g_chain[depth];
+        double ns[4];
+        size_t nHits = 0;
+        const RuntimeClass* targets[2] = { &g_chain[0], &g_unrelated };
+        for (int t = 0; t < 2; ++t) {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < kChecks; ++i)
+                nHits += WalkIsDerivedFrom(pLeaf, targets[t]);
+            ns[t * 2] = NsPerCheck(start, kChecks);
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < kChecks; ++i)
+                nHits += CachedIsDerivedFrom(cache, pLeaf, targets[t]);
+            ns[t * 2 + 1] = NsPerCheck(start, kChecks);
+        }
+        if (nHits != 2 * kChecks)
+            g_fail = 1;
+        std::printf("%5d %20.2f %10.2f %10.2f %10.2f\n", depth, ns[0], ns[1], ns[2], ns[3]);
+    }
+
+    std::printf("\nRESULT: %s\n", g_fail ? "FAILURE" : "SUCCESS");
+    return g_fail;
+}
@@ -0,0 +1,203 @@
+// Benchmark + model check for CMap bucket growth (openmfc_maphash, afx.h).
+//
+// CMap<> and the CMapPtrToPtr / CMapStringTo* wrappers keep the bucket
+// count they were created with (17 unless InitHashTable says otherwise), as
+// in MFC, so a map holding 1e5 keys scans chains thousands of assocs long on
+// every lookup. A map that calls EnableAutoRehash instead grows once the
+// count passes the bucket count, draining the old array a few buckets per
+// insert. This times insert and lookup at 1e3 / 1e5 / 1e7 keys for:
+//   fixed    InitHashTable(19): the default behaviour
+//            (skipped at 1e7, it would take hours)
+//   presized InitHashTable(~1.25 n): the best a caller could do by hand
+//   growing  EnableAutoRehash()
+// and reports the slowest single insert of the growing map, which is what
+// draining incrementally keeps small. The model check iterates and removes
+// keys while a drain is in progress.
+//
+// Build:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -Iinclude tests/bench_cmap_rehash.cpp -o /tmp/bench_cmap_rehash.exe
+//   WINEDEBUG=-all wine /tmp/bench_cmap_rehash.exe
+#include <openmfc/afx.h>
+
+#include <chrono>
+#include <cstdio>
+#include <set>
+#include <vector>
+
+typedef CMap<void*, void*, void*, void*> PtrMap;
+
+static int g_fail = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond)
+        g_fail = 1;
+}
+
+// Scattered, pointer-shaped keys (16-byte aligned, as heap pointers are).
+static void* KeyOf(size_t i) {
+    uint64_t x = (i + 1) * 0x9E3779B97F4A7C15ull;
+    x ^= x >> 29;
+    return reinterpret_cast<void*>(static_cast<uintptr_t>(x << 4));
+}
+
+static double NsSince(std::chrono::steady_clock::time_point start, size_t n) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / n;
+}
+
+struct Timing {
+    double insertNs;
+    double lookupNs;
+};
+
+static Timing Run(PtrMap& map, size_t n) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; ++i)
+        map[KeyOf(i)] = reinterpret_cast<void*>(i);
+    Timing t;
+    t.insertNs = NsSince(start, n);
+
+    size_t hits = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; ++i) {
+        void* value = nullptr;
+        hits += map.Lookup(KeyOf((i * 7919) % n), value) ? 1 : 0;
+    }
+    t.lookupNs = NsSince(start, n);
+    if (hits != n || static_cast<size_t>(map.GetCount()) != n)
+        g_fail = 1;
+    return t;
+}
+
+static double WorstInsertUs(size_t n) {
+    PtrMap map;
+    map.EnableAutoRehash();
+    double worst = 0;
+    for (size_t i = 0; i < n; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        map[KeyOf(i)] = nullptr;
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        if (us > worst)
+            worst = us;
+    }
+    return worst;
+}
+
+static void ModelCheck() {
+    // Without the opt-in the default size stays put, as in MFC.
+    PtrMap plain;
+    for (size_t i = 0; i < 1000; ++i)
+        plain[KeyOf(i)] = nullptr;
+    check("default map keeps 17 buckets", plain.GetHashTableSize() == 17 && plain.GetCount() == 1000);
+
+    // Stop right after a growth so the old array is still attached.
+    PtrMap map;
+    map.EnableAutoRehash();
+    size_t n = 0;
+    UINT nSize = map.GetHashTableSize();
+    while (map.GetHashTableSize() == nSize || n < 2000) {
+        if (map.GetHashTableSize() != nSize)
+            nSize = map.GetHashTableSize();
+        map[KeyOf(n)] = reinterpret_cast<void*>(n);
+        ++n;
+    }
+    for (int i = 0; i < 10; ++i, ++n)   // drain part of the old array
+        map[KeyOf(n)] = reinterpret_cast<void*>(n);
+    check("grew past the default size", map.GetHashTableSize() > 17);
+
+    bool allFound = true;
+    for (size_t i = 0; i < n; ++i) {
+        void* value = nullptr;
+        allFound = allFound && map.Lookup(KeyOf(i), value) && value == reinterpret_cast<void*>(i);
+    }
+    check("every key found mid-drain", allFound);
+
+    std::set<void*> seen;
+    bool noDup = true;
+    PtrMap::POSITION pos = map.GetStartPosition();
+    while (pos != PtrMap::POSITION()) {
+        void* key = nullptr;
+        void* value = nullptr;
+        map.GetNextAssoc(pos, key, value);
+        noDup = seen.insert(key).second && noDup;
+    }
+    check("iteration mid-drain visits each key once", noDup && seen.size() == n);
+
+    // Remove every other key as it is returned, MFC-style.
+    size_t visited = 0;
+    pos = map.GetStartPosition();
+    while (pos != PtrMap::POSITION()) {
+        void* key = nullptr;
+        void* value = nullptr;
+        map.GetNextAssoc(pos, key, value);
+        if ((reinterpret_cast<uintptr_t>(value) & 1) == 0)
+            map.RemoveKey(key);
+        ++visited;
+    }
+    check("remove-while-iterating visits everything", visited == n);
+    check("remove-while-iterating count", static_cast<size_t>(map.GetCount()) == n / 2);
+
+    bool oddOnly = true;
+    for (size_t i = 0; i < n; ++i) {
+        void* value = nullptr;
+        oddOnly = oddOnly && (map.Lookup(KeyOf(i), value) == ((i & 1) != 0));
+    }
+    check("survivors intact", oddOnly);
+
+    // A caller-chosen size stays put.
+    PtrMap fixed;
+    fixed.InitHashTable(19);
+    for (size_t i = 0; i < 1000; ++i)
+        fixed[KeyOf(i)] = nullptr;
+    check("InitHashTable(19) keeps its size", fixed.GetHashTableSize() == 19 && fixed.GetCount() == 1000);
+
+    // The opt-in applies to any size and survives RemoveAll / InitHashTable.
+    fixed.EnableAutoRehash();
+    for (size_t i = 1000; i < 2000; ++i)
+        fixed[KeyOf(i)] = nullptr;
+    check("opted-in InitHashTable(19) grows", fixed.GetHashTableSize() > 19);
+    fixed.RemoveAll();
+    fixed.InitHashTable(23, false);
+    for (size_t i = 0; i < 1000; ++i)
+        fixed[KeyOf(i)] = nullptr;
+    check("opt-in survives RemoveAll and InitHashTable", fixed.GetHashTableSize() > 23);
+    fixed.EnableAutoRehash(false);
+    UINT nFrozen = fixed.GetHashTableSize();
+    for (size_t i = 1000; i < 5000; ++i)
+        fixed[KeyOf(i)] = nullptr;
+    check("EnableAutoRehash(false) freezes the size", fixed.GetHashTableSize() == nFrozen && fixed.GetCount() == 5000);
+}
+
+int main() {
+    ModelCheck();
+
+    std::printf("\n%-9s %-9s %12s %12s\n", "keys", "table", "insert ns", "lookup ns");
+    const size_t sizes[] = { 1000, 100000, 10000000 };
+    for (size_t n : sizes) {
+        if (n <= 100000) {
+            PtrMap fixed;
+            fixed.InitHashTable(19);
+            Timing t = Run(fixed, n);
+            std::printf("%-9zu %-9s %12.1f %12.1f\n", n, "fixed", t.insertNs, t.lookupNs);
+        } else {
+            std::printf("%-9zu %-9s %12s %12s\n", n, "fixed", "-", "-");
+        }
+        {
+            PtrMap presized;
+            presized.InitHashTable(static_cast<UINT>(n + n / 4) | 1);
+            Timing t = Run(presized, n);
+            std::printf("%-9zu %-9s %12.1f %12.1f\n", n, "presized", t.insertNs, t.lookupNs);
+        }
+        {
+            PtrMap growing;
+            growing.EnableAutoRehash();
+            Timing t = Run(growing, n);
+            std::printf("%-9zu %-9s %12.1f %12.1f   (%u buckets)\n", n, "growing", t.insertNs, t.lookupNs,
+                        growing.GetHashTableSize());
+        }
+    }
+    std::printf("\nslowest single insert while growing to 1e6 keys: %.1f us\n", WorstInsertUs(1000000));
+
+    std::printf("RESULT: %s\n", g_fail ? "FAILURE" : "SUCCESS");
+    return g_fail;
+}
@@ -0,0 +1,226 @@
+// Correctness check + micro-benchmark for the HWND -> CWnd handle table.
+//
+// wincore.cpp used to route every message through a global
+// std::map<HWND, CWnd*> and kept temporary wrappers in a std::set, and idle
+// cleanup called IsWindow on every mapped window. handle_table.h replaces
+// that with a per-thread open-addressing table whose idle pass only visits
+// cold temporaries. This drives the real header with stand-in HWND/CWnd
+// types: it first checks the table against a std::map model under random
+// attach / detach / FromHandle / idle traffic, then times FromHandle and the
+// idle pass at 10k windows against the old structures.
+//
+// Build:
+//   g++ -O2 -std=c++17 tests/bench_handle_table.cpp -o /tmp/bench_handle_table
+//   /tmp/bench_handle_table
+// or, for the Windows toolchain:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static tests/bench_handle_table.cpp -o /tmp/bench_handle_table.exe
+//   WINEDEBUG=-all wine /tmp/bench_handle_table.exe
+
+#include "../phase4/src/handle_table.h"
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+struct HWND__ { int unused; };
+typedef HWND__* HWND;
+
+struct CWnd {
+    HWND m_hWnd = nullptr;
+    virtual ~CWnd() {}
+};
+
+struct CWndHandleTraits {
+    static void Attach(CWnd* pWnd, HWND hWnd) { pWnd->m_hWnd = hWnd; }
+    static void Detach(CWnd* pWnd) { pWnd->m_hWnd = nullptr; }
+};
+typedef openmfc::handle_table::HandleTable<HWND, CWnd, CWndHandleTraits> CWndHandleTable;
+
+static int g_failures = 0;
+
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { ++g_failures; if (g_failures <= 20) std::printf("FAIL: %s\n", msg); } \
+} while (0)
+
+// Real HWNDs are small, 2-aligned user-handle values; mimic that spread.
+static HWND MakeHwnd(size_t i) {
+    return reinterpret_cast<HWND>(static_cast<uintptr_t>(0x10000 + i * 0x22));
+}
+
+// "IsWindow" for both implementations.
+static std::unordered_set<HWND> g_liveWindows;
+static bool IsWindowStub(HWND h) { return g_liveWindows.count(h) != 0; }
+
+static void CheckAgainstModel() {
+    CWndHandleTable table;
+    std::map<HWND, CWnd*> permanent;           // model: caller-owned wrappers
+    std::set<HWND> temporary;                  // model: handles with a temp wrapper
+    std::vector<CWnd> owned(4000);
+    std::mt19937 rng(12345);
+    g_liveWindows.clear();
+
+    for (int step = 0; step < 200000; ++step) {
+        size_t i = rng() % owned.size();
+        HWND h = MakeHwnd(i);
+        switch (rng() % 6) {
+        case 0:   // Create / Attach
+            owned[i].m_hWnd = h;
+            table.SetPermanent(h, &owned[i]);
+            permanent[h] = &owned[i];
+            temporary.erase(h);
+            g_liveWindows.insert(h);
+            break;
+        case 1: { // WM_NCDESTROY
+            bool bTemp = false;
+            CWnd* p = table.Remove(h, &bTemp);
+            bool modelTemp = temporary.count(h) != 0;
+            CHECK(bTemp == modelTemp, "Remove reports temporary correctly");
+            if (!modelTemp) CHECK(p == (permanent.count(h) ? permanent[h] : nullptr), "Remove returns the permanent wrapper");
+            if (bTemp) table.ReleaseTemporary(p);
+            permanent.erase(h);
+            temporary.erase(h);
+            g_liveWindows.erase(h);
+            break;
+        }
+        case 2:   // window dies without passing through our window procedure
+            g_liveWindows.erase(h);
+            break;
+        case 3:
+        case 4: { // FromHandle
+            g_liveWindows.insert(h);
+            CWnd* p = table.FromHandle(h);
+            CHECK(p && p->m_hWnd == h, "FromHandle wrapper carries its HWND");
+            if (permanent.count(h)) CHECK(p == permanent[h], "FromHandle prefers the permanent wrapper");
+            else temporary.insert(h);
+            break;
+        }
+        default:  // OnIdle
+            if (step % 50 == 0) {
+                table.CollectTemporaries(IsWindowStub);
+                table.CollectTemporaries(IsWindowStub);   // second pass: everything is cold now
+                for (auto it = temporary.begin(); it != temporary.end();) {
+                    it = IsWindowStub(*it) ? std::next(it) : temporary.erase(it);
+                }
+            }
+            break;
+        }
+        if (step % 997 == 0) {
+            CHECK(table.GetCount() == permanent.size() + temporary.size(), "entry count matches the model");
+            CHECK(table.GetTemporaryCount() == temporary.size(), "temporary count matches the model");
+            for (size_t k = 0; k < owned.size(); k += 7) {
+                HWND hk = MakeHwnd(k);
+                CWnd* expect = permanent.count(hk) ? permanent[hk] : nullptr;
+                if (expect) CHECK(table.Lookup(hk) == expect, "Lookup finds the permanent wrapper");
+                else if (temporary.count(hk)) CHECK(table.Lookup(hk) && table.IsTemporary(hk), "Lookup finds the temporary wrapper");
+                else CHECK(table.Lookup(hk) == nullptr, "Lookup misses unmapped handles");
+            }
+        }
+    }
+}
+
+// ---- "before": the old global std::map + std::set ----
+
+struct OldHandleMap {
+    std::map<HWND, CWnd*> hwndMap;
+    std::set<CWnd*> tempWrappers;
+
+    ~OldHandleMap() { for (CWnd* p : tempWrappers) delete p; }
+
+    CWnd* FromHandle(HWND h) {
+        auto it = hwndMap.find(h);
+        if (it != hwndMap.end()) return it->second;
+        CWnd* w = new CWnd();
+        w->m_hWnd = h;
+        hwndMap[h] = w;
+        tempWrappers.insert(w);
+        return w;
+    }
+
+    void Cleanup() {
+        std::vector<HWND> stale;
+        for (auto& pair : hwndMap) if (!IsWindowStub(pair.first)) stale.push_back(pair.first);
+        for (HWND h : stale) {
+            CWnd* p = hwndMap[h];
+            hwndMap.erase(h);
+            if (tempWrappers.erase(p)) delete p;
+        }
+    }
+};
+
+static double NsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static volatile uintptr_t g_sink;
+
+int main() {
+    CheckAgainstModel();
+    std::printf("%s: handle table matches the std::map model\n\n", g_failures ? "FAIL" : "PASS");
+
+    const size_t kWindows = 10000;
+    const size_t kTemps = 200;
+    std::vector<CWnd> wrappers(kWindows);
+    std::vector<HWND> lookups;
+    std::mt19937 rng(7);
+    for (size_t i = 0; i < 1000000; ++i) lookups.push_back(MakeHwnd(rng() % kWindows));
+    g_liveWindows.clear();
+    for (size_t i = 0; i < kWindows + kTemps; ++i) g_liveWindows.insert(MakeHwnd(i));
+
+    OldHandleMap before;
+    CWndHandleTable after;
+    for (size_t i = 0; i < kWindows; ++i) {
+        wrappers[i].m_hWnd = MakeHwnd(i);
+        before.hwndMap[MakeHwnd(i)] = &wrappers[i];
+        after.SetPermanent(MakeHwnd(i), &wrappers[i]);
+    }
+    for (size_t i = kWindows; i < kWindows + kTemps; ++i) {
+        before.FromHandle(MakeHwnd(i));
+        after.FromHandle(MakeHwnd(i));
+    }
+
+    std::printf("%zu permanent windows, %zu temporaries\n", kWindows, kTemps);
+    std::printf("  %-28s %12s %12s %9s\n", "", "std::map", "table", "speedup");
+
+    uintptr_t acc = 0;
+    auto t = std::chrono::steady_clock::now();
+    for (HWND h : lookups) acc += reinterpret_cast<uintptr_t>(before.FromHandle(h));
+    double b = NsSince(t) / lookups.size();
+    t = std::chrono::steady_clock::now();
+    for (HWND h : lookups) acc += reinterpret_cast<uintptr_t>(after.FromHandle(h));
+    double a = NsSince(t) / lookups.size();
+    g_sink = acc;
+    std::printf("  %-28s %9.2f ns %9.2f ns %8.1fx\n", "FromHandle (hit)", b, a, b / a);
+
+    const int kIdlePasses = 200;
+    t = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIdlePasses; ++i) before.Cleanup();
+    b = NsSince(t) / kIdlePasses / 1000.0;
+    t = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIdlePasses; ++i) after.CollectTemporaries(IsWindowStub);
+    a = NsSince(t) / kIdlePasses / 1000.0;
+    std::printf("  %-28s %9.2f us %9.2f us %8.1fx\n", "idle cleanup pass", b, a, b / a);
+
+    // Temp churn: GetDlgItem-style wrappers for short-lived controls.
+    t = std::chrono::steady_clock::now();
+    for (int round = 0; round < 200; ++round) {
+        for (size_t i = 0; i < kTemps; ++i) g_liveWindows.erase(MakeHwnd(kWindows + i));
+        before.Cleanup();
+        for (size_t i = 0; i < kTemps; ++i) { g_liveWindows.insert(MakeHwnd(kWindows + i)); before.FromHandle(MakeHwnd(kWindows + i)); }
+    }
+    b = NsSince(t) / (200.0 * kTemps);
+    t = std::chrono::steady_clock::now();
+    for (int round = 0; round < 200; ++round) {
+        for (size_t i = 0; i < kTemps; ++i) g_liveWindows.erase(MakeHwnd(kWindows + i));
+        after.CollectTemporaries(IsWindowStub);
+        after.CollectTemporaries(IsWindowStub);
+        for (size_t i = 0; i < kTemps; ++i) { g_liveWindows.insert(MakeHwnd(kWindows + i)); after.FromHandle(MakeHwnd(kWindows + i)); }
+    }
+    a = NsSince(t) / (200.0 * kTemps);
+    std::printf("  %-28s %9.2f ns %9.2f ns %8.1fx\n", "temp wrapper churn (per temp)", b, a, b / a);
+
+    return g_failures ? 1 : 0;
+}
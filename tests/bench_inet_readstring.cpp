@@ -0,0 +1,476 @@
+// Loopback benchmark + correctness check for CInternetFile::ReadString
+// (phase4/src/inet_read_buffer.h, used by CInternetFile in inetcore.cpp).
+//
+// ReadString(wchar_t*, UINT) used to call Read(&ch, 1) -- one
+// InternetReadFile call -- per byte into a std::vector<char>, then convert
+// it with MultiByteToWideChar. ReadString(CString&) went through a 1024-char
+// stack buffer, so longer lines came back cut short (the rest turned up as
+// the next "line"). SetReadBufferSize only forwarded a WinINet option. Read
+// and ReadString now share a read-ahead buffer sized by SetReadBufferSize
+// (4 KB when ReadString first needs one, as in MFC). ReadString finds the
+// newline with memchr and converts each piece of the line as it comes out
+// of the buffer, holding back a multibyte character split between pieces.
+//
+// The buffer and conversion code is the real inet_read_buffer.h; WinINet
+// is replaced by a loopback stand-in. A server thread plays the HTTP
+// server: it answers a GET with a 200 MB line-oriented body of log-like
+// lines, mostly ASCII with some UTF-8 ("é", "€", "𝄞"), and every 500th
+// line 3,000 to 20,000 bytes long.
+// The client's InternetReadFile stand-in keeps WinINet's shape: a handle
+// looked up in a table and locked per call, copying out of an 8 KB buffer
+// that recv fills. The body is read line by line the old way and with the
+// real buffer code at 4 KB and 64 KB, converting UTF-8 -> UTF-16. The bench
+// reports MB/s, lines read and InternetReadFile calls; the new reader must
+// reproduce every line exactly. On a one-CPU box the server's line
+// generator shares the core, which caps the new readers' MB/s.
+//
+// Build (Linux; the UTF-8 code page stands in for CP_ACP):
+//   g++ -O2 -std=c++17 -pthread tests/bench_inet_readstring.cpp -o /tmp/bench_inet_readstring
+//   /tmp/bench_inet_readstring
+
+#include "../phase4/src/inet_read_buffer.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static int g_fail = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond)
+        g_fail = 1;
+}
+
+// ---- the body: deterministic lines, regenerated on both sides ----
+
+static const uint64_t kBodyBytes = 200ull * 1024 * 1024;
+
+struct LineGenerator {
+    uint64_t nLine = 0;
+    uint32_t nSeed = 12345;
+
+    uint32_t Next() {
+        nSeed = nSeed * 1103515245u + 12345u;
+        return nSeed >> 8;
+    }
+
+    // One line, "\r\n" included.
+    void Make(std::string& line) {
+        static const char* const kWords[] = { "GET", "/index.html", "200", "caf\xC3\xA9", "\xE2\x82\xAC" "42",
+                                              "user=anonymous", "\xF0\x9D\x84\x9E", "latency_ms=17", "ok", "HTTP/1.1" };
+        line.clear();
+        char head[48];
+        std::snprintf(head, sizeof(head), "%010llu ", static_cast<unsigned long long>(nLine));
+        line += head;
+        size_t nTarget = (nLine % 500 == 499) ? 3000 + Next() % 17000 : 20 + Next() % 180;
+        while (line.size() < nTarget) {
+            line += kWords[Next() % 10];
+            line += ' ';
+        }
+        line += "\r\n";
+        ++nLine;
+    }
+};
+
+// ---- the server: HTTP/1.0 200 with the whole body, then close ----
+
+static void Serve(int lfd) {
+    int fd = accept(lfd, nullptr, nullptr);
+    char req[1024];
+    recv(fd, req, sizeof(req), 0);
+    char header[128];
+    int nHeader = std::snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\nContent-Length: %llu\r\n\r\n",
+                                static_cast<unsigned long long>(kBodyBytes));
+    send(fd, header, nHeader, MSG_NOSIGNAL);
+    LineGenerator gen;
+    std::string line, out;
+    uint64_t nSent = 0;
+    while (nSent < kBodyBytes) {
+        while (out.size() < 256 * 1024) {
+            gen.Make(line);
+            out += line;
+        }
+        size_t n = std::min<uint64_t>(out.size(), kBodyBytes - nSent);
+        if (send(fd, out.data(), n, MSG_NOSIGNAL) <= 0)
+            break;
+        nSent += n;
+        out.clear();
+    }
+    close(fd);
+}
+
+// ---- the InternetReadFile stand-in ----
+
+struct InternetHandle {
+    int fd;
+    std::mutex lock;
+    char buf[8192];
+    size_t nPos = 0, nEnd = 0;
+};
+
+static std::unordered_map<void*, InternetHandle*> g_handles;
+static std::mutex g_handleLock;
+
+static uint64_t g_nReadCalls = 0;
+
+static bool InternetReadFile(void* hFile, void* p, unsigned n, unsigned* pnRead) {
+    ++g_nReadCalls;
+    InternetHandle* h;
+    {
+        std::lock_guard<std::mutex> lock(g_handleLock);
+        auto it = g_handles.find(hFile);
+        if (it == g_handles.end())
+            return false;
+        h = it->second;
+    }
+    std::lock_guard<std::mutex> lock(h->lock);
+    unsigned nDone = 0;
+    while (nDone < n) {
+        if (h->nPos == h->nEnd) {
+            ssize_t got = recv(h->fd, h->buf, sizeof(h->buf), 0);
+            if (got <= 0)
+                break;
+            h->nPos = 0;
+            h->nEnd = got;
+        }
+        size_t nCopy = std::min<size_t>(h->nEnd - h->nPos, n - nDone);
+        std::memcpy(static_cast<char*>(p) + nDone, h->buf + h->nPos, nCopy);
+        h->nPos += nCopy;
+        nDone += nCopy;
+    }
+    *pnRead = nDone;
+    return true;
+}
+
+// ---- UTF-8 -> UTF-16, standing in for MultiByteToWideChar(CP_ACP) ----
+
+static int Utf8ToUtf16(const char* p, size_t n, char16_t* pOut) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    int nOut = 0;
+    for (size_t i = 0; i < n;) {
+        uint32_t c = u[i];
+        size_t nLen = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+        if (i + nLen > n) {
+            pOut[nOut++] = 0xFFFD;
+            break;
+        }
+        if (nLen > 1) {
+            c &= 0x3F >> (nLen - 1);
+            for (size_t k = 1; k < nLen; ++k)
+                c = (c << 6) | (u[i + k] & 0x3F);
+        }
+        i += nLen;
+        if (c >= 0x10000) {
+            c -= 0x10000;
+            pOut[nOut++] = static_cast<char16_t>(0xD800 + (c >> 10));
+            pOut[nOut++] = static_cast<char16_t>(0xDC00 + (c & 0x3FF));
+        } else {
+            pOut[nOut++] = static_cast<char16_t>(c);
+        }
+    }
+    return nOut;
+}
+
+// ---- the old CInternetFile::ReadString ----
+
+struct OldInternetFile {
+    void* hFile;
+
+    unsigned Read(void* p, unsigned n) {
+        unsigned nRead = 0;
+        return InternetReadFile(hFile, p, n, &nRead) ? nRead : 0;
+    }
+
+    char16_t* ReadString(char16_t* pstr, unsigned nMax) {
+        std::vector<char> bytes;
+        bytes.reserve(nMax);
+        for (unsigned i = 0; i + 1 < nMax; ++i) {
+            char ch = 0;
+            if (Read(&ch, 1) != 1)
+                break;
+            bytes.push_back(ch);
+            if (ch == '\n')
+                break;
+        }
+        if (bytes.empty())
+            return nullptr;
+        int n = Utf8ToUtf16(bytes.data(), bytes.size(), pstr);
+        pstr[n] = 0;
+        return pstr;
+    }
+
+    bool ReadString(std::u16string& rString) {
+        char16_t buf[1024];
+        if (!ReadString(buf, 1024)) {
+            rString.clear();
+            return false;
+        }
+        rString = buf;
+        return true;
+    }
+};
+
+// ---- the new one, driving the real header ----
+
+struct NewInternetFile {
+    void* hFile;
+    openmfc_inetbuf::ReadAheadBuffer buffer;
+
+    explicit NewInternetFile(void* h) : hFile(h) {}
+
+    struct Source {
+        void* hFile;
+        unsigned operator()(void* p, unsigned n) const {
+            unsigned nRead = 0;
+            return InternetReadFile(hFile, p, n, &nRead) ? nRead : 0;
+        }
+    };
+
+    struct NoLead {
+        bool operator()(unsigned char) const { return false; }
+    };
+
+    bool ReadString(std::u16string& rString) {
+        if (buffer.GetSize() == 0)
+            buffer.SetSize(4096);
+        Source source{ hFile };
+        openmfc_inetbuf::SplitCharCarry<NoLead> carry(openmfc_inetbuf::kUtf8, NoLead());
+        size_t nLen = 0;
+        rString.resize(128);
+        auto emit = [&](const char* p, size_t n) {
+            if (nLen + n > rString.size())
+                rString.resize(std::max(rString.size() * 2, nLen + n));
+            nLen += Utf8ToUtf16(p, n, &rString[nLen]);
+        };
+        bool bRead = buffer.ReadLine(source, static_cast<size_t>(-1),
+                                     [&](const char* p, size_t n) { carry.Feed(p, n, emit); });
+        carry.Finish(emit);
+        rString.resize(nLen);
+        return bRead;
+    }
+};
+
+static std::u16string Widen(const std::string& s) {
+    std::u16string w(s.size(), u'\0');
+    w.resize(Utf8ToUtf16(s.data(), s.size(), &w[0]));
+    return w;
+}
+
+// Opens the "URL": connect, send GET, skip the response header.
+static void* OpenUrl(uint16_t nPort, InternetHandle& h) {
+    h.fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = nPort;
+    if (connect(h.fd, (sockaddr*)&addr, sizeof(addr)) != 0)
+        return nullptr;
+    const char req[] = "GET /log.txt HTTP/1.0\r\n\r\n";
+    send(h.fd, req, sizeof(req) - 1, 0);
+    std::string header;
+    char ch;
+    while (header.size() < 4 || header.compare(header.size() - 4, 4, "\r\n\r\n") != 0) {
+        if (recv(h.fd, &ch, 1, 0) != 1)
+            return nullptr;
+        header += ch;
+    }
+    std::lock_guard<std::mutex> lock(g_handleLock);
+    g_handles[&h] = &h;
+    return &h;
+}
+
+// FNV-1a over the UTF-16 text of each expected line, built before timing
+// so the readers are measured without the generator.
+static std::vector<uint64_t> g_lineHashes;
+
+static uint64_t HashLine(const std::u16string& s) {
+    uint64_t h = 1469598103934665603ull;
+    for (char16_t c : s)
+        h = (h ^ c) * 1099511628211ull;
+    return h;
+}
+
+static void BuildLineHashes() {
+    LineGenerator gen;
+    std::string line;
+    uint64_t nBytes = 0;
+    while (nBytes < kBodyBytes) {
+        gen.Make(line);
+        if (line.size() > kBodyBytes - nBytes)
+            line.resize(kBodyBytes - nBytes);
+        nBytes += line.size();
+        g_lineHashes.push_back(HashLine(Widen(line)));
+    }
+}
+
+struct Result {
+    double mbPerSec;
+    uint64_t nLines, nMismatched, nReadCalls;
+};
+
+// nBufferSize 0: the old reader; otherwise the new one with that buffer.
+static Result Run(unsigned nBufferSize) {
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bind(lfd, (sockaddr*)&addr, sizeof(addr));
+    listen(lfd, 1);
+    getsockname(lfd, (sockaddr*)&addr, &len);
+    std::thread server(Serve, lfd);
+
+    InternetHandle h;
+    void* hFile = OpenUrl(addr.sin_port, h);
+    Result r{};
+    std::u16string got;
+    g_nReadCalls = 0;
+    auto start = Clock::now();
+    if (nBufferSize == 0) {
+        OldInternetFile file{ hFile };
+        while (file.ReadString(got)) {
+            // A line cut at 1024 characters counts once as wrong; the rest
+            // of it, which the old reader returns as further lines, is
+            // skipped.
+            bool bMatch = r.nLines < g_lineHashes.size() && HashLine(got) == g_lineHashes[r.nLines];
+            if (!bMatch) {
+                ++r.nMismatched;
+                while (!got.empty() && got.back() != u'\n' && file.ReadString(got)) {
+                }
+            }
+            ++r.nLines;
+        }
+    } else {
+        NewInternetFile file(hFile);
+        file.buffer.SetSize(nBufferSize);
+        while (file.ReadString(got)) {
+            if (r.nLines >= g_lineHashes.size() || HashLine(got) != g_lineHashes[r.nLines])
+                ++r.nMismatched;
+            ++r.nLines;
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    server.join();
+    {
+        std::lock_guard<std::mutex> lock(g_handleLock);
+        g_handles.erase(hFile);
+    }
+    close(h.fd);
+    close(lfd);
+    r.mbPerSec = kBodyBytes / seconds / (1024.0 * 1024.0);
+    r.nReadCalls = g_nReadCalls;
+    return r;
+}
+
+static void CheckSemantics() {
+    // A scripted source that hands out fixed-size pieces.
+    struct Script {
+        std::string data;
+        size_t nPos = 0;
+        size_t nStep;
+        unsigned operator()(void* p, unsigned n) {
+            size_t nCopy = std::min<size_t>(std::min<size_t>(n, nStep), data.size() - nPos);
+            std::memcpy(p, data.data() + nPos, nCopy);
+            nPos += nCopy;
+            return static_cast<unsigned>(nCopy);
+        }
+    };
+    struct NoLead {
+        bool operator()(unsigned char) const { return false; }
+    };
+
+    Script script{ "ab\ncaf\xC3\xA9\xE2\x82\xAC\nlast", 0, 3 };
+    openmfc_inetbuf::ReadAheadBuffer buf;
+    buf.SetSize(4);
+    std::vector<std::string> lines;
+    std::string cur;
+    while (buf.ReadLine(script, static_cast<size_t>(-1), [&](const char* p, size_t n) { cur.append(p, n); })) {
+        lines.push_back(cur);
+        cur.clear();
+    }
+    check("lines longer than the buffer come back whole",
+          lines.size() == 3 && lines[0] == "ab\n" && lines[1] == "caf\xC3\xA9\xE2\x82\xAC\n" && lines[2] == "last");
+
+    // Split a 3-byte character at every offset across pieces.
+    bool bCarryOk = true;
+    const std::string text = "x\xE2\x82\xACy\xF0\x9D\x84\x9Ez";
+    for (size_t nPiece = 1; nPiece <= 4; ++nPiece) {
+        openmfc_inetbuf::SplitCharCarry<NoLead> carry(openmfc_inetbuf::kUtf8, NoLead());
+        std::u16string out;
+        auto emit = [&](const char* p, size_t n) {
+            char16_t tmp[16];
+            int k = Utf8ToUtf16(p, n, tmp);
+            out.append(tmp, k);
+        };
+        for (size_t i = 0; i < text.size(); i += nPiece)
+            carry.Feed(text.data() + i, std::min(nPiece, text.size() - i), emit);
+        carry.Finish(emit);
+        bCarryOk = bCarryOk && out == Widen(text);
+    }
+    check("a character split between pieces converts whole", bCarryOk);
+
+    // DBCS: 0x81..0x9F lead bytes, as in Shift-JIS.
+    struct SjisLead {
+        bool operator()(unsigned char b) const { return b >= 0x81 && b <= 0x9F; }
+    };
+    openmfc_inetbuf::SplitCharCarry<SjisLead> dbcs(openmfc_inetbuf::kDoubleByte, SjisLead());
+    std::vector<std::string> emitted;
+    auto keep = [&](const char* p, size_t n) { emitted.emplace_back(p, n); };
+    dbcs.Feed("a\x82", 2, keep);
+    dbcs.Feed("\xA0" "b", 2, keep);
+    dbcs.Finish(keep);
+    check("a DBCS lead byte waits for its trail byte",
+          emitted.size() == 3 && emitted[0] == "a" && emitted[1] == "\x82\xA0" && emitted[2] == "b");
+
+    Script raw{ std::string(10000, 'r'), 0, 10000 };
+    openmfc_inetbuf::ReadAheadBuffer readBuf;
+    readBuf.SetSize(4096);
+    char small[10];
+    char large[8192];
+    unsigned nSmall = readBuf.Read(raw, small, sizeof(small));
+    check("shrinking below the buffered bytes is refused, growing keeps them",
+          !readBuf.SetSize(1) && readBuf.SetSize(8192) && readBuf.GetBuffered() == 4086);
+    unsigned nLarge = readBuf.Read(raw, large, sizeof(large));
+    check("Read drains the buffer before reading past it",
+          nSmall == 10 && nLarge == 8192 && large[0] == 'r' && large[8191] == 'r');
+}
+
+int main() {
+    CheckSemantics();
+
+    std::printf("\n200 MB line-oriented body over loopback HTTP\n");
+    BuildLineHashes();
+    std::printf("reader                MB/s        lines   wrong lines   InternetReadFile calls\n");
+    struct {
+        const char* name;
+        unsigned nBufferSize;
+    } readers[] = { { "old (byte Read)", 0 }, { "new, 4 KB buffer", 4096 }, { "new, 64 KB buffer", 65536 } };
+    for (auto& reader : readers) {
+        Result r = Run(reader.nBufferSize);
+        std::printf("%-18s %8.1f %12llu %13llu %24llu\n", reader.name, r.mbPerSec,
+                    static_cast<unsigned long long>(r.nLines), static_cast<unsigned long long>(r.nMismatched),
+                    static_cast<unsigned long long>(r.nReadCalls));
+        if (reader.nBufferSize != 0)
+            check(reader.nBufferSize == 4096 ? "4 KB reader reproduces every line"
+                                             : "64 KB reader reproduces every line",
+                  r.nLines > 0 && r.nMismatched == 0);
+    }
+
+    std::printf("\nRESULT: %s\n", g_fail ? "FAILURE" : "SUCCESS");
+    return g_fail;
+}
@@ -0,0 +1,193 @@
+// Benchmark + correctness check for the CRuntimeClass name index
+// (phase4/src/runtime_class_registry.h, used by cobject_impl.cpp).
+//
+// RegisterRuntimeClass used to scan the whole registry vector for a
+// duplicate, so N AfxClassInit calls cost O(N^2), and FromName / Load
+// strcmp'd every registered class. Both now go through a name-hashed table
+// whose lookups take no lock.
+//
+// The old path is reproduced below next to the real header. With 5,000
+// synthetic DYNCREATE-style classes ("CGeneratedClass0000".."4999", which
+// share a long prefix like real class names do) the bench times
+// registration, then resolves every class name the way Load does for one
+// object each. A reader thread hammers Find while a second batch is
+// registered, to check that lookups stay correct across table growth.
+//
+// Build:
+//   g++ -O2 -std=c++17 -pthread tests/bench_runtime_class_registry.cpp -o /tmp/bench_runtime_class_registry
+//   /tmp/bench_runtime_class_registry
+// or, for the Windows toolchain:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static tests/bench_runtime_class_registry.cpp -o /tmp/bench_runtime_class_registry.exe
+//   WINEDEBUG=-all wine /tmp/bench_runtime_class_registry.exe
+
+#include "../phase4/src/runtime_class_registry.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int g_fail = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond)
+        g_fail = 1;
+}
+
+// The fields of CRuntimeClass the registry touches.
+struct RuntimeClass {
+    const char* m_lpszClassName;
+    RuntimeClass* m_pNextClass;
+};
+
+typedef openmfc_rtreg::ClassNameTable<RuntimeClass> Table;
+
+// ---- the old registry: vector with a duplicate scan, linear FromName ----
+
+struct LinearRegistry {
+    std::vector<RuntimeClass*> classes;
+    RuntimeClass* pHead = nullptr;
+
+    void Register(RuntimeClass* pClass) {
+        for (RuntimeClass* c : classes) {
+            if (c == pClass)
+                return;
+        }
+        pClass->m_pNextClass = pHead;
+        pHead = pClass;
+        classes.push_back(pClass);
+    }
+
+    RuntimeClass* Find(const char* psz) const {
+        for (RuntimeClass* c : classes) {
+            if (c->m_lpszClassName && std::strcmp(c->m_lpszClassName, psz) == 0)
+                return c;
+        }
+        return nullptr;
+    }
+};
+
+static double MsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::vector<std::string> MakeNames(size_t nFirst, size_t nCount) {
+    std::vector<std::string> names;
+    names.reserve(nCount);
+    char sz[64];
+    for (size_t i = nFirst; i < nFirst + nCount; ++i) {
+        std::snprintf(sz, sizeof(sz), "CGeneratedClass%04zu", i);
+        names.push_back(sz);
+    }
+    return names;
+}
+
+static void CheckSemantics() {
+    Table table;
+    RuntimeClass a{ "CDocument", nullptr };
+    RuntimeClass b{ "CDocument", nullptr };
+    RuntimeClass c{ "CDoc", nullptr };
+    RuntimeClass unnamed{ nullptr, nullptr };
+    check("empty table finds nothing", table.Find("CDocument") == nullptr);
+    check("first registration is indexed", table.Add(&a) && table.Find("CDocument") == &a);
+    check("re-registering the same class is refused", !table.Add(&a) && table.GetCount() == 1);
+    check("a second class with the same name keeps the first", !table.Add(&b) && table.Find("CDocument") == &a);
+    check("unnamed classes are not indexed", !table.Add(&unnamed) && table.GetCount() == 1);
+    table.Add(&c);
+    check("lookup by length matches whole names only",
+          table.Find("CDocument", 4) == &c && table.Find("CDocumentX", 9) == &a &&
+          table.Find("CDocu", 5) == nullptr);
+    check("null name finds nothing", table.Find(nullptr) == nullptr);
+}
+
+int main() {
+    CheckSemantics();
+
+    const size_t kClasses = 5000;
+    std::vector<std::string> names = MakeNames(0, kClasses);
+
+    std::printf("\n%zu classes          register (ms)   Load-style lookups (ms)\n", kClasses);
+
+    {
+        std::vector<RuntimeClass> classes(kClasses);
+        for (size_t i = 0; i < kClasses; ++i)
+            classes[i] = RuntimeClass{ names[i].c_str(), nullptr };
+        LinearRegistry reg;
+        auto start = std::chrono::steady_clock::now();
+        for (RuntimeClass& c : classes)
+            reg.Register(&c);
+        double msRegister = MsSince(start);
+        start = std::chrono::steady_clock::now();
+        size_t nFound = 0;
+        for (const std::string& name : names)
+            nFound += reg.Find(name.c_str()) != nullptr;
+        double msFind = MsSince(start);
+        std::printf("  linear scan   %14.3f %25.3f\n", msRegister, msFind);
+        if (nFound != kClasses)
+            g_fail = 1;
+    }
+
+    {
+        std::vector<RuntimeClass> classes(kClasses);
+        for (size_t i = 0; i < kClasses; ++i)
+            classes[i] = RuntimeClass{ names[i].c_str(), nullptr };
+        Table table;
+        auto start = std::chrono::steady_clock::now();
+        for (RuntimeClass& c : classes)
+            table.Add(&c);
+        double msRegister = MsSince(start);
+        start = std::chrono::steady_clock::now();
+        size_t nFound = 0;
+        for (const std::string& name : names)
+            nFound += table.Find(name.c_str(), name.size()) == &classes[&name - &names[0]];
+        double msFind = MsSince(start);
+        std::printf("  name index    %14.3f %25.3f\n\n", msRegister, msFind);
+        check("every class resolves to itself", nFound == kClasses);
+    }
+
+    // Readers during growth: a reader resolves the first batch while a
+    // writer registers a second batch, doubling the table several times.
+    {
+        std::vector<std::string> later = MakeNames(kClasses, 8 * kClasses);
+        std::vector<RuntimeClass> first(kClasses), second(later.size());
+        Table table;
+        for (size_t i = 0; i < kClasses; ++i) {
+            first[i] = RuntimeClass{ names[i].c_str(), nullptr };
+            table.Add(&first[i]);
+        }
+        for (size_t i = 0; i < later.size(); ++i)
+            second[i] = RuntimeClass{ later[i].c_str(), nullptr };
+
+        std::atomic<bool> done{ false };
+        std::atomic<size_t> nMisses{ 0 };
+        std::atomic<size_t> nRounds{ 0 };
+        std::thread reader([&] {
+            while (!done.load(std::memory_order_acquire)) {
+                for (size_t i = 0; i < kClasses; ++i) {
+                    if (table.Find(names[i].c_str()) != &first[i])
+                        nMisses.fetch_add(1, std::memory_order_relaxed);
+                }
+                nRounds.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        for (RuntimeClass& c : second)
+            table.Add(&c);
+        done.store(true, std::memory_order_release);
+        reader.join();
+
+        size_t nSecond = 0;
+        for (size_t i = 0; i < later.size(); ++i)
+            nSecond += table.Find(later[i].c_str()) == &second[i];
+        std::printf("  concurrent reader: %zu rounds over %zu names while %zu classes were added\n",
+                    nRounds.load(), kClasses, later.size());
+        check("lookups stay correct while the table grows", nMisses.load() == 0);
+        check("classes added under concurrent reads are all found", nSecond == later.size());
+    }
+
+    std::printf("\nRESULT: %s\n", g_fail ? "FAILURE" : "SUCCESS");
+    return g_fail;
+}
@@ -0,0 +1,100 @@
+// Contention benchmark for CThreadLocalObject::GetData / CThreadSlotData.
+//
+// GetData used to enter one process-wide CRITICAL_SECTION and hash
+// (threadId << 32 | slot) into an unordered_map on every call, so every
+// AfxGetThreadState-style access serialised all threads. It now reads the
+// calling thread's slot array through TlsGetValue with no lock. This runs
+// 1..64 threads, each hammering a handful of thread-local objects, through the
+// old scheme (reproduced below) and the real exports, and reports aggregate
+// lookups per second.
+//
+// Build:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static tests/bench_thread_local.cpp -o /tmp/bench_thread_local.exe
+//   WINEDEBUG=-all wine /tmp/bench_thread_local.exe
+#include "../phase4/src/global_cthreadslotdata.cpp"
+#include "../phase4/src/global_cthreadlocalobject.cpp"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Minimal CNoTrackObject stand-in: vtable slot 0 is the deleting destructor.
+struct FakeNoTrack;
+typedef void* (MS_ABI *FakeDtor)(FakeNoTrack*, unsigned);
+struct FakeNoTrack {
+    const void* const* vtbl;
+    long payload;
+};
+static void* MS_ABI FakeDeletingDtor(FakeNoTrack* p, unsigned flags) {
+    if (flags & 1) delete p;
+    return p;
+}
+static const void* const g_fakeVtbl[] = { reinterpret_cast<const void*>(&FakeDeletingDtor) };
+static void* MS_ABI CreateFake() { return new FakeNoTrack{ g_fakeVtbl, 1 }; }
+
+// ---- "before": global lock + (threadId, slot) hash ----
+namespace old_scheme {
+CRITICAL_SECTION g_cs;
+std::unordered_map<uint64_t, void*> g_values;
+
+void* GetData(DWORD slot) {
+    const uint64_t k = (static_cast<uint64_t>(GetCurrentThreadId()) << 32) | slot;
+    EnterCriticalSection(&g_cs);
+    auto it = g_values.find(k);
+    void* val = (it != g_values.end()) ? it->second : nullptr;
+    LeaveCriticalSection(&g_cs);
+    if (val == nullptr) {
+        val = CreateFake();
+        EnterCriticalSection(&g_cs);
+        g_values[k] = val;
+        LeaveCriticalSection(&g_cs);
+    }
+    return val;
+}
+} // namespace old_scheme
+
+static const int kObjects = 4;
+static const long kCallsPerThread = 400000;
+
+template <typename F>
+static double Run(int nThreads, F lookup) {
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < nThreads; ++t) {
+        threads.emplace_back([&] {
+            long sum = 0;
+            for (long i = 0; i < kCallsPerThread; ++i) {
+                sum += static_cast<FakeNoTrack*>(lookup(static_cast<int>(i % kObjects)))->payload;
+            }
+            if (sum != kCallsPerThread) std::printf("FAIL: lookup returned a foreign value\n");
+        });
+    }
+    for (auto& th : threads) th.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return nThreads * static_cast<double>(kCallsPerThread) / secs / 1e6;
+}
+
+int main() {
+    InitializeCriticalSection(&old_scheme::g_cs);
+    S objects[kObjects] = {};
+
+    std::printf("%-8s %16s %16s %9s\n", "threads", "lock+hash Mops", "TLS slots Mops", "speedup");
+    for (int n = 1; n <= 64; n *= 2) {
+        double before = Run(n, [](int i) { return old_scheme::GetData(static_cast<DWORD>(i + 1)); });
+        double after = Run(n, [&](int i) {
+            return impl__GetData_CThreadLocalObject__QEAAPEAVCNoTrackObject__P6APEAV2_XZ_Z(
+                &objects[i], reinterpret_cast<void*>(&CreateFake));
+        });
+        std::printf("%-8d %16.1f %16.1f %8.1fx\n", n, before, after, after / before);
+    }
+
+    for (S& obj : objects) {
+        impl___1CThreadLocalObject__QEAA_XZ(&obj);
+    }
+    for (auto& entry : old_scheme::g_values) {
+        delete static_cast<FakeNoTrack*>(entry.second);
+    }
+    return 0;
+}
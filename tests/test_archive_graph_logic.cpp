@@ -0,0 +1,277 @@
+// Behavioral test for CArchive::WriteObject / ReadObject / ReadClass, driven
+// through the real filecore.cpp.
+//
+// Build:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static -DUNICODE -D_UNICODE -I include \
+//       tests/test_archive_graph_logic.cpp -o /tmp/test_archive_graph.exe
+//   WINEDEBUG=-all wine /tmp/test_archive_graph.exe; echo EXIT=$?
+//
+// The test checks:
+// - the tags are MFC's: new class, class index, back-reference;
+// - a shared or cyclic object comes back as one object;
+// - references past index 0x7FFE use the wBigObjectTag escape;
+// - a foreign or malformed archive throws CArchiveException with badClass,
+//   badSchema or badIndex instead of being read past.
+// Store and load times for a 1e5-object graph are printed.
+
+#include "../phase4/src/filecore.cpp"
+#include "../phase4/src/collections_cplex.cpp"
+#include "../phase4/src/global_file_dispatch.cpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+class CGraphNode : public CObject {
+    DECLARE_SERIAL(CGraphNode)
+public:
+    int m_nValue = 0;
+    CGraphNode* m_pLeft = nullptr;
+    CGraphNode* m_pRight = nullptr;
+
+    void Serialize(CArchive& ar) override {
+        if (ar.IsStoring()) {
+            ar << m_nValue << m_pLeft << m_pRight;
+        } else {
+            ar >> m_nValue;
+            m_pLeft = static_cast<CGraphNode*>(ar.ReadObject(RUNTIME_CLASS(CGraphNode)));
+            m_pRight = static_cast<CGraphNode*>(ar.ReadObject(RUNTIME_CLASS(CGraphNode)));
+        }
+    }
+};
+IMPLEMENT_SERIAL(CGraphNode, CObject, 1)
+
+class COtherNode : public CObject {
+    DECLARE_SERIAL(COtherNode)
+public:
+    void Serialize(CArchive&) override {}
+};
+IMPLEMENT_SERIAL(COtherNode, CObject, 1)
+
+// Versionable: any stored schema loads and is reported by GetObjectSchema.
+class CVersionedNode : public CObject {
+    DECLARE_SERIAL(CVersionedNode)
+public:
+    UINT m_nLoadedSchema = 0;
+    void Serialize(CArchive& ar) override {
+        if (ar.IsLoading()) m_nLoadedSchema = ar.GetObjectSchema();
+    }
+};
+IMPLEMENT_SERIAL(CVersionedNode, CObject, 0x80000000u | 2)
+
+// CRuntimeClass::Load / Store live in cobject_impl.cpp. These write the same
+// record (schema, name length, name) and resolve names against this test's
+// classes only, so any other name is a class the loader does not know.
+extern "C" CRuntimeClass* MS_ABI
+impl__Load_CRuntimeClass__SAPEAU1_AEAVCArchive__PEAI_Z(CArchive* ar, unsigned int* pwSchemaNum) {
+    unsigned short wSchema = 0;
+    unsigned short wNameLen = 0;
+    *ar >> wSchema >> wNameLen;
+    *pwSchemaNum = wSchema;
+    char szName[64] = {};
+    if (wNameLen >= sizeof(szName) || ar->Read(szName, wNameLen) != wNameLen) return nullptr;
+    CRuntimeClass* classes[] = { RUNTIME_CLASS(CGraphNode), RUNTIME_CLASS(COtherNode), RUNTIME_CLASS(CVersionedNode) };
+    for (CRuntimeClass* pClass : classes) {
+        if (std::strcmp(pClass->m_lpszClassName, szName) == 0) return pClass;
+    }
+    return nullptr;
+}
+extern "C" void MS_ABI
+impl__Store_CRuntimeClass__QEBAXAEAVCArchive___Z(const CRuntimeClass* pThis, CArchive* ar) {
+    const unsigned short wNameLen = static_cast<unsigned short>(std::strlen(pThis->m_lpszClassName));
+    *ar << static_cast<unsigned short>(pThis->m_wSchema) << wNameLen;
+    ar->Write(pThis->m_lpszClassName, wNameLen);
+}
+extern "C" void MS_ABI
+impl__AfxThrowFileException__YAXHJPEB_W_Z(int, long, const wchar_t*) {
+}
+extern "C" CRuntimeClass* MS_ABI
+impl__GetThisClass_CFileException__SAPEAUCRuntimeClass__XZ() {
+    return nullptr;
+}
+
+// Stand-in for CArchiveException: carries the cause to the test.
+struct ArchiveError {
+    int cause;
+};
+extern "C" void MS_ABI impl__AfxThrowArchiveException__YAXHPEB_W_Z(int cause, const wchar_t*) {
+    throw ArchiveError{ cause };
+}
+struct OutOfMemory {};
+extern "C" void MS_ABI impl__AfxThrowMemoryException__YAXXZ() {
+    throw OutOfMemory{};
+}
+
+static int g_failures = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond) ++g_failures;
+}
+
+static std::vector<BYTE> StoreObjects(const std::vector<CObject*>& objects) {
+    CMemFile file;
+    {
+        CArchive ar(&file, CArchive::store);
+        for (CObject* pOb : objects) ar << pOb;
+        ar.Close();
+    }
+    std::vector<BYTE> bytes(static_cast<size_t>(file.GetLength()));
+    file.Seek(0, CFile::begin);
+    file.Read(bytes.data(), static_cast<UINT>(bytes.size()));
+    return bytes;
+}
+
+// Reads nCount objects; returns the CArchiveException cause, or 0.
+static int LoadObjects(const std::vector<BYTE>& bytes, size_t nCount, const CRuntimeClass* pRequested,
+                       std::vector<CObject*>* pLoaded) {
+    CMemFile file;
+    file.Write(bytes.data(), static_cast<UINT>(bytes.size()));
+    file.Seek(0, CFile::begin);
+    CArchive ar(&file, CArchive::load);
+    try {
+        for (size_t i = 0; i < nCount; ++i) {
+            CObject* pOb = ar.ReadObject(pRequested);
+            if (pLoaded) pLoaded->push_back(pOb);
+        }
+    } catch (const ArchiveError& e) {
+        ar.Abort();
+        return e.cause;
+    }
+    ar.Close();
+    return 0;
+}
+
+static std::vector<BYTE> Bytes(std::initializer_list<int> values) {
+    std::vector<BYTE> bytes;
+    for (int value : values) bytes.push_back(static_cast<BYTE>(value));
+    return bytes;
+}
+
+int main() {
+    const int kBadIndex = 5, kBadClass = 6, kBadSchema = 7;
+
+    // ---- Tag format ---------------------------------------------------------
+    CGraphNode a, b;
+    a.m_nValue = 0x11;
+    a.m_pLeft = &b;
+    a.m_pRight = &a;
+    b.m_nValue = 0x22;
+    const std::vector<BYTE> small = StoreObjects({ &a });
+    {
+        // FFFF, class record (class #1), a (#2): value, 8001 + b (#3), then
+        // a back-reference to #2.
+        std::vector<BYTE> expect = Bytes({ 0xFF, 0xFF, 0x01, 0x00, 0x0A, 0x00 });
+        for (const char* p = "CGraphNode"; *p; ++p) expect.push_back(static_cast<BYTE>(*p));
+        const std::vector<BYTE> tail = Bytes({ 0x11, 0, 0, 0, 0x01, 0x80, 0x22, 0, 0, 0, 0, 0, 0, 0, 0x02, 0x00 });
+        expect.insert(expect.end(), tail.begin(), tail.end());
+        check("tags match MFC (new class, class index, back-reference)", small == expect);
+    }
+    {
+        std::vector<CObject*> loaded;
+        check("small graph loads", LoadObjects(small, 1, RUNTIME_CLASS(CGraphNode), &loaded) == 0);
+        CGraphNode* pA = static_cast<CGraphNode*>(loaded[0]);
+        check("cycle comes back as the same object", pA && pA->m_pRight == pA && pA->m_nValue == 0x11);
+        check("child loads", pA && pA->m_pLeft && pA->m_pLeft->m_nValue == 0x22 && !pA->m_pLeft->m_pLeft);
+        if (pA) delete pA->m_pLeft;
+        delete pA;
+    }
+
+    // ---- Large shared graph -------------------------------------------------
+    // Every node points at an earlier one (a shared back-reference) and every
+    // seventh at itself; past index 0x7FFE the references take the escape.
+    const size_t kNodes = 100000;
+    std::vector<CGraphNode> nodes(kNodes);
+    std::vector<CObject*> roots(kNodes);
+    for (size_t i = 0; i < kNodes; ++i) {
+        nodes[i].m_nValue = static_cast<int>(i);
+        nodes[i].m_pLeft = i ? &nodes[i / 2] : nullptr;
+        nodes[i].m_pRight = (i % 7 == 0) ? &nodes[i] : nullptr;
+        roots[i] = &nodes[i];
+    }
+    auto start = std::chrono::steady_clock::now();
+    const std::vector<BYTE> big = StoreObjects(roots);
+    const double storeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    bool bEscape = false;
+    for (size_t i = 0; i + 1 < big.size() && !bEscape; ++i) bEscape = big[i] == 0xFF && big[i + 1] == 0x7F;
+    check("references past 0x7FFE use wBigObjectTag", bEscape);
+
+    std::vector<CObject*> loaded;
+    start = std::chrono::steady_clock::now();
+    const int nCause = LoadObjects(big, kNodes, RUNTIME_CLASS(CGraphNode), &loaded);
+    const double loadNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    bool bSame = nCause == 0 && loaded.size() == kNodes;
+    for (size_t i = 0; bSame && i < kNodes; ++i) {
+        const CGraphNode* p = static_cast<const CGraphNode*>(loaded[i]);
+        bSame = p->m_nValue == static_cast<int>(i) && p->m_pLeft == (i ? loaded[i / 2] : nullptr) &&
+                p->m_pRight == ((i % 7 == 0) ? p : nullptr);
+    }
+    check("1e5-node shared graph round-trips, one object per node", bSame);
+    std::printf("graph of %zu nodes, %zu bytes: store %.1f ns/object, load %.1f ns/object\n",
+                kNodes, big.size(), storeNs / kNodes, loadNs / kNodes);
+    for (CObject* pOb : loaded) delete pOb;
+
+    // ---- Foreign or malformed archives --------------------------------------
+    {
+        std::vector<BYTE> unknown = small;
+        unknown[6] = 'X';   // "XGraphNode"
+        check("unknown class throws badClass", LoadObjects(unknown, 1, nullptr, nullptr) == kBadClass);
+    }
+    {
+        std::vector<BYTE> newer = small;
+        newer[2] = 2;       // stored schema 2, class is schema 1
+        check("schema mismatch throws badSchema", LoadObjects(newer, 1, nullptr, nullptr) == kBadSchema);
+    }
+    {
+        COtherNode other;
+        const std::vector<BYTE> bytes = StoreObjects({ &other });
+        check("object of another class throws badClass",
+              LoadObjects(bytes, 1, RUNTIME_CLASS(CGraphNode), nullptr) == kBadClass);
+        std::vector<CObject*> any;
+        check("same object loads when any class is accepted", LoadObjects(bytes, 1, nullptr, &any) == 0 &&
+              any.size() == 1 && any[0] && any[0]->IsKindOf(RUNTIME_CLASS(COtherNode)));
+        for (CObject* pOb : any) delete pOb;
+    }
+    {
+        // Second reference is a back-reference (0x0002) to a COtherNode.
+        COtherNode other;
+        const std::vector<BYTE> bytes = StoreObjects({ &other, &other });
+        CMemFile file;
+        file.Write(bytes.data(), static_cast<UINT>(bytes.size()));
+        file.Seek(0, CFile::begin);
+        CArchive ar(&file, CArchive::load);
+        CObject* pFirst = nullptr;
+        int nCause = 0;
+        try {
+            pFirst = ar.ReadObject(nullptr);
+            ar.ReadObject(RUNTIME_CLASS(CGraphNode));
+        } catch (const ArchiveError& e) {
+            nCause = e.cause;
+        }
+        ar.Abort();
+        check("back-reference to another class throws badClass", pFirst && nCause == kBadClass);
+        delete pFirst;
+    }
+    check("back-reference past the map throws badIndex",
+          LoadObjects(Bytes({ 0x05, 0x00 }), 1, nullptr, nullptr) == kBadIndex);
+    check("unknown class index throws badIndex",
+          LoadObjects(Bytes({ 0x07, 0x80 }), 1, nullptr, nullptr) == kBadIndex);
+    {
+        CVersionedNode versioned;
+        std::vector<BYTE> bytes = StoreObjects({ &versioned });
+        bytes[2] = 1;       // written by an older version
+        std::vector<CObject*> any;
+        check("versionable class accepts an older schema", LoadObjects(bytes, 1, nullptr, &any) == 0 &&
+              any.size() == 1 && static_cast<CVersionedNode*>(any[0])->m_nLoadedSchema == 1);
+        for (CObject* pOb : any) delete pOb;
+    }
+
+    if (g_failures == 0) {
+        std::printf("ALL CHECKS PASSED\n");
+        return 0;
+    }
+    std::printf("%d CHECK(S) FAILED\n", g_failures);
+    return 1;
+}
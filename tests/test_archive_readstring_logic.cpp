@@ -0,0 +1,216 @@
+// Behavioral test for CArchive::ReadString and CStdioFile::ReadString,
+// driven through the real filecore.cpp.
+//
+// Build:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static -DUNICODE -D_UNICODE -I include \
+//       tests/test_archive_readstring_logic.cpp -o /tmp/test_archive_readstring.exe
+//   WINEDEBUG=-all wine /tmp/test_archive_readstring.exe; echo EXIT=$?
+//
+// ReadString scans the archive buffer for the newline and copies whole runs
+// between CRs, refilling only at buffer boundaries. The text is log-like:
+// mostly 20..200-char CRLF lines, every 64th line 2..20 K chars, so lines
+// span refills. It is read back through a CFile with archive buffers of
+// several sizes, including odd ones that split a wchar_t across a refill.
+// A CR-dense line checks that stripped CRs do not shorten wchar_t pieces.
+// Every line is compared against a reference split of the same text.
+// Throughput is printed for the default 4 KiB buffer.
+
+#include "../phase4/src/filecore.cpp"
+#include "../phase4/src/collections_cplex.cpp"
+#include "../phase4/src/global_file_dispatch.cpp"
+
+// filecore.cpp's CArchive object/exception code references a handful of
+// symbols that live in other translation units and are not reached here.
+extern "C" CRuntimeClass* MS_ABI
+impl__Load_CRuntimeClass__SAPEAU1_AEAVCArchive__PEAI_Z(CArchive*, unsigned int*) {
+    return nullptr;
+}
+extern "C" void MS_ABI
+impl__Store_CRuntimeClass__QEBAXAEAVCArchive___Z(const CRuntimeClass*, CArchive*) {
+}
+extern "C" void MS_ABI
+impl__AfxThrowFileException__YAXHJPEB_W_Z(int, long, const wchar_t*) {
+}
+extern "C" CRuntimeClass* MS_ABI
+impl__GetThisClass_CFileException__SAPEAUCRuntimeClass__XZ() {
+    return nullptr;
+}
+extern "C" void MS_ABI
+impl__AfxThrowArchiveException__YAXHPEB_W_Z(int, const wchar_t*) {
+}
+extern "C" void MS_ABI
+impl__AfxThrowMemoryException__YAXXZ() {
+}
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static int g_failures = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond) ++g_failures;
+}
+
+static const wchar_t kPath[] = L"test_archive_readstring.tmp";
+static const wchar_t kTextPath[] = L"test_archive_readstring_text.tmp";
+
+static std::wstring MakeText(size_t nTargetChars) {
+    std::wstring text;
+    text.reserve(nTargetChars + 32768);
+    unsigned seed = 12345;
+    for (size_t nLine = 0; text.size() < nTargetChars; ++nLine) {
+        seed = seed * 1664525u + 1013904223u;
+        size_t nLen = (nLine % 64 == 63) ? 2000 + (seed >> 8) % 18000 : 20 + (seed >> 8) % 180;
+        for (size_t i = 0; i < nLen; ++i) text.push_back(static_cast<wchar_t>(L'a' + (i * 7 + nLine) % 26));
+        text += L"\r\n";
+    }
+    text += L"last line\rwithout newline";
+    return text;
+}
+
+// What ReadString(CString&) returns line by line: up to and including the
+// newline, CRs dropped.
+static std::vector<std::wstring> SplitLines(const std::wstring& text) {
+    std::vector<std::wstring> lines(1);
+    for (wchar_t ch : text) {
+        if (ch == L'\r') continue;
+        lines.back().push_back(ch);
+        if (ch == L'\n') lines.emplace_back();
+    }
+    if (lines.back().empty()) lines.pop_back();
+    return lines;
+}
+
+static std::vector<std::wstring> ReadLines(int nBufSize, double* pSeconds) {
+    std::vector<std::wstring> lines;
+    CFile file(kPath, CFile::modeRead);
+    CArchive ar(&file, CArchive::load, nBufSize);
+    CString line;
+    const auto start = std::chrono::steady_clock::now();
+    while (ar.ReadString(line) > 0) {
+        lines.emplace_back(static_cast<const wchar_t*>(line), static_cast<size_t>(line.GetLength()));
+    }
+    if (pSeconds) *pSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ar.Close();
+    return lines;
+}
+
+int main() {
+    const std::wstring text = MakeText(4u * 1024 * 1024);
+    const std::vector<std::wstring> expected = SplitLines(text);
+    {
+        CFile out(kPath, CFile::modeCreate | CFile::modeWrite);
+        out.Write(text.data(), static_cast<UINT>(text.size() * sizeof(wchar_t)));
+        out.Close();
+    }
+
+    // ---- ReadString(CString&) across buffer sizes ---------------------------
+    double seconds = 0;
+    check("CString lines match, 4096-byte buffer", ReadLines(4096, &seconds) == expected);
+    std::printf("CArchive::ReadString(CString&): %.1f MB/s\n", text.size() * sizeof(wchar_t) / seconds / 1e6);
+    check("CString lines match, 4095-byte buffer (split wchar_t)", ReadLines(4095, nullptr) == expected);
+    check("CString lines match, 7-byte buffer", ReadLines(7, nullptr) == expected);
+
+    // ---- ReadString(wchar_t*, nMax) -----------------------------------------
+    {
+        CFile file(kPath, CFile::modeRead);
+        CArchive ar(&file, CArchive::load, 4095);
+        wchar_t piece[512];
+        std::wstring joined;
+        bool bShape = true;
+        int nRead = 0;
+        int nPrev = -1;
+        bool bPrevEndsLine = true;
+        while ((nRead = ar.ReadString(piece, 512)) > 0) {
+            bShape = bShape && piece[nRead] == L'\0' && nRead <= 511;
+            // Only a full buffer or the file's end stops a piece mid-line.
+            bShape = bShape && (nPrev < 0 || bPrevEndsLine || nPrev == 511);
+            joined.append(piece, static_cast<size_t>(nRead));
+            nPrev = nRead;
+            bPrevEndsLine = piece[nRead - 1] == L'\n';
+        }
+        std::wstring noCR;
+        for (wchar_t ch : text) {
+            if (ch != L'\r') noCR.push_back(ch);
+        }
+        check("wchar_t pieces rebuild the text without CRs", joined == noCR);
+        check("wchar_t pieces stop at newline or nMax - 1", bShape);
+        ar.Close();
+    }
+    {
+        // Every character is followed by a CR; stripped CRs take no room, so
+        // each piece still comes back full.
+        static const wchar_t kCRPath[] = L"test_archive_readstring_cr.tmp";
+        std::wstring crText;
+        for (int i = 0; i < 100; ++i) {
+            crText.push_back(static_cast<wchar_t>(L'a' + i % 26));
+            crText.push_back(L'\r');
+        }
+        crText.push_back(L'\n');
+        {
+            CFile out(kCRPath, CFile::modeCreate | CFile::modeWrite);
+            out.Write(crText.data(), static_cast<UINT>(crText.size() * sizeof(wchar_t)));
+            out.Close();
+        }
+        CFile file(kCRPath, CFile::modeRead);
+        CArchive ar(&file, CArchive::load, 4096);
+        wchar_t piece[11];
+        std::vector<int> sizes;
+        int nRead = 0;
+        while ((nRead = ar.ReadString(piece, 11)) > 0) sizes.push_back(nRead);
+        ar.Close();
+        file.Close();
+        CFile::Remove(kCRPath);
+        check("CR-dense line: pieces are full, CRs take no room",
+              sizes == std::vector<int>({ 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 1 }));
+    }
+
+    // ---- CStdioFile::ReadString(CString&) -----------------------------------
+    {
+        std::FILE* pOut = _wfopen(kTextPath, L"wb");
+        const std::string narrow(text.begin(), text.end());
+        std::fwrite(narrow.data(), 1, narrow.size(), pOut);
+        std::fclose(pOut);
+
+        // Text mode turns CRLF into LF; the lone CR in the last line stays.
+        std::vector<std::wstring> stdioExpected;
+        {
+            std::wstring crlfOnly;
+            for (size_t i = 0; i < text.size(); ++i) {
+                if (text[i] == L'\r' && i + 1 < text.size() && text[i + 1] == L'\n') continue;
+                crlfOnly.push_back(text[i]);
+            }
+            stdioExpected.emplace_back();
+            for (wchar_t ch : crlfOnly) {
+                stdioExpected.back().push_back(ch);
+                if (ch == L'\n') stdioExpected.emplace_back();
+            }
+            if (stdioExpected.back().empty()) stdioExpected.pop_back();
+        }
+
+        CStdioFile file(kTextPath, CFile::modeRead | CFile::typeText);
+        std::vector<std::wstring> lines;
+        CString line;
+        const auto start = std::chrono::steady_clock::now();
+        while (file.ReadString(line)) {
+            lines.emplace_back(static_cast<const wchar_t*>(line), static_cast<size_t>(line.GetLength()));
+        }
+        const double stdioSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        file.Close();
+        std::printf("CStdioFile::ReadString(CString&): %.1f MB/s\n", narrow.size() / stdioSeconds / 1e6);
+        check("CStdioFile lines match, long lines intact", lines == stdioExpected);
+    }
+
+    CFile::Remove(kPath);
+    CFile::Remove(kTextPath);
+
+    if (g_failures == 0) {
+        std::printf("ALL CHECKS PASSED\n");
+        return 0;
+    }
+    std::printf("%d CHECK(S) FAILED\n", g_failures);
+    return 1;
+}
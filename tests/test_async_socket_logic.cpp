@@ -0,0 +1,359 @@
+// Behavioral test for CAsyncSocket FD_* notifications, driven through the
+// real sockcore.cpp over loopback.
+//
+// Build:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static -DUNICODE -D_UNICODE -I include \
+//       tests/test_async_socket_logic.cpp -lws2_32 -o /tmp/test_async_socket.exe
+//   WINEDEBUG=-all wine /tmp/test_async_socket.exe; echo EXIT=$?
+//
+// An echo server and its clients run on CAsyncSocket callbacks alone; the
+// test only pumps the thread's message queue. It checks that:
+// - OnAccept, OnConnect, OnReceive and OnClose fire, on the thread that
+//   called AsyncSelect, through that thread's message-only window;
+// - every byte sent comes back, at 1, 100 and 5,000 connections at once;
+// - a stale FD_READ (nothing left to read) does not reach OnReceive;
+// - a socket selected on another thread is notified on that thread, via
+//   its own window;
+// - a closed socket gets no more callbacks.
+// Messages per second and p50/p99 round-trip latency at each connection
+// count are printed.
+
+#include "../phase4/src/filecore.cpp"
+#include "../phase4/src/collections_cplex.cpp"
+#include "../phase4/src/global_file_dispatch.cpp"
+#include "../phase4/src/sockcore.cpp"
+
+// filecore.cpp's CArchive object/exception code references a handful of
+// symbols that live in other translation units and are not reached here.
+extern "C" CRuntimeClass* MS_ABI
+impl__Load_CRuntimeClass__SAPEAU1_AEAVCArchive__PEAI_Z(CArchive*, unsigned int*) {
+    return nullptr;
+}
+extern "C" void MS_ABI
+impl__Store_CRuntimeClass__QEBAXAEAVCArchive___Z(const CRuntimeClass*, CArchive*) {
+}
+extern "C" void MS_ABI
+impl__AfxThrowFileException__YAXHJPEB_W_Z(int, long, const wchar_t*) {
+}
+extern "C" CRuntimeClass* MS_ABI
+impl__GetThisClass_CFileException__SAPEAUCRuntimeClass__XZ() {
+    return nullptr;
+}
+extern "C" void MS_ABI
+impl__AfxThrowArchiveException__YAXHPEB_W_Z(int, const wchar_t*) {
+}
+extern "C" void MS_ABI
+impl__AfxThrowMemoryException__YAXXZ() {
+}
+
+// afxwin.h's inline CWnd / CCmdTarget members reference these; they live
+// in appcore.cpp and wincore.cpp.
+CRuntimeClass CCmdTarget::classCCmdTarget{};
+CRuntimeClass CWnd::classCWnd{};
+CCmdTarget::~CCmdTarget() {}
+int CCmdTarget::OnCmdMsg(unsigned int, int, void*, void*) { return 0; }
+const AFX_MSGMAP* CCmdTarget::GetMessageMap() const { return nullptr; }
+const AFX_MSGMAP* PASCAL CWnd::GetThisMessageMap() { return nullptr; }
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static int g_failures = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond) ++g_failures;
+}
+
+// Dispatches the calling thread's messages until done() or the timeout.
+static bool PumpUntil(const std::function<bool()>& done, DWORD dwTimeoutMs) {
+    const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(dwTimeoutMs);
+    while (!done()) {
+        MSG msg;
+        while (::PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
+            ::TranslateMessage(&msg);
+            ::DispatchMessageW(&msg);
+        }
+        if (done()) break;
+        if (Clock::now() >= deadline) return false;
+        ::MsgWaitForMultipleObjectsEx(0, nullptr, 10, QS_ALLINPUT, 0);
+    }
+    return true;
+}
+
+struct Callbacks {
+    std::atomic<int> nAccept{ 0 };
+    std::atomic<int> nConnect{ 0 };
+    std::atomic<int> nReceive{ 0 };
+    std::atomic<int> nClose{ 0 };
+    std::atomic<int> nWrongThread{ 0 };
+    DWORD dwThread = 0;
+
+    void Seen(std::atomic<int>& n) {
+        ++n;
+        if (::GetCurrentThreadId() != dwThread) ++nWrongThread;
+    }
+};
+
+class EchoConnection : public CAsyncSocket {
+public:
+    explicit EchoConnection(Callbacks& cb) : m_cb(cb) {}
+    void OnReceive(int nErrorCode) override {
+        m_cb.Seen(m_cb.nReceive);
+        if (nErrorCode) return;
+        char buf[4096];
+        int n = Receive(buf, sizeof(buf));
+        if (n > 0) Send(buf, n);
+    }
+    void OnClose(int) override { m_cb.Seen(m_cb.nClose); }
+
+private:
+    Callbacks& m_cb;
+};
+
+class EchoListener : public CAsyncSocket {
+public:
+    explicit EchoListener(Callbacks& cb) : m_cb(cb) {}
+    void OnAccept(int nErrorCode) override {
+        m_cb.Seen(m_cb.nAccept);
+        if (nErrorCode) return;
+        std::unique_ptr<EchoConnection> pConn(new EchoConnection(m_cb));
+        if (Accept(*pConn)) {
+            pConn->AsyncSelect(FD_READ | FD_CLOSE);
+            m_connections.push_back(std::move(pConn));
+        }
+    }
+    UINT Port() {
+        CString address;
+        UINT nPort = 0;
+        GetSockName(address, nPort);
+        return nPort;
+    }
+    std::vector<std::unique_ptr<EchoConnection>> m_connections;
+
+private:
+    Callbacks& m_cb;
+};
+
+// Once started, sends nMessages numbered messages, one at a time, each
+// after the echo of the last one has come back, and records each round
+// trip in microseconds.
+class EchoClient : public CAsyncSocket {
+public:
+    static const int kMessageSize = 64;
+
+    EchoClient(Callbacks& cb, int nMessages, std::vector<double>& latencies)
+        : m_cb(cb), m_nMessages(nMessages), m_latencies(latencies) {}
+    void OnConnect(int nErrorCode) override {
+        m_cb.Seen(m_cb.nConnect);
+        m_bConnectOk = nErrorCode == 0;
+    }
+    void OnReceive(int nErrorCode) override {
+        m_cb.Seen(m_cb.nReceive);
+        if (nErrorCode) return;
+        int n = Receive(m_pending + m_nHave, kMessageSize - m_nHave);
+        if (n <= 0) return;
+        m_nHave += n;
+        if (m_nHave < kMessageSize) return;
+        m_nHave = 0;
+        m_latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - m_sent).count());
+        m_bIntact = m_bIntact && m_pending[0] == static_cast<char>(m_nEchoed) &&
+                    m_pending[kMessageSize - 1] == m_pending[0];
+        if (++m_nEchoed < m_nMessages) SendNext();
+    }
+    void Start() {
+        if (m_bConnectOk) SendNext();
+    }
+    bool Done() const { return m_nEchoed == m_nMessages; }
+
+    bool m_bConnectOk = false;
+    bool m_bIntact = true;
+    int m_nEchoed = 0;
+
+private:
+    void SendNext() {
+        char buf[kMessageSize];
+        std::memset(buf, static_cast<char>(m_nEchoed), sizeof(buf));
+        m_sent = Clock::now();
+        Send(buf, sizeof(buf));
+    }
+
+    Callbacks& m_cb;
+    const int m_nMessages;
+    std::vector<double>& m_latencies;
+    Clock::time_point m_sent;
+    char m_pending[kMessageSize];
+    int m_nHave = 0;
+};
+
+struct EchoRun {
+    bool bAllConnected = false;
+    bool bFinished = false;
+    bool bIntact = true;
+    double messagesPerSec = 0;
+    double p50Us = 0;
+    double p99Us = 0;
+};
+
+// Connects nClients clients to the listener in waves the accept backlog
+// can hold, then runs the echo on all of them at once. The clients stay
+// connected in `clients` afterwards.
+static EchoRun RunEcho(Callbacks& cb, EchoListener& listener, UINT nPort, int nClients, int nMessages,
+                       std::vector<std::unique_ptr<EchoClient>>& clients, std::vector<double>& latencies) {
+    const int kWave = 100;
+    clients.clear();
+    listener.m_connections.clear();
+    latencies.clear();
+    latencies.reserve(static_cast<size_t>(nClients) * nMessages);
+    cb.nAccept = 0;
+    cb.nConnect = 0;
+
+    EchoRun run;
+    for (int nStarted = 0; nStarted < nClients;) {
+        const int nWave = std::min(kWave, nClients - nStarted);
+        for (int i = 0; i < nWave; ++i) {
+            clients.emplace_back(new EchoClient(cb, nMessages, latencies));
+            clients.back()->Create(0, SOCK_STREAM, FD_CONNECT | FD_READ);
+            clients.back()->Connect(L"127.0.0.1", nPort);
+        }
+        nStarted += nWave;
+        if (!PumpUntil([&] { return cb.nConnect == nStarted && cb.nAccept == nStarted; }, 20000)) return run;
+    }
+    run.bAllConnected = true;
+    for (const auto& pClient : clients) run.bAllConnected = run.bAllConnected && pClient->m_bConnectOk;
+
+    const Clock::time_point start = Clock::now();
+    for (const auto& pClient : clients) pClient->Start();
+    run.bFinished = PumpUntil([&] {
+        for (const auto& pClient : clients) {
+            if (!pClient->Done()) return false;
+        }
+        return true;
+    }, 60000);
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (const auto& pClient : clients) run.bIntact = run.bIntact && pClient->m_bIntact;
+    run.messagesPerSec = latencies.size() / seconds;
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        run.p50Us = latencies[latencies.size() / 2];
+        run.p99Us = latencies[latencies.size() * 99 / 100];
+    }
+    return run;
+}
+
+// A socket that only counts OnReceive.
+class CountingSocket : public CAsyncSocket {
+public:
+    void OnReceive(int) override { ++m_nReceive; m_dwThread = ::GetCurrentThreadId(); }
+    std::atomic<int> m_nReceive{ 0 };
+    DWORD m_dwThread = 0;
+};
+
+int main() {
+    Callbacks cb;
+    cb.dwThread = ::GetCurrentThreadId();
+
+    EchoListener listener(cb);
+    check("listener created",
+          listener.Create(0, SOCK_STREAM, FD_ACCEPT, L"127.0.0.1") && listener.Listen(SOMAXCONN));
+    const UINT nPort = listener.Port();
+
+    // ---- Echo benchmark at 1, 100 and 5,000 connections ---------------------
+    // About the same number of round trips at each size. The 5,000-client
+    // run is last, and its sockets are used by the sections below.
+    const int kClientCounts[] = { 1, 100, 5000 };
+    const int kMessageCounts[] = { 20000, 200, 4 };
+    std::vector<std::unique_ptr<EchoClient>> clients;
+    std::vector<double> latencies;
+    int nClients = 0;
+    for (int i = 0; i < 3; ++i) {
+        nClients = kClientCounts[i];
+        const EchoRun run = RunEcho(cb, listener, nPort, nClients, kMessageCounts[i], clients, latencies);
+        std::printf("%5d connections x %5d messages: %9.0f messages/s, round trip p50 %7.1f us, p99 %8.1f us\n",
+                    nClients, kMessageCounts[i], run.messagesPerSec, run.p50Us, run.p99Us);
+        char name[96];
+        std::snprintf(name, sizeof(name), "%d connection(s): OnAccept and OnConnect for every one", nClients);
+        check(name, run.bAllConnected && cb.nAccept == nClients &&
+                    listener.m_connections.size() == static_cast<size_t>(nClients));
+        std::snprintf(name, sizeof(name), "%d connection(s): every message echoed intact", nClients);
+        check(name, run.bFinished && run.bIntact);
+    }
+    check("callbacks run on the thread that selected the sockets", cb.nWrongThread == 0);
+
+    // ---- Stale FD_READ is filtered ------------------------------------------
+    {
+        const int nBefore = cb.nReceive;
+        CAsyncSocket::DoCallBack(clients[0]->GetSocket(), WSAMAKESELECTREPLY(FD_READ, 0));
+        check("FD_READ with nothing to read skips OnReceive", cb.nReceive == nBefore);
+    }
+
+    // ---- OnClose ------------------------------------------------------------
+    {
+        const int nBefore = cb.nClose;
+        const SOCKET hClient = clients[0]->GetSocket();
+        check("a live socket is in the handle map", CAsyncSocket::LookupHandle(hClient) == clients[0].get());
+        clients[0]->Close();
+        check("peer close reaches OnClose", PumpUntil([&] { return cb.nClose > nBefore; }, 5000));
+        check("a closed socket is no longer in the handle map", CAsyncSocket::LookupHandle(hClient) == nullptr);
+    }
+
+    // ---- Another thread's socket --------------------------------------------
+    {
+        std::unique_ptr<CountingSocket> pSocket(new CountingSocket);
+        std::atomic<bool> bSelected{ false };
+        std::atomic<bool> bStop{ false };
+        HWND hWorkerWnd = nullptr;
+        DWORD dwWorker = 0;
+        std::thread worker([&] {
+            dwWorker = ::GetCurrentThreadId();
+            pSocket->Create(0, SOCK_STREAM, FD_CONNECT | FD_READ);
+            pSocket->Connect(L"127.0.0.1", nPort);
+            hWorkerWnd = GetSocketWindow();
+            bSelected = true;
+            PumpUntil([&] { return bStop.load(); }, 20000);
+            pSocket->Close();
+        });
+        while (!bSelected) std::this_thread::yield();
+        check("each thread gets its own notification window",
+              hWorkerWnd != nullptr && hWorkerWnd != GetSocketWindow() &&
+              ::GetWindowThreadProcessId(hWorkerWnd, nullptr) == dwWorker);
+        // The main thread accepts it and echoes one message back.
+        PumpUntil([&] { return listener.m_connections.size() == nClients + 1; }, 5000);
+        const char hello[] = "hello";
+        pSocket->Send(hello, sizeof(hello));
+        const bool bGot = PumpUntil([&] { return pSocket->m_nReceive > 0; }, 5000);
+        bStop = true;
+        worker.join();
+        check("a worker's socket is notified on the worker", bGot && pSocket->m_dwThread == dwWorker);
+    }
+
+    // ---- No callbacks after Close -------------------------------------------
+    {
+        const int nBefore = cb.nReceive;
+        EchoConnection* pConn = listener.m_connections.back().get();
+        const SOCKET hOld = pConn->GetSocket();
+        pConn->Close();
+        CAsyncSocket::DoCallBack(hOld, WSAMAKESELECTREPLY(FD_READ, 0));
+        PumpUntil([] { return false; }, 100);
+        check("no OnReceive for a closed socket", cb.nReceive == nBefore);
+    }
+
+    clients.clear();
+    listener.Close();
+
+    if (g_failures == 0) {
+        std::printf("ALL CHECKS PASSED\n");
+        return 0;
+    }
+    std::printf("%d CHECK(S) FAILED\n", g_failures);
+    return 1;
+}
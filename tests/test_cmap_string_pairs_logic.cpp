@@ -0,0 +1,196 @@
+// Behavioral test for CMapStringToString::PLookup / PGetFirstAssoc /
+// PGetNextAssoc, driven through the real filecore.cpp.
+//
+// Build:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static -DUNICODE -D_UNICODE -I include \
+//       tests/test_cmap_string_pairs_logic.cpp -o /tmp/test_cmap_string_pairs.exe
+//   WINEDEBUG=-all wine /tmp/test_cmap_string_pairs.exe; echo EXIT=$?
+//
+// The test checks:
+// - PLookup returns the map's own node: writes through it show up in
+//   Lookup, and GetAssocAt finds the same node;
+// - the pointers it returns stay valid while the buckets grow;
+// - the PGet*Assoc walk visits every entry once, in GetNextAssoc order,
+//   and follows removals;
+// - Serialize round-trips the entries.
+// SetAt + PLookup and full-walk times are printed.
+
+#include "../phase4/src/filecore.cpp"
+#include "../phase4/src/collections_cplex.cpp"
+#include "../phase4/src/global_file_dispatch.cpp"
+
+// filecore.cpp's CArchive object/exception code references a handful of
+// symbols that live in other translation units and are not reached here.
+extern "C" CRuntimeClass* MS_ABI
+impl__Load_CRuntimeClass__SAPEAU1_AEAVCArchive__PEAI_Z(CArchive*, unsigned int*) {
+    return nullptr;
+}
+extern "C" void MS_ABI
+impl__Store_CRuntimeClass__QEBAXAEAVCArchive___Z(const CRuntimeClass*, CArchive*) {
+}
+extern "C" void MS_ABI
+impl__AfxThrowFileException__YAXHJPEB_W_Z(int, long, const wchar_t*) {
+}
+extern "C" CRuntimeClass* MS_ABI
+impl__GetThisClass_CFileException__SAPEAUCRuntimeClass__XZ() {
+    return nullptr;
+}
+extern "C" void MS_ABI
+impl__AfxThrowArchiveException__YAXHPEB_W_Z(int, const wchar_t*) {
+}
+extern "C" void MS_ABI
+impl__AfxThrowMemoryException__YAXXZ() {
+}
+
+#include <chrono>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static int g_failures = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond) ++g_failures;
+}
+
+static CString KeyOf(int i) {
+    CString key;
+    key.Format(L"HKEY_CURRENT_USER\\Software\\OpenMFC\\Settings\\Entry%d", i);
+    return key;
+}
+
+static CString ValueOf(int i) {
+    CString value;
+    value.Format(L"value %d", i);
+    return value;
+}
+
+int main() {
+    // ---- PLookup hands out the map's own node --------------------------------
+    {
+        CMapStringToString map;
+        map.SetAt(L"alpha", L"1");
+        map.SetAt(L"beta", L"2");
+        CMapStringToString::CPair* pPair = map.PLookup(L"alpha");
+        check("PLookup finds a key", pPair && pPair->key == L"alpha" && pPair->value == L"1");
+        check("PLookup of a missing key is null", map.PLookup(L"gamma") == nullptr);
+        const CMapStringToString& cmap = map;
+        check("const PLookup returns the same node", cmap.PLookup(L"alpha") == pPair);
+        pPair->value = L"changed";
+        CString value;
+        check("a write through the pair is seen by Lookup", map.Lookup(L"alpha", value) && value == L"changed");
+        UINT nBucket = 0;
+        UINT nHash = 0;
+        check("GetAssocAt returns the PLookup node",
+              static_cast<CMapStringToString::CPair*>(map.GetAssocAt(L"alpha", nBucket, nHash)) == pPair);
+        map.SetAt(L"alpha", L"again");
+        check("SetAt of an existing key keeps the node", map.PLookup(L"alpha") == pPair && pPair->value == L"again");
+        map.RemoveKey(L"alpha");
+        check("a removed key is gone from PLookup", map.PLookup(L"alpha") == nullptr && map.GetCount() == 1);
+    }
+
+    // ---- Pointers stay valid while the buckets grow --------------------------
+    const int kEntries = 100000;
+    {
+        CMapStringToString map;
+        map.EnableAutoRehash();
+        const UINT nInitialBuckets = map.GetHashTableSize();
+        std::vector<CMapStringToString::CPair*> pairs;
+        for (int i = 0; i < 64; ++i) {
+            map.SetAt(KeyOf(i), ValueOf(i));
+            pairs.push_back(map.PLookup(KeyOf(i)));
+        }
+        double interleaveMs = 0;
+        {
+            const Clock::time_point start = Clock::now();
+            bool bFound = true;
+            for (int i = 64; i < kEntries; ++i) {
+                map.SetAt(KeyOf(i), ValueOf(i));
+                bFound = bFound && map.PLookup(KeyOf(i / 2)) != nullptr;
+            }
+            interleaveMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            check("SetAt + PLookup of an older key always finds it", bFound);
+        }
+        check("the buckets grew", map.GetHashTableSize() > nInitialBuckets);
+        bool bStable = true;
+        for (int i = 0; i < 64; ++i) {
+            bStable = bStable && map.PLookup(KeyOf(i)) == pairs[i] && pairs[i]->key == KeyOf(i) &&
+                      pairs[i]->value == ValueOf(i);
+        }
+        check("pairs from before the growth are still the map's nodes", bStable);
+
+        // ---- The walk ------------------------------------------------------
+        std::set<std::wstring> seen;
+        bool bValues = true;
+        const Clock::time_point start = Clock::now();
+        for (const CMapStringToString::CPair* p = map.PGetFirstAssoc(); p; p = map.PGetNextAssoc(p)) {
+            seen.insert(static_cast<const wchar_t*>(p->key));
+            bValues = bValues && p->value == map[p->key];
+        }
+        const double walkMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        check("PGet*Assoc visits every entry once", seen.size() == static_cast<size_t>(kEntries) && bValues);
+
+        bool bSameOrder = true;
+        CMapStringToString::POSITION pos = map.GetStartPosition();
+        const CMapStringToString::CPair* p = map.PGetFirstAssoc();
+        while (pos.pAssoc && p) {
+            CString key;
+            CString value;
+            map.GetNextAssoc(pos, key, value);
+            bSameOrder = bSameOrder && key == p->key;
+            p = map.PGetNextAssoc(p);
+        }
+        check("and in GetNextAssoc order", bSameOrder && !pos.pAssoc && !p);
+
+        for (int i = 0; i < kEntries; i += 2) map.RemoveKey(KeyOf(i));
+        INT_PTR nWalked = 0;
+        bool bOnlyOdd = true;
+        for (const CMapStringToString::CPair* q = map.PGetFirstAssoc(); q; q = map.PGetNextAssoc(q)) {
+            ++nWalked;
+            bOnlyOdd = bOnlyOdd && map.PLookup(q->key) == q;
+        }
+        check("after removals the walk sees only what is left", nWalked == kEntries / 2 && bOnlyOdd &&
+                                                                 nWalked == map.GetCount());
+        std::printf("%d entries: SetAt + PLookup %.3f us/pair, PGet*Assoc walk %.1f ms\n", kEntries,
+                    interleaveMs * 1000.0 / (kEntries - 64), walkMs);
+    }
+    {
+        CMapStringToString empty;
+        check("an empty map walks nothing", empty.PGetFirstAssoc() == nullptr);
+    }
+
+    // ---- Serialize ------------------------------------------------------------
+    {
+        CMapStringToString map;
+        for (int i = 0; i < 1000; ++i) map.SetAt(KeyOf(i), ValueOf(i));
+        CMemFile file;
+        {
+            CArchive ar(&file, CArchive::store);
+            map.Serialize(ar);
+            ar.Close();
+        }
+        file.Seek(0, CFile::begin);
+        CMapStringToString loaded;
+        {
+            CArchive ar(&file, CArchive::load);
+            loaded.Serialize(ar);
+        }
+        bool bSame = loaded.GetCount() == map.GetCount();
+        for (const CMapStringToString::CPair* p = map.PGetFirstAssoc(); bSame && p; p = map.PGetNextAssoc(p)) {
+            const CMapStringToString::CPair* q = loaded.PLookup(p->key);
+            bSame = q && q->value == p->value;
+        }
+        check("Serialize round-trips every pair", bSame);
+    }
+
+    if (g_failures == 0) {
+        std::printf("ALL CHECKS PASSED\n");
+        return 0;
+    }
+    std::printf("%d CHECK(S) FAILED\n", g_failures);
+    return 1;
+}
@@ -25,6 +25,12 @@ extern "C" CRuntimeClass* MS_ABI
 impl__GetThisClass_CFileException__SAPEAUCRuntimeClass__XZ() {
     return nullptr;
 }
+extern "C" void MS_ABI
+impl__AfxThrowArchiveException__YAXHPEB_W_Z(int, const wchar_t*) {
+}
+extern "C" void MS_ABI
+impl__AfxThrowMemoryException__YAXXZ() {
+}
 
 #include "../phase4/src/file_cmirrorfile.cpp"
 
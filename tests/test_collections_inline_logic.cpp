@@ -0,0 +1,284 @@
+// Behavioral test for the non-template collections (CPtrArray, CDWordArray,
+// CObList, CMapPtrToPtr, ...), driven through the real filecore.cpp members.
+//
+// Build:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static -DUNICODE -D_UNICODE -I include \
+//       tests/test_collections_inline_logic.cpp -o /tmp/test_collections_inline.exe
+//   WINEDEBUG=-all wine /tmp/test_collections_inline.exe; echo EXIT=$?
+//
+// The collections keep their elements in their own retail member block, so
+// the test checks that block directly (m_pData/m_nSize, m_pNodeHead,
+// m_pHashTable), that the wrappers cannot be copied, and that Serialize
+// writes element counts in MFC's WORD / 0xFFFF+DWORD format. It finishes
+// with per-thread GetAt/Lookup timings next to a copy of the old side-table
+// path (one process-wide mutex plus a hash lookup per call), so the numbers
+// read as a before/after comparison.
+
+#include "../phase4/src/filecore.cpp"
+#include "../phase4/src/collections_cplex.cpp"
+#include "../phase4/src/global_file_dispatch.cpp"
+
+// filecore.cpp's CArchive object/exception code references a handful of
+// symbols that live in other translation units and are not reached here.
+extern "C" CRuntimeClass* MS_ABI
+impl__Load_CRuntimeClass__SAPEAU1_AEAVCArchive__PEAI_Z(CArchive*, unsigned int*) {
+    return nullptr;
+}
+extern "C" void MS_ABI
+impl__Store_CRuntimeClass__QEBAXAEAVCArchive___Z(const CRuntimeClass*, CArchive*) {
+}
+extern "C" void MS_ABI
+impl__AfxThrowFileException__YAXHJPEB_W_Z(int, long, const wchar_t*) {
+}
+extern "C" CRuntimeClass* MS_ABI
+impl__GetThisClass_CFileException__SAPEAUCRuntimeClass__XZ() {
+    return nullptr;
+}
+extern "C" void MS_ABI
+impl__AfxThrowArchiveException__YAXHPEB_W_Z(int, const wchar_t*) {
+}
+extern "C" void MS_ABI
+impl__AfxThrowMemoryException__YAXXZ() {
+}
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+static int g_failures = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond) ++g_failures;
+}
+
+// The wrappers own their storage; a member-wise copy would double-free it.
+static_assert(!std::is_copy_constructible<CPtrArray>::value, "CPtrArray must not be copyable");
+static_assert(!std::is_copy_assignable<CDWordArray>::value, "CDWordArray must not be assignable");
+static_assert(!std::is_copy_constructible<CObList>::value, "CObList must not be copyable");
+static_assert(!std::is_copy_constructible<CMapPtrToPtr>::value, "CMapPtrToPtr must not be copyable");
+static_assert(!std::is_copy_constructible<CStringArray>::value, "CStringArray must not be copyable");
+static_assert(!std::is_copy_constructible<CStringList>::value, "CStringList must not be copyable");
+static_assert(!std::is_copy_assignable<CMapStringToString>::value, "CMapStringToString must not be assignable");
+static_assert(!std::is_copy_constructible<CMapStringToOb>::value, "CMapStringToOb must not be copyable");
+static_assert(!std::is_copy_constructible<CMapStringToPtr>::value, "CMapStringToPtr must not be copyable");
+
+// Test-side accessors for the protected retail member blocks.
+struct PtrArrayAccess : CPtrArray {
+    static void** Data(CPtrArray& a) { return static_cast<PtrArrayAccess&>(a).m_pData; }
+    static INT_PTR Size(CPtrArray& a) { return static_cast<PtrArrayAccess&>(a).m_nSize; }
+};
+struct ObListAccess : CObList {
+    static void* Head(CObList& l) { return static_cast<ObListAccess&>(l).m_pNodeHead; }
+    static INT_PTR Count(CObList& l) { return static_cast<ObListAccess&>(l).m_nCount; }
+};
+struct MapAccess : CMapPtrToPtr {
+    static void* Table(CMapPtrToPtr& m) { return static_cast<MapAccess&>(m).m_pHashTable; }
+};
+
+static void* AsPtr(INT_PTR n) { return reinterpret_cast<void*>(n); }
+
+// Stores array into a CMemFile and returns the archive bytes.
+static std::vector<BYTE> Store(CDWordArray& array) {
+    CMemFile file;
+    {
+        CArchive ar(&file, CArchive::store);
+        array.Serialize(ar);
+        ar.Close();
+    }
+    std::vector<BYTE> bytes(static_cast<size_t>(file.GetLength()));
+    file.Seek(0, CFile::begin);
+    file.Read(bytes.data(), static_cast<UINT>(bytes.size()));
+    return bytes;
+}
+
+static void Load(const std::vector<BYTE>& bytes, CDWordArray& array) {
+    CMemFile file;
+    file.Write(bytes.data(), static_cast<UINT>(bytes.size()));
+    file.Seek(0, CFile::begin);
+    CArchive ar(&file, CArchive::load);
+    array.Serialize(ar);
+    ar.Close();
+}
+
+// The storage path the collections used before: every member took one
+// process-wide mutex and found the wrapper's elements in a hash map keyed by
+// the wrapper's address. Kept as the timing baseline.
+namespace side_table {
+
+std::mutex g_stateMutex;
+
+template<class Wrapper, class State>
+std::unordered_map<const Wrapper*, State>& States() {
+    static std::unordered_map<const Wrapper*, State> states;
+    return states;
+}
+
+class PtrArray {
+public:
+    typedef CArray<void*, void*> State;
+    PtrArray() { std::lock_guard<std::mutex> lock(g_stateMutex); States<PtrArray, State>()[this]; }
+    ~PtrArray() { std::lock_guard<std::mutex> lock(g_stateMutex); States<PtrArray, State>().erase(this); }
+    void SetSize(INT_PTR nNewSize) {
+        std::lock_guard<std::mutex> lock(g_stateMutex);
+        States<PtrArray, State>()[this].SetSize(nNewSize);
+    }
+    void SetAt(INT_PTR nIndex, void* newElement) {
+        std::lock_guard<std::mutex> lock(g_stateMutex);
+        States<PtrArray, State>()[this].SetAt(nIndex, newElement);
+    }
+    void* GetAt(INT_PTR nIndex) const {
+        std::lock_guard<std::mutex> lock(g_stateMutex);
+        auto it = States<PtrArray, State>().find(this);
+        return it == States<PtrArray, State>().end() ? nullptr : it->second.GetAt(nIndex);
+    }
+};
+
+class MapPtrToPtr {
+public:
+    typedef CMap<void*, void*, void*, void*> State;
+    MapPtrToPtr() { std::lock_guard<std::mutex> lock(g_stateMutex); States<MapPtrToPtr, State>()[this]; }
+    ~MapPtrToPtr() { std::lock_guard<std::mutex> lock(g_stateMutex); States<MapPtrToPtr, State>().erase(this); }
+    void SetAt(void* key, void* newValue) {
+        std::lock_guard<std::mutex> lock(g_stateMutex);
+        States<MapPtrToPtr, State>()[this].SetAt(key, newValue);
+    }
+    BOOL Lookup(void* key, void*& rValue) const {
+        std::lock_guard<std::mutex> lock(g_stateMutex);
+        auto it = States<MapPtrToPtr, State>().find(this);
+        return it != States<MapPtrToPtr, State>().end() && it->second.Lookup(key, rValue);
+    }
+};
+
+} // namespace side_table
+
+template<class TArray>
+static double TimeArrayReads(int nThreads, int nOps) {
+    std::vector<std::thread> threads;
+    const auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < nThreads; ++t) {
+        threads.emplace_back([nOps] {
+            TArray array;
+            array.SetSize(1024);
+            for (INT_PTR i = 0; i < 1024; ++i) array.SetAt(i, AsPtr(i));
+            volatile INT_PTR sum = 0;
+            for (int i = 0; i < nOps; ++i) sum += reinterpret_cast<INT_PTR>(array.GetAt(i & 1023));
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count()
+           / (static_cast<double>(nOps) * nThreads);
+}
+
+template<class TMap>
+static double TimeMapLookups(int nThreads, int nOps) {
+    std::vector<std::thread> threads;
+    const auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < nThreads; ++t) {
+        threads.emplace_back([nOps] {
+            TMap map;
+            for (INT_PTR i = 1; i <= 1024; ++i) map.SetAt(AsPtr(i * 16), AsPtr(i));
+            void* value = nullptr;
+            volatile INT_PTR hits = 0;
+            for (int i = 0; i < nOps; ++i) hits += map.Lookup(AsPtr(((i & 1023) + 1) * 16), value);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count()
+           / (static_cast<double>(nOps) * nThreads);
+}
+
+int main() {
+    // ---- Layout -------------------------------------------------------------
+    check("sizeof(CPtrArray)==40", sizeof(CPtrArray) == 40);
+    check("sizeof(CObList)==56", sizeof(CObList) == 56);
+    check("sizeof(CMapPtrToPtr)==56", sizeof(CMapPtrToPtr) == 56);
+
+    // ---- Storage lives in the object ----------------------------------------
+    {
+        CPtrArray array;
+        for (INT_PTR i = 0; i < 100; ++i) array.Add(AsPtr(i + 1));
+        check("array: m_nSize tracks Add", PtrArrayAccess::Size(array) == 100);
+        check("array: m_pData holds the elements", PtrArrayAccess::Data(array)[42] == AsPtr(43));
+        check("array: GetData is m_pData", array.GetData() == PtrArrayAccess::Data(array));
+        array.RemoveAt(0, 10);
+        check("array: RemoveAt shifts the tail", array.GetSize() == 90 && array.GetAt(0) == AsPtr(11));
+    }
+    {
+        CObList list;
+        check("list: starts empty", ObListAccess::Head(list) == nullptr && list.IsEmpty());
+        CObject* items[3] = { reinterpret_cast<CObject*>(0x10), reinterpret_cast<CObject*>(0x20),
+                              reinterpret_cast<CObject*>(0x30) };
+        for (CObject* item : items) list.AddTail(item);
+        check("list: nodes hang off m_pNodeHead", ObListAccess::Head(list) != nullptr && ObListAccess::Count(list) == 3);
+        check("list: order kept", list.GetHead() == items[0] && list.GetTail() == items[2]);
+    }
+    {
+        CMapPtrToPtr map;
+        for (INT_PTR i = 1; i <= 500; ++i) map.SetAt(AsPtr(i), AsPtr(i * 2));
+        void* value = nullptr;
+        check("map: buckets hang off m_pHashTable", MapAccess::Table(map) != nullptr);
+        check("map: Lookup finds every key", map.GetCount() == 500 && map.Lookup(AsPtr(250), value) && value == AsPtr(500));
+        check("map: RemoveKey", map.RemoveKey(AsPtr(250)) && !map.Lookup(AsPtr(250), value));
+    }
+
+    // ---- Serialize counts ---------------------------------------------------
+    {
+        CDWordArray small;
+        for (DWORD i = 0; i < 3; ++i) small.Add(i * 7);
+        const std::vector<BYTE> bytes = Store(small);
+        WORD wCount = 0;
+        std::memcpy(&wCount, bytes.data(), sizeof(wCount));
+        check("serialize: small count is one WORD", bytes.size() == 2 + 3 * 4 && wCount == 3);
+    }
+    {
+        const DWORD kBig = 70000;   // past 0xFFFF
+        CDWordArray big;
+        big.SetSize(kBig);
+        for (DWORD i = 0; i < kBig; ++i) big.SetAt(i, i ^ 0x5A5A5A5Au);
+        const std::vector<BYTE> bytes = Store(big);
+        WORD wEscape = 0;
+        DWORD dwCount = 0;
+        std::memcpy(&wEscape, bytes.data(), sizeof(wEscape));
+        std::memcpy(&dwCount, bytes.data() + 2, sizeof(dwCount));
+        check("serialize: large count is 0xFFFF + DWORD",
+              bytes.size() == 2 + 4 + kBig * 4 && wEscape == 0xFFFF && dwCount == kBig);
+
+        CDWordArray loaded;
+        Load(bytes, loaded);
+        bool same = loaded.GetSize() == static_cast<INT_PTR>(kBig);
+        for (DWORD i = 0; same && i < kBig; ++i) same = loaded.GetAt(i) == (i ^ 0x5A5A5A5Au);
+        check("serialize: large array round-trips", same);
+    }
+
+    // ---- Per-thread access cost ---------------------------------------------
+    const int kOps = 2000000;
+    const unsigned nThreads = std::thread::hardware_concurrency() > 1 ? 4 : 1;
+    const int nMany = static_cast<int>(nThreads);
+    const double arrayBefore[2] = { TimeArrayReads<side_table::PtrArray>(1, kOps),
+                                    TimeArrayReads<side_table::PtrArray>(nMany, kOps) };
+    const double arrayAfter[2] = { TimeArrayReads<CPtrArray>(1, kOps), TimeArrayReads<CPtrArray>(nMany, kOps) };
+    const double mapBefore[2] = { TimeMapLookups<side_table::MapPtrToPtr>(1, kOps),
+                                  TimeMapLookups<side_table::MapPtrToPtr>(nMany, kOps) };
+    const double mapAfter[2] = { TimeMapLookups<CMapPtrToPtr>(1, kOps), TimeMapLookups<CMapPtrToPtr>(nMany, kOps) };
+    std::printf("                      side table (before)       inline (after)\n");
+    std::printf("                      1 thread   %u threads      1 thread   %u threads\n", nThreads, nThreads);
+    std::printf("CPtrArray::GetAt:     %7.2f    %7.2f ns/op   %7.2f    %7.2f ns/op\n",
+                arrayBefore[0], arrayBefore[1], arrayAfter[0], arrayAfter[1]);
+    std::printf("CMapPtrToPtr::Lookup: %7.2f    %7.2f ns/op   %7.2f    %7.2f ns/op\n",
+                mapBefore[0], mapBefore[1], mapAfter[0], mapAfter[1]);
+    check("inline GetAt is cheaper than the side table", arrayAfter[0] < arrayBefore[0]);
+    check("inline Lookup is cheaper than the side table", mapAfter[0] < mapBefore[0]);
+
+    if (g_failures == 0) {
+        std::printf("ALL CHECKS PASSED\n");
+        return 0;
+    }
+    std::printf("%d CHECK(S) FAILED\n", g_failures);
+    return 1;
+}
@@ -0,0 +1,235 @@
+// Behavioral test for CCriticalSection::Lock(DWORD) / Unlock, driven through
+// the real synccore.cpp.
+//
+// Build:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static -DUNICODE -D_UNICODE -I include \
+//       tests/test_critsec_timed_lock_logic.cpp -o /tmp/test_critsec_timed_lock.exe
+//   WINEDEBUG=-all wine /tmp/test_critsec_timed_lock.exe; echo EXIT=$?
+//
+// The test checks:
+// - untimed Lock/Unlock never arms the timed-waiter flag, so Unlock stays
+//   a plain LeaveCriticalSection;
+// - Lock(0) on a held section fails at once, Lock(n) fails after about n ms;
+// - WaitOnAddress / WakeByAddressAll resolve from the already-loaded
+//   kernelbase.dll;
+// - a parked waiter is woken by Unlock, not by its timeout;
+// - a waiter whose holder leaves m_sect directly (as retail-inlined Unlock
+//   does) still gets in within a wait slice;
+// - timed lockers from 2 to 32 threads keep mutual exclusion, all make
+//   progress, and leave no waiter registered on any stripe.
+// The wake latency and the p50/p99 Lock(timeout) latency per thread count
+// are printed.
+
+#include "../phase4/src/synccore.cpp"
+
+// synccore.cpp's AfxBeginThread constructs a CWinThread; those members live
+// in appcore.cpp and are not reached here.
+CRuntimeClass CCmdTarget::classCCmdTarget{};
+CRuntimeClass CWnd::classCWnd{};
+CRuntimeClass CWinThread::classCWinThread{};
+CCmdTarget::~CCmdTarget() {}
+int CCmdTarget::OnCmdMsg(unsigned int, int, void*, void*) { return 0; }
+const AFX_MSGMAP* CCmdTarget::GetMessageMap() const { return nullptr; }
+CWinThread::CWinThread() {}
+CWinThread::~CWinThread() {}
+BOOL CWinThread::InitInstance() { return FALSE; }
+int CWinThread::ExitInstance() { return 0; }
+int CWinThread::Run() { return 0; }
+BOOL CWinThread::PreTranslateMessage(MSG*) { return FALSE; }
+BOOL CWinThread::OnIdle(LONG) { return FALSE; }
+BOOL CWinThread::IsIdleMessage(MSG*) { return FALSE; }
+BOOL CWinThread::PumpMessage() { return FALSE; }
+BOOL CWinThread::PrePumpMessage() { return FALSE; }
+BOOL CWinThread::PostPumpMessage() { return FALSE; }
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static int g_failures = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond) ++g_failures;
+}
+
+static double MsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static bool NoWaitersRegistered() {
+    for (const TimedLockStripe& stripe : g_timedLockStripes) {
+        if (stripe.nWaiters != 0) return false;
+    }
+    return true;
+}
+
+// Runs fn on another thread while that thread holds section.
+template <typename Fn>
+static void WhileHeldElsewhere(CCriticalSection& section, Fn fn) {
+    std::atomic<bool> bHeld{ false };
+    std::atomic<bool> bDone{ false };
+    std::thread holder([&] {
+        section.Lock();
+        bHeld = true;
+        while (!bDone) std::this_thread::yield();
+        section.Unlock();
+    });
+    while (!bHeld) std::this_thread::yield();
+    fn();
+    bDone = true;
+    holder.join();
+}
+
+int main() {
+    // ---- Untimed use never touches the stripes ------------------------------
+    {
+        CCriticalSection section;
+        for (int i = 0; i < 1000; ++i) {
+            section.Lock();
+            section.Unlock();
+        }
+        check("Lock(timeout) that gets in at once", section.Lock(100) == TRUE);
+        section.Unlock();
+        WhileHeldElsewhere(section, [&] {
+            check("Lock(0) on a held section fails", section.Lock(0) == FALSE);
+        });
+        check("no timed wait yet: waiter flag still clear", g_nTimedWaiterSeen == 0);
+        check("SetSpinCount returns the previous count",
+              (section.SetSpinCount(1234), section.SetSpinCount(0) == 1234));
+    }
+
+    // ---- Timeouts -----------------------------------------------------------
+    {
+        CCriticalSection section;
+        WhileHeldElsewhere(section, [&] {
+            const Clock::time_point start = Clock::now();
+            const BOOL bGot = section.Lock(100);
+            const double ms = MsSince(start);
+            check("Lock(100) on a section held throughout fails", bGot == FALSE);
+            check("and waits about 100 ms", ms >= 90 && ms < 1000);
+        });
+        check("a parked wait arms the waiter flag", g_nTimedWaiterSeen == 1);
+        check("the timed-out waiter is unregistered", NoWaitersRegistered());
+    }
+
+    const AddressWaitApi& api = GetAddressWaitApi();
+    check("WaitOnAddress / WakeByAddressAll resolved from kernelbase.dll",
+          api.pfnWait != nullptr && api.pfnWakeAll != nullptr);
+
+    // ---- Unlock wakes a parked waiter ---------------------------------------
+    {
+        CCriticalSection section;
+        std::vector<double> latencies;
+        bool bAllGot = true;
+        for (int trial = 0; trial < 20; ++trial) {
+            std::atomic<bool> bParked{ false };
+            Clock::time_point released;
+            section.Lock();
+            std::thread waiter([&] {
+                bParked = true;
+                const BOOL bGot = section.Lock(5000);
+                const double ms = MsSince(released);
+                bAllGot = bAllGot && bGot;
+                latencies.push_back(ms);
+                if (bGot) section.Unlock();
+            });
+            while (!bParked) std::this_thread::yield();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            released = Clock::now();
+            section.Unlock();
+            waiter.join();
+        }
+        std::sort(latencies.begin(), latencies.end());
+        check("a parked waiter gets the lock once it is released", bAllGot);
+        check("it is woken by Unlock, well before its 5 s timeout", latencies.back() < 1000);
+        std::printf("release-to-acquire latency: median %.3f ms, max %.3f ms\n",
+                    latencies[latencies.size() / 2], latencies.back());
+    }
+
+    // ---- A release that bypasses Unlock --------------------------------------
+    {
+        CCriticalSection section;
+        std::vector<double> latencies;
+        bool bAllGot = true;
+        for (int trial = 0; trial < 20; ++trial) {
+            std::atomic<bool> bParked{ false };
+            Clock::time_point released;
+            section.Lock();
+            std::thread waiter([&] {
+                bParked = true;
+                const BOOL bGot = section.Lock(5000);
+                bAllGot = bAllGot && bGot;
+                latencies.push_back(MsSince(released));
+                if (bGot) section.Unlock();
+            });
+            while (!bParked) std::this_thread::yield();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            released = Clock::now();
+            ::LeaveCriticalSection(&section.m_sect);
+            waiter.join();
+        }
+        std::sort(latencies.begin(), latencies.end());
+        check("a waiter sees a plain LeaveCriticalSection", bAllGot);
+        check("within a wait slice, not at its 5 s timeout", latencies.back() < 1000);
+        std::printf("LeaveCriticalSection-to-acquire latency: median %.3f ms, max %.3f ms\n",
+                    latencies[latencies.size() / 2], latencies.back());
+    }
+
+    // ---- Contention ---------------------------------------------------------
+    const int kThreadCounts[] = { 2, 4, 8, 16, 32 };
+    for (int nThreads : kThreadCounts) {
+        CCriticalSection section;
+        const Clock::time_point stop = Clock::now() + std::chrono::milliseconds(300);
+        long nInside = 0;
+        std::atomic<bool> bOverlap{ false };
+        std::vector<std::vector<double>> waits(nThreads);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < nThreads; ++t) {
+            threads.emplace_back([&, t] {
+                while (Clock::now() < stop) {
+                    const Clock::time_point start = Clock::now();
+                    if (!section.Lock(5000)) continue;
+                    waits[t].push_back(MsSince(start));
+                    if (++nInside != 1) bOverlap = true;
+                    std::this_thread::sleep_for(std::chrono::microseconds(20));
+                    --nInside;
+                    section.Unlock();
+                }
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+        std::vector<double> all;
+        size_t nMin = waits[0].size();
+        for (const std::vector<double>& w : waits) {
+            nMin = std::min(nMin, w.size());
+            all.insert(all.end(), w.begin(), w.end());
+        }
+        std::sort(all.begin(), all.end());
+        char name[80];
+        std::snprintf(name, sizeof(name), "%d threads: timed lockers keep mutual exclusion", nThreads);
+        check(name, !bOverlap);
+        std::snprintf(name, sizeof(name), "%d threads: every thread gets the lock", nThreads);
+        check(name, nMin > 0);
+        std::snprintf(name, sizeof(name), "%d threads: no waiter left registered", nThreads);
+        check(name, NoWaitersRegistered());
+        if (!all.empty()) {
+            std::printf("%2d threads, 300 ms: %zu acquisitions, Lock p50 %.3f ms, p99 %.3f ms, "
+                        "least-served thread %.2f of an even share\n",
+                        nThreads, all.size(), all[all.size() / 2], all[all.size() * 99 / 100],
+                        nMin * nThreads / static_cast<double>(all.size()));
+        }
+    }
+
+    if (g_failures == 0) {
+        std::printf("ALL CHECKS PASSED\n");
+        return 0;
+    }
+    std::printf("%d CHECK(S) FAILED\n", g_failures);
+    return 1;
+}
@@ -33,6 +33,12 @@ extern "C" CRuntimeClass* MS_ABI
 impl__GetThisClass_CFileException__SAPEAUCRuntimeClass__XZ() {
     return nullptr;
 }
+extern "C" void MS_ABI
+impl__AfxThrowArchiveException__YAXHPEB_W_Z(int, const wchar_t*) {
+}
+extern "C" void MS_ABI
+impl__AfxThrowMemoryException__YAXXZ() {
+}
 
 #include "../phase4/src/file_csharedfile.cpp"
 
@@ -44,7 +50,7 @@ static int g_failures = 0;
 // Test-side accessor to inspect CMemFile's protected bookkeeping members.
 struct TestAccessor : CSharedFile {
     static BYTE*& Buffer(CSharedFile* p)  { return static_cast<TestAccessor*>(p)->m_lpBuffer; }
-    static UINT&  BufSize(CSharedFile* p) { return static_cast<TestAccessor*>(p)->m_nBufferSize; }
+    static SIZE_T& BufSize(CSharedFile* p) { return static_cast<TestAccessor*>(p)->m_nBufferSize; }
 };
 
 static void check(const char* name, bool cond) {
@@ -65,7 +71,7 @@ extern "C" void          MS_ABI impl__SetHandle_CSharedFile__QEAAXPEAXH_Z(void*,
 
 int main() {
     // ---- Layout sanity ------------------------------------------------------
-    check("sizeof(CSharedFile)==72", sizeof(CSharedFile) == 72);
+    check("sizeof(CSharedFile)==104", sizeof(CSharedFile) == 104);
 
     // ---- 1. Construct via ctor thunk; placement into a raw buffer -----------
     alignas(CSharedFile) unsigned char storage[sizeof(CSharedFile)];
@@ -143,7 +149,7 @@ int main() {
     check("SetHandle: object adopted handle", obj->m_hGlobalMemory == hExt);
     check("SetHandle: m_lpBuffer locked non-null", TestAccessor::Buffer(obj) != nullptr);
     check("SetHandle: m_nBufferSize reflects GlobalSize",
-          TestAccessor::BufSize(obj) == static_cast<UINT>(GlobalSize(hExt)));
+          TestAccessor::BufSize(obj) == GlobalSize(hExt));
     bool extSeen = (TestAccessor::Buffer(obj) != nullptr);
     if (TestAccessor::Buffer(obj)) {
         for (SIZE_T i = 0; i < n3; ++i) {
@@ -0,0 +1,299 @@
+// Behavioral test for CSocket's blocking calls, driven through the real
+// sockcore.cpp over loopback.
+//
+// Build:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static -DUNICODE -D_UNICODE -I include \
+//       tests/test_csocket_blocking_logic.cpp -lws2_32 -o /tmp/test_csocket_blocking.exe
+//   WINEDEBUG=-all wine /tmp/test_csocket_blocking.exe; echo EXIT=$?
+//
+// A CSocket on the main thread talks to a plain blocking WinSock peer on a
+// helper thread. The test checks that:
+// - Accept, Connect, Receive and Send block until the peer acts, and the
+//   waiting thread sleeps rather than spins (thread CPU time is printed);
+// - a refused Connect fails with WSAECONNREFUSED;
+// - a Send larger than the socket buffers completes intact against a slow
+//   reader;
+// - OnMessagePending runs about every m_nTimeOut ms while nothing arrives;
+// - CancelBlockingCall makes the call fail with WSAEINTR, and a nested
+//   call fails with WSAEINPROGRESS;
+// - another socket's notifications wait in the aux queue until the
+//   blocking call returns.
+
+#include "../phase4/src/filecore.cpp"
+#include "../phase4/src/collections_cplex.cpp"
+#include "../phase4/src/global_file_dispatch.cpp"
+#include "../phase4/src/sockcore.cpp"
+
+// filecore.cpp's CArchive object/exception code references a handful of
+// symbols that live in other translation units and are not reached here.
+extern "C" CRuntimeClass* MS_ABI
+impl__Load_CRuntimeClass__SAPEAU1_AEAVCArchive__PEAI_Z(CArchive*, unsigned int*) {
+    return nullptr;
+}
+extern "C" void MS_ABI
+impl__Store_CRuntimeClass__QEBAXAEAVCArchive___Z(const CRuntimeClass*, CArchive*) {
+}
+extern "C" void MS_ABI
+impl__AfxThrowFileException__YAXHJPEB_W_Z(int, long, const wchar_t*) {
+}
+extern "C" CRuntimeClass* MS_ABI
+impl__GetThisClass_CFileException__SAPEAUCRuntimeClass__XZ() {
+    return nullptr;
+}
+extern "C" void MS_ABI
+impl__AfxThrowArchiveException__YAXHPEB_W_Z(int, const wchar_t*) {
+}
+extern "C" void MS_ABI
+impl__AfxThrowMemoryException__YAXXZ() {
+}
+
+// afxwin.h's inline CWnd / CCmdTarget members reference these; they live
+// in appcore.cpp and wincore.cpp.
+CRuntimeClass CCmdTarget::classCCmdTarget{};
+CRuntimeClass CWnd::classCWnd{};
+CCmdTarget::~CCmdTarget() {}
+int CCmdTarget::OnCmdMsg(unsigned int, int, void*, void*) { return 0; }
+const AFX_MSGMAP* CCmdTarget::GetMessageMap() const { return nullptr; }
+const AFX_MSGMAP* PASCAL CWnd::GetThisMessageMap() { return nullptr; }
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static int g_failures = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond) ++g_failures;
+}
+
+static double MsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// CPU time (user + kernel) the calling thread has used, in ms.
+static double ThreadCpuMs() {
+    FILETIME ftCreate, ftExit, ftKernel, ftUser;
+    ::GetThreadTimes(::GetCurrentThread(), &ftCreate, &ftExit, &ftKernel, &ftUser);
+    const ULONGLONG n = ((ULONGLONG)ftKernel.dwHighDateTime << 32 | ftKernel.dwLowDateTime) +
+                        ((ULONGLONG)ftUser.dwHighDateTime << 32 | ftUser.dwLowDateTime);
+    return n / 10000.0;
+}
+
+static void SleepFor(std::chrono::milliseconds ms) {
+    std::this_thread::sleep_for(ms);
+}
+
+static sockaddr_in Loopback(UINT nPort) {
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((u_short)nPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+// A plain blocking peer socket connected to nPort.
+static SOCKET ConnectPeer(UINT nPort) {
+    SOCKET s = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = Loopback(nPort);
+    ::connect(s, (const sockaddr*)&addr, sizeof(addr));
+    return s;
+}
+
+static UINT PortOf(CAsyncSocket& socket) {
+    CString address;
+    UINT nPort = 0;
+    socket.GetSockName(address, nPort);
+    return nPort;
+}
+
+// A CSocket whose OnMessagePending runs a test hook.
+class HookedSocket : public CSocket {
+public:
+    void SetTimeOut(int nMs) { m_nTimeOut = nMs; }
+    std::function<void(HookedSocket&)> m_hook;
+    int m_nPending = 0;
+
+protected:
+    int OnMessagePending() override {
+        ++m_nPending;
+        if (m_hook) m_hook(*this);
+        return CSocket::OnMessagePending();
+    }
+};
+
+class CountingSocket : public CAsyncSocket {
+public:
+    void OnReceive(int) override { ++m_nReceive; }
+    int m_nReceive = 0;
+};
+
+int main() {
+    HookedSocket listener;
+    check("listener created", listener.Create(0, SOCK_STREAM, FD_ACCEPT, L"127.0.0.1") && listener.Listen());
+    const UINT nPort = PortOf(listener);
+
+    // ---- Accept blocks until the peer connects -------------------------------
+    SOCKET hPeer = INVALID_SOCKET;
+    HookedSocket conn;
+    {
+        std::thread peer([&] {
+            SleepFor(std::chrono::milliseconds(150));
+            hPeer = ConnectPeer(nPort);
+        });
+        const Clock::time_point start = Clock::now();
+        const BOOL bAccepted = listener.Accept(conn);
+        const double ms = MsSince(start);
+        peer.join();
+        check("Accept waits for the connection", bAccepted && ms >= 100);
+    }
+
+    // ---- Receive blocks, asleep ---------------------------------------------
+    {
+        std::thread peer([&] {
+            SleepFor(std::chrono::milliseconds(300));
+            ::send(hPeer, "hello", 5, 0);
+        });
+        char buf[16] = {};
+        const Clock::time_point start = Clock::now();
+        const double cpuStart = ThreadCpuMs();
+        const int n = conn.Receive(buf, sizeof(buf));
+        const double cpuMs = ThreadCpuMs() - cpuStart;
+        const double ms = MsSince(start);
+        peer.join();
+        check("Receive waits for the data", n == 5 && std::memcmp(buf, "hello", 5) == 0 && ms >= 250);
+        check("the wait sleeps rather than spins", cpuMs < ms / 4);
+        std::printf("Receive blocked %.0f ms using %.1f ms of CPU\n", ms, cpuMs);
+    }
+
+    // ---- Send larger than the socket buffers, slow reader -------------------
+    {
+        const size_t kBytes = 16u * 1024 * 1024;
+        std::vector<char> data(kBytes);
+        for (size_t i = 0; i < kBytes; ++i) data[i] = static_cast<char>(i * 31 + (i >> 16));
+        std::atomic<bool> bIntact{ true };
+        size_t nReceived = 0;
+        std::thread peer([&] {
+            std::vector<char> buf(64 * 1024);
+            while (nReceived < kBytes) {
+                int n = ::recv(hPeer, buf.data(), (int)buf.size(), 0);
+                if (n <= 0) break;
+                if (std::memcmp(buf.data(), data.data() + nReceived, (size_t)n) != 0) bIntact = false;
+                nReceived += (size_t)n;
+                SleepFor(std::chrono::milliseconds(1));
+            }
+        });
+        const Clock::time_point start = Clock::now();
+        const double cpuStart = ThreadCpuMs();
+        const int nSent = conn.Send(data.data(), (int)kBytes);
+        const double cpuMs = ThreadCpuMs() - cpuStart;
+        const double ms = MsSince(start);
+        peer.join();
+        check("blocking Send of 16 MB completes", nSent == (int)kBytes && nReceived == kBytes && bIntact);
+        std::printf("Send of 16 MB to a paced reader: %.0f ms, %.1f ms of sender CPU\n", ms, cpuMs);
+    }
+
+    // ---- OnMessagePending cadence -------------------------------------------
+    {
+        conn.SetTimeOut(50);
+        conn.m_nPending = 0;
+        std::thread peer([&] {
+            SleepFor(std::chrono::milliseconds(500));
+            ::send(hPeer, "x", 1, 0);
+        });
+        char ch = 0;
+        const int n = conn.Receive(&ch, 1);
+        peer.join();
+        check("Receive still returns the byte", n == 1 && ch == 'x');
+        check("OnMessagePending runs about every m_nTimeOut ms", conn.m_nPending >= 5 && conn.m_nPending <= 30);
+        std::printf("OnMessagePending calls over 500 ms at m_nTimeOut 50: %d\n", conn.m_nPending);
+    }
+
+    // ---- CancelBlockingCall and nested calls --------------------------------
+    {
+        int nNestedError = 0;
+        bool bBlockingSeen = false;
+        conn.m_nPending = 0;
+        conn.m_hook = [&](HookedSocket& s) {
+            bBlockingSeen = bBlockingSeen || s.IsBlocking();
+            char ch;
+            if (s.Receive(&ch, 1) == SOCKET_ERROR) nNestedError = ::WSAGetLastError();
+            if (s.m_nPending >= 3) s.CancelBlockingCall();
+        };
+        char ch = 0;
+        const int n = conn.Receive(&ch, 1);
+        const int nError = ::WSAGetLastError();
+        conn.m_hook = nullptr;
+        check("IsBlocking during the call", bBlockingSeen);
+        check("nested call fails with WSAEINPROGRESS", nNestedError == WSAEINPROGRESS);
+        check("CancelBlockingCall fails the call with WSAEINTR", n == SOCKET_ERROR && nError == WSAEINTR);
+        check("not blocking afterwards", !conn.IsBlocking());
+    }
+
+    // ---- Other sockets' notifications wait for the call ---------------------
+    {
+        CountingSocket other;
+        other.Create(0, SOCK_STREAM, FD_READ);
+        other.Connect(L"127.0.0.1", nPort);
+        HookedSocket otherServer;
+        listener.Accept(otherServer);
+        otherServer.Send("ping", 4);
+
+        int nDuringCall = -1;
+        conn.m_hook = [&](HookedSocket&) { nDuringCall = other.m_nReceive; };
+        std::thread peer([&] {
+            SleepFor(std::chrono::milliseconds(300));
+            ::send(hPeer, "y", 1, 0);
+        });
+        char ch = 0;
+        conn.Receive(&ch, 1);
+        peer.join();
+        conn.m_hook = nullptr;
+        check("no OnReceive for another socket during the call", nDuringCall == 0);
+        const Clock::time_point deadline = Clock::now() + std::chrono::seconds(5);
+        MSG msg;
+        while (other.m_nReceive == 0 && Clock::now() < deadline) {
+            while (::PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) ::DispatchMessageW(&msg);
+            ::MsgWaitForMultipleObjectsEx(0, nullptr, 10, QS_ALLINPUT, 0);
+        }
+        check("it is delivered once the call returns", other.m_nReceive >= 1);
+    }
+
+    // ---- Connect ------------------------------------------------------------
+    {
+        SOCKET hPeerListen = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = Loopback(0);
+        ::bind(hPeerListen, (const sockaddr*)&addr, sizeof(addr));
+        ::listen(hPeerListen, 1);
+        int nLen = sizeof(addr);
+        ::getsockname(hPeerListen, (sockaddr*)&addr, &nLen);
+        const UINT nPeerPort = ntohs(addr.sin_port);
+
+        CSocket client;
+        client.Create();
+        check("blocking Connect succeeds", client.Connect(L"127.0.0.1", nPeerPort) == TRUE);
+        SOCKET hAccepted = ::accept(hPeerListen, nullptr, nullptr);
+        ::closesocket(hAccepted);
+        ::closesocket(hPeerListen);
+
+        CSocket refused;
+        refused.Create();
+        const BOOL bConnected = refused.Connect(L"127.0.0.1", nPeerPort);
+        check("Connect to a closed port fails with WSAECONNREFUSED",
+              !bConnected && ::WSAGetLastError() == WSAECONNREFUSED);
+    }
+
+    ::closesocket(hPeer);
+
+    if (g_failures == 0) {
+        std::printf("ALL CHECKS PASSED\n");
+        return 0;
+    }
+    std::printf("%d CHECK(S) FAILED\n", g_failures);
+    return 1;
+}
@@ -3,6 +3,8 @@
 
 #include <openmfc/afxstr.h>
 #include <cstdio>
+#include <thread>
+#include <vector>
 
 #define TEST(name) void test_##name()
 #define ASSERT(cond) do { if (!(cond)) { std::fprintf(stderr, "FAIL: %s at %d\n", #cond, __LINE__); failed++; } else { passed++; } } while(0)
@@ -204,6 +206,56 @@ TEST(span) {
     ASSERT(alpha == L"abc");
 }
 
+TEST(string_mgr) {
+    IAtlStringMgr* pMgr = OpenMFC_GetStringMgr();
+
+    // nAllocLength reports the requested capacity, not the size class.
+    CStringData* p = pMgr->Allocate(10, sizeof(wchar_t));
+    ASSERT(p != nullptr && p->nAllocLength == 10 && p->nRefs == 1 && p->pStringMgr == pMgr);
+
+    // Growing within the block's class keeps the buffer.
+    wcscpy(p->data(), L"abc");
+    p->nDataLength = 3;
+    CStringData* q = pMgr->Reallocate(p, 15, sizeof(wchar_t));
+    ASSERT(q == p && q->nAllocLength == 15);
+
+    // Growing past it (and on into malloc territory) keeps the contents.
+    q = pMgr->Reallocate(q, 200, sizeof(wchar_t));
+    ASSERT(q != nullptr && q->nAllocLength == 200 && q->nDataLength == 3 && wcscmp(q->data(), L"abc") == 0);
+    q = pMgr->Reallocate(q, 5000, sizeof(wchar_t));
+    ASSERT(q != nullptr && q->nAllocLength == 5000 && wcscmp(q->data(), L"abc") == 0);
+    q = pMgr->Reallocate(q, 9000, sizeof(wchar_t));
+    ASSERT(q != nullptr && wcscmp(q->data(), L"abc") == 0);
+    pMgr->Free(q);
+
+    // A freed small block is handed out again by the same thread.
+    CStringData* a = pMgr->Allocate(20, sizeof(wchar_t));
+    pMgr->Free(a);
+    CStringData* b = pMgr->Allocate(20, sizeof(wchar_t));
+    ASSERT(a == b);
+    pMgr->Free(b);
+}
+
+TEST(shared_across_threads) {
+    // Copies of one buffer taken and dropped concurrently must leave exactly
+    // the original reference behind.
+    CString shared(L"shared between threads");
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&shared] {
+            for (int i = 0; i < 20000; ++i) {
+                CString copy(shared);
+                CString other;
+                other = copy;
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    ASSERT(shared == L"shared between threads");
+    const CStringData* pData = reinterpret_cast<const CStringData*>(shared.GetString()) - 1;
+    ASSERT(pData->nRefs == 1);
+}
+
 int main() {
     std::printf("Running CString tests...\n");
 
@@ -223,6 +275,8 @@ int main() {
     test_delete_insert();
     test_reverse();
     test_span();
+    test_string_mgr();
+    test_shared_across_threads();
 
     std::printf("Results: %d passed, %d failed\n", passed, failed);
     return failed > 0 ? 1 : 0;
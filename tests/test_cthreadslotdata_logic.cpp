@@ -1,10 +1,29 @@
 // Behavioral test for CThreadSlotData. Drives the real exported impl_
 // functions and asserts concrete outcomes around TLS-backed slot storage.
 #include <cstdio>
+#include <thread>
+#include <vector>
 #include "../phase4/src/global_cthreadslotdata.cpp"
 
 static int g_fail = 0;
 
+// Stand-in for a CNoTrackObject: slot 0 of its vtable is the MSVC deleting
+// destructor, which the slot table calls when it deletes a value. Deletes
+// are only counted so the objects can live on the stack.
+struct FakeValue {
+    void** vtbl;
+    int    nDeleted;
+};
+
+static void* MS_ABI FakeDeletingDtor(void* p, unsigned) {
+    ++static_cast<FakeValue*>(p)->nDeleted;
+    return p;
+}
+
+static void* g_fakeVtbl[1] = { (void*)&FakeDeletingDtor };
+
+static FakeValue MakeValue() { return FakeValue{ g_fakeVtbl, 0 }; }
+
 static void check(const char* name, bool cond) {
     printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
     if (!cond)
@@ -29,7 +48,7 @@ int main() {
     check("AllocSlot increasing", s2 > s1 && s3 > s2);
 
     // SetValue / GetThreadValue round-trip on this thread.
-    int v1 = 111, v2 = 222, v3 = 333;
+    FakeValue v1 = MakeValue(), v2 = MakeValue(), v3 = MakeValue();
     impl__SetValue_CThreadSlotData__QEAAXHPEAX_Z(&d, s1, &v1);
     impl__SetValue_CThreadSlotData__QEAAXHPEAX_Z(&d, s2, &v2);
     impl__SetValue_CThreadSlotData__QEAAXHPEAX_Z(&d, s3, &v3);
@@ -41,13 +60,14 @@ int main() {
     check("thread node linked", d.m_list.m_pHead != nullptr);
 
     // Overwrite a value.
-    int v1b = 999;
+    FakeValue v1b = MakeValue();
     impl__SetValue_CThreadSlotData__QEAAXHPEAX_Z(&d, s1, &v1b);
     check("overwrite value", d.GetThreadValue(s1) == &v1b);
 
     // FreeSlot clears the per-thread value.
     impl__FreeSlot_CThreadSlotData__QEAAXH_Z(&d, s2);
     check("FreeSlot clears value", d.GetThreadValue(s2) == nullptr);
+    check("FreeSlot deletes value", v2.nDeleted == 1);
     check("FreeSlot leaves others", d.GetThreadValue(s1) == &v1b &&
                                      d.GetThreadValue(s3) == &v3);
 
@@ -65,6 +85,8 @@ int main() {
     impl__DeleteValues_CThreadSlotData__QEAAXPEAUHINSTANCE____H_Z(&d, hMod, 1);
     check("DeleteValues(hInst) cleared tagged",
           d.GetThreadValue(s1) == nullptr && d.GetThreadValue(s3) == nullptr);
+    check("DeleteValues(hInst) deleted each value once",
+          v1b.nDeleted == 1 && v3.nDeleted == 1 && v2.nDeleted == 2 && v1.nDeleted == 0);
 
     // DeleteValues with null hInst (current thread) clears everything.
     impl__SetValue_CThreadSlotData__QEAAXHPEAX_Z(&d, s1, &v1);
@@ -80,14 +102,88 @@ int main() {
     HINSTANCE hMod2 = (HINSTANCE)0x5678;
     int s5 = impl__AllocSlot_CThreadSlotData__QEAAHXZ(&d);
     impl__AssignInstance_CThreadSlotData__QEAAXPEAUHINSTANCE_____Z(&d, hMod2);
-    int vx = 4242;
+    FakeValue vx = MakeValue();
     impl__SetValue_CThreadSlotData__QEAAXHPEAX_Z(&d, s5, &vx);
     // Delete values for hMod (the first module): s5 belongs to hMod2, survives.
     impl__DeleteValues_CThreadSlotData__QEAAXPEAUHINSTANCE____H_Z(&d, hMod, 1);
-    check("DeleteValues scoping spares other module", d.GetThreadValue(s5) == &vx);
+    check("DeleteValues scoping spares other module", d.GetThreadValue(s5) == &vx && vx.nDeleted == 0);
     // Now delete for hMod2: s5 must clear.
     impl__DeleteValues_CThreadSlotData__QEAAXPEAUHINSTANCE____H_Z(&d, hMod2, 1);
-    check("DeleteValues clears own module", d.GetThreadValue(s5) == nullptr);
+    check("DeleteValues clears own module", d.GetThreadValue(s5) == nullptr && vx.nDeleted == 1);
+
+    // Values are per thread: workers set the same slot concurrently (the
+    // unlocked fast path) and each reads back only its own value.
+    {
+        const int kThreads = 8;
+        FakeValue vals[kThreads];
+        for (FakeValue& v : vals) v = MakeValue();
+        bool ok[kThreads] = {};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < kThreads; ++t) {
+            workers.emplace_back([&, t] {
+                bool good = d.GetThreadValue(s1) == nullptr;
+                for (int i = 0; i < 1000; ++i) {
+                    impl__SetValue_CThreadSlotData__QEAAXHPEAX_Z(&d, s1, &vals[t]);
+                    good = good && d.GetThreadValue(s1) == &vals[t];
+                }
+                // Thread-exit teardown: clearing its own values frees its node.
+                impl__DeleteValues_CThreadSlotData__QEAAXPEAUHINSTANCE____H_Z(&d, nullptr, 0);
+                ok[t] = good && TlsGetValue(d.m_tlsIndex) == nullptr;
+            });
+        }
+        for (auto& w : workers) w.join();
+        bool all = true;
+        for (int t = 0; t < kThreads; ++t) all = all && ok[t];
+        check("per-thread values isolated", all);
+        for (int t = 0; t < kThreads; ++t) all = all && vals[t].nDeleted == 1;
+        check("thread teardown deletes its value once", all);
+        int nodes = 0;
+        for (void* p = d.m_list.m_pHead; p != nullptr; p = *(void**)p) ++nodes;
+        check("exited threads left no nodes", nodes <= 1);
+    }
+
+    // A slot past the thread's current array grows it to cover every
+    // allocated slot at once.
+    {
+        int last = 0;
+        for (int i = 0; i < 20; ++i)
+            last = impl__AllocSlot_CThreadSlotData__QEAAHXZ(&d);
+        impl__SetValue_CThreadSlotData__QEAAXHPEAX_Z(&d, last - 10, &v1);
+        CThreadData* pOwn = (CThreadData*)TlsGetValue(d.m_tlsIndex);
+        check("grow covers allocated slots", pOwn != nullptr && pOwn->nCount >= d.m_nMax);
+        void** pArray = pOwn ? pOwn->pData : nullptr;
+        impl__SetValue_CThreadSlotData__QEAAXHPEAX_Z(&d, last, &v2);
+        check("highest slot round-trip", d.GetThreadValue(last) == &v2);
+        check("no realloc for a covered slot", pOwn != nullptr && pOwn->pData == pArray);
+    }
+
+    // FreeSlot with a destroy callback hands every thread's value over once.
+    {
+        static int destroyed = 0;
+        int sd = impl__AllocSlot_CThreadSlotData__QEAAHXZ(&d);
+        FakeValue va = MakeValue(), vb = MakeValue();
+        impl__SetValue_CThreadSlotData__QEAAXHPEAX_Z(&d, sd, &va);
+        std::thread other([&] { impl__SetValue_CThreadSlotData__QEAAXHPEAX_Z(&d, sd, &vb); });
+        other.join();
+        OpenMfcFreeThreadSlot(&d, sd, [](void*) { ++destroyed; });
+        check("FreeSlot destroys each thread's value", destroyed == 2);
+        check("FreeSlot with destroy clears value", d.GetThreadValue(sd) == nullptr);
+    }
+
+    // Threads that exit without calling DeleteValues: the process-wide
+    // instance's thread-detach hook deletes their values and frees their
+    // nodes, as AfxTermThread does in MFC.
+    {
+        CThreadSlotData* pProcess = OpenMfcGetThreadSlotData();
+        int sp = impl__AllocSlot_CThreadSlotData__QEAAHXZ(pProcess);
+        FakeValue vt = MakeValue();
+        std::thread worker([&] { impl__SetValue_CThreadSlotData__QEAAXHPEAX_Z(pProcess, sp, &vt); });
+        worker.join();
+        check("thread exit deletes bound value", vt.nDeleted == 1);
+        check("thread exit frees its node", pProcess->m_list.m_pHead == nullptr);
+        impl__FreeSlot_CThreadSlotData__QEAAXH_Z(pProcess, sp);
+        check("freed slot does not delete again", vt.nDeleted == 1);
+    }
 
     // NULL-guard: must not crash.
     impl__AllocSlot_CThreadSlotData__QEAAHXZ(nullptr);
@@ -95,7 +191,10 @@ int main() {
     impl__FreeSlot_CThreadSlotData__QEAAXH_Z(nullptr, 1);
     check("null-guards survived", true);
 
+    FakeValue vlast = MakeValue();
+    impl__SetValue_CThreadSlotData__QEAAXHPEAX_Z(&d, s1, &vlast);
     impl___1CThreadSlotData__QEAA_XZ(&d);
+    check("dtor: deletes remaining values", vlast.nDeleted == 1);
     check("dtor: list emptied", d.m_list.m_pHead == nullptr);
     check("dtor: tls freed", d.m_tlsIndex == TLS_OUT_OF_INDEXES);
 
@@ -0,0 +1,275 @@
+// Behavioral test for COleDispatchDriver::InvokeHelperV argument passing and
+// the GetDispID cache, both inline in afxdisp.h.
+//
+// Build:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static -DUNICODE -D_UNICODE -I include \
+//       tests/test_dispatch_driver_logic.cpp -loleaut32 -lole32 -luuid -o /tmp/test_dispatch_driver.exe
+//   WINEDEBUG=-all wine /tmp/test_dispatch_driver.exe; echo EXIT=$?
+//
+// A fake IDispatch resolves 64 member names case-insensitively and folds
+// each call's arguments into its result in the order it receives them. The
+// test checks that:
+// - InvokeHelper passes arguments last to first, with 2 arguments (stack
+//   array) and with 20 (spilled to the heap);
+// - a 2-argument call makes no heap allocation and a 20-argument call one;
+// - GetDispID calls GetIDsOfNames once per name, per driver, and a cached
+//   by-name call makes no heap allocation;
+// - an unknown name throws and is not cached;
+// - FlushDispIDCache, ReleaseDispatch, AttachDispatch and DetachDispatch
+//   drop the cache, so a new dispatch's DISPIDs are never answered from the
+//   old one's;
+// - destroyed drivers leave no cache behind.
+// By-name calls per second, with and without the cache, are printed.
+
+#include "openmfc/afxdisp.h"
+
+// afxdisp.h's inline members throw through these; they live in
+// mfc_exceptions.cpp. Here the HRESULT itself is thrown.
+void AFXAPI AfxThrowOleException(LONG sc) {
+    throw sc;
+}
+void AFXAPI AfxThrowOleDispatchException(WORD, const wchar_t*, UINT) {
+    throw static_cast<LONG>(DISP_E_EXCEPTION);
+}
+
+// afxwin.h's inline CWnd / CWinApp members reference these; they live in
+// appcore.cpp and wincore.cpp.
+CRuntimeClass CCmdTarget::classCCmdTarget{};
+CRuntimeClass CWinThread::classCWinThread{};
+CRuntimeClass CWinApp::classCWinApp{};
+CRuntimeClass CWnd::classCWnd{};
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cwctype>
+#include <new>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static std::atomic<unsigned long> g_nNews{0};
+
+void* operator new(size_t n) {
+    g_nNews.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+static int g_failures = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond) ++g_failures;
+}
+
+// "Sum" is DISPID nBase and "Member<i>" nBase + i. Every member returns its
+// arguments folded in the order Invoke receives them.
+class FakeDispatch : public IDispatch {
+public:
+    explicit FakeDispatch(DISPID nBase) : m_nBase(nBase) {
+        m_names.push_back(L"Sum");
+        for (int i = 1; i < 64; ++i)
+            m_names.push_back(L"Member" + std::to_wstring(i));
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override {
+        if (!ppvObject)
+            return E_POINTER;
+        *ppvObject = nullptr;
+        if (riid == IID_IUnknown || riid == IID_IDispatch) {
+            *ppvObject = static_cast<IDispatch*>(this);
+            return S_OK;
+        }
+        return E_NOINTERFACE;
+    }
+    // Lives on the test's stack; drivers attach with bAutoRelease FALSE.
+    ULONG STDMETHODCALLTYPE AddRef() override { return 1; }
+    ULONG STDMETHODCALLTYPE Release() override { return 1; }
+
+    HRESULT STDMETHODCALLTYPE GetTypeInfoCount(UINT* pctinfo) override {
+        if (!pctinfo)
+            return E_POINTER;
+        *pctinfo = 0;
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE GetTypeInfo(UINT, LCID, ITypeInfo**) override { return E_NOTIMPL; }
+
+    HRESULT STDMETHODCALLTYPE GetIDsOfNames(REFIID, LPOLESTR* rgszNames, UINT cNames, LCID,
+                                            DISPID* rgDispId) override {
+        ++m_nGetIDsOfNames;
+        for (UINT n = 0; n < cNames; ++n) {
+            rgDispId[n] = DISPID_UNKNOWN;
+            for (size_t i = 0; i < m_names.size(); ++i) {
+                if (EqualNoCase(m_names[i].c_str(), rgszNames[n]))
+                    rgDispId[n] = m_nBase + static_cast<DISPID>(i);
+            }
+            if (rgDispId[n] == DISPID_UNKNOWN)
+                return DISP_E_UNKNOWNNAME;
+        }
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE Invoke(DISPID dispid, REFIID, LCID, WORD, DISPPARAMS* pParams,
+                                     VARIANT* pResult, EXCEPINFO*, UINT*) override {
+        if (dispid < m_nBase || dispid >= m_nBase + static_cast<DISPID>(m_names.size()))
+            return DISP_E_MEMBERNOTFOUND;
+        LONG folded = 0;
+        for (UINT i = 0; i < pParams->cArgs; ++i)
+            folded = folded * 3 + pParams->rgvarg[i].lVal;
+        if (pResult) {
+            pResult->vt = VT_I4;
+            pResult->lVal = folded;
+        }
+        return S_OK;
+    }
+
+    unsigned long m_nGetIDsOfNames = 0;
+
+private:
+    static bool EqualNoCase(const wchar_t* a, const wchar_t* b) {
+        for (; *a && *b; ++a, ++b) {
+            if (std::towlower(*a) != std::towlower(*b))
+                return false;
+        }
+        return *a == *b;
+    }
+
+    DISPID m_nBase;
+    std::vector<std::wstring> m_names;
+};
+
+static const BYTE kTwoArgs[] = { VT_I4, VT_I4, 0 };
+static const BYTE kTwentyArgs[] = { VT_I4, VT_I4, VT_I4, VT_I4, VT_I4, VT_I4, VT_I4, VT_I4, VT_I4, VT_I4,
+                                    VT_I4, VT_I4, VT_I4, VT_I4, VT_I4, VT_I4, VT_I4, VT_I4, VT_I4, VT_I4, 0 };
+
+static LONG CallTwenty(COleDispatchDriver& driver, DISPID dispid, LONG first) {
+    LONG result = 0;
+    driver.InvokeHelper(dispid, DISPATCH_METHOD, VT_I4, &result, kTwentyArgs, first, 2L, 3L, 4L, 5L, 6L,
+                        7L, 8L, 9L, 10L, 11L, 12L, 13L, 14L, 15L, 16L, 17L, 18L, 19L, 20L);
+    return result;
+}
+
+static size_t CacheCount() {
+    return openmfc_dispcache::GetRegistry().caches.size();
+}
+
+int main() {
+    FakeDispatch dispatch(1);
+    FakeDispatch other(1001);
+
+    // ---- Arguments -----------------------------------------------------------
+    {
+        COleDispatchDriver driver(&dispatch, FALSE);
+        LONG result = 0;
+        unsigned long news = g_nNews.load();
+        driver.InvokeHelper(1, DISPATCH_METHOD, VT_I4, &result, kTwoArgs, 10L, 32L);
+        check("two arguments reach Invoke last to first", result == 32 * 3 + 10);
+        check("a two-argument call makes no heap allocation", g_nNews.load() == news);
+
+        LONG expected = 0;
+        for (LONG i = 20; i >= 1; --i)
+            expected = expected * 3 + i;
+        news = g_nNews.load();
+        result = CallTwenty(driver, 1, 1L);
+        check("twenty (spilled) arguments reach Invoke last to first", result == expected);
+        check("a twenty-argument call allocates once", g_nNews.load() == news + 1);
+    }
+
+    // ---- GetDispID -----------------------------------------------------------
+    const long kCalls = 200000;
+    {
+        COleDispatchDriver driver(&dispatch, FALSE);
+        unsigned long lookups = dispatch.m_nGetIDsOfNames;
+        check("GetDispID returns the dispatch's DISPIDs",
+              driver.GetDispID(L"Sum") == 1 && driver.GetDispID(L"Member63") == 64);
+        check("a second GetDispID is answered from the cache",
+              driver.GetDispID(L"Sum") == 1 && driver.GetDispID(L"Member63") == 64 &&
+              dispatch.m_nGetIDsOfNames == lookups + 2);
+        driver.GetDispID(L"sum");
+        check("names are cached as spelled", dispatch.m_nGetIDsOfNames == lookups + 3);
+
+        LONG hr = 0;
+        try {
+            driver.GetDispID(L"NoSuchMember");
+        } catch (LONG sc) {
+            hr = sc;
+        }
+        lookups = dispatch.m_nGetIDsOfNames;
+        try {
+            driver.GetDispID(L"NoSuchMember");
+        } catch (LONG) {
+        }
+        check("an unknown name throws and is not cached",
+              hr == DISP_E_UNKNOWNNAME && dispatch.m_nGetIDsOfNames == lookups + 1);
+
+        COleDispatchDriver second(&dispatch, FALSE);
+        lookups = dispatch.m_nGetIDsOfNames;
+        second.GetDispID(L"Sum");
+        check("each driver has its own cache", dispatch.m_nGetIDsOfNames == lookups + 1);
+
+        // By name: GetIDsOfNames each call, then through the cache.
+        volatile LONG sink = 0;
+        Clock::time_point start = Clock::now();
+        for (long i = 0; i < kCalls; ++i) {
+            LPOLESTR name = const_cast<LPOLESTR>((i & 1) ? L"Sum" : L"Member63");
+            DISPID dispid = DISPID_UNKNOWN;
+            dispatch.GetIDsOfNames(IID_NULL, &name, 1, LOCALE_USER_DEFAULT, &dispid);
+            LONG result = 0;
+            driver.InvokeHelper(dispid, DISPATCH_METHOD, VT_I4, &result, kTwoArgs, i, 7L);
+            sink = result;
+        }
+        const double uncachedSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        lookups = dispatch.m_nGetIDsOfNames;
+        const unsigned long news = g_nNews.load();
+        start = Clock::now();
+        for (long i = 0; i < kCalls; ++i) {
+            LONG result = 0;
+            driver.InvokeHelper(driver.GetDispID((i & 1) ? L"Sum" : L"Member63"), DISPATCH_METHOD, VT_I4,
+                                &result, kTwoArgs, i, 7L);
+            sink = result;
+        }
+        const double cachedSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        check("cached by-name calls never reach GetIDsOfNames", dispatch.m_nGetIDsOfNames == lookups);
+        check("cached by-name calls make no heap allocation", g_nNews.load() == news);
+        std::printf("by name: %.0f calls/s with GetIDsOfNames each call, %.0f calls/s through GetDispID\n",
+                    kCalls / uncachedSeconds, kCalls / cachedSeconds);
+    }
+    check("destroyed drivers leave no cache", CacheCount() == 0);
+
+    // ---- Dropping the cache --------------------------------------------------
+    {
+        COleDispatchDriver driver(&dispatch, FALSE);
+        driver.GetDispID(L"Member1");
+        unsigned long lookups = dispatch.m_nGetIDsOfNames;
+        driver.FlushDispIDCache();
+        driver.GetDispID(L"Member1");
+        check("FlushDispIDCache drops the cache", dispatch.m_nGetIDsOfNames == lookups + 1);
+
+        driver.AttachDispatch(&other, FALSE);
+        check("AttachDispatch drops the old dispatch's DISPIDs", driver.GetDispID(L"Member1") == 1002);
+
+        driver.ReleaseDispatch();
+        check("ReleaseDispatch drops the cache", CacheCount() == 0);
+
+        driver.AttachDispatch(&dispatch, FALSE);
+        driver.GetDispID(L"Member1");
+        driver.DetachDispatch();
+        check("DetachDispatch drops the cache", CacheCount() == 0);
+        driver.AttachDispatch(&other, FALSE);
+        check("a reattached driver resolves against its new dispatch", driver.GetDispID(L"Member1") == 1002);
+    }
+    check("no caches left behind", CacheCount() == 0);
+
+    if (g_failures == 0) {
+        std::printf("ALL CHECKS PASSED\n");
+        return 0;
+    }
+    std::printf("%d CHECK(S) FAILED\n", g_failures);
+    return 1;
+}
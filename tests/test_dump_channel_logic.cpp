@@ -0,0 +1,222 @@
+// Syscall-count test for the buffered dump channel behind AfxDump and
+// CDumpContext(nullptr), driven through the real global_cdumpcontext.cpp and
+// memcore.cpp.
+//
+// CDumpContext(nullptr) and AfxDump used to send every fragment straight to
+// OutputDebugStringW (and AfxDump to stderr as well). This dumps a
+// 1e5-element CObArray through a real CDumpContext, in the order MFC's
+// CObArray::Dump writes it (this tree's CObject::Dump takes no dump
+// context, so the element loop is spelled out here). Output goes to an
+// AfxSetDumpOutput callback that does one real write(2) to the null device
+// per call, standing in for the debugger round trip. The test compares call
+// counts and wall time for the old pass-through behaviour
+// (afxDumpFlushImmediate) against line and block coalescing. It also
+// checks that:
+// - every policy produces the same text;
+// - AfxDump and CDumpContext(nullptr) share the channel;
+// - a partial line waits for its end, or for CDumpContext::Flush /
+//   AfxFlushDump;
+// - redirecting writes out what the old destination was owed;
+// - a fragment longer than the buffer arrives intact;
+// - AfxSetDumpFlushPolicy reports the previous policy and ignores bad ones.
+//
+// Build:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static -DUNICODE -D_UNICODE -I include \
+//       tests/test_dump_channel_logic.cpp -o /tmp/test_dump_channel.exe
+//   WINEDEBUG=-all wine /tmp/test_dump_channel.exe; echo EXIT=$?
+
+#include "../phase4/src/filecore.cpp"
+#include "../phase4/src/collections_cplex.cpp"
+#include "../phase4/src/global_file_dispatch.cpp"
+#include "../phase4/src/global_cdumpcontext.cpp"
+#include "../phase4/src/memcore.cpp"
+
+// filecore.cpp's CArchive object/exception code references a handful of
+// symbols that live in other translation units and are not reached here.
+extern "C" CRuntimeClass* MS_ABI
+impl__Load_CRuntimeClass__SAPEAU1_AEAVCArchive__PEAI_Z(CArchive*, unsigned int*) {
+    return nullptr;
+}
+extern "C" void MS_ABI
+impl__Store_CRuntimeClass__QEBAXAEAVCArchive___Z(const CRuntimeClass*, CArchive*) {
+}
+extern "C" void MS_ABI
+impl__AfxThrowFileException__YAXHJPEB_W_Z(int, long, const wchar_t*) {
+}
+extern "C" CRuntimeClass* MS_ABI
+impl__GetThisClass_CFileException__SAPEAUCRuntimeClass__XZ() {
+    return nullptr;
+}
+extern "C" void MS_ABI
+impl__AfxThrowArchiveException__YAXHPEB_W_Z(int, const wchar_t*) {
+}
+extern "C" void MS_ABI
+impl__AfxThrowMemoryException__YAXXZ() {
+}
+
+// memcore.cpp's afxwin.h pulls in framework classes and app-state helpers
+// that live in appcore.cpp; the dump paths never reach them.
+CRuntimeClass CCmdTarget::classCCmdTarget{};
+CRuntimeClass CWinThread::classCWinThread{};
+CRuntimeClass CWinApp::classCWinApp{};
+CRuntimeClass CWnd::classCWnd{};
+CCmdTarget::~CCmdTarget() {}
+int CCmdTarget::OnCmdMsg(unsigned int, int, void*, void*) { return 0; }
+const AFX_MSGMAP* CCmdTarget::GetMessageMap() const { return nullptr; }
+HINSTANCE AFXAPI AfxGetInstanceHandle() { return nullptr; }
+HINSTANCE AFXAPI AfxGetResourceHandle() { return nullptr; }
+
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+static int g_failures = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond) ++g_failures;
+}
+
+#ifdef __MINGW32__
+static const char kNullDevice[] = "NUL";
+#else
+static const char kNullDevice[] = "/dev/null";
+#endif
+
+// One write(2) per callback; also keeps the text for comparison.
+struct SyscallOutput {
+    int fd = ::open(kNullDevice, O_WRONLY);
+    long nCalls = 0;
+    bool bUnterminated = false;
+    bool bWriteFailed = false;
+    std::wstring text;
+
+    ~SyscallOutput() { if (fd >= 0) ::close(fd); }
+};
+
+static void AFXAPI WriteOutput(const wchar_t* text, size_t length, void* pContext) {
+    SyscallOutput& out = *static_cast<SyscallOutput*>(pContext);
+    if (text[length] != L'\0') out.bUnterminated = true;
+    if (::write(out.fd, text, length * sizeof(wchar_t)) < 0) out.bWriteFailed = true;
+    ++out.nCalls;
+    out.text.append(text, length);
+}
+
+class CDumpItem : public CObject {};
+
+// CObArray::Dump at depth > 0.
+static void DumpObArray(CDumpContext& dc, const CObArray& array) {
+    dc << L"a CObArray at " << static_cast<const void*>(&array) << L"\n";
+    dc << L"with " << static_cast<int>(array.GetSize()) << L" elements";
+    for (INT_PTR i = 0; i < array.GetSize(); ++i) {
+        dc << L"\n\t[" << static_cast<int>(i) << L"] = " << static_cast<const void*>(array.GetAt(i));
+    }
+    dc << L"\n";
+}
+
+struct RunResult {
+    long calls;
+    double ms;
+    std::wstring text;
+    bool terminated;
+};
+
+static RunResult Run(int nPolicy, const CObArray& array) {
+    SyscallOutput out;
+    impl__AfxSetDumpFlushPolicy(nPolicy);
+    impl__AfxSetDumpOutput(WriteOutput, &out);
+    const auto start = std::chrono::steady_clock::now();
+    CDumpContext dc(nullptr);
+    DumpObArray(dc, array);
+    dc.Flush();
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    impl__AfxSetDumpOutput(nullptr, nullptr);
+    return RunResult{out.nCalls, ms, out.text, !out.bUnterminated && !out.bWriteFailed};
+}
+
+int main() {
+    const int kElements = 100000;
+    std::vector<CDumpItem> items(kElements);
+    CObArray array;
+    array.SetSize(kElements);
+    for (int i = 0; i < kElements; ++i) array.SetAt(i, &items[i]);
+
+    const RunResult immediate = Run(afxDumpFlushImmediate, array);
+    const RunResult line = Run(afxDumpFlushLine, array);
+    const RunResult block = Run(afxDumpFlushBlock, array);
+    std::printf("dump of %d elements (%zu chars):\n", kElements, immediate.text.size());
+    std::printf("  immediate: %8ld writes, %8.2f ms\n", immediate.calls, immediate.ms);
+    std::printf("  line:      %8ld writes, %8.2f ms\n", line.calls, line.ms);
+    std::printf("  block:     %8ld writes, %8.2f ms\n", block.calls, block.ms);
+
+    check("every policy produces the same text", line.text == immediate.text && block.text == immediate.text);
+    check("the dump has every element", immediate.text.find(L"\t[99999] = $") != std::wstring::npos);
+    check("every write is nul-terminated", immediate.terminated && line.terminated && block.terminated);
+    check("pass-through makes one write per fragment", immediate.calls >= 4L * kElements);
+    check("line policy makes one write per line", line.calls <= kElements + 2);
+    check("block policy cuts writes by more than 100x", block.calls * 100 < immediate.calls);
+    check("block policy is faster than pass-through", block.ms < immediate.ms);
+
+    // Line policy holds a partial line until it ends; AfxDump shares the channel.
+    check("AfxSetDumpFlushPolicy returns the previous policy",
+          impl__AfxSetDumpFlushPolicy(afxDumpFlushLine) == afxDumpFlushBlock);
+    check("and ignores an unknown one", impl__AfxSetDumpFlushPolicy(7) == afxDumpFlushLine &&
+                                        impl__AfxSetDumpFlushPolicy(-1) == afxDumpFlushLine);
+    {
+        SyscallOutput out;
+        impl__AfxSetDumpOutput(WriteOutput, &out);
+        CDumpContext dc(nullptr);
+        dc << L"a = ";
+        impl__AfxDump__PB_W(L"5");
+        check("a partial line is held back", out.nCalls == 0);
+        dc << L"\nb = ";
+        check("a completed line goes out in one write", out.nCalls == 1 && out.text == L"a = 5\n");
+        dc.Flush();
+        check("CDumpContext::Flush writes the partial line", out.nCalls == 2 && out.text == L"a = 5\nb = ");
+        impl__AfxDump__PB_W(L"7");
+        impl__AfxFlushDump();
+        check("so does AfxFlushDump", out.text == L"a = 5\nb = 7");
+        impl__AfxSetDumpOutput(nullptr, nullptr);
+    }
+
+    // Redirecting writes out what the old destination was owed.
+    {
+        SyscallOutput first;
+        SyscallOutput second;
+        impl__AfxSetDumpFlushPolicy(afxDumpFlushBlock);
+        impl__AfxSetDumpOutput(WriteOutput, &first);
+        CDumpContext dc(nullptr);
+        dc << L"before redirect\n";
+        check("block policy holds whole lines", first.nCalls == 0);
+        impl__AfxSetDumpOutput(WriteOutput, &second);
+        check("redirect flushes the old destination", first.text == L"before redirect\n");
+        dc << L"after redirect\n";
+        dc.Flush();
+        check("the new destination gets what follows", second.text == L"after redirect\n" &&
+                                                         first.text == L"before redirect\n");
+        impl__AfxSetDumpOutput(nullptr, nullptr);
+    }
+
+    // A fragment longer than the buffer still arrives intact and in order.
+    {
+        SyscallOutput out;
+        impl__AfxSetDumpOutput(WriteOutput, &out);
+        const std::wstring big(openmfc_dump::DumpChannel::kBufferChars * 3, L'x');
+        CDumpContext dc(nullptr);
+        dc << L"head " << big.c_str() << L" tail\n";
+        dc.Flush();
+        check("an oversized fragment passes through", out.text == L"head " + big + L" tail\n" && !out.bUnterminated);
+        impl__AfxSetDumpOutput(nullptr, nullptr);
+    }
+    impl__AfxSetDumpFlushPolicy(afxDumpFlushLine);
+
+    if (g_failures == 0) {
+        std::printf("ALL CHECKS PASSED\n");
+        return 0;
+    }
+    std::printf("%d CHECK(S) FAILED\n", g_failures);
+    return 1;
+}
@@ -0,0 +1,117 @@
+// Logic test for global_afx_msgcache.cpp (compiles+links; runs on Windows CI).
+// Drives AfxFindMessageEntry and the per-thread (map, message, code, id)
+// cache behind CCmdTarget::OnCmdMsg / CWnd::OnWndMsg over a two-level map
+// chain, and checks entry resolution, negative caching, the hit/miss
+// counters, and that a flush empties other threads' caches too.
+#include "../phase4/src/global_afx_msgcache.cpp"
+#include <cstdio>
+#include <thread>
+
+// Framework CRuntimeClass statics dragged in by afxwin.h's class graph (not
+// CObject, defined inline).
+CRuntimeClass CCmdTarget::classCCmdTarget{};
+CRuntimeClass CWinThread::classCWinThread{};
+CRuntimeClass CWinApp::classCWinApp{};
+CRuntimeClass CWnd::classCWnd{};
+CRuntimeClass CDialog::classCDialog{};
+
+static int failures = 0;
+static void check(bool ok, const char* m){ if(!ok){ printf("FAIL: %s\n", m); failures++; } }
+
+static const AFX_MSGMAP_ENTRY s_baseEntries[] = {
+    { WM_COMMAND, CN_COMMAND, 100, 100, AfxSig_vv, (AFX_PMSG)0 },
+    { WM_COMMAND, CN_UPDATE_COMMAND_UI, 100, 100, AfxSig_cmdui, (AFX_PMSG)0 },
+    { WM_PAINT, 0, 0, 0, AfxSig_vv, (AFX_PMSG)0 },
+    { 0, 0, 0, 0, AfxSig_end, (AFX_PMSG)0 }
+};
+static const AFX_MSGMAP s_baseMap = { nullptr, s_baseEntries };
+static const AFX_MSGMAP* AFXAPI GetBaseMap() { return &s_baseMap; }
+
+static const AFX_MSGMAP_ENTRY s_derivedEntries[] = {
+    { WM_COMMAND, CN_COMMAND, 200, 209, AfxSig_vw, (AFX_PMSG)0 },
+    { WM_COMMAND, CN_COMMAND, 100, 100, AfxSig_bv, (AFX_PMSG)0 },   // overrides the base
+    { 0, 0, 0, 0, AfxSig_end, (AFX_PMSG)0 }
+};
+static const AFX_MSGMAP s_derivedMap = { GetBaseMap, s_derivedEntries };
+
+static ULONGLONG Hits() { ULONGLONG h = 0; OpenMfcGetMessageCacheStats(&h, nullptr); return h; }
+static ULONGLONG Misses() { ULONGLONG m = 0; OpenMfcGetMessageCacheStats(nullptr, &m); return m; }
+
+int main(){
+    // AfxFindMessageEntry: one table, exact message/code, inclusive id range.
+    check(impl__AfxFindMessageEntry__YAPEBUAFX_MSGMAP_ENTRY__PEBU1_III_Z(s_derivedEntries, WM_COMMAND, CN_COMMAND, 205) == &s_derivedEntries[0],
+          "AfxFindMessageEntry matches inside an id range");
+    check(impl__AfxFindMessageEntry__YAPEBUAFX_MSGMAP_ENTRY__PEBU1_III_Z(s_derivedEntries, WM_COMMAND, CN_COMMAND, 210) == nullptr,
+          "AfxFindMessageEntry stops at nLastID");
+    check(impl__AfxFindMessageEntry__YAPEBUAFX_MSGMAP_ENTRY__PEBU1_III_Z(s_baseEntries, WM_COMMAND, CN_UPDATE_COMMAND_UI, 100) == &s_baseEntries[1],
+          "AfxFindMessageEntry keys on the notification code");
+    check(impl__AfxFindMessageEntry__YAPEBUAFX_MSGMAP_ENTRY__PEBU1_III_Z(nullptr, WM_COMMAND, 0, 0) == nullptr,
+          "AfxFindMessageEntry tolerates a null table");
+
+    OpenMfcFlushMessageCache();
+    check(Hits() == 0 && Misses() == 0, "flush zeroes the counters");
+
+    // Chain walk: derived entries shadow base entries, base entries are found.
+    check(OpenMfcLookupMessageEntry(&s_derivedMap, WM_COMMAND, CN_COMMAND, 100) == &s_derivedEntries[1],
+          "derived entry wins over the base");
+    check(OpenMfcLookupMessageEntry(&s_derivedMap, WM_PAINT, 0, 0) == &s_baseEntries[2],
+          "window message resolved from the base map");
+    check(OpenMfcLookupMessageEntry(&s_derivedMap, WM_COMMAND, CN_COMMAND, 300) == nullptr,
+          "unhandled command resolves to null");
+    check(Hits() == 0 && Misses() == 3, "first lookups are misses");
+
+    // Repeats -- including the unhandled one -- are served from the cache.
+    for (int i = 0; i < 10; ++i) {
+        check(OpenMfcLookupMessageEntry(&s_derivedMap, WM_COMMAND, CN_COMMAND, 100) == &s_derivedEntries[1],
+              "cached derived entry");
+        check(OpenMfcLookupMessageEntry(&s_derivedMap, WM_COMMAND, CN_COMMAND, 300) == nullptr,
+              "cached negative answer");
+    }
+    check(Hits() == 20 && Misses() == 3, "repeat lookups are hits");
+
+    // The key includes the map: the base map alone still resolves its own entry.
+    check(OpenMfcLookupMessageEntry(&s_baseMap, WM_COMMAND, CN_COMMAND, 100) == &s_baseEntries[0],
+          "base map keyed separately from derived map");
+    check(OpenMfcLookupMessageEntry(nullptr, WM_COMMAND, 0, 0) == nullptr, "null map");
+
+    // The cache is per thread: another thread starts cold.
+    ULONGLONG otherHits = 1, otherMisses = 0;
+    std::thread worker([&] {
+        OpenMfcLookupMessageEntry(&s_derivedMap, WM_COMMAND, CN_COMMAND, 100);
+        OpenMfcGetMessageCacheStats(&otherHits, &otherMisses);
+    });
+    worker.join();
+    check(otherHits == 0 && otherMisses == 1, "other thread has its own cache");
+
+    OpenMfcFlushMessageCache();
+    check(OpenMfcLookupMessageEntry(&s_derivedMap, WM_COMMAND, CN_COMMAND, 205) == &s_derivedEntries[0],
+          "lookup after flush");
+    check(Hits() == 0 && Misses() == 1, "flush drops cached entries");
+
+    // A flush (AfxTermExtensionModule's) reaches threads other than the caller.
+    {
+        HANDLE hWarm = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        HANDLE hFlushed = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        ULONGLONG warmHits = 0, afterHits = 1, afterMisses = 0;
+        std::thread worker([&] {
+            OpenMfcLookupMessageEntry(&s_derivedMap, WM_PAINT, 0, 0);
+            OpenMfcLookupMessageEntry(&s_derivedMap, WM_PAINT, 0, 0);
+            OpenMfcGetMessageCacheStats(&warmHits, nullptr);
+            ::SetEvent(hWarm);
+            ::WaitForSingleObject(hFlushed, INFINITE);
+            OpenMfcLookupMessageEntry(&s_derivedMap, WM_PAINT, 0, 0);
+            OpenMfcGetMessageCacheStats(&afterHits, &afterMisses);
+        });
+        ::WaitForSingleObject(hWarm, INFINITE);
+        OpenMfcFlushMessageCache();
+        ::SetEvent(hFlushed);
+        worker.join();
+        ::CloseHandle(hWarm);
+        ::CloseHandle(hFlushed);
+        check(warmHits == 1, "worker warmed its cache");
+        check(afterHits == 0 && afterMisses == 1, "flush from another thread drops the worker's entries");
+    }
+
+    if (failures == 0) printf("PASS: global_afx_msgcache logic\n");
+    return failures ? 1 : 0;
+}
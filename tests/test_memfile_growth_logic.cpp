@@ -0,0 +1,284 @@
+// Behavioral test for CMemFile buffer growth and CArchive direct buffering,
+// driven through the real filecore.cpp and file_csharedfile.cpp.
+//
+// Build:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static -DUNICODE -D_UNICODE -I include \
+//       tests/test_memfile_growth_logic.cpp -o /tmp/test_memfile_growth.exe
+//   WINEDEBUG=-all wine /tmp/test_memfile_growth.exe; echo EXIT=$?
+//
+// The test checks:
+// - the default, geometric and reserved growth modes keep the written bytes;
+//   reserved growth never moves the buffer;
+// - a buffer with nGrowBytes 0 never grows: a constructor or Attach buffer,
+//   an empty file, and CSharedFile's SetHandle block all throw
+//   CFileException::diskFull and are left as they were;
+// - an Attach buffer with nGrowBytes != 0 grows by nGrowBytes steps, even
+//   with geometric growth on, and Detach hands back the grown buffer;
+// - a CArchive on a file that owns its memory writes in place but grows
+//   nothing until it is written to; on an attached buffer it stages.
+// Append and archive store times are printed for each mode.
+
+#include "../phase4/src/filecore.cpp"
+#include "../phase4/src/collections_cplex.cpp"
+#include "../phase4/src/global_file_dispatch.cpp"
+#include "../phase4/src/file_csharedfile.cpp"
+
+// filecore.cpp's CArchive object/exception code references a handful of
+// symbols that live in other translation units and are not reached here.
+extern "C" CRuntimeClass* MS_ABI
+impl__Load_CRuntimeClass__SAPEAU1_AEAVCArchive__PEAI_Z(CArchive*, unsigned int*) {
+    return nullptr;
+}
+extern "C" void MS_ABI
+impl__Store_CRuntimeClass__QEBAXAEAVCArchive___Z(const CRuntimeClass*, CArchive*) {
+}
+extern "C" CRuntimeClass* MS_ABI
+impl__GetThisClass_CFileException__SAPEAUCRuntimeClass__XZ() {
+    return nullptr;
+}
+extern "C" void MS_ABI
+impl__AfxThrowArchiveException__YAXHPEB_W_Z(int, const wchar_t*) {
+}
+extern "C" void MS_ABI
+impl__AfxThrowMemoryException__YAXXZ() {
+}
+
+// Stand-in for CFileException: carries the cause to the test.
+struct FileError {
+    int cause;
+};
+extern "C" void MS_ABI impl__AfxThrowFileException__YAXHJPEB_W_Z(int cause, long, const wchar_t*) {
+    throw FileError{ cause };
+}
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static int g_failures = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond) ++g_failures;
+}
+
+// Test-side accessor for the protected bookkeeping.
+struct MemFileAccess : CMemFile {
+    static BYTE* Buffer(CMemFile& f) { return static_cast<MemFileAccess&>(f).m_lpBuffer; }
+    static SIZE_T BufferSize(CMemFile& f) { return static_cast<MemFileAccess&>(f).m_nBufferSize; }
+};
+
+static const int kDiskFull = 13;   // CFileException::diskFull
+
+// Returns the CFileException cause thrown by fn, or 0.
+template <typename Fn>
+static int CauseOf(Fn fn) {
+    try {
+        fn();
+    } catch (const FileError& e) {
+        return e.cause;
+    }
+    return 0;
+}
+
+// Appends nTotal bytes in 4 KB records; counts how often the buffer moved.
+static bool Append(CMemFile& file, size_t nTotal, double* pMs, int* pMoves) {
+    static BYTE record[4096];
+    const auto start = std::chrono::steady_clock::now();
+    BYTE* pLast = MemFileAccess::Buffer(file);
+    int nMoves = 0;
+    for (size_t n = 0; n < nTotal; n += sizeof(record)) {
+        std::memset(record, static_cast<int>((n / sizeof(record)) & 0xFF), sizeof(record));
+        file.Write(record, sizeof(record));
+        if (MemFileAccess::Buffer(file) != pLast) {
+            ++nMoves;
+            pLast = MemFileAccess::Buffer(file);
+        }
+    }
+    *pMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    *pMoves = nMoves;
+    bool bSame = file.GetLength() == nTotal;
+    const BYTE* p = MemFileAccess::Buffer(file);
+    for (size_t n = 0; bSame && n < nTotal; n += sizeof(record)) {
+        bSame = p[n] == static_cast<BYTE>((n / sizeof(record)) & 0xFF) && p[n + sizeof(record) - 1] == p[n];
+    }
+    return bSame;
+}
+
+int main() {
+    // ---- Growth modes -------------------------------------------------------
+    const size_t kTotal = 64u * 1024 * 1024;
+    {
+        CMemFile linear;
+        double ms = 0;
+        int nMoves = 0;
+        check("linear growth keeps the bytes", Append(linear, kTotal, &ms, &nMoves));
+        std::printf("append %zu MB, linear:    %8.1f ms, %6d buffer moves\n", kTotal >> 20, ms, nMoves);
+    }
+    {
+        CMemFile geometric;
+        geometric.SetGeometricGrowth();
+        double ms = 0;
+        int nMoves = 0;
+        check("geometric growth keeps the bytes", Append(geometric, kTotal, &ms, &nMoves));
+        std::printf("append %zu MB, geometric: %8.1f ms, %6d buffer moves\n", kTotal >> 20, ms, nMoves);
+    }
+    {
+        CMemFile reserved;
+        check("ReserveAddressSpace on an empty file", reserved.ReserveAddressSpace(kTotal) == TRUE);
+        double ms = 0;
+        int nMoves = 0;
+        check("reserved growth keeps the bytes", Append(reserved, kTotal, &ms, &nMoves));
+        check("reserved buffer never moves", nMoves == 0);
+        std::printf("append %zu MB, reserved:  %8.1f ms, %6d buffer moves\n", kTotal >> 20, ms, nMoves);
+        const BYTE extra = 0;
+        check("writing past the reservation throws diskFull",
+              CauseOf([&] { reserved.Write(&extra, 1); }) == kDiskFull && reserved.GetLength() == kTotal);
+    }
+
+    // ---- Buffers the file does not own --------------------------------------
+    {
+        BYTE owned[64];
+        std::memset(owned, 0x5A, sizeof(owned));
+        CMemFile file(owned, sizeof(owned));
+        BYTE data[100] = {};
+        file.Seek(0, CFile::begin);
+        check("constructor buffer: write past it throws diskFull",
+              CauseOf([&] { file.Write(data, sizeof(data)); }) == kDiskFull);
+        check("constructor buffer: not reallocated",
+              MemFileAccess::Buffer(file) == owned && MemFileAccess::BufferSize(file) == sizeof(owned) && owned[0] == 0x5A);
+        check("constructor buffer: write inside it works",
+              CauseOf([&] { file.Write(data, 32); }) == 0 && owned[0] == 0 && owned[32] == 0x5A);
+        check("constructor buffer: SetLength past it throws diskFull",
+              CauseOf([&] { file.SetLength(65); }) == kDiskFull && file.GetLength() == sizeof(owned));
+        check("GetBufferPtr: no direct access to a borrowed buffer",
+              (file.GetBufferPtr(CFile::bufferCheck) & CFile::bufferDirect) == 0);
+    }
+    {
+        BYTE* pHeap = static_cast<BYTE*>(std::malloc(16));
+        CMemFile file;
+        file.Attach(pHeap, 16);
+        const BYTE data[32] = {};
+        check("fixed Attach buffer: write past it throws diskFull",
+              CauseOf([&] { file.Write(data, sizeof(data)); }) == kDiskFull && MemFileAccess::Buffer(file) == pHeap);
+        check("Detach hands the attached buffer back", file.Detach() == pHeap);
+        std::free(pHeap);
+    }
+    {
+        BYTE* pHeap = static_cast<BYTE*>(std::malloc(1000));
+        CMemFile file;
+        file.SetGeometricGrowth();
+        file.Attach(pHeap, 1000, 100);
+        BYTE data[1050];
+        for (size_t i = 0; i < sizeof(data); ++i) data[i] = static_cast<BYTE>(i);
+        const int nCause = CauseOf([&] { file.Write(data, sizeof(data)); });
+        check("growable Attach buffer: write past it grows by nGrowBytes",
+              nCause == 0 && MemFileAccess::BufferSize(file) == 1100 && file.GetLength() == sizeof(data));
+        BYTE* pGrown = file.Detach();
+        check("Detach hands the grown buffer back", pGrown && std::memcmp(pGrown, data, sizeof(data)) == 0);
+        std::free(pGrown);
+    }
+    {
+        CMemFile fixed(0);
+        const BYTE data[8] = {};
+        check("nGrowBytes 0: first write throws diskFull",
+              CauseOf([&] { fixed.Write(data, sizeof(data)); }) == kDiskFull && MemFileAccess::Buffer(fixed) == nullptr);
+    }
+
+    // ---- CSharedFile --------------------------------------------------------
+    {
+        HGLOBAL hBlock = ::GlobalAlloc(GMEM_MOVEABLE, 64);
+        CSharedFile shared;
+        shared.SetHandle(hBlock, TRUE);
+        const BYTE data[100] = {};
+        check("SetHandle block: write past it throws diskFull",
+              CauseOf([&] { shared.Write(data, sizeof(data)); }) == kDiskFull);
+        check("SetHandle block: handle kept, not realloc'd",
+              shared.m_hGlobalMemory == hBlock && ::GlobalSize(hBlock) < sizeof(data));
+        HGLOBAL hOut = shared.Detach();
+        check("detached CSharedFile grows again",
+              hOut == hBlock && CauseOf([&] { shared.Write(data, sizeof(data)); }) == 0 &&
+              shared.GetLength() == sizeof(data));
+        ::GlobalFree(hOut);
+    }
+    {
+        CSharedFile shared;
+        BYTE data[5000];
+        for (size_t i = 0; i < sizeof(data); ++i) data[i] = static_cast<BYTE>(i * 7);
+        shared.Write(data, sizeof(data));
+        HGLOBAL hOut = shared.Detach();
+        const BYTE* p = hOut ? static_cast<const BYTE*>(::GlobalLock(hOut)) : nullptr;
+        check("grown CSharedFile detaches to a global block with the bytes",
+              p && ::GlobalSize(hOut) >= sizeof(data) && std::memcmp(p, data, sizeof(data)) == 0);
+        if (hOut) {
+            ::GlobalUnlock(hOut);
+            ::GlobalFree(hOut);
+        }
+    }
+
+    // ---- CArchive -----------------------------------------------------------
+    {
+        CMemFile file;
+        {
+            CArchive ar(&file, CArchive::store);
+            ar.Close();
+        }
+        check("empty store archive grows nothing",
+              MemFileAccess::Buffer(file) == nullptr && MemFileAccess::BufferSize(file) == 0 && file.GetLength() == 0);
+    }
+    {
+        CMemFile file;
+        const size_t kInts = 4u * 1024 * 1024;
+        auto start = std::chrono::steady_clock::now();
+        {
+            CArchive ar(&file, CArchive::store);
+            for (size_t i = 0; i < kInts; ++i) ar << static_cast<int>(i * 3);
+            ar.Close();
+        }
+        const double storeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        check("direct store writes exactly what was stored", file.GetLength() == kInts * sizeof(int));
+        file.Seek(0, CFile::begin);
+        bool bSame = true;
+        start = std::chrono::steady_clock::now();
+        {
+            CArchive ar(&file, CArchive::load);
+            for (size_t i = 0; bSame && i < kInts; ++i) {
+                int n = 0;
+                ar >> n;
+                bSame = n == static_cast<int>(i * 3);
+            }
+        }
+        const double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        check("direct load reads it back", bSame);
+        std::printf("archive %zu MB on CMemFile: store %.1f ms, load %.1f ms\n",
+                    (kInts * sizeof(int)) >> 20, storeMs, loadMs);
+    }
+    {
+        BYTE owned[64] = {};
+        CMemFile file(owned, sizeof(owned));
+        file.SetLength(0);
+        {
+            CArchive ar(&file, CArchive::store);
+            for (int i = 0; i < 16; ++i) ar << i;
+            ar.Close();
+        }
+        int n5 = 0;
+        std::memcpy(&n5, owned + 5 * sizeof(int), sizeof(int));
+        check("archive on a borrowed buffer stages into it", file.GetLength() == 64 && n5 == 5);
+        file.SetLength(0);
+        const int nCause = CauseOf([&] {
+            CArchive ar(&file, CArchive::store | CArchive::bNoFlushOnDelete);
+            for (int i = 0; i < 17; ++i) ar << i;
+            ar.Close();
+        });
+        check("archive overflowing a borrowed buffer throws diskFull", nCause == kDiskFull);
+    }
+
+    if (g_failures == 0) {
+        std::printf("ALL CHECKS PASSED\n");
+        return 0;
+    }
+    std::printf("%d CHECK(S) FAILED\n", g_failures);
+    return 1;
+}
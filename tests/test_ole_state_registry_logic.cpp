@@ -0,0 +1,163 @@
+// Stress test for the OLE side-state registries, driven through the real
+// olecore.cpp.
+//
+// olecore.cpp keeps per-object state for drop targets, documents, client and
+// server items and controls in these registries. Before, they were
+// std::vectors: a push_back could move every state and leave pointers held by
+// callers dangling. This creates and destroys 1e5 COleClientItems and 1e5
+// COleDropTargets while a window of them stays alive. Client item state is
+// made by the constructor and filled through SetActiveVerb, SetModifiedFlag
+// and SetIconicMetafile; drop target state is made the way Register makes it
+// and dropped by the destructor's Revoke. The test checks that:
+// - every live object's state keeps its first address and its contents;
+// - the accessors read back what was set;
+// - a destroyed object leaves no state behind;
+// - the registries hold one state per live object and drain to empty.
+//
+// Build:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static -DUNICODE -D_UNICODE -I include \
+//       tests/test_ole_state_registry_logic.cpp -lole32 -loleaut32 -loledlg -luuid \
+//       -o /tmp/test_ole_state_registry.exe
+//   WINEDEBUG=-all wine /tmp/test_ole_state_registry.exe; echo EXIT=$?
+
+#include "../phase4/src/olecore.cpp"
+
+// afxole.h's class graph roots in framework classes that live in other
+// translation units; the item and drop target paths never reach them.
+CRuntimeClass CCmdTarget::classCCmdTarget{};
+CRuntimeClass CWinThread::classCWinThread{};
+CRuntimeClass CWinApp::classCWinApp{};
+CRuntimeClass CWnd::classCWnd{};
+CRuntimeClass CDocument::classCDocument{};
+CCmdTarget::~CCmdTarget() {}
+int CCmdTarget::OnCmdMsg(unsigned int, int, void*, void*) { return 0; }
+const AFX_MSGMAP* CCmdTarget::GetMessageMap() const { return nullptr; }
+
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <random>
+
+static int g_failures = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond) ++g_failures;
+}
+
+struct LiveItem {
+    COleClientItem* item;
+    ClientItemState* state;
+    LONG serial;
+};
+
+struct LiveTarget {
+    COleDropTarget* target;
+    DropTargetState* state;
+};
+
+static bool ItemIntact(const LiveItem& live) {
+    return FindClientItemState(live.item) == live.state && live.state->item == live.item &&
+           live.item->GetActiveVerb() == live.serial && live.item->IsModified() == (live.serial & 1) &&
+           live.state->iconicMetafile != nullptr;
+}
+
+int main() {
+    const int kObjects = 100000;
+    const size_t kWindow = 2000;   // objects alive at once
+
+    // The metafile every item gets a private copy of.
+    HGLOBAL hMetaPict = ::GlobalAlloc(GMEM_MOVEABLE, 64);
+
+    std::deque<LiveItem> liveItems;
+    std::deque<LiveTarget> liveTargets;
+    std::mt19937 rng(12345);
+
+    int movedStates = 0;
+    int corruptStates = 0;
+    int leftoverStates = 0;
+    int sharedMetafiles = 0;
+    for (int i = 0; i < kObjects; ++i) {
+        LiveItem item{ new COleClientItem(nullptr), nullptr, i };
+        item.state = FindClientItemState(item.item);
+        item.item->SetIconicMetafile(hMetaPict);
+        item.item->SetActiveVerb(i);
+        item.item->SetModifiedFlag(i & 1);
+        if (item.state && item.state->iconicMetafile == hMetaPict) ++sharedMetafiles;
+        liveItems.push_back(item);
+
+        // COleDropTarget::Register makes the state like this once it has a
+        // window; here there is no window to register with.
+        LiveTarget target{ new COleDropTarget, nullptr };
+        target.state = GetDropTargetState(target.target, true);
+        liveTargets.push_back(target);
+
+        // Revisit a random live object through its saved pointer.
+        const LiveItem& probeItem = liveItems[rng() % liveItems.size()];
+        if (FindClientItemState(probeItem.item) != probeItem.state) ++movedStates;
+        if (!ItemIntact(probeItem)) ++corruptStates;
+        const LiveTarget& probeTarget = liveTargets[rng() % liveTargets.size()];
+        if (GetDropTargetState(probeTarget.target, false) != probeTarget.state) ++movedStates;
+        if (probeTarget.state->target != probeTarget.target || probeTarget.state->adapter != nullptr) {
+            ++corruptStates;
+        }
+
+        if (liveItems.size() > kWindow) {
+            // Destroy one from the middle too, so removal is not just FIFO.
+            size_t victim = rng() % liveItems.size();
+            std::swap(liveItems[victim], liveItems.front());
+            COleClientItem* dead = liveItems.front().item;
+            delete dead;
+            if (FindClientItemState(dead)) ++leftoverStates;
+            liveItems.pop_front();
+
+            victim = rng() % liveTargets.size();
+            std::swap(liveTargets[victim], liveTargets.front());
+            COleDropTarget* deadTarget = liveTargets.front().target;
+            delete deadTarget;
+            if (GetDropTargetState(deadTarget, false)) ++leftoverStates;
+            liveTargets.pop_front();
+        }
+    }
+
+    check("state pointers stay put across 1e5 inserts and removals", movedStates == 0);
+    check("states keep their contents", corruptStates == 0);
+    check("each item holds its own copy of the metafile", sharedMetafiles == 0);
+    check("destroyed objects have no state", leftoverStates == 0);
+    check("one state per live object", g_clientItemStates.GetCount() == liveItems.size() &&
+                                        g_dropTargetStates.GetCount() == liveTargets.size());
+
+    int allSurvivors = 0;
+    for (const LiveItem& item : liveItems) {
+        if (ItemIntact(item)) ++allSurvivors;
+    }
+    check("every surviving client item keeps its first state",
+          allSurvivors == static_cast<int>(liveItems.size()));
+
+    const LiveItem& first = liveItems.front();
+    check("asking for a known item's state again returns it", GetClientItemState(first.item, true) == first.state);
+    COleDropTarget stranger;
+    check("looking up an object without state does not create one",
+          GetDropTargetState(&stranger, false) == nullptr &&
+          g_dropTargetStates.GetCount() == liveTargets.size());
+    stranger.Revoke();
+    check("Revoke of an object without state is a no-op", g_dropTargetStates.GetCount() == liveTargets.size());
+
+    while (!liveItems.empty()) {
+        delete liveItems.back().item;
+        liveItems.pop_back();
+    }
+    while (!liveTargets.empty()) {
+        delete liveTargets.back().target;
+        liveTargets.pop_back();
+    }
+    check("registries drain to empty", g_clientItemStates.GetCount() == 0 && g_dropTargetStates.GetCount() == 0);
+    ::GlobalFree(hMetaPict);
+
+    if (g_failures == 0) {
+        std::printf("ALL CHECKS PASSED\n");
+        return 0;
+    }
+    std::printf("%d CHECK(S) FAILED\n", g_failures);
+    return 1;
+}
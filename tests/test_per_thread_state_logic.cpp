@@ -0,0 +1,172 @@
+// Multi-threaded test for the per-thread state objects handed out by the
+// real regcore.cpp (AfxGetModuleThreadState) and appcore.cpp
+// (AfxGetThreadState).
+//
+// AfxGetModuleThreadState used to return one static AFX_MODULE_THREAD_STATE
+// to every thread. This checks, on the retail state objects, that:
+// - each thread gets its own module thread state and thread state, stable
+//   across calls;
+// - what one thread writes is never seen by another;
+// - a thread's module thread state is gone once the thread exits: a call
+//   made during its teardown gets the shared fallback, not a new object;
+// - a thread that never asks allocates nothing.
+//
+// Build:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static -DUNICODE -D_UNICODE -I include \
+//       tests/test_per_thread_state_logic.cpp -o /tmp/test_per_thread_state.exe
+//   WINEDEBUG=-all wine /tmp/test_per_thread_state.exe; echo EXIT=$?
+
+// Both files define impl__AfxGetMainWnd (the DLL links with
+// --allow-multiple-definition); appcore.cpp's is the one kept here.
+#define impl__AfxGetMainWnd__YAPEAVCWnd__XZ regcore_impl__AfxGetMainWnd__YAPEAVCWnd__XZ
+#include "../phase4/src/regcore.cpp"
+#undef impl__AfxGetMainWnd__YAPEAVCWnd__XZ
+#include "../phase4/src/appcore.cpp"
+
+// appcore.cpp's document, dialog, message and exception paths reference
+// members that live in other translation units and are not reached here.
+CRuntimeClass CWnd::classCWnd{};
+CRuntimeClass CException::classCException{};
+int CException::GetErrorMessage(wchar_t*, unsigned int, unsigned int*) const { return 0; }
+void CException::Dump() const {}
+void CException::AssertValid() const {}
+void CFileException::Dump() const {}
+void CFileException::AssertValid() const {}
+void CArchiveException::Dump() const {}
+void CArchiveException::AssertValid() const {}
+CRuntimeClass CDialog::classCDialog{};
+CRuntimeClass CFileDialog::classCFileDialog{};
+CRuntimeClass CPrintDialog::classCPrintDialog{};
+CDialog::CDialog() {}
+CDialog::~CDialog() {}
+intptr_t CDialog::DoModal() { return 0; }
+BOOL CDialog::Create(const wchar_t*, CWnd*) { return FALSE; }
+BOOL CDialog::Create(unsigned int, CWnd*) { return FALSE; }
+int CDialog::OnInitDialog() { return FALSE; }
+void CDialog::OnOK() {}
+void CDialog::OnCancel() {}
+void CDialog::OnSetFont(CWnd*) {}
+CFileDialog::CFileDialog(int, const wchar_t*, const wchar_t*, unsigned long, const wchar_t*, CWnd*, unsigned long, int) {}
+CFileDialog::~CFileDialog() {}
+intptr_t CFileDialog::DoModal() { return 0; }
+CString CFileDialog::GetPathName() const { return CString(); }
+CPrintDialog::CPrintDialog(int, unsigned long, CWnd*) {}
+CPrintDialog::~CPrintDialog() {}
+intptr_t CPrintDialog::DoModal() { return 0; }
+const AFX_MSGMAP_ENTRY* OpenMfcLookupMessageEntry(const AFX_MSGMAP*, UINT, UINT, UINT) { return nullptr; }
+void OpenMfcCleanupTempWrappers() {}
+
+#include <atomic>
+#include <cstdio>
+#include <set>
+#include <thread>
+#include <vector>
+
+static int g_failures = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond) ++g_failures;
+}
+
+typedef openmfc_threadstate::PerThread<AFX_MODULE_THREAD_STATE> ModuleThreadStates;
+
+static AFX_MODULE_THREAD_STATE* GetModuleThreadState() {
+    return impl__AfxGetModuleThreadState__YAPEAUAFX_MODULE_THREAD_STATE__XZ();
+}
+
+// _AFX_THREAD_STATE is opaque here; its first word stands in for a member.
+static void*& ThreadStateWord(_AFX_THREAD_STATE* pState) {
+    return *reinterpret_cast<void**>(pState);
+}
+
+// What a thread sees when it asks for its module thread state during its
+// own teardown, after the state has been freed. Constructed before the
+// thread's first call, so it is destroyed after the state is.
+struct TeardownProbe {
+    AFX_MODULE_THREAD_STATE** ppSeen;
+    bool* pbHadState;
+    ~TeardownProbe() {
+        *pbHadState = ModuleThreadStates::Peek() != nullptr;
+        *ppSeen = GetModuleThreadState();
+    }
+};
+
+int main() {
+    const int kThreads = 8;
+    const int kRounds = 20000;
+
+    AFX_MODULE_THREAD_STATE* pMain = GetModuleThreadState();
+    pMain->m_nTempMapLock = 1000;
+    check("the main thread's module thread state is created once",
+          pMain != nullptr && pMain == GetModuleThreadState() && ModuleThreadStates::Peek() == pMain);
+    _AFX_THREAD_STATE* pMainThreadState = AfxGetThreadState();
+    ThreadStateWord(pMainThreadState) = &pMainThreadState;
+    check("AfxGetThreadState and its export agree",
+          impl__AfxGetThreadState__YAPEAV_AFX_THREAD_STATE__XZ() == pMainThreadState);
+
+    std::vector<AFX_MODULE_THREAD_STATE*> seen(kThreads);
+    std::vector<_AFX_THREAD_STATE*> seenThreadStates(kThreads);
+    std::atomic<int> mixedUp{ 0 };
+    std::atomic<int> ready{ 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([t, &seen, &seenThreadStates, &mixedUp, &ready] {
+            if (ModuleThreadStates::Peek() != nullptr) ++mixedUp;
+            AFX_MODULE_THREAD_STATE* pState = GetModuleThreadState();
+            _AFX_THREAD_STATE* pThreadState = AfxGetThreadState();
+            seen[t] = pState;
+            seenThreadStates[t] = pThreadState;
+            // Another thread's data would show up here.
+            if (pState->m_nTempMapLock != 0 || ThreadStateWord(pThreadState) != nullptr) ++mixedUp;
+            ThreadStateWord(pThreadState) = &seen[t];
+            ++ready;
+            while (ready.load() < kThreads) std::this_thread::yield();   // all states live at once
+            for (int i = 0; i < kRounds; ++i) {
+                AFX_MODULE_THREAD_STATE* pAgain = GetModuleThreadState();
+                if (pAgain != pState || pAgain->m_nTempMapLock != i) ++mixedUp;
+                if (AfxGetThreadState() != pThreadState || ThreadStateWord(pThreadState) != &seen[t]) ++mixedUp;
+                ++pAgain->m_nTempMapLock;    // as AfxLockTempMaps would
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    std::set<AFX_MODULE_THREAD_STATE*> distinct(seen.begin(), seen.end());
+    distinct.insert(pMain);
+    check("every thread gets its own module thread state", distinct.size() == kThreads + 1);
+    std::set<_AFX_THREAD_STATE*> distinctThreadStates(seenThreadStates.begin(), seenThreadStates.end());
+    distinctThreadStates.insert(pMainThreadState);
+    check("every thread gets its own thread state", distinctThreadStates.size() == kThreads + 1);
+    check("no thread sees another thread's writes", mixedUp == 0);
+    check("the main thread's states are untouched by workers",
+          pMain->m_nTempMapLock == 1000 && ThreadStateWord(pMainThreadState) == &pMainThreadState);
+
+    // A thread's state is freed when it exits.
+    AFX_MODULE_THREAD_STATE* pSeenInTeardown[2] = { nullptr, nullptr };
+    bool bHadState[2] = { true, true };
+    for (int t = 0; t < 2; ++t) {
+        std::thread exiting([&, t] {
+            thread_local TeardownProbe probe{ &pSeenInTeardown[t], &bHadState[t] };
+            (void)probe;
+            GetModuleThreadState();
+        });
+        exiting.join();
+    }
+    check("a thread's module thread state is freed when it exits", !bHadState[0] && !bHadState[1]);
+    check("a call during teardown gets the shared fallback, not a new state",
+          pSeenInTeardown[0] != nullptr && pSeenInTeardown[0] == pSeenInTeardown[1] &&
+          pSeenInTeardown[0] != pMain);
+
+    bool bIdleHasState = true;
+    std::thread idle([&bIdleHasState] { bIdleHasState = ModuleThreadStates::Peek() != nullptr; });
+    idle.join();
+    check("a thread that never asks allocates nothing", !bIdleHasState);
+
+    if (g_failures == 0) {
+        std::printf("ALL CHECKS PASSED\n");
+        return 0;
+    }
+    std::printf("%d CHECK(S) FAILED\n", g_failures);
+    return 1;
+}
@@ -0,0 +1,254 @@
+// Persistence test for the CWinApp profile functions, driven through the
+// real appcore.cpp in INI mode (m_pszProfileName set, no SetRegistryKey).
+//
+// GetProfile*/WriteProfile* used to live only in per-app maps and were lost
+// when the process exited. This writes 1e4 ints, strings and blobs through
+// the exported WriteProfile* entry points, measures per-write latency and
+// ends the app with ExitInstance. A second CWinApp with the same profile
+// name then reloads everything through GetProfile*. The test also checks
+// that:
+// - a hand-edited INI keeps its comments, entries and ANSI encoding;
+// - a write is readable before it is saved;
+// - names are case-insensitive and missing entries get the default;
+// - overwrites, entry deletes and section deletes persist;
+// - a write made after ExitInstance is still saved;
+// - once loaded, reads come from the cache, not the file.
+//
+// Build:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static -DUNICODE -D_UNICODE -I include \
+//       tests/test_profile_store_logic.cpp -o /tmp/test_profile_store.exe
+//   WINEDEBUG=-all wine /tmp/test_profile_store.exe; echo EXIT=$?
+
+#include "../phase4/src/appcore.cpp"
+
+// appcore.cpp's document, dialog, message and exception paths reference
+// members that live in other translation units and are not reached here.
+CRuntimeClass CWnd::classCWnd{};
+CRuntimeClass CException::classCException{};
+int CException::GetErrorMessage(wchar_t*, unsigned int, unsigned int*) const { return 0; }
+void CException::Dump() const {}
+void CException::AssertValid() const {}
+void CFileException::Dump() const {}
+void CFileException::AssertValid() const {}
+void CArchiveException::Dump() const {}
+void CArchiveException::AssertValid() const {}
+CRuntimeClass CDialog::classCDialog{};
+CRuntimeClass CFileDialog::classCFileDialog{};
+CRuntimeClass CPrintDialog::classCPrintDialog{};
+CDialog::CDialog() {}
+CDialog::~CDialog() {}
+intptr_t CDialog::DoModal() { return 0; }
+BOOL CDialog::Create(const wchar_t*, CWnd*) { return FALSE; }
+BOOL CDialog::Create(unsigned int, CWnd*) { return FALSE; }
+int CDialog::OnInitDialog() { return FALSE; }
+void CDialog::OnOK() {}
+void CDialog::OnCancel() {}
+void CDialog::OnSetFont(CWnd*) {}
+CFileDialog::CFileDialog(int, const wchar_t*, const wchar_t*, unsigned long, const wchar_t*, CWnd*, unsigned long, int) {}
+CFileDialog::~CFileDialog() {}
+intptr_t CFileDialog::DoModal() { return 0; }
+CString CFileDialog::GetPathName() const { return CString(); }
+CPrintDialog::CPrintDialog(int, unsigned long, CWnd*) {}
+CPrintDialog::~CPrintDialog() {}
+intptr_t CPrintDialog::DoModal() { return 0; }
+const AFX_MSGMAP_ENTRY* OpenMfcLookupMessageEntry(const AFX_MSGMAP*, UINT, UINT, UINT) { return nullptr; }
+void OpenMfcCleanupTempWrappers() {}
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static int g_failures = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond) ++g_failures;
+}
+
+// A path with a separator is used as given rather than resolved against
+// the Windows directory.
+static const char kIniFile[] = "openmfc_profile_test.ini";
+static const wchar_t kProfileName[] = L".\\openmfc_profile_test.ini";
+static const char kComment[] = "; hand-edited settings, kept across saves\r\n";
+static const char kSeed[] =
+    "; hand-edited settings, kept across saves\r\n"
+    "[Window]\r\n"
+    "Left=10\r\n"
+    "\r\n";
+
+static std::string ReadIniBytes() {
+    std::string bytes;
+    std::FILE* file = std::fopen(kIniFile, "rb");
+    if (!file) return bytes;
+    char buffer[4096];
+    size_t read = 0;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) != 0) bytes.append(buffer, read);
+    std::fclose(file);
+    return bytes;
+}
+
+static CWinApp* OpenApp() {
+    CWinApp* app = new CWinApp(L"ProfileTest");
+    app->m_pszProfileName = kProfileName;
+    return app;
+}
+
+static void CloseApp(CWinApp* app) {
+    impl___1CWinApp__UEAA_XZ(app);
+    delete app;
+}
+
+static unsigned int GetInt(CWinApp* app, const wchar_t* section, const wchar_t* entry, int defaultValue) {
+    return impl__GetProfileIntW_CWinApp__UEAAIPEB_W0H_Z(app, section, entry, defaultValue);
+}
+
+static std::wstring GetString(CWinApp* app, const wchar_t* section, const wchar_t* entry) {
+    alignas(CString) unsigned char storage[sizeof(CString)];
+    CString* value = reinterpret_cast<CString*>(storage);
+    impl__GetProfileStringW_CWinApp__UEAA_AV__CStringT__WV__StrTraitMFC_DLL__WV__ChTraitsCRT__W_ATL_____ATL__PEB_W00_Z(
+        value, app, section, entry, L"<missing>");
+    std::wstring text = static_cast<const wchar_t*>(*value);
+    value->~CString();
+    return text;
+}
+
+static bool GetBinary(CWinApp* app, const wchar_t* section, const wchar_t* entry, std::vector<unsigned char>& blob) {
+    unsigned char* data = nullptr;
+    unsigned int bytes = 0;
+    if (!impl__GetProfileBinary_CWinApp__UEAAHPEB_W0PEAPEAEPEAI_Z(app, section, entry, &data, &bytes)) return false;
+    blob.assign(data, data + bytes);
+    delete[] data;
+    return true;
+}
+
+static void WriteString(CWinApp* app, const wchar_t* section, const wchar_t* entry, const wchar_t* value) {
+    impl__WriteProfileStringW_CWinApp__UEAAHPEB_W00_Z(app, section, entry, value);
+}
+
+static std::wstring EntryName(const wchar_t* prefix, int i) {
+    wchar_t buffer[32];
+    std::swprintf(buffer, 32, L"%ls%d", prefix, i);
+    return buffer;
+}
+
+static std::vector<unsigned char> BlobFor(int i) {
+    std::vector<unsigned char> blob(1 + i % 13);
+    for (size_t k = 0; k < blob.size(); ++k) blob[k] = static_cast<unsigned char>(i * 31 + k * 7);
+    return blob;
+}
+
+int main() {
+    const int kSettings = 10000;
+    {
+        std::FILE* seed = std::fopen(kIniFile, "wb");
+        std::fwrite(kSeed, 1, sizeof(kSeed) - 1, seed);
+        std::fclose(seed);
+    }
+
+    // ---- Session 1: write through the app, end it with ExitInstance -------
+    CWinApp* app = OpenApp();
+    check("a hand-edited entry is loaded", GetInt(app, L"Window", L"Left", -1) == 10);
+    std::vector<double> latencies;
+    latencies.reserve(kSettings);
+    for (int i = 0; i < kSettings; ++i) {
+        const std::wstring entry = EntryName(L"Entry", i);
+        const auto start = std::chrono::steady_clock::now();
+        switch (i % 3) {
+        case 0: impl__WriteProfileInt_CWinApp__UEAAHPEB_W0H_Z(app, L"Ints", entry.c_str(), i - 5000); break;
+        case 1: WriteString(app, L"Strings", entry.c_str(), EntryName(L"value ", i).c_str()); break;
+        default: {
+            std::vector<unsigned char> blob = BlobFor(i);
+            impl__WriteProfileBinary_CWinApp__UEAAHPEB_W0PEAEI_Z(app, L"Blobs", entry.c_str(), blob.data(),
+                                                                 static_cast<unsigned int>(blob.size()));
+            break;
+        }
+        }
+        latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::vector<double> sorted(latencies);
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0;
+    for (double latency : latencies) total += latency;
+    std::printf("write latency over %d settings: mean %.2f us, p50 %.2f us, p99 %.2f us, max %.2f us\n",
+                kSettings, total / kSettings, sorted[kSettings / 2], sorted[kSettings * 99 / 100], sorted.back());
+    check("the median write does not wait for the disk", sorted[kSettings / 2] < 100.0);
+    check("a write is readable before it is saved",
+          static_cast<int>(GetInt(app, L"Ints", L"Entry3", 0)) == 3 - 5000);
+
+    const auto exitStart = std::chrono::steady_clock::now();
+    impl__ExitInstance_CWinApp__UEAAHXZ(app);
+    std::printf("ExitInstance took %.2f ms\n",
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - exitStart).count());
+    {
+        const std::string bytes = ReadIniBytes();
+        check("the INI keeps its comment line", bytes.compare(0, sizeof(kComment) - 1, kComment) == 0);
+        check("and its hand-edited entry", bytes.find("[Window]\r\nLeft=10\r\n") != std::string::npos);
+        check("and stays ANSI", bytes.compare(0, 3, "\xEF\xBB\xBF") != 0 && bytes.compare(0, 2, "\xFF\xFE") != 0);
+        check("ExitInstance saved the settings", bytes.find("Entry9999=") != std::string::npos);
+    }
+
+    // ---- Session 2: a new app object sees everything from disk ------------
+    CWinApp* reloaded = OpenApp();
+    int wrong = 0;
+    for (int i = 0; i < kSettings; ++i) {
+        const std::wstring entry = EntryName(L"Entry", i);
+        switch (i % 3) {
+        case 0:
+            if (static_cast<int>(GetInt(reloaded, L"Ints", entry.c_str(), 0)) != i - 5000) ++wrong;
+            break;
+        case 1:
+            if (GetString(reloaded, L"Strings", entry.c_str()) != EntryName(L"value ", i)) ++wrong;
+            break;
+        default: {
+            std::vector<unsigned char> blob;
+            if (!GetBinary(reloaded, L"Blobs", entry.c_str(), blob) || blob != BlobFor(i)) ++wrong;
+            break;
+        }
+        }
+    }
+    check("all 1e4 settings survive a reload in a new CWinApp", wrong == 0);
+    check("names are case-insensitive", GetString(reloaded, L"STRINGS", L"entry1") == L"value 1");
+    check("a missing entry gets the default", GetInt(reloaded, L"Ints", L"Missing", 77) == 77 &&
+                                              GetString(reloaded, L"Ints", L"Missing") == L"<missing>");
+
+    // Overwrites and deletes persist too.
+    impl__WriteProfileInt_CWinApp__UEAAHPEB_W0H_Z(reloaded, L"Ints", L"Entry0", 1);
+    impl__WriteProfileInt_CWinApp__UEAAHPEB_W0H_Z(reloaded, L"Ints", L"Entry0", 2);
+    WriteString(reloaded, L"Strings", L"Entry1", nullptr);
+    WriteString(reloaded, L"Blobs", nullptr, nullptr);
+    WriteString(reloaded, L"Blobs", L"Fresh", L"after delete");
+    check("a deleted entry is gone at once", GetString(reloaded, L"Strings", L"Entry1") == L"<missing>");
+    impl__ExitInstance_CWinApp__UEAAHXZ(reloaded);
+    WriteString(reloaded, L"Late", L"Entry", L"after ExitInstance");
+    CloseApp(reloaded);
+    CloseApp(app);
+
+    // ---- Session 3 --------------------------------------------------------
+    app = OpenApp();
+    check("the last of repeated writes wins", GetInt(app, L"Ints", L"Entry0", 0) == 2);
+    check("a deleted entry stays deleted", GetString(app, L"Strings", L"Entry1") == L"<missing>");
+    check("its neighbours remain", GetString(app, L"Strings", L"Entry4") == L"value 4");
+    std::vector<unsigned char> blob;
+    check("a deleted section stays deleted", !GetBinary(app, L"Blobs", L"Entry2", blob));
+    check("a write after a section delete persists", GetString(app, L"Blobs", L"Fresh") == L"after delete");
+    check("a write after ExitInstance persists", GetString(app, L"Late", L"Entry") == L"after ExitInstance");
+    check("the comment survives deletes", ReadIniBytes().compare(0, sizeof(kComment) - 1, kComment) == 0);
+
+    // The profile was read once, on first use; later reads do not go back
+    // to the file.
+    std::remove(kIniFile);
+    check("reads come from the warm cache", GetInt(app, L"Window", L"Left", -1) == 10 &&
+                                            GetString(app, L"Strings", L"Entry7") == L"value 7");
+    impl__ExitInstance_CWinApp__UEAAHXZ(app);
+    CloseApp(app);
+    std::remove(kIniFile);
+
+    if (g_failures == 0) {
+        std::printf("ALL CHECKS PASSED\n");
+        return 0;
+    }
+    std::printf("%d CHECK(S) FAILED\n", g_failures);
+    return 1;
+}
@@ -0,0 +1,564 @@
+// Behavioral test for CRecordset bulk row fetching (useMultiRowFetch),
+// driven through the real dbcore.cpp over an in-memory ODBC driver.
+//
+// Build:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static -DUNICODE -D_UNICODE -I include \
+//       tests/test_recordset_bulk_logic.cpp -o /tmp/test_recordset_bulk.exe
+//   WINEDEBUG=-all wine /tmp/test_recordset_bulk.exe; echo EXIT=$?
+//
+// The SQL* entry points dbcore.cpp calls are defined below (no -lodbc32):
+// one table of kRows rows (id, name), scrolled with the ODBC 3 rowset rules
+// and written column-wise into whatever SQLBindCol bound. The test checks:
+// - RFX_*_Bulk allocate and bind one value and one length array per column
+//   at the rowset size the driver accepted;
+// - MoveNext / MovePrev fetch whole SQL_FETCH_NEXT / SQL_FETCH_PRIOR
+//   rowsets, one driver call each, with row status and rows fetched;
+// - MoveNextRow / MovePrevRow step through the fetched rows and go back to
+//   the driver only at either end of the rowset;
+// - SetRowsetSize on an open recordset rebinds and refetches from the
+//   current row; Close unbinds and frees the arrays.
+// Rows/sec for a MoveNext scan of a 1e6-row table at rowset sizes 1, 100
+// and 10,000 are printed. The in-memory driver has no per-call round trip,
+// so the figures show dbcore.cpp's own per-fetch cost; only the fetch
+// counts are checked.
+
+#include "../phase4/src/dbcore.cpp"
+
+// dbcore.cpp's CRecordView pulls in the CFormView / CScrollView / CView
+// vtables and CDBException's base class; those live in docview.cpp,
+// wincore.cpp, appcore.cpp and mfc_exceptions.cpp and are not reached here.
+CRuntimeClass CCmdTarget::classCCmdTarget{};
+CRuntimeClass CWnd::classCWnd{};
+CRuntimeClass CException::classCException{};
+CRuntimeClass CView::classCView{};
+CRuntimeClass CScrollView::classCScrollView{};
+CRuntimeClass CFormView::classCFormView{};
+int CException::GetErrorMessage(wchar_t*, unsigned int, unsigned int*) const { return FALSE; }
+void CException::Dump() const {}
+void CException::AssertValid() const {}
+CCmdTarget::~CCmdTarget() {}
+int CCmdTarget::OnCmdMsg(unsigned int, int, void*, void*) { return 0; }
+const AFX_MSGMAP* CCmdTarget::GetMessageMap() const { return nullptr; }
+CView::CView() {}
+CView::~CView() {}
+void CView::OnUpdate(CView*, unsigned long, CObject*) {}
+void CView::OnInitialUpdate() {}
+CDocument* CView::GetDocument() const { return nullptr; }
+CFrameWnd* CView::GetParentFrame() const { return nullptr; }
+int CView::OnPreparePrinting(void*) { return 0; }
+void CView::OnBeginPrinting(void*, void*) {}
+void CView::OnEndPrinting(void*, void*) {}
+void CView::OnActivateView(int, CView*, CView*) {}
+DWORD CView::OnDragEnter(COleDataObject*, DWORD, CPoint) { return 0; }
+DWORD CView::OnDragOver(COleDataObject*, DWORD, CPoint) { return 0; }
+BOOL CView::OnDrop(COleDataObject*, DWORD, CPoint) { return FALSE; }
+DWORD CView::OnDropEx(COleDataObject*, DWORD, DWORD, CPoint) { return 0; }
+CScrollView::CScrollView() {}
+CScrollView::~CScrollView() {}
+void CScrollView::SetScrollSizes(int, const SIZE&, const SIZE&, const SIZE&) {}
+void CScrollView::GetScrollBarSizes(SIZE&) {}
+void CScrollView::GetTrueClientSize(SIZE&, SIZE&) const {}
+void CScrollView::ScrollToPosition(POINT) {}
+CPoint CScrollView::GetScrollPosition() const { return CPoint(); }
+void CScrollView::FillOutsideRect(void*, void*) {}
+void CScrollView::ResizeParentToFit(int) {}
+void CScrollView::OnUpdate(CView*, unsigned long, CObject*) {}
+void CScrollView::OnInitialUpdate() {}
+void CScrollView::OnDraw(void*) {}
+CFormView::~CFormView() {}
+BOOL CFormView::Create(const wchar_t*, const wchar_t*, DWORD, const struct tagRECT&, CWnd*, unsigned int,
+                       CCreateContext*) { return FALSE; }
+void CFormView::DoDataExchange(void*) {}
+void CFormView::OnInitialUpdate() {}
+void CFormView::OnDraw(void*) {}
+
+#include <chrono>
+#include <cstdio>
+#include <cwchar>
+#include <map>
+
+static int g_failures = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond) ++g_failures;
+}
+
+//=============================================================================
+// In-memory ODBC driver
+//=============================================================================
+namespace stubodbc {
+
+const long kRows = 1003;
+const SQLULEN kMaxRowsetSize = 500;   // larger ROW_ARRAY_SIZE requests are lowered
+
+// The benchmark raises both for its scan.
+long g_nTableRows = kRows;
+SQLULEN g_nMaxRowsetSize = kMaxRowsetSize;
+
+struct Binding {
+    SQLSMALLINT nCType = 0;
+    SQLPOINTER pValues = nullptr;
+    SQLLEN nValueSize = 0;
+    SQLLEN* pLengths = nullptr;
+};
+
+struct Handle {
+    SQLSMALLINT nType = 0;
+    // Statements only.
+    std::map<SQLUSMALLINT, Binding> bindings;
+    SQLULEN nRowsetSize = 1;
+    SQLUSMALLINT* pRowStatus = nullptr;
+    SQLULEN* pRowsFetched = nullptr;
+    long nRowsetStart = 0;   // 0 before the first row, g_nTableRows + 1 after the last
+    long nRowsetCount = 0;
+    SQLULEN nPosition = 0;   // SQLSetPos row
+};
+
+long g_nFetchCalls = 0;
+long g_nRowsDelivered = 0;
+long g_nLiveStatements = 0;
+
+// L"row<n>"; cheaper than swprintf, so the benchmark times dbcore.cpp
+// rather than the driver's formatting.
+int FormatName(wchar_t* szName, long nRow) {
+    wchar_t szDigits[24];
+    int nDigits = 0;
+    do {
+        szDigits[nDigits++] = static_cast<wchar_t>(L'0' + nRow % 10);
+        nRow /= 10;
+    } while (nRow != 0);
+    int n = 0;
+    szName[n++] = L'r';
+    szName[n++] = L'o';
+    szName[n++] = L'w';
+    while (nDigits != 0) szName[n++] = szDigits[--nDigits];
+    szName[n] = L'\0';
+    return n;
+}
+
+void FillRow(Handle& stmt, SQLULEN nIndex, long nRow) {
+    for (auto& entry : stmt.bindings) {
+        Binding& binding = entry.second;
+        char* pValue = static_cast<char*>(binding.pValues) + nIndex * binding.nValueSize;
+        SQLLEN nLength = 0;
+        if (entry.first == 1 && binding.nCType == SQL_C_LONG) {
+            const int nId = static_cast<int>(nRow);
+            std::memcpy(pValue, &nId, sizeof(nId));
+            nLength = sizeof(nId);
+        } else if (entry.first == 2 && binding.nCType == SQL_C_WCHAR) {
+            wchar_t szName[32];
+            const int n = FormatName(szName, nRow);
+            const size_t nMax = static_cast<size_t>(binding.nValueSize) / sizeof(wchar_t);
+            std::wmemcpy(reinterpret_cast<wchar_t*>(pValue), szName, std::min<size_t>(n + 1, nMax));
+            nLength = n * static_cast<SQLLEN>(sizeof(wchar_t));
+        } else {
+            nLength = SQL_NULL_DATA;
+        }
+        if (binding.pLengths) binding.pLengths[nIndex] = nLength;
+    }
+}
+
+// Positions the rowset at nStart (clipped to the result set) and delivers it.
+SQLRETURN Deliver(Handle& stmt, long nStart, SQLRETURN rcFound) {
+    ++g_nFetchCalls;
+    if (nStart < 1 || nStart > g_nTableRows) {
+        stmt.nRowsetStart = nStart < 1 ? 0 : g_nTableRows + 1;
+        stmt.nRowsetCount = 0;
+        if (stmt.pRowsFetched) *stmt.pRowsFetched = 0;
+        return SQL_NO_DATA;
+    }
+    const long nCount = std::min<long>(static_cast<long>(stmt.nRowsetSize), g_nTableRows - nStart + 1);
+    for (SQLULEN i = 0; i < stmt.nRowsetSize; ++i) {
+        if (static_cast<long>(i) < nCount) FillRow(stmt, i, nStart + static_cast<long>(i));
+        if (stmt.pRowStatus) stmt.pRowStatus[i] = static_cast<long>(i) < nCount ? SQL_ROW_SUCCESS : SQL_ROW_NOROW;
+    }
+    if (stmt.pRowsFetched) *stmt.pRowsFetched = static_cast<SQLULEN>(nCount);
+    stmt.nRowsetStart = nStart;
+    stmt.nRowsetCount = nCount;
+    g_nRowsDelivered += nCount;
+    return rcFound;
+}
+
+} // namespace stubodbc
+
+using stubodbc::Handle;
+
+extern "C" {
+
+SQLRETURN SQL_API SQLAllocHandle(SQLSMALLINT nType, SQLHANDLE, SQLHANDLE* phOut) {
+    Handle* pHandle = new Handle;
+    pHandle->nType = nType;
+    if (nType == SQL_HANDLE_STMT) ++stubodbc::g_nLiveStatements;
+    *phOut = pHandle;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLFreeHandle(SQLSMALLINT nType, SQLHANDLE hHandle) {
+    if (nType == SQL_HANDLE_STMT) --stubodbc::g_nLiveStatements;
+    delete static_cast<Handle*>(hHandle);
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLBindCol(SQLHSTMT hstmt, SQLUSMALLINT nColumn, SQLSMALLINT nCType, SQLPOINTER pValues,
+                             SQLLEN nValueSize, SQLLEN* pLengths) {
+    stubodbc::Binding& binding = static_cast<Handle*>(hstmt)->bindings[nColumn];
+    binding.nCType = nCType;
+    binding.pValues = pValues;
+    binding.nValueSize = nValueSize;
+    binding.pLengths = pLengths;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLFreeStmt(SQLHSTMT hstmt, SQLUSMALLINT nOption) {
+    Handle& stmt = *static_cast<Handle*>(hstmt);
+    if (nOption == SQL_UNBIND) stmt.bindings.clear();
+    if (nOption == SQL_CLOSE) stmt.nRowsetStart = 0;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLSetStmtAttr(SQLHSTMT hstmt, SQLINTEGER nAttr, SQLPOINTER pValue, SQLINTEGER) {
+    Handle& stmt = *static_cast<Handle*>(hstmt);
+    switch (nAttr) {
+    case SQL_ATTR_ROW_ARRAY_SIZE: {
+        const SQLULEN nAsked = reinterpret_cast<SQLULEN>(pValue);
+        stmt.nRowsetSize = std::min(nAsked, stubodbc::g_nMaxRowsetSize);
+        return stmt.nRowsetSize == nAsked ? SQL_SUCCESS : SQL_SUCCESS_WITH_INFO;
+    }
+    case SQL_ATTR_ROW_STATUS_PTR:
+        stmt.pRowStatus = static_cast<SQLUSMALLINT*>(pValue);
+        return SQL_SUCCESS;
+    case SQL_ATTR_ROWS_FETCHED_PTR:
+        stmt.pRowsFetched = static_cast<SQLULEN*>(pValue);
+        return SQL_SUCCESS;
+    default:
+        return SQL_SUCCESS;
+    }
+}
+
+SQLRETURN SQL_API SQLGetStmtAttr(SQLHSTMT hstmt, SQLINTEGER nAttr, SQLPOINTER pValue, SQLINTEGER, SQLINTEGER*) {
+    if (nAttr != SQL_ATTR_ROW_ARRAY_SIZE) return SQL_ERROR;
+    *static_cast<SQLULEN*>(pValue) = static_cast<Handle*>(hstmt)->nRowsetSize;
+    return SQL_SUCCESS;
+}
+
+// ODBC 3 rowset positioning; nRowsetSize is the size of both the current
+// and the new rowset.
+SQLRETURN SQL_API SQLFetchScroll(SQLHSTMT hstmt, SQLSMALLINT nOrientation, SQLLEN nOffset) {
+    const long nRows = stubodbc::g_nTableRows;
+    Handle& stmt = *static_cast<Handle*>(hstmt);
+    const long nSize = static_cast<long>(stmt.nRowsetSize);
+    const long nStart = stmt.nRowsetStart;
+    switch (nOrientation) {
+    case SQL_FETCH_NEXT:
+        return stubodbc::Deliver(stmt, nStart == 0 ? 1 : nStart + nSize, SQL_SUCCESS);
+    case SQL_FETCH_PRIOR:
+        if (nStart == 0 || nStart == 1) return stubodbc::Deliver(stmt, 0, SQL_SUCCESS);
+        if (nStart > nRows) return stubodbc::Deliver(stmt, std::max(1L, nRows - nSize + 1), SQL_SUCCESS);
+        if (nStart <= nSize) return stubodbc::Deliver(stmt, 1, SQL_SUCCESS_WITH_INFO);
+        return stubodbc::Deliver(stmt, nStart - nSize, SQL_SUCCESS);
+    case SQL_FETCH_FIRST:
+        return stubodbc::Deliver(stmt, 1, SQL_SUCCESS);
+    case SQL_FETCH_LAST:
+        return stubodbc::Deliver(stmt, std::max(1L, nRows - nSize + 1), SQL_SUCCESS);
+    case SQL_FETCH_ABSOLUTE:
+        return stubodbc::Deliver(stmt, static_cast<long>(nOffset), SQL_SUCCESS);
+    case SQL_FETCH_RELATIVE:
+        return stubodbc::Deliver(stmt, nStart + static_cast<long>(nOffset), SQL_SUCCESS);
+    default:
+        return SQL_ERROR;
+    }
+}
+
+SQLRETURN SQL_API SQLSetPos(SQLHSTMT hstmt, SQLSETPOSIROW nRow, SQLUSMALLINT nOperation, SQLUSMALLINT) {
+    Handle& stmt = *static_cast<Handle*>(hstmt);
+    if (nOperation != SQL_POSITION || nRow == 0 || static_cast<long>(nRow) > stmt.nRowsetCount) return SQL_ERROR;
+    stmt.nPosition = nRow;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLExecute(SQLHSTMT hstmt) {
+    static_cast<Handle*>(hstmt)->nRowsetStart = 0;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLExecDirectW(SQLHSTMT hstmt, SQLWCHAR*, SQLINTEGER) {
+    return SQLExecute(hstmt);
+}
+
+SQLRETURN SQL_API SQLNumResultCols(SQLHSTMT, SQLSMALLINT* pnCols) {
+    *pnCols = 2;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLCloseCursor(SQLHSTMT hstmt) {
+    static_cast<Handle*>(hstmt)->nRowsetStart = 0;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLPrepareW(SQLHSTMT, SQLWCHAR*, SQLINTEGER) { return SQL_SUCCESS; }
+SQLRETURN SQL_API SQLDriverConnectW(SQLHDBC, SQLHWND, SQLWCHAR*, SQLSMALLINT, SQLWCHAR*, SQLSMALLINT, SQLSMALLINT*,
+                                    SQLUSMALLINT) { return SQL_SUCCESS; }
+SQLRETURN SQL_API SQLDisconnect(SQLHDBC) { return SQL_SUCCESS; }
+SQLRETURN SQL_API SQLSetEnvAttr(SQLHENV, SQLINTEGER, SQLPOINTER, SQLINTEGER) { return SQL_SUCCESS; }
+SQLRETURN SQL_API SQLSetConnectAttr(SQLHDBC, SQLINTEGER, SQLPOINTER, SQLINTEGER) { return SQL_SUCCESS; }
+SQLRETURN SQL_API SQLEndTran(SQLSMALLINT, SQLHANDLE, SQLSMALLINT) { return SQL_SUCCESS; }
+SQLRETURN SQL_API SQLCancel(SQLHSTMT) { return SQL_SUCCESS; }
+SQLRETURN SQL_API SQLMoreResults(SQLHSTMT) { return SQL_NO_DATA; }
+SQLRETURN SQL_API SQLGetInfo(SQLHDBC, SQLUSMALLINT, SQLPOINTER, SQLSMALLINT, SQLSMALLINT*) { return SQL_ERROR; }
+SQLRETURN SQL_API SQLGetData(SQLHSTMT, SQLUSMALLINT, SQLSMALLINT, SQLPOINTER, SQLLEN, SQLLEN*) { return SQL_ERROR; }
+SQLRETURN SQL_API SQLDescribeColW(SQLHSTMT, SQLUSMALLINT, SQLWCHAR*, SQLSMALLINT, SQLSMALLINT*, SQLSMALLINT*, SQLULEN*,
+                                  SQLSMALLINT*, SQLSMALLINT*) { return SQL_ERROR; }
+SQLRETURN SQL_API SQLGetDiagRecW(SQLSMALLINT, SQLHANDLE, SQLSMALLINT, SQLWCHAR*, SQLINTEGER*, SQLWCHAR*, SQLSMALLINT,
+                                 SQLSMALLINT*) { return SQL_NO_DATA; }
+SQLRETURN SQL_API SQLBindParameter(SQLHSTMT, SQLUSMALLINT, SQLSMALLINT, SQLSMALLINT, SQLSMALLINT, SQLULEN, SQLSMALLINT,
+                                   SQLPOINTER, SQLLEN, SQLLEN*) { return SQL_SUCCESS; }
+
+} // extern "C"
+
+//=============================================================================
+// Test recordset
+//=============================================================================
+class CRowsRecordset : public CRecordset {
+public:
+    static const int kNameChars = 16;
+
+    explicit CRowsRecordset(CDatabase* pDatabase) : CRecordset(pDatabase) {}
+    CString GetDefaultSQL() override { return CString(L"SELECT id, name FROM rows"); }
+    void DoBulkFieldExchange(CFieldExchange* pFX) override {
+        RFX_Int_Bulk(pFX, L"id", &m_rgID, &m_rgIDLengths);
+        RFX_Text_Bulk(pFX, L"name", &m_rgName, &m_rgNameLengths, kNameChars);
+    }
+
+    // The current row's id, read from the bulk arrays.
+    int CurrentID() const { return m_rgID[GetRowsetCursorPosition() - 1]; }
+    const wchar_t* CurrentName() const { return m_rgName + (GetRowsetCursorPosition() - 1) * kNameChars; }
+
+    int* m_rgID = nullptr;
+    __int64* m_rgIDLengths = nullptr;
+    wchar_t* m_rgName = nullptr;
+    __int64* m_rgNameLengths = nullptr;
+};
+
+// True if the fetched rowset holds rows nFirst, nFirst + 1, ... with their
+// names, lengths and row status.
+static bool RowsetHolds(const CRowsRecordset& rs, long nFirst, DWORD nCount) {
+    if (rs.GetRowsFetched() != nCount) return false;
+    for (DWORD i = 0; i < nCount; ++i) {
+        wchar_t szName[32];
+        std::swprintf(szName, 32, L"row%ld", nFirst + static_cast<long>(i));
+        if (rs.m_rgID[i] != nFirst + static_cast<long>(i) || rs.m_rgIDLengths[i] != sizeof(int) ||
+            std::wcscmp(rs.m_rgName + i * CRowsRecordset::kNameChars, szName) != 0 ||
+            rs.m_rgNameLengths[i] != static_cast<__int64>(std::wcslen(szName) * sizeof(wchar_t)) ||
+            rs.GetRowStatus(static_cast<WORD>(i + 1)) != SQL_ROW_SUCCESS) {
+            return false;
+        }
+    }
+    return rs.GetRowStatus(static_cast<WORD>(nCount + 1)) == SQL_ROW_NOROW;
+}
+
+struct ScanResult {
+    double rowsPerSec;
+    long nFetchCalls;
+    bool bComplete;
+};
+
+// Reads every row's id and name with MoveNext, a rowset at a time.
+static ScanResult ScanTable(CDatabase& db, long nRowsetSize) {
+    CRowsRecordset rs(&db);
+    rs.SetRowsetSize(static_cast<DWORD>(nRowsetSize));
+    rs.Open(CRecordset::snapshot, nullptr, CRecordset::useMultiRowFetch);
+    stubodbc::g_nFetchCalls = 0;
+    long nRows = 0;
+    long long nSum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (rs.MoveNext(); !rs.IsEOF(); rs.MoveNext()) {
+        const DWORD nCount = rs.GetRowsFetched();
+        for (DWORD i = 0; i < nCount; ++i) nSum += rs.m_rgID[i] + rs.m_rgName[i * CRowsRecordset::kNameChars];
+        nRows += static_cast<long>(nCount);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const long nFetchCalls = stubodbc::g_nFetchCalls;
+    rs.Close();
+    const long long nIds = static_cast<long long>(nRows) * (nRows + 1) / 2;
+    return ScanResult{nRows / seconds, nFetchCalls, nRows == stubodbc::g_nTableRows &&
+                                               nSum == nIds + static_cast<long long>(L'r') * nRows};
+}
+
+int main() {
+    using stubodbc::g_nFetchCalls;
+    using stubodbc::g_nRowsDelivered;
+    using stubodbc::kRows;
+
+    CDatabase db;
+    check("database opens on the stub driver", db.Open(nullptr, FALSE, FALSE, L"DSN=stub;") == TRUE);
+
+    // ---- Binding ------------------------------------------------------------
+    {
+        CRowsRecordset rs(&db);
+        rs.SetRowsetSize(100);
+        check("bulk Open", rs.Open(CRecordset::snapshot, nullptr, CRecordset::useMultiRowFetch) == TRUE);
+        check("RFX_*_Bulk allocate every array",
+              rs.m_rgID && rs.m_rgIDLengths && rs.m_rgName && rs.m_rgNameLengths);
+        Handle& stmt = *static_cast<Handle*>(rs.GetHSTMT());
+        check("columns bound column-wise at the rowset size",
+              stmt.bindings.size() == 2 && stmt.nRowsetSize == 100 &&
+              stmt.bindings[1].pValues == rs.m_rgID && stmt.bindings[1].nCType == SQL_C_LONG &&
+              stmt.bindings[2].pValues == rs.m_rgName &&
+              stmt.bindings[2].nValueSize == CRowsRecordset::kNameChars * sizeof(wchar_t) &&
+              reinterpret_cast<__int64*>(stmt.bindings[2].pLengths) == rs.m_rgNameLengths);
+        rs.Close();
+        check("Close frees the arrays and clears the members", rs.m_rgID == nullptr && rs.m_rgName == nullptr);
+    }
+    {
+        CRowsRecordset rs(&db);
+        rs.SetRowsetSize(5000);
+        rs.Open(CRecordset::snapshot, nullptr, CRecordset::useMultiRowFetch);
+        check("a rowset size the driver lowers is reported as accepted", rs.GetRowsetSize() == 500);
+        rs.Close();
+    }
+
+    // ---- MoveNext / MovePrev fetch whole rowsets ----------------------------
+    {
+        CRowsRecordset rs(&db);
+        rs.SetRowsetSize(100);
+        rs.Open(CRecordset::snapshot, nullptr, CRecordset::useMultiRowFetch);
+
+        g_nFetchCalls = 0;
+        g_nRowsDelivered = 0;
+        long nRowsSeen = 0;
+        long nRowsets = 0;
+        bool bIntact = true;
+        long nExpectFirst = 1;
+        for (rs.MoveNext(); !rs.IsEOF(); rs.MoveNext()) {
+            const DWORD nCount = rs.GetRowsFetched();
+            bIntact = bIntact && RowsetHolds(rs, nExpectFirst, nCount) && rs.GetRowsetCursorPosition() == 1 &&
+                      rs.GetAbsolutePosition() == nExpectFirst;
+            nExpectFirst += static_cast<long>(nCount);
+            nRowsSeen += static_cast<long>(nCount);
+            ++nRowsets;
+        }
+        check("MoveNext walks every row exactly once, a rowset at a time",
+              bIntact && nRowsSeen == kRows && nRowsets == (kRows + 99) / 100);
+        check("one SQL_FETCH_NEXT per rowset, plus the one that hits the end",
+              g_nFetchCalls == nRowsets + 1 && g_nRowsDelivered == kRows);
+        check("no rows fetched at EOF", rs.GetRowsFetched() == 0 && RowsetHolds(rs, 0, 0));
+
+        rs.MovePrev();
+        check("MovePrev past the end fetches the last full rowset",
+              !rs.IsEOF() && RowsetHolds(rs, kRows - 99, 100) && rs.GetAbsolutePosition() == kRows - 99);
+        rs.MovePrev();
+        check("MovePrev fetches the prior rowset", RowsetHolds(rs, kRows - 199, 100) &&
+                                                   rs.GetAbsolutePosition() == kRows - 199);
+        rs.Move(50, SQL_FETCH_ABSOLUTE);
+        rs.MovePrev();
+        check("MovePrev near the start clips to the first rowset",
+              RowsetHolds(rs, 1, 100) && rs.GetAbsolutePosition() == 1);
+        rs.MovePrev();
+        check("MovePrev from the first rowset reaches BOF", rs.IsBOF() && rs.GetRowsFetched() == 0);
+        rs.MoveFirst();
+        check("MoveFirst", !rs.IsBOF() && RowsetHolds(rs, 1, 100) && rs.GetAbsolutePosition() == 1);
+        rs.MoveLast();
+        check("MoveLast puts the cursor on the first row of the last rowset",
+              RowsetHolds(rs, kRows - 99, 100) && rs.GetRowsetCursorPosition() == 1);
+        rs.Close();
+    }
+
+    // ---- MoveNextRow / MovePrevRow step within the rowset -------------------
+    {
+        CRowsRecordset rs(&db);
+        rs.SetRowsetSize(100);
+        rs.Open(CRecordset::snapshot, nullptr, CRecordset::useMultiRowFetch);
+
+        g_nFetchCalls = 0;
+        long nExpect = 1;
+        bool bInOrder = true;
+        for (rs.MoveNextRow(); !rs.IsEOF(); rs.MoveNextRow()) {
+            wchar_t szName[32];
+            std::swprintf(szName, 32, L"row%ld", nExpect);
+            bInOrder = bInOrder && rs.CurrentID() == nExpect && rs.GetAbsolutePosition() == nExpect &&
+                       std::wcscmp(rs.CurrentName(), szName) == 0;
+            ++nExpect;
+        }
+        check("MoveNextRow visits every row in order", bInOrder && nExpect == kRows + 1);
+        check("and goes to the driver only at the end of each rowset",
+              g_nFetchCalls == (kRows + 99) / 100 + 1);
+
+        g_nFetchCalls = 0;
+        bInOrder = true;
+        for (rs.MovePrevRow(); !rs.IsBOF(); rs.MovePrevRow()) {
+            --nExpect;
+            bInOrder = bInOrder && rs.CurrentID() == nExpect && rs.GetAbsolutePosition() == nExpect;
+        }
+        check("MovePrevRow visits every row back to the first", bInOrder && nExpect == 1);
+        check("and fetches only at the start of each rowset", g_nFetchCalls == (kRows + 99) / 100 + 1);
+
+        rs.MoveFirst();
+        rs.MoveNextRow();
+        rs.MoveNextRow();
+        rs.MoveNext();
+        check("MoveNext after stepping fetches the next whole rowset",
+              RowsetHolds(rs, 101, 100) && rs.GetRowsetCursorPosition() == 1 && rs.GetAbsolutePosition() == 101);
+        rs.Close();
+    }
+
+    // ---- SetRowsetSize on an open recordset ---------------------------------
+    {
+        CRowsRecordset rs(&db);
+        rs.SetRowsetSize(10);
+        rs.Open(CRecordset::snapshot, nullptr, CRecordset::useMultiRowFetch);
+        rs.MoveNext();
+        for (int i = 0; i < 3; ++i) rs.MoveNextRow();
+        int* pOld = rs.m_rgID;
+        rs.SetRowsetSize(50);
+        check("SetRowsetSize rebinds the arrays at the new size",
+              static_cast<Handle*>(rs.GetHSTMT())->nRowsetSize == 50 &&
+              static_cast<Handle*>(rs.GetHSTMT())->bindings[1].pValues == rs.m_rgID && rs.m_rgID != pOld);
+        check("and refetches from the current row", RowsetHolds(rs, 4, 50) && rs.GetAbsolutePosition() == 4);
+        rs.Close();
+    }
+
+    // ---- Single-row recordsets are untouched --------------------------------
+    {
+        CRowsRecordset rs(&db);
+        rs.Open(CRecordset::snapshot, nullptr, CRecordset::none);
+        check("no bulk arrays without useMultiRowFetch", rs.m_rgID == nullptr && rs.GetRowsFetched() == 0);
+        g_nFetchCalls = 0;
+        rs.MoveNext();
+        rs.MoveNext();
+        check("MoveNext fetches one row per call", g_nFetchCalls == 2 && rs.GetAbsolutePosition() == 2);
+        rs.Close();
+    }
+
+    // ---- Throughput by rowset size ------------------------------------------
+    {
+        const long kBenchRows = 1000000;
+        stubodbc::g_nTableRows = kBenchRows;
+        stubodbc::g_nMaxRowsetSize = 10000;
+        const long sizes[] = {1, 100, 10000};
+        ScanResult results[3];
+        std::printf("MoveNext scan of %ld rows:\n", kBenchRows);
+        for (int i = 0; i < 3; ++i) {
+            results[i] = ScanTable(db, sizes[i]);
+            std::printf("  rowset %5ld: %12.0f rows/sec, %7ld driver fetches\n", sizes[i], results[i].rowsPerSec,
+                        results[i].nFetchCalls);
+        }
+        check("every rowset size reads the whole table",
+              results[0].bComplete && results[1].bComplete && results[2].bComplete);
+        check("fetches drop with the rowset size", results[0].nFetchCalls == kBenchRows + 1 &&
+                                                   results[1].nFetchCalls == kBenchRows / 100 + 1 &&
+                                                   results[2].nFetchCalls == kBenchRows / 10000 + 1);
+        stubodbc::g_nTableRows = kRows;
+        stubodbc::g_nMaxRowsetSize = stubodbc::kMaxRowsetSize;
+    }
+
+    db.Close();
+    check("every statement handle freed", stubodbc::g_nLiveStatements == 0);
+
+    if (g_failures == 0) {
+        std::printf("ALL CHECKS PASSED\n");
+        return 0;
+    }
+    std::printf("%d CHECK(S) FAILED\n", g_failures);
+    return 1;
+}
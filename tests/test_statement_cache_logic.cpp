@@ -0,0 +1,419 @@
+// Behavioral test for the CDatabase prepared-statement cache and
+// ExecuteSQLBatch, driven through the real dbcore.cpp over a stub ODBC
+// driver.
+//
+// Build:
+//   x86_64-w64-mingw32-g++ -O2 -std=c++17 -static -DUNICODE -D_UNICODE -I include \
+//       tests/test_statement_cache_logic.cpp -o /tmp/test_statement_cache.exe
+//   WINEDEBUG=-all wine /tmp/test_statement_cache.exe; echo EXIT=$?
+//
+// The SQL* entry points dbcore.cpp calls are defined below (no -lodbc32).
+// They count prepares, direct executions and executions per statement, and
+// refuse cursor attributes on a prepared statement with HY011 as drivers
+// do, and tokenize the SQL text on every prepare and direct execution as
+// a stand-in for the driver's parser. The test checks:
+// - the cache is off by default: ExecuteSQL runs SQLExecDirect on a
+//   statement it frees at once;
+// - once sized, ExecuteSQL and ExecuteSQLBatch prepare each text once,
+//   keep at most that many idle statements and free the oldest;
+// - ExecuteSQLBatch runs parameter arrays as one PARAMSET_SIZE execution,
+//   or row by row when the driver will not take the size;
+// - CRecordset::Open runs OnSetOptions on a new statement before preparing
+//   it, every time, with or without the cache.
+// Rows/sec for 1e5 single-row INSERTs through ExecuteSQL with the cache
+// off and on, and through ExecuteSQLBatch, are printed.
+
+#include "../phase4/src/dbcore.cpp"
+
+// dbcore.cpp's CRecordView pulls in the CFormView / CScrollView / CView
+// vtables and CDBException's base class; those live in docview.cpp,
+// wincore.cpp, appcore.cpp and mfc_exceptions.cpp and are not reached here.
+CRuntimeClass CCmdTarget::classCCmdTarget{};
+CRuntimeClass CWnd::classCWnd{};
+CRuntimeClass CException::classCException{};
+CRuntimeClass CView::classCView{};
+CRuntimeClass CScrollView::classCScrollView{};
+CRuntimeClass CFormView::classCFormView{};
+int CException::GetErrorMessage(wchar_t*, unsigned int, unsigned int*) const { return FALSE; }
+void CException::Dump() const {}
+void CException::AssertValid() const {}
+CCmdTarget::~CCmdTarget() {}
+int CCmdTarget::OnCmdMsg(unsigned int, int, void*, void*) { return 0; }
+const AFX_MSGMAP* CCmdTarget::GetMessageMap() const { return nullptr; }
+CView::CView() {}
+CView::~CView() {}
+void CView::OnUpdate(CView*, unsigned long, CObject*) {}
+void CView::OnInitialUpdate() {}
+CDocument* CView::GetDocument() const { return nullptr; }
+CFrameWnd* CView::GetParentFrame() const { return nullptr; }
+int CView::OnPreparePrinting(void*) { return 0; }
+void CView::OnBeginPrinting(void*, void*) {}
+void CView::OnEndPrinting(void*, void*) {}
+void CView::OnActivateView(int, CView*, CView*) {}
+DWORD CView::OnDragEnter(COleDataObject*, DWORD, CPoint) { return 0; }
+DWORD CView::OnDragOver(COleDataObject*, DWORD, CPoint) { return 0; }
+BOOL CView::OnDrop(COleDataObject*, DWORD, CPoint) { return FALSE; }
+DWORD CView::OnDropEx(COleDataObject*, DWORD, DWORD, CPoint) { return 0; }
+CScrollView::CScrollView() {}
+CScrollView::~CScrollView() {}
+void CScrollView::SetScrollSizes(int, const SIZE&, const SIZE&, const SIZE&) {}
+void CScrollView::GetScrollBarSizes(SIZE&) {}
+void CScrollView::GetTrueClientSize(SIZE&, SIZE&) const {}
+void CScrollView::ScrollToPosition(POINT) {}
+CPoint CScrollView::GetScrollPosition() const { return CPoint(); }
+void CScrollView::FillOutsideRect(void*, void*) {}
+void CScrollView::ResizeParentToFit(int) {}
+void CScrollView::OnUpdate(CView*, unsigned long, CObject*) {}
+void CScrollView::OnInitialUpdate() {}
+void CScrollView::OnDraw(void*) {}
+CFormView::~CFormView() {}
+BOOL CFormView::Create(const wchar_t*, const wchar_t*, DWORD, const struct tagRECT&, CWnd*, unsigned int,
+                       CCreateContext*) { return FALSE; }
+void CFormView::DoDataExchange(void*) {}
+void CFormView::OnInitialUpdate() {}
+void CFormView::OnDraw(void*) {}
+
+#include <chrono>
+#include <cstdio>
+#include <cwctype>
+#include <set>
+#include <string>
+#include <vector>
+
+static int g_failures = 0;
+
+static void check(const char* name, bool cond) {
+    std::printf("[%s] %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond) ++g_failures;
+}
+
+//=============================================================================
+// Stub ODBC driver
+//=============================================================================
+namespace stubodbc {
+
+struct Statement {
+    bool bPrepared = false;
+    std::wstring sql;
+    std::vector<std::wstring> tokens;
+    SQLULEN nParamsetSize = 1;
+    SQLULEN* pParamsProcessed = nullptr;
+    SQLUSMALLINT* pParamStatus = nullptr;
+    long nExecutes = 0;
+};
+
+std::set<Statement*> g_statements;
+long g_nPrepares = 0;
+long g_nExecDirects = 0;
+long g_nExecutes = 0;          // SQLExecute calls
+long g_nRowsExecuted = 0;      // parameter rows run by them
+long g_nHY011 = 0;             // cursor attributes set on a prepared statement
+SQLULEN g_nMaxParamset = 1000; // larger PARAMSET_SIZE requests are refused
+
+// Splits the text into words, numbers, quoted strings and punctuation.
+std::vector<std::wstring> Tokenize(const SQLWCHAR* pszSQL) {
+    std::vector<std::wstring> tokens;
+    const wchar_t* p = reinterpret_cast<const wchar_t*>(pszSQL);
+    while (*p) {
+        if (std::iswspace(*p)) {
+            ++p;
+            continue;
+        }
+        const wchar_t* pStart = p;
+        if (std::iswalnum(*p) || *p == L'_') {
+            while (std::iswalnum(*p) || *p == L'_') ++p;
+        } else if (*p == L'\'') {
+            for (++p; *p && *p != L'\''; ++p) {}
+            if (*p) ++p;
+        } else {
+            ++p;
+        }
+        tokens.emplace_back(pStart, p);
+    }
+    return tokens;
+}
+
+} // namespace stubodbc
+
+using stubodbc::Statement;
+
+extern "C" {
+
+SQLRETURN SQL_API SQLAllocHandle(SQLSMALLINT nType, SQLHANDLE, SQLHANDLE* phOut) {
+    if (nType == SQL_HANDLE_STMT) {
+        Statement* pStmt = new Statement;
+        stubodbc::g_statements.insert(pStmt);
+        *phOut = pStmt;
+    } else {
+        *phOut = new int(nType);
+    }
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLFreeHandle(SQLSMALLINT nType, SQLHANDLE hHandle) {
+    if (nType == SQL_HANDLE_STMT) {
+        Statement* pStmt = static_cast<Statement*>(hHandle);
+        if (stubodbc::g_statements.erase(pStmt) == 0) return SQL_INVALID_HANDLE;
+        delete pStmt;
+    } else {
+        delete static_cast<int*>(hHandle);
+    }
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLPrepareW(SQLHSTMT hstmt, SQLWCHAR* pszSQL, SQLINTEGER) {
+    Statement& stmt = *static_cast<Statement*>(hstmt);
+    stmt.bPrepared = true;
+    stmt.sql = pszSQL;
+    stmt.tokens = stubodbc::Tokenize(pszSQL);
+    ++stubodbc::g_nPrepares;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLExecute(SQLHSTMT hstmt) {
+    Statement& stmt = *static_cast<Statement*>(hstmt);
+    if (!stmt.bPrepared) return SQL_ERROR;
+    ++stmt.nExecutes;
+    ++stubodbc::g_nExecutes;
+    stubodbc::g_nRowsExecuted += static_cast<long>(stmt.nParamsetSize);
+    if (stmt.pParamsProcessed) *stmt.pParamsProcessed = stmt.nParamsetSize;
+    for (SQLULEN i = 0; stmt.pParamStatus && i < stmt.nParamsetSize; ++i) stmt.pParamStatus[i] = SQL_PARAM_SUCCESS;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLExecDirectW(SQLHSTMT hstmt, SQLWCHAR* pszSQL, SQLINTEGER) {
+    static_cast<Statement*>(hstmt)->tokens = stubodbc::Tokenize(pszSQL);
+    ++stubodbc::g_nExecDirects;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLSetStmtAttr(SQLHSTMT hstmt, SQLINTEGER nAttr, SQLPOINTER pValue, SQLINTEGER) {
+    Statement& stmt = *static_cast<Statement*>(hstmt);
+    switch (nAttr) {
+    case SQL_ATTR_CONCURRENCY:
+        if (stmt.bPrepared) {
+            ++stubodbc::g_nHY011;
+            return SQL_ERROR;
+        }
+        return SQL_SUCCESS;
+    case SQL_ATTR_PARAMSET_SIZE: {
+        const SQLULEN nAsked = reinterpret_cast<SQLULEN>(pValue);
+        stmt.nParamsetSize = std::min(nAsked, stubodbc::g_nMaxParamset);
+        return stmt.nParamsetSize == nAsked ? SQL_SUCCESS : SQL_SUCCESS_WITH_INFO;
+    }
+    case SQL_ATTR_PARAMS_PROCESSED_PTR:
+        stmt.pParamsProcessed = static_cast<SQLULEN*>(pValue);
+        return SQL_SUCCESS;
+    case SQL_ATTR_PARAM_STATUS_PTR:
+        stmt.pParamStatus = static_cast<SQLUSMALLINT*>(pValue);
+        return SQL_SUCCESS;
+    default:
+        return SQL_SUCCESS;
+    }
+}
+
+SQLRETURN SQL_API SQLFreeStmt(SQLHSTMT hstmt, SQLUSMALLINT nOption) {
+    if (nOption == SQL_RESET_PARAMS) static_cast<Statement*>(hstmt)->nParamsetSize = 1;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLNumResultCols(SQLHSTMT, SQLSMALLINT* pnCols) {
+    *pnCols = 1;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLBindParameter(SQLHSTMT, SQLUSMALLINT, SQLSMALLINT, SQLSMALLINT, SQLSMALLINT, SQLULEN, SQLSMALLINT,
+                                   SQLPOINTER, SQLLEN, SQLLEN*) { return SQL_SUCCESS; }
+SQLRETURN SQL_API SQLDriverConnectW(SQLHDBC, SQLHWND, SQLWCHAR*, SQLSMALLINT, SQLWCHAR*, SQLSMALLINT, SQLSMALLINT*,
+                                    SQLUSMALLINT) { return SQL_SUCCESS; }
+SQLRETURN SQL_API SQLDisconnect(SQLHDBC) { return SQL_SUCCESS; }
+SQLRETURN SQL_API SQLSetEnvAttr(SQLHENV, SQLINTEGER, SQLPOINTER, SQLINTEGER) { return SQL_SUCCESS; }
+SQLRETURN SQL_API SQLSetConnectAttr(SQLHDBC, SQLINTEGER, SQLPOINTER, SQLINTEGER) { return SQL_SUCCESS; }
+SQLRETURN SQL_API SQLEndTran(SQLSMALLINT, SQLHANDLE, SQLSMALLINT) { return SQL_SUCCESS; }
+SQLRETURN SQL_API SQLCancel(SQLHSTMT) { return SQL_SUCCESS; }
+SQLRETURN SQL_API SQLCloseCursor(SQLHSTMT) { return SQL_SUCCESS; }
+SQLRETURN SQL_API SQLMoreResults(SQLHSTMT) { return SQL_NO_DATA; }
+SQLRETURN SQL_API SQLBindCol(SQLHSTMT, SQLUSMALLINT, SQLSMALLINT, SQLPOINTER, SQLLEN, SQLLEN*) { return SQL_SUCCESS; }
+SQLRETURN SQL_API SQLFetchScroll(SQLHSTMT, SQLSMALLINT, SQLLEN) { return SQL_NO_DATA; }
+SQLRETURN SQL_API SQLSetPos(SQLHSTMT, SQLSETPOSIROW, SQLUSMALLINT, SQLUSMALLINT) { return SQL_ERROR; }
+SQLRETURN SQL_API SQLGetStmtAttr(SQLHSTMT, SQLINTEGER, SQLPOINTER, SQLINTEGER, SQLINTEGER*) { return SQL_ERROR; }
+SQLRETURN SQL_API SQLGetInfo(SQLHDBC, SQLUSMALLINT, SQLPOINTER, SQLSMALLINT, SQLSMALLINT*) { return SQL_ERROR; }
+SQLRETURN SQL_API SQLGetData(SQLHSTMT, SQLUSMALLINT, SQLSMALLINT, SQLPOINTER, SQLLEN, SQLLEN*) { return SQL_ERROR; }
+SQLRETURN SQL_API SQLDescribeColW(SQLHSTMT, SQLUSMALLINT, SQLWCHAR*, SQLSMALLINT, SQLSMALLINT*, SQLSMALLINT*, SQLULEN*,
+                                  SQLSMALLINT*, SQLSMALLINT*) { return SQL_ERROR; }
+SQLRETURN SQL_API SQLGetDiagRecW(SQLSMALLINT, SQLHANDLE, SQLSMALLINT, SQLWCHAR*, SQLINTEGER*, SQLWCHAR*, SQLSMALLINT,
+                                 SQLSMALLINT*) { return SQL_NO_DATA; }
+
+} // extern "C"
+
+// A recordset whose OnSetOptions sets a cursor attribute, as MFC's does.
+class COrdersRecordset : public CRecordset {
+public:
+    explicit COrdersRecordset(CDatabase* pDatabase) : CRecordset(pDatabase) {}
+    CString GetDefaultSQL() override { return CString(L"SELECT id FROM orders"); }
+    BOOL OnSetOptions(HSTMT hstmt) override {
+        const RETCODE rc = SQLSetStmtAttr(hstmt, SQL_ATTR_CONCURRENCY, (SQLPOINTER)SQL_CONCUR_READ_ONLY, 0);
+        m_bOptionsOk = m_bOptionsOk && SqlSucceeded(rc);
+        return SqlSucceeded(rc);
+    }
+    bool m_bOptionsOk = true;
+};
+
+static double RowsPerSec(long nRows, std::chrono::steady_clock::time_point start) {
+    return nRows / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void ResetCounts() {
+    stubodbc::g_nPrepares = 0;
+    stubodbc::g_nExecDirects = 0;
+    stubodbc::g_nExecutes = 0;
+    stubodbc::g_nRowsExecuted = 0;
+    stubodbc::g_nHY011 = 0;
+}
+
+int main() {
+    using namespace stubodbc;
+
+    CDatabase db;
+    check("database opens on the stub driver", db.Open(nullptr, FALSE, FALSE, L"DSN=stub;") == TRUE);
+
+    // ---- Off by default -----------------------------------------------------
+    check("the cache starts off", db.GetStatementCacheSize() == 0);
+    ResetCounts();
+    for (int i = 0; i < 3; ++i) db.ExecuteSQL(L"UPDATE orders SET shipped = 1");
+    check("uncached ExecuteSQL executes directly, no prepare",
+          g_nExecDirects == 3 && g_nPrepares == 0 && g_nExecutes == 0);
+    check("and frees its statement each time", g_statements.empty());
+
+    // ---- Opt-in cache -------------------------------------------------------
+    db.SetStatementCacheSize(2);
+    ResetCounts();
+    for (int i = 0; i < 5; ++i) db.ExecuteSQL(L"UPDATE orders SET shipped = 1");
+    check("a repeated ExecuteSQL text is prepared once", g_nPrepares == 1 && g_nExecutes == 5 && g_nExecDirects == 0);
+    check("hits and misses are counted", db.GetStatementCacheHits() == 4 && db.GetStatementCacheMisses() == 1);
+    check("the idle statement is kept", g_statements.size() == 1);
+
+    db.ExecuteSQL(L"DELETE FROM orders WHERE id = 1");
+    db.ExecuteSQL(L"DELETE FROM orders WHERE id = 2");
+    check("no more idle statements than the cache size", g_statements.size() == 2);
+    ResetCounts();
+    db.ExecuteSQL(L"UPDATE orders SET shipped = 1");
+    check("the least recently used statement was freed", g_nPrepares == 1);
+    db.ExecuteSQL(L"DELETE FROM orders WHERE id = 2");
+    check("the most recently used one was kept", g_nPrepares == 1);
+
+    // ---- ExecuteSQLBatch ----------------------------------------------------
+    {
+        const DWORD kRows = 800;
+        std::vector<int> ids(kRows);
+        for (DWORD i = 0; i < kRows; ++i) ids[i] = static_cast<int>(i);
+        CDatabase::ParamArray param = { SQL_C_LONG, SQL_INTEGER, 0, 0, ids.data(), sizeof(int), nullptr };
+        const wchar_t* const kInsert = L"INSERT INTO orders (id) VALUES (?)";
+
+        ResetCounts();
+        DWORD nProcessed = 0;
+        check("ExecuteSQLBatch of 800 rows", db.ExecuteSQLBatch(kInsert, &param, 1, kRows, &nProcessed) == TRUE);
+        check("runs as one PARAMSET_SIZE execution", g_nPrepares == 1 && g_nExecutes == 1 && g_nRowsExecuted == kRows);
+        check("and reports every row processed", nProcessed == kRows);
+        db.ExecuteSQLBatch(kInsert, &param, 1, kRows, &nProcessed);
+        check("a repeated batch reuses the prepared statement", g_nPrepares == 1 && g_nExecutes == 2);
+
+        g_nMaxParamset = 100;
+        ResetCounts();
+        check("ExecuteSQLBatch when the driver lowers PARAMSET_SIZE",
+              db.ExecuteSQLBatch(kInsert, &param, 1, kRows, &nProcessed) == TRUE && nProcessed == kRows);
+        check("runs row by row on the same statement", g_nPrepares == 0 && g_nExecutes == kRows);
+        g_nMaxParamset = 1000;
+
+        db.SetStatementCacheSize(0);
+        check("turning the cache off frees its idle statements", g_statements.empty());
+        ResetCounts();
+        db.ExecuteSQLBatch(kInsert, &param, 1, kRows, &nProcessed);
+        check("an uncached batch still prepares once and frees the statement",
+              g_nPrepares == 1 && g_nExecutes == 1 && g_statements.empty());
+    }
+
+    // ---- Recordsets set their options before the prepare --------------------
+    for (int nCacheSize : { 0, 16 }) {
+        db.SetStatementCacheSize(nCacheSize);
+        ResetCounts();
+        const unsigned long nHits = db.GetStatementCacheHits();
+        bool bOpened = true;
+        COrdersRecordset rs(&db);
+        for (int i = 0; i < 3; ++i) {
+            bOpened = bOpened && rs.Open(CRecordset::snapshot, nullptr, CRecordset::none) == TRUE;
+            rs.Close();
+        }
+        const bool bCached = nCacheSize != 0;
+        check(bCached ? "cache on: every recordset Open succeeds" : "cache off: every recordset Open succeeds", bOpened);
+        check(bCached ? "cache on: OnSetOptions never hits HY011" : "cache off: OnSetOptions never hits HY011",
+              rs.m_bOptionsOk && g_nHY011 == 0);
+        check(bCached ? "cache on: each Open prepares a new statement" : "cache off: each Open prepares a new statement",
+              g_nPrepares == 3 && db.GetStatementCacheHits() == nHits);
+        check(bCached ? "cache on: Close frees the statement" : "cache off: Close frees the statement",
+              g_statements.empty());
+    }
+    {
+        COrdersRecordset rs(&db);
+        ResetCounts();
+        rs.Open(CRecordset::snapshot, nullptr, CRecordset::executeDirect);
+        check("executeDirect sets options and runs SQLExecDirect",
+              rs.m_bOptionsOk && g_nExecDirects == 1 && g_nPrepares == 0);
+        rs.Close();
+    }
+
+    // ---- Throughput with and without the cache ------------------------------
+    {
+        const long kRows = 100000;
+        const DWORD kBatchRows = 1000;
+        const wchar_t* const kInsert =
+            L"INSERT INTO orders (id, customer, placed, status, total) "
+            L"VALUES (42, 'ACME Corporation', '2024-01-01', 'open', 1999)";
+        std::vector<int> ids(kBatchRows);
+        for (DWORD i = 0; i < kBatchRows; ++i) ids[i] = static_cast<int>(i);
+        CDatabase::ParamArray param = { SQL_C_LONG, SQL_INTEGER, 0, 0, ids.data(), sizeof(int), nullptr };
+
+        db.SetStatementCacheSize(0);
+        ResetCounts();
+        auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < kRows; ++i) db.ExecuteSQL(kInsert);
+        const double uncached = RowsPerSec(kRows, start);
+        const long nUncachedParses = g_nExecDirects + g_nPrepares;
+
+        db.SetStatementCacheSize(16);
+        ResetCounts();
+        start = std::chrono::steady_clock::now();
+        for (long i = 0; i < kRows; ++i) db.ExecuteSQL(kInsert);
+        const double cached = RowsPerSec(kRows, start);
+        const long nCachedParses = g_nExecDirects + g_nPrepares;
+
+        ResetCounts();
+        DWORD nProcessed = 0;
+        start = std::chrono::steady_clock::now();
+        for (long i = 0; i < kRows; i += kBatchRows) {
+            db.ExecuteSQLBatch(L"INSERT INTO orders (id) VALUES (?)", &param, 1, kBatchRows, &nProcessed);
+        }
+        const double batched = RowsPerSec(kRows, start);
+
+        std::printf("%ld single-row INSERTs:\n", kRows);
+        std::printf("  ExecuteSQL, cache off:   %12.0f rows/sec, %6ld parses\n", uncached, nUncachedParses);
+        std::printf("  ExecuteSQL, cache on:    %12.0f rows/sec, %6ld parses\n", cached, nCachedParses);
+        std::printf("  ExecuteSQLBatch of %lu: %12.0f rows/sec\n", static_cast<unsigned long>(kBatchRows), batched);
+        check("without the cache every INSERT is parsed", nUncachedParses == kRows);
+        check("with it the INSERT is parsed once", nCachedParses == 1);
+        check("the cache raises rows/sec", cached > uncached);
+        check("batches run every row", g_nRowsExecuted == kRows && g_nExecutes == kRows / kBatchRows);
+        db.SetStatementCacheSize(0);
+    }
+
+    db.ExecuteSQL(L"UPDATE orders SET shipped = 1");
+    db.Close();
+    check("Close frees the idle statements", g_statements.empty());
+
+    if (g_failures == 0) {
+        std::printf("ALL CHECKS PASSED\n");
+        return 0;
+    }
+    std::printf("%d CHECK(S) FAILED\n", g_failures);
+    return 1;
+}